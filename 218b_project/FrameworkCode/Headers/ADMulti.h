@@ -4,6 +4,7 @@
 // Setup up ADC0 to convert up to 4 channels using SS2
 
 #include <stdint.h>
+#include <stdbool.h>
 
 // initialize the A/D converter to convert on 1-4 channels
 void ADC_MultiInit(uint8_t HowMany);
@@ -17,4 +18,20 @@ void ADC_MultiInit(uint8_t HowMany);
 // lowest numbered converted channel is in data[0]
 
 void ADC_MultiRead(uint32_t data[4]);
+
+// start converting every SamplePeriodUS, triggered by Timer 4A
+void ADC_MultiStartContinuous(uint32_t SamplePeriodUS);
+
+// copy the latest set of results without waiting. Returns the number of
+// the set, which goes up by one for each conversion, 0 if there are none
+uint32_t ADC_MultiLatest(uint32_t data[4]);
+
+// the ADC0 sequence 2 interrupt response
+void ADC_MultiISR(void);
+
+#ifdef ES_PORT_POSIX
+// host only: drive the fake converter
+void ADC_MultiFakeSetInput(uint8_t Channel, uint32_t Counts);
+void ADC_MultiFakeTimerTimeout(void);
+#endif
 #endif
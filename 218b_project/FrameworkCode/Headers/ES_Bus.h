@@ -0,0 +1,68 @@
+/****************************************************************************
+ Module
+     ES_Bus.h
+ Description
+     header file for the optional publish/subscribe bus, which delivers an
+     event to every service subscribed to its type with a single enqueue
+ Notes
+     ES_BUS_SIZE and BUS_SUBSCRIPTIONS are set in ES_Configure.h, everything
+     here compiles away unless ES_BUS_SIZE is defined
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 18:30         started coding
+*****************************************************************************/
+#ifndef ES_Bus_H
+#define ES_Bus_H
+
+#include "ES_Configure.h"
+#include "ES_Types.h"
+#include "ES_Events.h"
+
+#ifdef ES_BUS_SIZE
+
+#if (ES_BUS_SIZE < 2) || (ES_BUS_SIZE > 128) || \
+  ((ES_BUS_SIZE & (ES_BUS_SIZE - 1)) != 0)
+#error "ES_BUS_SIZE must be a power of two from 2 to 128"
+#endif
+
+// every service waiting on an event in the bus can have that many more
+// events outstanding than its queue holds, the per-service rings that
+// shadow the queues (ES_Profile, ES_Sched) are made that much bigger
+#define ES_BUS_SLOTS ES_BUS_SIZE
+
+// for ES_Bus_PublishTo, every service
+#define ES_BUS_EVERYONE 0xFFFFFFFFUL
+
+// what is known about the bus
+typedef struct
+{
+  uint32_t    Publishes;      // events accepted
+  uint32_t    Unheard;        // accepted with nobody subscribed
+  uint32_t    NumDrops;       // events refused because the bus was full
+  uint8_t     PeakDepth;      // most events waiting at once
+  ES_Event_t  LastDrop;       // valid if NumDrops != 0
+  uint32_t    LastBlockers;   // subscribers that had not read the oldest
+                              // event at the time of the last drop
+}ES_BusStats_t;
+
+void ES_Bus_Init(void);
+bool ES_Bus_Subscribe(uint8_t WhichService, ES_EventType_t WhichEvent);
+bool ES_Bus_Unsubscribe(uint8_t WhichService, ES_EventType_t WhichEvent);
+uint32_t ES_Bus_GetSubscribers(ES_EventType_t WhichEvent);
+bool ES_Bus_Publish(ES_Event_t ThisEvent);
+bool ES_Bus_PublishTo(uint32_t Subscribers, ES_Event_t ThisEvent);
+void ES_Bus_Queued(uint8_t WhichService, bool AtFront);
+bool ES_Bus_Take(uint8_t WhichService, ES_Event_t *pEvent);
+bool ES_Bus_HasEvents(uint8_t WhichService);
+ES_BusStats_t const *ES_Bus_GetStats(void);
+void ES_Bus_ResetStats(void);
+void ES_Bus_PrintStats(void);
+
+#else
+
+#define ES_BUS_SLOTS 0
+
+#endif /* ES_BUS_SIZE */
+
+#endif /* ES_Bus_H */
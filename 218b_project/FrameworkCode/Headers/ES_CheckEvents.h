@@ -17,12 +17,30 @@
 #ifndef ES_CheckEvents_H
 #define ES_CheckEvents_H
 
+#include "ES_Configure.h"
 #include "ES_Types.h"
 
 typedef bool CheckFunc (void);
 
 typedef CheckFunc (*pCheckFunc);
 
+#ifdef EVENT_CHECK_SCHEDULE
+// kept for each checker in EVENT_CHECK_SCHEDULE, times in clock counts
+typedef struct
+{
+  uint32_t Calls;
+  uint32_t Hits;        // calls that returned true
+  uint32_t Skips;       // passes of the idle loop on which it was not due
+  uint32_t MaxTime;
+  uint64_t TotalTime;
+}ES_CheckerStats_t;
+#endif
+
 bool ES_CheckUserEvents(void);
+#ifdef EVENT_CHECK_SCHEDULE
+ES_CheckerStats_t const *ES_GetCheckerStats(uint8_t WhichChecker);
+void ES_ResetCheckerStats(void);
+void ES_PrintCheckerStats(void);
+#endif
 
 #endif  // ES_CheckEvents_H
@@ -26,229 +26,36 @@
 
 /****************************************************************************/
 // The maximum number of services sets an upper bound on the number of
-// services that the framework will handle. Reasonable values are 8 and 16
-// corresponding to an 8-bit(uint8_t) and 16-bit(uint16_t) Ready variable size
-#define MAX_NUM_SERVICES 16
+// services that the framework will handle. The Ready variable is 32 bits wide
+// so that the highest priority can be found with a single count leading
+// zeros instruction, which puts the upper limit at 32
+#define MAX_NUM_SERVICES 32
 
 /****************************************************************************/
 // This macro determines that number of services that are *actually* used in
 // a particular application. It will vary in value from 1 to MAX_NUM_SERVICES
+// and must match the number of entries in SERVICE_LIST below
 #define NUM_SERVICES 2
 
 /****************************************************************************/
-// These are the definitions for Service 0, the lowest priority service.
-// Every Events and Services application must have a Service 0. Further
-// services are added in numeric sequence (1,2,3,...) with increasing
-// priorities
-// the header file with the public function prototypes
-#define SERV_0_HEADER "MotorService.h"
-// the name of the Init function
-#define SERV_0_INIT InitMotorService
-// the name of the run function
-#define SERV_0_RUN RunMotorService
-// How big should this services Queue be? Small queue b/c this service
-// receives only the ES_INIT event
-#define SERV_0_QUEUE_SIZE 3
-
-/****************************************************************************/
-// The following sections are used to define the parameters for each of the
-// services. You only need to fill out as many as the number of services
-// defined by NUM_SERVICES
-/****************************************************************************/
-// These are the definitions for Service 1
-#if NUM_SERVICES > 1
-// the header file with the public function prototypes
-#define SERV_1_HEADER "GamePlayHSM.h"
-// the name of the Init function
-#define SERV_1_INIT InitMasterSM
-// the name of the run function
-#define SERV_1_RUN RunMasterSM
-// How big should this services Queue be? Large queue because Sharp sensor
-// can flood framework with events
-#define SERV_1_QUEUE_SIZE 50
-#endif
-
-/****************************************************************************/
-// These are the definitions for Service 2
-#if NUM_SERVICES > 2
-// the header file with the public function prototypes
-#define SERV_2_HEADER "TestHarnessService2.h"
-// the name of the Init function
-#define SERV_2_INIT InitTestHarnessService2
-// the name of the run function
-#define SERV_2_RUN RunTestHarnessService2
-// How big should this services Queue be?
-#define SERV_2_QUEUE_SIZE 3
-#endif
-
-/****************************************************************************/
-// These are the definitions for Service 3
-#if NUM_SERVICES > 3
-// the header file with the public function prototypes
-#define SERV_3_HEADER "TestHarnessService3.h"
-// the name of the Init function
-#define SERV_3_INIT InitTestHarnessService3
-// the name of the run function
-#define SERV_3_RUN RunTestHarnessService3
-// How big should this services Queue be?
-#define SERV_3_QUEUE_SIZE 3
-#endif
-
-/****************************************************************************/
-// These are the definitions for Service 4
-#if NUM_SERVICES > 4
-// the header file with the public function prototypes
-#define SERV_4_HEADER "TestHarnessService4.h"
-// the name of the Init function
-#define SERV_4_INIT InitTestHarnessService4
-// the name of the run function
-#define SERV_4_RUN RunTestHarnessService4
-// How big should this services Queue be?
-#define SERV_4_QUEUE_SIZE 3
-#endif
-
-/****************************************************************************/
-// These are the definitions for Service 5
-#if NUM_SERVICES > 5
-// the header file with the public function prototypes
-#define SERV_5_HEADER "TestHarnessService5.h"
-// the name of the Init function
-#define SERV_5_INIT InitTestHarnessService5
-// the name of the run function
-#define SERV_5_RUN RunTestHarnessService5
-// How big should this services Queue be?
-#define SERV_5_QUEUE_SIZE 3
-#endif
-
-/****************************************************************************/
-// These are the definitions for Service 6
-#if NUM_SERVICES > 6
-// the header file with the public function prototypes
-#define SERV_6_HEADER "TestHarnessService6.h"
-// the name of the Init function
-#define SERV_6_INIT InitTestHarnessService6
-// the name of the run function
-#define SERV_6_RUN RunTestHarnessService6
-// How big should this services Queue be?
-#define SERV_6_QUEUE_SIZE 3
-#endif
-
-/****************************************************************************/
-// These are the definitions for Service 7
-#if NUM_SERVICES > 7
-// the header file with the public function prototypes
-#define SERV_7_HEADER "TestHarnessService7.h"
-// the name of the Init function
-#define SERV_7_INIT InitTestHarnessService7
-// the name of the run function
-#define SERV_7_RUN RunTestHarnessService7
-// How big should this services Queue be?
-#define SERV_7_QUEUE_SIZE 3
-#endif
-
-/****************************************************************************/
-// These are the definitions for Service 8
-#if NUM_SERVICES > 8
-// the header file with the public function prototypes
-#define SERV_8_HEADER "TestHarnessService8.h"
-// the name of the Init function
-#define SERV_8_INIT InitTestHarnessService8
-// the name of the run function
-#define SERV_8_RUN RunTestHarnessService8
-// How big should this services Queue be?
-#define SERV_8_QUEUE_SIZE 3
-#endif
-
-/****************************************************************************/
-// These are the definitions for Service 9
-#if NUM_SERVICES > 9
-// the header file with the public function prototypes
-#define SERV_9_HEADER "TestHarnessService9.h"
-// the name of the Init function
-#define SERV_9_INIT InitTestHarnessService9
-// the name of the run function
-#define SERV_9_RUN RunTestHarnessService9
-// How big should this services Queue be?
-#define SERV_9_QUEUE_SIZE 3
-#endif
-
-/****************************************************************************/
-// These are the definitions for Service 10
-#if NUM_SERVICES > 10
-// the header file with the public function prototypes
-#define SERV_10_HEADER "TestHarnessService10.h"
-// the name of the Init function
-#define SERV_10_INIT InitTestHarnessService10
-// the name of the run function
-#define SERV_10_RUN RunTestHarnessService10
-// How big should this services Queue be?
-#define SERV_10_QUEUE_SIZE 3
-#endif
-
-/****************************************************************************/
-// These are the definitions for Service 11
-#if NUM_SERVICES > 11
-// the header file with the public function prototypes
-#define SERV_11_HEADER "TestHarnessService11.h"
-// the name of the Init function
-#define SERV_11_INIT InitTestHarnessService11
-// the name of the run function
-#define SERV_11_RUN RunTestHarnessService11
-// How big should this services Queue be?
-#define SERV_11_QUEUE_SIZE 3
-#endif
-
-/****************************************************************************/
-// These are the definitions for Service 12
-#if NUM_SERVICES > 12
-// the header file with the public function prototypes
-#define SERV_12_HEADER "TestHarnessService12.h"
-// the name of the Init function
-#define SERV_12_INIT InitTestHarnessService12
-// the name of the run function
-#define SERV_12_RUN RunTestHarnessService12
-// How big should this services Queue be?
-#define SERV_12_QUEUE_SIZE 3
-#endif
-
-/****************************************************************************/
-// These are the definitions for Service 13
-#if NUM_SERVICES > 13
-// the header file with the public function prototypes
-#define SERV_13_HEADER "TestHarnessService13.h"
-// the name of the Init function
-#define SERV_13_INIT InitTestHarnessService13
-// the name of the run function
-#define SERV_13_RUN RunTestHarnessService13
-// How big should this services Queue be?
-#define SERV_13_QUEUE_SIZE 3
-#endif
-
-/****************************************************************************/
-// These are the definitions for Service 14
-#if NUM_SERVICES > 14
-// the header file with the public function prototypes
-#define SERV_14_HEADER "TestHarnessService14.h"
-// the name of the Init function
-#define SERV_14_INIT InitTestHarnessService14
-// the name of the run function
-#define SERV_14_RUN RunTestHarnessService14
-// How big should this services Queue be?
-#define SERV_14_QUEUE_SIZE 3
-#endif
-
-/****************************************************************************/
-// These are the definitions for Service 15
-#if NUM_SERVICES > 15
-// the header file with the public function prototypes
-#define SERV_15_HEADER "TestHarnessService15.h"
-// the name of the Init function
-#define SERV_15_INIT InitTestHarnessService15
-// the name of the run function
-#define SERV_15_RUN RunTestHarnessService15
-// How big should this services Queue be?
-#define SERV_15_QUEUE_SIZE 3
-#endif
+// These are the definitions of the services. Each entry in the list gives
+// the name of the Init function, the name of the Run function, how big
+// that service's queue should be and what kind of queue it is. The first
+// entry is Service 0, the lowest priority service. Every Events and Services
+// application must have a Service 0. Further services are added in sequence
+// (1,2,3,...) with increasing priorities. The header files with the public
+// function prototypes for these services are listed in ES_ServiceHeaders.h
+// The queue kind is ES_QUEUE_STANDARD or ES_QUEUE_SPSC (see ES_Queue.h).
+// Only use ES_QUEUE_SPSC if all posts to the service come from one context,
+// either a single ISR or only the main loop (services, event checkers and
+// timers), and its size must then be a power of two.
+#define SERVICE_LIST(ES_SERVICE)                                              \
+  /* Service 0: small queue b/c this service receives only ES_INIT, which  \
+     only comes from the main loop, so it can be lock-free */                 \
+  ES_SERVICE(InitMotorService, RunMotorService, 4, ES_QUEUE_SPSC)             \
+  /* Service 1: large queue because Sharp sensor can flood framework with   \
+     events. The beacon ISRs post here as well as the main loop */          \
+  ES_SERVICE(InitMasterSM, RunMasterSM, 50, ES_QUEUE_STANDARD)
 
 /****************************************************************************/
 // Name/define the events of interest
@@ -278,6 +85,61 @@ typedef enum
   EV_EOM                      /* indicating SPI transmit finished */
 }ES_EventType_t;
 
+// the number of event types, keep this one more than the last entry above.
+// Used to size the per event type tables
+#define NUM_EVENT_TYPES (EV_EOM + 1)
+
+/****************************************************************************/
+// Rules for merging a post into an event of the same type that is still
+// waiting in a service's queue, so that a burst of identical events gets
+// dispatched once. Each entry gives the service's Run function, the event
+// type and the rule (see ES_CoalesceRule_t in ES_Framework.h):
+//   ES_COALESCE_KEEP_FIRST   the waiting event is left as it is
+//   ES_COALESCE_KEEP_LATEST  the waiting event takes the new param
+//   ES_COALESCE_COUNT        the waiting event's param counts the posts
+// Only services with ES_QUEUE_STANDARD queues can have rules. Comment out
+// the whole list if no coalescing is wanted.
+#define COALESCE_LIST(ES_COALESCE)                                           \
+  /* the beacon ISRs post on every edge once they have locked on */          \
+  ES_COALESCE(RunMasterSM, EV_ATTACK_GOAL_DETECTED, ES_COALESCE_COUNT)       \
+  ES_COALESCE(RunMasterSM, EV_DEFEND_GOAL_DETECTED, ES_COALESCE_COUNT)       \
+  ES_COALESCE(RunMasterSM, EV_RELOADER_DETECTED, ES_COALESCE_COUNT)
+
+/****************************************************************************/
+// The order in which ES_Run serves the services that have events waiting
+// (see ES_Sched.h):
+//   ES_SCHED_STATIC  the highest numbered service first
+//   ES_SCHED_EDF     earliest deadline first, the service whose oldest
+//                    waiting event is due soonest goes first
+#define ES_SCHED_POLICY ES_SCHED_STATIC
+
+// uncomment this line to stamp the posts with deadlines and count the
+// misses under ES_SCHED_STATIC as well. ES_SCHED_EDF always does.
+// ES_Sched_PrintStats prints them out
+//#define ES_DEADLINES
+
+// How soon, in uS, after it is posted each event must have been handled
+// (the run function has returned). Each entry gives the service's Run
+// function and its deadline, services that are not listed get
+// ES_DEFAULT_DEADLINE_US. Keep them under 2000000 so the host port can
+// use them too
+#define ES_DEFAULT_DEADLINE_US 100000
+#define DEADLINE_LIST(ES_DEADLINE)                                           \
+  /* the motors have to see the control law on time */                      \
+  ES_DEADLINE(RunMotorService, 5000)                                         \
+  ES_DEADLINE(RunMasterSM, 20000)
+
+/****************************************************************************/
+// uncomment ES_BUS_SIZE to have a publish/subscribe bus (see ES_Bus.h) of
+// that many events, a power of two. A published event goes to all of the
+// services subscribed to its type in a single enqueue, or to none of them
+// if the bus is full, and ES_PostAll goes through it as well. Each entry in
+// BUS_SUBSCRIPTIONS gives a service's Run function and an event type it
+// gets from the start, services can also call ES_Bus_Subscribe. Comment
+// out the whole list if there are none to start with.
+//#define ES_BUS_SIZE 16
+//#define BUS_SUBSCRIPTIONS(ES_SUBSCRIBE) ES_SUBSCRIBE(RunMasterSM, EV_EOM)
+
 /****************************************************************************/
 // These are the definitions for the Distribution lists. Each definition
 // should be a comma-separated list of post functions to indicate which
@@ -309,8 +171,21 @@ typedef enum
 #endif
 
 /****************************************************************************/
-// This is the list of event-checking functions
-#define EVENT_CHECK_LIST Check4LimitSwitches, Check4SharpEvents, Check4Wire
+// This is the list of event-checking functions. Each entry gives the
+// function, how often to call it in uS (0 to call it on every pass of the
+// idle loop) and its priority (when several are due, the higher ones are
+// called first, equal ones take turns). See ES_PrintCheckerStats in
+// ES_CheckEvents.h for how much time each one takes. To call all of them
+// on every pass, in order, use a plain comma separated EVENT_CHECK_LIST
+// instead, e.g. #define EVENT_CHECK_LIST Check4LimitSwitches, Check4Wire
+#define EVENT_CHECK_SCHEDULE(ES_CHECKER)                                    \
+  /* a GPIO read, so cheap enough to do every time */                       \
+  ES_CHECKER(Check4LimitSwitches, 0, 2)                                     \
+  /* these two wait on the ADC, ~15uS each */                               \
+  ES_CHECKER(Check4SharpEvents, 2000, 1)                                    \
+  ES_CHECKER(Check4Wire, 1000, 1)                                           \
+  /* 'T' dumps the trace ring, 't' restarts it, see EventCheckers.c */      \
+  ES_CHECKER(Check4TraceKey, 50000, 0)
 
 /****************************************************************************/
 // These are the definitions for the post functions to be executed when the
@@ -336,6 +211,12 @@ typedef enum
 #define TIMER14_RESP_FUNC PostMasterSM
 #define TIMER15_RESP_FUNC TIMER_UNUSED
 
+/****************************************************************************/
+// The number of timers, beyond the 16 above, that can be handed out while
+// running with ES_Timer_AllocTimer. Each one costs 16 bytes of RAM. The
+// total number of timers must be less than 255.
+#define NUM_DYNAMIC_TIMERS 16
+
 /****************************************************************************/
 // Give the timer numbers symbolic names to make it easier to move them
 // to different timers if the need arises. Keep these definitions close to // the definitions for the response functions to make it easier to check
@@ -364,4 +245,44 @@ typedef enum
 // PF1 & PF2
 #define _INCLUDE_BASIC_FRAMEWORK_DEBUG_
 
+/**************************************************************************/
+// uncomment this line to let the framework sleep between timer expiries
+// rather than taking every tick interrupt while it is idle. The event
+// checkers in EVENT_CHECK_SCHEDULE only get called when something wakes the
+// processor, so only use this if all of the events come from interrupts
+// and timers.
+//#define ES_TICKLESS_IDLE
+
+/**************************************************************************/
+// uncomment this line to have ES_Run keep dispatch counts, run function
+// times and queue waits for every service & event type (see ES_Profile.h).
+// ES_Profile_Dump prints them out
+//#define ES_PROFILE
+
+/**************************************************************************/
+// comment this line out to stop recording every post & dispatch in a ring
+// of this many 12 byte records (a power of two, see ES_Trace.h).
+// ES_Trace_Stop freezes the ring when a problem is noticed, ES_Trace_Dump
+// prints it for Tools/ES_TraceDecode.py, or for ES_Trace_Replay in a host
+// build. Pressing 'T' on the terminal does both (Check4TraceKey)
+#define ES_TRACE_SIZE 128
+
+/**************************************************************************/
+// comment this line out to stop keeping the peak depth and the number of
+// posts & dropped posts, per event type, for every service queue (see
+// ES_GetQueueStats in ES_Framework.h). Costs 8 bytes per service per event
+// type
+#define ES_QUEUE_STATS
+
+// with ES_QUEUE_STATS, uncomment this line to have ES_Run print the queue
+// stats every ES_QUEUE_REPORT_TICKS ticks (less than 65536) while it is idle
+//#define ES_QUEUE_REPORT_TICKS 10000
+
+// with ES_QUEUE_STATS, uncomment this line and give the name of a function
+// void Func(ES_QueueOverflow_t const *pOverflow) to have it called with the
+// details of every post that is lost to a full queue. It is called from
+// whatever made the post, which may be an ISR, so keep it short and do not
+// post from it
+//#define ES_QUEUE_OVERFLOW_HOOK OnQueueOverflow
+
 #endif /* ES_CONFIGURE_H */
@@ -39,10 +39,52 @@ typedef enum
   FailedInit
 }ES_Return_t;
 
+// the ways that a post can be merged into an event of the same type that
+// is still waiting in the queue, used in COALESCE_LIST in ES_Configure.h
+typedef enum
+{
+  ES_COALESCE_NONE = 0,     // every post is queued
+  ES_COALESCE_KEEP_FIRST,   // the waiting event stands in for the new one
+  ES_COALESCE_KEEP_LATEST,  // the waiting event takes the new param
+  ES_COALESCE_COUNT         // the waiting event's param counts the posts
+}ES_CoalesceRule_t;
+
+#ifdef ES_QUEUE_STATS
+// PostingService when a post does not come from a run function
+#define ES_NO_SERVICE 0xFF
+
+// what is known about a post that was lost because the queue was full
+typedef struct
+{
+  uint8_t     Service;          // the service whose queue was full
+  ES_Event_t  Event;            // the event that was dropped
+  uint8_t     Interrupt;        // exception number of the poster, 0 if not ISR
+  uint8_t     PostingService;   // whose run function posted, or ES_NO_SERVICE
+}ES_QueueOverflow_t;
+
+// kept for each service queue
+typedef struct
+{
+  uint8_t             Size;                     // number of entries
+  uint8_t             PeakDepth;                // most ever waiting at once
+  uint32_t            Posts[NUM_EVENT_TYPES];   // successful posts
+  uint32_t            Drops[NUM_EVENT_TYPES];   // posts lost to a full queue
+  uint32_t            NumDrops;                 // all event types
+  uint32_t            NumCoalesced;             // posts merged, see Posts
+  ES_QueueOverflow_t  LastOverflow;             // valid if NumDrops != 0
+}ES_QueueStats_t;
+#endif
+
 ES_Return_t ES_Initialize(TimerRate_t NewRate);
 ES_Return_t ES_Run(void);
 bool ES_PostAll(ES_Event_t ThisEvent);
 bool ES_PostToService(uint8_t WhichService, ES_Event_t ThisEvent);
 bool ES_PostToServiceLIFO(uint8_t WhichService, ES_Event_t TheEvent);
+bool ES_IsIdle(void);
+#ifdef ES_QUEUE_STATS
+ES_QueueStats_t const *ES_GetQueueStats(uint8_t WhichService);
+void ES_ResetQueueStats(void);
+void ES_PrintQueueStats(void);
+#endif
 
 #endif   // ES_Framework_H
@@ -0,0 +1,172 @@
+/****************************************************************************
+ Module
+     ES_Hsm.h
+ Description
+     header file for the table driven hierarchical state machine engine, an
+     alternative to writing a machine as nested switch statements after the
+     pattern in HSMTemplate.c
+ Notes
+     A machine is described by two X-macro lists, one line per state and one
+     per transition, which ES_HSM_DEFINE turns into constant tables:
+
+       #define DOOR_STATES(ES_HSM_STATE) \
+         ES_HSM_STATE(CLOSED, ES_HSM_TOP, LOCKED, NULL, NULL, NULL) \
+         ES_HSM_STATE(LOCKED, CLOSED, ES_HSM_NO_STATE, EnterLocked, NULL, NULL) \
+         ES_HSM_STATE(UNLOCKED, CLOSED, ES_HSM_NO_STATE, NULL, NULL, NULL) \
+         ES_HSM_STATE(OPEN, ES_HSM_TOP, ES_HSM_NO_STATE, NULL, ExitOpen, NULL)
+
+       #define DOOR_TRANSITIONS(ES_HSM_TRANSITION) \
+         ES_HSM_TRANSITION(LOCKED, EV_KEY, UNLOCKED, IsRightKey, NULL, \
+           ES_HSM_EXTERNAL) \
+         ES_HSM_TRANSITION(UNLOCKED, EV_PUSH, OPEN, NULL, NULL, ES_HSM_EXTERNAL) \
+         ES_HSM_TRANSITION(OPEN, EV_PUSH, CLOSED, NULL, NULL, ES_HSM_HISTORY)
+
+       typedef enum { DOOR_STATES(ES_HSM_STATE_NAME) } DoorState_t;
+       ES_HSM_DEFINE(DoorHsm, DOOR_STATES, DOOR_TRANSITIONS, CLOSED);
+
+     A state line is (Name, Parent, Initial child, Entry, Exit, During). The
+     parent must have a lower number than its children. A transition line is
+     (Source, Event type, Target, Guard, Action, Kind), any function may be
+     NULL. The states are numbered by their names, so the enum can be
+     written out by hand instead, as long as it has no gaps.
+
+     The first transition out of a state whose guard passes is taken, and
+     a state that takes none leaves the event to its parent, so a
+     transition out of a composite state applies to everything inside it.
+     Transitions are external, they exit up to the deepest state that
+     contains both source and target without being either of them, and
+     enter down from there to a leaf by the initial children, or by the
+     remembered children for ES_HSM_HISTORY. ES_HSM_INTERNAL only runs the
+     action. An event that causes a transition is consumed, one that does
+     not is passed back, after any re-mapping by the During functions, for
+     the caller to hand up. A kind or'ed with ES_HSM_PASS_ON passes the
+     event back after its transition as well, as a template machine does
+     when it leaves ReturnEvent alone.
+
+     During functions see every event that reaches their state, innermost
+     first, and may re-map or consume it, as in HSMTemplate.c. Entry
+     functions are given ES_ENTRY or ES_ENTRY_HISTORY, so a state can start
+     a separately written machine the usual way.
+
+     ES_Hsm_Dispatch also takes ES_ENTRY, ES_ENTRY_HISTORY and ES_EXIT, so
+     a table driven machine can replace a hand written one behind the same
+     Start/Run functions. A Start function that picks its first state, as
+     StartTemplateSM may, calls ES_Hsm_SetInitial before ES_Hsm_Start.
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 19:10         started coding
+*****************************************************************************/
+#ifndef ES_Hsm_H
+#define ES_Hsm_H
+
+#include "ES_Configure.h"
+#include "ES_Types.h"
+#include "ES_Events.h"
+#include "ES_General.h"
+
+// the parent of the outermost states, and the initial child of a leaf
+#define ES_HSM_TOP      0xFF
+#define ES_HSM_NO_STATE 0xFF
+
+// deepest nesting allowed, the outermost states are at depth 1
+#ifndef ES_HSM_MAX_DEPTH
+#define ES_HSM_MAX_DEPTH 6
+#endif
+
+// the kinds of transition
+#define ES_HSM_EXTERNAL 0   // exit & enter, then to the initial leaf
+#define ES_HSM_INTERNAL 1   // action only, no state change
+#define ES_HSM_HISTORY  2   // exit & enter, then to the last active leaf
+#define ES_HSM_PASS_ON  0x80  // or'ed with a kind, don't consume the event
+
+typedef void (*ES_HsmEntryFunc_t)(ES_Event_t EntryEvent);
+typedef void (*ES_HsmExitFunc_t)(void);
+typedef ES_Event_t (*ES_HsmDuringFunc_t)(ES_Event_t ThisEvent);
+typedef bool (*ES_HsmGuardFunc_t)(ES_Event_t ThisEvent);
+typedef void (*ES_HsmActionFunc_t)(ES_Event_t ThisEvent);
+
+typedef struct
+{
+  uint8_t             Parent;
+  uint8_t             Initial;
+  ES_HsmEntryFunc_t   Entry;
+  ES_HsmExitFunc_t    Exit;
+  ES_HsmDuringFunc_t  During;
+}ES_HsmState_t;
+
+typedef struct
+{
+  uint8_t             Source;
+  ES_EventType_t      Event;
+  uint8_t             Target;
+  ES_HsmGuardFunc_t   Guard;
+  ES_HsmActionFunc_t  Action;
+  uint8_t             Kind;
+}ES_HsmTransition_t;
+
+// worked out by ES_Hsm_Init for each transition
+typedef struct
+{
+  uint8_t Next;       // next transition on the same state & event
+  uint8_t LcaDepth;   // exit states deeper than this
+  uint8_t EntryLen;
+  uint8_t Entry[ES_HSM_MAX_DEPTH];  // then enter these, outermost first
+}ES_HsmPath_t;
+
+typedef struct
+{
+  ES_HsmState_t const       *pStates;
+  ES_HsmTransition_t const  *pTransitions;
+  uint8_t                   *pDepths;     // per state
+  uint8_t                   *pHistory;    // per state, last active child
+  ES_HsmPath_t              *pPaths;      // per transition
+  uint8_t                   *pDispatch;   // [state][event type], first
+                                          // transition or ES_HSM_NO_STATE
+  uint8_t                   NumStates;
+  uint8_t                   NumTransitions;
+  uint8_t                   Initial;      // outermost state to start in
+  uint8_t                   TopHistory;   // outermost state last active
+  uint8_t                   Current;      // active leaf
+  bool                      IsBuilt;
+  bool                      IsActive;
+}ES_Hsm_t;
+
+// expanders for the state & transition lists
+#define ES_HSM_STATE_NAME(Name, Parent, Initial, Entry, Exit, During) Name,
+
+#define ES_HSM_STATE_ENTRY(Name, Parent, Initial, Entry, Exit, During) \
+  [Name] = { (Parent), (Initial), (Entry), (Exit), (During) },
+
+#define ES_HSM_TRANSITION_ENTRY(Source, Event, Target, Guard, Action, Kind) \
+  { (Source), (Event), (Target), (Guard), (Action), (Kind) },
+
+// the tables and work space for a machine, and the machine itself
+#define ES_HSM_DEFINE(Machine, STATE_LIST, TRANSITION_LIST, InitialState)   \
+  static ES_HsmState_t const Machine##_States[] = {                         \
+    STATE_LIST(ES_HSM_STATE_ENTRY)                                          \
+  };                                                                        \
+  static ES_HsmTransition_t const Machine##_Transitions[] = {               \
+    TRANSITION_LIST(ES_HSM_TRANSITION_ENTRY)                                \
+  };                                                                        \
+  static uint8_t Machine##_Depths[ARRAY_SIZE(Machine##_States)];            \
+  static uint8_t Machine##_History[ARRAY_SIZE(Machine##_States)];           \
+  static ES_HsmPath_t Machine##_Paths[ARRAY_SIZE(Machine##_Transitions)];   \
+  static uint8_t Machine##_Dispatch[ARRAY_SIZE(Machine##_States) *          \
+    NUM_EVENT_TYPES];                                                       \
+  static ES_Hsm_t Machine = {                                               \
+    Machine##_States, Machine##_Transitions, Machine##_Depths,              \
+    Machine##_History, Machine##_Paths, Machine##_Dispatch,                 \
+    ARRAY_SIZE(Machine##_States), ARRAY_SIZE(Machine##_Transitions),        \
+    (InitialState), ES_HSM_NO_STATE, ES_HSM_NO_STATE, false, false          \
+  }
+
+bool ES_Hsm_Init(ES_Hsm_t *pHsm);
+bool ES_Hsm_SetInitial(ES_Hsm_t *pHsm, uint8_t WhichState);
+void ES_Hsm_Start(ES_Hsm_t *pHsm, ES_Event_t EntryEvent);
+void ES_Hsm_Stop(ES_Hsm_t *pHsm);
+ES_Event_t ES_Hsm_Dispatch(ES_Hsm_t *pHsm, ES_Event_t ThisEvent);
+uint8_t ES_Hsm_Query(ES_Hsm_t const *pHsm);
+bool ES_Hsm_IsIn(ES_Hsm_t const *pHsm, uint8_t WhichState);
+
+#endif /* ES_Hsm_H */
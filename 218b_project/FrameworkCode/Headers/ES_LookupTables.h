@@ -24,6 +24,7 @@
  01/15/12 13:03 jec      started coding
 *****************************************************************************/
 #include "ES_Types.h"
+#include "ES_Port.h"
 /*
   Since we moved up to 16 timers & services, this table got too big to justify
   having a separate table for the clear and set masks, so just #define the
@@ -32,10 +33,11 @@
 #define BitNum2ClrMask ~BitNum2SetMask
 
 /*
-  this table is used to go from a bit number (0-7) to the mask used to set
-  that bit in a byte.
+  this table is used to go from a bit number (0-31) to the mask used to set
+  that bit in a 32-bit word. It is 32 entries long to cover the widened Ready
+  variable. The 16-bit timer flags use the first 16 entries.
 */
-extern uint16_t const BitNum2SetMask[];
+extern uint32_t const BitNum2SetMask[];
 
 /*
   this table is used to go from an unsigned 4bit value to the most significant
@@ -48,16 +50,40 @@ extern uint8_t const Nybble2MSBitNum[15];
 
 /****************************************************************************
  Function
-   ES_GetMSBSet
+   ES_GetMSBitSetLUT
  Parameters
-   uint16_t  Val2Check The number to find the MSB in
+   uint32_t  Val2Check The number to find the MSB in
  Returns
    bit number of the MSB that is set in Val2Check, 128 if Val2Check = 0
  Description
-   find the MSB that is set in Val2Check and returns that bit number
+   find the MSB that is set in Val2Check and returns that bit number, using
+   the Nybble2MSBitNum table
  Notes
-
+   This is the portable version, used when the port does not provide
+   ES_CountLeadingZeros
  Author
    J. Edward Carryer, 10/20/13, 17:03
 ****************************************************************************/
-uint8_t ES_GetMSBitSet(uint16_t Val2Check);
+uint8_t ES_GetMSBitSetLUT(uint32_t Val2Check);
+
+/****************************************************************************
+ Macro
+   ES_GetMSBitSet
+ Parameters
+   uint32_t  Val2Check The number to find the MSB in
+ Returns
+   bit number of the MSB that is set in Val2Check, 128 if Val2Check = 0
+ Description
+   find the MSB that is set in Val2Check and returns that bit number
+ Notes
+   When the port provides a count leading zeros intrinsic, this is a single
+   instruction plus the test for 0, otherwise it falls back to the look-up
+   table version. Val2Check is evaluated more than once in the CLZ version.
+****************************************************************************/
+#ifdef ES_CountLeadingZeros
+#define ES_GetMSBitSet(Val2Check)                                            \
+  (((Val2Check) == 0) ? (uint8_t)128 :                                       \
+   (uint8_t)(31 - ES_CountLeadingZeros((uint32_t)(Val2Check))))
+#else
+#define ES_GetMSBitSet(Val2Check) ES_GetMSBitSetLUT(Val2Check)
+#endif
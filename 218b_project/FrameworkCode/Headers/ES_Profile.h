@@ -0,0 +1,52 @@
+/****************************************************************************
+ Module
+     ES_Profile.h
+ Description
+     header file for the optional dispatch profiler built into ES_Run
+ Notes
+     Everything here compiles away unless ES_PROFILE is defined in
+     ES_Configure.h
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 14:10         started coding
+*****************************************************************************/
+#ifndef ES_Profile_H
+#define ES_Profile_H
+
+#include "ES_Configure.h"
+#include "ES_Types.h"
+#include "ES_Events.h"
+
+#ifdef ES_PROFILE
+
+// number of log2 buckets in each histogram. Bucket 0 counts times below
+// 2^ES_PROFILE_HIST_SHIFT clock counts, each bucket after that covers twice
+// the time of the one before it, the last one catches everything longer
+#define ES_PROFILE_NUM_BUCKETS 16
+#define ES_PROFILE_HIST_SHIFT 6
+
+// what is kept for each service & event type pair
+typedef struct
+{
+  uint32_t Count;                               // number of dispatches
+  uint32_t ExecMax;                             // longest run function time
+  uint32_t WaitMax;                             // longest post to dispatch
+  uint64_t ExecTotal;
+  uint64_t WaitTotal;
+  uint16_t ExecHist[ES_PROFILE_NUM_BUCKETS];    // saturate at 0xFFFF
+  uint16_t WaitHist[ES_PROFILE_NUM_BUCKETS];
+}ES_ProfileStats_t;
+
+void ES_Profile_Init(void);
+void ES_Profile_Reset(void);
+void ES_Profile_Posted(uint8_t WhichService, bool AtFront);
+void ES_Profile_BeginRun(uint8_t WhichService, ES_EventType_t WhichEvent);
+void ES_Profile_EndRun(void);
+ES_ProfileStats_t const *ES_Profile_GetStats(uint8_t WhichService,
+    ES_EventType_t WhichEvent);
+void ES_Profile_Dump(void);
+
+#endif /* ES_PROFILE */
+
+#endif /* ES_Profile_H */
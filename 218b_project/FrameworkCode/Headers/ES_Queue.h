@@ -20,13 +20,38 @@
 #include "ES_Types.h"
 #include "ES_Events.h"
 
+/* the kinds of queue that a service can be given in SERVICE_LIST.
+   ES_QUEUE_STANDARD is the original circular buffer, any number of
+   producers may post to it and it supports LIFO posting.
+   ES_QUEUE_SPSC is lock-free, for a queue with a single producer context
+   (one ISR, or only the main loop) and ES_Run as the single consumer. Its
+   size must be a power of two, no larger than 128, and it is FIFO only.
+*/
+typedef enum
+{
+  ES_QUEUE_STANDARD,
+  ES_QUEUE_SPSC
+}ES_QueueKind_t;
+
+// returned by ES_EnQueueFIFOSlot when the queue is full
+#define ES_QUEUE_NO_SLOT 0xFF
+
 /* prototypes for public functions */
 
 uint8_t ES_InitQueue(ES_Event_t *pBlock, uint8_t BlockSize);
 bool ES_EnQueueFIFO(ES_Event_t *pBlock, ES_Event_t Event2Add);
 bool ES_EnQueueLIFO(ES_Event_t *pBlock, ES_Event_t Event2Add);
+uint8_t ES_EnQueueFIFOSlot(ES_Event_t *pBlock, ES_Event_t Event2Add);
+ES_Event_t *ES_GetQueueSlot(ES_Event_t *pBlock, uint8_t Slot);
 uint8_t ES_DeQueue(ES_Event_t *pBlock, ES_Event_t *pReturnEvent);
 //void EF_FlushQueue( unsigned char * pBlock );
 bool ES_IsQueueEmpty(ES_Event_t *pBlock);
+uint8_t ES_GetQueueDepth(ES_Event_t *pBlock);
+
+uint8_t ES_InitSPSCQueue(ES_Event_t *pBlock, uint8_t BlockSize);
+bool ES_EnQueueSPSC(ES_Event_t *pBlock, ES_Event_t Event2Add);
+uint8_t ES_DeQueueSPSC(ES_Event_t *pBlock, ES_Event_t *pReturnEvent);
+bool ES_IsSPSCQueueEmpty(ES_Event_t *pBlock);
+uint8_t ES_GetSPSCQueueDepth(ES_Event_t *pBlock);
 
 #endif /*ES_Queue_H */
@@ -0,0 +1,60 @@
+/****************************************************************************
+ Module
+     ES_Sched.h
+ Description
+     header file for the scheduling policies that ES_Run can use to choose
+     the next service to run, and for the deadline bookkeeping behind them
+ Notes
+     ES_SCHED_POLICY and ES_DEADLINES are set in ES_Configure.h
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 16:40         started coding
+*****************************************************************************/
+#ifndef ES_Sched_H
+#define ES_Sched_H
+
+#include "ES_Configure.h"
+#include "ES_Types.h"
+#include "ES_Port.h"
+
+// the values that ES_SCHED_POLICY can take
+#define ES_SCHED_STATIC 0   // highest numbered service with an event first
+#define ES_SCHED_EDF    1   // service whose oldest event is due soonest first
+
+#ifndef ES_SCHED_POLICY
+#define ES_SCHED_POLICY ES_SCHED_STATIC
+#endif
+
+#if (ES_SCHED_POLICY != ES_SCHED_STATIC) && (ES_SCHED_POLICY != ES_SCHED_EDF)
+#error "ES_SCHED_POLICY must be ES_SCHED_STATIC or ES_SCHED_EDF"
+#endif
+
+// EDF can not work without the deadlines
+#if (ES_SCHED_POLICY == ES_SCHED_EDF) && !defined(ES_DEADLINES)
+#define ES_DEADLINES
+#endif
+
+#ifdef ES_DEADLINES
+
+// kept for each service, times are in _HW_GetCycleCount counts
+typedef struct
+{
+  uint32_t Dispatches;    // events handled
+  uint32_t Misses;        // events whose run function finished late
+  uint32_t MaxResponse;   // longest from post to run function return
+  uint32_t MaxLate;       // furthest past the deadline, 0 if never missed
+}ES_DeadlineStats_t;
+
+void ES_Sched_Init(void);
+void ES_Sched_Posted(uint8_t WhichService, bool AtFront);
+uint8_t ES_Sched_PickEDF(uint32_t ReadyBits);
+void ES_Sched_BeginRun(uint8_t WhichService);
+void ES_Sched_EndRun(void);
+ES_DeadlineStats_t const *ES_Sched_GetStats(uint8_t WhichService);
+void ES_Sched_ResetStats(void);
+void ES_Sched_PrintStats(void);
+
+#endif /* ES_DEADLINES */
+
+#endif /* ES_Sched_H */
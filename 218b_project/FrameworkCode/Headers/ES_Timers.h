@@ -33,6 +33,7 @@
 
 #include "ES_Port.h"
 #include "ES_Types.h"
+#include "ES_PostList.h"
 
 typedef enum
 {
@@ -42,13 +43,24 @@ typedef enum
   ES_Timer_NOT_ACTIVE = 0
 }ES_TimerReturn_t;
 
+// returned by ES_Timer_AllocTimer when there are no timers left
+#define ES_Timer_NO_TIMER 0xFF
+
+// returned by ES_Timer_GetTicksToNextExpiry when no timers are running
+#define ES_Timer_NO_EXPIRY 0xFFFFFFFFUL
+
 void ES_Timer_Init(TimerRate_t Rate);
 void ES_Timer_Tick_Resp(void);
-ES_TimerReturn_t ES_Timer_InitTimer(uint8_t Num, uint16_t NewTime);
-ES_TimerReturn_t ES_Timer_SetTimer(uint8_t Num, uint16_t NewTime);
+ES_TimerReturn_t ES_Timer_InitTimer(uint8_t Num, uint32_t NewTime);
+ES_TimerReturn_t ES_Timer_InitPeriodicTimer(uint8_t Num, uint32_t Period);
+ES_TimerReturn_t ES_Timer_SetTimer(uint8_t Num, uint32_t NewTime);
 ES_TimerReturn_t ES_Timer_StartTimer(uint8_t Num);
 ES_TimerReturn_t ES_Timer_StopTimer(uint8_t Num);
+uint8_t ES_Timer_AllocTimer(pPostFunc PostFunc);
+ES_TimerReturn_t ES_Timer_FreeTimer(uint8_t Num);
 uint16_t ES_Timer_GetTime(void);
+uint32_t ES_Timer_GetTicksToNextExpiry(void);
+void ES_Timer_AdvanceTicks(uint32_t Ticks);
 
 #endif   /* ES_Timers_H */
 /*------------------------------ End of file ------------------------------*/
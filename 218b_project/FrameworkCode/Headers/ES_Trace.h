@@ -0,0 +1,80 @@
+/****************************************************************************
+ Module
+     ES_Trace.h
+ Description
+     header file for the optional trace recorder, which keeps the most
+     recent posts and dispatches in a ring in RAM
+ Notes
+     ES_TRACE_SIZE is set in ES_Configure.h, everything here compiles away
+     unless it is defined.
+
+     ES_Trace_Dump prints the ring as hex, one record per line, between an
+     ES_TRACE header and an ES_TRACE_END line. Capture that from the
+     terminal and decode it with Tools/ES_TraceDecode.py, or feed it back
+     to the services with ES_Trace_Replay in a host (ES_PORT_POSIX) build.
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 21:40         started coding
+*****************************************************************************/
+#ifndef ES_Trace_H
+#define ES_Trace_H
+
+#include "ES_Configure.h"
+#include "ES_Types.h"
+#include "ES_Events.h"
+
+#ifdef ES_TRACE_SIZE
+
+#if (ES_TRACE_SIZE < 16) || ((ES_TRACE_SIZE & (ES_TRACE_SIZE - 1)) != 0)
+#error "ES_TRACE_SIZE must be a power of two, 16 or more"
+#endif
+
+// what a record is about
+#define ES_TRACE_POST     0   // put at the tail of a queue
+#define ES_TRACE_LIFO     1   // put at the head of a queue
+#define ES_TRACE_MERGED   2   // coalesced into an event already waiting
+#define ES_TRACE_PUBLISH  3   // put on the bus
+#define ES_TRACE_DISPATCH 4   // handed to a run function
+
+// or'ed into a post that was lost because the queue or the bus was full
+#define ES_TRACE_REFUSED  0x80
+
+// Source when the post did not come from a run function, and Target for
+// the bus
+#define ES_TRACE_NO_SERVICE 0xFF
+#define ES_TRACE_BUS        0xFE
+
+typedef struct
+{
+  uint32_t  Time;         // _HW_GetCycleCount
+  uint16_t  Param;
+  uint8_t   Type;
+  uint8_t   Kind;
+  uint8_t   Source;       // whose run function posted
+  uint8_t   Interrupt;    // exception number of the poster, 0 if not ISR
+  uint8_t   Target;       // the service posted to or dispatched
+}ES_TraceRecord_t;
+
+void ES_Trace_Init(void);
+void ES_Trace_Post(uint8_t Kind, uint8_t Target, ES_Event_t ThisEvent);
+void ES_Trace_BeginRun(uint8_t WhichService, ES_Event_t ThisEvent);
+void ES_Trace_EndRun(void);
+void ES_Trace_Start(void);
+void ES_Trace_Stop(void);
+void ES_Trace_Dump(void);
+
+#ifdef ES_PORT_POSIX
+bool ES_Trace_IsReplaying(void);
+bool ES_Trace_Replayed(uint8_t Kind, uint8_t Target, ES_Event_t ThisEvent);
+bool ES_Trace_Replay(char const *pFileName);
+#else
+// only the host can replay, these let the framework's replay checks
+// compile away
+#define ES_Trace_IsReplaying() false
+#define ES_Trace_Replayed(Kind, Target, ThisEvent) true
+#endif
+
+#endif /* ES_TRACE_SIZE */
+
+#endif /* ES_Trace_H */
@@ -8,6 +8,7 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/17/26 21:20         added Check4TraceKey
  10/18/15 11:50 jec      added #include for stdint & stdbool
  08/06/13 14:37 jec      started coding
 *****************************************************************************/
@@ -22,5 +23,6 @@
 // prototypes for event checkers
 
 bool Check4Keystroke(void);
+bool Check4TraceKey(void);
 
 #endif /* EventCheckers_H */
@@ -421,7 +421,12 @@ bool Check4SharpEvents(void)
 {
   bool      ReturnValue = false;
   uint32_t  Counts[NUM_ADC_PINS];
-  ADC_MultiRead(Counts);
+
+  //nothing has been converted yet, so there is nothing to compare
+  if (ADC_MultiLatest(Counts) == 0)
+  {
+    return false;
+  }
   uint32_t  Count = Counts[SHARP_ADC];
 
   if ((Count >= SHARP_THRESHOLD + 5) && (LastCount < SHARP_THRESHOLD - 5))
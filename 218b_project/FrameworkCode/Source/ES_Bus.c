@@ -0,0 +1,1085 @@
+/****************************************************************************
+ Module
+     ES_Bus.c
+ Description
+     optional publish/subscribe bus. Each event type has a mask of the
+     services subscribed to it. Publishing an event writes it once into a
+     ring shared by all of the services and sets all of the subscribers'
+     Ready bits at once, each service then takes it from the ring when
+     ES_Run dispatches to it. Either every subscriber gets the event or,
+     if the ring is full, none of them do.
+ Notes
+     Only compiled when ES_BUS_SIZE is defined in ES_Configure.h
+
+     Every entry in the ring carries a mask of the subscribers that have not
+     taken it yet. An entry is free again once its mask is empty and all of
+     the entries before it are free, so one slow subscriber holds up the
+     whole bus: size it for the slowest.
+
+     Each service has a cursor into the ring, past the entries it has
+     already looked at. Entries that were not for it are never for it
+     later, so its cursor only moves forward.
+
+     A service gets its bus events and its queue events merged back into
+     the order they were posted in. Each service has a ring with a bit for
+     every event waiting for it, set if the event is on the bus and clear
+     if it is in the queue. Publishes add to the rings, the framework's post
+     functions call ES_Bus_Queued, and ES_Bus_Take follows the ring. The
+     rings that ES_Profile & ES_Sched keep in post order then line up with
+     the events as they are run.
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 18:30         started coding
+*****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Configure.h"
+
+// the host test at the bottom always needs the bus
+#if defined(TEST) && defined(ES_PORT_POSIX) && !defined(ES_BUS_SIZE)
+#define ES_BUS_SIZE 8
+#endif
+
+#include "ES_Bus.h"
+
+#ifdef ES_BUS_SIZE
+
+#include "ES_General.h"
+#include "ES_Port.h"
+#include "ES_LookupTables.h"
+#include "ES_Profile.h"
+#include "ES_Sched.h"
+#include "ES_Trace.h"
+#include <stdio.h>
+#include <string.h>
+
+/*--------------------------- External Variables --------------------------*/
+// the Ready bits in ES_Framework.c
+extern volatile uint32_t Ready;
+
+/*----------------------------- Module Defines ----------------------------*/
+#define BUS_MASK (ES_BUS_SIZE - 1)
+
+// the bits of all of the services in SERVICE_LIST
+#define ALL_SERVICES ((uint32_t)((1ULL << NUM_SERVICES) - 1))
+
+typedef struct
+{
+  ES_Event_t  Event;
+  uint32_t    Pending;    // subscribers that have not taken it yet
+}BusEntry_t;
+
+typedef struct
+{
+  uint32_t  *pFromBus;    // a bit for each waiting event, set if on the bus
+  uint16_t  Size;
+  uint16_t  First;
+  uint16_t  Count;
+}OrderRing_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+static uint32_t FindNext(uint8_t WhichService);
+static void AddToOrder(uint8_t WhichService, bool FromBus, bool AtFront);
+
+/*---------------------------- Module Variables ---------------------------*/
+static BusEntry_t Entries[ES_BUS_SIZE];
+
+// free running counts of entries, the ring index is the count & BUS_MASK.
+// Head is where the next publish goes, every entry before Tail has been
+// taken by all of its subscribers. Only changed with interrupts off
+static uint32_t Head;
+static uint32_t Tail;
+static uint32_t Cursors[NUM_SERVICES];
+
+static uint32_t Subscribers[NUM_EVENT_TYPES];
+
+static ES_BusStats_t Stats;
+
+// one order ring per service, with room for a full queue and a full bus
+#define ORDER_ENTRY(Init, Run, QueueSize, Kind) \
+  static uint32_t Order_##Run[((QueueSize) + ES_BUS_SIZE + 31) / 32];
+
+SERVICE_LIST(ORDER_ENTRY)
+
+#define ORDER_RING_ENTRY(Init, Run, QueueSize, Kind) \
+  { Order_##Run, (QueueSize) + ES_BUS_SIZE, 0, 0 },
+
+static OrderRing_t OrderRings[NUM_SERVICES] = {
+  SERVICE_LIST(ORDER_RING_ENTRY)
+};
+
+#ifdef BUS_SUBSCRIPTIONS
+// the subscriptions that are in place from the start, from
+// BUS_SUBSCRIPTIONS. Services are named by their run functions, so first
+// number them
+#define SERV_INDEX_ENTRY(Init, Run, QueueSize, Kind) BusIndex_##Run,
+
+enum
+{
+  SERVICE_LIST(SERV_INDEX_ENTRY)
+};
+
+typedef struct
+{
+  uint8_t         Service;
+  ES_EventType_t  Event;
+}Subscription_t;
+
+#define SUBSCRIPTION_ENTRY(Run, Type) { BusIndex_##Run, Type },
+
+static Subscription_t const InitialSubscriptions[] = {
+  BUS_SUBSCRIPTIONS(SUBSCRIPTION_ENTRY)
+};
+#endif
+
+// names for the printout, taken from the run functions
+#define NAME_ENTRY(Init, Run, QueueSize, Kind) #Run,
+
+static char const *const ServiceNames[NUM_SERVICES] = {
+  SERVICE_LIST(NAME_ENTRY)
+};
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+   ES_Bus_Init
+ Parameters
+   None
+ Returns
+   None
+ Description
+   empties the bus, sets up the subscriptions from BUS_SUBSCRIPTIONS and
+   clears the statistics
+ Notes
+   called by ES_Initialize before any of the services are initialized, so
+   that their init functions can subscribe & publish
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Bus_Init(void)
+{
+  uint8_t i;
+
+  Head = 0;
+  Tail = 0;
+  memset(Entries, 0, sizeof(Entries));
+  memset(Cursors, 0, sizeof(Cursors));
+  memset(Subscribers, 0, sizeof(Subscribers));
+  for (i = 0; i < NUM_SERVICES; i++)
+  {
+    OrderRings[i].First = 0;
+    OrderRings[i].Count = 0;
+  }
+#ifdef BUS_SUBSCRIPTIONS
+  for (i = 0; i < ARRAY_SIZE(InitialSubscriptions); i++)
+  {
+    Subscribers[InitialSubscriptions[i].Event] |=
+        BitNum2SetMask[InitialSubscriptions[i].Service];
+  }
+#endif
+  ES_Bus_ResetStats();
+}
+
+/****************************************************************************
+ Function
+   ES_Bus_Subscribe
+ Parameters
+   uint8_t : the service that wants the events (its priority)
+   ES_EventType_t : the event type it wants
+ Returns
+   bool : false if there is no such service or event type
+ Description
+   adds the service to the subscribers of the event type, it gets every
+   event of that type published from now on
+ Notes
+
+ Author
+   10/17/26
+****************************************************************************/
+bool ES_Bus_Subscribe(uint8_t WhichService, ES_EventType_t WhichEvent)
+{
+  if ((WhichService >= NUM_SERVICES) ||
+      ((uint16_t)WhichEvent >= NUM_EVENT_TYPES))
+  {
+    return false;
+  }
+  ES_AtomicSetBits(&Subscribers[WhichEvent], BitNum2SetMask[WhichService]);
+  return true;
+}
+
+/****************************************************************************
+ Function
+   ES_Bus_Unsubscribe
+ Parameters
+   uint8_t : the service that no longer wants the events (its priority)
+   ES_EventType_t : the event type
+ Returns
+   bool : false if there is no such service or event type
+ Description
+   takes the service off the subscribers of the event type
+ Notes
+   events of that type that were published before this are still on the
+   bus for the service, and it will still get them
+ Author
+   10/17/26
+****************************************************************************/
+bool ES_Bus_Unsubscribe(uint8_t WhichService, ES_EventType_t WhichEvent)
+{
+  if ((WhichService >= NUM_SERVICES) ||
+      ((uint16_t)WhichEvent >= NUM_EVENT_TYPES))
+  {
+    return false;
+  }
+  ES_AtomicClrBits(&Subscribers[WhichEvent], BitNum2SetMask[WhichService]);
+  return true;
+}
+
+/****************************************************************************
+ Function
+   ES_Bus_GetSubscribers
+ Parameters
+   ES_EventType_t : the event type
+ Returns
+   uint32_t : a bit for each subscribed service, bit 0 for service 0
+ Description
+   lets the application see who is listening
+ Notes
+
+ Author
+   10/17/26
+****************************************************************************/
+uint32_t ES_Bus_GetSubscribers(ES_EventType_t WhichEvent)
+{
+  if ((uint16_t)WhichEvent >= NUM_EVENT_TYPES)
+  {
+    return 0;
+  }
+  return Subscribers[WhichEvent];
+}
+
+/****************************************************************************
+ Function
+   ES_Bus_Publish
+ Parameters
+   ES_Event_t : the event to deliver
+ Returns
+   bool : false if the bus was full (nobody gets it) or the event type is
+   out of range, true otherwise, even if nobody is subscribed
+ Description
+   delivers the event to every service subscribed to its type
+ Notes
+   may be called from an ISR
+ Author
+   10/17/26
+****************************************************************************/
+bool ES_Bus_Publish(ES_Event_t ThisEvent)
+{
+  if ((uint16_t)ThisEvent.EventType >= NUM_EVENT_TYPES)
+  {
+    return false;
+  }
+  return ES_Bus_PublishTo(Subscribers[ThisEvent.EventType], ThisEvent);
+}
+
+/****************************************************************************
+ Function
+   ES_Bus_PublishTo
+ Parameters
+   uint32_t : a bit for each service to deliver to, bit 0 for service 0
+   ES_Event_t : the event to deliver
+ Returns
+   bool : false if the bus was full, in which case nobody gets it
+ Description
+   delivers the event to the given services, whatever their subscriptions
+ Notes
+   used by ES_PostAll with every bit set, bits past the last service are
+   ignored. May be called from an ISR, the whole publish happens with
+   interrupts off. The critical region saves its own PRIMASK since the
+   caller may already be in one.
+ Author
+   10/17/26
+****************************************************************************/
+bool ES_Bus_PublishTo(uint32_t Targets, ES_Event_t ThisEvent)
+{
+  BusEntry_t  *pEntry;
+  uint32_t    SavedPRIMASK;
+  uint32_t    Depth;
+  uint32_t    ToOrder;
+  uint8_t     WhichService;
+  bool        ReturnVal = true;
+
+#ifdef ES_TRACE_SIZE
+  // a replayed run function's publishes are checked, not delivered
+  if (ES_Trace_IsReplaying())
+  {
+    return ES_Trace_Replayed(ES_TRACE_PUBLISH, ES_TRACE_BUS, ThisEvent);
+  }
+#endif
+  Targets &= ALL_SERVICES;
+  SavedPRIMASK = CPUgetPRIMASK_cpsid();
+  // let go of the entries that all of their subscribers have taken
+  while ((Tail != Head) && (Entries[Tail & BUS_MASK].Pending == 0))
+  {
+    Tail++;
+  }
+  if (Targets == 0)
+  {
+    Stats.Publishes++;
+    Stats.Unheard++;
+  }
+  else if ((Head - Tail) >= ES_BUS_SIZE)
+  {
+    Stats.NumDrops++;
+    Stats.LastDrop = ThisEvent;
+    Stats.LastBlockers = Entries[Tail & BUS_MASK].Pending;
+    ReturnVal = false;
+  }
+  else
+  {
+    pEntry = &Entries[Head & BUS_MASK];
+    pEntry->Event = ThisEvent;
+    pEntry->Pending = Targets;
+    Head++;
+    Depth = Head - Tail;
+    if (Depth > Stats.PeakDepth)
+    {
+      Stats.PeakDepth = (uint8_t)Depth;
+    }
+    Stats.Publishes++;
+    // each subscriber gets it after everything already posted to it, and
+    // the rings that shadow the queues need an entry for each subscriber
+    ToOrder = Targets;
+    while (ToOrder != 0)
+    {
+      WhichService = ES_GetMSBitSet(ToOrder);
+      ToOrder &= ~BitNum2SetMask[WhichService];
+      AddToOrder(WhichService, true, false);
+#ifdef ES_PROFILE
+      ES_Profile_Posted(WhichService, false);
+#endif
+#ifdef ES_DEADLINES
+      ES_Sched_Posted(WhichService, false);
+#endif
+    }
+    // show all of the subscribers as having something to do
+    ES_AtomicSetBits(&Ready, Targets);
+  }
+  CPUsetPRIMASK(SavedPRIMASK);
+#ifdef ES_TRACE_SIZE
+  ES_Trace_Post(ReturnVal ? ES_TRACE_PUBLISH :
+      ES_TRACE_PUBLISH | ES_TRACE_REFUSED, ES_TRACE_BUS, ThisEvent);
+#endif
+  return ReturnVal;
+}
+
+/****************************************************************************
+ Function
+   ES_Bus_Queued
+ Parameters
+   uint8_t : the service whose queue was just posted to
+   bool : true if the event went to the front of the queue (LIFO)
+ Returns
+   None
+ Description
+   records where the event falls among the service's bus events, so that
+   ES_Run hands them all over in the order they were posted
+ Notes
+   called from the framework post functions after a successful enqueue,
+   in the same critical region, so that an interrupt can not get a publish
+   in between the event and its place in the ring. The ring update still
+   saves its own PRIMASK so that it is safe to call on its own.
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Bus_Queued(uint8_t WhichService, bool AtFront)
+{
+  uint32_t SavedPRIMASK;
+
+  SavedPRIMASK = CPUgetPRIMASK_cpsid();
+  AddToOrder(WhichService, false, AtFront);
+  CPUsetPRIMASK(SavedPRIMASK);
+}
+
+/****************************************************************************
+ Function
+   ES_Bus_Take
+ Parameters
+   uint8_t : the service that is about to run
+   ES_Event_t * : where to put its event
+ Returns
+   bool : true if the service's next event was on the bus, false if it is
+   in the service's queue
+ Description
+   hands over the service's oldest event if it came through the bus
+ Notes
+   called by ES_Run before it looks in the service's queue, which it only
+   does if this returns false
+ Author
+   10/17/26
+****************************************************************************/
+bool ES_Bus_Take(uint8_t WhichService, ES_Event_t *pEvent)
+{
+  OrderRing_t *pRing = &OrderRings[WhichService];
+  BusEntry_t  *pEntry;
+  uint32_t    SavedPRIMASK;
+  uint32_t    Next;
+  bool        FromBus;
+  bool        ReturnVal = false;
+
+  SavedPRIMASK = CPUgetPRIMASK_cpsid();
+  if (pRing->Count != 0)
+  {
+    FromBus = ((pRing->pFromBus[pRing->First >> 5] &
+        BitNum2SetMask[pRing->First & 31]) != 0);
+    if (++pRing->First >= pRing->Size)
+    {
+      pRing->First = 0;
+    }
+    pRing->Count--;
+    if (FromBus)
+    {
+      Next = FindNext(WhichService);
+      if (Next != Head)
+      {
+        pEntry = &Entries[Next & BUS_MASK];
+        *pEvent = pEntry->Event;
+        pEntry->Pending &= ~BitNum2SetMask[WhichService];
+        Cursors[WhichService] = Next + 1;
+        ReturnVal = true;
+      }
+    }
+  }
+  CPUsetPRIMASK(SavedPRIMASK);
+  return ReturnVal;
+}
+
+/****************************************************************************
+ Function
+   ES_Bus_HasEvents
+ Parameters
+   uint8_t : the service to look for
+ Returns
+   bool : true if there is an event on the bus that it has not taken
+ Description
+   lets ES_Run decide whether the service's Ready bit can be cleared
+ Notes
+
+ Author
+   10/17/26
+****************************************************************************/
+bool ES_Bus_HasEvents(uint8_t WhichService)
+{
+  uint32_t  SavedPRIMASK;
+  bool      ReturnVal;
+
+  SavedPRIMASK = CPUgetPRIMASK_cpsid();
+  ReturnVal = (FindNext(WhichService) != Head);
+  CPUsetPRIMASK(SavedPRIMASK);
+  return ReturnVal;
+}
+
+/****************************************************************************
+ Function
+   ES_Bus_GetStats
+ Parameters
+   None
+ Returns
+   pointer to the statistics for the bus
+ Description
+   lets the application see how full the bus gets and what it has dropped
+ Notes
+   the counts may change while they are being read if publishes go on
+ Author
+   10/17/26
+****************************************************************************/
+ES_BusStats_t const *ES_Bus_GetStats(void)
+{
+  return &Stats;
+}
+
+/****************************************************************************
+ Function
+   ES_Bus_ResetStats
+ Parameters
+   None
+ Returns
+   None
+ Description
+   clears the counts, the peak depth starts over at the depth now
+ Notes
+
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Bus_ResetStats(void)
+{
+  uint32_t SavedPRIMASK;
+
+  SavedPRIMASK = CPUgetPRIMASK_cpsid();
+  memset(&Stats, 0, sizeof(Stats));
+  Stats.PeakDepth = (uint8_t)(Head - Tail);
+  CPUsetPRIMASK(SavedPRIMASK);
+}
+
+/****************************************************************************
+ Function
+   ES_Bus_PrintStats
+ Parameters
+   None
+ Returns
+   None
+ Description
+   prints the use of the bus, who is subscribed to what, and who was
+   holding the bus up at the last drop
+ Notes
+   goes out through printf, so it takes a while
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Bus_PrintStats(void)
+{
+  uint16_t Type;
+  uint8_t  i;
+
+  printf("\r\nBus size %u peak %u publishes %lu unheard %lu drops %lu\r\n",
+      ES_BUS_SIZE, Stats.PeakDepth, (unsigned long)Stats.Publishes,
+      (unsigned long)Stats.Unheard, (unsigned long)Stats.NumDrops);
+  for (Type = 0; Type < NUM_EVENT_TYPES; Type++)
+  {
+    if (Subscribers[Type] != 0)
+    {
+      printf("    event %3u ->", Type);
+      for (i = 0; i < NUM_SERVICES; i++)
+      {
+        if ((Subscribers[Type] & BitNum2SetMask[i]) != 0)
+        {
+          printf(" %s", ServiceNames[i]);
+        }
+      }
+      printf("\r\n");
+    }
+  }
+  if (Stats.NumDrops != 0)
+  {
+    printf("    last drop: event %u param %u, waiting on",
+        Stats.LastDrop.EventType, Stats.LastDrop.EventParam);
+    for (i = 0; i < NUM_SERVICES; i++)
+    {
+      if ((Stats.LastBlockers & BitNum2SetMask[i]) != 0)
+      {
+        printf(" %s", ServiceNames[i]);
+      }
+    }
+    printf("\r\n");
+  }
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+/****************************************************************************
+ Function
+   FindNext
+ Parameters
+   uint8_t : the service to look for
+ Returns
+   uint32_t : the count of the first entry from the service's cursor on
+   that it has not taken, Head if there is none
+ Description
+   moves the service's cursor up to that entry, since nothing it skips
+   over is for the service
+ Notes
+   call with interrupts off. A cursor that has fallen behind Tail, or
+   wrapped past it, is brought up to Tail: everything before Tail has been
+   taken by all of its subscribers
+****************************************************************************/
+static uint32_t FindNext(uint8_t WhichService)
+{
+  uint32_t Mask = BitNum2SetMask[WhichService];
+  uint32_t Next = Cursors[WhichService];
+
+  if ((Head - Next) > (Head - Tail))
+  {
+    Next = Tail;
+  }
+  while ((Next != Head) && ((Entries[Next & BUS_MASK].Pending & Mask) == 0))
+  {
+    Next++;
+  }
+  Cursors[WhichService] = Next;
+  return Next;
+}
+
+/****************************************************************************
+ Function
+   AddToOrder
+ Parameters
+   uint8_t : the service that was posted to
+   bool : true if the event went on the bus, false if into the queue
+   bool : true if the event went to the front of the queue (LIFO)
+ Returns
+   None
+ Description
+   adds the event's place to the service's order ring
+ Notes
+   call with interrupts off. The ring always has room, a service can not
+   have more than a full queue and a full bus waiting
+****************************************************************************/
+static void AddToOrder(uint8_t WhichService, bool FromBus, bool AtFront)
+{
+  OrderRing_t *pRing = &OrderRings[WhichService];
+  uint16_t    Index;
+
+  if (pRing->Count >= pRing->Size)
+  {
+    return;
+  }
+  if (AtFront)
+  {
+    pRing->First = (pRing->First == 0) ? (pRing->Size - 1) :
+        (pRing->First - 1);
+    Index = pRing->First;
+  }
+  else
+  {
+    Index = pRing->First + pRing->Count;
+    if (Index >= pRing->Size)
+    {
+      Index -= pRing->Size;
+    }
+  }
+  if (FromBus)
+  {
+    pRing->pFromBus[Index >> 5] |= BitNum2SetMask[Index & 31];
+  }
+  else
+  {
+    pRing->pFromBus[Index >> 5] &= ~BitNum2SetMask[Index & 31];
+  }
+  pRing->Count++;
+}
+
+#if defined(TEST) && defined(ES_PORT_POSIX)
+/*
+  Host test of the bus with the framework's use of it, for the services in
+  ES_Configure.h. Each service gets a plain queue of its configured size,
+  and a model of ES_Run takes its events with ES_Bus_Take then ES_DeQueue.
+  Random FIFO & LIFO posts, publishes to random services and to the
+  subscribers of an event type, subscription changes and dispatches are
+  checked against a model of what each service should get, in what
+  order, and when the bus should refuse a publish. The Ready bits must be
+  set exactly when a service has something waiting. The queue functions
+  come from ES_Queue.c and the tables from ES_LookupTables.c, both built
+  without TEST so that their own tests are left out:
+  gcc -DES_PORT_POSIX -I<app headers> -IHeaders -c Source/ES_Queue.c \
+      Source/ES_LookupTables.c
+  gcc -O2 -DTEST -DES_PORT_POSIX -I<app headers> -IHeaders Source/ES_Bus.c \
+      ES_Queue.o ES_LookupTables.o
+*/
+#include "ES_Queue.h"
+
+#define NUM_TEST_OPS 1000000UL
+#define MAX_WAITING  256          // more than any queue plus the bus
+#define TEST_EVENT   ((ES_EventType_t)(NUM_EVENT_TYPES - 1))
+
+// stand-ins for the port and the framework, so that this test links on
+// its own
+uint32_t _PRIMASK_temp;
+volatile uint32_t Ready;
+
+uint32_t CPUgetPRIMASK_cpsid(void)
+{
+  return 0;
+}
+
+void CPUsetPRIMASK(uint32_t newPRIMASK)
+{
+  (void)newPRIMASK;
+}
+
+#ifdef ES_TRACE_SIZE
+bool ES_Trace_IsReplaying(void)
+{
+  return false;
+}
+
+bool ES_Trace_Replayed(uint8_t Kind, uint8_t Target, ES_Event_t ThisEvent)
+{
+  (void)Kind;
+  (void)Target;
+  (void)ThisEvent;
+  return true;
+}
+
+void ES_Trace_Post(uint8_t Kind, uint8_t Target, ES_Event_t ThisEvent)
+{
+  (void)Kind;
+  (void)Target;
+  (void)ThisEvent;
+}
+#endif
+
+#ifdef ES_PROFILE
+void ES_Profile_Posted(uint8_t WhichService, bool AtFront)
+{
+  (void)WhichService;
+  (void)AtFront;
+}
+#endif
+
+#ifdef ES_DEADLINES
+void ES_Sched_Posted(uint8_t WhichService, bool AtFront)
+{
+  (void)WhichService;
+  (void)AtFront;
+}
+#endif
+
+#define TEST_QUEUE_ENTRY(Init, Run, QueueSize, Kind) \
+  static ES_Event_t TestQueue_##Run[(QueueSize)];
+
+SERVICE_LIST(TEST_QUEUE_ENTRY)
+
+#define TEST_QUEUE_PTR(Init, Run, QueueSize, Kind) \
+  { TestQueue_##Run, (QueueSize) },
+
+static struct
+{
+  ES_Event_t  *pMem;
+  uint8_t     Size;
+} const TestQueues[NUM_SERVICES] = {
+  SERVICE_LIST(TEST_QUEUE_PTR)
+};
+
+// what each service should get next, oldest first
+typedef struct
+{
+  uint16_t  Param[MAX_WAITING];
+  uint16_t  First;
+  uint16_t  Count;
+  uint16_t  InQueue;
+}ModelService_t;
+
+static ModelService_t Model[NUM_SERVICES];
+// the bus entries, by the same free running count as the bus
+static uint32_t       ModelPending[ES_BUS_SIZE];
+static uint32_t       ModelHead;
+static uint32_t       ModelTail;
+static uint32_t       ModelDrops;
+static uint32_t       ModelSubscribers;
+static uint16_t       NextParam;
+static uint32_t       Errors;
+static uint32_t       RandomState = 12345;
+
+static void Check(bool Condition, char const *pWhat)
+{
+  if (Condition != true)
+  {
+    printf("FAILED: %s\n", pWhat);
+    Errors++;
+  }
+}
+
+static uint32_t Random(uint32_t Range)
+{
+  RandomState = RandomState * 1103515245u + 12345u;
+  return (RandomState >> 8) % Range;
+}
+
+static void ModelAdd(uint8_t Service, uint16_t Param, bool AtFront)
+{
+  ModelService_t *pModel = &Model[Service];
+
+  if (AtFront)
+  {
+    pModel->First = (uint16_t)((pModel->First + MAX_WAITING - 1) %
+        MAX_WAITING);
+    pModel->Param[pModel->First] = Param;
+  }
+  else
+  {
+    pModel->Param[(pModel->First + pModel->Count) % MAX_WAITING] = Param;
+  }
+  pModel->Count++;
+}
+
+static void CheckReady(void)
+{
+  uint8_t i;
+
+  for (i = 0; i < NUM_SERVICES; i++)
+  {
+    Check(((Ready & BitNum2SetMask[i]) != 0) == (Model[i].Count != 0),
+        "Ready bit matches the waiting events");
+  }
+}
+
+static void Post(uint8_t Service, bool AtFront)
+{
+  ES_Event_t  ThisEvent;
+  bool        Posted;
+
+  ThisEvent.EventType = TEST_EVENT;
+  ThisEvent.EventParam = NextParam;
+  if (AtFront)
+  {
+    Posted = ES_EnQueueLIFO(TestQueues[Service].pMem, ThisEvent);
+  }
+  else
+  {
+    Posted = ES_EnQueueFIFO(TestQueues[Service].pMem, ThisEvent);
+  }
+  // one entry of the block holds the queue structure
+  Check(Posted == (Model[Service].InQueue < TestQueues[Service].Size - 1),
+      "post refused only when the queue is full");
+  if (Posted)
+  {
+    ES_Bus_Queued(Service, AtFront);
+    ES_AtomicSetBits(&Ready, BitNum2SetMask[Service]);
+    ModelAdd(Service, NextParam, AtFront);
+    Model[Service].InQueue++;
+    NextParam++;
+  }
+}
+
+static void Publish(uint32_t Targets, bool BySubscription)
+{
+  ES_Event_t  ThisEvent;
+  bool        Published;
+  bool        Full;
+  uint8_t     i;
+
+  ThisEvent.EventType = TEST_EVENT;
+  ThisEvent.EventParam = NextParam;
+  while ((ModelTail != ModelHead) &&
+      (ModelPending[ModelTail % ES_BUS_SIZE] == 0))
+  {
+    ModelTail++;
+  }
+  Full = (Targets != 0) && ((ModelHead - ModelTail) >= ES_BUS_SIZE);
+  if (BySubscription)
+  {
+    Published = ES_Bus_Publish(ThisEvent);
+  }
+  else
+  {
+    Published = ES_Bus_PublishTo(Targets, ThisEvent);
+  }
+  Check(Published == !Full, "publish refused only when the bus is full");
+  if (Full)
+  {
+    ModelDrops++;
+  }
+  else if (Targets != 0)
+  {
+    ModelPending[ModelHead % ES_BUS_SIZE] = Targets;
+    ModelHead++;
+    for (i = 0; i < NUM_SERVICES; i++)
+    {
+      if ((Targets & BitNum2SetMask[i]) != 0)
+      {
+        ModelAdd(i, NextParam, false);
+      }
+    }
+  }
+  NextParam++;
+}
+
+// what ES_Run does for one event
+static void Dispatch(uint8_t Service)
+{
+  ModelService_t  *pModel = &Model[Service];
+  ES_Event_t      ThisEvent;
+  uint8_t         NumLeft;
+  uint32_t        Count;
+  bool            FromBus;
+
+  FromBus = ES_Bus_Take(Service, &ThisEvent);
+  if (FromBus)
+  {
+    NumLeft = ES_Bus_HasEvents(Service) ||
+        !ES_IsQueueEmpty(TestQueues[Service].pMem);
+  }
+  else
+  {
+    NumLeft = ES_DeQueue(TestQueues[Service].pMem, &ThisEvent);
+  }
+  if (NumLeft == 0)
+  {
+    ES_AtomicClrBits(&Ready, BitNum2SetMask[Service]);
+    if (ES_Bus_HasEvents(Service) ||
+        !ES_IsQueueEmpty(TestQueues[Service].pMem))
+    {
+      ES_AtomicSetBits(&Ready, BitNum2SetMask[Service]);
+    }
+  }
+  Check(ThisEvent.EventParam == pModel->Param[pModel->First],
+      "events come out in the order they were posted");
+  if (FromBus)
+  {
+    // the oldest bus entry that was for this service
+    for (Count = ModelTail; Count != ModelHead; Count++)
+    {
+      if ((ModelPending[Count % ES_BUS_SIZE] & BitNum2SetMask[Service]) != 0)
+      {
+        ModelPending[Count % ES_BUS_SIZE] &= ~BitNum2SetMask[Service];
+        break;
+      }
+    }
+    Check(Count != ModelHead, "bus event taken that was not published");
+  }
+  else
+  {
+    pModel->InQueue--;
+  }
+  pModel->First = (uint16_t)((pModel->First + 1) % MAX_WAITING);
+  pModel->Count--;
+}
+
+static void Reset(void)
+{
+  uint8_t i;
+
+  ES_Bus_Init();
+  Ready = 0;
+  memset(Model, 0, sizeof(Model));
+  memset(ModelPending, 0, sizeof(ModelPending));
+  ModelHead = 0;
+  ModelTail = 0;
+  ModelDrops = 0;
+  ModelSubscribers = 0;
+  for (i = 0; i < NUM_SERVICES; i++)
+  {
+    ES_InitQueue(TestQueues[i].pMem, TestQueues[i].Size);
+  }
+}
+
+// a broadcast must not get ahead of a post that is already waiting
+static void PostAllBehindPost(void)
+{
+  uint16_t First = NextParam;
+  uint8_t  i;
+
+  Reset();
+  Post(NUM_SERVICES - 1, false);
+  Publish(ALL_SERVICES, false);
+  Post(NUM_SERVICES - 1, false);
+  Post(0, true);
+  for (i = 0; i < 3; i++)
+  {
+    Check(Model[NUM_SERVICES - 1].Param[i] == (uint16_t)(First + i),
+        "model order of post, broadcast, post");
+    Dispatch(NUM_SERVICES - 1);
+  }
+  Check(Model[0].Param[Model[0].First] == (uint16_t)(First + 3),
+      "LIFO post ahead of the broadcast");
+  Dispatch(0);
+  Dispatch(0);
+  CheckReady();
+}
+
+static void RandomOps(void)
+{
+  uint32_t  Op;
+  uint32_t  Waiting;
+  uint8_t   Service;
+  uint8_t   i;
+
+  Reset();
+  for (Op = 0; Op < NUM_TEST_OPS; Op++)
+  {
+    Service = (uint8_t)Random(NUM_SERVICES);
+    switch (Random(8))
+    {
+      case 0:
+      {
+        Post(Service, false);
+      }
+      break;
+
+      case 1:
+      {
+        Post(Service, true);
+      }
+      break;
+
+      case 2:
+      {
+        Publish((uint32_t)Random(ALL_SERVICES + 1), false);
+      }
+      break;
+
+      case 3:
+      {
+        if (Random(4) == 0)
+        {
+          if ((ModelSubscribers & BitNum2SetMask[Service]) != 0)
+          {
+            ES_Bus_Unsubscribe(Service, TEST_EVENT);
+            ModelSubscribers &= ~BitNum2SetMask[Service];
+          }
+          else
+          {
+            ES_Bus_Subscribe(Service, TEST_EVENT);
+            ModelSubscribers |= BitNum2SetMask[Service];
+          }
+        }
+        Check(ES_Bus_GetSubscribers(TEST_EVENT) == ModelSubscribers,
+            "subscribers");
+        Publish(ModelSubscribers, true);
+      }
+      break;
+
+      default:  // run a service that has something waiting
+      {
+        if (Ready != 0)
+        {
+          // mostly the highest priority one, as ES_Run would, but not
+          // always so that the lower ones fall behind on the bus
+          if (Random(2) == 0)
+          {
+            Service = ES_GetMSBitSet(Ready);
+          }
+          else
+          {
+            while ((Ready & BitNum2SetMask[Service]) == 0)
+            {
+              Service = (uint8_t)((Service + 1) % NUM_SERVICES);
+            }
+          }
+          Dispatch(Service);
+        }
+      }
+      break;
+    }
+    CheckReady();
+  }
+  Waiting = 0;
+  for (i = 0; i < NUM_SERVICES; i++)
+  {
+    Waiting += Model[i].Count;
+  }
+  while (Ready != 0)
+  {
+    Dispatch(ES_GetMSBitSet(Ready));
+    Waiting--;
+  }
+  Check(Waiting == 0, "every event handed over");
+  Check(ES_Bus_GetStats()->NumDrops == ModelDrops, "drop count");
+}
+
+int main(void)
+{
+  PostAllBehindPost();
+  RandomOps();
+  ES_Bus_PrintStats();
+  printf("%lu errors\n", (unsigned long)Errors);
+  return (Errors == 0) ? 0 : 1;
+}
+
+#endif /* TEST */
+
+#endif /* ES_BUS_SIZE */
+
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
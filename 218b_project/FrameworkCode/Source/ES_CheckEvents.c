@@ -22,14 +22,259 @@
 
 #include "ES_EventCheckWrapper.h"
 
+#ifdef EVENT_CHECK_SCHEDULE
+#include "ES_Port.h"
+#include <stdio.h>
+#include <string.h>
+
+typedef struct
+{
+  CheckFunc   *Func;
+  uint32_t    Period;     // in _HW_GetCycleCount counts
+  uint8_t     Priority;
+}ES_CheckerDesc_t;
+
+#define CHECKER_ENTRY(Func, PeriodUS, Priority) \
+  { Func, (PeriodUS) * ES_CYCLES_PER_US, Priority },
+
+static ES_CheckerDesc_t const ES_CheckerList[] = {
+  EVENT_CHECK_SCHEDULE(CHECKER_ENTRY)
+};
+
+#define NUM_CHECKERS ARRAY_SIZE(ES_CheckerList)
+
+// the checkers in a round are kept as bits in a 32 bit word,
+// this will fail to compile (negative array size) if there are too many
+typedef char NumCheckersCheck_t[(NUM_CHECKERS <= 32) ? 1 : -1];
+
+#define CHECKER_NAME_ENTRY(Func, PeriodUS, Priority) #Func,
+
+static char const *const CheckerNames[] = {
+  EVENT_CHECK_SCHEDULE(CHECKER_NAME_ENTRY)
+};
+
+#define NO_CHECKER 0xFF
+
+static uint32_t           NextDue[NUM_CHECKERS];
+static ES_CheckerStats_t  CheckerStats[NUM_CHECKERS];
+// the checkers left to call in this round, one bit each
+static uint32_t           Round;
+// time covered by the statistics, in clock counts
+static uint64_t           Elapsed;
+static uint32_t           LastCall;
+// where the search for the next checker to call starts, just past the last
+// one called, so that checkers of the same priority take turns
+static uint8_t            Cursor;
+static bool               Started;
+#else
 // Fill in this array with the names of your event checking functions
 
 static CheckFunc *const ES_EventList[] = {
   EVENT_CHECK_LIST
 };
+#endif
 
 // Implementation for public functions
+#ifdef EVENT_CHECK_SCHEDULE
+/****************************************************************************
+ Function
+   ES_CheckUserEvents
+ Parameters
+   None
+ Returns
+   bool: true if any of the user event checkers returned true, false otherwise
+ Description
+   calls the event checkers from EVENT_CHECK_SCHEDULE whose periods are up.
+   The checkers that are due are gathered into a round, and each of them
+   is called once, highest priority first, before a new round is started.
+   Checkers of the same priority go in turn, starting after the last one
+   called. Stops at the first one that returns true so that its event can
+   be processed, the rest of the round carries on from the next call
+ Notes
+   so a checker that keeps finding events can not starve the others, the
+   most it can do is go first in every round. A checker that falls more
+   than a period behind starts over from now rather than being called
+   back to back to catch up
+ Author
+   10/17/26
+****************************************************************************/
+bool ES_CheckUserEvents(void)
+{
+  uint32_t  Now = _HW_GetCycleCount();
+  uint32_t  Start;
+  uint32_t  Time;
+  uint8_t   i;
+  uint8_t   Index;
+  uint8_t   Best;
+  bool      Found;
+
+  if (!Started)
+  {
+    for (i = 0; i < NUM_CHECKERS; i++)
+    {
+      NextDue[i] = Now;
+    }
+    LastCall = Now;
+    Started = true;
+  }
+  Elapsed += Now - LastCall;
+  LastCall = Now;
+  if (Round == 0)
+  {
+    // start a new round with the checkers that are due now
+    for (i = 0; i < NUM_CHECKERS; i++)
+    {
+      if ((int32_t)(Now - NextDue[i]) >= 0)
+      {
+        Round |= (uint32_t)1 << i;
+      }
+      else
+      {
+        CheckerStats[i].Skips++;
+      }
+    }
+  }
+
+  while (Round != 0)
+  {
+    Best = NO_CHECKER;
+    for (i = 0; i < NUM_CHECKERS; i++)
+    {
+      Index = Cursor + i;
+      if (Index >= NUM_CHECKERS)
+      {
+        Index -= NUM_CHECKERS;
+      }
+      if (((Round & ((uint32_t)1 << Index)) != 0) &&
+          ((Best == NO_CHECKER) ||
+          (ES_CheckerList[Index].Priority > ES_CheckerList[Best].Priority)))
+      {
+        Best = Index;
+      }
+    }
+    Round &= ~((uint32_t)1 << Best);
+    Cursor = Best + 1;
+    if (Cursor >= NUM_CHECKERS)
+    {
+      Cursor = 0;
+    }
+    NextDue[Best] += ES_CheckerList[Best].Period;
+    if ((int32_t)(Now - NextDue[Best]) >= 0)
+    {
+      NextDue[Best] = Now + ES_CheckerList[Best].Period;
+    }
+
+    Start = _HW_GetCycleCount();
+    Found = ES_CheckerList[Best].Func();
+    Time = _HW_GetCycleCount() - Start;
+
+    CheckerStats[Best].Calls++;
+    CheckerStats[Best].TotalTime += Time;
+    if (Time > CheckerStats[Best].MaxTime)
+    {
+      CheckerStats[Best].MaxTime = Time;
+    }
+    if (Found == true)
+    {
+      CheckerStats[Best].Hits++;
+      return true;  // found a new event, so process it first
+    }
+  }
+  return false;
+}
+
+/****************************************************************************
+ Function
+   ES_GetCheckerStats
+ Parameters
+   uint8_t : which checker, its position in EVENT_CHECK_SCHEDULE
+ Returns
+   pointer to the statistics for that checker, NULL if there is no such
+   checker
+ Description
+   lets the application look at the raw numbers, times are in clock counts
+ Notes
+
+ Author
+   10/17/26
+****************************************************************************/
+ES_CheckerStats_t const *ES_GetCheckerStats(uint8_t WhichChecker)
+{
+  if (WhichChecker >= NUM_CHECKERS)
+  {
+    return NULL;
+  }
+  return &CheckerStats[WhichChecker];
+}
 
+/****************************************************************************
+ Function
+   ES_ResetCheckerStats
+ Parameters
+   None
+ Returns
+   None
+ Description
+   clears the statistics for all of the event checkers
+ Notes
+
+ Author
+   10/17/26
+****************************************************************************/
+void ES_ResetCheckerStats(void)
+{
+  memset(CheckerStats, 0, sizeof(CheckerStats));
+  Elapsed = 0;
+}
+
+/****************************************************************************
+ Function
+   ES_PrintCheckerStats
+ Parameters
+   None
+ Returns
+   None
+ Description
+   prints the period, priority, calls, events found, passes skipped and
+   run times of every event checker, with the share of the time since the
+   statistics were reset that it has taken. Setting a checker's period to
+   0 and comparing its load shows how much time its period saves
+ Notes
+   goes out through printf, so it takes a while
+ Author
+   10/17/26
+****************************************************************************/
+void ES_PrintCheckerStats(void)
+{
+  uint8_t                 i;
+  ES_CheckerStats_t const *pStats;
+  uint32_t                Avg;
+  uint32_t                Load;
+
+  printf("\r\nEvent checkers (uS) over %lu mS\r\n",
+      (unsigned long)(Elapsed / (ES_CYCLES_PER_US * 1000u)));
+  printf("%-20s %7s %4s %10s %8s %10s %7s %7s %6s\r\n", "Checker", "Period",
+      "Prio", "Calls", "Hits", "Skips", "AvgTime", "MaxTime", "Load%");
+  for (i = 0; i < NUM_CHECKERS; i++)
+  {
+    pStats = &CheckerStats[i];
+    Avg = (pStats->Calls != 0) ?
+        (uint32_t)(pStats->TotalTime / pStats->Calls) : 0;
+    // in tenths of a percent
+    Load = (Elapsed != 0) ?
+        (uint32_t)(pStats->TotalTime * 1000u / Elapsed) : 0;
+    printf("%-20s %7lu %4u %10lu %8lu %10lu %7lu %7lu %4lu.%lu\r\n",
+        CheckerNames[i],
+        (unsigned long)(ES_CheckerList[i].Period / ES_CYCLES_PER_US),
+        ES_CheckerList[i].Priority, (unsigned long)pStats->Calls,
+        (unsigned long)pStats->Hits, (unsigned long)pStats->Skips,
+        (unsigned long)(Avg / ES_CYCLES_PER_US),
+        (unsigned long)(pStats->MaxTime / ES_CYCLES_PER_US),
+        (unsigned long)(Load / 10), (unsigned long)(Load % 10));
+  }
+}
+
+#else
 /****************************************************************************
  Function
    ES_CheckUserEvents
@@ -65,5 +310,7 @@ bool ES_CheckUserEvents(void)
   }
 }
 
+#endif
+
 /*------------------------------- Footnotes -------------------------------*/
 /*------------------------------ End of file ------------------------------*/
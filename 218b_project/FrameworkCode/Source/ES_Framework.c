@@ -34,6 +34,10 @@
 #include "ES_Timers.h"
 #include "ES_General.h"
 #include "ES_CheckEvents.h"
+#include "ES_Profile.h"
+#include "ES_Sched.h"
+#include "ES_Bus.h"
+#include "ES_Trace.h"
 // Include the header files for the Service modules.
 // This gets you the prototypes for the public service functions.
 
@@ -46,11 +50,19 @@
 #endif
 
 #include <stdio.h>
+#include <string.h>
 
 #ifndef ES_CONFIGURE_H
 #error "ES_Configure.h was not included"
 #endif
 
+#if defined(TEST) && defined(ES_TEST_LUT_DISPATCH)
+// for the host dispatch bench at the bottom: pick with the table, as ES_Run
+// did before CLZ, so that the two can be timed against each other
+#undef ES_GetMSBitSet
+#define ES_GetMSBitSet(Val2Check) ES_GetMSBitSetLUT(Val2Check)
+#endif
+
 /*----------------------------- Module Defines ----------------------------*/
 typedef bool InitFunc_t (uint8_t Priority);
 typedef ES_Event_t RunFunc_t (ES_Event_t ThisEvent);
@@ -70,174 +82,143 @@ typedef struct
 {
   ES_Event_t *pMem;     // pointer to the memory
   uint8_t Size;         // how big is it
+  ES_QueueKind_t Kind;  // standard or lock-free single producer/consumer
+#ifdef ES_QUEUE_STATS
+  ES_QueueStats_t *pStats;  // telemetry for this queue
+#endif
 }ES_QueueDesc_t;
 
+#if defined(ES_QUEUE_REPORT_TICKS) && (ES_QUEUE_REPORT_TICKS > 0xFFFF)
+#error "ES_QUEUE_REPORT_TICKS must fit in the 16 bit ES_Timer_GetTime"
+#endif
+
 /*---------------------------- Module Functions ---------------------------*/
 //static bool CheckSystemEvents( void );
+static bool EnQueueFIFO(uint8_t WhichQueue, ES_Event_t Event2Add);
+static bool HasEventsWaiting(uint8_t WhichService);
+#ifdef COALESCE_LIST
+static bool EnQueueCoalesced(uint8_t WhichQueue, ES_Event_t Event2Add);
+#endif
+#ifdef ES_QUEUE_STATS
+static void RecordPost(uint8_t WhichQueue, ES_Event_t ThisEvent, bool Posted);
+#endif
 
 /*---------------------------- Module Variables ---------------------------*/
 /****************************************************************************/
-// You fill in this array with the names of the service init & run functions
-// for each service that you use.
-// The order is: InitFunction, RunFunction
+// The service descriptors are built from SERVICE_LIST in ES_Configure.h.
+// The order is: InitFunction, RunFunction, QueueSize, QueueKind
 // The first entry, at index 0, is the lowest priority, with increasing
 // priority with higher indices
 
+#define SERV_DESC_ENTRY(Init, Run, QueueSize, Kind) { Init, Run },
+
 static ES_ServDesc_t const ServDescList[] =
-{ { SERV_0_INIT, SERV_0_RUN } /* lowest priority  always present */
-#if NUM_SERVICES > 1
-  , { SERV_1_INIT, SERV_1_RUN }
-#endif
-#if NUM_SERVICES > 2
-  , { SERV_2_INIT, SERV_2_RUN }
-#endif
-#if NUM_SERVICES > 3
-  , { SERV_3_INIT, SERV_3_RUN }
-#endif
-#if NUM_SERVICES > 4
-  , { SERV_4_INIT, SERV_4_RUN }
-#endif
-#if NUM_SERVICES > 5
-  , { SERV_5_INIT, SERV_5_RUN }
-#endif
-#if NUM_SERVICES > 6
-  , { SERV_6_INIT, SERV_6_RUN }
-#endif
-#if NUM_SERVICES > 7
-  , { SERV_7_INIT, SERV_7_RUN }
-#endif
-#if NUM_SERVICES > 8
-  , { SERV_8_INIT, SERV_8_RUN }
-#endif
-#if NUM_SERVICES > 9
-  , { SERV_9_INIT, SERV_9_RUN }
-#endif
-#if NUM_SERVICES > 10
-  , { SERV_10_INIT, SERV_10_RUN }
-#endif
-#if NUM_SERVICES > 11
-  , { SERV_11_INIT, SERV_11_RUN }
-#endif
-#if NUM_SERVICES > 12
-  , { SERV_12_INIT, SERV_12_RUN }
-#endif
-#if NUM_SERVICES > 13
-  , { SERV_13_INIT, SERV_13_RUN }
-#endif
-#if NUM_SERVICES > 14
-  , { SERV_14_INIT, SERV_14_RUN }
-#endif
-#if NUM_SERVICES > 15
-  , { SERV_15_INIT, SERV_15_RUN }
-#endif
+{
+  SERVICE_LIST(SERV_DESC_ENTRY)
 };
 
 /****************************************************************************/
-// The queues for the services
+// The queues for the services, one per entry in SERVICE_LIST, named after
+// the run function that they feed. The lock-free queues must be a power of
+// two in size, this will fail to compile (negative array size) if not
 
-static ES_Event_t Queue0[SERV_0_QUEUE_SIZE + 1];
-#if NUM_SERVICES > 1
-static ES_Event_t Queue1[SERV_1_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 2
-static ES_Event_t Queue2[SERV_2_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 3
-static ES_Event_t Queue3[SERV_3_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 4
-static ES_Event_t Queue4[SERV_4_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 5
-static ES_Event_t Queue5[SERV_5_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 6
-static ES_Event_t Queue6[SERV_6_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 7
-static ES_Event_t Queue7[SERV_7_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 8
-static ES_Event_t Queue8[SERV_8_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 9
-static ES_Event_t Queue9[SERV_9_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 10
-static ES_Event_t Queue10[SERV_10_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 11
-static ES_Event_t Queue11[SERV_11_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 12
-static ES_Event_t Queue12[SERV_12_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 13
-static ES_Event_t Queue13[SERV_13_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 14
-static ES_Event_t Queue14[SERV_14_QUEUE_SIZE + 1];
-#endif
-#if NUM_SERVICES > 15
-static ES_Event_t Queue15[SERV_15_QUEUE_SIZE + 1];
+#define QUEUE_ENTRY(Init, Run, QueueSize, Kind)                     \
+  static ES_Event_t Queue_##Run[(QueueSize) + 1];                   \
+  typedef char QueueSizeCheck_##Run[(((Kind) != ES_QUEUE_SPSC) ||   \
+    (((QueueSize) & ((QueueSize) - 1)) == 0)) ? 1 : -1];
+
+SERVICE_LIST(QUEUE_ENTRY)
+
+#ifdef ES_QUEUE_STATS
+// and the telemetry for each queue
+#define QUEUE_STATS_ENTRY(Init, Run, QueueSize, Kind) \
+  static ES_QueueStats_t QueueStats_##Run;
+
+SERVICE_LIST(QUEUE_STATS_ENTRY)
+
+// names used in the printed report
+#define SERV_NAME_ENTRY(Init, Run, QueueSize, Kind) #Run,
+
+static char const *const ServiceNames[] = {
+  SERVICE_LIST(SERV_NAME_ENTRY)
+};
 #endif
 
 /****************************************************************************/
 // array of queue descriptors for posting by priority level
 
-static ES_QueueDesc_t const EventQueues[NUM_SERVICES] = {
-  { Queue0, ARRAY_SIZE(Queue0) }
-#if NUM_SERVICES > 1
-  , { Queue1, ARRAY_SIZE(Queue1) }
-#endif
-#if NUM_SERVICES > 2
-  , { Queue2, ARRAY_SIZE(Queue2) }
-#endif
-#if NUM_SERVICES > 3
-  , { Queue3, ARRAY_SIZE(Queue3) }
-#endif
-#if NUM_SERVICES > 4
-  , { Queue4, ARRAY_SIZE(Queue4) }
-#endif
-#if NUM_SERVICES > 5
-  , { Queue5, ARRAY_SIZE(Queue5) }
-#endif
-#if NUM_SERVICES > 6
-  , { Queue6, ARRAY_SIZE(Queue6) }
+#ifdef ES_QUEUE_STATS
+#define QUEUE_DESC_ENTRY(Init, Run, QueueSize, Kind) \
+  { Queue_##Run, ARRAY_SIZE(Queue_##Run), Kind, &QueueStats_##Run },
+#else
+#define QUEUE_DESC_ENTRY(Init, Run, QueueSize, Kind) \
+  { Queue_##Run, ARRAY_SIZE(Queue_##Run), Kind },
 #endif
-#if NUM_SERVICES > 7
-  , { Queue7, ARRAY_SIZE(Queue7) }
-#endif
-#if NUM_SERVICES > 8
-  , { Queue8, ARRAY_SIZE(Queue8) }
-#endif
-#if NUM_SERVICES > 9
-  , { Queue9, ARRAY_SIZE(Queue9) }
-#endif
-#if NUM_SERVICES > 10
-  , { Queue10, ARRAY_SIZE(Queue10) }
-#endif
-#if NUM_SERVICES > 11
-  , { Queue11, ARRAY_SIZE(Queue11) }
-#endif
-#if NUM_SERVICES > 12
-  , { Queue12, ARRAY_SIZE(Queue12) }
-#endif
-#if NUM_SERVICES > 13
-  , { Queue13, ARRAY_SIZE(Queue13) }
+
+static ES_QueueDesc_t const EventQueues[NUM_SERVICES] = {
+  SERVICE_LIST(QUEUE_DESC_ENTRY)
+};
+
+// make sure that NUM_SERVICES agrees with SERVICE_LIST, this will fail to
+// compile (negative array size) if it does not
+typedef char NumServicesCheck_t[
+  (ARRAY_SIZE(ServDescList) == NUM_SERVICES) ? 1 : -1];
+
+#ifdef COALESCE_LIST
+/****************************************************************************/
+// The coalescing rules from COALESCE_LIST, indexed by service & event type.
+// Services are named by their run functions, so first number them
+
+#define SERV_INDEX_ENTRY(Init, Run, QueueSize, Kind) ServIndex_##Run,
+
+enum
+{
+  SERVICE_LIST(SERV_INDEX_ENTRY)
+};
+
+// the rules can only be applied to standard queues, this will fail to
+// compile (negative array size) if one names a service with an SPSC queue
+#define SERV_KIND_ENTRY(Init, Run, QueueSize, Kind) \
+  enum { ServKind_##Run = Kind };
+
+SERVICE_LIST(SERV_KIND_ENTRY)
+
+#define COALESCE_CHECK(Run, Type, Rule) \
+  typedef char CoalesceCheck_##Run##_##Type[                        \
+    ((int)ServKind_##Run == (int)ES_QUEUE_STANDARD) ? 1 : -1];
+
+COALESCE_LIST(COALESCE_CHECK)
+
+#define COALESCE_ENTRY(Run, Type, Rule) [ServIndex_##Run][Type] = Rule,
+
+static uint8_t const CoalesceRules[NUM_SERVICES][NUM_EVENT_TYPES] = {
+  COALESCE_LIST(COALESCE_ENTRY)
+};
+
+// the queue slot holding the waiting event of each coalesced type, or
+// ES_QUEUE_NO_SLOT if there is none. Only changed with interrupts off
+static uint8_t PendingSlot[NUM_SERVICES][NUM_EVENT_TYPES];
 #endif
-#if NUM_SERVICES > 14
-  , { Queue14, ARRAY_SIZE(Queue14) }
+
+#if NUM_SERVICES > MAX_NUM_SERVICES
+#error "NUM_SERVICES is larger than MAX_NUM_SERVICES"
 #endif
-#if NUM_SERVICES > 15
-  , { Queue15, ARRAY_SIZE(Queue15) }
+#if MAX_NUM_SERVICES > 32
+#error "Ready is 32 bits wide, so no more than 32 services are possible"
 #endif
-};
 
 /****************************************************************************/
-// Variable used to keep track of which queues have events in them
+// Variable used to keep track of which queues have events in them. Posts
+// from interrupts change it, so it is only modified with ES_AtomicSetBits
+// and ES_AtomicClrBits
+
+volatile uint32_t Ready;
 
-uint16_t Ready;
+#ifdef ES_QUEUE_STATS
+// the service whose run function is executing, so that a post that
+// overflows a queue can be traced to its poster
+static uint8_t RunningService = ES_NO_SERVICE;
+#endif
 
 /*------------------------------ Module Code ------------------------------*/
 /****************************************************************************
@@ -259,6 +240,24 @@ ES_Return_t ES_Initialize(TimerRate_t NewRate)
 {
   uint8_t i;
   ES_Timer_Init(NewRate);  // start up the timer subsystem
+#ifdef ES_PROFILE
+  ES_Profile_Init();       // before the inits, they may post
+#endif
+#ifdef ES_DEADLINES
+  ES_Sched_Init();
+#endif
+#ifdef ES_TRACE_SIZE
+  ES_Trace_Init();
+#endif
+#ifdef ES_QUEUE_STATS
+  ES_ResetQueueStats();
+#endif
+#ifdef ES_BUS_SIZE
+  ES_Bus_Init();           // so that the inits can subscribe
+#endif
+#ifdef COALESCE_LIST
+  memset(PendingSlot, ES_QUEUE_NO_SLOT, sizeof(PendingSlot));
+#endif
   // loop through the list testing for NULL pointers and
   for (i = 0; i < ARRAY_SIZE(ServDescList); i++)
   {
@@ -268,7 +267,18 @@ ES_Return_t ES_Initialize(TimerRate_t NewRate)
       return FailedPointer; // protect against NULL pointers
     }
     // and initializing the event queues (must happen before running inits)
-    ES_InitQueue(EventQueues[i].pMem, EventQueues[i].Size);
+    if (EventQueues[i].Kind == ES_QUEUE_SPSC)
+    {
+      ES_InitSPSCQueue(EventQueues[i].pMem, EventQueues[i].Size);
+    }
+    else
+    {
+      ES_InitQueue(EventQueues[i].pMem, EventQueues[i].Size);
+    }
+#ifdef ES_QUEUE_STATS
+    // one entry of the block holds the queue structure
+    EventQueues[i].pStats->Size = EventQueues[i].Size - 1;
+#endif
     // executing the init functions
     if (ServDescList[i].InitFunc(i) != true)
     {
@@ -303,7 +313,14 @@ ES_Return_t ES_Run(void)
 {
   // make these static to improve speed
   uint8_t           HighestPrior;
+  uint8_t           NumLeft;
   static ES_Event_t ThisEvent;
+#ifdef ES_QUEUE_REPORT_TICKS
+  static uint16_t   LastReport;
+#endif
+#ifdef COALESCE_LIST
+  uint32_t          SavedPRIMASK;
+#endif
 
   while (1) // stay here unless we detect an error condition
   {         // loop through the list executing the run functions for services
@@ -311,19 +328,86 @@ ES_Return_t ES_Run(void)
     // Ready
     while ((_HW_Process_Pending_Ints()) && (Ready != 0))
     {
+#if ES_SCHED_POLICY == ES_SCHED_EDF
+      // the service whose oldest event is due soonest
+      HighestPrior = ES_Sched_PickEDF(Ready);
+#else
+      // CLZ based on ports that have it, look-up table otherwise
       HighestPrior = ES_GetMSBitSet(Ready);
-      if (ES_DeQueue(EventQueues[HighestPrior].pMem, &ThisEvent) == 0)
+#endif
+#ifdef ES_BUS_SIZE
+      // the bus and the queue events come out in the order they were
+      // posted, the bus says which is next
+      if (ES_Bus_Take(HighestPrior, &ThisEvent) == true)
+      {
+        NumLeft = HasEventsWaiting(HighestPrior) ? 1 : 0;
+      }
+      else
+#endif
+      if (EventQueues[HighestPrior].Kind == ES_QUEUE_SPSC)
+      {
+        NumLeft = ES_DeQueueSPSC(EventQueues[HighestPrior].pMem, &ThisEvent);
+      }
+      else
+      {
+#ifdef COALESCE_LIST
+        // forget the pending slot in the same critical region as the
+        // DeQueue, or an ISR could merge a post into an event that has
+        // already left the queue
+        SavedPRIMASK = CPUgetPRIMASK_cpsid();
+#endif
+        NumLeft = ES_DeQueue(EventQueues[HighestPrior].pMem, &ThisEvent);
+#ifdef COALESCE_LIST
+        if ((uint16_t)ThisEvent.EventType < NUM_EVENT_TYPES)
+        {
+          PendingSlot[HighestPrior][ThisEvent.EventType] = ES_QUEUE_NO_SLOT;
+        }
+        CPUsetPRIMASK(SavedPRIMASK);
+#endif
+      }
+      if (NumLeft == 0)
       {
-        Ready &= BitNum2ClrMask[HighestPrior]; // mark queue as now empty
+        // mark queue as now empty
+        ES_AtomicClrBits(&Ready, BitNum2SetMask[HighestPrior]);
+        // an interrupt may have posted between the DeQueue and the clear,
+        // if so, its Ready bit was just lost, so put it back
+        if (HasEventsWaiting(HighestPrior))
+        {
+          ES_AtomicSetBits(&Ready, BitNum2SetMask[HighestPrior]);
+        }
       }
 #ifdef _INCLUDE_BASIC_FRAMEWORK_DEBUG_
       _HW_DebugSetLine1();
+#endif
+#ifdef ES_PROFILE
+      ES_Profile_BeginRun(HighestPrior, ThisEvent.EventType);
+#endif
+#ifdef ES_DEADLINES
+      ES_Sched_BeginRun(HighestPrior);
+#endif
+#ifdef ES_QUEUE_STATS
+      RunningService = HighestPrior;
+#endif
+#ifdef ES_TRACE_SIZE
+      ES_Trace_BeginRun(HighestPrior, ThisEvent);
 #endif
       if (ServDescList[HighestPrior].RunFunc(ThisEvent).EventType !=
           ES_NO_EVENT)
       {
         return FailedRun;
       }
+#ifdef ES_TRACE_SIZE
+      ES_Trace_EndRun();
+#endif
+#ifdef ES_QUEUE_STATS
+      RunningService = ES_NO_SERVICE;
+#endif
+#ifdef ES_DEADLINES
+      ES_Sched_EndRun();
+#endif
+#ifdef ES_PROFILE
+      ES_Profile_EndRun();
+#endif
 #ifdef _INCLUDE_BASIC_FRAMEWORK_DEBUG_
       _HW_DebugClearLine1();
 #endif
@@ -332,7 +416,17 @@ ES_Return_t ES_Run(void)
 #ifdef _INCLUDE_BASIC_FRAMEWORK_DEBUG_
     _HW_DebugSetLine2();
 #endif
-    // all the queues are empty, so look for new user detected events
+#ifdef ES_QUEUE_REPORT_TICKS
+    // time for the periodic queue report?
+    if ((uint16_t)(ES_Timer_GetTime() - LastReport) >= ES_QUEUE_REPORT_TICKS)
+    {
+      LastReport += ES_QUEUE_REPORT_TICKS;
+      ES_PrintQueueStats();
+    }
+#endif
+    // all the queues are empty, give the port a chance to deal with idle
+    _HW_Idle();
+    // then look for new user detected events
     ES_CheckUserEvents();
 #ifdef _INCLUDE_BASIC_FRAMEWORK_DEBUG_
     _HW_DebugClearLine2();
@@ -350,23 +444,27 @@ ES_Return_t ES_Run(void)
  Description
    posts to all of the services' queues
  Notes
-
+   with the bus (ES_BUS_SIZE) the event is published once to all of the
+   services, so either they all get it or none do
  Author
    J. Edward Carryer, 01/15/12,
 ****************************************************************************/
 bool ES_PostAll(ES_Event_t ThisEvent)
 {
+#ifdef ES_BUS_SIZE
+  return ES_Bus_PublishTo(ES_BUS_EVERYONE, ThisEvent);
+#else
   uint8_t i;
   // loop through the list executing the post functions
   for (i = 0; i < ARRAY_SIZE(EventQueues); i++)
   {
-    if (ES_EnQueueFIFO(EventQueues[i].pMem, ThisEvent) != true)
+    if (EnQueueFIFO(i, ThisEvent) != true)
     {
       break; // this is a failed post
     }
     else
     {
-      Ready |= BitNum2SetMask[i]; // show queue as non-empty
+      ES_AtomicSetBits(&Ready, BitNum2SetMask[i]); // show queue as non-empty
     }
   }
   if (i == ARRAY_SIZE(EventQueues))    // if no failures
@@ -377,6 +475,7 @@ bool ES_PostAll(ES_Event_t ThisEvent)
   {
     return false;
   }
+#endif
 }
 
 /****************************************************************************
@@ -397,10 +496,10 @@ bool ES_PostAll(ES_Event_t ThisEvent)
 bool ES_PostToService(uint8_t WhichService, ES_Event_t TheEvent)
 {
   if ((WhichService < ARRAY_SIZE(EventQueues)) &&
-      (ES_EnQueueFIFO(EventQueues[WhichService].pMem, TheEvent) ==
-      true))
+      (EnQueueFIFO(WhichService, TheEvent) == true))
   {
-    Ready |= BitNum2SetMask[WhichService]; // show queue as non-empty
+    // show queue as non-empty
+    ES_AtomicSetBits(&Ready, BitNum2SetMask[WhichService]);
     return true;
   }
   else
@@ -421,27 +520,507 @@ bool ES_PostToService(uint8_t WhichService, ES_Event_t TheEvent)
    Posts, using LIFO strategy, to one of the services' queues
  Notes
    used by the Defer/Recall event capability
+   The lock-free queues can only be added to at the tail, so this always
+   fails for a service whose queue is ES_QUEUE_SPSC
  Author
    J. Edward Carryer, 11/02/13
 ****************************************************************************/
 bool ES_PostToServiceLIFO(uint8_t WhichService, ES_Event_t TheEvent)
 {
+  uint32_t  SavedPRIMASK;
+  bool      Posted = false;
+
+#ifdef ES_TRACE_SIZE
+  if (ES_Trace_IsReplaying())
+  {
+    return ES_Trace_Replayed(ES_TRACE_LIFO, WhichService, TheEvent);
+  }
+#endif
   if ((WhichService < ARRAY_SIZE(EventQueues)) &&
-      (ES_EnQueueLIFO(EventQueues[WhichService].pMem, TheEvent) ==
-      true))
+      (EventQueues[WhichService].Kind != ES_QUEUE_SPSC))
+  {
+    // the enqueue, the bus order, the time stamp and the deadline in one
+    // critical region, as in EnQueueFIFO
+    SavedPRIMASK = CPUgetPRIMASK_cpsid();
+    Posted = ES_EnQueueLIFO(EventQueues[WhichService].pMem, TheEvent);
+#ifdef ES_BUS_SIZE
+    if (Posted == true)
+    {
+      ES_Bus_Queued(WhichService, true);
+    }
+#endif
+#ifdef ES_PROFILE
+    if (Posted == true)
+    {
+      ES_Profile_Posted(WhichService, true);
+    }
+#endif
+#ifdef ES_DEADLINES
+    if (Posted == true)
+    {
+      ES_Sched_Posted(WhichService, true);
+    }
+#endif
+    CPUsetPRIMASK(SavedPRIMASK);
+  }
+  if (Posted == true)
   {
-    Ready |= BitNum2SetMask[WhichService]; // show queue as non-empty
+#ifdef ES_QUEUE_STATS
+    RecordPost(WhichService, TheEvent, true);
+#endif
+#ifdef ES_TRACE_SIZE
+    ES_Trace_Post(ES_TRACE_LIFO, WhichService, TheEvent);
+#endif
+    // show queue as non-empty
+    ES_AtomicSetBits(&Ready, BitNum2SetMask[WhichService]);
     return true;
   }
   else
   {
+#ifdef ES_QUEUE_STATS
+    // an SPSC queue is not overflowing, LIFO is just not allowed there
+    if ((WhichService < ARRAY_SIZE(EventQueues)) &&
+        (EventQueues[WhichService].Kind != ES_QUEUE_SPSC))
+    {
+      RecordPost(WhichService, TheEvent, false);
+    }
+#endif
+#ifdef ES_TRACE_SIZE
+    ES_Trace_Post(ES_TRACE_LIFO | ES_TRACE_REFUSED, WhichService, TheEvent);
+#endif
     return false;
   }
 }
 
+/****************************************************************************
+ Function
+   ES_IsIdle
+ Parameters
+   None
+ Returns
+   boolean : true if none of the services have an event waiting
+ Description
+   lets the port check, with interrupts disabled, that nothing was posted
+   between ES_Run finding the queues empty and the port going to sleep
+ Notes
+
+ Author
+   10/17/26
+****************************************************************************/
+bool ES_IsIdle(void)
+{
+  return Ready == 0;
+}
+
+#ifdef ES_QUEUE_STATS
+/****************************************************************************
+ Function
+   ES_GetQueueStats
+ Parameters
+   uint8_t : Which service's queue (index into ServDescList)
+ Returns
+   pointer to the telemetry for that queue, NULL if there is no such service
+ Description
+   lets the application look at the peak depth and the posts and dropped
+   posts for each event type, to see how big the queue really needs to be
+ Notes
+   the counts may change while they are being read if posts are going on
+ Author
+   10/17/26
+****************************************************************************/
+ES_QueueStats_t const *ES_GetQueueStats(uint8_t WhichService)
+{
+  if (WhichService >= ARRAY_SIZE(EventQueues))
+  {
+    return NULL;
+  }
+  return EventQueues[WhichService].pStats;
+}
+
+/****************************************************************************
+ Function
+   ES_ResetQueueStats
+ Parameters
+   None
+ Returns
+   None
+ Description
+   clears the peak depths and the post & drop counts for all of the queues
+ Notes
+   the peak depth starts over at the number of events in the queue now
+ Author
+   10/17/26
+****************************************************************************/
+void ES_ResetQueueStats(void)
+{
+  uint8_t         i;
+  uint8_t         Size;
+  uint32_t        SavedPRIMASK;
+  ES_QueueStats_t *pStats;
+
+  for (i = 0; i < ARRAY_SIZE(EventQueues); i++)
+  {
+    pStats = EventQueues[i].pStats;
+    SavedPRIMASK = CPUgetPRIMASK_cpsid();
+    Size = pStats->Size;
+    memset(pStats, 0, sizeof(*pStats));
+    pStats->Size = Size;
+    if (EventQueues[i].Kind == ES_QUEUE_SPSC)
+    {
+      pStats->PeakDepth = ES_GetSPSCQueueDepth(EventQueues[i].pMem);
+    }
+    else
+    {
+      pStats->PeakDepth = ES_GetQueueDepth(EventQueues[i].pMem);
+    }
+    CPUsetPRIMASK(SavedPRIMASK);
+  }
+}
+
+/****************************************************************************
+ Function
+   ES_PrintQueueStats
+ Parameters
+   None
+ Returns
+   None
+ Description
+   prints the size, peak depth and drops for every queue, followed by the
+   posts and drops for each event type that has been posted to it
+ Notes
+   goes out through printf, so it takes a while
+ Author
+   10/17/26
+****************************************************************************/
+void ES_PrintQueueStats(void)
+{
+  uint8_t               i;
+  uint16_t              Type;
+  ES_QueueStats_t const *pStats;
+
+  printf("\r\nQueue stats\r\n");
+  for (i = 0; i < ARRAY_SIZE(EventQueues); i++)
+  {
+    pStats = EventQueues[i].pStats;
+    printf("%-20s size %3u peak %3u drops %lu coalesced %lu\r\n",
+        ServiceNames[i], pStats->Size, pStats->PeakDepth,
+        (unsigned long)pStats->NumDrops, (unsigned long)pStats->NumCoalesced);
+    for (Type = 0; Type < NUM_EVENT_TYPES; Type++)
+    {
+      if ((pStats->Posts[Type] != 0) || (pStats->Drops[Type] != 0))
+      {
+        printf("    event %3u posts %10lu drops %10lu\r\n", Type,
+            (unsigned long)pStats->Posts[Type],
+            (unsigned long)pStats->Drops[Type]);
+      }
+    }
+    if (pStats->NumDrops != 0)
+    {
+      printf("    last drop: event %u param %u from ",
+          pStats->LastOverflow.Event.EventType,
+          pStats->LastOverflow.Event.EventParam);
+      if (pStats->LastOverflow.Interrupt != 0)
+      {
+        printf("exception %u\r\n", pStats->LastOverflow.Interrupt);
+      }
+      else if (pStats->LastOverflow.PostingService != ES_NO_SERVICE)
+      {
+        printf("%s\r\n",
+            ServiceNames[pStats->LastOverflow.PostingService]);
+      }
+      else
+      {
+        printf("event checker or timer\r\n");
+      }
+    }
+  }
+}
+#endif
+
 //*********************************
 // private functions
 //*********************************
+/****************************************************************************
+ Function
+   EnQueueFIFO
+ Parameters
+   uint8_t : Which queue to add to (index into EventQueues)
+   ES_Event : The Event to be added
+ Returns
+   boolean : False if the queue was full
+ Description
+   adds the event to the tail of the queue, using the queue functions that
+   match the kind of queue that the service was configured with
+ Notes
+   the enqueue, the bus order, the time stamp and the deadline are updated
+   in one critical region, as in EnQueueCoalesced, or an ISR that posts in
+   between would have its bus event handed over first, or its stamp and
+   deadline given to this event. The critical region saves its own PRIMASK
+   since the poster may already be in one.
+****************************************************************************/
+static bool EnQueueFIFO(uint8_t WhichQueue, ES_Event_t Event2Add)
+{
+  uint32_t  SavedPRIMASK;
+  bool      ReturnVal;
+
+#ifdef ES_TRACE_SIZE
+  // a replayed run function's posts are checked, not queued
+  if (ES_Trace_IsReplaying())
+  {
+    return ES_Trace_Replayed(ES_TRACE_POST, WhichQueue, Event2Add);
+  }
+#endif
+#ifdef COALESCE_LIST
+  if (((uint16_t)Event2Add.EventType < NUM_EVENT_TYPES) &&
+      (CoalesceRules[WhichQueue][Event2Add.EventType] != ES_COALESCE_NONE))
+  {
+    return EnQueueCoalesced(WhichQueue, Event2Add);
+  }
+#endif
+  SavedPRIMASK = CPUgetPRIMASK_cpsid();
+  if (EventQueues[WhichQueue].Kind == ES_QUEUE_SPSC)
+  {
+    ReturnVal = ES_EnQueueSPSC(EventQueues[WhichQueue].pMem, Event2Add);
+  }
+  else
+  {
+    ReturnVal = ES_EnQueueFIFO(EventQueues[WhichQueue].pMem, Event2Add);
+  }
+#ifdef ES_BUS_SIZE
+  if (ReturnVal == true)
+  {
+    ES_Bus_Queued(WhichQueue, false);
+  }
+#endif
+#ifdef ES_PROFILE
+  if (ReturnVal == true)
+  {
+    ES_Profile_Posted(WhichQueue, false);
+  }
+#endif
+#ifdef ES_DEADLINES
+  if (ReturnVal == true)
+  {
+    ES_Sched_Posted(WhichQueue, false);
+  }
+#endif
+  CPUsetPRIMASK(SavedPRIMASK);
+#ifdef ES_QUEUE_STATS
+  RecordPost(WhichQueue, Event2Add, ReturnVal);
+#endif
+#ifdef ES_TRACE_SIZE
+  ES_Trace_Post(ReturnVal ? ES_TRACE_POST : ES_TRACE_POST | ES_TRACE_REFUSED,
+      WhichQueue, Event2Add);
+#endif
+  return ReturnVal;
+}
+
+/****************************************************************************
+ Function
+   HasEventsWaiting
+ Parameters
+   uint8_t : Which service to look at (index into EventQueues)
+ Returns
+   boolean : true if there is an event in its queue, or on the bus for it
+ Description
+   used by ES_Run to check that a Ready bit it has just cleared was not
+   needed after all
+ Notes
+
+****************************************************************************/
+static bool HasEventsWaiting(uint8_t WhichService)
+{
+#ifdef ES_BUS_SIZE
+  if (ES_Bus_HasEvents(WhichService))
+  {
+    return true;
+  }
+#endif
+  if (EventQueues[WhichService].Kind == ES_QUEUE_SPSC)
+  {
+    return !ES_IsSPSCQueueEmpty(EventQueues[WhichService].pMem);
+  }
+  return !ES_IsQueueEmpty(EventQueues[WhichService].pMem);
+}
+
+#ifdef COALESCE_LIST
+/****************************************************************************
+ Function
+   EnQueueCoalesced
+ Parameters
+   uint8_t : Which queue to add to (index into EventQueues)
+   ES_Event : The Event to be added
+ Returns
+   boolean : False if the queue was full
+ Description
+   applies the coalescing rule for this service & event type: if an event
+   of the same type is still waiting, the post is merged into it in place,
+   otherwise the event is queued and its slot remembered
+ Notes
+   the look-up, the merge and the enqueue all happen with interrupts off,
+   in the same way as the DeQueue & slot clear in ES_Run. The critical
+   region saves its own PRIMASK since the poster may already be in one.
+****************************************************************************/
+static bool EnQueueCoalesced(uint8_t WhichQueue, ES_Event_t Event2Add)
+{
+  uint8_t     *pSlot = &PendingSlot[WhichQueue][Event2Add.EventType];
+  uint8_t     Rule = CoalesceRules[WhichQueue][Event2Add.EventType];
+  ES_Event_t  *pPending;
+  uint32_t    SavedPRIMASK;
+  bool        ReturnVal = true;
+#ifdef ES_TRACE_SIZE
+  ES_Event_t  AsPosted = Event2Add;   // before a count rule changes it
+  uint8_t     TraceKind = ES_TRACE_MERGED;
+#endif
+
+  SavedPRIMASK = CPUgetPRIMASK_cpsid();
+  if (*pSlot != ES_QUEUE_NO_SLOT)
+  {
+    pPending = ES_GetQueueSlot(EventQueues[WhichQueue].pMem, *pSlot);
+    switch (Rule)
+    {
+      case ES_COALESCE_KEEP_LATEST:
+      {
+        pPending->EventParam = Event2Add.EventParam;
+      }
+      break;
+      case ES_COALESCE_COUNT:
+      {
+        if (pPending->EventParam < 0xFFFF)
+        {
+          pPending->EventParam++;
+        }
+      }
+      break;
+      default:    // ES_COALESCE_KEEP_FIRST, nothing to change
+        break;
+    }
+#ifdef ES_QUEUE_STATS
+    EventQueues[WhichQueue].pStats->NumCoalesced++;
+#endif
+  }
+  else
+  {
+    if (Rule == ES_COALESCE_COUNT)
+    {
+      Event2Add.EventParam = 1;
+    }
+    *pSlot = ES_EnQueueFIFOSlot(EventQueues[WhichQueue].pMem, Event2Add);
+    ReturnVal = (*pSlot != ES_QUEUE_NO_SLOT);
+#ifdef ES_TRACE_SIZE
+    TraceKind = ReturnVal ? ES_TRACE_POST : ES_TRACE_POST | ES_TRACE_REFUSED;
+#endif
+#ifdef ES_BUS_SIZE
+    // and only a new entry takes a place among the bus events
+    if (ReturnVal == true)
+    {
+      ES_Bus_Queued(WhichQueue, false);
+    }
+#endif
+#ifdef ES_PROFILE
+    // only a new entry gets a time stamp, not a merged post
+    if (ReturnVal == true)
+    {
+      ES_Profile_Posted(WhichQueue, false);
+    }
+#endif
+#ifdef ES_DEADLINES
+    // nor a deadline, the waiting event keeps the earlier one
+    if (ReturnVal == true)
+    {
+      ES_Sched_Posted(WhichQueue, false);
+    }
+#endif
+  }
+  CPUsetPRIMASK(SavedPRIMASK);
+
+#ifdef ES_QUEUE_STATS
+  RecordPost(WhichQueue, Event2Add, ReturnVal);
+#endif
+#ifdef ES_TRACE_SIZE
+  ES_Trace_Post(TraceKind, WhichQueue, AsPosted);
+#endif
+  return ReturnVal;
+}
+#endif
+
+#ifdef ES_QUEUE_STATS
+#ifdef ES_QUEUE_OVERFLOW_HOOK
+void ES_QUEUE_OVERFLOW_HOOK(ES_QueueOverflow_t const *pOverflow);
+#endif
+
+/****************************************************************************
+ Function
+   RecordPost
+ Parameters
+   uint8_t : Which queue was posted to (index into EventQueues)
+   ES_Event : The Event that was posted
+   bool : true if it went into the queue, false if the queue was full
+ Returns
+   nothing
+ Description
+   updates the queue telemetry after a post, and on a drop records where
+   it came from and calls the overflow hook, if there is one
+ Notes
+   may be called from an ISR, so the counts are updated with interrupts
+   off. The critical region saves its own PRIMASK since the poster may
+   already be in one. The hook is called after interrupts are restored.
+****************************************************************************/
+static void RecordPost(uint8_t WhichQueue, ES_Event_t ThisEvent, bool Posted)
+{
+  ES_QueueStats_t *pStats = EventQueues[WhichQueue].pStats;
+  uint8_t         Depth;
+  uint32_t        SavedPRIMASK;
+#ifdef ES_QUEUE_OVERFLOW_HOOK
+  ES_QueueOverflow_t Overflow;
+#endif
+
+  SavedPRIMASK = CPUgetPRIMASK_cpsid();
+  if (Posted)
+  {
+    if ((uint16_t)ThisEvent.EventType < NUM_EVENT_TYPES)
+    {
+      pStats->Posts[ThisEvent.EventType]++;
+    }
+    if (EventQueues[WhichQueue].Kind == ES_QUEUE_SPSC)
+    {
+      Depth = ES_GetSPSCQueueDepth(EventQueues[WhichQueue].pMem);
+    }
+    else
+    {
+      Depth = ES_GetQueueDepth(EventQueues[WhichQueue].pMem);
+    }
+    if (Depth > pStats->PeakDepth)
+    {
+      pStats->PeakDepth = Depth;
+    }
+  }
+  else
+  {
+    if ((uint16_t)ThisEvent.EventType < NUM_EVENT_TYPES)
+    {
+      pStats->Drops[ThisEvent.EventType]++;
+    }
+    pStats->NumDrops++;
+    pStats->LastOverflow.Service = WhichQueue;
+    pStats->LastOverflow.Event = ThisEvent;
+    pStats->LastOverflow.Interrupt = _HW_GetActiveInterrupt();
+    pStats->LastOverflow.PostingService =
+        (pStats->LastOverflow.Interrupt != 0) ? ES_NO_SERVICE : RunningService;
+#ifdef ES_QUEUE_OVERFLOW_HOOK
+    Overflow = pStats->LastOverflow;
+#endif
+  }
+  CPUsetPRIMASK(SavedPRIMASK);
+#ifdef ES_QUEUE_OVERFLOW_HOOK
+  if (!Posted)
+  {
+    ES_QUEUE_OVERFLOW_HOOK(&Overflow);
+  }
+#endif
+}
+#endif
+
 #if 0
 /****************************************************************************
  Function
@@ -472,5 +1051,314 @@ static bool CheckSystemEvents(void)
 }
 
 #endif
+
+#if defined(TEST) && defined(ES_PORT_POSIX)
+/*
+  Host dispatch bench. Times ES_Run itself, from the post that sets a Ready
+  bit to the call of the run function that takes the event, with whatever
+  queue kinds, coalescing, stats & trace the ES_Configure.h it is built with
+  turns on. Every service in SERVICE_LIST is replaced by a stand-in whose
+  run function posts one event to the next service, round robin, so that
+  every priority gets picked, and ES_Run is left by returning an error
+  event once NUM_BENCH_EVENTS have gone through. Build it twice, the second
+  time with -DES_TEST_LUT_DISPATCH to pick with the nybble table as ES_Run
+  did before CLZ, and compare the ns per dispatch. After the bench a post
+  is interrupted, as soon as its event is in the queue, by an interrupt
+  that posts too, and the events must still come out in order; build with
+  -DES_BUS_SIZE=16 to have the interrupt publish as well, and with
+  -DES_DEADLINES and -DES_PROFILE to check that the post keeps the
+  deadline and time stamp it was given before the interrupt:
+  gcc -O2 -DES_PORT_POSIX -I<app headers> -IHeaders -c Source/ES_Queue.c
+      Source/ES_LookupTables.c Source/ES_Trace.c Source/ES_Profile.c
+      Source/ES_Sched.c Source/ES_Bus.c
+  gcc -O2 -DTEST -DES_PORT_POSIX -I<app headers> -IHeaders
+      Source/ES_Framework.c ES_Queue.o ES_LookupTables.o ES_Trace.o
+      ES_Profile.o ES_Sched.o ES_Bus.o
+*/
+#include <time.h>
+
+#define NUM_BENCH_EVENTS 2000000u
+#define INTERRUPT_US     1000u    // how long the interrupt takes
+
+static uint32_t NumDispatched;
+static uint32_t PostedAt;
+static uint64_t TotalLatency;
+static uint32_t MinLatency = UINT32_MAX;
+static uint32_t MaxLatency;
+static uint16_t Errors;
+static bool     IsClockStepped;
+static uint32_t SteppedClock;
+
+// stand-ins for the port, so that this test links on its own. PRIMASK is
+// emulated, and an interrupt left pending is taken as soon as interrupts
+// are turned back on with an event waiting for service 0
+uint32_t _PRIMASK_temp;
+static uint32_t PRIMASK;
+static void (*pInterrupt)(void);
+
+uint32_t CPUgetPRIMASK_cpsid(void)
+{
+  uint32_t WasPRIMASK = PRIMASK;
+
+  PRIMASK = 1;
+  return WasPRIMASK;
+}
+
+void CPUsetPRIMASK(uint32_t newPRIMASK)
+{
+  void (*pTaken)(void) = pInterrupt;
+
+  PRIMASK = newPRIMASK;
+  if ((PRIMASK == 0) && (pTaken != NULL))
+  {
+    // held back while looking, the bus look takes a critical region too
+    pInterrupt = NULL;
+    if (HasEventsWaiting(0))
+    {
+      pTaken();
+    }
+    else
+    {
+      pInterrupt = pTaken;
+    }
+  }
+}
+
+uint32_t _HW_GetCycleCount(void)
+{
+  struct timespec Now;
+
+  // for the interrupted post, every read is a microsecond on, and the
+  // interrupt moves it on too
+  if (IsClockStepped)
+  {
+    SteppedClock += ES_CYCLES_PER_US;
+    return SteppedClock;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &Now);
+  return (uint32_t)(Now.tv_sec * 1000000000u + Now.tv_nsec);
+}
+
+bool _HW_Process_Pending_Ints(void)
+{
+  return true;
+}
+
+void _HW_Idle(void)
+{
+  // only reached if a post was lost, the bench never lets the queues empty
+  Errors++;
+}
+
+uint8_t _HW_GetActiveInterrupt(void)
+{
+  return 0;
+}
+
+uint16_t ES_Timer_GetTime(void)
+{
+  return 0;
+}
+
+void ES_Timer_Init(TimerRate_t Rate)
+{
+  (void)Rate;
+}
+
+bool ES_CheckUserEvents(void)
+{
+  return false;
+}
+
+#ifdef _INCLUDE_BASIC_FRAMEWORK_DEBUG_
+void _HW_DebugLines_Init(void) {}
+void _HW_DebugSetLine1(void) {}
+void _HW_DebugClearLine1(void) {}
+void _HW_DebugSetLine2(void) {}
+void _HW_DebugClearLine2(void) {}
+#endif
+
+// the event each stand-in passes on, the first user event so that no
+// coalescing rule or HSM event gets in the way
+#define BENCH_EVENT (ES_EXIT + 1)
+
+static ES_Event_t BenchRun(uint8_t WhichService, ES_Event_t ThisEvent)
+{
+  uint32_t    Latency = _HW_GetCycleCount() - PostedAt;
+  ES_Event_t  NextEvent;
+
+  if ((ThisEvent.EventType != BENCH_EVENT) ||
+      (ThisEvent.EventParam != WhichService))
+  {
+    Errors++;
+  }
+  TotalLatency += Latency;
+  if (Latency < MinLatency)
+  {
+    MinLatency = Latency;
+  }
+  if (Latency > MaxLatency)
+  {
+    MaxLatency = Latency;
+  }
+  if (++NumDispatched == NUM_BENCH_EVENTS)
+  {
+    NextEvent.EventType = ES_ERROR;   // and out of ES_Run
+    return NextEvent;
+  }
+  NextEvent.EventType = BENCH_EVENT;
+  NextEvent.EventParam = (WhichService + 1) % NUM_SERVICES;
+  PostedAt = _HW_GetCycleCount();
+  if (ES_PostToService(NextEvent.EventParam, NextEvent) != true)
+  {
+    Errors++;
+  }
+  NextEvent.EventType = ES_NO_EVENT;
+  return NextEvent;
+}
+
+// the stand-ins, named after the real services so that they fill the same
+// places in ServDescList
+#define BENCH_SERVICE_ENTRY(Init, Run, QueueSize, Kind)  \
+  bool Init(uint8_t Priority)                            \
+  {                                                      \
+    (void)Priority;                                      \
+    return true;                                         \
+  }                                                      \
+  ES_Event_t Run(ES_Event_t ThisEvent)                   \
+  {                                                      \
+    return BenchRun(ServIndex_##Run, ThisEvent);         \
+  }
+
+#ifndef COALESCE_LIST
+#define SERV_INDEX_ENTRY(Init, Run, QueueSize, Kind) ServIndex_##Run,
+
+enum
+{
+  SERVICE_LIST(SERV_INDEX_ENTRY)
+};
+#endif
+
+SERVICE_LIST(BENCH_SERVICE_ENTRY)
+
+static void Check(bool Condition, char const *pWhat)
+{
+  if (Condition != true)
+  {
+    printf("FAILED: %s\n", pWhat);
+    Errors++;
+  }
+}
+
+// what ES_Run does to get a service's next event
+static ES_Event_t TakeEvent(uint8_t WhichService)
+{
+  ES_Event_t ThisEvent;
+
+  ThisEvent.EventType = ES_NO_EVENT;
+#ifdef ES_BUS_SIZE
+  if (ES_Bus_Take(WhichService, &ThisEvent) == true)
+  {
+    return ThisEvent;
+  }
+#endif
+  if (EventQueues[WhichService].Kind == ES_QUEUE_SPSC)
+  {
+    ES_DeQueueSPSC(EventQueues[WhichService].pMem, &ThisEvent);
+  }
+  else
+  {
+    ES_DeQueue(EventQueues[WhichService].pMem, &ThisEvent);
+  }
+  return ThisEvent;
+}
+
+// the interrupt, it posts to the last service and publishes to service 0
+static void PostFromInterrupt(void)
+{
+  ES_Event_t ThisEvent;
+
+  SteppedClock += INTERRUPT_US * ES_CYCLES_PER_US;
+  ThisEvent.EventType = BENCH_EVENT;
+  ThisEvent.EventParam = 2;
+  Check(ES_PostToService(NUM_SERVICES - 1, ThisEvent), "post from interrupt");
+#ifdef ES_BUS_SIZE
+  ThisEvent.EventParam = 3;
+  Check(ES_Bus_PublishTo(BitNum2SetMask[0], ThisEvent),
+      "publish from interrupt");
+#endif
+}
+
+static void CheckInterruptedPost(void)
+{
+  ES_Event_t ThisEvent;
+
+  ThisEvent.EventType = BENCH_EVENT;
+  ThisEvent.EventParam = 1;
+  pInterrupt = PostFromInterrupt;
+  IsClockStepped = true;
+  Check(ES_PostToService(0, ThisEvent), "interrupted post");
+  Check(pInterrupt == NULL, "interrupt taken during the post");
+  Check(TakeEvent(0).EventParam == 1, "interrupted post handed over first");
+#ifdef ES_PROFILE
+  // stamped before the interrupt, so its wait takes the interrupt in
+  ES_Profile_Reset();
+  ES_Profile_BeginRun(0, BENCH_EVENT);
+  ES_Profile_EndRun();
+  Check(ES_Profile_GetStats(0, BENCH_EVENT)->WaitMax >=
+      INTERRUPT_US * ES_CYCLES_PER_US, "interrupted post keeps its stamp");
+#endif
+#ifdef ES_DEADLINES
+  // stamped before the interrupt, so its response takes the interrupt in
+  ES_Sched_ResetStats();
+  ES_Sched_BeginRun(0);
+  ES_Sched_EndRun();
+  Check(ES_Sched_GetStats(0)->MaxResponse >=
+      INTERRUPT_US * ES_CYCLES_PER_US, "interrupted post keeps its deadline");
+#endif
+  IsClockStepped = false;
+#ifdef ES_BUS_SIZE
+  Check(TakeEvent(0).EventParam == 3, "then the publish from the interrupt");
+#endif
+  Check(TakeEvent(NUM_SERVICES - 1).EventParam == 2, "post from interrupt");
+  Ready = 0;
+}
+
+int main(void)
+{
+  ES_Event_t  FirstEvent;
+
+#ifdef ES_TEST_LUT_DISPATCH
+  printf("ES_Run dispatch, nybble table pick, %u services\n", NUM_SERVICES);
+#else
+  printf("ES_Run dispatch, CLZ pick, %u services\n", NUM_SERVICES);
+#endif
+  if (ES_Initialize(ES_Timer_RATE_1mS) != Success)
+  {
+    puts("ES_Initialize failed");
+    return 1;
+  }
+  FirstEvent.EventType = BENCH_EVENT;
+  FirstEvent.EventParam = 0;
+  PostedAt = _HW_GetCycleCount();
+  ES_PostToService(0, FirstEvent);
+  if (ES_Run() != FailedRun)
+  {
+    Errors++;
+  }
+  if (NumDispatched != NUM_BENCH_EVENTS)
+  {
+    Errors++;
+  }
+  CheckInterruptedPost();
+  printf("%u dispatches, post to run function %lu.%02lu ns mean, "
+      "%u min, %u max\n", NumDispatched,
+      (unsigned long)(TotalLatency / NumDispatched),
+      (unsigned long)((TotalLatency % NumDispatched) * 100 / NumDispatched),
+      MinLatency, MaxLatency);
+  printf("%u errors\n", Errors);
+  return Errors;
+}
+#endif /* TEST && ES_PORT_POSIX */
 /*------------------------------- Footnotes -------------------------------*/
 /*------------------------------ End of file ------------------------------*/
@@ -0,0 +1,977 @@
+/****************************************************************************
+ Module
+     ES_Hsm.c
+ Description
+     table driven engine for hierarchical state machines described with
+     ES_HSM_DEFINE (see ES_Hsm.h)
+ Notes
+     ES_Hsm_Init, which ES_Hsm_Start calls the first time if nobody else
+     has, works out everything that does not depend on the current state:
+     for each transition the depth of the least common ancestor of its
+     source and target and the list of states to enter below it, and for
+     each state & event type the first transition to try. Dispatching an
+     event is then a walk up from the active leaf, one table look up per
+     level, with no recursion, so the stack used does not grow with the
+     depth of the machine.
+
+     A parent's During function does not see an event that one of its
+     children used for a transition. In HSMTemplate.c it still runs, after
+     the child machine returns.
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 19:10         started coding
+*****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Configure.h"
+#include "ES_Hsm.h"
+#include <string.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+#define PARENT_OF(pHsm, State) ((pHsm)->pStates[State].Parent)
+#define KIND_OF(pTrans) ((pTrans)->Kind & (uint8_t)~ES_HSM_PASS_ON)
+
+/*---------------------------- Module Functions ---------------------------*/
+static uint8_t DepthOf(ES_Hsm_t const *pHsm, uint8_t State);
+static bool BuildPath(ES_Hsm_t *pHsm, uint8_t Which);
+static void TakeTransition(ES_Hsm_t *pHsm, uint8_t Which,
+    ES_Event_t ThisEvent);
+static void ExitTo(ES_Hsm_t *pHsm, uint8_t Depth);
+static void Enter(ES_Hsm_t *pHsm, uint8_t State, ES_Event_t EntryEvent);
+static void EnterLeaf(ES_Hsm_t *pHsm, uint8_t State, ES_Event_t EntryEvent);
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+   ES_Hsm_Init
+ Parameters
+   ES_Hsm_t * : the machine, from ES_HSM_DEFINE
+ Returns
+   bool : false if the description is not a valid machine
+ Description
+   checks the state & transition tables and builds the dispatch table and
+   the exit & entry paths of the transitions from them
+ Notes
+   a machine that fails here is never started, and passes every event
+   back untouched
+ Author
+   10/17/26
+****************************************************************************/
+bool ES_Hsm_Init(ES_Hsm_t *pHsm)
+{
+  ES_HsmState_t const       *pState;
+  ES_HsmTransition_t const  *pTrans;
+  uint8_t                   *pSlot;
+  uint8_t                   i;
+
+  pHsm->IsBuilt = false;
+  pHsm->IsActive = false;
+  if ((pHsm->NumStates >= ES_HSM_NO_STATE) ||
+      (pHsm->NumTransitions >= ES_HSM_NO_STATE) ||
+      (pHsm->Initial >= pHsm->NumStates) ||
+      (PARENT_OF(pHsm, pHsm->Initial) != ES_HSM_TOP))
+  {
+    return false;
+  }
+
+  // parents come before their children, so the depths can be filled in
+  // in one pass, and the hierarchy can not loop
+  for (i = 0; i < pHsm->NumStates; i++)
+  {
+    pState = &pHsm->pStates[i];
+    if (pState->Parent == ES_HSM_TOP)
+    {
+      pHsm->pDepths[i] = 1;
+    }
+    else if (pState->Parent < i)
+    {
+      pHsm->pDepths[i] = pHsm->pDepths[pState->Parent] + 1;
+    }
+    else
+    {
+      return false;
+    }
+    if (pHsm->pDepths[i] > ES_HSM_MAX_DEPTH)
+    {
+      return false;
+    }
+    pHsm->pHistory[i] = ES_HSM_NO_STATE;
+  }
+  for (i = 0; i < pHsm->NumStates; i++)
+  {
+    pState = &pHsm->pStates[i];
+    if ((pState->Initial != ES_HSM_NO_STATE) &&
+        ((pState->Initial >= pHsm->NumStates) ||
+        (PARENT_OF(pHsm, pState->Initial) != i)))
+    {
+      return false;
+    }
+  }
+
+  // chain the transitions on each state & event type, working backwards
+  // so that they are tried in the order they were listed
+  memset(pHsm->pDispatch, ES_HSM_NO_STATE,
+      (size_t)pHsm->NumStates * NUM_EVENT_TYPES);
+  for (i = pHsm->NumTransitions; i-- > 0;)
+  {
+    pTrans = &pHsm->pTransitions[i];
+    if ((pTrans->Source >= pHsm->NumStates) ||
+        ((unsigned)pTrans->Event >= NUM_EVENT_TYPES) ||
+        (KIND_OF(pTrans) > ES_HSM_HISTORY) ||
+        ((KIND_OF(pTrans) != ES_HSM_INTERNAL) &&
+        (pTrans->Target >= pHsm->NumStates)))
+    {
+      return false;
+    }
+    pSlot = &pHsm->pDispatch[pTrans->Source * NUM_EVENT_TYPES +
+        pTrans->Event];
+    pHsm->pPaths[i].Next = *pSlot;
+    *pSlot = i;
+    if (!BuildPath(pHsm, i))
+    {
+      return false;
+    }
+  }
+  pHsm->TopHistory = ES_HSM_NO_STATE;
+  pHsm->Current = ES_HSM_NO_STATE;
+  pHsm->IsBuilt = true;
+  return true;
+}
+
+/****************************************************************************
+ Function
+   ES_Hsm_SetInitial
+ Parameters
+   ES_Hsm_t * : the machine
+   uint8_t : an outermost state
+ Returns
+   bool : false if the state is not an outermost one of this machine
+ Description
+   sets the state the next ES_ENTRY start goes into
+ Notes
+   for a machine whose Start function picks the first state from what it
+   finds, where StartTemplateSM would set CurrentState
+ Author
+   10/17/26
+****************************************************************************/
+bool ES_Hsm_SetInitial(ES_Hsm_t *pHsm, uint8_t WhichState)
+{
+  if ((WhichState >= pHsm->NumStates) ||
+      (PARENT_OF(pHsm, WhichState) != ES_HSM_TOP))
+  {
+    return false;
+  }
+  pHsm->Initial = WhichState;
+  return true;
+}
+
+/****************************************************************************
+ Function
+   ES_Hsm_Start
+ Parameters
+   ES_Hsm_t * : the machine
+   ES_Event_t : ES_ENTRY, or ES_ENTRY_HISTORY to go back to the leaf that
+                was active when the machine last stopped
+ Returns
+   None
+ Description
+   enters the machine from the top, running the entry functions outermost
+   first
+ Notes
+   the equivalent of StartTemplateSM. Starting a running machine stops it
+   first, so every entry function is matched by an exit function.
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Hsm_Start(ES_Hsm_t *pHsm, ES_Event_t EntryEvent)
+{
+  uint8_t First = pHsm->Initial;
+
+  if (!pHsm->IsBuilt && !ES_Hsm_Init(pHsm))
+  {
+    return;
+  }
+  ES_Hsm_Stop(pHsm);
+
+  if (EntryEvent.EventType != ES_ENTRY_HISTORY)
+  {
+    EntryEvent.EventType = ES_ENTRY;
+  }
+  else if (pHsm->TopHistory != ES_HSM_NO_STATE)
+  {
+    First = pHsm->TopHistory;
+  }
+  pHsm->IsActive = true;
+  Enter(pHsm, First, EntryEvent);
+  EnterLeaf(pHsm, First, EntryEvent);
+}
+
+/****************************************************************************
+ Function
+   ES_Hsm_Stop
+ Parameters
+   ES_Hsm_t * : the machine
+ Returns
+   None
+ Description
+   leaves every active state, running the exit functions innermost first
+ Notes
+   the equivalent of running a template machine with ES_EXIT. The active
+   states are remembered for a later start with ES_ENTRY_HISTORY, and
+   ES_Hsm_Query still returns the leaf that was active.
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Hsm_Stop(ES_Hsm_t *pHsm)
+{
+  uint8_t Leaf = pHsm->Current;
+
+  if (pHsm->IsActive)
+  {
+    ExitTo(pHsm, 0);
+    pHsm->Current = Leaf;
+    pHsm->IsActive = false;
+  }
+}
+
+/****************************************************************************
+ Function
+   ES_Hsm_Dispatch
+ Parameters
+   ES_Hsm_t * : the machine
+   ES_Event_t : the event to process
+ Returns
+   ES_Event_t : ES_NO_EVENT if the event was consumed, otherwise the event,
+                as re-mapped by the During functions, for the level above.
+                Only transitions marked ES_HSM_PASS_ON pass it on.
+ Description
+   runs the During functions from the active leaf outwards, and takes the
+   first transition whose guard passes, on the innermost state that has one
+ Notes
+   ES_ENTRY, ES_ENTRY_HISTORY and ES_EXIT start and stop the machine, so
+   this can stand in for the run function of a template machine
+ Author
+   10/17/26
+****************************************************************************/
+ES_Event_t ES_Hsm_Dispatch(ES_Hsm_t *pHsm, ES_Event_t ThisEvent)
+{
+  ES_HsmTransition_t const  *pTrans;
+  ES_HsmDuringFunc_t        During;
+  uint8_t                   State;
+  uint8_t                   Which;
+
+  switch (ThisEvent.EventType)
+  {
+    case ES_ENTRY:
+    case ES_ENTRY_HISTORY:
+    {
+      ES_Hsm_Start(pHsm, ThisEvent);
+      return ThisEvent;
+    }
+    case ES_EXIT:
+    {
+      ES_Hsm_Stop(pHsm);
+      return ThisEvent;
+    }
+    default:
+      break;
+  }
+  if (!pHsm->IsActive)
+  {
+    return ThisEvent;
+  }
+
+  for (State = pHsm->Current; State != ES_HSM_TOP;
+      State = PARENT_OF(pHsm, State))
+  {
+    During = pHsm->pStates[State].During;
+    if (During != NULL)
+    {
+      ThisEvent = During(ThisEvent);
+      if (ThisEvent.EventType == ES_NO_EVENT)
+      {
+        break;
+      }
+    }
+    if ((unsigned)ThisEvent.EventType < NUM_EVENT_TYPES)
+    {
+      Which = pHsm->pDispatch[State * NUM_EVENT_TYPES + ThisEvent.EventType];
+      while (Which != ES_HSM_NO_STATE)
+      {
+        pTrans = &pHsm->pTransitions[Which];
+        if ((pTrans->Guard == NULL) || pTrans->Guard(ThisEvent))
+        {
+          TakeTransition(pHsm, Which, ThisEvent);
+          if ((pTrans->Kind & ES_HSM_PASS_ON) == 0)
+          {
+            ThisEvent.EventType = ES_NO_EVENT;
+          }
+          return ThisEvent;
+        }
+        Which = pHsm->pPaths[Which].Next;
+      }
+    }
+  }
+  return ThisEvent;
+}
+
+/****************************************************************************
+ Function
+   ES_Hsm_Query
+ Parameters
+   ES_Hsm_t const * : the machine
+ Returns
+   uint8_t : the active leaf state, ES_HSM_NO_STATE if never started
+ Description
+   the equivalent of QueryTemplateSM
+ Author
+   10/17/26
+****************************************************************************/
+uint8_t ES_Hsm_Query(ES_Hsm_t const *pHsm)
+{
+  return pHsm->Current;
+}
+
+/****************************************************************************
+ Function
+   ES_Hsm_IsIn
+ Parameters
+   ES_Hsm_t const * : the machine
+   uint8_t : a state
+ Returns
+   bool : true if the state is the active leaf or contains it
+ Description
+   tests for being in a composite state without naming all of its leaves
+ Author
+   10/17/26
+****************************************************************************/
+bool ES_Hsm_IsIn(ES_Hsm_t const *pHsm, uint8_t WhichState)
+{
+  uint8_t State;
+
+  if (pHsm->IsActive)
+  {
+    for (State = pHsm->Current; State != ES_HSM_TOP;
+        State = PARENT_OF(pHsm, State))
+    {
+      if (State == WhichState)
+      {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+static uint8_t DepthOf(ES_Hsm_t const *pHsm, uint8_t State)
+{
+  return (State == ES_HSM_TOP) ? 0 : pHsm->pDepths[State];
+}
+
+static bool BuildPath(ES_Hsm_t *pHsm, uint8_t Which)
+{
+  ES_HsmTransition_t const  *pTrans = &pHsm->pTransitions[Which];
+  ES_HsmPath_t              *pPath = &pHsm->pPaths[Which];
+  uint8_t                   FromSide;
+  uint8_t                   ToSide;
+  uint8_t                   State;
+  uint8_t                   i;
+
+  pPath->LcaDepth = 0;
+  pPath->EntryLen = 0;
+  if (KIND_OF(pTrans) == ES_HSM_INTERNAL)
+  {
+    return true;
+  }
+
+  // the least common ancestor is taken over the parents, so a transition
+  // to itself, an ancestor or a descendant leaves & re-enters the source
+  FromSide = PARENT_OF(pHsm, pTrans->Source);
+  ToSide = PARENT_OF(pHsm, pTrans->Target);
+  while (DepthOf(pHsm, FromSide) > DepthOf(pHsm, ToSide))
+  {
+    FromSide = PARENT_OF(pHsm, FromSide);
+  }
+  while (DepthOf(pHsm, ToSide) > DepthOf(pHsm, FromSide))
+  {
+    ToSide = PARENT_OF(pHsm, ToSide);
+  }
+  while (FromSide != ToSide)
+  {
+    FromSide = PARENT_OF(pHsm, FromSide);
+    ToSide = PARENT_OF(pHsm, ToSide);
+  }
+  pPath->LcaDepth = DepthOf(pHsm, FromSide);
+
+  // down from there to the target
+  pPath->EntryLen = pHsm->pDepths[pTrans->Target] - pPath->LcaDepth;
+  State = pTrans->Target;
+  for (i = pPath->EntryLen; i-- > 0;)
+  {
+    pPath->Entry[i] = State;
+    State = PARENT_OF(pHsm, State);
+  }
+
+  // and on to the initial leaf, unless the way down depends on history
+  if (KIND_OF(pTrans) == ES_HSM_EXTERNAL)
+  {
+    State = pTrans->Target;
+    while (pHsm->pStates[State].Initial != ES_HSM_NO_STATE)
+    {
+      State = pHsm->pStates[State].Initial;
+      if (pPath->EntryLen >= ES_HSM_MAX_DEPTH)
+      {
+        return false;
+      }
+      pPath->Entry[pPath->EntryLen++] = State;
+    }
+  }
+  return true;
+}
+
+static void TakeTransition(ES_Hsm_t *pHsm, uint8_t Which,
+    ES_Event_t ThisEvent)
+{
+  ES_HsmTransition_t const  *pTrans = &pHsm->pTransitions[Which];
+  ES_HsmPath_t const        *pPath = &pHsm->pPaths[Which];
+  ES_Event_t                EntryEvent;
+  uint8_t                   Kind = KIND_OF(pTrans);
+  uint8_t                   i;
+
+  if (Kind != ES_HSM_INTERNAL)
+  {
+    ExitTo(pHsm, pPath->LcaDepth);
+  }
+  if (pTrans->Action != NULL)
+  {
+    pTrans->Action(ThisEvent);
+  }
+  if (Kind != ES_HSM_INTERNAL)
+  {
+    EntryEvent.EventType = (Kind == ES_HSM_HISTORY) ?
+        ES_ENTRY_HISTORY : ES_ENTRY;
+    EntryEvent.EventParam = 0;
+    for (i = 0; i < pPath->EntryLen; i++)
+    {
+      Enter(pHsm, pPath->Entry[i], EntryEvent);
+    }
+    if (Kind == ES_HSM_HISTORY)
+    {
+      EnterLeaf(pHsm, pTrans->Target, EntryEvent);
+    }
+  }
+}
+
+// exits the active states deeper than Depth, innermost first, and
+// remembers each one as the last active child of its parent
+static void ExitTo(ES_Hsm_t *pHsm, uint8_t Depth)
+{
+  uint8_t State = pHsm->Current;
+  uint8_t Parent;
+
+  while ((State != ES_HSM_TOP) && (pHsm->pDepths[State] > Depth))
+  {
+    if (pHsm->pStates[State].Exit != NULL)
+    {
+      pHsm->pStates[State].Exit();
+    }
+    Parent = PARENT_OF(pHsm, State);
+    if (Parent == ES_HSM_TOP)
+    {
+      pHsm->TopHistory = State;
+    }
+    else
+    {
+      pHsm->pHistory[Parent] = State;
+    }
+    State = Parent;
+    pHsm->Current = State;
+  }
+}
+
+static void Enter(ES_Hsm_t *pHsm, uint8_t State, ES_Event_t EntryEvent)
+{
+  pHsm->Current = State;
+  if (pHsm->pStates[State].Entry != NULL)
+  {
+    pHsm->pStates[State].Entry(EntryEvent);
+  }
+}
+
+// enters the states below State down to a leaf, by the remembered children
+// for ES_ENTRY_HISTORY where there are any, by the initial ones otherwise
+static void EnterLeaf(ES_Hsm_t *pHsm, uint8_t State, ES_Event_t EntryEvent)
+{
+  uint8_t Child;
+
+  for (;;)
+  {
+    Child = ES_HSM_NO_STATE;
+    if (EntryEvent.EventType == ES_ENTRY_HISTORY)
+    {
+      Child = pHsm->pHistory[State];
+    }
+    if (Child == ES_HSM_NO_STATE)
+    {
+      Child = pHsm->pStates[State].Initial;
+    }
+    if (Child == ES_HSM_NO_STATE)
+    {
+      return;
+    }
+    Enter(pHsm, Child, EntryEvent);
+    State = Child;
+  }
+}
+
+#if defined(TEST) && defined(ES_PORT_POSIX)
+/*
+  Host benchmark. The same three level machine is written twice, once as
+  nested switches after HSMTemplate.c, with one run function per level,
+  and once as ES_Hsm tables. Both are driven with the same pseudo-random
+  events, their entry & exit calls are hashed to check that they do the
+  same thing, and the time per event and the deepest stack reached from
+  the dispatch call are printed for each.
+
+     OUTER_A            OUTER_B
+       MID_A    MID_B
+         IN_A  IN_B
+
+  EV_LINE_HIT toggles IN_A & IN_B, EV_SWITCH_HIT toggles MID_A & MID_B,
+  EV_STATE_CHANGE toggles OUTER_A & OUTER_B, going back into OUTER_A by
+  history, and EV_SCORE_UPDATE is handled by nobody. A two state machine
+  is checked first for ES_HSM_PASS_ON and ES_Hsm_SetInitial. Build with:
+  gcc -O2 -DTEST -DES_PORT_POSIX -I<app headers> -IHeaders Source/ES_Hsm.c
+*/
+#include <stdio.h>
+#include <time.h>
+
+#define NUM_BENCH_EVENTS 2000000u
+
+typedef enum
+{
+  OUTER_A, MID_A, IN_A, IN_B, MID_B, OUTER_B, NUM_BENCH_STATES
+}BenchState_t;
+
+static uint32_t   LogHash;
+static uint32_t   NumDurings;
+static char const *pStackBase;
+static char const *pStackLow;
+
+// called from every entry, exit & during function of both machines
+static void __attribute__((noinline)) Note(uint8_t Code)
+{
+  char Marker;
+
+  // during calls are counted, not hashed, see the Notes at the top
+  if (Code != 0)
+  {
+    LogHash = LogHash * 31u + Code;
+  }
+  if (&Marker < pStackLow)
+  {
+    pStackLow = &Marker;
+  }
+}
+
+/*--------------------- the machine after HSMTemplate.c --------------------*/
+static BenchState_t OuterState, MidState, InState;
+
+static ES_Event_t RunIn(ES_Event_t CurrentEvent);
+static ES_Event_t RunMid(ES_Event_t CurrentEvent);
+
+static ES_Event_t DuringLeaf(BenchState_t State, ES_Event_t Event)
+{
+  if ((Event.EventType == ES_ENTRY) || (Event.EventType == ES_ENTRY_HISTORY))
+  {
+    Note('E' + State);
+  }
+  else if (Event.EventType == ES_EXIT)
+  {
+    Note('X' + State);
+  }
+  else
+  {
+    NumDurings++;
+    Note(0);
+  }
+  return Event;
+}
+
+static void StartIn(ES_Event_t CurrentEvent)
+{
+  if (ES_ENTRY_HISTORY != CurrentEvent.EventType)
+  {
+    InState = IN_A;
+  }
+  RunIn(CurrentEvent);
+}
+
+static void StartMid(ES_Event_t CurrentEvent)
+{
+  if (ES_ENTRY_HISTORY != CurrentEvent.EventType)
+  {
+    MidState = MID_A;
+  }
+  RunMid(CurrentEvent);
+}
+
+static ES_Event_t DuringMidA(ES_Event_t Event)
+{
+  ES_Event_t ReturnEvent = Event;
+
+  if ((Event.EventType == ES_ENTRY) || (Event.EventType == ES_ENTRY_HISTORY))
+  {
+    Note('E' + MID_A);
+    StartIn(Event);
+  }
+  else if (Event.EventType == ES_EXIT)
+  {
+    RunIn(Event);
+    Note('X' + MID_A);
+  }
+  else
+  {
+    ReturnEvent = RunIn(Event);
+    NumDurings++;
+    Note(0);
+  }
+  return ReturnEvent;
+}
+
+static ES_Event_t DuringOuterA(ES_Event_t Event)
+{
+  ES_Event_t ReturnEvent = Event;
+
+  if ((Event.EventType == ES_ENTRY) || (Event.EventType == ES_ENTRY_HISTORY))
+  {
+    Note('E' + OUTER_A);
+    StartMid(Event);
+  }
+  else if (Event.EventType == ES_EXIT)
+  {
+    RunMid(Event);
+    Note('X' + OUTER_A);
+  }
+  else
+  {
+    ReturnEvent = RunMid(Event);
+    NumDurings++;
+    Note(0);
+  }
+  return ReturnEvent;
+}
+
+static ES_Event_t RunIn(ES_Event_t CurrentEvent)
+{
+  bool          MakeTransition = false;
+  BenchState_t  NextState = InState;
+  ES_Event_t    EntryEventKind = { ES_ENTRY, 0 };
+  ES_Event_t    ReturnEvent = CurrentEvent;
+
+  ReturnEvent = CurrentEvent = DuringLeaf(InState, CurrentEvent);
+  if (CurrentEvent.EventType == EV_LINE_HIT)
+  {
+    NextState = (InState == IN_A) ? IN_B : IN_A;
+    MakeTransition = true;
+    ReturnEvent.EventType = ES_NO_EVENT;
+  }
+  if (MakeTransition == true)
+  {
+    CurrentEvent.EventType = ES_EXIT;
+    RunIn(CurrentEvent);
+    InState = NextState;
+    RunIn(EntryEventKind);
+  }
+  return ReturnEvent;
+}
+
+static ES_Event_t RunMid(ES_Event_t CurrentEvent)
+{
+  bool          MakeTransition = false;
+  BenchState_t  NextState = MidState;
+  ES_Event_t    EntryEventKind = { ES_ENTRY, 0 };
+  ES_Event_t    ReturnEvent = CurrentEvent;
+
+  switch (MidState)
+  {
+    case MID_A:
+    {
+      ReturnEvent = CurrentEvent = DuringMidA(CurrentEvent);
+      if (CurrentEvent.EventType == EV_SWITCH_HIT)
+      {
+        NextState = MID_B;
+        MakeTransition = true;
+        ReturnEvent.EventType = ES_NO_EVENT;
+      }
+    }
+    break;
+    default:
+    {
+      ReturnEvent = CurrentEvent = DuringLeaf(MidState, CurrentEvent);
+      if (CurrentEvent.EventType == EV_SWITCH_HIT)
+      {
+        NextState = MID_A;
+        MakeTransition = true;
+        ReturnEvent.EventType = ES_NO_EVENT;
+      }
+    }
+    break;
+  }
+  if (MakeTransition == true)
+  {
+    CurrentEvent.EventType = ES_EXIT;
+    RunMid(CurrentEvent);
+    MidState = NextState;
+    RunMid(EntryEventKind);
+  }
+  return ReturnEvent;
+}
+
+static ES_Event_t RunOuter(ES_Event_t CurrentEvent)
+{
+  bool          MakeTransition = false;
+  BenchState_t  NextState = OuterState;
+  ES_Event_t    EntryEventKind = { ES_ENTRY, 0 };
+  ES_Event_t    ReturnEvent = CurrentEvent;
+
+  switch (OuterState)
+  {
+    case OUTER_A:
+    {
+      ReturnEvent = CurrentEvent = DuringOuterA(CurrentEvent);
+      if (CurrentEvent.EventType == EV_STATE_CHANGE)
+      {
+        NextState = OUTER_B;
+        MakeTransition = true;
+        ReturnEvent.EventType = ES_NO_EVENT;
+      }
+    }
+    break;
+    default:
+    {
+      ReturnEvent = CurrentEvent = DuringLeaf(OuterState, CurrentEvent);
+      if (CurrentEvent.EventType == EV_STATE_CHANGE)
+      {
+        NextState = OUTER_A;
+        MakeTransition = true;
+        EntryEventKind.EventType = ES_ENTRY_HISTORY;
+        ReturnEvent.EventType = ES_NO_EVENT;
+      }
+    }
+    break;
+  }
+  if (MakeTransition == true)
+  {
+    CurrentEvent.EventType = ES_EXIT;
+    RunOuter(CurrentEvent);
+    OuterState = NextState;
+    RunOuter(EntryEventKind);
+  }
+  return ReturnEvent;
+}
+
+static void StartOuter(ES_Event_t CurrentEvent)
+{
+  OuterState = OUTER_A;
+  RunOuter(CurrentEvent);
+}
+
+/*------------------------- the same machine in tables ---------------------*/
+#define BENCH_ENTRY_FUNC(State) \
+  static void Enter##State(ES_Event_t EntryEvent) \
+  { (void)EntryEvent; Note('E' + State); } \
+  static void Exit##State(void) { Note('X' + State); }
+
+BENCH_ENTRY_FUNC(OUTER_A)
+BENCH_ENTRY_FUNC(MID_A)
+BENCH_ENTRY_FUNC(IN_A)
+BENCH_ENTRY_FUNC(IN_B)
+BENCH_ENTRY_FUNC(MID_B)
+BENCH_ENTRY_FUNC(OUTER_B)
+
+static ES_Event_t DuringBench(ES_Event_t Event)
+{
+  NumDurings++;
+  Note(0);
+  return Event;
+}
+
+#define BENCH_STATES(ES_HSM_STATE) \
+  ES_HSM_STATE(OUTER_A, ES_HSM_TOP, MID_A, EnterOUTER_A, ExitOUTER_A, \
+      DuringBench) \
+  ES_HSM_STATE(MID_A, OUTER_A, IN_A, EnterMID_A, ExitMID_A, DuringBench) \
+  ES_HSM_STATE(IN_A, MID_A, ES_HSM_NO_STATE, EnterIN_A, ExitIN_A, \
+      DuringBench) \
+  ES_HSM_STATE(IN_B, MID_A, ES_HSM_NO_STATE, EnterIN_B, ExitIN_B, \
+      DuringBench) \
+  ES_HSM_STATE(MID_B, OUTER_A, ES_HSM_NO_STATE, EnterMID_B, ExitMID_B, \
+      DuringBench) \
+  ES_HSM_STATE(OUTER_B, ES_HSM_TOP, ES_HSM_NO_STATE, EnterOUTER_B, \
+      ExitOUTER_B, DuringBench)
+
+#define BENCH_TRANSITIONS(ES_HSM_TRANSITION) \
+  ES_HSM_TRANSITION(IN_A, EV_LINE_HIT, IN_B, NULL, NULL, ES_HSM_EXTERNAL) \
+  ES_HSM_TRANSITION(IN_B, EV_LINE_HIT, IN_A, NULL, NULL, ES_HSM_EXTERNAL) \
+  ES_HSM_TRANSITION(MID_A, EV_SWITCH_HIT, MID_B, NULL, NULL, \
+      ES_HSM_EXTERNAL) \
+  ES_HSM_TRANSITION(MID_B, EV_SWITCH_HIT, MID_A, NULL, NULL, \
+      ES_HSM_EXTERNAL) \
+  ES_HSM_TRANSITION(OUTER_A, EV_STATE_CHANGE, OUTER_B, NULL, NULL, \
+      ES_HSM_EXTERNAL) \
+  ES_HSM_TRANSITION(OUTER_B, EV_STATE_CHANGE, OUTER_A, NULL, NULL, \
+      ES_HSM_HISTORY)
+
+ES_HSM_DEFINE(BenchHsm, BENCH_STATES, BENCH_TRANSITIONS, OUTER_A);
+
+/*-------------------- passing an event on after a transition --------------*/
+typedef enum { PASS_A, PASS_B } PassState_t;
+
+#define PASS_STATES(ES_HSM_STATE) \
+  ES_HSM_STATE(PASS_A, ES_HSM_TOP, ES_HSM_NO_STATE, NULL, NULL, NULL) \
+  ES_HSM_STATE(PASS_B, ES_HSM_TOP, ES_HSM_NO_STATE, NULL, NULL, NULL)
+
+#define PASS_TRANSITIONS(ES_HSM_TRANSITION) \
+  ES_HSM_TRANSITION(PASS_A, EV_LINE_HIT, PASS_B, NULL, NULL, \
+      ES_HSM_EXTERNAL | ES_HSM_PASS_ON) \
+  ES_HSM_TRANSITION(PASS_B, EV_LINE_HIT, PASS_A, NULL, NULL, \
+      ES_HSM_EXTERNAL) \
+  ES_HSM_TRANSITION(PASS_B, EV_SWITCH_HIT, PASS_B, NULL, NULL, \
+      ES_HSM_INTERNAL | ES_HSM_PASS_ON)
+
+ES_HSM_DEFINE(PassHsm, PASS_STATES, PASS_TRANSITIONS, PASS_A);
+
+// returns the number of checks that failed
+static uint32_t CheckPassOn(void)
+{
+  ES_Event_t  ThisEvent = { ES_ENTRY, 0 };
+  uint32_t    Failed = 0;
+
+  ES_Hsm_Start(&PassHsm, ThisEvent);
+  ThisEvent.EventType = EV_LINE_HIT;
+  ThisEvent = ES_Hsm_Dispatch(&PassHsm, ThisEvent);
+  Failed += (ThisEvent.EventType != EV_LINE_HIT) ||
+      (ES_Hsm_Query(&PassHsm) != PASS_B);
+  ThisEvent.EventType = EV_SWITCH_HIT;
+  ThisEvent = ES_Hsm_Dispatch(&PassHsm, ThisEvent);
+  Failed += (ThisEvent.EventType != EV_SWITCH_HIT) ||
+      (ES_Hsm_Query(&PassHsm) != PASS_B);
+  ThisEvent.EventType = EV_LINE_HIT;
+  ThisEvent = ES_Hsm_Dispatch(&PassHsm, ThisEvent);
+  Failed += (ThisEvent.EventType != ES_NO_EVENT) ||
+      (ES_Hsm_Query(&PassHsm) != PASS_A);
+
+  Failed += ES_Hsm_SetInitial(&PassHsm, NUM_BENCH_STATES);
+  Failed += !ES_Hsm_SetInitial(&PassHsm, PASS_B);
+  ThisEvent.EventType = ES_ENTRY;
+  ES_Hsm_Start(&PassHsm, ThisEvent);
+  Failed += (ES_Hsm_Query(&PassHsm) != PASS_B);
+  return Failed;
+}
+
+/*------------------------------- the driver -------------------------------*/
+typedef struct
+{
+  uint32_t  Hash;
+  uint32_t  Durings;
+  uint8_t   Leaf;
+  double    NsPerEvent;
+  long      StackBytes;
+}BenchResult_t;
+
+static ES_EventType_t const BenchEvents[] = {
+  EV_LINE_HIT, EV_SWITCH_HIT, EV_STATE_CHANGE, EV_SCORE_UPDATE
+};
+
+static void RunBench(bool UseTables, BenchResult_t *pResult)
+{
+  ES_Event_t      ThisEvent = { ES_ENTRY, 0 };
+  struct timespec Start;
+  struct timespec End;
+  uint32_t        Seed = 12345u;
+  uint32_t        i;
+  char            Base;
+
+  LogHash = 0;
+  NumDurings = 0;
+  pStackBase = pStackLow = &Base;
+  if (UseTables)
+  {
+    ES_Hsm_Start(&BenchHsm, ThisEvent);
+  }
+  else
+  {
+    StartOuter(ThisEvent);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &Start);
+  for (i = 0; i < NUM_BENCH_EVENTS; i++)
+  {
+    // mostly inner events, as on the robot
+    Seed = Seed * 1103515245u + 12345u;
+    ThisEvent.EventType = BenchEvents[(Seed >> 16) % 7u < 4u ? 0 :
+        (Seed >> 16) % 7u - 3u];
+    if (UseTables)
+    {
+      ES_Hsm_Dispatch(&BenchHsm, ThisEvent);
+    }
+    else
+    {
+      RunOuter(ThisEvent);
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &End);
+
+  pResult->Hash = LogHash;
+  pResult->Durings = NumDurings;
+  if (UseTables)
+  {
+    pResult->Leaf = ES_Hsm_Query(&BenchHsm);
+  }
+  else
+  {
+    pResult->Leaf = (OuterState == OUTER_B) ? OUTER_B :
+        (MidState == MID_B) ? MID_B : InState;
+  }
+  pResult->NsPerEvent = ((End.tv_sec - Start.tv_sec) * 1e9 +
+      (End.tv_nsec - Start.tv_nsec)) / NUM_BENCH_EVENTS;
+  pResult->StackBytes = (long)(pStackBase - pStackLow);
+}
+
+int main(void)
+{
+  BenchResult_t Template;
+  BenchResult_t Tables;
+
+  if (!ES_Hsm_Init(&BenchHsm))
+  {
+    printf("bad machine description\r\n");
+    return 1;
+  }
+  if (CheckPassOn() != 0)
+  {
+    printf("FAIL: ES_HSM_PASS_ON or ES_Hsm_SetInitial\r\n");
+    return 1;
+  }
+  RunBench(false, &Template);
+  RunBench(true, &Tables);
+
+  printf("%u events, %u states, 3 levels\r\n", NUM_BENCH_EVENTS,
+      NUM_BENCH_STATES);
+  printf("             nS/event  stack bytes  during calls\r\n");
+  printf("HSMTemplate  %8.1f  %11ld  %12u\r\n", Template.NsPerEvent,
+      Template.StackBytes, Template.Durings);
+  printf("ES_Hsm       %8.1f  %11ld  %12u\r\n", Tables.NsPerEvent,
+      Tables.StackBytes, Tables.Durings);
+  if ((Template.Hash != Tables.Hash) || (Template.Leaf != Tables.Leaf))
+  {
+    printf("FAIL: entries & exits differ\r\n");
+    return 1;
+  }
+  printf("same entries & exits, final state %u in both\r\n", Tables.Leaf);
+  return 0;
+}
+#endif /* TEST && ES_PORT_POSIX */
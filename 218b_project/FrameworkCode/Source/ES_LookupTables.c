@@ -33,7 +33,8 @@
 #include "ES_Types.h"
 #include "ES_General.h"
 #include "ES_Timers.h"
-#include "bitdefs.h"
+#include "ES_LookupTables.h"
+#include "BITDEFS.H"
 
 /*----------------------------- Module Defines ----------------------------*/
 #define ISOLATE_LS_NYBBLE 0x0F
@@ -56,12 +57,14 @@ uint16_t const BitNum2ClrMask[] = {
 */
 
 /*
-  this table is used to go from a bit number (0-15) to the mask used to set
-  that bit in a byte.
+  this table is used to go from a bit number (0-31) to the mask used to set
+  that bit in a 32-bit word.
 */
-uint16_t const BitNum2SetMask[] = {
+uint32_t const BitNum2SetMask[] = {
   BIT0HI, BIT1HI, BIT2HI, BIT3HI, BIT4HI, BIT5HI, BIT6HI, BIT7HI, BIT8HI, BIT9HI,
-  BIT10HI, BIT11HI, BIT12HI, BIT13HI, BIT14HI, BIT15HI
+  BIT10HI, BIT11HI, BIT12HI, BIT13HI, BIT14HI, BIT15HI, BIT16HI, BIT17HI,
+  BIT18HI, BIT19HI, BIT20HI, BIT21HI, BIT22HI, BIT23HI, BIT24HI, BIT25HI,
+  BIT26HI, BIT27HI, BIT28HI, BIT29HI, BIT30HI, BIT31HI
 };
 
 /*
@@ -76,7 +79,7 @@ uint8_t const Nybble2MSBitNum[15] = {
 };
 
 /*------------------------------ Module Code ------------------------------*/
-uint8_t ES_GetMSBitSet(uint16_t Val2Check)
+uint8_t ES_GetMSBitSetLUT(uint32_t Val2Check)
 {
   int8_t  LoopCntr;
   uint8_t Nybble2Test;
@@ -107,22 +110,116 @@ uint8_t ES_GetMSBitSet(uint16_t Val2Check)
 #ifdef TEST
 #include <stdio.h>
 
-void main(void)
+/*
+  cycle counter used to time the two versions of ES_GetMSBitSet. On the Tiva
+  this is the DWT cycle counter, on the host it is a nanosecond clock, so the
+  host numbers are ns/call rather than cycles/call.
+*/
+#ifdef ES_PORT_POSIX
+#include <time.h>
+static uint32_t ReadCycles(void)
 {
-  uint16_t  Counter = 0;
-  uint8_t   MSBit;
+  struct timespec Now;
+  clock_gettime(CLOCK_MONOTONIC, &Now);
+  return (uint32_t)(Now.tv_sec * 1000000000u + Now.tv_nsec);
+}
+
+#define CycleCounterInit()
+#else
+#define DEMCR       (*((volatile uint32_t *)0xE000EDFC))
+#define DWT_CTRL    (*((volatile uint32_t *)0xE0001000))
+#define DWT_CYCCNT  (*((volatile uint32_t *)0xE0001004))
+#define DEMCR_TRCENA      BIT24HI
+#define DWT_CTRL_CYCCNTENA BIT0HI
+
+static uint32_t ReadCycles(void)
+{
+  return DWT_CYCCNT;
+}
+
+static void CycleCounterInit(void)
+{
+  DEMCR     |= DEMCR_TRCENA;
+  DWT_CYCCNT = 0;
+  DWT_CTRL  |= DWT_CTRL_CYCCNTENA;
+}
+
+#endif
+
+#define NUM_BENCH_PASSES 10000
+
+// volatile so that the compiler can not hoist the calls out of the loops
+static volatile uint32_t  BenchVal;
+static volatile uint8_t   BenchResult;
+
+int main(void)
+{
+  uint32_t  Counter;
+  uint8_t   BitNum;
+  uint32_t  Start;
+  uint32_t  LUTTime;
+  uint32_t  CLZTime;
+  uint32_t  Pass;
+  uint16_t  Errors = 0;
 
   puts( "Testing the MSB Look-up function\n\r");
   puts( __TIME__ " " __DATE__);
   puts( "\n\r");
-  MSBit = ES_GetMSBitSet(Counter);
-  printf("the MSB set in %u is bit %d\n\r", Counter, MSBit);
+  printf("the MSB set in 0 is bit %d\n\r", ES_GetMSBitSet(0));
 
-  for (Counter = 1; Counter != 0; Counter++)
+  // every single bit and every bit with all of the lower bits set must agree
+  for (BitNum = 0; BitNum < 32; BitNum++)
   {
-    MSBit = ES_GetMSBitSet(Counter);
-    printf("the MSB set in %u is bit %d\n\r", Counter, MSBit);
+    Counter = BitNum2SetMask[BitNum];
+    if ((ES_GetMSBitSet(Counter) != BitNum) ||
+        (ES_GetMSBitSetLUT(Counter) != BitNum) ||
+        (ES_GetMSBitSet(Counter | (Counter - 1)) != BitNum) ||
+        (ES_GetMSBitSetLUT(Counter | (Counter - 1)) != BitNum))
+    {
+      printf("mismatch at bit %d\n\r", BitNum);
+      Errors++;
+    }
+  }
+  // and the two versions must agree for all 16-bit values
+  for (Counter = 1; Counter <= 0xFFFF; Counter++)
+  {
+    if (ES_GetMSBitSet(Counter) != ES_GetMSBitSetLUT(Counter))
+    {
+      printf("mismatch at %u\n\r", Counter);
+      Errors++;
+    }
+  }
+  printf("%u errors\n\r", Errors);
+
+  // now time them, across all of the bit positions that Ready can hold
+  CycleCounterInit();
+  Start = ReadCycles();
+  for (Pass = 0; Pass < NUM_BENCH_PASSES; Pass++)
+  {
+    for (BitNum = 0; BitNum < 32; BitNum++)
+    {
+      BenchVal    = BitNum2SetMask[BitNum];
+      BenchResult = ES_GetMSBitSetLUT(BenchVal);
+    }
+  }
+  LUTTime = ReadCycles() - Start;
+
+  Start = ReadCycles();
+  for (Pass = 0; Pass < NUM_BENCH_PASSES; Pass++)
+  {
+    for (BitNum = 0; BitNum < 32; BitNum++)
+    {
+      BenchVal    = BitNum2SetMask[BitNum];
+      BenchResult = ES_GetMSBitSet(BenchVal);
+    }
   }
+  CLZTime = ReadCycles() - Start;
+
+  printf("LUT: %u.%02u per call\n\r", LUTTime / (NUM_BENCH_PASSES * 32),
+      (LUTTime % (NUM_BENCH_PASSES * 32)) * 100 / (NUM_BENCH_PASSES * 32));
+  printf("CLZ: %u.%02u per call\n\r", CLZTime / (NUM_BENCH_PASSES * 32),
+      (CLZTime % (NUM_BENCH_PASSES * 32)) * 100 / (NUM_BENCH_PASSES * 32));
+  return Errors;
 }
 
 #endif
@@ -29,6 +29,7 @@
 #include "inc/hw_types.h"
 #include "inc/hw_gpio.h"
 #include "inc/hw_sysctl.h"
+#include "inc/hw_nvic.h"
 #include "driverlib/sysctl.h"
 #include "driverlib/interrupt.h"
 #include "driverlib/uart.h"
@@ -37,9 +38,21 @@
 #include "driverlib/gpio.h"
 #include "utils/uartstdio.h"
 
+#include "ES_Configure.h"
 #include "ES_Port.h"
 #include "ES_Types.h"
 #include "ES_Timers.h"
+#include "ES_Framework.h"
+
+#if defined(TEST) && defined(ES_PORT_POSIX)
+// built on the host for the tickless idle test at the bottom: the SysTick
+// and NVIC registers are a model, and WFI lets the model's clock run
+static volatile uint32_t *TestReg(uint32_t Address);
+static void TestWFI(void);
+#undef HWREG
+#define HWREG(x) (*TestReg(x))
+#define __wfi() TestWFI()
+#endif
 
 #define UART_PORT 0
 #define UART_BAUD 115200UL
@@ -64,6 +77,13 @@
 // Needed for debug port access
 #define ALL_BITS (0xff << 2)
 
+// the DWT cycle counter, TivaWare does not define these
+#define DEMCR       HWREG(0xE000EDFC)
+#define DWT_CTRL    HWREG(0xE0001000)
+#define DWT_CYCCNT  HWREG(0xE0001004)
+#define DEMCR_TRCENA        BIT24HI
+#define DWT_CTRL_CYCCNTENA  BIT0HI
+
 // TickCount is used to track the number of timer ints that have occurred
 // since the last check. It should really never be more than 1, but just to
 // be sure, we increment it in the interrupt response rather than simply
@@ -82,6 +102,13 @@ static volatile uint16_t SysTickCounter = 0;
 // doing EnterCritical/ExitCritical pairs
 uint32_t _PRIMASK_temp;
 
+#ifdef ES_TICKLESS_IDLE
+// number of SysTick counts in one tick, and the most ticks that will fit
+// in the 24 bit SysTick counter for one long sleep
+static uint32_t TickPeriod;
+static uint32_t MaxIdleTicks;
+#endif
+
 /****************************************************************************
  Function
      _HW_Timer_Init
@@ -101,6 +128,13 @@ uint32_t _PRIMASK_temp;
 ****************************************************************************/
 void _HW_Timer_Init(TimerRate_t Rate)
 {
+#ifdef ES_TICKLESS_IDLE
+  // SysTickPeriodSet loads Rate - 1, so a tick is Rate counts
+  TickPeriod = (uint32_t)Rate;
+  MaxIdleTicks = (NVIC_ST_RELOAD_M + 1) / TickPeriod;
+#endif
+  DEMCR |= DEMCR_TRCENA;  /* start the cycle counter */
+  DWT_CTRL |= DWT_CTRL_CYCCNTENA;
   SysTickPeriodSet(Rate); /* Set the SysTick Interrupt Rate */
   SysTickIntEnable();     /* Enable the SysTick Interrupt */
   SysTickEnable();        /* Enable SysTick */
@@ -186,6 +220,120 @@ bool _HW_Process_Pending_Ints(void)
   return true;  // always return true to allow loop test in ES_Run to proceed
 }
 
+#ifdef ES_TICKLESS_IDLE
+/****************************************************************************
+ Function
+     _HW_Idle
+ Parameters
+     none
+ Returns
+     none
+ Description
+     called by ES_Run when all of the queues are empty. Stretches the
+     current SysTick period out to the next timer expiry and sleeps (WFI)
+     until then, or until some other interrupt wakes us. On the way out
+     SysTickCounter and the timers are brought up to date with the ticks
+     that were skipped, and SysTick is set to finish the tick that we are
+     part way through, then go back to normal periods.
+ Notes
+     SysTick is stopped for a few instructions while it is re-programmed,
+     so time drifts by that much per sleep.
+     The event checkers only run when we wake, so this is only suitable for
+     applications whose events come from interrupts and timers.
+ Author
+     10/17/26
+****************************************************************************/
+void _HW_Idle(void)
+{
+  uint32_t Ticks2Sleep;
+  uint32_t FirstTick;
+  uint32_t SleepCounts;
+  uint32_t Elapsed;
+  uint32_t Remainder;
+  uint32_t SkippedTicks;
+
+  EnterCritical();
+  Ticks2Sleep = ES_Timer_GetTicksToNextExpiry();
+  if (Ticks2Sleep > MaxIdleTicks)
+  {
+    Ticks2Sleep = MaxIdleTicks;
+  }
+  // not worth it for 1 tick, and an ISR may have posted or ticked since
+  // ES_Run found everything empty
+  if ((Ticks2Sleep < 2) || (TickCount != 0) || (ES_IsIdle() == false))
+  {
+    ExitCritical();
+    return;
+  }
+  HWREG(NVIC_ST_CTRL) &= ~NVIC_ST_CTRL_ENABLE;
+  // with SysTick stopped, make sure that a tick did not just end
+  if (HWREG(NVIC_INT_CTRL) & NVIC_INT_CTRL_PENDSTSET)
+  {
+    HWREG(NVIC_ST_CTRL) |= NVIC_ST_CTRL_ENABLE;
+    ExitCritical();
+    return;
+  }
+  // what is left of this tick, plus all but the last of the ticks to skip,
+  // the interrupt at the end of the last one wakes us
+  FirstTick = HWREG(NVIC_ST_CURRENT);
+  if (FirstTick == 0)
+  {
+    // the clock between the end of a tick and the reload, a whole tick is
+    // still to go
+    FirstTick = TickPeriod;
+  }
+  SleepCounts = FirstTick + ((Ticks2Sleep - 1) * TickPeriod);
+  HWREG(NVIC_ST_RELOAD) = SleepCounts - 1;
+  HWREG(NVIC_ST_CURRENT) = 0;   // reload from the long period
+  HWREG(NVIC_ST_CTRL) |= NVIC_ST_CTRL_ENABLE;
+  HWREG(NVIC_ST_RELOAD) = TickPeriod - 1;  // used from the next reload
+
+  __wfi();    // interrupts are masked, but any of them will wake us
+
+  HWREG(NVIC_ST_CTRL) &= ~NVIC_ST_CTRL_ENABLE;
+  if (HWREG(NVIC_INT_CTRL) & NVIC_INT_CTRL_PENDSTSET)
+  {
+    // slept all the way, SysTickIntHandler will count the last tick as soon
+    // as we unmask and SysTick has already reloaded with the normal period
+    SkippedTicks = Ticks2Sleep - 1;
+    HWREG(NVIC_ST_CTRL) |= NVIC_ST_CTRL_ENABLE;
+  }
+  else
+  {
+    // woken early, count the ticks that went by, then set up to finish the
+    // tick that we are part way through
+    Elapsed = SleepCounts - HWREG(NVIC_ST_CURRENT);
+    if (Elapsed < FirstTick)
+    {
+      SkippedTicks = 0;
+      Remainder = FirstTick - Elapsed;
+    }
+    else
+    {
+      SkippedTicks = 1 + ((Elapsed - FirstTick) / TickPeriod);
+      Remainder = TickPeriod - ((Elapsed - FirstTick) % TickPeriod);
+    }
+    // SysTick never counts down from a reload of 0, so rather than finish
+    // a tick with 1 count left, count that tick now and run on to the end
+    // of the next one
+    if (Remainder < 2)
+    {
+      SkippedTicks++;
+      Remainder += TickPeriod;
+    }
+    HWREG(NVIC_ST_RELOAD) = Remainder - 1;
+    HWREG(NVIC_ST_CURRENT) = 0;
+    HWREG(NVIC_ST_CTRL) |= NVIC_ST_CTRL_ENABLE;
+    HWREG(NVIC_ST_RELOAD) = TickPeriod - 1;
+  }
+  SysTickCounter += SkippedTicks;   // keep ES_Timer_GetTime monotonic
+  ExitCritical();
+  // now let the timers catch up, outside of the critical region since
+  // timeouts may be posted
+  ES_Timer_AdvanceTicks(SkippedTicks);
+}
+
+#endif
 /****************************************************************************
  Function
      ConsoleInit
@@ -220,6 +368,46 @@ void ConsoleInit(void)
   UARTStdioConfig(UART_PORT, UART_BAUD, SRC_CLK_FREQ);
 }
 
+/****************************************************************************
+ Function
+     _HW_GetActiveInterrupt
+ Parameters
+     none
+ Returns
+     uint8_t, the exception number being serviced, 0 if in thread mode
+ Description
+     reads VECTACTIVE from the interrupt control register. Subtract 16 from
+     the number to get the interrupt number in the TivaWare INT_ list
+ Notes
+
+ Author
+     10/17/26 15:02
+ ****************************************************************************/
+uint8_t _HW_GetActiveInterrupt(void)
+{
+  return (uint8_t)(HWREG(NVIC_INT_CTRL) & NVIC_INT_CTRL_VEC_ACT_M);
+}
+
+/****************************************************************************
+ Function
+     _HW_GetCycleCount
+ Parameters
+     none
+ Returns
+     uint32_t, the DWT cycle counter, ES_CYCLES_PER_US counts per uS
+ Description
+     a free running clock for timing things that are much shorter than a
+     tick. Wraps every 107 seconds at 40MHz
+ Notes
+     started by _HW_Timer_Init
+ Author
+     10/17/26 16:20
+ ****************************************************************************/
+uint32_t _HW_GetCycleCount(void)
+{
+  return DWT_CYCCNT;
+}
+
 #if defined(rvmdk) || defined(__ARMCC_VERSION)
 uint32_t CPUgetPRIMASK_cpsid(void)
 {
@@ -345,3 +533,312 @@ void _HW_DebugClearLine2(void)
 {
   HWREG(DEBUG_PORT + (GPIO_O_DATA + ALL_BITS)) &= ~DEBUG_LINE_2;
 }
+
+#if defined(TEST) && defined(ES_PORT_POSIX)
+/*
+  Host test of the tickless _HW_Idle, built on the host with a model of
+  SysTick and of the pending bit in NVIC_INT_CTRL in place of the
+  registers. The model counts down one clock at a time as the Cortex-M4
+  does: a write to CURRENT clears it, the next clock loads RELOAD and the
+  clock that takes it to 0 pends the SysTick interrupt, which is taken as
+  soon as PRIMASK is cleared. WFI runs the clock until the interrupt is
+  pending, or stops it early, at a random point or around a tick boundary,
+  to stand in for some other interrupt waking the processor. A second,
+  untouched SysTick running at the tick rate from the same start is the
+  reference: after every sleep, the ticks counted by the timers (tick
+  responses plus the ticks skipped) must be the ticks that the reference
+  has seen, and so must SysTickCounter, which ES_Timer_GetTime returns, so
+  no tick is lost or counted twice and the ticks do not drift.
+  The timers are a stand-in with one timer that is restarted for a random
+  time, up to a few sleeps long, whenever it expires. Build with:
+  gcc -O2 -DTEST -DES_PORT_POSIX -DES_TICKLESS_IDLE -I<app headers>
+      -IHeaders -I$TIVAWARE Source/ES_Port.c
+*/
+#include <stdio.h>
+
+#define NUM_TEST_SLEEPS 200000u
+#define TEST_RATE ES_Timer_RATE_1mS
+
+static uint32_t Regs[4];        // CTRL, RELOAD, CURRENT, INT_CTRL
+static uint32_t OtherReg;       // everything else reads & writes here
+static bool     Masked;         // PRIMASK
+static bool     WasEnabled;     // SysTick, at the last register access
+static uint32_t RefCurrent;     // the reference SysTick
+static uint32_t RefTicks;
+static uint32_t TimerTicks;     // the ticks the timers have been told of
+static uint32_t NextExpiry;
+static uint32_t NumExpiries;
+static uint32_t NumWakeups;
+static uint32_t NumEarly;
+static uint32_t Errors;
+static uint32_t Seed = 12345u;
+
+static uint32_t Advance(uint32_t NumClocks);
+
+static uint32_t Random(void)
+{
+  Seed = Seed * 1103515245u + 12345u;
+  return Seed >> 8;
+}
+
+static volatile uint32_t *TestReg(uint32_t Address)
+{
+  // an instruction or so goes by between register accesses, which matters
+  // just after SysTick is enabled from 0: the first clock loads RELOAD, so
+  // a RELOAD written after the enable is only used from the next reload
+  if ((Regs[0] & NVIC_ST_CTRL_ENABLE) && !WasEnabled)
+  {
+    Advance(1);
+  }
+  WasEnabled = (Regs[0] & NVIC_ST_CTRL_ENABLE) != 0;
+  switch (Address)
+  {
+    case NVIC_ST_CTRL:
+      return &Regs[0];
+    case NVIC_ST_RELOAD:
+      return &Regs[1];
+    case NVIC_ST_CURRENT:
+      return &Regs[2];
+    case NVIC_INT_CTRL:
+      return &Regs[3];
+    default:
+      return &OtherReg;
+  }
+}
+
+// take the SysTick interrupt if it is pending and interrupts are enabled
+static void TakeInterrupt(void)
+{
+  if (!Masked && (Regs[3] & NVIC_INT_CTRL_PENDSTSET))
+  {
+    Regs[3] &= ~NVIC_INT_CTRL_PENDSTSET;
+    NumWakeups++;
+    SysTickIntHandler();
+  }
+}
+
+// clocks until the model SysTick next pends, if it is running
+static uint32_t ClocksToPend(void)
+{
+  if ((Regs[0] & NVIC_ST_CTRL_ENABLE) == 0)
+  {
+    return UINT32_MAX;
+  }
+  // from 0, the first clock only loads RELOAD
+  return (Regs[2] == 0) ? Regs[1] + 1 : Regs[2];
+}
+
+// run both SysTicks for NumClocks, no further than the model's next pend,
+// returns how many clocks went by
+static uint32_t Advance(uint32_t NumClocks)
+{
+  uint32_t Step = ClocksToPend();
+  uint32_t Left;
+
+  if (Step > NumClocks)
+  {
+    Step = NumClocks;
+  }
+  if (Regs[0] & NVIC_ST_CTRL_ENABLE)
+  {
+    Left = Step;
+    if ((Regs[2] == 0) && (Left > 0))
+    {
+      Regs[2] = Regs[1];
+      Left--;
+    }
+    Regs[2] -= Left;
+    if ((Left > 0) && (Regs[2] == 0))
+    {
+      Regs[3] |= NVIC_INT_CTRL_PENDSTSET;
+    }
+  }
+  if (Step >= RefCurrent)
+  {
+    RefTicks += 1 + (Step - RefCurrent) / TEST_RATE;
+    RefCurrent = TEST_RATE - ((Step - RefCurrent) % TEST_RATE);
+  }
+  else
+  {
+    RefCurrent -= Step;
+  }
+  return Step;
+}
+
+// let NumClocks go by with the framework busy and interrupts enabled
+static void Run(uint32_t NumClocks)
+{
+  while (NumClocks > 0)
+  {
+    NumClocks -= Advance(NumClocks);
+    TakeInterrupt();
+  }
+}
+
+static void TestWFI(void)
+{
+  uint32_t ToPend = ClocksToPend();
+  uint32_t WakeAfter = ToPend;
+
+  switch (Random() % 4u)
+  {
+    case 0:
+    {
+      // woken at a random point
+      WakeAfter = 1 + Random() % ToPend;
+    }
+    break;
+    case 1:
+    {
+      // woken within a couple of clocks of a tick boundary, the awkward
+      // cases for working out how many ticks went by
+      WakeAfter = RefCurrent + (Random() % 4u) * TEST_RATE + Random() % 5u;
+      WakeAfter = (WakeAfter > 2) ? WakeAfter - 2 : 1;
+    }
+    break;
+    default:
+      break;
+  }
+  if (WakeAfter < ToPend)
+  {
+    NumEarly++;
+    Advance(WakeAfter);
+  }
+  else
+  {
+    Advance(ToPend);
+  }
+}
+
+uint32_t CPUgetPRIMASK_cpsid(void)
+{
+  uint32_t Old = Masked;
+  Masked = true;
+  return Old;
+}
+
+void CPUsetPRIMASK(uint32_t newPRIMASK)
+{
+  Masked = (newPRIMASK != 0);
+  TakeInterrupt();
+}
+
+// the TivaWare calls made by _HW_Timer_Init, SysTickPeriodSet loads one
+// less than the period, as the real one does
+void SysTickPeriodSet(uint32_t ui32Period)
+{
+  Regs[1] = ui32Period - 1;
+}
+
+void SysTickIntEnable(void)
+{
+}
+
+void SysTickEnable(void)
+{
+  Regs[0] |= NVIC_ST_CTRL_ENABLE;
+}
+
+bool IntMasterEnable(void)
+{
+  Masked = false;
+  return false;
+}
+
+// and by ConsoleInit, which is not called
+void SysCtlPeripheralEnable(uint32_t ui32Peripheral)
+{
+  (void)ui32Peripheral;
+}
+
+void GPIOPinConfigure(uint32_t ui32PinConfig)
+{
+  (void)ui32PinConfig;
+}
+
+void GPIOPinTypeUART(uint32_t ui32Port, uint8_t ui8Pins)
+{
+  (void)ui32Port;
+  (void)ui8Pins;
+}
+
+void UARTClockSourceSet(uint32_t ui32Base, uint32_t ui32Source)
+{
+  (void)ui32Base;
+  (void)ui32Source;
+}
+
+void UARTStdioConfig(uint32_t ui32Port, uint32_t ui32Baud,
+    uint32_t ui32SrcClock)
+{
+  (void)ui32Port;
+  (void)ui32Baud;
+  (void)ui32SrcClock;
+}
+
+// a stand-in for the timers, with one timer running
+uint32_t ES_Timer_GetTicksToNextExpiry(void)
+{
+  return NextExpiry - TimerTicks;
+}
+
+static void TimerTick(void)
+{
+  TimerTicks++;
+  if (TimerTicks == NextExpiry)
+  {
+    NumExpiries++;
+    NextExpiry = TimerTicks + 1 + Random() % 1500u;
+  }
+}
+
+void ES_Timer_Tick_Resp(void)
+{
+  TimerTick();
+}
+
+void ES_Timer_AdvanceTicks(uint32_t Ticks)
+{
+  while (Ticks-- > 0)
+  {
+    TimerTick();
+  }
+}
+
+bool ES_IsIdle(void)
+{
+  return true;
+}
+
+int main(void)
+{
+  uint32_t Sleep;
+
+  puts("Testing the tickless _HW_Idle against a SysTick model");
+  RefCurrent = TEST_RATE;
+  _HW_Timer_Init(TEST_RATE);
+  NextExpiry = 1 + Random() % 1500u;
+  for (Sleep = 0; Sleep < NUM_TEST_SLEEPS; Sleep++)
+  {
+    // busy for a while, from a few clocks to a few ticks
+    Run(1 + Random() % (3u * TEST_RATE));
+    _HW_Process_Pending_Ints();
+    _HW_Idle();
+    _HW_Process_Pending_Ints();
+    if ((TimerTicks != RefTicks) || (_HW_GetTickCount() != (uint16_t)RefTicks))
+    {
+      if (Errors < 10)
+      {
+        printf("sleep %u: %u ticks, timers saw %u, tick count %u\n", Sleep,
+            RefTicks, TimerTicks, _HW_GetTickCount());
+      }
+      Errors++;
+    }
+  }
+  printf("%u sleeps, %u cut short, %u ticks, %u tick interrupts, "
+      "%u expiries\n", NUM_TEST_SLEEPS, NumEarly, RefTicks, NumWakeups,
+      NumExpiries);
+  printf("%u errors\n", Errors);
+  return Errors != 0;
+}
+#endif /* TEST && ES_PORT_POSIX */
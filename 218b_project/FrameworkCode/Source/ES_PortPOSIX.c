@@ -0,0 +1,618 @@
+/****************************************************************************
+ Module
+   ES_PortPOSIX.c
+
+ Revision
+   1.0.1
+
+ Description
+   Host (Linux/POSIX) port of the Events & Services Framework. It implements
+   the same ES_Port.h surface as the TM4C123G port in ES_Port.c so that the
+   unmodified framework (ES_Framework.c, ES_Timers.c, ES_Queue.c ...) and any
+   hardware independent services can be run, profiled and tested on a
+   workstation.
+
+ Notes
+   Compile this file *instead of* ES_Port.c and define ES_PORT_POSIX, e.g.
+
+     gcc -DES_PORT_POSIX -I Headers Source/ES_PortPOSIX.c
+         Source/ES_Framework.c Source/ES_Timers.c Source/ES_Queue.c
+         Source/ES_LookupTables.c Source/ES_PostList.c Source/ES_CheckEvents.c
+         Source/ES_DeferRecall.c <host main & services> -lpthread
+
+   with an ES_Configure.h that names services that do not touch the Tiva
+   registers. ES_ShortTimer.c, termio.c, uartstdio.c and retarget.c are
+   TivaWare specific and stay out of a host build.
+
+   There are two clocks, chosen with _HW_SelectClock() before ES_Initialize:
+   HW_CLOCK_WALL     a thread blocks on a timerfd programmed to the tick rate
+                     and runs SysTickIntHandler as an 'interrupt', so the
+                     framework runs in real time just as it does on the Tiva.
+   HW_CLOCK_VIRTUAL  no threads. Time only moves when ES_Run goes idle and
+                     then it moves straight to the next tick, so time spent
+                     waiting on timers costs nothing and an hour of game
+                     replays in milliseconds. Runs are fully deterministic.
+
+   'Interrupt context' is emulated with a mutex that plays the part of
+   PRIMASK: EnterCritical takes it, the tick thread and _HW_RaiseInterrupt
+   hold it while they run an interrupt response. A thread that already holds
+   it sees interrupts as disabled, so posting from a simulated ISR works just
+   like it does on the target.
+
+   With ES_TICKLESS_IDLE defined in ES_Configure.h, the virtual clock jumps
+   straight to the next timer expiry when ES_Run goes idle, rather than
+   delivering every tick, just as the Tiva port sleeps through them. The
+   tick hook is only called on the ticks that are delivered.
+
+   _HW_RunFor wraps ES_Run so a test can run the framework for a fixed number
+   of ticks. It leaves ES_Run with a longjmp from _HW_Process_Pending_Ints,
+   which is only called between run functions, so no service is ever left
+   part way through an event.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 09:40         started coding, based on ES_Port.c for the TM4C123G
+ ***************************************************************************/
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <setjmp.h>
+#include <pthread.h>
+#include <poll.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/timerfd.h>
+
+#include "ES_Configure.h"
+#include "ES_Port.h"
+#include "ES_Types.h"
+#include "ES_Timers.h"
+#include "ES_Framework.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// the TimerRate_t values are SysTick reload values for a 40MHz clock, so
+// each count is 25nS
+#define NS_PER_SYSTICK_COUNT 25ULL
+#define NS_PER_SECOND 1000000000ULL
+
+/*---------------------------- Module Functions ---------------------------*/
+void SysTickIntHandler(void);
+static void *TickThread(void *pUnused);
+static void VirtualTick(void);
+
+/*---------------------------- Module Variables ---------------------------*/
+// TickCount & SysTickCounter serve the same purpose as in ES_Port.c, they
+// are written in 'interrupt context' and read from ES_Run
+static volatile uint8_t   TickCount;
+static volatile uint16_t  SysTickCounter = 0;
+// 32 bit version of SysTickCounter for long simulations
+static volatile uint32_t  ElapsedTicks = 0;
+
+// This variable is used to store the state of the interrupt mask when
+// doing EnterCritical/ExitCritical pairs
+uint32_t _PRIMASK_temp;
+
+// the lock that stands in for PRIMASK & the flag that tells a thread if it
+// is the one holding it
+static pthread_mutex_t  IntLock = PTHREAD_MUTEX_INITIALIZER;
+static __thread bool    IntsMasked = false;
+// set while a thread is running an interrupt response
+static __thread bool    InInterrupt = false;
+
+static HWClock_t  WhichClock = HW_CLOCK_WALL;
+static TimerRate_t  TickRate = ES_Timer_RATE_OFF;
+static pthread_t  TickThreadID;
+static int        TickFD = -1;
+
+static void (*pTickHook)(uint32_t Now) = NULL;
+
+// used by _HW_RunFor to get back out of ES_Run
+static jmp_buf  RunForReturn;
+static bool     RunForActive = false;
+static uint32_t RunForEndTick;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     _HW_SelectClock
+ Parameters
+     HWClock_t WhichClock, HW_CLOCK_WALL or HW_CLOCK_VIRTUAL
+ Returns
+     None.
+ Description
+     chooses the time source used by _HW_Timer_Init
+ Notes
+     must be called before ES_Initialize, the default is HW_CLOCK_WALL
+ Author
+     10/17/26 09:52
+****************************************************************************/
+void _HW_SelectClock(HWClock_t NewClock)
+{
+  WhichClock = NewClock;
+}
+
+/****************************************************************************
+ Function
+     _HW_Timer_Init
+ Parameters
+     TimerRate_t Rate set to one of the ES_Timer_RATE_XX values to set the
+     Tick rate
+ Returns
+     None.
+ Description
+     In wall clock mode, programs a timerfd for the requested rate and starts
+     the thread that turns its expirations into tick interrupts. In virtual
+     mode there is nothing to start, ticks are generated from _HW_Idle.
+ Notes
+
+ Author
+     10/17/26 09:55
+****************************************************************************/
+void _HW_Timer_Init(TimerRate_t Rate)
+{
+  struct itimerspec Period;
+  uint64_t          PeriodNS;
+
+  TickRate = Rate;
+  if ((WhichClock == HW_CLOCK_VIRTUAL) || (Rate == ES_Timer_RATE_OFF))
+  {
+    return;
+  }
+  PeriodNS = ((uint64_t)Rate + 1) * NS_PER_SYSTICK_COUNT;
+  Period.it_interval.tv_sec = PeriodNS / NS_PER_SECOND;
+  Period.it_interval.tv_nsec = PeriodNS % NS_PER_SECOND;
+  Period.it_value = Period.it_interval;
+
+  TickFD = timerfd_create(CLOCK_MONOTONIC, 0);
+  if ((TickFD < 0) || (timerfd_settime(TickFD, 0, &Period, NULL) != 0))
+  {
+    perror("_HW_Timer_Init");
+    return;
+  }
+  pthread_create(&TickThreadID, NULL, TickThread, NULL);
+}
+
+/****************************************************************************
+ Function
+     SysTickIntHandler
+ Parameters
+     none
+ Returns
+     None.
+ Description
+     the tick 'interrupt' response. Identical to the one in ES_Port.c, it
+     only counts, the framework response is handled in
+     _HW_Process_Pending_Ints
+ Notes
+     always called holding IntLock, from TickThread or VirtualTick
+ Author
+     10/17/26 10:02
+****************************************************************************/
+void SysTickIntHandler(void)
+{
+  ++TickCount;          /* flag that it occurred and needs a response */
+  ++SysTickCounter;     // keep the free running time going
+  ++ElapsedTicks;
+  if (pTickHook != NULL)
+  {
+    pTickHook(ElapsedTicks);
+  }
+}
+
+/****************************************************************************
+ Function
+    _HW_GetTickCount()
+ Parameters
+    none
+ Returns
+    uint16_t   count of number of system ticks that have occurred.
+ Description
+    wrapper for access to SysTickCounter
+ Notes
+
+ Author
+    10/17/26 10:04
+****************************************************************************/
+uint16_t _HW_GetTickCount(void)
+{
+  return __atomic_load_n(&SysTickCounter, __ATOMIC_ACQUIRE);
+}
+
+/****************************************************************************
+ Function
+    _HW_GetElapsedTicks()
+ Parameters
+    none
+ Returns
+    uint32_t   count of ticks since the start of the run
+ Description
+    same as _HW_GetTickCount, but wide enough for long simulations
+ Notes
+
+ Author
+    10/17/26 10:05
+****************************************************************************/
+uint32_t _HW_GetElapsedTicks(void)
+{
+  return __atomic_load_n(&ElapsedTicks, __ATOMIC_ACQUIRE);
+}
+
+/****************************************************************************
+ Function
+     _HW_Process_Pending_Ints
+ Parameters
+     none
+ Returns
+     always true.
+ Description
+     runs the framework tick response once for every tick that has occurred
+     since the last call, then, if _HW_RunFor's time is up, leaves ES_Run
+ Notes
+     the ticks are claimed in one atomic swap so that the tick thread can
+     keep counting while we process them
+ Author
+     10/17/26 10:08
+****************************************************************************/
+bool _HW_Process_Pending_Ints(void)
+{
+  uint8_t NumTicks;
+
+  NumTicks = __atomic_exchange_n(&TickCount, 0, __ATOMIC_ACQ_REL);
+  while (NumTicks > 0)
+  {
+    /* call the framework tick response to actually run the timers */
+    ES_Timer_Tick_Resp();
+    NumTicks--;
+  }
+  if (RunForActive &&
+      ((int32_t)(_HW_GetElapsedTicks() - RunForEndTick) >= 0))
+  {
+    longjmp(RunForReturn, 1);
+  }
+  return true;  // always return true to allow loop test in ES_Run to proceed
+}
+
+/****************************************************************************
+ Function
+     _HW_Idle
+ Parameters
+     none
+ Returns
+     none
+ Description
+     called by ES_Run when all of the queues are empty. In virtual time this
+     is where time passes: we skip straight to the next tick, or in tickless
+     mode, to the next timer expiry.
+ Notes
+     the skipped ticks are counted and the timers caught up without
+     running SysTickIntHandler, the last tick is delivered as an interrupt
+ Author
+     10/17/26 10:15
+****************************************************************************/
+void _HW_Idle(void)
+{
+#ifdef ES_TICKLESS_IDLE
+  uint32_t Ticks2Sleep;
+#endif
+
+  if (WhichClock != HW_CLOCK_VIRTUAL)
+  {
+    return;
+  }
+#ifdef ES_TICKLESS_IDLE
+  EnterCritical();
+  Ticks2Sleep = ES_Timer_GetTicksToNextExpiry();
+  // don't sleep past the end of a _HW_RunFor
+  if (RunForActive && (Ticks2Sleep > (RunForEndTick - ElapsedTicks)))
+  {
+    Ticks2Sleep = RunForEndTick - ElapsedTicks;
+  }
+  if ((Ticks2Sleep < 2) || (ES_IsIdle() == false))
+  {
+    Ticks2Sleep = 1;
+  }
+  SysTickCounter += Ticks2Sleep - 1;
+  ElapsedTicks += Ticks2Sleep - 1;
+  ExitCritical();
+  ES_Timer_AdvanceTicks(Ticks2Sleep - 1);
+#endif
+  VirtualTick();
+}
+
+/****************************************************************************
+ Function
+     _HW_RunFor
+ Parameters
+     uint32_t NumTicks, how long to let the framework run
+ Returns
+     bool, true if the time ran out, false if ES_Run returned on its own
+ Description
+     runs ES_Run for NumTicks ticks of framework time and then returns.
+     May be called repeatedly to step a simulation along.
+ Notes
+     ES_Initialize must already have been called
+ Author
+     10/17/26 10:20
+****************************************************************************/
+bool _HW_RunFor(uint32_t NumTicks)
+{
+  RunForEndTick = _HW_GetElapsedTicks() + NumTicks;
+  RunForActive = true;
+  if (setjmp(RunForReturn) == 0)
+  {
+    ES_Run(); // only comes back on an error
+    RunForActive = false;
+    return false;
+  }
+  RunForActive = false;
+  return true;
+}
+
+/****************************************************************************
+ Function
+     _HW_RaiseInterrupt
+ Parameters
+     void (*pISR)(void), the interrupt response routine to run
+ Returns
+     none
+ Description
+     runs pISR in 'interrupt context': it waits until no critical region,
+     tick or other simulated interrupt is running and holds them off while
+     pISR runs. Safe to call from any thread.
+ Notes
+     if the caller is already in interrupt context pISR is simply called
+ Author
+     10/17/26 10:24
+****************************************************************************/
+void _HW_RaiseInterrupt(void (*pISR)(void))
+{
+  bool WasInInterrupt = InInterrupt;
+
+  if (IntsMasked)
+  {
+    InInterrupt = true;
+    pISR();
+    InInterrupt = WasInInterrupt;
+    return;
+  }
+  pthread_mutex_lock(&IntLock);
+  IntsMasked = true;
+  InInterrupt = true;
+  pISR();
+  InInterrupt = false;
+  IntsMasked = false;
+  pthread_mutex_unlock(&IntLock);
+}
+
+/****************************************************************************
+ Function
+     _HW_GetActiveInterrupt
+ Parameters
+     none
+ Returns
+     uint8_t, non-zero if called from an interrupt response
+ Description
+     host version, there are no exception numbers so every simulated
+     interrupt is reported as 1
+ Notes
+
+ Author
+     10/17/26 15:04
+****************************************************************************/
+uint8_t _HW_GetActiveInterrupt(void)
+{
+  return InInterrupt ? 1 : 0;
+}
+
+/****************************************************************************
+ Function
+     _HW_GetCycleCount
+ Parameters
+     none
+ Returns
+     uint32_t, nanoseconds from CLOCK_MONOTONIC, wraps every 4.3 seconds
+ Description
+     host stand-in for the DWT cycle counter, ES_CYCLES_PER_US is 1000 here
+ Notes
+     always real time, it does not follow the virtual clock
+ Author
+     10/17/26 16:24
+****************************************************************************/
+uint32_t _HW_GetCycleCount(void)
+{
+  struct timespec Now;
+
+  clock_gettime(CLOCK_MONOTONIC, &Now);
+  return (uint32_t)(Now.tv_sec * NS_PER_SECOND + Now.tv_nsec);
+}
+
+/****************************************************************************
+ Function
+     _HW_SetTickHook
+ Parameters
+     void (*pHook)(uint32_t Now), function to call on every tick, NULL for none
+ Returns
+     none
+ Description
+     lets a simulation inject stimulus (e.g. raise a sensor interrupt) at
+     a known time. The hook is called in interrupt context.
+ Notes
+
+ Author
+     10/17/26 10:26
+****************************************************************************/
+void _HW_SetTickHook(void (*pHook)(uint32_t Now))
+{
+  pTickHook = pHook;
+}
+
+/****************************************************************************
+ Function
+     ConsoleInit
+ Parameters
+     none
+ Returns
+     none.
+ Description
+     the console is the terminal that we were started from, just make sure
+     that output is not held back in a buffer
+ Notes
+
+ Author
+     10/17/26 10:28
+ ****************************************************************************/
+void ConsoleInit(void)
+{
+  setvbuf(stdout, NULL, _IONBF, 0);
+}
+
+/****************************************************************************
+ Function
+     kbhit
+ Parameters
+     none
+ Returns
+     int, non-zero if a character is waiting on stdin
+ Description
+     host version of the termio function used by IsNewKeyReady()
+ Notes
+
+ Author
+     10/17/26 10:29
+ ****************************************************************************/
+int kbhit(void)
+{
+  struct pollfd StdIn = { STDIN_FILENO, POLLIN, 0 };
+  return poll(&StdIn, 1, 0) > 0;
+}
+
+/****************************************************************************
+ Function
+     CPUgetPRIMASK_cpsid
+ Parameters
+     none
+ Returns
+     uint32_t, 1 if 'interrupts' were already disabled, 0 if not
+ Description
+     host version of the PRIMASK read & disable used by EnterCritical
+ Notes
+
+ Author
+     10/17/26 10:31
+ ****************************************************************************/
+uint32_t CPUgetPRIMASK_cpsid(void)
+{
+  if (IntsMasked)
+  {
+    return 1;
+  }
+  pthread_mutex_lock(&IntLock);
+  IntsMasked = true;
+  return 0;
+}
+
+/****************************************************************************
+ Function
+     CPUsetPRIMASK
+ Parameters
+     uint32_t newPRIMASK, 0 to enable 'interrupts', 1 to disable them
+ Returns
+     none
+ Description
+     host version of the PRIMASK restore used by ExitCritical
+ Notes
+
+ Author
+     10/17/26 10:33
+ ****************************************************************************/
+void CPUsetPRIMASK(uint32_t newPRIMASK)
+{
+  if ((newPRIMASK == 0) && IntsMasked)
+  {
+    IntsMasked = false;
+    pthread_mutex_unlock(&IntLock);
+  }
+  else if ((newPRIMASK != 0) && !IntsMasked)
+  {
+    pthread_mutex_lock(&IntLock);
+    IntsMasked = true;
+  }
+}
+
+// there are no debug lines on the host, keep the framework happy
+void _HW_DebugLines_Init(void)
+{}
+
+void _HW_DebugSetLine1(void)
+{}
+
+void _HW_DebugClearLine1(void)
+{}
+
+void _HW_DebugSetLine2(void)
+{}
+
+void _HW_DebugClearLine2(void)
+{}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+/****************************************************************************
+ Function
+     TickThread
+ Parameters
+     void * unused
+ Returns
+     never
+ Description
+     waits on the timerfd and delivers one tick interrupt per expiration.
+     If we fall behind, the missed ticks are delivered back to back, just
+     as TickCount would pile up on the Tiva.
+ Notes
+
+ Author
+     10/17/26 10:40
+****************************************************************************/
+static void *TickThread(void *pUnused)
+{
+  uint64_t Expirations;
+
+  (void)pUnused;
+  while (read(TickFD, &Expirations, sizeof(Expirations)) ==
+      sizeof(Expirations))
+  {
+    while (Expirations-- > 0)
+    {
+      _HW_RaiseInterrupt(SysTickIntHandler);
+    }
+  }
+  return NULL;
+}
+
+/****************************************************************************
+ Function
+     VirtualTick
+ Parameters
+     none
+ Returns
+     none
+ Description
+     delivers the next tick interrupt in virtual time
+ Notes
+
+ Author
+     10/17/26 10:44
+****************************************************************************/
+static void VirtualTick(void)
+{
+  if (TickRate != ES_Timer_RATE_OFF)
+  {
+    _HW_RaiseInterrupt(SysTickIntHandler);
+  }
+}
+
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
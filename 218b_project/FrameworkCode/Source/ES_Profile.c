@@ -0,0 +1,397 @@
+/****************************************************************************
+ Module
+     ES_Profile.c
+ Description
+     optional profiler for the dispatch loop in ES_Run. For every service &
+     event type pair it keeps the number of dispatches, the time spent in the
+     run function and the time the event sat in the queue between the post
+     and the dispatch, as totals, maxima and log2 histograms.
+ Notes
+     Only compiled when ES_PROFILE is defined in ES_Configure.h. The tables
+     take about 100 bytes per service per event type, so check the RAM
+     before turning it on with a lot of services.
+
+     Times come from _HW_GetCycleCount, the CPU clock on the Tiva and
+     nanoseconds on the host. Run function times include any interrupts
+     that happened while it was running.
+
+     The queue wait is measured with a ring of post time stamps per service
+     that shadows the event queue. The post functions stamp an event in
+     the same critical region as they queue it, so a post from an
+     interrupt can not land in between and swap the two stamps.
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 14:10         started coding
+*****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Configure.h"
+#include "ES_Profile.h"
+#include "ES_Bus.h"
+
+#ifdef ES_PROFILE
+
+#include "ES_General.h"
+#include "ES_Port.h"
+#include "ES_LookupTables.h"
+#include <stdio.h>
+#include <string.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+#define HIST_MAX 0xFFFF
+
+typedef struct
+{
+  uint32_t  *pStamps;   // post time of each event in the service's queue
+  uint8_t   Size;
+  uint8_t   First;
+  uint8_t   Count;
+}StampRing_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+static void AddToHist(uint16_t *pHist, uint32_t Time);
+static void PrintHist(char const *pLabel, uint16_t const *pHist);
+
+/*---------------------------- Module Variables ---------------------------*/
+// one time stamp ring per service, the same size as its event queue plus
+// the bus, if there is one
+#define STAMP_ENTRY(Init, Run, QueueSize, Kind) \
+  static uint32_t Stamps_##Run[(QueueSize) + ES_BUS_SLOTS];
+
+SERVICE_LIST(STAMP_ENTRY)
+
+#define RING_ENTRY(Init, Run, QueueSize, Kind) \
+  { Stamps_##Run, ARRAY_SIZE(Stamps_##Run), 0, 0 },
+
+static StampRing_t StampRings[NUM_SERVICES] = {
+  SERVICE_LIST(RING_ENTRY)
+};
+
+// names for the dump, taken from the run functions
+#define NAME_ENTRY(Init, Run, QueueSize, Kind) #Run,
+
+static char const *const ServiceNames[NUM_SERVICES] = {
+  SERVICE_LIST(NAME_ENTRY)
+};
+
+static ES_ProfileStats_t Stats[NUM_SERVICES][NUM_EVENT_TYPES];
+
+// the dispatch in progress, ES_Run is never re-entered so one is enough
+static ES_ProfileStats_t  *pCurrent;
+static uint32_t           RunStart;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+   ES_Profile_Init
+ Parameters
+   None
+ Returns
+   None
+ Description
+   clears all of the statistics & time stamps
+ Notes
+   called by ES_Initialize before any of the services are initialized, the
+   timers (and so the cycle counter) have been started by then
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Profile_Init(void)
+{
+  ES_Profile_Reset();
+}
+
+/****************************************************************************
+ Function
+   ES_Profile_Reset
+ Parameters
+   None
+ Returns
+   None
+ Description
+   clears the statistics, the time stamps of events that are still in the
+   queues are kept so that their waits come out right
+ Notes
+
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Profile_Reset(void)
+{
+  memset(Stats, 0, sizeof(Stats));
+  pCurrent = NULL;
+}
+
+/****************************************************************************
+ Function
+   ES_Profile_Posted
+ Parameters
+   uint8_t : which service was just posted to
+   bool : true if the event went to the front of the queue (LIFO)
+ Returns
+   None
+ Description
+   records the time that an event went into a service's queue
+ Notes
+   called from the framework post functions after a successful enqueue,
+   in the same critical region, so that the stamp lines up with the queue
+   slot. The ring update still saves its own PRIMASK so that it is safe
+   to call on its own.
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Profile_Posted(uint8_t WhichService, bool AtFront)
+{
+  StampRing_t *pRing = &StampRings[WhichService];
+  uint32_t    Now = _HW_GetCycleCount();
+  uint32_t    SavedPRIMASK;
+  uint8_t     Index;
+
+  SavedPRIMASK = CPUgetPRIMASK_cpsid();
+  if (pRing->Count < pRing->Size)
+  {
+    if (AtFront)
+    {
+      pRing->First = (pRing->First == 0) ? (pRing->Size - 1) :
+          (pRing->First - 1);
+      Index = pRing->First;
+    }
+    else
+    {
+      Index = pRing->First + pRing->Count;
+      if (Index >= pRing->Size)
+      {
+        Index -= pRing->Size;
+      }
+    }
+    pRing->pStamps[Index] = Now;
+    pRing->Count++;
+  }
+  CPUsetPRIMASK(SavedPRIMASK);
+}
+
+/****************************************************************************
+ Function
+   ES_Profile_BeginRun
+ Parameters
+   uint8_t : the service that is about to run
+   ES_EventType_t : the type of the event it was given
+ Returns
+   None
+ Description
+   takes the post time stamp of the event that was just removed from the
+   queue, records the wait, and starts timing the run function
+ Notes
+   called by ES_Run after the DeQueue, just before the run function
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Profile_BeginRun(uint8_t WhichService, ES_EventType_t WhichEvent)
+{
+  StampRing_t *pRing = &StampRings[WhichService];
+  uint32_t    Now = _HW_GetCycleCount();
+  uint32_t    Wait = 0;
+  uint32_t    SavedPRIMASK;
+
+  SavedPRIMASK = CPUgetPRIMASK_cpsid();
+  if (pRing->Count > 0)
+  {
+    Wait = Now - pRing->pStamps[pRing->First];
+    if (++pRing->First >= pRing->Size)
+    {
+      pRing->First = 0;
+    }
+    pRing->Count--;
+  }
+  CPUsetPRIMASK(SavedPRIMASK);
+
+  if ((uint16_t)WhichEvent >= NUM_EVENT_TYPES)
+  {
+    pCurrent = NULL;  // not one that we have room for
+    return;
+  }
+  pCurrent = &Stats[WhichService][WhichEvent];
+  pCurrent->Count++;
+  pCurrent->WaitTotal += Wait;
+  if (Wait > pCurrent->WaitMax)
+  {
+    pCurrent->WaitMax = Wait;
+  }
+  AddToHist(pCurrent->WaitHist, Wait);
+  // start timing as late as possible, so our own work is not counted
+  RunStart = _HW_GetCycleCount();
+}
+
+/****************************************************************************
+ Function
+   ES_Profile_EndRun
+ Parameters
+   None
+ Returns
+   None
+ Description
+   records the time taken by the run function started by ES_Profile_BeginRun
+ Notes
+
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Profile_EndRun(void)
+{
+  uint32_t Exec = _HW_GetCycleCount() - RunStart;
+
+  if (pCurrent == NULL)
+  {
+    return;
+  }
+  pCurrent->ExecTotal += Exec;
+  if (Exec > pCurrent->ExecMax)
+  {
+    pCurrent->ExecMax = Exec;
+  }
+  AddToHist(pCurrent->ExecHist, Exec);
+  pCurrent = NULL;
+}
+
+/****************************************************************************
+ Function
+   ES_Profile_GetStats
+ Parameters
+   uint8_t : which service
+   ES_EventType_t : which event type
+ Returns
+   pointer to the statistics for that pair, NULL if either is out of range
+ Description
+   lets an application look at the raw numbers, times are in clock counts
+ Notes
+
+ Author
+   10/17/26
+****************************************************************************/
+ES_ProfileStats_t const *ES_Profile_GetStats(uint8_t WhichService,
+    ES_EventType_t WhichEvent)
+{
+  if ((WhichService >= NUM_SERVICES) ||
+      ((uint16_t)WhichEvent >= NUM_EVENT_TYPES))
+  {
+    return NULL;
+  }
+  return &Stats[WhichService][WhichEvent];
+}
+
+/****************************************************************************
+ Function
+   ES_Profile_Dump
+ Parameters
+   None
+ Returns
+   None
+ Description
+   prints a table of the statistics, one line for each service & event type
+   pair that has been dispatched, followed by its histograms. Times are in uS
+ Notes
+   goes out through printf, which is uartstdio on the Tiva. This takes a
+   long time, so call it from somewhere that can afford it, like a
+   keystroke handler
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Profile_Dump(void)
+{
+  uint8_t           Service;
+  uint16_t          Event;
+  ES_ProfileStats_t *pStats;
+
+  printf("\r\nES profile (uS), histogram bucket 0 is < %u nS, then x2\r\n",
+      (unsigned)((1000u << ES_PROFILE_HIST_SHIFT) / ES_CYCLES_PER_US));
+  printf("%-20s %5s %10s %9s %9s %9s %9s\r\n", "Service", "Event", "Count",
+      "ExecAvg", "ExecMax", "WaitAvg", "WaitMax");
+  for (Service = 0; Service < NUM_SERVICES; Service++)
+  {
+    for (Event = 0; Event < NUM_EVENT_TYPES; Event++)
+    {
+      pStats = &Stats[Service][Event];
+      if (pStats->Count == 0)
+      {
+        continue;
+      }
+      printf("%-20s %5u %10lu %9lu %9lu %9lu %9lu\r\n", ServiceNames[Service],
+          Event, (unsigned long)pStats->Count,
+          (unsigned long)(pStats->ExecTotal / pStats->Count / ES_CYCLES_PER_US),
+          (unsigned long)(pStats->ExecMax / ES_CYCLES_PER_US),
+          (unsigned long)(pStats->WaitTotal / pStats->Count / ES_CYCLES_PER_US),
+          (unsigned long)(pStats->WaitMax / ES_CYCLES_PER_US));
+      PrintHist("exec", pStats->ExecHist);
+      PrintHist("wait", pStats->WaitHist);
+    }
+  }
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+/****************************************************************************
+ Function
+   AddToHist
+ Parameters
+   uint16_t * : the histogram to add to
+   uint32_t : the time to add, in clock counts
+ Returns
+   None
+ Description
+   bumps the log2 bucket that the time falls in, buckets stop at HIST_MAX
+ Notes
+
+****************************************************************************/
+static void AddToHist(uint16_t *pHist, uint32_t Time)
+{
+  uint32_t  Scaled = Time >> ES_PROFILE_HIST_SHIFT;
+  uint8_t   Bucket = 0;
+
+  if (Scaled != 0)
+  {
+    Bucket = ES_GetMSBitSet(Scaled) + 1;
+    if (Bucket >= ES_PROFILE_NUM_BUCKETS)
+    {
+      Bucket = ES_PROFILE_NUM_BUCKETS - 1;
+    }
+  }
+  if (pHist[Bucket] < HIST_MAX)
+  {
+    pHist[Bucket]++;
+  }
+}
+
+/****************************************************************************
+ Function
+   PrintHist
+ Parameters
+   char const * : label for the line
+   uint16_t const * : the histogram to print
+ Returns
+   None
+ Description
+   prints the bucket counts up to the last one that is not empty
+ Notes
+
+****************************************************************************/
+static void PrintHist(char const *pLabel, uint16_t const *pHist)
+{
+  uint8_t Last = ES_PROFILE_NUM_BUCKETS;
+  uint8_t i;
+
+  while ((Last > 0) && (pHist[Last - 1] == 0))
+  {
+    Last--;
+  }
+  printf("    %s:", pLabel);
+  for (i = 0; i < Last; i++)
+  {
+    printf(" %u", (unsigned)pHist[i]);
+  }
+  printf("\r\n");
+}
+
+#endif /* ES_PROFILE */
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
@@ -5,6 +5,13 @@
  Description
      Implements a FIFO circular buffer of EF_Event in a block of memory
  Notes
+     There are two flavors of queue here. The original one keeps a count of
+     entries and uses a critical region around every change, so that any
+     mix of ISRs and the main loop can post to it. The SPSC (single
+     producer, single consumer) one is for queues that are only ever posted
+     to from a single context. It is a power of two in size and keeps
+     separate free-running head and tail counters, each written by only one
+     side, so no critical region is needed, just memory fences.
 
  History
  When           Who     What/Why
@@ -31,6 +38,24 @@ typedef struct
 
 typedef ES_Queue_t *pQueue_t;
 
+// Mask is the (power of two) size of the queue - 1
+// Head counts entries ever added, it is only written by the producer
+// Tail counts entries ever removed, it is only written by the consumer
+// Head - Tail is the number of entries in the queue. The counters are
+// 8 bits so that they can be read & written without being torn, which
+// limits the size to 128 entries
+// entries are made to Head & Mask + sizeof(ES_SPSCQueue_t)
+typedef struct
+{
+  uint8_t Mask;
+  volatile uint8_t Head;
+  volatile uint8_t Tail;
+}ES_SPSCQueue_t;
+
+typedef ES_SPSCQueue_t *pSPSCQueue_t;
+
+#define MAX_SPSC_QUEUE_SIZE 128
+
 /*---------------------------- Module Functions ---------------------------*/
 
 /*---------------------------- Module Variables ---------------------------*/
@@ -104,6 +129,66 @@ bool ES_EnQueueFIFO(ES_Event_t *pBlock, ES_Event_t Event2Add)
   }
 }
 
+/****************************************************************************
+ Function
+   ES_EnQueueFIFOSlot
+ Parameters
+   ES_Event * pBlock : pointer to the block of memory in use as the Queue
+   ES_Event Event2Add : event to be added to the Queue
+ Returns
+   uint8_t : the slot that the event went into, ES_QUEUE_NO_SLOT if full
+ Description
+   same as ES_EnQueueFIFO, but tells where the event went so that the
+   caller can get back to it with ES_GetQueueSlot while it is still queued
+ Notes
+   used by the framework to coalesce events in place
+ Author
+   10/17/26
+****************************************************************************/
+uint8_t ES_EnQueueFIFOSlot(ES_Event_t *pBlock, ES_Event_t Event2Add)
+{
+  pQueue_t  pThisQueue;
+  uint8_t   Slot;
+
+  pThisQueue = (pQueue_t)pBlock;
+  if (pThisQueue->NumEntries < pThisQueue->QueueSize)
+  {
+    EnterCritical();  // save interrupt state, turn ints off
+    Slot = (uint8_t)((pThisQueue->CurrentIndex + pThisQueue->NumEntries)
+        % pThisQueue->QueueSize);
+    pBlock[1 + Slot] = Event2Add;
+    pThisQueue->NumEntries++; // inc number of entries
+    ExitCritical();           // restore saved interrupt state
+
+    return Slot;
+  }
+  else
+  {
+    return ES_QUEUE_NO_SLOT;
+  }
+}
+
+/****************************************************************************
+ Function
+   ES_GetQueueSlot
+ Parameters
+   ES_Event * pBlock : pointer to the block of memory in use as the Queue
+   uint8_t Slot : a slot returned by ES_EnQueueFIFOSlot
+ Returns
+   ES_Event * : the event in that slot
+ Description
+   see above
+ Notes
+   only meaningful while the event is still in the queue
+ Author
+   10/17/26
+****************************************************************************/
+ES_Event_t *ES_GetQueueSlot(ES_Event_t *pBlock, uint8_t Slot)
+{
+  // 1+ to step past the Queue struct at the beginning of the block
+  return &pBlock[1 + Slot];
+}
+
 /****************************************************************************
  Function
    ES_EnQueueLIFO
@@ -218,6 +303,193 @@ bool ES_IsQueueEmpty(ES_Event_t *pBlock)
   return pThisQueue->NumEntries == 0;
 }
 
+/****************************************************************************
+ Function
+   ES_GetQueueDepth
+ Parameters
+   unsigned char * pBlock : pointer to the block of memory in use as the Queue
+ Returns
+   uint8_t : the number of events in the Queue
+ Description
+   see above
+ Notes
+
+ Author
+   10/17/26
+****************************************************************************/
+uint8_t ES_GetQueueDepth(ES_Event_t *pBlock)
+{
+  pQueue_t pThisQueue;
+
+  pThisQueue = (pQueue_t)pBlock;
+  return pThisQueue->NumEntries;
+}
+
+/****************************************************************************
+ Function
+   ES_InitSPSCQueue
+ Parameters
+   EF_Event * pBlock : pointer to the block of memory to use for the Queue
+   unsigned char BlockSize: size of the block pointed to by pBlock
+ Returns
+   max number of entries in the created queue, 0 if BlockSize - 1 is not a
+   power of two (or is too big)
+ Description
+   Initializes a lock-free queue structure at the beginning of the block of
+   memory
+ Notes
+   as for ES_InitQueue, declare an array of ES_Event with 1 more element than
+   you need for the actual queue. The queue itself must be a power of two
+   in size, no bigger than MAX_SPSC_QUEUE_SIZE.
+ Author
+   10/17/26
+****************************************************************************/
+uint8_t ES_InitSPSCQueue(ES_Event_t *pBlock, uint8_t BlockSize)
+{
+  pSPSCQueue_t  pThisQueue;
+  uint8_t       QueueSize = BlockSize - 1;
+
+  pThisQueue = (pSPSCQueue_t)pBlock;
+  if ((QueueSize == 0) || (QueueSize > MAX_SPSC_QUEUE_SIZE) ||
+      ((QueueSize & (QueueSize - 1)) != 0))
+  {
+    pThisQueue->Mask = 0;
+    QueueSize = 0;
+  }
+  else
+  {
+    pThisQueue->Mask = QueueSize - 1;
+  }
+  pThisQueue->Head = 0;
+  pThisQueue->Tail = 0;
+  return QueueSize;
+}
+
+/****************************************************************************
+ Function
+   ES_EnQueueSPSC
+ Parameters
+   ES_Event * pBlock : pointer to the block of memory in use as the Queue
+   ES_Event Event2Add : event to be added to the Queue
+ Returns
+   bool : true if the add was successful, false if not
+ Description
+   if it will fit, adds Event2Add to the tail of the lock-free Queue
+ Notes
+   must only be called from the single producer context for this queue
+ Author
+   10/17/26
+****************************************************************************/
+bool ES_EnQueueSPSC(ES_Event_t *pBlock, ES_Event_t Event2Add)
+{
+  pSPSCQueue_t  pThisQueue;
+  uint8_t       Head;
+  uint8_t       Tail;
+
+  pThisQueue = (pSPSCQueue_t)pBlock;
+  Head = pThisQueue->Head;    // we are the only writer, so this is current
+  Tail = pThisQueue->Tail;
+  // the consumer must be done with the slot before we write to it
+  ES_AcquireFence();
+  // the difference works across the wrap of the counters
+  if ((uint8_t)(Head - Tail) > pThisQueue->Mask)
+  {
+    return false; // full
+  }
+  // 1+ to step past the Queue struct at the beginning of the block
+  pBlock[1 + (Head & pThisQueue->Mask)] = Event2Add;
+  // the event must be in place before the consumer can see the new Head
+  ES_ReleaseFence();
+  pThisQueue->Head = Head + 1;
+  return true;
+}
+
+/****************************************************************************
+ Function
+   ES_DeQueueSPSC
+ Parameters
+   unsigned char * pBlock : pointer to the block of memory in use as the Queue
+   ES_Event * pReturnEvent : used to return the event pulled from the queue
+ Returns
+   The number of entries remaining in the Queue
+ Description
+   pulls next available entry from the lock-free Queue, EF_NO_EVENT if Queue
+   was empty and copies it to *pReturnEvent.
+ Notes
+   must only be called from the single consumer (ES_Run). The number left
+   is a snapshot, the producer may have added more since.
+ Author
+   10/17/26
+****************************************************************************/
+uint8_t ES_DeQueueSPSC(ES_Event_t *pBlock, ES_Event_t *pReturnEvent)
+{
+  pSPSCQueue_t  pThisQueue;
+  uint8_t       Head;
+  uint8_t       Tail;
+
+  pThisQueue = (pSPSCQueue_t)pBlock;
+  Tail = pThisQueue->Tail;    // we are the only writer, so this is current
+  Head = pThisQueue->Head;
+  // make sure that we see the event that goes with this Head
+  ES_AcquireFence();
+  if (Head == Tail)   // no items left in the queue
+  {
+    (*pReturnEvent).EventType = ES_NO_EVENT;
+    (*pReturnEvent).EventParam = 0;
+    return 0;
+  }
+  *pReturnEvent = pBlock[1 + (Tail & pThisQueue->Mask)];
+  // we must be done reading the slot before the producer can reuse it
+  ES_ReleaseFence();
+  Tail++;
+  pThisQueue->Tail = Tail;
+  return (uint8_t)(Head - Tail);
+}
+
+/****************************************************************************
+ Function
+   ES_IsSPSCQueueEmpty
+ Parameters
+   unsigned char * pBlock : pointer to the block of memory in use as the Queue
+ Returns
+   bool : true if Queue is empty
+ Description
+   see above
+ Notes
+
+ Author
+   10/17/26
+****************************************************************************/
+bool ES_IsSPSCQueueEmpty(ES_Event_t *pBlock)
+{
+  pSPSCQueue_t pThisQueue;
+
+  pThisQueue = (pSPSCQueue_t)pBlock;
+  return pThisQueue->Head == pThisQueue->Tail;
+}
+
+/****************************************************************************
+ Function
+   ES_GetSPSCQueueDepth
+ Parameters
+   unsigned char * pBlock : pointer to the block of memory in use as the Queue
+ Returns
+   uint8_t : the number of events in the lock-free Queue
+ Description
+   see above
+ Notes
+   a snapshot, exact only when called from the producer or the consumer
+ Author
+   10/17/26
+****************************************************************************/
+uint8_t ES_GetSPSCQueueDepth(ES_Event_t *pBlock)
+{
+  pSPSCQueue_t pThisQueue;
+
+  pThisQueue = (pSPSCQueue_t)pBlock;
+  return (uint8_t)(pThisQueue->Head - pThisQueue->Tail);
+}
+
 #if 0
 /****************************************************************************
  Function
@@ -248,7 +520,7 @@ void QueueFlushQueue(uint8_t *pBlock)
 /***************************************************************************
  private functions
  ***************************************************************************/
-#ifdef TEST
+#if defined(TEST) && !defined(ES_PORT_POSIX)
 
 #include <stdio.h>
 #include "ES_General.h"
@@ -321,6 +593,133 @@ void main(void)
   }
 }
 
+#endif
+
+#if defined(TEST) && defined(ES_PORT_POSIX)
+/*
+  Host stress test for the SPSC queue. A second thread plays the part of the
+  ISR, posting a numbered sequence of events as fast as it can while main
+  plays ES_Run, pulling them off and checking that none are lost, duplicated
+  or re-ordered. It also runs the same traffic through the standard queue
+  for comparison. Build with:
+  gcc -O2 -DTEST -DES_PORT_POSIX -I<app headers> -IHeaders Source/ES_Queue.c
+      -lpthread
+*/
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "ES_General.h"
+
+// stand-ins for the ES_PortPOSIX.c critical region, so that this test
+// links on its own
+uint32_t _PRIMASK_temp;
+static pthread_mutex_t IntLock = PTHREAD_MUTEX_INITIALIZER;
+
+uint32_t CPUgetPRIMASK_cpsid(void)
+{
+  pthread_mutex_lock(&IntLock);
+  return 0;
+}
+
+void CPUsetPRIMASK(uint32_t newPRIMASK)
+{
+  (void)newPRIMASK;
+  pthread_mutex_unlock(&IntLock);
+}
+
+#define NUM_STRESS_EVENTS 2000000UL
+
+static ES_Event_t SPSCQueue[64 + 1];
+static ES_Event_t StdQueue[64 + 1];
+static volatile bool UseSPSC;
+
+static void *ProducerThread(void *pArg)
+{
+  uint32_t    Sent;
+  ES_Event_t  ThisEvent;
+  (void)pArg;
+
+  for (Sent = 0; Sent < NUM_STRESS_EVENTS; Sent++)
+  {
+    ThisEvent.EventType = (ES_EventType_t)(Sent & 0x0F);
+    ThisEvent.EventParam = (uint16_t)Sent;
+    if (UseSPSC)
+    {
+      while (ES_EnQueueSPSC(SPSCQueue, ThisEvent) == false)
+      {
+        sched_yield(); // full, let the consumer run if we share a core
+      }
+    }
+    else
+    {
+      while (ES_EnQueueFIFO(StdQueue, ThisEvent) == false)
+      {
+        sched_yield();
+      }
+    }
+  }
+  return NULL;
+}
+
+static uint32_t RunStress(bool SPSC)
+{
+  pthread_t       Producer;
+  uint32_t        Received = 0;
+  uint32_t        Errors = 0;
+  ES_Event_t      ThisEvent;
+  struct timespec Start, End;
+  bool            GotOne;
+
+  UseSPSC = SPSC;
+  clock_gettime(CLOCK_MONOTONIC, &Start);
+  pthread_create(&Producer, NULL, ProducerThread, NULL);
+  while (Received < NUM_STRESS_EVENTS)
+  {
+    if (SPSC)
+    {
+      GotOne = !ES_IsSPSCQueueEmpty(SPSCQueue);
+      ES_DeQueueSPSC(SPSCQueue, &ThisEvent);
+    }
+    else
+    {
+      GotOne = !ES_IsQueueEmpty(StdQueue);
+      ES_DeQueue(StdQueue, &ThisEvent);
+    }
+    if (GotOne)
+    {
+      if ((ThisEvent.EventParam != (uint16_t)Received) ||
+          (ThisEvent.EventType != (ES_EventType_t)(Received & 0x0F)))
+      {
+        Errors++;
+      }
+      Received++;
+    }
+    else
+    {
+      sched_yield();
+    }
+  }
+  pthread_join(Producer, NULL);
+  clock_gettime(CLOCK_MONOTONIC, &End);
+  printf("%s: %lu events, %u errors, %.1f ns/event\n\r",
+      SPSC ? "SPSC" : "standard", NUM_STRESS_EVENTS, Errors,
+      ((End.tv_sec - Start.tv_sec) * 1e9 + (End.tv_nsec - Start.tv_nsec)) /
+      NUM_STRESS_EVENTS);
+  return Errors;
+}
+
+int main(void)
+{
+  uint32_t Errors;
+
+  ES_InitSPSCQueue(SPSCQueue, ARRAY_SIZE(SPSCQueue));
+  ES_InitQueue(StdQueue, ARRAY_SIZE(StdQueue));
+  Errors = RunStress(true);
+  Errors += RunStress(false);
+  return Errors != 0;
+}
+
 #endif
 /*------------------------------- Footnotes -------------------------------*/
 /*------------------------------ End of file ------------------------------*/
@@ -0,0 +1,637 @@
+/****************************************************************************
+ Module
+     ES_Sched.c
+ Description
+     deadline bookkeeping for ES_Run and the earliest deadline first (EDF)
+     scheduling policy. Every post is stamped with an absolute deadline, the
+     post time plus the relative deadline given for the service in
+     DEADLINE_LIST, and every dispatch checks the time that the run function
+     returned against it. Under ES_SCHED_EDF, ES_Run serves the service
+     whose oldest waiting event has the earliest deadline, rather than the
+     highest numbered one.
+ Notes
+     Only compiled when ES_DEADLINES is defined, which ES_Sched.h does
+     whenever ES_SCHED_POLICY is ES_SCHED_EDF.
+
+     The deadlines are kept in a ring per service that shadows the event
+     queue, so ES_Event_t does not grow. The post functions stamp an event
+     in the same critical region as they queue it, so a post from an
+     interrupt can not land in between and take its stamp. A post that is
+     coalesced into a waiting event does not get a stamp, the waiting
+     event keeps its deadline.
+
+     Deadlines are in _HW_GetCycleCount counts, which wrap, so they are
+     compared by the sign of their difference. Relative deadlines must be
+     less than half the wrap, 53 seconds on the Tiva and 2 on the host.
+
+     Neither policy pre-empts a run function, so the deadlines only decide
+     which event goes next.
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 16:40         started coding
+*****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Configure.h"
+
+// the host trace replay at the bottom always needs the deadlines
+#if defined(TEST) && defined(ES_PORT_POSIX) && !defined(ES_DEADLINES)
+#define ES_DEADLINES
+#endif
+
+#include "ES_Sched.h"
+#include "ES_Bus.h"
+
+#ifdef ES_DEADLINES
+
+#include "ES_General.h"
+#include "ES_LookupTables.h"
+#include <stdio.h>
+#include <string.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+typedef struct
+{
+  uint32_t  *pDeadlines;  // deadline of each event in the service's queue
+  uint8_t   Size;
+  uint8_t   First;
+  uint8_t   Count;
+}DeadlineRing_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+static uint32_t HeadDeadline(uint8_t WhichService, uint32_t Now);
+
+/*---------------------------- Module Variables ---------------------------*/
+// one deadline ring per service, the same size as its event queue plus
+// the bus, if there is one
+#define RING_MEM_ENTRY(Init, Run, QueueSize, Kind) \
+  static uint32_t Deadlines_##Run[(QueueSize) + ES_BUS_SLOTS];
+
+SERVICE_LIST(RING_MEM_ENTRY)
+
+#define RING_ENTRY(Init, Run, QueueSize, Kind) \
+  { Deadlines_##Run, ARRAY_SIZE(Deadlines_##Run), 0, 0 },
+
+static DeadlineRing_t Rings[NUM_SERVICES] = {
+  SERVICE_LIST(RING_ENTRY)
+};
+
+// the relative deadlines from DEADLINE_LIST, in uS, indexed by service.
+// Services are named by their run functions, so first number them. A 0
+// here means the service was not listed and gets ES_DEFAULT_DEADLINE_US
+#define SERV_INDEX_ENTRY(Init, Run, QueueSize, Kind) SchedIndex_##Run,
+
+enum
+{
+  SERVICE_LIST(SERV_INDEX_ENTRY)
+};
+
+#ifdef DEADLINE_LIST
+#define DEADLINE_ENTRY(Run, US) [SchedIndex_##Run] = (US),
+
+static uint32_t const RelDeadlineUS[NUM_SERVICES] = {
+  DEADLINE_LIST(DEADLINE_ENTRY)
+};
+#else
+static uint32_t const RelDeadlineUS[NUM_SERVICES];
+#endif
+
+#ifndef ES_DEFAULT_DEADLINE_US
+#define ES_DEFAULT_DEADLINE_US 100000
+#endif
+
+// names for the printout, taken from the run functions
+#define NAME_ENTRY(Init, Run, QueueSize, Kind) #Run,
+
+static char const *const ServiceNames[NUM_SERVICES] = {
+  SERVICE_LIST(NAME_ENTRY)
+};
+
+static ES_DeadlineStats_t Stats[NUM_SERVICES];
+
+// the dispatch in progress, ES_Run is never re-entered so one is enough
+static ES_DeadlineStats_t *pCurrent;
+static uint32_t           CurrentDeadline;
+static uint32_t           CurrentRelDeadline;
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+   ES_Sched_Init
+ Parameters
+   None
+ Returns
+   None
+ Description
+   empties the deadline rings and clears the statistics
+ Notes
+   called by ES_Initialize before any of the services are initialized
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Sched_Init(void)
+{
+  uint8_t i;
+
+  for (i = 0; i < NUM_SERVICES; i++)
+  {
+    Rings[i].First = 0;
+    Rings[i].Count = 0;
+  }
+  ES_Sched_ResetStats();
+}
+
+/****************************************************************************
+ Function
+   ES_Sched_Posted
+ Parameters
+   uint8_t : which service was just posted to
+   bool : true if the event went to the front of the queue (LIFO)
+ Returns
+   None
+ Description
+   stamps the event that just went into a service's queue with its
+   absolute deadline
+ Notes
+   called from the framework post functions after a successful enqueue,
+   in the same critical region, so that the stamp lines up with the queue
+   slot. The ring update still saves its own PRIMASK so that it is safe
+   to call on its own.
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Sched_Posted(uint8_t WhichService, bool AtFront)
+{
+  DeadlineRing_t  *pRing = &Rings[WhichService];
+  uint32_t        RelDeadline = RelDeadlineUS[WhichService];
+  uint32_t        Deadline;
+  uint32_t        SavedPRIMASK;
+  uint8_t         Index;
+
+  if (RelDeadline == 0)
+  {
+    RelDeadline = ES_DEFAULT_DEADLINE_US;
+  }
+  Deadline = _HW_GetCycleCount() + RelDeadline * ES_CYCLES_PER_US;
+
+  SavedPRIMASK = CPUgetPRIMASK_cpsid();
+  if (pRing->Count < pRing->Size)
+  {
+    if (AtFront)
+    {
+      pRing->First = (pRing->First == 0) ? (pRing->Size - 1) :
+          (pRing->First - 1);
+      Index = pRing->First;
+    }
+    else
+    {
+      Index = pRing->First + pRing->Count;
+      if (Index >= pRing->Size)
+      {
+        Index -= pRing->Size;
+      }
+    }
+    pRing->pDeadlines[Index] = Deadline;
+    pRing->Count++;
+  }
+  CPUsetPRIMASK(SavedPRIMASK);
+}
+
+/****************************************************************************
+ Function
+   ES_Sched_PickEDF
+ Parameters
+   uint32_t : the Ready bits, must not be 0
+ Returns
+   uint8_t : the service to run next
+ Description
+   finds the ready service whose oldest event has the earliest deadline.
+   On a tie the higher numbered service wins, as it would under
+   ES_SCHED_STATIC
+ Notes
+   the scan is done with interrupts off so that a LIFO post from an ISR
+   can not move a ring head part way through. It looks at each ready
+   service once, highest first
+ Author
+   10/17/26
+****************************************************************************/
+uint8_t ES_Sched_PickEDF(uint32_t ReadyBits)
+{
+  uint8_t   Best;
+  uint8_t   WhichService;
+  uint32_t  BestDeadline;
+  uint32_t  Deadline;
+  uint32_t  Now = _HW_GetCycleCount();
+  uint32_t  SavedPRIMASK;
+
+  SavedPRIMASK = CPUgetPRIMASK_cpsid();
+  Best = ES_GetMSBitSet(ReadyBits);
+  BestDeadline = HeadDeadline(Best, Now);
+  ReadyBits &= ~((uint32_t)1 << Best);
+  while (ReadyBits != 0)
+  {
+    WhichService = ES_GetMSBitSet(ReadyBits);
+    Deadline = HeadDeadline(WhichService, Now);
+    if ((int32_t)(Deadline - BestDeadline) < 0)
+    {
+      Best = WhichService;
+      BestDeadline = Deadline;
+    }
+    ReadyBits &= ~((uint32_t)1 << WhichService);
+  }
+  CPUsetPRIMASK(SavedPRIMASK);
+  return Best;
+}
+
+/****************************************************************************
+ Function
+   ES_Sched_BeginRun
+ Parameters
+   uint8_t : the service that is about to run
+ Returns
+   None
+ Description
+   takes the deadline of the event that was just removed from the queue,
+   to be checked when the run function returns
+ Notes
+   called by ES_Run after the DeQueue, just before the run function
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Sched_BeginRun(uint8_t WhichService)
+{
+  DeadlineRing_t  *pRing = &Rings[WhichService];
+  uint32_t        SavedPRIMASK;
+
+  pCurrent = NULL;
+  SavedPRIMASK = CPUgetPRIMASK_cpsid();
+  if (pRing->Count > 0)
+  {
+    CurrentDeadline = pRing->pDeadlines[pRing->First];
+    if (++pRing->First >= pRing->Size)
+    {
+      pRing->First = 0;
+    }
+    pRing->Count--;
+    pCurrent = &Stats[WhichService];
+  }
+  CPUsetPRIMASK(SavedPRIMASK);
+
+  CurrentRelDeadline = RelDeadlineUS[WhichService];
+  if (CurrentRelDeadline == 0)
+  {
+    CurrentRelDeadline = ES_DEFAULT_DEADLINE_US;
+  }
+  CurrentRelDeadline *= ES_CYCLES_PER_US;
+}
+
+/****************************************************************************
+ Function
+   ES_Sched_EndRun
+ Parameters
+   None
+ Returns
+   None
+ Description
+   checks the time that the run function started by ES_Sched_BeginRun
+   returned against the event's deadline
+ Notes
+
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Sched_EndRun(void)
+{
+  int32_t   Late = (int32_t)(_HW_GetCycleCount() - CurrentDeadline);
+  uint32_t  Response = (uint32_t)(Late + (int32_t)CurrentRelDeadline);
+
+  if (pCurrent == NULL)
+  {
+    return;
+  }
+  pCurrent->Dispatches++;
+  if (Response > pCurrent->MaxResponse)
+  {
+    pCurrent->MaxResponse = Response;
+  }
+  if (Late > 0)
+  {
+    pCurrent->Misses++;
+    if ((uint32_t)Late > pCurrent->MaxLate)
+    {
+      pCurrent->MaxLate = (uint32_t)Late;
+    }
+  }
+  pCurrent = NULL;
+}
+
+/****************************************************************************
+ Function
+   ES_Sched_GetStats
+ Parameters
+   uint8_t : which service
+ Returns
+   pointer to the deadline statistics for that service, NULL if there is
+   no such service
+ Description
+   lets an application look at the raw numbers, times are in clock counts
+ Notes
+
+ Author
+   10/17/26
+****************************************************************************/
+ES_DeadlineStats_t const *ES_Sched_GetStats(uint8_t WhichService)
+{
+  if (WhichService >= NUM_SERVICES)
+  {
+    return NULL;
+  }
+  return &Stats[WhichService];
+}
+
+/****************************************************************************
+ Function
+   ES_Sched_ResetStats
+ Parameters
+   None
+ Returns
+   None
+ Description
+   clears the deadline statistics, the deadlines of events that are still
+   in the queues are kept
+ Notes
+
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Sched_ResetStats(void)
+{
+  memset(Stats, 0, sizeof(Stats));
+  pCurrent = NULL;
+}
+
+/****************************************************************************
+ Function
+   ES_Sched_PrintStats
+ Parameters
+   None
+ Returns
+   None
+ Description
+   prints the relative deadline, dispatches, misses, worst response and
+   worst lateness of every service. Times are in uS
+ Notes
+   goes out through printf, so it takes a while
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Sched_PrintStats(void)
+{
+  uint8_t   i;
+  uint32_t  RelDeadline;
+
+  printf("\r\nDeadlines (uS)\r\n");
+  printf("%-20s %9s %10s %8s %9s %9s\r\n", "Service", "Deadline",
+      "Dispatches", "Misses", "MaxResp", "MaxLate");
+  for (i = 0; i < NUM_SERVICES; i++)
+  {
+    RelDeadline = RelDeadlineUS[i];
+    if (RelDeadline == 0)
+    {
+      RelDeadline = ES_DEFAULT_DEADLINE_US;
+    }
+    printf("%-20s %9lu %10lu %8lu %9lu %9lu\r\n", ServiceNames[i],
+        (unsigned long)RelDeadline, (unsigned long)Stats[i].Dispatches,
+        (unsigned long)Stats[i].Misses,
+        (unsigned long)(Stats[i].MaxResponse / ES_CYCLES_PER_US),
+        (unsigned long)(Stats[i].MaxLate / ES_CYCLES_PER_US));
+  }
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+/****************************************************************************
+ Function
+   HeadDeadline
+ Parameters
+   uint8_t : which service
+   uint32_t : the time now
+ Returns
+   uint32_t the deadline of the oldest event waiting for that service
+ Description
+   a service that is ready but has no deadline waiting (it was posted to
+   before ES_Sched_Init) is treated as due now
+ Notes
+   call with interrupts off
+****************************************************************************/
+static uint32_t HeadDeadline(uint8_t WhichService, uint32_t Now)
+{
+  if (Rings[WhichService].Count == 0)
+  {
+    return Now;
+  }
+  return Rings[WhichService].pDeadlines[Rings[WhichService].First];
+}
+
+#if defined(TEST) && defined(ES_PORT_POSIX)
+/*
+  Host trace replay. Runs a trace of posts through a model of ES_Run, once
+  with each scheduling policy, and prints the deadline statistics for both
+  so that their worst case response times can be compared. The services,
+  their queue sizes and deadlines come from the ES_Configure.h that it is
+  built with. A trace is a text file with one post per line:
+      <post time, uS> <service number> <run function time, uS>
+  in order of post time, lines starting with # are skipped. With no trace
+  file a made up one is used: a periodic event for service 0, and a
+  periodic event plus regular bursts of 10 for service 1. Build with:
+  gcc -O2 -DTEST -DES_PORT_POSIX -I<app headers> -IHeaders Source/ES_Sched.c
+*/
+#include <stdlib.h>
+
+typedef struct
+{
+  uint64_t  PostTime;   // nS
+  uint8_t   Service;
+  uint32_t  RunTime;    // nS
+}TracePost_t;
+
+// stand-ins for the port functions, so that this test links on its own and
+// runs on simulated time
+uint32_t _PRIMASK_temp;
+static uint64_t SimNow;
+
+uint32_t CPUgetPRIMASK_cpsid(void)
+{
+  return 0;
+}
+
+void CPUsetPRIMASK(uint32_t newPRIMASK)
+{
+  (void)newPRIMASK;
+}
+
+uint32_t _HW_GetCycleCount(void)
+{
+  return (uint32_t)SimNow;
+}
+
+#define MAX_TRACE_POSTS 100000u
+
+#define QUEUE_SIZE_ENTRY(Init, Run, QueueSize, Kind) (QueueSize),
+
+static uint8_t const QueueSizes[NUM_SERVICES] = {
+  SERVICE_LIST(QUEUE_SIZE_ENTRY)
+};
+
+static TracePost_t Trace[MAX_TRACE_POSTS];
+static uint32_t    NumPosts;
+
+// the model of the queues only needs the run time of each waiting event.
+// 256 entries so that the uint8_t indices wrap around on their own
+static uint32_t ModelQueue[NUM_SERVICES][256];
+static uint8_t  ModelFirst[NUM_SERVICES];
+static uint8_t  ModelCount[NUM_SERVICES];
+
+static void AddPost(uint64_t PostUS, uint8_t Service, uint32_t RunUS)
+{
+  if ((NumPosts < MAX_TRACE_POSTS) && (Service < NUM_SERVICES))
+  {
+    Trace[NumPosts].PostTime = PostUS * 1000u;
+    Trace[NumPosts].Service = Service;
+    Trace[NumPosts].RunTime = RunUS * 1000u;
+    NumPosts++;
+  }
+}
+
+static bool LoadTrace(char const *pFileName)
+{
+  FILE          *pFile = fopen(pFileName, "r");
+  char          Line[128];
+  unsigned long PostUS;
+  unsigned      Service;
+  unsigned long RunUS;
+
+  if (pFile == NULL)
+  {
+    perror(pFileName);
+    return false;
+  }
+  while (fgets(Line, sizeof(Line), pFile) != NULL)
+  {
+    if ((Line[0] != '#') &&
+        (sscanf(Line, "%lu %u %lu", &PostUS, &Service, &RunUS) == 3))
+    {
+      AddPost(PostUS, (uint8_t)Service, RunUS);
+    }
+  }
+  fclose(pFile);
+  return true;
+}
+
+static void MakeTrace(void)
+{
+  uint64_t  Time;
+  uint8_t   i;
+
+  for (Time = 0; Time < 2000000u; Time += 1000u)
+  {
+    if ((Time % 5000u) == 0)
+    {
+      AddPost(Time, 0, 400);    // control law
+    }
+    if ((Time % 10000u) == 3000u)
+    {
+      AddPost(Time, 1, 300);    // sensor poll
+    }
+    if ((Time % 50000u) == 24000u)
+    {
+      for (i = 0; (i < 10) && (NUM_SERVICES > 1); i++)
+      {
+        AddPost(Time + i * 100u, NUM_SERVICES - 1, 700);  // beacon burst
+      }
+    }
+  }
+}
+
+static void Replay(uint8_t Policy)
+{
+  uint32_t  Ready = 0;
+  uint32_t  Next = 0;
+  uint32_t  Drops = 0;
+  uint64_t  Now = 0;
+  uint8_t   Service;
+  uint8_t   Index;
+
+  memset(ModelFirst, 0, sizeof(ModelFirst));
+  memset(ModelCount, 0, sizeof(ModelCount));
+  SimNow = 0;
+  ES_Sched_Init();
+  while ((Next < NumPosts) || (Ready != 0))
+  {
+    // idle, so skip ahead to the next post
+    if ((Ready == 0) && (Trace[Next].PostTime > Now))
+    {
+      Now = Trace[Next].PostTime;
+    }
+    // everything posted by now, stamped at its own post time as if an
+    // interrupt had posted it while the last run function was running
+    while ((Next < NumPosts) && (Trace[Next].PostTime <= Now))
+    {
+      Service = Trace[Next].Service;
+      if (ModelCount[Service] < QueueSizes[Service])
+      {
+        SimNow = Trace[Next].PostTime;
+        Index = (uint8_t)(ModelFirst[Service] + ModelCount[Service]);
+        ModelQueue[Service][Index] = Trace[Next].RunTime;
+        ModelCount[Service]++;
+        ES_Sched_Posted(Service, false);
+        Ready |= (uint32_t)1 << Service;
+      }
+      else
+      {
+        Drops++;
+      }
+      Next++;
+    }
+    SimNow = Now;
+    Service = (Policy == ES_SCHED_EDF) ? ES_Sched_PickEDF(Ready) :
+        ES_GetMSBitSet(Ready);
+    Index = ModelFirst[Service]++;
+    if (--ModelCount[Service] == 0)
+    {
+      Ready &= ~((uint32_t)1 << Service);
+    }
+    ES_Sched_BeginRun(Service);
+    Now += ModelQueue[Service][Index];
+    SimNow = Now;
+    ES_Sched_EndRun();
+  }
+  printf("\r\n%s: %lu posts, %lu lost to full queues",
+      (Policy == ES_SCHED_EDF) ? "EDF" : "static", (unsigned long)NumPosts,
+      (unsigned long)Drops);
+  ES_Sched_PrintStats();
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc > 1)
+  {
+    if (!LoadTrace(argv[1]))
+    {
+      return 1;
+    }
+  }
+  else
+  {
+    MakeTrace();
+  }
+  Replay(ES_SCHED_STATIC);
+  Replay(ES_SCHED_EDF);
+  return 0;
+}
+#endif
+
+#endif /* ES_DEADLINES */
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
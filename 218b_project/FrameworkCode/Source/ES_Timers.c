@@ -3,12 +3,20 @@
      ES_Timers.c
 
  Description
-     This is a module implementing  8 16 bit timers all using the RTI
-     timebase
+     This is a module implementing 16 fixed and NUM_DYNAMIC_TIMERS allocated
+     32 bit timers all using the RTI timebase
 
  Notes
      Everything is done in terms of RTI Ticks, which can change from
      application to application.
+     The running timers are kept in a hierarchical timing wheel, so that
+     the work done on each tick is proportional to the number of timers that
+     expire on that tick, not the number of timers running. Level 0 of the
+     wheel has a slot for each of the next 64 ticks, level 1 a slot for
+     each of the next 64 groups of 64 ticks, and so on. When the low bits of
+     the time roll over, the timers in the next slot of the level above are
+     moved down (cascaded) to a finer level. 6 levels of 6 bits cover all
+     32 bit durations.
 
  History
  When           Who     What/Why
@@ -53,46 +61,75 @@
 /*--------------------------- External Variables --------------------------*/
 
 /*----------------------------- Module Defines ----------------------------*/
+// the first 16 timers are the ones with response functions fixed in
+// ES_Configure.h, the rest are handed out by ES_Timer_AllocTimer
+#define NUM_FIXED_TIMERS 16
+#define NUM_TIMERS (NUM_FIXED_TIMERS + NUM_DYNAMIC_TIMERS)
+
+#if NUM_TIMERS >= ES_Timer_NO_TIMER
+#error "too many timers, NUM_DYNAMIC_TIMERS must be reduced"
+#endif
+
+// geometry of the timing wheel
+#define WHEEL_BITS 6
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+#define WHEEL_LEVELS 6
+
+// marks the end of a list of timers in the wheel
+#define NO_TIMER 0xFF
+
+// values for the Flags field of a timer
+#define TIMER_ACTIVE    BIT0HI
+#define TIMER_ALLOCATED BIT1HI
 
 /*------------------------------ Module Types -----------------------------*/
 
+typedef uint32_t Timer_t; // sets size of timers to 32 bits
+
 /*
-   the size of Tflag sets the number of timers, uint8 = 8, uint16 = 16 ...)
-   to add more timers, you will need to change the data type and modify
-   the initialization of TMR_TimerArray and TMR_MaskArray
+   The wheel time is kept in 64 bits so that a timer set for up to 2^32-1
+   ticks always has a well defined place in the wheel, even as the tick
+   count wraps. Only the low 32 bits of the expiry time need to be kept.
 */
+typedef uint64_t WheelTime_t;
 
-typedef uint16_t Tflag_t;
-
-typedef uint16_t Timer_t; // sets size of timers to 16 bits
+typedef struct
+{
+  Timer_t   Expiry;     // low 32 bits of the wheel time when it times out
+  Timer_t   Remaining;  // ticks left to run when it is not active
+  Timer_t   Period;     // reload value for periodic timers, 0 for one-shot
+  uint16_t  Slot;       // which slot of the wheel it is in when active
+  uint8_t   Next;       // links for the list of timers in that slot
+  uint8_t   Prev;
+  uint8_t   Flags;
+}TimerEntry_t;
 
 /*---------------------------- Module Functions ---------------------------*/
+static pPostFunc GetPostFunc(uint8_t Num);
+static void InsertTimer(uint8_t Num, Timer_t Ticks);
+static void RemoveTimer(uint8_t Num);
+static void CascadeSlot(uint16_t Slot);
+static uint32_t TicksToNextWork(bool ToExpiry);
+#if defined(TEST) && defined(ES_PORT_POSIX)
+static bool TestPost(ES_Event_t ThisEvent);
+#endif
 
 /*---------------------------- Module Variables ---------------------------*/
-static Timer_t TMR_TimerArray[sizeof(Tflag_t) * BITS_PER_BYTE] =
-{
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0,
-  0x0
-};
+static TimerEntry_t     TMR_TimerArray[NUM_TIMERS];
+
+// the head of the list of timers in each slot, for all levels
+static uint8_t          Wheel[WHEEL_LEVELS * WHEEL_SIZE];
 
-static Tflag_t          TMR_ActiveFlags;
+// the number of ticks that the wheel has processed
+static WheelTime_t      WheelTime;
 
-static pPostFunc const  Timer2PostFunc[sizeof(Tflag_t) * BITS_PER_BYTE] =
+static pPostFunc const  Timer2PostFunc[NUM_FIXED_TIMERS] =
 {
+#if defined(TEST) && defined(ES_PORT_POSIX)
+  // the host test at the bottom takes every timeout itself
+  [0 ... NUM_FIXED_TIMERS - 1] = TestPost
+#else
   TIMER0_RESP_FUNC,
   TIMER1_RESP_FUNC,
   TIMER2_RESP_FUNC,
@@ -109,8 +146,12 @@ static pPostFunc const  Timer2PostFunc[sizeof(Tflag_t) * BITS_PER_BYTE] =
   TIMER13_RESP_FUNC,
   TIMER14_RESP_FUNC,
   TIMER15_RESP_FUNC
+#endif
 };
 
+// response functions for the allocated timers, TIMER_UNUSED when free
+static pPostFunc        DynamicPostFunc[NUM_DYNAMIC_TIMERS];
+
 /*------------------------------ Module Code ------------------------------*/
 /****************************************************************************
  Function
@@ -124,12 +165,25 @@ static pPostFunc const  Timer2PostFunc[sizeof(Tflag_t) * BITS_PER_BYTE] =
      Initializes the timer module by setting up the tick at the requested
     rate
  Notes
-     None.
+     also empties the timing wheel, so all timers are stopped
  Author
      J. Edward Carryer, 02/24/97 14:23
 ****************************************************************************/
 void ES_Timer_Init(TimerRate_t Rate)
 {
+  uint16_t i;
+
+  for (i = 0; i < ARRAY_SIZE(Wheel); i++)
+  {
+    Wheel[i] = NO_TIMER;
+  }
+  for (i = 0; i < ARRAY_SIZE(TMR_TimerArray); i++)
+  {
+    TMR_TimerArray[i].Flags = 0;
+    TMR_TimerArray[i].Remaining = 0;
+    TMR_TimerArray[i].Period = 0;
+  }
+  WheelTime = 0;
   // call the hardware init routine
   _HW_Timer_Init(Rate);
 }
@@ -139,28 +193,35 @@ void ES_Timer_Init(TimerRate_t Rate)
      ES_Timer_SetTimer
  Parameters
      unsigned char Num, the number of the timer to set.
-     unsigned int NewTime, the new time to set on that timer
+     uint32_t NewTime, the new time to set on that timer
  Returns
      ES_Timer_ERR if requested timer does not exist or has no service
      ES_Timer_OK  otherwise
  Description
      sets the time for a timer, but does not make it active.
  Notes
-     None.
+     if the timer is already running, it continues to run with the new time
  Author
      J. Edward Carryer, 02/24/97 17:11
 ****************************************************************************/
-ES_TimerReturn_t ES_Timer_SetTimer(uint8_t Num, uint16_t NewTime)
+ES_TimerReturn_t ES_Timer_SetTimer(uint8_t Num, uint32_t NewTime)
 {
   /* tried to set a timer that doesn't exist */
   if ((Num >= ARRAY_SIZE(TMR_TimerArray)) ||
       /* tried to set a timer without a service */
-      (Timer2PostFunc[Num] == TIMER_UNUSED) ||
+      (GetPostFunc(Num) == TIMER_UNUSED) ||
       (NewTime == 0))   /* no time being set */
   {
     return ES_Timer_ERR;
   }
-  TMR_TimerArray[Num] = NewTime;
+  EnterCritical();
+  TMR_TimerArray[Num].Remaining = NewTime;
+  if (TMR_TimerArray[Num].Flags & TIMER_ACTIVE)
+  {
+    RemoveTimer(Num);
+    InsertTimer(Num, NewTime);
+  }
+  ExitCritical();
   return ES_Timer_OK;
 }
 
@@ -172,8 +233,8 @@ ES_TimerReturn_t ES_Timer_SetTimer(uint8_t Num, uint16_t NewTime)
  Returns
      ES_Timer_ERR for error ES_Timer_OK for success
  Description
-     simply sets the active flag in TMR_ActiveFlags to (re)start a
-     stopped timer.
+     puts the timer back in the wheel with the time it had left to (re)start
+     a stopped timer.
  Notes
      None.
  Author
@@ -184,11 +245,16 @@ ES_TimerReturn_t ES_Timer_StartTimer(uint8_t Num)
   /* tried to set a timer that doesn't exist */
   if ((Num >= ARRAY_SIZE(TMR_TimerArray)) ||
       /* tried to set a timer with no time on it */
-      (TMR_TimerArray[Num] == 0))
+      (TMR_TimerArray[Num].Remaining == 0))
   {
     return ES_Timer_ERR;
   }
-  TMR_ActiveFlags |= BitNum2SetMask[Num];  /* set timer as active */
+  EnterCritical();
+  if ((TMR_TimerArray[Num].Flags & TIMER_ACTIVE) == 0)
+  {
+    InsertTimer(Num, TMR_TimerArray[Num].Remaining);  /* set timer as active */
+  }
+  ExitCritical();
   return ES_Timer_OK;
 }
 
@@ -200,8 +266,8 @@ ES_TimerReturn_t ES_Timer_StartTimer(uint8_t Num)
  Returns
      ES_Timer_ERR for error (timer doesn't exist) ES_Timer_OK for success.
  Description
-     simply clears the bit in TMR_ActiveFlags associated with this
-     timer. This will cause it to stop counting.
+     takes the timer out of the wheel, saving the time that it had left.
+     This will cause it to stop counting.
  Notes
      None.
  Author
@@ -213,7 +279,14 @@ ES_TimerReturn_t ES_Timer_StopTimer(uint8_t Num)
   {
     return ES_Timer_ERR;    /* tried to set a timer that doesn't exist */
   }
-  TMR_ActiveFlags &= BitNum2ClrMask[Num];  /* set timer as inactive */
+  EnterCritical();
+  if (TMR_TimerArray[Num].Flags & TIMER_ACTIVE)
+  {
+    RemoveTimer(Num);       /* set timer as inactive */
+    TMR_TimerArray[Num].Remaining =
+        TMR_TimerArray[Num].Expiry - (Timer_t)WheelTime;
+  }
+  ExitCritical();
   return ES_Timer_OK;
 }
 
@@ -222,31 +295,141 @@ ES_TimerReturn_t ES_Timer_StopTimer(uint8_t Num)
      ES_Timer_InitTimer
  Parameters
      unsigned char Num, the number of the timer to start
-     unsigned int NewTime, the number of ticks to be counted
+     uint32_t NewTime, the number of ticks to be counted
  Returns
      ES_Timer_ERR if the requested timer does not exist, ES_Timer_OK otherwise.
  Description
      sets the NewTime into the chosen timer and sets the timer active to
-     begin counting.
+     begin counting. The timer runs once.
  Notes
      None.
  Author
      J. Edward Carryer, 02/24/97 14:51
 ****************************************************************************/
 
-ES_TimerReturn_t ES_Timer_InitTimer(uint8_t Num, uint16_t NewTime)
+ES_TimerReturn_t ES_Timer_InitTimer(uint8_t Num, uint32_t NewTime)
 {
   /* tried to set a timer that doesn't exist */
   if ((Num >= ARRAY_SIZE(TMR_TimerArray)) ||
       /* tried to set a timer without a service */
-      (Timer2PostFunc[Num] == TIMER_UNUSED) ||
+      (GetPostFunc(Num) == TIMER_UNUSED) ||
       /* tried to set a timer without putting any time on it */
       (NewTime == 0))
   {
     return ES_Timer_ERR;
   }
-  TMR_TimerArray[Num] = NewTime;
-  TMR_ActiveFlags |= BitNum2SetMask[Num];     /* set timer as active */
+  EnterCritical();
+  if (TMR_TimerArray[Num].Flags & TIMER_ACTIVE)
+  {
+    RemoveTimer(Num);
+  }
+  TMR_TimerArray[Num].Remaining = NewTime;
+  TMR_TimerArray[Num].Period = 0;
+  InsertTimer(Num, NewTime);     /* set timer as active */
+  ExitCritical();
+  return ES_Timer_OK;
+}
+
+/****************************************************************************
+ Function
+     ES_Timer_InitPeriodicTimer
+ Parameters
+     unsigned char Num, the number of the timer to start
+     uint32_t Period, the number of ticks between timeouts
+ Returns
+     ES_Timer_ERR if the requested timer does not exist, ES_Timer_OK otherwise.
+ Description
+     like ES_Timer_InitTimer, but each time the timer expires it is reloaded
+     with Period and keeps running, until it is stopped.
+ Notes
+     the reload is done in the tick response, so there is no drift from the
+     time it takes the service to respond to the ES_TIMEOUT
+ Author
+     10/17/26
+****************************************************************************/
+ES_TimerReturn_t ES_Timer_InitPeriodicTimer(uint8_t Num, uint32_t Period)
+{
+  if (ES_Timer_InitTimer(Num, Period) != ES_Timer_OK)
+  {
+    return ES_Timer_ERR;
+  }
+  // safe to set this outside of the critical region, it is only read when
+  // the timer expires and that can not happen for at least another tick
+  TMR_TimerArray[Num].Period = Period;
+  return ES_Timer_OK;
+}
+
+/****************************************************************************
+ Function
+     ES_Timer_AllocTimer
+ Parameters
+     pPostFunc PostFunc, the function to post the ES_TIMEOUT events to
+ Returns
+     the number of the timer, to use with the other ES_Timer functions,
+     ES_Timer_NO_TIMER if they are all in use
+ Description
+     hands out one of the NUM_DYNAMIC_TIMERS timers, for modules that need
+     timers beyond the 16 fixed ones in ES_Configure.h
+ Notes
+     The EventParam of the ES_TIMEOUT is the timer number, as usual.
+ Author
+     10/17/26
+****************************************************************************/
+uint8_t ES_Timer_AllocTimer(pPostFunc PostFunc)
+{
+  uint8_t i;
+  uint8_t Num = ES_Timer_NO_TIMER;
+
+  if (PostFunc == TIMER_UNUSED)
+  {
+    return ES_Timer_NO_TIMER;
+  }
+  EnterCritical();
+  for (i = 0; i < NUM_DYNAMIC_TIMERS; i++)
+  {
+    if (DynamicPostFunc[i] == TIMER_UNUSED)
+    {
+      DynamicPostFunc[i] = PostFunc;
+      Num = NUM_FIXED_TIMERS + i;
+      TMR_TimerArray[Num].Flags = TIMER_ALLOCATED;
+      TMR_TimerArray[Num].Remaining = 0;
+      TMR_TimerArray[Num].Period = 0;
+      break;
+    }
+  }
+  ExitCritical();
+  return Num;
+}
+
+/****************************************************************************
+ Function
+     ES_Timer_FreeTimer
+ Parameters
+     unsigned char Num, a timer number from ES_Timer_AllocTimer
+ Returns
+     ES_Timer_ERR if Num is not an allocated timer, ES_Timer_OK otherwise.
+ Description
+     stops the timer and returns it to the pool
+ Notes
+     an ES_TIMEOUT from this timer may still be in a queue
+ Author
+     10/17/26
+****************************************************************************/
+ES_TimerReturn_t ES_Timer_FreeTimer(uint8_t Num)
+{
+  if ((Num < NUM_FIXED_TIMERS) || (Num >= ARRAY_SIZE(TMR_TimerArray)) ||
+      ((TMR_TimerArray[Num].Flags & TIMER_ALLOCATED) == 0))
+  {
+    return ES_Timer_ERR;
+  }
+  EnterCritical();
+  if (TMR_TimerArray[Num].Flags & TIMER_ACTIVE)
+  {
+    RemoveTimer(Num);
+  }
+  TMR_TimerArray[Num].Flags = 0;
+  DynamicPostFunc[Num - NUM_FIXED_TIMERS] = TIMER_UNUSED;
+  ExitCritical();
   return ES_Timer_OK;
 }
 
@@ -280,45 +463,630 @@ uint16_t ES_Timer_GetTime(void)
      None.
  Description
      This is the new Tick response routine to support the timer module.
-     It will increment time, to maintain the functionality of the
-     GetTime() timer and it will check through the active timers,
-     decrementing each active timers count, if the count goes to 0, it
-     will post an event to the corresponding SM and clear the active flag to
-     prevent further counting.
+     It advances the wheel by one tick, cascading timers down from the
+     coarser levels when the finer levels roll over, then posts an
+     ES_TIMEOUT to the corresponding SM for each timer in the current level
+     0 slot. One-shot timers stop, periodic timers are put back in the
+     wheel for another period.
  Notes
      Called from _Timer_Int_Resp in ES_Port.c.
+     Timers can be started and stopped from ISRs, so each timer is taken
+     out of the wheel inside a critical region, but the post is done outside
+     of it, since the queues have their own critical regions and those do
+     not nest.
  Author
      J. Edward Carryer, 02/24/97 15:06
 ****************************************************************************/
 void ES_Timer_Tick_Resp(void)
 {
-  static Tflag_t    NeedsProcessing;
-  static uint8_t    NextTimer2Process;
   static ES_Event_t NewEvent;
+  uint8_t           Level;
+  uint16_t          Slot;
+  uint8_t           NextTimer2Process;
+
+  WheelTime++;
+  // when the bits for a level roll over to 0, the timers in the next slot
+  // of the level above are due within the range of the finer levels
+  for (Level = 1; Level < WHEEL_LEVELS; Level++)
+  {
+    if (((WheelTime >> (WHEEL_BITS * (Level - 1))) & WHEEL_MASK) != 0)
+    {
+      break;
+    }
+    CascadeSlot((Level * WHEEL_SIZE) +
+        (uint16_t)((WheelTime >> (WHEEL_BITS * Level)) & WHEEL_MASK));
+  }
 
-  if (TMR_ActiveFlags != 0) /* if !=0 , then at least 1 timer is active */
+  // everything left in this level 0 slot has timed out
+  Slot = (uint16_t)(WheelTime & WHEEL_MASK);
+  while (Wheel[Slot] != NO_TIMER)
   {
-    // start by getting a list of all the active timers
-    NeedsProcessing = TMR_ActiveFlags;
-    do
+    EnterCritical();
+    NextTimer2Process = Wheel[Slot];
+    if (NextTimer2Process != NO_TIMER)
     {
-      // find the MSB that is set
-      NextTimer2Process = ES_GetMSBitSet(NeedsProcessing);
-      /* decrement that timer, check if timed out */
-      if (--TMR_TimerArray[NextTimer2Process] == 0)
+      RemoveTimer(NextTimer2Process);
+      if (TMR_TimerArray[NextTimer2Process].Period != 0)
+      {
+        InsertTimer(NextTimer2Process, TMR_TimerArray[NextTimer2Process].Period);
+      }
+      else
       {
-        NewEvent.EventType = ES_TIMEOUT;
-        NewEvent.EventParam = NextTimer2Process;
-        /* post the timeout event to the right Service */
-        Timer2PostFunc[NextTimer2Process](NewEvent);
         /* and stop counting */
-        TMR_ActiveFlags &= BitNum2ClrMask[NextTimer2Process];
+        TMR_TimerArray[NextTimer2Process].Remaining = 0;
       }
-      // mark off the active timer that we just processed
-      NeedsProcessing &= BitNum2ClrMask[NextTimer2Process];
-    } while (NeedsProcessing != 0);
+    }
+    ExitCritical();
+    if (NextTimer2Process != NO_TIMER)
+    {
+      NewEvent.EventType = ES_TIMEOUT;
+      NewEvent.EventParam = NextTimer2Process;
+      /* post the timeout event to the right Service */
+      GetPostFunc(NextTimer2Process)(NewEvent);
+    }
+  }
+}
+
+/****************************************************************************
+ Function
+     ES_Timer_GetTicksToNextExpiry
+ Parameters
+     None.
+ Returns
+     the number of ticks until the next timer expires, ES_Timer_NO_EXPIRY if
+     no timers are running
+ Description
+     used by the port for tickless idle. Until the tick that this returns,
+     nothing will time out, so the port may sleep and then catch up with
+     ES_Timer_AdvanceTicks.
+ Notes
+     Call with interrupts disabled, so that an ISR can not start a timer
+     between this answer and the sleep that depends on it.
+ Author
+     10/17/26
+****************************************************************************/
+uint32_t ES_Timer_GetTicksToNextExpiry(void)
+{
+  return TicksToNextWork(true);
+}
+
+/****************************************************************************
+ Function
+     ES_Timer_AdvanceTicks
+ Parameters
+     uint32_t Ticks, the number of ticks that went by without a response
+ Returns
+     None.
+ Description
+     catches the timers up after the port has slept through some ticks.
+     The ticks with nothing to do are jumped over, the tick response is run
+     for the ones that do have work, so timeouts are still posted and
+     periodic timers are still reloaded from the right tick.
+ Notes
+     Called from the port, in the same (thread) context as
+     ES_Timer_Tick_Resp
+ Author
+     10/17/26
+****************************************************************************/
+void ES_Timer_AdvanceTicks(uint32_t Ticks)
+{
+  uint32_t Skip;
+
+  while (Ticks > 0)
+  {
+    EnterCritical();
+    Skip = TicksToNextWork(false);
+    if (Skip > Ticks)
+    {
+      Skip = Ticks;
+    }
+    // nothing happens on the ticks that we jump over
+    WheelTime += Skip - 1;
+    ExitCritical();
+    ES_Timer_Tick_Resp();
+    Ticks -= Skip;
+  }
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+/****************************************************************************
+ Function
+     GetPostFunc
+ Parameters
+     unsigned char Num, a timer number, known to be in range
+ Returns
+     the function to post this timer's ES_TIMEOUT to
+ Description
+     looks in the fixed table for the first 16, the allocated table for the
+     rest
+ Notes
+
+ Author
+     10/17/26
+****************************************************************************/
+static pPostFunc GetPostFunc(uint8_t Num)
+{
+  if (Num < NUM_FIXED_TIMERS)
+  {
+    return Timer2PostFunc[Num];
+  }
+  return DynamicPostFunc[Num - NUM_FIXED_TIMERS];
+}
+
+/****************************************************************************
+ Function
+     InsertTimer
+ Parameters
+     unsigned char Num, the timer to put in the wheel
+     Timer_t Ticks, how many ticks from now it should time out (>0)
+ Returns
+     None.
+ Description
+     puts the timer at the head of the slot for its expiry time and marks it
+     active. The level is the first one above which the expiry time and the
+     wheel time agree, so the slot is always ahead of the current one for
+     that level and will be reached (or cascaded) before the timer is due.
+ Notes
+     must be called from inside a critical region
+ Author
+     10/17/26
+****************************************************************************/
+static void InsertTimer(uint8_t Num, Timer_t Ticks)
+{
+  WheelTime_t Expiry = WheelTime + Ticks;
+  WheelTime_t Differ = Expiry ^ WheelTime;
+  uint8_t     Level = 0;
+  uint16_t    Slot;
+
+  while ((Level < (WHEEL_LEVELS - 1)) &&
+      ((Differ >> (WHEEL_BITS * (Level + 1))) != 0))
+  {
+    Level++;
+  }
+  Slot = (Level * WHEEL_SIZE) +
+      (uint16_t)((Expiry >> (WHEEL_BITS * Level)) & WHEEL_MASK);
+
+  TMR_TimerArray[Num].Expiry = (Timer_t)Expiry;
+  TMR_TimerArray[Num].Slot = Slot;
+  TMR_TimerArray[Num].Prev = NO_TIMER;
+  TMR_TimerArray[Num].Next = Wheel[Slot];
+  if (Wheel[Slot] != NO_TIMER)
+  {
+    TMR_TimerArray[Wheel[Slot]].Prev = Num;
+  }
+  Wheel[Slot] = Num;
+  TMR_TimerArray[Num].Flags |= TIMER_ACTIVE;
+}
+
+/****************************************************************************
+ Function
+     RemoveTimer
+ Parameters
+     unsigned char Num, an active timer
+ Returns
+     None.
+ Description
+     unlinks the timer from its slot of the wheel and marks it inactive
+ Notes
+     must be called from inside a critical region
+ Author
+     10/17/26
+****************************************************************************/
+static void RemoveTimer(uint8_t Num)
+{
+  TimerEntry_t *pThisTimer = &TMR_TimerArray[Num];
+
+  if (pThisTimer->Prev != NO_TIMER)
+  {
+    TMR_TimerArray[pThisTimer->Prev].Next = pThisTimer->Next;
+  }
+  else
+  {
+    Wheel[pThisTimer->Slot] = pThisTimer->Next;
+  }
+  if (pThisTimer->Next != NO_TIMER)
+  {
+    TMR_TimerArray[pThisTimer->Next].Prev = pThisTimer->Prev;
+  }
+  pThisTimer->Flags &= ~TIMER_ACTIVE;
+}
+
+/****************************************************************************
+ Function
+     CascadeSlot
+ Parameters
+     uint16_t Slot, a slot in one of the coarse levels of the wheel
+ Returns
+     None.
+ Description
+     moves every timer in the slot to its place in the finer levels, based
+     on the time it has left to run
+ Notes
+     one timer at a time, so that interrupts are not held off for long
+ Author
+     10/17/26
+****************************************************************************/
+static void CascadeSlot(uint16_t Slot)
+{
+  uint8_t Num;
+
+  while (Wheel[Slot] != NO_TIMER)
+  {
+    EnterCritical();
+    Num = Wheel[Slot];
+    if (Num != NO_TIMER)
+    {
+      RemoveTimer(Num);
+      // the time left is < 2^32, so the low 32 bits are enough to find it
+      InsertTimer(Num, TMR_TimerArray[Num].Expiry - (Timer_t)WheelTime);
+    }
+    ExitCritical();
+  }
+}
+
+/****************************************************************************
+ Function
+     TicksToNextWork
+ Parameters
+     bool ToExpiry, true to find the next timeout, false to find the next
+     tick on which the tick response has anything at all to do
+ Returns
+     the number of ticks until then, ES_Timer_NO_EXPIRY if no timers are
+     running
+ Description
+     The first occupied slot of the lowest occupied level holds the next
+     timers to expire, and the tick response has nothing to do before the
+     start of that slot (when it is cascaded, or for level 0, expires).
+     For the time to the next timeout, the timers in that slot are searched
+     for the one that expires first.
+ Notes
+     Scans at most 63 slots per level, but only when the framework is idle.
+     Must be called from inside a critical region
+ Author
+     10/17/26
+****************************************************************************/
+static uint32_t TicksToNextWork(bool ToExpiry)
+{
+  uint8_t     Level;
+  uint8_t     Current;
+  uint8_t     Offset;
+  uint16_t    Slot;
+  uint8_t     Num;
+  WheelTime_t Ticks;
+  Timer_t     TimeLeft;
+
+  for (Level = 0; Level < WHEEL_LEVELS; Level++)
+  {
+    Current = (uint8_t)((WheelTime >> (WHEEL_BITS * Level)) & WHEEL_MASK);
+    for (Offset = 1; Offset < WHEEL_SIZE; Offset++)
+    {
+      // slots at or behind the current one are only ever used by the top
+      // level, once the wheel time has wrapped around it
+      if ((Level < (WHEEL_LEVELS - 1)) && ((Current + Offset) > WHEEL_MASK))
+      {
+        break;
+      }
+      Slot = (Level * WHEEL_SIZE) + ((Current + Offset) & WHEEL_MASK);
+      if (Wheel[Slot] == NO_TIMER)
+      {
+        continue;
+      }
+      if ((ToExpiry == false) || (Level == 0))
+      {
+        // ticks until the start of that slot
+        Ticks = ((WheelTime_t)Offset << (WHEEL_BITS * Level)) -
+            (WheelTime & ((1ULL << (WHEEL_BITS * Level)) - 1));
+        return (Ticks >= ES_Timer_NO_EXPIRY) ?
+               (ES_Timer_NO_EXPIRY - 1) : (uint32_t)Ticks;
+      }
+      TimeLeft = ES_Timer_NO_EXPIRY;
+      for (Num = Wheel[Slot]; Num != NO_TIMER; Num = TMR_TimerArray[Num].Next)
+      {
+        if ((Timer_t)(TMR_TimerArray[Num].Expiry - (Timer_t)WheelTime) <
+            TimeLeft)
+        {
+          TimeLeft = TMR_TimerArray[Num].Expiry - (Timer_t)WheelTime;
+        }
+      }
+      return TimeLeft;
+    }
+  }
+  return ES_Timer_NO_EXPIRY;
+}
+
+#if defined(TEST) && defined(ES_PORT_POSIX)
+/*
+  Host test of the timing wheel against a reference model: a plain array of
+  absolute expiry times that is searched on every tick. All of the timers,
+  fixed and allocated, are driven with pseudo-random inits, periodic inits,
+  sets, stops & starts, with times picked around every level boundary of
+  the wheel (64^n - 1, 64^n, 64^n + 1) as well as at random. Time moves on
+  by single ticks, and by jumps of up to ES_Timer_GetTicksToNextExpiry
+  through ES_Timer_AdvanceTicks, as the tickless port does. On every tick
+  the timers that time out must be exactly the ones the model says, and
+  ES_Timer_GetTicksToNextExpiry must agree with the model before each
+  jump. The wheel starts just short of 2^32 ticks, so its 32 bit expiry
+  times wrap, and ES_Timer_GetTime, through a stand-in for the port's 16
+  bit tick count, wraps every 65536 ticks. Build with:
+  gcc -O2 -DTEST -DES_PORT_POSIX -I<app headers> -IHeaders Source/ES_Timers.c
+*/
+#include <stdio.h>
+
+#define NUM_TEST_STEPS 2000000u
+#define TEST_START_TICK 0xFFFFF000UL
+
+typedef struct
+{
+  bool      Active;
+  uint64_t  Expiry;     // absolute tick
+  uint32_t  Remaining;
+  uint32_t  Period;
+}ModelTimer_t;
+
+static ModelTimer_t ModelTimers[NUM_TIMERS];
+static uint64_t     ModelNow;
+static uint64_t     TimedOut;     // the timers posted on this tick
+static uint32_t     NumTimeouts;
+static uint32_t     Errors;
+static uint32_t     Seed = 12345u;
+
+// stand-ins for the port, so that this test links on its own
+uint32_t _PRIMASK_temp;
+
+uint32_t CPUgetPRIMASK_cpsid(void)
+{
+  return 0;
+}
+
+void CPUsetPRIMASK(uint32_t newPRIMASK)
+{
+  (void)newPRIMASK;
+}
+
+void _HW_Timer_Init(TimerRate_t Rate)
+{
+  (void)Rate;
+}
+
+uint16_t _HW_GetTickCount(void)
+{
+  return (uint16_t)ModelNow;
+}
+
+static bool TestPost(ES_Event_t ThisEvent)
+{
+  if ((ThisEvent.EventType != ES_TIMEOUT) ||
+      (ThisEvent.EventParam >= NUM_TIMERS) ||
+      (TimedOut & (1ULL << ThisEvent.EventParam)) ||
+      (ES_Timer_GetTime() != (uint16_t)ModelNow))
+  {
+    Errors++;
+  }
+  TimedOut |= 1ULL << ThisEvent.EventParam;
+  NumTimeouts++;
+  return true;
+}
+
+static uint32_t Random(void)
+{
+  Seed = Seed * 1103515245u + 12345u;
+  return Seed >> 8;
+}
+
+// mostly short times, so that plenty of timers expire, with the level
+// boundaries of the wheel and the odd very long one mixed in
+static uint32_t RandomTime(void)
+{
+  uint32_t Boundary;
+
+  switch (Random() % 8u)
+  {
+    case 0:
+    case 1:
+    {
+      // 64^n - 1, 64^n or 64^n + 1 for n = 1..5
+      Boundary = 1UL << (WHEEL_BITS * (1 + Random() % (WHEEL_LEVELS - 1)));
+      return Boundary - 1 + Random() % 3u;
+    }
+    case 2:
+    {
+      return 1 + (Random() << 8 ^ Random());   // anything up to 2^32 - 1
+    }
+    default:
+    {
+      return 1 + Random() % 200u;
+    }
+  }
+}
+
+static uint32_t ModelTicksToNextExpiry(void)
+{
+  uint64_t  Soonest = ES_Timer_NO_EXPIRY;
+  uint8_t   Num;
+
+  for (Num = 0; Num < NUM_TIMERS; Num++)
+  {
+    if (ModelTimers[Num].Active &&
+        ((ModelTimers[Num].Expiry - ModelNow) < Soonest))
+    {
+      Soonest = ModelTimers[Num].Expiry - ModelNow;
+    }
+  }
+  return (uint32_t)Soonest;
+}
+
+// the model's side of a tick, after the wheel has had its
+static void ModelTick(void)
+{
+  uint64_t  Expected = 0;
+  uint8_t   Num;
+
+  for (Num = 0; Num < NUM_TIMERS; Num++)
+  {
+    if (ModelTimers[Num].Active && (ModelTimers[Num].Expiry == ModelNow))
+    {
+      Expected |= 1ULL << Num;
+      if (ModelTimers[Num].Period != 0)
+      {
+        ModelTimers[Num].Expiry = ModelNow + ModelTimers[Num].Period;
+      }
+      else
+      {
+        ModelTimers[Num].Active = false;
+        ModelTimers[Num].Remaining = 0;
+      }
+    }
+  }
+  if (Expected != TimedOut)
+  {
+    if (Errors < 10)
+    {
+      printf("tick %llu: expected %016llx, timed out %016llx\n",
+          (unsigned long long)ModelNow, (unsigned long long)Expected,
+          (unsigned long long)TimedOut);
+    }
+    Errors++;
+  }
+  TimedOut = 0;
+}
+
+static void RandomOperation(void)
+{
+  uint8_t       Num = Random() % NUM_TIMERS;
+  ModelTimer_t  *pModel = &ModelTimers[Num];
+  uint32_t      Time = RandomTime();
+  bool          OK = true;
+
+  switch (Random() % 6u)
+  {
+    case 0:
+    case 1:
+    {
+      OK = ES_Timer_InitTimer(Num, Time) == ES_Timer_OK;
+      pModel->Active = true;
+      pModel->Expiry = ModelNow + Time;
+      pModel->Remaining = Time;
+      pModel->Period = 0;
+    }
+    break;
+    case 2:
+    {
+      // periodic timers only with short periods, or they never come round
+      Time = 1 + Time % 300u;
+      OK = ES_Timer_InitPeriodicTimer(Num, Time) == ES_Timer_OK;
+      pModel->Active = true;
+      pModel->Expiry = ModelNow + Time;
+      pModel->Remaining = Time;
+      pModel->Period = Time;
+    }
+    break;
+    case 3:
+    {
+      OK = ES_Timer_SetTimer(Num, Time) == ES_Timer_OK;
+      pModel->Remaining = Time;
+      if (pModel->Active)
+      {
+        pModel->Expiry = ModelNow + Time;
+      }
+    }
+    break;
+    case 4:
+    {
+      OK = ES_Timer_StopTimer(Num) == ES_Timer_OK;
+      if (pModel->Active)
+      {
+        pModel->Active = false;
+        pModel->Remaining = (uint32_t)(pModel->Expiry - ModelNow);
+      }
+    }
+    break;
+    default:
+    {
+      // a timer with no time on it can not be started
+      OK = (ES_Timer_StartTimer(Num) == ES_Timer_OK) ==
+          (pModel->Remaining != 0);
+      if (!pModel->Active && (pModel->Remaining != 0))
+      {
+        pModel->Active = true;
+        pModel->Expiry = ModelNow + pModel->Remaining;
+      }
+    }
+    break;
+  }
+  if (!OK)
+  {
+    Errors++;
+  }
+}
+
+int main(void)
+{
+  uint32_t  Step;
+  uint32_t  Jump;
+  uint32_t  NumJumps = 0;
+  uint8_t   i;
+
+  puts("Testing the timing wheel against a reference model");
+  ES_Timer_Init(ES_Timer_RATE_1mS);
+  // all of the allocated timers as well as the fixed ones
+  for (i = 0; i < NUM_DYNAMIC_TIMERS; i++)
+  {
+    if (ES_Timer_AllocTimer(TestPost) != NUM_FIXED_TIMERS + i)
+    {
+      Errors++;
+    }
+  }
+  if (ES_Timer_AllocTimer(TestPost) != ES_Timer_NO_TIMER)
+  {
+    Errors++;
+  }
+  // with nothing running, the jump is done in one go
+  ModelNow = TEST_START_TICK;
+  ES_Timer_AdvanceTicks(TEST_START_TICK);
+
+  for (Step = 0; Step < NUM_TEST_STEPS; Step++)
+  {
+    if ((Random() % 4u) == 0)
+    {
+      RandomOperation();
+    }
+    if ((Random() % 8u) == 0)
+    {
+      // skip ahead to the next timeout, or part of the way there
+      Jump = ES_Timer_GetTicksToNextExpiry();
+      if (Jump != ModelTicksToNextExpiry())
+      {
+        Errors++;
+      }
+      if (Jump == ES_Timer_NO_EXPIRY)
+      {
+        continue;
+      }
+      if ((Random() % 2u) == 0)
+      {
+        Jump = 1 + Random() % Jump;
+      }
+      // no timer expires on the ticks jumped over, so only the last one
+      // has anything to check
+      ModelNow += Jump;
+      ES_Timer_AdvanceTicks(Jump);
+      NumJumps++;
+    }
+    else
+    {
+      ModelNow++;
+      ES_Timer_Tick_Resp();
+    }
+    ModelTick();
   }
+  printf("%u steps, %u jumps, %u timeouts, now at tick %llu\n",
+      NUM_TEST_STEPS, NumJumps, NumTimeouts, (unsigned long long)ModelNow);
+  printf("%u errors\n", Errors);
+  return Errors != 0;
 }
+#endif /* TEST && ES_PORT_POSIX */
 
 /*------------------------------- Footnotes -------------------------------*/
 /*------------------------------ End of file ------------------------------*/
@@ -0,0 +1,870 @@
+/****************************************************************************
+ Module
+     ES_Trace.c
+ Description
+     optional trace recorder. Every post, merge, refusal, publish and
+     dispatch adds a 12 byte record to a ring in RAM, so the last
+     ES_TRACE_SIZE of them can be looked at after something goes wrong,
+     without the printf calls that change the timing being chased.
+ Notes
+     Only compiled when ES_TRACE_SIZE is defined in ES_Configure.h. Adding a
+     record takes a time stamp and a short critical region, so it is safe
+     from interrupts, and once the ring is full the oldest records are lost.
+
+     Times come from _HW_GetCycleCount, so they wrap after 107 seconds on
+     the Tiva. The decoder assumes that no two records in a row are further
+     apart than that.
+
+     In a host build ES_Trace_Replay reads a captured dump back and feeds
+     the recorded dispatches, in order, straight to the run functions. The
+     posts that they make are checked against the recorded ones rather than
+     queued, and the replay stops at the first one that differs. Only a
+     capture that starts from reset (the ring never wrapped) replays from a
+     known state. Timers and the clock are not driven by the replay, the
+     timeouts show up as dispatches like any other event.
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 21:40         started coding
+*****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Configure.h"
+#include "ES_Trace.h"
+
+#ifdef ES_TRACE_SIZE
+
+#include "ES_General.h"
+#include "ES_Port.h"
+#include <stdio.h>
+#include <string.h>
+#ifdef ES_PORT_POSIX
+#include "ES_ServiceHeaders.h"
+#endif
+
+/*----------------------------- Module Defines ----------------------------*/
+#define TRACE_MASK (ES_TRACE_SIZE - 1)
+
+// the version of the dump format, bump it if the record line changes
+#define TRACE_FORMAT 1
+
+// the types are kept in a byte, this will fail to compile (negative array
+// size) if there are too many
+typedef char EventTypesCheck_t[(NUM_EVENT_TYPES <= 256) ? 1 : -1];
+
+/*---------------------------- Module Functions ---------------------------*/
+static void AddRecord(uint8_t Kind, uint8_t Source, uint8_t Interrupt,
+    uint8_t Target, ES_Event_t ThisEvent);
+#ifdef ES_PORT_POSIX
+static bool LoadCapture(char const *pFileName);
+static ES_TraceRecord_t const *NextExpected(void);
+static uint8_t PostClass(uint8_t Kind);
+static void ReportDivergence(char const *pWhat,
+    ES_TraceRecord_t const *pExpected, bool WasMade, uint8_t Kind,
+    uint8_t Target, ES_Event_t ThisEvent);
+#endif
+
+/*---------------------------- Module Variables ---------------------------*/
+static ES_TraceRecord_t Ring[ES_TRACE_SIZE];
+static uint32_t         Written;      // records ever added, wraps
+static bool             IsRecording;
+
+// the dispatch in progress, ES_Run is never re-entered so one is enough
+static uint8_t          RunningService = ES_TRACE_NO_SERVICE;
+
+#ifdef ES_PORT_POSIX
+// the run functions, so that the replay can call them directly
+typedef ES_Event_t RunFunc_t (ES_Event_t ThisEvent);
+
+#define RUN_ENTRY(Init, Run, QueueSize, Kind) Run,
+
+static RunFunc_t *const RunFuncs[NUM_SERVICES] = {
+  SERVICE_LIST(RUN_ENTRY)
+};
+
+#define NAME_ENTRY(Init, Run, QueueSize, Kind) #Run,
+
+static char const *const ServiceNames[NUM_SERVICES] = {
+  SERVICE_LIST(NAME_ENTRY)
+};
+
+static ES_TraceRecord_t Capture[ES_TRACE_SIZE];
+static uint32_t         CaptureCount;
+static uint32_t         ReplayNext;       // next capture record to look at
+static uint32_t         ReplayDispatch;   // the dispatch being replayed
+static bool             IsReplaying;
+static bool             HasDiverged;
+#endif
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+   ES_Trace_Init
+ Parameters
+   None
+ Returns
+   None
+ Description
+   empties the ring and starts recording
+ Notes
+   called by ES_Initialize before any of the services are initialized, so
+   that the posts made by their init functions are in the trace
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Trace_Init(void)
+{
+  Written = 0;
+  RunningService = ES_TRACE_NO_SERVICE;
+  IsRecording = true;
+}
+
+/****************************************************************************
+ Function
+   ES_Trace_Post
+ Parameters
+   uint8_t : what happened, ES_TRACE_POST, ES_TRACE_MERGED etc. with
+             ES_TRACE_REFUSED or'ed in if the event was lost
+   uint8_t : the service posted to, or ES_TRACE_BUS
+   ES_Event_t : the event as it was posted
+ Returns
+   None
+ Description
+   records a post, along with the run function or interrupt that made it
+ Notes
+   called from the framework post functions, possibly from an interrupt
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Trace_Post(uint8_t Kind, uint8_t Target, ES_Event_t ThisEvent)
+{
+  uint8_t Interrupt = _HW_GetActiveInterrupt();
+
+  AddRecord(Kind, (Interrupt != 0) ? ES_TRACE_NO_SERVICE : RunningService,
+      Interrupt, Target, ThisEvent);
+}
+
+/****************************************************************************
+ Function
+   ES_Trace_BeginRun
+ Parameters
+   uint8_t : the service that is about to run
+   ES_Event_t : the event it was given
+ Returns
+   None
+ Description
+   records the dispatch, and remembers the service so that the posts it
+   makes are put down to it
+ Notes
+   called by ES_Run just before the run function
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Trace_BeginRun(uint8_t WhichService, ES_Event_t ThisEvent)
+{
+  AddRecord(ES_TRACE_DISPATCH, ES_TRACE_NO_SERVICE, 0, WhichService,
+      ThisEvent);
+  RunningService = WhichService;
+}
+
+/****************************************************************************
+ Function
+   ES_Trace_EndRun
+ Parameters
+   None
+ Returns
+   None
+ Description
+   marks the end of the run function started by ES_Trace_BeginRun
+ Notes
+
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Trace_EndRun(void)
+{
+  RunningService = ES_TRACE_NO_SERVICE;
+}
+
+/****************************************************************************
+ Function
+   ES_Trace_Start
+ Parameters
+   None
+ Returns
+   None
+ Description
+   carries on recording after ES_Trace_Stop, the ring is kept
+ Notes
+
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Trace_Start(void)
+{
+  IsRecording = true;
+}
+
+/****************************************************************************
+ Function
+   ES_Trace_Stop
+ Parameters
+   None
+ Returns
+   None
+ Description
+   freezes the ring, so that the records leading up to a fault can be
+   kept while the application carries on
+ Notes
+   call it from wherever the problem is first noticed, then dump the ring
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Trace_Stop(void)
+{
+  IsRecording = false;
+}
+
+/****************************************************************************
+ Function
+   ES_Trace_Dump
+ Parameters
+   None
+ Returns
+   None
+ Description
+   prints the ring, oldest record first, in the form that
+   Tools/ES_TraceDecode.py and ES_Trace_Replay read:
+     ES_TRACE <format> <records written> <services> <cycles per uS>
+     one line of 22 hex digits per record: Time, Param, Type, Kind, Source,
+       Interrupt, Target
+     ES_TRACE_END
+ Notes
+   goes out through printf, which is uartstdio on the Tiva. Recording is
+   stopped while the ring is printed, so that the dump does not overwrite
+   what it is printing, then put back the way it was. This takes a long
+   time, so call it from somewhere that can afford it, like a keystroke
+   handler
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Trace_Dump(void)
+{
+  bool                    WasRecording = IsRecording;
+  uint32_t                Count;
+  uint32_t                Index;
+  ES_TraceRecord_t const  *pRecord;
+
+  IsRecording = false;
+  Count = (Written < ES_TRACE_SIZE) ? Written : ES_TRACE_SIZE;
+  printf("\r\nES_TRACE %u %lu %u %u\r\n", TRACE_FORMAT,
+      (unsigned long)Written, (unsigned)NUM_SERVICES,
+      (unsigned)ES_CYCLES_PER_US);
+  for (Index = Written - Count; Index != Written; Index++)
+  {
+    pRecord = &Ring[Index & TRACE_MASK];
+    printf("%08lx%04x%02x%02x%02x%02x%02x\r\n", (unsigned long)pRecord->Time,
+        (unsigned)pRecord->Param, (unsigned)pRecord->Type,
+        (unsigned)pRecord->Kind, (unsigned)pRecord->Source,
+        (unsigned)pRecord->Interrupt, (unsigned)pRecord->Target);
+  }
+  printf("ES_TRACE_END\r\n");
+  IsRecording = WasRecording;
+}
+
+#ifdef ES_PORT_POSIX
+/****************************************************************************
+ Function
+   ES_Trace_IsReplaying
+ Parameters
+   None
+ Returns
+   bool : true while ES_Trace_Replay is running
+ Description
+   tells the framework post functions to hand their posts to
+   ES_Trace_Replayed instead of queueing them
+ Notes
+
+ Author
+   10/17/26
+****************************************************************************/
+bool ES_Trace_IsReplaying(void)
+{
+  return IsReplaying;
+}
+
+/****************************************************************************
+ Function
+   ES_Trace_Replayed
+ Parameters
+   uint8_t : ES_TRACE_POST, ES_TRACE_LIFO or ES_TRACE_PUBLISH
+   uint8_t : the service posted to, or ES_TRACE_BUS
+   ES_Event_t : the event being posted
+ Returns
+   bool : what the post returned in the capture, true if there is no
+          matching record
+ Description
+   checks a post made by a replayed run function against the next one
+   that the same run function made in the capture, and records it
+ Notes
+   a post that was refused in the capture is refused again, so the code
+   that handles a full queue runs the same way
+ Author
+   10/17/26
+****************************************************************************/
+bool ES_Trace_Replayed(uint8_t Kind, uint8_t Target, ES_Event_t ThisEvent)
+{
+  ES_TraceRecord_t const *pExpected = NextExpected();
+
+  if (pExpected == NULL)
+  {
+    ReportDivergence("extra post", NULL, true, Kind, Target, ThisEvent);
+  }
+  else if ((PostClass(pExpected->Kind) != Kind) ||
+      (pExpected->Target != Target) ||
+      (pExpected->Type != (uint8_t)ThisEvent.EventType) ||
+      (pExpected->Param != ThisEvent.EventParam))
+  {
+    ReportDivergence("different post", pExpected, true, Kind, Target,
+        ThisEvent);
+  }
+  else
+  {
+    Kind = pExpected->Kind;
+    ReplayNext++;
+  }
+  ES_Trace_Post(Kind, Target, ThisEvent);
+  return (Kind & ES_TRACE_REFUSED) == 0;
+}
+
+/****************************************************************************
+ Function
+   ES_Trace_Replay
+ Parameters
+   char const * : the file holding the captured dump
+ Returns
+   bool : true if every dispatch in the capture made the same posts again
+ Description
+   calls the run functions with the recorded events in the recorded order,
+   and compares what they post with what they posted in the capture
+ Notes
+   call it after ES_Initialize, instead of ES_Run. Anything else in the
+   file, such as other terminal output, is skipped. The run functions are
+   called directly, so the queues, coalescing and the bus are not involved
+   and the Ready bits that the posts set are meaningless afterwards.
+   ES_Trace_Dump shows what the replay did
+ Author
+   10/17/26
+****************************************************************************/
+bool ES_Trace_Replay(char const *pFileName)
+{
+  ES_TraceRecord_t const  *pLeftOver;
+  ES_Event_t              ThisEvent;
+  uint32_t                NumDispatches = 0;
+  uint8_t                 WhichService;
+
+  if (LoadCapture(pFileName) != true)
+  {
+    return false;
+  }
+  ES_Trace_Init();
+  IsReplaying = true;
+  HasDiverged = false;
+  ReplayNext = 0;
+  while ((ReplayNext < CaptureCount) && (HasDiverged == false))
+  {
+    if (Capture[ReplayNext].Kind != ES_TRACE_DISPATCH)
+    {
+      ReplayNext++;
+      continue;
+    }
+    ReplayDispatch = ReplayNext++;
+    WhichService = Capture[ReplayDispatch].Target;
+    if (WhichService >= NUM_SERVICES)
+    {
+      printf("trace record %lu: no service %u\r\n",
+          (unsigned long)ReplayDispatch, (unsigned)WhichService);
+      HasDiverged = true;
+      break;
+    }
+    ThisEvent.EventType = (ES_EventType_t)Capture[ReplayDispatch].Type;
+    ThisEvent.EventParam = Capture[ReplayDispatch].Param;
+    ES_Trace_BeginRun(WhichService, ThisEvent);
+    RunFuncs[WhichService](ThisEvent);
+    ES_Trace_EndRun();
+    NumDispatches++;
+    // anything left over from this run was not posted this time
+    pLeftOver = NextExpected();
+    if (pLeftOver != NULL)
+    {
+      ReportDivergence("missing post", pLeftOver, false, 0, 0, ThisEvent);
+    }
+  }
+  IsReplaying = false;
+  printf("replayed %lu dispatches of %lu records, %s\r\n",
+      (unsigned long)NumDispatches, (unsigned long)CaptureCount,
+      HasDiverged ? "diverged" : "all posts matched");
+  return !HasDiverged;
+}
+#endif
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+/****************************************************************************
+ Function
+   AddRecord
+ Parameters
+   uint8_t : kind of record
+   uint8_t : the run function that made the post
+   uint8_t : the exception number of the interrupt that made it, or 0
+   uint8_t : the service or bus posted to, or the service dispatched
+   ES_Event_t : the event
+ Returns
+   None
+ Description
+   takes the next slot in the ring and fills it in
+ Notes
+   the slot is claimed and filled with interrupts off, so a post from an
+   interrupt cannot land in the middle of a record. The critical region
+   saves its own PRIMASK since the caller may already be in one.
+****************************************************************************/
+static void AddRecord(uint8_t Kind, uint8_t Source, uint8_t Interrupt,
+    uint8_t Target, ES_Event_t ThisEvent)
+{
+  ES_TraceRecord_t  *pRecord;
+  uint32_t          SavedPRIMASK;
+
+  if (IsRecording != true)
+  {
+    return;
+  }
+  SavedPRIMASK = CPUgetPRIMASK_cpsid();
+  pRecord = &Ring[Written & TRACE_MASK];
+  Written++;
+  pRecord->Time = _HW_GetCycleCount();
+  pRecord->Param = ThisEvent.EventParam;
+  pRecord->Type = (uint8_t)ThisEvent.EventType;
+  pRecord->Kind = Kind;
+  pRecord->Source = Source;
+  pRecord->Interrupt = Interrupt;
+  pRecord->Target = Target;
+  CPUsetPRIMASK(SavedPRIMASK);
+}
+
+#ifdef ES_PORT_POSIX
+/****************************************************************************
+ Function
+   LoadCapture
+ Parameters
+   char const * : the file holding the captured dump
+ Returns
+   bool : false if the file could not be read or held no complete dump
+ Description
+   reads the records of the last dump in the file into Capture
+ Notes
+
+****************************************************************************/
+static bool LoadCapture(char const *pFileName)
+{
+  FILE          *pFile = fopen(pFileName, "r");
+  char          Line[80];
+  unsigned      Format = 0;
+  unsigned      NumServices = 0;
+  unsigned long Total = 0;
+  unsigned long Time;
+  unsigned      Fields[6];
+  bool          InDump = false;
+  bool          IsComplete = false;
+
+  if (pFile == NULL)
+  {
+    printf("can't open %s\r\n", pFileName);
+    return false;
+  }
+  while (fgets(Line, sizeof(Line), pFile) != NULL)
+  {
+    if (sscanf(Line, "ES_TRACE %u %lu %u", &Format, &Total,
+        &NumServices) == 3)
+    {
+      InDump = true;
+      IsComplete = false;
+      CaptureCount = 0;
+    }
+    else if (strncmp(Line, "ES_TRACE_END", 12) == 0)
+    {
+      IsComplete = InDump;
+      InDump = false;
+    }
+    else if (InDump && (CaptureCount < ES_TRACE_SIZE) &&
+        (sscanf(Line, "%8lx%4x%2x%2x%2x%2x%2x", &Time, &Fields[0],
+        &Fields[1], &Fields[2], &Fields[3], &Fields[4], &Fields[5]) == 7))
+    {
+      Capture[CaptureCount].Time = (uint32_t)Time;
+      Capture[CaptureCount].Param = (uint16_t)Fields[0];
+      Capture[CaptureCount].Type = (uint8_t)Fields[1];
+      Capture[CaptureCount].Kind = (uint8_t)Fields[2];
+      Capture[CaptureCount].Source = (uint8_t)Fields[3];
+      Capture[CaptureCount].Interrupt = (uint8_t)Fields[4];
+      Capture[CaptureCount].Target = (uint8_t)Fields[5];
+      CaptureCount++;
+    }
+  }
+  fclose(pFile);
+
+  if (!IsComplete || (Format != TRACE_FORMAT))
+  {
+    printf("no complete format %u trace in %s\r\n", TRACE_FORMAT, pFileName);
+    return false;
+  }
+  if (NumServices != NUM_SERVICES)
+  {
+    printf("the trace has %u services, this build has %u\r\n", NumServices,
+        (unsigned)NUM_SERVICES);
+    return false;
+  }
+  if (Total > CaptureCount)
+  {
+    printf("the first %lu records were overwritten, the replay does not "
+        "start from reset\r\n", Total - CaptureCount);
+  }
+  return true;
+}
+
+/****************************************************************************
+ Function
+   NextExpected
+ Parameters
+   None
+ Returns
+   the next capture record made by the run function being replayed, or
+   NULL if it made no more
+ Description
+   skips over the posts made by interrupts, which are interleaved with the
+   run function's own, up to the next dispatch
+ Notes
+
+****************************************************************************/
+static ES_TraceRecord_t const *NextExpected(void)
+{
+  uint8_t WhichService = Capture[ReplayDispatch].Target;
+
+  while ((ReplayNext < CaptureCount) &&
+      (Capture[ReplayNext].Kind != ES_TRACE_DISPATCH))
+  {
+    if ((Capture[ReplayNext].Source == WhichService) &&
+        (Capture[ReplayNext].Interrupt == 0))
+    {
+      return &Capture[ReplayNext];
+    }
+    ReplayNext++;
+  }
+  return NULL;
+}
+
+/****************************************************************************
+ Function
+   PostClass
+ Parameters
+   uint8_t : the kind of a recorded post
+ Returns
+   uint8_t : the post call that made it, ES_TRACE_POST, ES_TRACE_LIFO or
+             ES_TRACE_PUBLISH
+ Description
+   a merge, or a refusal, was still a post as far as the run function knew
+ Notes
+
+****************************************************************************/
+static uint8_t PostClass(uint8_t Kind)
+{
+  Kind &= ~ES_TRACE_REFUSED;
+  return (Kind == ES_TRACE_MERGED) ? ES_TRACE_POST : Kind;
+}
+
+/****************************************************************************
+ Function
+   ReportDivergence
+ Parameters
+   char const * : what went wrong
+   ES_TraceRecord_t const * : the post that was expected, or NULL
+   bool : true if a post was made
+   uint8_t, uint8_t, ES_Event_t : the post that was made
+ Returns
+   None
+ Description
+   prints the first place that the replay differs from the capture
+ Notes
+
+****************************************************************************/
+static void ReportDivergence(char const *pWhat,
+    ES_TraceRecord_t const *pExpected, bool WasMade, uint8_t Kind,
+    uint8_t Target, ES_Event_t ThisEvent)
+{
+  ES_TraceRecord_t const *pDispatch = &Capture[ReplayDispatch];
+
+  if (HasDiverged)
+  {
+    return;   // only the first is worth anything
+  }
+  HasDiverged = true;
+  printf("trace record %lu: %s, running %s with event %u param %u\r\n",
+      (unsigned long)ReplayDispatch, pWhat, ServiceNames[pDispatch->Target],
+      (unsigned)pDispatch->Type, (unsigned)pDispatch->Param);
+  if (pExpected != NULL)
+  {
+    printf("  expected kind %u to %u, event %u param %u (record %lu)\r\n",
+        (unsigned)PostClass(pExpected->Kind), (unsigned)pExpected->Target,
+        (unsigned)pExpected->Type, (unsigned)pExpected->Param,
+        (unsigned long)(pExpected - Capture));
+  }
+  if (WasMade)
+  {
+    printf("  made kind %u to %u, event %u param %u\r\n", (unsigned)Kind,
+        (unsigned)Target, (unsigned)ThisEvent.EventType,
+        (unsigned)ThisEvent.EventParam);
+  }
+}
+#endif
+
+#if defined(TEST) && defined(ES_PORT_POSIX)
+/*
+  Host test of ES_Trace_Replay. Every service in SERVICE_LIST is replaced
+  by a stand-in that keeps a state made from every event it has been given
+  and posts an event made from that state to the next service, so a replay
+  only matches if each run function gets the same events in the same order
+  as in the capture. ES_Run records a short run from ES_Initialize, well
+  inside the ring, ES_Trace_Dump writes it to a file, and that is replayed
+  as it is, then with one stand-in posting a different event, leaving a
+  post out and adding one, each of which the replay has to report. Build
+  with:
+  gcc -DES_PORT_POSIX -I<app headers> -IHeaders -c Source/ES_Framework.c
+      Source/ES_Queue.c Source/ES_LookupTables.c Source/ES_Profile.c
+      Source/ES_Sched.c Source/ES_Bus.c
+  gcc -DTEST -DES_PORT_POSIX -I<app headers> -IHeaders Source/ES_Trace.c
+      ES_Framework.o ES_Queue.o ES_LookupTables.o ES_Profile.o ES_Sched.o
+      ES_Bus.o
+*/
+#include "ES_Framework.h"
+#include <unistd.h>
+
+#define CAPTURE_FILE "ES_Trace_test.txt"
+
+// dispatches to record, the ES_INIT ones and two records for each of these
+// have to fit in the ring
+#define NUM_TEST_DISPATCHES ((ES_TRACE_SIZE / 2) - NUM_SERVICES - 4)
+
+// the event the stand-ins pass on, the first user event so that no
+// coalescing rule or HSM event gets in the way
+#define TEST_EVENT (ES_EXIT + 1)
+
+// what the stand-in that posts at dispatch MUTATE_AT does wrong
+#define MUTATE_NONE   0
+#define MUTATE_PARAM  1
+#define MUTATE_SKIP   2
+#define MUTATE_EXTRA  3
+
+#define MUTATE_AT (NUM_TEST_DISPATCHES / 2)
+
+static uint32_t TestState[NUM_SERVICES];
+static uint32_t NumDispatched;
+static uint8_t  Mutation;
+static uint32_t Errors;
+
+// stand-ins for the port, so that this test links on its own. Nothing here
+// is an interrupt, so there is no critical region to emulate
+uint32_t _PRIMASK_temp;
+
+uint32_t CPUgetPRIMASK_cpsid(void)
+{
+  return 0;
+}
+
+void CPUsetPRIMASK(uint32_t newPRIMASK)
+{
+  (void)newPRIMASK;
+}
+
+uint32_t _HW_GetCycleCount(void)
+{
+  return NumDispatched;
+}
+
+bool _HW_Process_Pending_Ints(void)
+{
+  return true;
+}
+
+void _HW_Idle(void)
+{
+  // only reached if a post was lost, the stand-ins never let the queues
+  // empty
+  Errors++;
+}
+
+uint8_t _HW_GetActiveInterrupt(void)
+{
+  return 0;
+}
+
+uint16_t ES_Timer_GetTime(void)
+{
+  return 0;
+}
+
+void ES_Timer_Init(TimerRate_t Rate)
+{
+  (void)Rate;
+}
+
+bool ES_CheckUserEvents(void)
+{
+  return false;
+}
+
+#ifdef _INCLUDE_BASIC_FRAMEWORK_DEBUG_
+void _HW_DebugLines_Init(void) {}
+void _HW_DebugSetLine1(void) {}
+void _HW_DebugClearLine1(void) {}
+void _HW_DebugSetLine2(void) {}
+void _HW_DebugClearLine2(void) {}
+#endif
+
+static void Check(bool IsOK, char const *pWhat)
+{
+  if (!IsOK)
+  {
+    printf("FAIL: %s\n", pWhat);
+    Errors++;
+  }
+}
+
+static ES_Event_t TestRun(uint8_t WhichService, ES_Event_t ThisEvent)
+{
+  ES_Event_t  NextEvent;
+  uint8_t     NextService = (WhichService + 1) % NUM_SERVICES;
+
+  NextEvent.EventType = ES_NO_EVENT;
+  if (ThisEvent.EventType == ES_INIT)
+  {
+    TestState[WhichService] = WhichService + 1;
+    return NextEvent;
+  }
+  TestState[WhichService] = TestState[WhichService] * 1103515245u + 12345u +
+      ThisEvent.EventParam;
+  if (++NumDispatched == NUM_TEST_DISPATCHES)
+  {
+    NextEvent.EventType = ES_ERROR;   // and out of ES_Run
+    return NextEvent;
+  }
+  NextEvent.EventType = TEST_EVENT;
+  NextEvent.EventParam = (uint16_t)(TestState[WhichService] >> 16);
+  if (NumDispatched == MUTATE_AT)
+  {
+    if (Mutation == MUTATE_PARAM)
+    {
+      NextEvent.EventParam ^= 1;
+    }
+    else if (Mutation == MUTATE_SKIP)
+    {
+      NextEvent.EventType = ES_NO_EVENT;
+      return NextEvent;
+    }
+    else if (Mutation == MUTATE_EXTRA)
+    {
+      ES_PostToService(WhichService, NextEvent);
+    }
+  }
+  Check(ES_PostToService(NextService, NextEvent), "post refused");
+  NextEvent.EventType = ES_NO_EVENT;
+  return NextEvent;
+}
+
+// the stand-ins, named after the real services so that they fill the same
+// places in ServDescList and RunFuncs
+#define TEST_SERVICE_ENTRY(Init, Run, QueueSize, Kind)   \
+  bool Init(uint8_t Priority)                            \
+  {                                                      \
+    ES_Event_t ThisEvent = { ES_INIT, 0 };               \
+    return ES_PostToService(Priority, ThisEvent);        \
+  }                                                      \
+  ES_Event_t Run(ES_Event_t ThisEvent)                   \
+  {                                                      \
+    return TestRun(ServIndex_##Run, ThisEvent);          \
+  }
+
+#define SERV_INDEX_ENTRY(Init, Run, QueueSize, Kind) ServIndex_##Run,
+
+enum
+{
+  SERVICE_LIST(SERV_INDEX_ENTRY)
+};
+
+SERVICE_LIST(TEST_SERVICE_ENTRY)
+
+// writes the ring to CAPTURE_FILE, as it would be captured from a terminal
+static bool DumpToFile(void)
+{
+  FILE  *pFile = fopen(CAPTURE_FILE, "w");
+  int   SavedStdout;
+
+  if (pFile == NULL)
+  {
+    return false;
+  }
+  fflush(stdout);
+  SavedStdout = dup(STDOUT_FILENO);
+  dup2(fileno(pFile), STDOUT_FILENO);
+  printf("some other terminal output\r\n");
+  ES_Trace_Dump();
+  fflush(stdout);
+  dup2(SavedStdout, STDOUT_FILENO);
+  close(SavedStdout);
+  fclose(pFile);
+  return true;
+}
+
+static bool ReplayWith(uint8_t WhichMutation)
+{
+  Mutation = WhichMutation;
+  NumDispatched = 0;
+  return ES_Trace_Replay(CAPTURE_FILE);
+}
+
+int main(void)
+{
+  ES_Event_t  FirstEvent = { TEST_EVENT, 0 };
+  uint32_t    Recorded;
+
+  printf("ES_Trace_Replay, %u services, %u dispatches\n", NUM_SERVICES,
+      (unsigned)NUM_TEST_DISPATCHES);
+  if (ES_Initialize(ES_Timer_RATE_1mS) != Success)
+  {
+    puts("ES_Initialize failed");
+    return 1;
+  }
+  ES_PostToService(0, FirstEvent);
+  Check(ES_Run() == FailedRun, "ES_Run did not stop");
+  Check(NumDispatched == NUM_TEST_DISPATCHES, "wrong number of dispatches");
+  Recorded = Written;
+  Check(Recorded <= ES_TRACE_SIZE, "the recording wrapped the ring");
+  ES_Trace_Stop();
+  Check(DumpToFile(), "can't write " CAPTURE_FILE);
+
+  Check(ReplayWith(MUTATE_NONE), "the unchanged services diverged");
+  // all but the ES_INIT posts and FirstEvent, which no run function made
+  Check(Written == Recorded - NUM_SERVICES - 1,
+      "the replay recorded a different trace");
+  Check(!ReplayWith(MUTATE_PARAM), "a different post was not reported");
+  Check(!ReplayWith(MUTATE_SKIP), "a missing post was not reported");
+  Check(!ReplayWith(MUTATE_EXTRA), "an extra post was not reported");
+  Check(!ES_Trace_Replay("no such file"), "a missing file replayed");
+  Check(ReplayWith(MUTATE_NONE), "a good replay after a bad one failed");
+
+  remove(CAPTURE_FILE);
+  printf("%lu errors\n", (unsigned long)Errors);
+  return (Errors == 0) ? 0 : 1;
+}
+#endif /* TEST && ES_PORT_POSIX */
+
+#endif /* ES_TRACE_SIZE */
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
@@ -16,6 +16,7 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/17/26 21:20         added Check4TraceKey
  08/06/13 13:36 jec     initial version
 ****************************************************************************/
 
@@ -37,6 +38,7 @@
 // include our own prototypes to insure consistency between header &
 // actual functionsdefinition
 #include "EventCheckers.h"
+#include "ES_Trace.h"
 
 // This is the event checking function sample. It is not intended to be
 // included in the module. It is only here as a sample to guide you in writing
@@ -118,3 +120,50 @@ bool Check4Lock(void)
   }
   return false;
 }*/
+
+/****************************************************************************
+ Function
+   Check4TraceKey
+ Parameters
+   None
+ Returns
+   bool: true if a trace key was handled
+ Description
+   'T' stops the trace recorder and dumps the ring, so that the posts and
+   dispatches leading up to whatever was just seen on the robot can be
+   captured from the terminal. The ring stays frozen, so 'T' again prints
+   the same records, until 't' starts recording again
+ Notes
+   the dump goes out through printf and holds up the framework while it
+   does, which is fine for a debug key. Other keys are thrown away, nothing
+   else in this project reads the keyboard. Without ES_TRACE_SIZE the keys
+   are only thrown away.
+ Author
+   10/17/26
+****************************************************************************/
+bool Check4TraceKey(void)
+{
+  char Key;
+
+  if (!IsNewKeyReady())
+  {
+    return false;
+  }
+  Key = GetNewKey();
+#ifdef ES_TRACE_SIZE
+  if (Key == 'T')
+  {
+    ES_Trace_Stop();
+    ES_Trace_Dump();
+    return true;
+  }
+  if (Key == 't')
+  {
+    ES_Trace_Start();
+    printf("trace recording\r\n");
+    return true;
+  }
+#endif
+  (void)Key;
+  return false;
+}
@@ -108,7 +108,7 @@ static uint32_t getArrayAvg(uint32_t arrayToSum[]);
 /*---------------------------- Module Variables ---------------------------*/
 // everybody needs a state variable, you may need others as well
 static LineFollowingState_t CurrentState;
-static uint32_t             FieldStrengths[3];  //used to not have static declaration
+static uint32_t             FieldStrengths[4];  //all 4 A/D results land here
 static bool                 firstSwitchType;    //false means left, true means right
 static bool                 OnWire;
 static const float          pGain_forward = 0.020;// worked with offset speed 35
@@ -316,7 +316,15 @@ LineFollowingState_t QueryLineFollowingSM(void)
 //event checker for checking for wire
 bool Check4Wire(void)
 {
-  ADC_MultiRead(FieldStrengths);
+  static uint32_t LastSample = 0;
+  uint32_t        ThisSample = ADC_MultiLatest(FieldStrengths);
+
+  //nothing new since last time, don't count the same sample twice
+  if (ThisSample == LastSample)
+  {
+    return false;
+  }
+  LastSample = ThisSample;
 
   static uint32_t InductorValsLeft[RUNNING_AVG_ARRAY_LEN] = { 0 };
   static uint32_t InductorValsRight[RUNNING_AVG_ARRAY_LEN] = { 0 };
@@ -365,8 +373,11 @@ void ControlLaw(void)
   static uint32_t InductorValsRight[RUNNING_AVG_ARRAY_LEN] = { 0 };
   static uint32_t arrayPos = 0;
 
-  //Read magnetic field strengths
-  ADC_MultiRead(FieldStrengths);
+  //Read magnetic field strengths, leave the motors alone until there are some
+  if (ADC_MultiLatest(FieldStrengths) == 0)
+  {
+    return;
+  }
   InductorValsLeft[arrayPos & 0x07] = FieldStrengths[LEFT_INDUCT] + LEFT_INDUCTOR_OFFSET;
   InductorValsRight[arrayPos & 0x07] = FieldStrengths[RIGHT_INDUCT];
   arrayPos++;
@@ -13,6 +13,7 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/17/26 20:40         moved onto the ES_Hsm tables
  02/27/17 09:48 jec      another correction to re-assign both CurrentEvent
                          and ReturnEvent to the result of the During function
                          this eliminates the need for the prior fix and allows
@@ -52,6 +53,7 @@
 // Basic includes for a program using the Events and Services Framework
 #include "ES_Configure.h"
 #include "ES_Framework.h"
+#include "ES_Hsm.h"
 
 /* include header files for this state machine as well as any machines at the
    next lower level in the hierarchy that are sub-machines to this machine
@@ -86,23 +88,74 @@
 #define RETROREFLECTIVE_SEND_PERIOD 300 //500 worked?
 
 /*---------------------------- Module Functions ---------------------------*/
-/* prototypes for private functions for this machine, thibgungs like during
-   functions, entry & exit functions.They should be functions relevant to the
-   behavior of this state machine
+/* prototypes for private functions for this machine, things like entry &
+   exit functions, guards and actions. They should be functions relevant to
+   the behavior of this state machine
 */
+static void EnterReloading(ES_Event_t EntryEvent);
+static void ExitReloading(void);
 static ES_Event_t DuringReloading(ES_Event_t Event);
-static ES_Event_t DuringRotatingShoot(ES_Event_t Event);
+static void EnterRotatingShoot(ES_Event_t EntryEvent);
+static void ExitRotating(void);
+static void EnterFindingShot(ES_Event_t EntryEvent);
+static void ExitFindingShot(void);
 static ES_Event_t DuringFindingShot(ES_Event_t Event);
+static void EnterShooting(ES_Event_t EntryEvent);
+static void ExitShooting(void);
 static ES_Event_t DuringShooting(ES_Event_t Event);
-static ES_Event_t DuringMovingBackward(ES_Event_t Event);
-static ES_Event_t DuringRotatingToDefinitelyShoot(ES_Event_t Event);
+static void EnterMovingBackward(ES_Event_t EntryEvent);
+static void ExitMovingBackward(void);
+static void EnterRotatingToDefinitelyShoot(ES_Event_t EntryEvent);
+static bool IsHandshakeTimer(ES_Event_t Event);
+static bool IsRetroreflectiveTimer(ES_Event_t Event);
+static bool IsDarkHorseTimer(ES_Event_t Event);
+static void CountBallLoaded(ES_Event_t Event);
+static void ClearRetroEdges(ES_Event_t Event);
 
 /*---------------------------- Module Variables ---------------------------*/
-// everybody needs a state variable, you may need others as well
-static OffenseState_t CurrentState;
-static uint32_t       LastCaptureRetroreflective;
-static uint32_t       NumRetroEdges = 0;
-static bool           FaceOff = true;
+// the machine is described by these two tables (see ES_Hsm.h) rather than
+// by nested switch statements. RELOADING and SHOOTING run the Reloading and
+// Shooting machines below them from their entry, exit & during functions.
+#define OFFENSE_STATES(ES_HSM_STATE)                                        \
+  ES_HSM_STATE(RELOADING, ES_HSM_TOP, ES_HSM_NO_STATE,                      \
+      EnterReloading, ExitReloading, DuringReloading)                       \
+  ES_HSM_STATE(ROTATING_TO_SHOOT, ES_HSM_TOP, ES_HSM_NO_STATE,              \
+      EnterRotatingShoot, ExitRotating, NULL)                               \
+  ES_HSM_STATE(MOVING_BACKWARD, ES_HSM_TOP, ES_HSM_NO_STATE,                \
+      EnterMovingBackward, ExitMovingBackward, NULL)                        \
+  ES_HSM_STATE(FINDING_SHOT, ES_HSM_TOP, ES_HSM_NO_STATE,                   \
+      EnterFindingShot, ExitFindingShot, DuringFindingShot)                 \
+  ES_HSM_STATE(SHOOTING, ES_HSM_TOP, ES_HSM_NO_STATE,                       \
+      EnterShooting, ExitShooting, DuringShooting)                          \
+  ES_HSM_STATE(ROTATING_TO_DEFINITELY_SHOOT, ES_HSM_TOP, ES_HSM_NO_STATE,   \
+      EnterRotatingToDefinitelyShoot, ExitRotating, NULL)
+
+// back up off the reloader, turn to the goal, look for a clear shot and
+// shoot, backing up again if the shot is blocked. EV_EARLY_DEFENSE starts
+// looking for the shot again. None of these consume the event, the play
+// machine sees them too.
+#define OFFENSE_TRANSITIONS(ES_HSM_TRANSITION)                              \
+  ES_HSM_TRANSITION(RELOADING, ES_TIMEOUT, MOVING_BACKWARD,                 \
+      IsHandshakeTimer, CountBallLoaded, ES_HSM_EXTERNAL | ES_HSM_PASS_ON)  \
+  ES_HSM_TRANSITION(ROTATING_TO_SHOOT, EV_ATTACK_GOAL_DETECTED,             \
+      FINDING_SHOT, NULL, NULL, ES_HSM_EXTERNAL | ES_HSM_PASS_ON)           \
+  ES_HSM_TRANSITION(FINDING_SHOT, ES_TIMEOUT, SHOOTING,                     \
+      IsRetroreflectiveTimer, NULL, ES_HSM_EXTERNAL | ES_HSM_PASS_ON)       \
+  ES_HSM_TRANSITION(FINDING_SHOT, EV_OBJECT_DETECTED_RETRO,                 \
+      MOVING_BACKWARD, NULL, ClearRetroEdges,                               \
+      ES_HSM_EXTERNAL | ES_HSM_PASS_ON)                                     \
+  ES_HSM_TRANSITION(FINDING_SHOT, EV_EARLY_DEFENSE, FINDING_SHOT,           \
+      NULL, NULL, ES_HSM_EXTERNAL | ES_HSM_PASS_ON)                         \
+  ES_HSM_TRANSITION(MOVING_BACKWARD, ES_TIMEOUT, ROTATING_TO_SHOOT,         \
+      IsDarkHorseTimer, NULL, ES_HSM_EXTERNAL | ES_HSM_PASS_ON)             \
+  ES_HSM_TRANSITION(ROTATING_TO_DEFINITELY_SHOOT, EV_ATTACK_GOAL_DETECTED,  \
+      SHOOTING, NULL, NULL, ES_HSM_EXTERNAL | ES_HSM_PASS_ON)
+
+ES_HSM_DEFINE(OffenseHsm, OFFENSE_STATES, OFFENSE_TRANSITIONS, ENTRY_STATE);
+
+static uint32_t LastCaptureRetroreflective;
+static uint32_t NumRetroEdges = 0;
+static bool     FaceOff = true;
 
 /*------------------------------ Module Code ------------------------------*/
 /****************************************************************************
@@ -113,212 +166,20 @@ static bool           FaceOff = true;
    ES_Event_t: the event to process
 
  Returns
-   ES_Event_t: an event to return
+   ES_Event_t: ES_NO_EVENT if the event was consumed, otherwise the event,
+   for the upper level state machine
 
  Description
-   add your description here
+   hands the event to the table driven machine
  Notes
-   uses nested switch/case to implement the machine.
+   ES_ENTRY, ES_ENTRY_HISTORY & ES_EXIT start and stop the machine, so the
+   play machine drives it the same as any other lower level machine
  Author
    J. Edward Carryer, 2/11/05, 10:45AM
 ****************************************************************************/
 ES_Event_t RunOffenseSM(ES_Event_t CurrentEvent)
 {
-  bool            MakeTransition = false;/* are we making a state transition? */
-  OffenseState_t  NextState = CurrentState;
-  ES_Event_t      EntryEventKind = { ES_ENTRY, 0 }; // default to normal entry to new state
-  ES_Event_t      ReturnEvent = CurrentEvent;       // assume we are not consuming event
-
-  switch (CurrentState)
-  {
-    case RELOADING: // If current state is state one
-    {               // Execute During function for state one. ES_ENTRY & ES_EXIT are
-                    // processed here allow the lower level state machines to re-map
-                    // or consume the event
-      ReturnEvent = CurrentEvent = DuringReloading(CurrentEvent);
-      //process any events
-      if (CurrentEvent.EventType != ES_NO_EVENT)      //If an event is active
-      {
-        switch (CurrentEvent.EventType)
-        {
-          case ES_TIMEOUT:  //If event is event one
-          {                 // Execute action function for state one : event one
-            if (CurrentEvent.EventParam == HANDSHAKE_TIMER)
-            {
-              SetNumBalls(GetNumBalls() + 1);
-              NextState = MOVING_BACKWARD;      //Decide what the next state will be
-              // for internal transitions, skip changing MakeTransition
-              MakeTransition = true;       //mark that we are taking a transition
-              // if transitioning to a state with history change kind of entry
-              //EntryEventKind.EventType = ES_ENTRY_HISTORY;
-              // optionally, consume or re-map this event for the upper
-              // level state machine
-              //ReturnEvent.EventType = ES_NO_EVENT;
-            }
-          }
-          break;
-            // repeat cases as required for relevant events
-        }
-      }
-    }
-    break;
-    // repeat state pattern as required for other states
-
-    case ROTATING_TO_SHOOT: // If current state is state one
-    {                       // Execute During function for state one. ES_ENTRY & ES_EXIT are
-                            // processed here allow the lower level state machines to re-map
-                            // or consume the event
-      ReturnEvent = CurrentEvent = DuringRotatingShoot(CurrentEvent);
-      //process any events
-      if (CurrentEvent.EventType != ES_NO_EVENT)      //If an event is active
-      {
-        switch (CurrentEvent.EventType)
-        {
-          case EV_ATTACK_GOAL_DETECTED:                                 //If event is event one
-          {                                                             // Execute action function for state one : event one
-
-            NextState = FINDING_SHOT;        //Decide what the next state will be
-
-            // for internal transitions, skip changing MakeTransition
-            MakeTransition = true;       //mark that we are taking a transition
-            // if transitioning to a state with history change kind of entry
-            //EntryEventKind.EventType = ES_ENTRY_HISTORY;
-            // optionally, consume or re-map this event for the upper
-            // level state machine
-            //ReturnEvent.EventType = ES_NO_EVENT;
-          }
-          break;
-            // repeat cases as required for relevant events
-        }
-      }
-    }
-    break;
-
-    case FINDING_SHOT:  // If current state is state one
-    {                   // Execute During function for state one. ES_ENTRY & ES_EXIT are
-                        // processed here allow the lower level state machines to re-map
-                        // or consume the event
-      ReturnEvent = CurrentEvent = DuringFindingShot(CurrentEvent);
-      //process any events
-      if (CurrentEvent.EventType != ES_NO_EVENT)      //If an event is active
-      {
-        switch (CurrentEvent.EventType)
-        {
-          // Execute action function for state one : event one
-          case ES_TIMEOUT:
-          {
-            if (CurrentEvent.EventParam == RETROREFLECTIVE_TIMER)
-            {
-              NextState = SHOOTING;
-              MakeTransition = true;
-            }
-          }
-          break;
-
-          case EV_OBJECT_DETECTED_RETRO:
-          {
-            ResetRetroEdges();
-            NextState = MOVING_BACKWARD;
-            MakeTransition = true;
-          }
-          break;
-          case EV_EARLY_DEFENSE:
-          {
-            ReturnEvent.EventParam = MAKE_DEFENSE_ENTRY_STATE_ROTATING;
-            MakeTransition = true;
-          }
-          break;
-        }
-      }
-    }
-    break;
-    // for internal transitions, skip changing MakeTransition
-    //mark that we are taking a transition
-    // if transitioning to a state with history change kind of entry
-    //EntryEventKind.EventType = ES_ENTRY_HISTORY;
-    // optionally, consume or re-map this event for the upper
-    // level state machine
-    //ReturnEvent.EventType = ES_NO_EVENT;
-    // repeat cases as required for relevant events
-
-    case MOVING_BACKWARD:
-    {
-      ReturnEvent = CurrentEvent = DuringMovingBackward(CurrentEvent);
-      if (CurrentEvent.EventType != ES_NO_EVENT)        //If an event is active
-      {
-        switch (CurrentEvent.EventType)
-        {
-          case ES_TIMEOUT:       //If event is event one
-          { if (CurrentEvent.EventParam == DARK_HORSE_TIMER)
-            {
-              // Execute action function for state one : event one
-
-              NextState = ROTATING_TO_SHOOT;
-
-              // for internal transitions, skip changing MakeTransition
-              MakeTransition = true;       //mark that we are taking a transition
-              // if transitioning to a state with history change kind of entry
-              //EntryEventKind.EventType = ES_ENTRY_HISTORY;
-              // optionally, consume or re-map this event for the upper
-              // level state machine
-              //ReturnEvent.EventType = ES_NO_EVENT;
-            }
-          }
-          break;
-        }
-      }
-    }
-    break;
-    case SHOOTING:  // If current state is state one
-    {               // Execute During function for state one. ES_ENTRY & ES_EXIT are
-                    // processed here allow the lower level state machines to re-map
-                    // or consume the event
-      ReturnEvent = CurrentEvent = DuringShooting(CurrentEvent);
-      //process any events
-      if (CurrentEvent.EventType != ES_NO_EVENT)      //If an event is active
-      {
-      }
-    }
-    break;
-    case ROTATING_TO_DEFINITELY_SHOOT:
-      ReturnEvent = CurrentEvent = DuringRotatingToDefinitelyShoot(CurrentEvent);
-      //process any events
-      if (CurrentEvent.EventType != ES_NO_EVENT)      //If an event is active
-      {
-        switch (CurrentEvent.EventType)
-        {
-          case EV_ATTACK_GOAL_DETECTED:
-          {
-            // Execute action function for state one : event one
-
-            NextState = SHOOTING;
-
-            // for internal transitions, skip changing MakeTransition
-            MakeTransition = true;       //mark that we are taking a transition
-            // if transitioning to a state with history change kind of entry
-            //EntryEventKind.EventType = ES_ENTRY_HISTORY;
-            // optionally, consume or re-map this event for the upper
-            // level state machine
-            //ReturnEvent.EventType = ES_NO_EVENT;
-          }
-          break;
-        }
-      }
-  }
-  //   If we are making a state transition
-  if (MakeTransition == true)
-  {
-    //   Execute exit function for current state
-    CurrentEvent.EventType = ES_EXIT;
-    RunOffenseSM(CurrentEvent);
-
-    CurrentState = NextState;    //Modify state variable
-
-    //   Execute entry function for new state
-    // this defaults to ES_ENTRY
-    RunOffenseSM(EntryEventKind);
-  }
-  return ReturnEvent;
+  return ES_Hsm_Dispatch(&OffenseHsm, CurrentEvent);
 }
 
 /****************************************************************************
@@ -326,7 +187,7 @@ ES_Event_t RunOffenseSM(ES_Event_t CurrentEvent)
      StartOffense_SM
 
  Parameters
-     None
+     ES_Event_t: ES_ENTRY, or ES_ENTRY_HISTORY to go back to the last state
 
  Returns
      None
@@ -334,35 +195,30 @@ ES_Event_t RunOffenseSM(ES_Event_t CurrentEvent)
  Description
      Does any required initialization for this state machine
  Notes
-
+     backs straight off the line at the face off, goes to shoot with balls
+     on board, and to reload otherwise
  Author
      J. Edward Carryer, 2/18/99, 10:38AM
 ****************************************************************************/
 void StartOffenseSM(ES_Event_t CurrentEvent)
 {
-  // to implement entry to a history state or directly to a substate
-  // you can modify the initialization of the CurrentState variable
-  // otherwise just start in the entry state every time the state machine
-  // is started
-
   if (ES_ENTRY_HISTORY != CurrentEvent.EventType)
   {
     if (FaceOff)
     {
-      CurrentState = MOVING_BACKWARD;  //LINE_FOLLOWING_OFFENSE;
+      ES_Hsm_SetInitial(&OffenseHsm, MOVING_BACKWARD); //LINE_FOLLOWING_OFFENSE;
       FaceOff = false;
     }
     else if (GetNumBalls() > 1)
     {
-      CurrentState = ROTATING_TO_SHOOT;
+      ES_Hsm_SetInitial(&OffenseHsm, ROTATING_TO_SHOOT);
     }
     else
     {
-      CurrentState = ENTRY_STATE;
+      ES_Hsm_SetInitial(&OffenseHsm, ENTRY_STATE);
     }
   }
-  // call the entry function (if any) for the ENTRY_STATE
-  RunOffenseSM(CurrentEvent);
+  ES_Hsm_Start(&OffenseHsm, CurrentEvent);
 }
 
 /****************************************************************************
@@ -384,7 +240,7 @@ void StartOffenseSM(ES_Event_t CurrentEvent)
 ****************************************************************************/
 OffenseState_t QueryOffenseSM(void)
 {
-  return CurrentState;
+  return (OffenseState_t)ES_Hsm_Query(&OffenseHsm);
 }
 
 void SetFaceoffFalse(void)
@@ -396,291 +252,174 @@ void SetFaceoffFalse(void)
  private functions
  ***************************************************************************/
 
-static ES_Event_t DuringReloading(ES_Event_t Event)
+static void EnterReloading(ES_Event_t EntryEvent)
 {
-  ES_Event_t ReturnEvent = Event;   // assume no re-mapping or consumption
-
-  // process ES_ENTRY, ES_ENTRY_HISTORY & ES_EXIT events
-  if ((Event.EventType == ES_ENTRY) ||
-      (Event.EventType == ES_ENTRY_HISTORY))
-  {
-    // implement any entry actions required for this state machine
-    // after that start any lower level machines that run in this state
-    StartReloadingSM(Event);
+  // start the lower level machine that runs in this state
+  StartReloadingSM(EntryEvent);
+}
 
-    // repeat the StartxxxSM() functions for concurrent state machines
-    // on the lower level
-  }
-  else if (Event.EventType == ES_EXIT)
-  {
-    // on exit, give the lower levels a chance to clean up first
-    RunReloadingSM(Event);
+static void ExitReloading(void)
+{
+  ES_Event_t ExitEvent = { ES_EXIT, 0 };
 
-    // repeat for any concurrently running state machines
-    // now do any local exit functionality
-  }
-  else
-  // do the 'during' function for this state
-  {
-    // run any lower level state machine
-    ReturnEvent = RunReloadingSM(Event);
+  RunReloadingSM(ExitEvent);
+}
 
-    // repeat for any concurrent lower level machines
-    // do any activity that is repeated as long as we are in this state
-  }
-  // return either Event, if you don't want to allow the lower level machine
-  // to remap the current event, or ReturnEvent if you do want to allow it.
-  return ReturnEvent;
+static ES_Event_t DuringReloading(ES_Event_t Event)
+{
+  // let the lower level machine consume or re-map the event
+  return RunReloadingSM(Event);
 }
 
 //Do we need to start an event checker for a goal??
-static ES_Event_t DuringRotatingShoot(ES_Event_t Event)
+static void EnterRotatingShoot(ES_Event_t EntryEvent)
 {
-  ES_Event_t ReturnEvent = Event;   // assume no re-mapping or consumption
+  //Looking for goal now, set number edges = 0
+  ResetGoalEdges();
 
-  // process ES_ENTRY, ES_ENTRY_HISTORY & ES_EXIT events
-  if ((Event.EventType == ES_ENTRY) ||
-      (Event.EventType == ES_ENTRY_HISTORY))
-  {
-    // implement any entry actions required for this state machine
-    
-    //Looking for goal now, set number edges = 0
-    ResetGoalEdges();
-    
-    // enable the Timer A in Wide Timer 3 interrupt in the NVIC (goal detection)
-    // it is interrupt number 100 so appears in EN3 at bit 4
-    HWREG(WTIMER3_BASE + TIMER_O_IMR) |= TIMER_IMR_CAEIM;
-
-
-    // enable the Timer B in Wide Timer 1 interrupt in the NVIC
-    // it is interrupt number 97 so appears in EN3 at bit 1
-//        HWREG(NVIC_EN3) |= BIT1HI;
+  // enable the Timer A in Wide Timer 3 interrupt in the NVIC (goal detection)
+  // it is interrupt number 100 so appears in EN3 at bit 4
+  HWREG(WTIMER3_BASE + TIMER_O_IMR) |= TIMER_IMR_CAEIM;
 
-    //Begin Rotating
-    RotateRight(DEFAULT_DUTY_CYCLE);
+  // enable the Timer B in Wide Timer 1 interrupt in the NVIC
+  // it is interrupt number 97 so appears in EN3 at bit 1
+//        HWREG(NVIC_EN3) |= BIT1HI;
 
-    // after that start any lower level machines that run in this state
-    //StartLowerLevelSM( Event );
-    // repeat the StartxxxSM() functions for concurrent state machines
-    // on the lower level
-  }
-  else if (Event.EventType == ES_EXIT)
-  {
-    // on exit, give the lower levels a chance to clean up first
-    //RunLowerLevelSM(Event);
-    // repeat for any concurrently running state machines
-    // now do any local exit functionality
-    StopMotors();
-
-    // disable the Timer B in Wide Timer 3 interrupt in the NVIC
-    // it is interrupt number 100 so appears in EN3 at bit 4 (goal detection)
-    HWREG(WTIMER3_BASE + TIMER_O_IMR) &= ~TIMER_IMR_CAEIM;
-  }
-  else
-  // do the 'during' function for this state
-  {
-    // run any lower level state machine
-    // ReturnEvent = RunLowerLevelSM(Event);
-    // repeat for any concurrent lower level machines
-    // do any activity that is repeated as long as we are in this state
-  }
-  // return either Event, if you don't want to allow the lower level machine
-  // to remap the current event, or ReturnEvent if you do want to allow it.
-  return ReturnEvent;
+  //Begin Rotating
+  RotateRight(DEFAULT_DUTY_CYCLE);
 }
 
-
-static ES_Event_t DuringFindingShot(ES_Event_t Event)
+// shared by both rotating states
+static void ExitRotating(void)
 {
-  ES_Event_t ReturnEvent = Event;   // assume no re-mapping or consumption
-
-  // process ES_ENTRY, ES_ENTRY_HISTORY & ES_EXIT events
-  if ((Event.EventType == ES_ENTRY) ||
-      (Event.EventType == ES_ENTRY_HISTORY))
-  {
-    // implement any entry actions required for this state machine
-    NumRetroEdges = 0;
+  StopMotors();
 
-    //Disable PWM1 (PB4 and PB5) while initializing
-    HWREG(PWM0_BASE + PWM_O_1_CTL) = 0;
-    //Set half the period (load = period/4/32 - adjusting for difference in clock to PWM and timers)
-    HWREG(PWM0_BASE + PWM_O_1_LOAD) = RETROREFLECTIVE_SEND_PERIOD >> 1;
-    //Set value at which pin changes state (50% duty cycle)
-    HWREG(PWM0_BASE + PWM_O_1_CMPB) = RETROREFLECTIVE_SEND_PERIOD >> 2;
-    //Set up+down count mode, enable PWM generator, and make generate update locally
-    //synchronized to zero count
-    HWREG(PWM0_BASE + PWM_O_1_CTL) = (PWM_1_CTL_MODE | PWM_1_CTL_ENABLE |
-        PWM_1_CTL_GENAUPD_LS | PWM_1_CTL_GENBUPD_LS);
+  // disable the Timer B in Wide Timer 3 interrupt in the NVIC
+  // it is interrupt number 100 so appears in EN3 at bit 4 (goal detection)
+  HWREG(WTIMER3_BASE + TIMER_O_IMR) &= ~TIMER_IMR_CAEIM;
+}
 
-    //enable local interrupt for retroref receiver
-    HWREG(WTIMER1_BASE + TIMER_O_IMR) |= TIMER_IMR_CBEIM;
+static void EnterFindingShot(ES_Event_t EntryEvent)
+{
+  NumRetroEdges = 0;
 
-    //Turn on retroreflective emitter
-    HWREG(PWM0_BASE + PWM_O_ENABLE) |= PWM_ENABLE_PWM3EN;
+  //Disable PWM1 (PB4 and PB5) while initializing
+  HWREG(PWM0_BASE + PWM_O_1_CTL) = 0;
+  //Set half the period (load = period/4/32 - adjusting for difference in clock to PWM and timers)
+  HWREG(PWM0_BASE + PWM_O_1_LOAD) = RETROREFLECTIVE_SEND_PERIOD >> 1;
+  //Set value at which pin changes state (50% duty cycle)
+  HWREG(PWM0_BASE + PWM_O_1_CMPB) = RETROREFLECTIVE_SEND_PERIOD >> 2;
+  //Set up+down count mode, enable PWM generator, and make generate update locally
+  //synchronized to zero count
+  HWREG(PWM0_BASE + PWM_O_1_CTL) = (PWM_1_CTL_MODE | PWM_1_CTL_ENABLE |
+      PWM_1_CTL_GENAUPD_LS | PWM_1_CTL_GENBUPD_LS);
 
-    ES_Timer_InitTimer(RETROREFLECTIVE_TIMER, RETROREFLECTIVE_TIMER_DURATION);
-  }
-  else if (Event.EventType == ES_EXIT)
-  {
-    // on exit, give the lower levels a chance to clean up first
-    //RunLowerLevelSM(Event);
-    //Disable PWM3 (pin PB5)
-    HWREG(PWM0_BASE + PWM_O_ENABLE) &= ~PWM_ENABLE_PWM3EN;
-    // disable the Timer B in Wide Timer 1 interrupt in the NVIC
-    // it is interrupt number 97 so appears in EN3 at bit 1
-    HWREG(WTIMER1_BASE + TIMER_O_IMR) &= ~TIMER_IMR_CBEIM;
-    // now do any local exit functionality
-  }
-  else
-  // do the 'during' function for this state
-  {
-    // run any lower level state machine
-    // ReturnEvent = RunLowerLevelSM(Event);
+  //enable local interrupt for retroref receiver
+  HWREG(WTIMER1_BASE + TIMER_O_IMR) |= TIMER_IMR_CBEIM;
 
-    // repeat for any concurrent lower level machines
+  //Turn on retroreflective emitter
+  HWREG(PWM0_BASE + PWM_O_ENABLE) |= PWM_ENABLE_PWM3EN;
 
-    // do any activity that is repeated as long as we are in this state
-  }
-  // return either Event, if you don't want to allow the lower level machine
-  // to remap the current event, or ReturnEvent if you do want to allow it.
-  return ReturnEvent;
+  ES_Timer_InitTimer(RETROREFLECTIVE_TIMER, RETROREFLECTIVE_TIMER_DURATION);
 }
 
-static ES_Event_t DuringShooting(ES_Event_t Event)
+static void ExitFindingShot(void)
 {
-  ES_Event_t ReturnEvent = Event;   // assume no re-mapping or consumption
+  //Disable PWM3 (pin PB5)
+  HWREG(PWM0_BASE + PWM_O_ENABLE) &= ~PWM_ENABLE_PWM3EN;
+  // disable the Timer B in Wide Timer 1 interrupt in the NVIC
+  // it is interrupt number 97 so appears in EN3 at bit 1
+  HWREG(WTIMER1_BASE + TIMER_O_IMR) &= ~TIMER_IMR_CBEIM;
+}
 
-  // process ES_ENTRY, ES_ENTRY_HISTORY & ES_EXIT events
-  if ((Event.EventType == ES_ENTRY) ||
-      (Event.EventType == ES_ENTRY_HISTORY))
+static ES_Event_t DuringFindingShot(ES_Event_t Event)
+{
+  // tell the play machine which defense state to start in
+  if (Event.EventType == EV_EARLY_DEFENSE)
   {
-    // implement any entry actions required for this state machine
+    Event.EventParam = MAKE_DEFENSE_ENTRY_STATE_ROTATING;
+  }
+  return Event;
+}
 
-    //Turn on flywheel (enable PWM)
-    HWREG(PWM0_BASE + PWM_O_ENABLE) |= PWM_ENABLE_PWM6EN;
+static void EnterShooting(ES_Event_t EntryEvent)
+{
+  //Turn on flywheel (enable PWM)
+  HWREG(PWM0_BASE + PWM_O_ENABLE) |= PWM_ENABLE_PWM6EN;
 
-    //Start timer for flywheel turning on
-    ES_Timer_InitTimer(SHOOTING_TIMER, FLYWHEEL_WAIT_DURATION);
+  //Start timer for flywheel turning on
+  ES_Timer_InitTimer(SHOOTING_TIMER, FLYWHEEL_WAIT_DURATION);
 
-    // after that start any lower level machines that run in this state
-    StartShootingSM(Event);
+  // after that start the lower level machine that runs in this state
+  StartShootingSM(EntryEvent);
+}
 
-    // repeat the StartxxxSM() functions for concurrent state machines
-    // on the lower level
-  }
-  else if (Event.EventType == ES_EXIT)
-  {
-    // on exit, give the lower levels a chance to clean up first
-    RunShootingSM(Event);
+static void ExitShooting(void)
+{
+  ES_Event_t ExitEvent = { ES_EXIT, 0 };
 
-    // repeat for any concurrently running state machines
-    // now do any local exit functionality
+  // on exit, give the lower level a chance to clean up first
+  RunShootingSM(ExitEvent);
 
-    //Turn off flywheel (disable PWM to PD0)
-    HWREG(PWM0_BASE + PWM_O_ENABLE) &= ~PWM_ENABLE_PWM6EN;
+  //Turn off flywheel (disable PWM to PD0)
+  HWREG(PWM0_BASE + PWM_O_ENABLE) &= ~PWM_ENABLE_PWM6EN;
 
-    //Get number of balls correct (if all balls gone, extra ghost ball so that
-    //ball wheel turns the right amount next time)
-    if (GetNumBalls() <= 0)
-    {
-      SetNumBalls(1);
-    }
-  }
-  else
-  // do the 'during' function for this state
+  //Get number of balls correct (if all balls gone, extra ghost ball so that
+  //ball wheel turns the right amount next time)
+  if (GetNumBalls() <= 0)
   {
-    // run any lower level state machine
-    ReturnEvent = RunShootingSM(Event);
-
-    // repeat for any concurrent lower level machines
-    // do any activity that is repeated as long as we are in this state
+    SetNumBalls(1);
   }
-  // return either Event, if you don't want to allow the lower level machine
-  // to remap the current event, or ReturnEvent if you do want to allow it.
-  return ReturnEvent;
 }
 
-static ES_Event_t DuringMovingBackward(ES_Event_t Event)
+static ES_Event_t DuringShooting(ES_Event_t Event)
 {
-  ES_Event_t ReturnEvent = Event; // assume no re-mapping or consumption
-
-  // process ES_ENTRY, ES_ENTRY_HISTORY & ES_EXIT events
-  if ((Event.EventType == ES_ENTRY) ||
-      (Event.EventType == ES_ENTRY_HISTORY))
-  {
-    // implement any entry actions required for this state machine
-
-    //Start timer for flywheel turning on
-    ES_Timer_InitTimer(DARK_HORSE_TIMER, DARK_HORSE_DURATION);
-    DriveBackward(REVERSE_SPEED);
+  // let the lower level machine consume or re-map the event
+  return RunShootingSM(Event);
+}
 
-    // repeat the StartxxxSM() functions for concurrent state machines
-    // on the lower level
-  }
-  else if (Event.EventType == ES_EXIT)
-  {
-    // on exit, give the lower levels a chance to clean up first
+static void EnterMovingBackward(ES_Event_t EntryEvent)
+{
+  //Start timer for flywheel turning on
+  ES_Timer_InitTimer(DARK_HORSE_TIMER, DARK_HORSE_DURATION);
+  DriveBackward(REVERSE_SPEED);
+}
 
-    // repeat for any concurrently running state machines
-    // now do any local exit functionality
+static void ExitMovingBackward(void)
+{
+  StopMotors();
+}
 
-    StopMotors();
-  }
-  else
-  // do the 'during' function for this state
-  {
-    // run any lower level state machine
+//Do we need to start an event checker for a goal??
+static void EnterRotatingToDefinitelyShoot(ES_Event_t EntryEvent)
+{
+  //Begin Rotating
+  RotateRight(DEFAULT_DUTY_CYCLE);
+}
 
-    // repeat for any concurrent lower level machines
-    // do any activity that is repeated as long as we are in this state
-  }
-  // return either Event, if you don't want to allow the lower level machine
-  // to remap the current event, or ReturnEvent if you do want to allow it.
-  return ReturnEvent;
+static bool IsHandshakeTimer(ES_Event_t Event)
+{
+  return Event.EventParam == HANDSHAKE_TIMER;
 }
 
-//Do we need to start an event checker for a goal??
-static ES_Event_t DuringRotatingToDefinitelyShoot(ES_Event_t Event)
+static bool IsRetroreflectiveTimer(ES_Event_t Event)
 {
-  ES_Event_t ReturnEvent = Event;   // assume no re-mapping or consumption
+  return Event.EventParam == RETROREFLECTIVE_TIMER;
+}
 
-  // process ES_ENTRY, ES_ENTRY_HISTORY & ES_EXIT events
-  if ((Event.EventType == ES_ENTRY) ||
-      (Event.EventType == ES_ENTRY_HISTORY))
-  {
-    // implement any entry actions required for this state machine
+static bool IsDarkHorseTimer(ES_Event_t Event)
+{
+  return Event.EventParam == DARK_HORSE_TIMER;
+}
 
-    //Begin Rotating
-    RotateRight(DEFAULT_DUTY_CYCLE);
+static void CountBallLoaded(ES_Event_t Event)
+{
+  SetNumBalls(GetNumBalls() + 1);
+}
 
-    // after that start any lower level machines that run in this state
-    //StartLowerLevelSM( Event );
-    // repeat the StartxxxSM() functions for concurrent state machines
-    // on the lower level
-  }
-  else if (Event.EventType == ES_EXIT)
-  {
-    // on exit, give the lower levels a chance to clean up first
-    //RunLowerLevelSM(Event);
-    // repeat for any concurrently running state machines
-    // now do any local exit functionality
-    StopMotors();
-
-    // disable the Timer B in Wide Timer 3 interrupt in the NVIC
-    // it is interrupt number 100 so appears in EN3 at bit 4 (goal detection)
-    HWREG(WTIMER3_BASE + TIMER_O_IMR) &= ~TIMER_IMR_CAEIM;
-  }
-  else
-  // do the 'during' function for this state
-  {
-    // run any lower level state machine
-    // ReturnEvent = RunLowerLevelSM(Event);
-    // repeat for any concurrent lower level machines
-    // do any activity that is repeated as long as we are in this state
-  }
-  // return either Event, if you don't want to allow the lower level machine
-  // to remap the current event, or ReturnEvent if you do want to allow it.
-  return ReturnEvent;
+static void ClearRetroEdges(ES_Event_t Event)
+{
+  ResetRetroEdges();
 }
 
 void Retroreflective_ISR(void)
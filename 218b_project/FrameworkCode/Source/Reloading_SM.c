@@ -13,6 +13,7 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/17/26 20:40         moved onto the ES_Hsm tables
  02/27/17 09:48 jec      another correction to re-assign both CurrentEvent
                          and ReturnEvent to the result of the During function
                          this eliminates the need for the prior fix and allows
@@ -52,6 +53,7 @@
 // Basic includes for a program using the Events and Services Framework
 #include "ES_Configure.h"
 #include "ES_Framework.h"
+#include "ES_Hsm.h"
 
 /* include header files for this state machine as well as any machines at the
    next lower level in the hierarchy that are sub-machines to this machine
@@ -81,25 +83,63 @@
 #define OVERTIME_FLAG 5
 
 /*---------------------------- Module Functions ---------------------------*/
-/* prototypes for private functions for this machine, things like during
-   functions, entry & exit functions.They should be functions relevant to the
-   behavior of this state machine
+/* prototypes for private functions for this machine, things like entry &
+   exit functions, guards and actions. They should be functions relevant to
+   the behavior of this state machine
 */
-static ES_Event_t DuringRotatingBeacon(ES_Event_t Event);
+static void EnterRotatingBeacon(ES_Event_t EntryEvent);
+static void ExitRotatingBeacon(void);
+static void EnterLineFollowingReloader(ES_Event_t EntryEvent);
+static void ExitLineFollowingReloader(void);
 static ES_Event_t DuringLineFollowingReloader(ES_Event_t Event);
-static ES_Event_t DuringReading(ES_Event_t Event);
-static ES_Event_t DuringWaitingBall(ES_Event_t Event);
+static void EnterReading(ES_Event_t EntryEvent);
+static void ExitReading(void);
+static bool IsRotateTimer(ES_Event_t Event);
+static bool IsHandshakeTimer(ES_Event_t Event);
+static bool IsOffense(ES_Event_t Event);
+static void TurnPastBeacon(ES_Event_t Event);
+static void GoToOffense(ES_Event_t Event);
 
 /*---------------------------- Module Variables ---------------------------*/
-// everybody needs a state variable, you may need others as well
-static ReloadingState_t CurrentState;
-static uint32_t         NumEdges;
-static uint32_t         LastPeriod;
-static uint32_t         LastCapture;
-static int8_t           NumBalls;
-static bool             RightSwitchHit;
-static bool             LeftSwitchHit;
-static bool             Reloading = true;
+// the machine is described by these two tables (see ES_Hsm.h) rather than
+// by nested switch statements
+#define RELOADING_STATES(ES_HSM_STATE)                                      \
+  ES_HSM_STATE(ROTATING_TO_BEACON, ES_HSM_TOP, ES_HSM_NO_STATE,             \
+      EnterRotatingBeacon, ExitRotatingBeacon, NULL)                        \
+  ES_HSM_STATE(LINE_FOLLOWING_RELOADING, ES_HSM_TOP, ES_HSM_NO_STATE,       \
+      EnterLineFollowingReloader, ExitLineFollowingReloader,                \
+      DuringLineFollowingReloader)                                          \
+  ES_HSM_STATE(READING, ES_HSM_TOP, ES_HSM_NO_STATE,                        \
+      EnterReading, ExitReading, NULL)                                      \
+  ES_HSM_STATE(WAITING_FOR_BALL, ES_HSM_TOP, ES_HSM_NO_STATE,               \
+      NULL, NULL, NULL)
+
+// turn a little further once the beacon is seen, follow the line in to the
+// reloader, then hand shake with it until the master machine says to go on
+// to offense. The handshake timeout goes on up to the Offense machine, which
+// counts the ball.
+#define RELOADING_TRANSITIONS(ES_HSM_TRANSITION)                            \
+  ES_HSM_TRANSITION(ROTATING_TO_BEACON, EV_RELOADER_DETECTED,               \
+      ROTATING_TO_BEACON, NULL, TurnPastBeacon, ES_HSM_INTERNAL)            \
+  ES_HSM_TRANSITION(ROTATING_TO_BEACON, ES_TIMEOUT,                         \
+      LINE_FOLLOWING_RELOADING, IsRotateTimer, NULL, ES_HSM_EXTERNAL)       \
+  ES_HSM_TRANSITION(LINE_FOLLOWING_RELOADING, EV_SWITCH_HIT, READING,       \
+      NULL, NULL, ES_HSM_EXTERNAL)                                          \
+  ES_HSM_TRANSITION(READING, EV_STATE_CHANGE, WAITING_FOR_BALL,             \
+      IsOffense, NULL, ES_HSM_EXTERNAL)                                     \
+  ES_HSM_TRANSITION(WAITING_FOR_BALL, ES_TIMEOUT, WAITING_FOR_BALL,         \
+      IsHandshakeTimer, GoToOffense, ES_HSM_INTERNAL | ES_HSM_PASS_ON)
+
+ES_HSM_DEFINE(ReloadingHsm, RELOADING_STATES, RELOADING_TRANSITIONS,
+    ENTRY_STATE);
+
+static uint32_t NumEdges;
+static uint32_t LastPeriod;
+static uint32_t LastCapture;
+static int8_t   NumBalls;
+static bool     RightSwitchHit;
+static bool     LeftSwitchHit;
+static bool     Reloading = true;
 
 /*------------------------------ Module Code ------------------------------*/
 /****************************************************************************
@@ -110,173 +150,20 @@ static bool             Reloading = true;
    ES_Event_t: the event to process
 
  Returns
-   ES_Event_t: an event to return
+   ES_Event_t: ES_NO_EVENT if the event was consumed, otherwise the event,
+   for the upper level state machine
 
  Description
-   add your description here
+   hands the event to the table driven machine
  Notes
-   uses nested switch/case to implement the machine.
+   ES_ENTRY, ES_ENTRY_HISTORY & ES_EXIT start and stop the machine, so the
+   upper level machines drive it the same as any other lower level machine
  Author
    J. Edward Carryer, 2/11/05, 10:45AM
 ****************************************************************************/
 ES_Event_t RunReloadingSM(ES_Event_t CurrentEvent)
 {
-  bool              MakeTransition = false;/* are we making a state transition? */
-  ReloadingState_t  NextState = CurrentState;
-  ES_Event_t        EntryEventKind = { ES_ENTRY, 0 }; // default to normal entry to new state
-  ES_Event_t        ReturnEvent = CurrentEvent;       // assume we are not consuming event
-
-  switch (CurrentState)
-  {
-    case ROTATING_TO_BEACON:  // If current state is state one
-    {                         // Execute During function for state one. ES_ENTRY & ES_EXIT are
-      // processed here allow the lower level state machines to re-map
-      // or consume the event
-      ReturnEvent = CurrentEvent = DuringRotatingBeacon(CurrentEvent);
-      //process any events
-      if (CurrentEvent.EventType != ES_NO_EVENT) //If an event is active
-      {
-        switch (CurrentEvent.EventType)
-        {
-          case EV_RELOADER_DETECTED:  //If event is event one
-          {                           // Execute action function for state one : event one
-
-            //start timer to turn more
-            ES_Timer_InitTimer(RELOADING_ROTATE_TIMER, ROTATING_DURATION);
-            HWREG(WTIMER3_BASE + TIMER_O_IMR) &= ~TIMER_IMR_CBEIM;
-
-            // for internal transitions, skip changing MakeTransition
-//          MakeTransition = true; //mark that we are taking a transition
-            // if transitioning to a state with history change kind of entry
-            //EntryEventKind.EventType = ES_ENTRY_HISTORY;
-            // optionally, consume or re-map this event for the upper
-            // level state machine
-            ReturnEvent.EventType = ES_NO_EVENT;
-          }
-          break;
-          // repeat cases as required for relevant events
-
-          case ES_TIMEOUT:  //If event is event one
-          {                 // Execute action function for state one : event one
-            if (CurrentEvent.EventParam == RELOADING_ROTATE_TIMER)
-            {
-              NextState = LINE_FOLLOWING_RELOADING;//Decide what the next state will be
-
-              // for internal transitions, skip changing MakeTransition
-              MakeTransition = true; //mark that we are taking a transition
-              // if transitioning to a state with history change kind of entry
-              //EntryEventKind.EventType = ES_ENTRY_HISTORY;
-              // optionally, consume or re-map this event for the upper
-              // level state machine
-              ReturnEvent.EventType = ES_NO_EVENT;
-            }
-          }
-          break;
-        }
-      }
-    }
-    break;
-
-    case LINE_FOLLOWING_RELOADING:  // If current state is state one
-    {                               // Execute During function for state one. ES_ENTRY & ES_EXIT are
-      // processed here allow the lower level state machines to re-map
-      // or consume the event
-      ReturnEvent = CurrentEvent = DuringLineFollowingReloader(CurrentEvent);
-      //process any events
-      if (CurrentEvent.EventType != ES_NO_EVENT) //If an event is active
-      {
-        switch (CurrentEvent.EventType)
-        {
-          case EV_SWITCH_HIT:     //If event is event one
-          {                       // Execute action function for state one : event one
-            NextState = READING;  //Decide what the next state will be
-
-            // for internal transitions, skip changing MakeTransition
-            MakeTransition = true; //mark that we are taking a transition
-            // if transitioning to a state with history change kind of entry
-            //EntryEventKind.EventType = ES_ENTRY_HISTORY;
-            // optionally, consume or re-map this event for the upper
-            // level state machine
-            ReturnEvent.EventType = ES_NO_EVENT;
-          }
-          break;
-            // repeat cases as required for relevant events
-        }
-      }
-    }
-    break;
-
-    // repeat state pattern as required for other states
-    case READING: // If current state is state one
-    {             // Execute During function for state one. ES_ENTRY & ES_EXIT are
-      // processed here allow the lower level state machines to re-map
-      // or consume the event
-      ReturnEvent = CurrentEvent = DuringReading(CurrentEvent);
-      //process any events
-      if (CurrentEvent.EventType != ES_NO_EVENT) //If an event is active
-      {
-        switch (CurrentEvent.EventType)
-        {
-          case EV_STATE_CHANGE:
-          {
-            if (CurrentEvent.EventParam == (PlayState_t)OFFENSE)
-            {
-              NextState = WAITING_FOR_BALL;//Decide what the next state will be
-
-              // for internal transitions, skip changing MakeTransition
-              MakeTransition = true; //mark that we are taking a transition
-              // if transitioning to a state with history change kind of entry
-              //EntryEventKind.EventType = ES_ENTRY_HISTORY;
-              // optionally, consume or re-map this event for the upper
-              // level state machine
-              ReturnEvent.EventType = ES_NO_EVENT;
-            }
-          }
-          break;
-        }
-      }
-    }
-    break;
-    // repeat state pattern as required for other states
-
-    case WAITING_FOR_BALL:        // If current state is state one
-      // Execute During function for state one. ES_ENTRY & ES_EXIT are
-      // processed here allow the lower level state machines to re-map
-      // or consume the event
-      ReturnEvent = CurrentEvent = DuringWaitingBall(CurrentEvent);
-      //process any events
-      if (CurrentEvent.EventType != ES_NO_EVENT) //If an event is active
-      {
-        switch (CurrentEvent.EventType)
-        {
-          case ES_TIMEOUT:
-          {
-            if (CurrentEvent.EventParam == HANDSHAKE_TIMER)
-            {
-              ES_Event_t ThisEvent;
-              ThisEvent.EventType = EV_STATE_CHANGE;
-              ThisEvent.EventParam = (PlayState_t)OFFENSE;
-              PostMasterSM(ThisEvent);
-            }
-          }
-          break;
-        }
-      }
-  }
-  //   If we are making a state transition
-  if (MakeTransition == true)
-  {
-    //   Execute exit function for current state
-    CurrentEvent.EventType = ES_EXIT;
-    RunReloadingSM(CurrentEvent);
-
-    CurrentState = NextState; //Modify state variable
-
-    //   Execute entry function for new state
-    // this defaults to ES_ENTRY
-    RunReloadingSM(EntryEventKind);
-  }
-  return ReturnEvent;
+  return ES_Hsm_Dispatch(&ReloadingHsm, CurrentEvent);
 }
 
 /****************************************************************************
@@ -284,7 +171,9 @@ ES_Event_t RunReloadingSM(ES_Event_t CurrentEvent)
      StartReloadingSM
 
  Parameters
-     None
+     ES_Event_t: ES_ENTRY, or ES_ENTRY_HISTORY to go back to the last state.
+     An ES_ENTRY with OVERTIME_FLAG as its parameter starts the handshake
+     hardware as well
 
  Returns
      None
@@ -298,10 +187,6 @@ ES_Event_t RunReloadingSM(ES_Event_t CurrentEvent)
 ****************************************************************************/
 void StartReloadingSM(ES_Event_t CurrentEvent)
 {
-  // to implement entry to a history state or directly to a substate
-  // you can modify the initialization of the CurrentState variable
-  // otherwise just start in the entry state every time the state machine
-  // is started
   if (ES_ENTRY_HISTORY != CurrentEvent.EventType)
   {
     //either rotate or directly pidcontrol depending on where we are
@@ -317,16 +202,15 @@ void StartReloadingSM(ES_Event_t CurrentEvent)
     }
     if (Reloading)
     {
-      CurrentState = LINE_FOLLOWING_RELOADING;
+      ES_Hsm_SetInitial(&ReloadingHsm, LINE_FOLLOWING_RELOADING);
       Reloading = false;
     }
     else
     {
-      CurrentState = ENTRY_STATE;     //rotating to reload beacon
+      ES_Hsm_SetInitial(&ReloadingHsm, ENTRY_STATE); //rotating to reload beacon
     }
   }
-  // call the entry function (if any) for the ENTRY_STATE
-  RunReloadingSM(CurrentEvent);
+  ES_Hsm_Start(&ReloadingHsm, CurrentEvent);
 }
 
 /****************************************************************************
@@ -348,7 +232,7 @@ void StartReloadingSM(ES_Event_t CurrentEvent)
 ****************************************************************************/
 ReloadingState_t QueryReloadingSM(void)
 {
-  return CurrentState;
+  return (ReloadingState_t)ES_Hsm_Query(&ReloadingHsm);
 }
 
 /***************************************************************************
@@ -414,163 +298,88 @@ void Handshake_ISR(void)
   LastCapture = ThisCapture;
 }
 
-static ES_Event_t DuringRotatingBeacon(ES_Event_t Event)
+static void EnterRotatingBeacon(ES_Event_t EntryEvent)
 {
-  ES_Event_t ReturnEvent = Event;   // assume no re-mapping or consumption
+  RotateLeft(65);
+  HWREG(WTIMER3_BASE + TIMER_O_IMR) |= TIMER_IMR_CBEIM;
+  ResetReloadEdges();
+}
 
-  // process ES_ENTRY, ES_ENTRY_HISTORY & ES_EXIT events
-  if ((Event.EventType == ES_ENTRY) ||
-      (Event.EventType == ES_ENTRY_HISTORY))
-  {
-    // implement any entry actions required for this state machine
-    RotateLeft(65);
-    HWREG(WTIMER3_BASE + TIMER_O_IMR) |= TIMER_IMR_CBEIM;
-    ResetReloadEdges();
-
-    // after that start any lower level machines that run in this state
-    //StartLowerLevelSM( Event );
-    // repeat the StartxxxSM() functions for concurrent state machines
-    // on the lower level
-  }
-  else if (Event.EventType == ES_EXIT)
-  {
-    // on exit, give the lower levels a chance to clean up first
-    //RunLowerLevelSM(Event);
-    // repeat for any concurrently running state machines
+static void ExitRotatingBeacon(void)
+{
+  HWREG(WTIMER3_BASE + TIMER_O_IMR) &= ~TIMER_IMR_CBEIM;
+  StopMotors();
+}
 
-    // now do any local exit functionality
-    HWREG(WTIMER3_BASE + TIMER_O_IMR) &= ~TIMER_IMR_CBEIM;
-    StopMotors();
-  }
-  else
-  // do the 'during' function for this state
-  {
-    // run any lower level state machine
-    // ReturnEvent = RunLowerLevelSM(Event);
-    // repeat for any concurrent lower level machines
-    // do any activity that is repeated as long as we are in this state
-  }
-  // return either Event, if you don't want to allow the lower level machine
-  // to remap the current event, or ReturnEvent if you do want to allow it.
-  return ReturnEvent;
+static void EnterLineFollowingReloader(ES_Event_t EntryEvent)
+{
+  // start lower level machine that runs in this state
+  StartLineFollowingSM(EntryEvent);
 }
 
-static ES_Event_t DuringLineFollowingReloader(ES_Event_t Event)
+static void ExitLineFollowingReloader(void)
 {
-  ES_Event_t ReturnEvent = Event;   // assume no re-mapping or consumption
+  ES_Event_t ExitEvent = { ES_EXIT, 0 };
 
-  // process ES_ENTRY, ES_ENTRY_HISTORY & ES_EXIT events
-  if ((Event.EventType == ES_ENTRY) ||
-      (Event.EventType == ES_ENTRY_HISTORY))
-  {
-    // implement any entry actions required for this state machine
-    // after that, start lower level machine that runS in this state
-    StartLineFollowingSM(Event);
-  }
-  else if (Event.EventType == ES_EXIT)
-  {
-    // on exit, give the lower levels a chance to clean up first
-    RunLineFollowingSM(Event);
-    // repeat for any concurrently running state machines
-    // now do any local exit functionality
-  }
-  else
-  // do the 'during' function for this state
-  {
-    // run any lower level state machine
-    ReturnEvent = RunLineFollowingSM(Event);
+  RunLineFollowingSM(ExitEvent);
+}
 
-    // repeat for any concurrent lower level machines
-    // do any activity that is repeated as long as we are in this state
-  }
-  // return either Event, if you don't want to allow the lower level machine
-  // to remap the current event, or ReturnEvent if you do want to allow it.
-  return ReturnEvent;
+static ES_Event_t DuringLineFollowingReloader(ES_Event_t Event)
+{
+  // let the lower level machine consume or re-map the event
+  return RunLineFollowingSM(Event);
 }
 
-static ES_Event_t DuringReading(ES_Event_t Event)
+static void EnterReading(ES_Event_t EntryEvent)
 {
-  ES_Event_t ReturnEvent = Event;   // assume no re-mapping or consumption
+  //enable local interrupt for handshake ir
+  HWREG(WTIMER0_BASE + TIMER_O_IMR) |= TIMER_IMR_CAEIM;
 
-  // process ES_ENTRY, ES_ENTRY_HISTORY & ES_EXIT events
-  if ((Event.EventType == ES_ENTRY) ||
-      (Event.EventType == ES_ENTRY_HISTORY))
-  {
-    // implement any entry actions required for this state machine
+  //Enable PWM output
+  HWREG(PWM0_BASE + PWM_O_ENABLE) |= PWM_ENABLE_PWM2EN;
+  NumEdges = 0;
 
-    //enable local interrupt for handshake ir
-    HWREG(WTIMER0_BASE + TIMER_O_IMR) |= TIMER_IMR_CAEIM;
+  ES_Timer_InitTimer(HANDSHAKE_TIMER, HANDSHAKE_DURATION);
+}
 
-    //Enable PWM output
-    HWREG(PWM0_BASE + PWM_O_ENABLE) |= PWM_ENABLE_PWM2EN;
-    NumEdges = 0;
+static void ExitReading(void)
+{
+  // disable the Timer A in Wide Timer 0 interrupt in the NVIC
+  // it is interrupt number 94 so appears in EN2 at bit 30
+//        HWREG(NVIC_DIS2) = BIT30HI;
+  HWREG(WTIMER0_BASE + TIMER_O_IMR) &= ~TIMER_IMR_CAEIM;
+  //Disable PWM output
+  HWREG(PWM0_BASE + PWM_O_ENABLE) &= ~PWM_ENABLE_PWM2EN;
+}
 
-    ES_Timer_InitTimer(HANDSHAKE_TIMER, HANDSHAKE_DURATION);
+static bool IsRotateTimer(ES_Event_t Event)
+{
+  return Event.EventParam == RELOADING_ROTATE_TIMER;
+}
 
-    // after that start any lower level machines that run in this state
-    //StartLowerLevelSM( Event );
-    // repeat the StartxxxSM() functions for concurrent state machines
-    // on the lower level
-  }
-  else if (Event.EventType == ES_EXIT)
-  {
-    // on exit, give the lower levels a chance to clean up first
-    //RunLowerLevelSM(Event);
-    // repeat for any concurrently running state machines
-    // now do any local exit functionality
+static bool IsHandshakeTimer(ES_Event_t Event)
+{
+  return Event.EventParam == HANDSHAKE_TIMER;
+}
 
-    // disable the Timer A in Wide Timer 0 interrupt in the NVIC
-    // it is interrupt number 94 so appears in EN2 at bit 30
-//        HWREG(NVIC_DIS2) = BIT30HI;
-    HWREG(WTIMER0_BASE + TIMER_O_IMR) &= ~TIMER_IMR_CAEIM;
-    //Disable PWM output
-    HWREG(PWM0_BASE + PWM_O_ENABLE) &= ~PWM_ENABLE_PWM2EN;
-  }
-  else
-  // do the 'during' function for this state
-  {
-    // run any lower level state machine
-    // ReturnEvent = RunLowerLevelSM(Event);
-    // repeat for any concurrent lower level machines
-    // do any activity that is repeated as long as we are in this state
-  }
-  // return either Event, if you don't want to allow the lower level machine
-  // to remap the current event, or ReturnEvent if you do want to allow it.
-  return ReturnEvent;
+static bool IsOffense(ES_Event_t Event)
+{
+  return Event.EventParam == (PlayState_t)OFFENSE;
 }
 
-static ES_Event_t DuringWaitingBall(ES_Event_t Event)
+static void TurnPastBeacon(ES_Event_t Event)
 {
-  ES_Event_t ReturnEvent = Event;   // assume no re-mapping or consumption
+  //start timer to turn more
+  ES_Timer_InitTimer(RELOADING_ROTATE_TIMER, ROTATING_DURATION);
+  HWREG(WTIMER3_BASE + TIMER_O_IMR) &= ~TIMER_IMR_CBEIM;
+}
 
-  // process ES_ENTRY, ES_ENTRY_HISTORY & ES_EXIT events
-  if ((Event.EventType == ES_ENTRY) ||
-      (Event.EventType == ES_ENTRY_HISTORY))
-  {
-    // implement any entry actions required for this state machine
-    // after that start any lower level machines that run in this state
-    //StartLowerLevelSM( Event );
-    // repeat the StartxxxSM() functions for concurrent state machines
-    // on the lower level
-  }
-  else if (Event.EventType == ES_EXIT)
-  {
-    // on exit, give the lower levels a chance to clean up first
-    //RunLowerLevelSM(Event);
-    // repeat for any concurrently running state machines
-    // now do any local exit functionality
-  }
-  else
-  // do the 'during' function for this state
-  {
-    // run any lower level state machine
-    // ReturnEvent = RunLowerLevelSM(Event);
-    // repeat for any concurrent lower level machines
-    // do any activity that is repeated as long as we are in this state
-  }
-  // return either Event, if you don't want to allow the lower level machine
-  // to remap the current event, or ReturnEvent if you do want to allow it.
-  return ReturnEvent;
+static void GoToOffense(ES_Event_t Event)
+{
+  ES_Event_t ThisEvent;
+  ThisEvent.EventType = EV_STATE_CHANGE;
+  ThisEvent.EventParam = (PlayState_t)OFFENSE;
+  PostMasterSM(ThisEvent);
 }
 
 int8_t GetNumBalls(void)
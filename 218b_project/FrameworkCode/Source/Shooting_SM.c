@@ -4,6 +4,7 @@
 // Basic includes for a program using the Events and Services Framework
 #include "ES_Configure.h"
 #include "ES_Framework.h"
+#include "ES_Hsm.h"
 
 /* include header files for this state machine as well as any machines at the
    next lower level in the hierarchy that are sub-machines to this machine
@@ -29,199 +30,80 @@
 #define SERVO_CMP_RIGHT 1562  //2.5ms high time
 
 /*---------------------------- Module Functions ---------------------------*/
-/* prototypes for private functions for this machine, things like during
-   functions, entry & exit functions.They should be functions relevant to the
-   behavior of this state machine
+/* prototypes for private functions for this machine, things like entry &
+   exit functions, guards and actions. They should be functions relevant to
+   the behavior of this state machine
 */
 
-static ES_Event_t DuringWaitingForFlywheel(ES_Event_t Event);
-static ES_Event_t DuringWaitingForBallWheel(ES_Event_t Event);
-static ES_Event_t DuringWaitingForShot(ES_Event_t Event);
+static void EnterWaitingForBallWheel(ES_Event_t EntryEvent);
+static void ExitWaitingForBallWheel(void);
+static void EnterWaitingForShot(ES_Event_t EntryEvent);
+static bool IsShootingTimer(ES_Event_t Event);
+static bool IsBallWheelTimer(ES_Event_t Event);
+static bool IsShootingTimerWithBalls(ES_Event_t Event);
+static void CountBallShot(ES_Event_t Event);
+static void GoToDefenseEarly(ES_Event_t Event);
 
 /*---------------------------- Module Variables ---------------------------*/
-// everybody needs a state variable, you may need others as well
-static ShootingState_t CurrentState;
+// the machine is described by these two tables (see ES_Hsm.h) rather than
+// by nested switch statements
+#define SHOOTING_STATES(ES_HSM_STATE)                                       \
+  ES_HSM_STATE(WAITING_FOR_FLYWHEEL, ES_HSM_TOP, ES_HSM_NO_STATE,           \
+      NULL, NULL, NULL)                                                     \
+  ES_HSM_STATE(WAITING_FOR_BALL_WHEEL, ES_HSM_TOP, ES_HSM_NO_STATE,         \
+      EnterWaitingForBallWheel, ExitWaitingForBallWheel, NULL)              \
+  ES_HSM_STATE(WAITING_FOR_SHOT, ES_HSM_TOP, ES_HSM_NO_STATE,               \
+      EnterWaitingForShot, NULL, NULL)
+
+// once the flywheel is up to speed turn the ball wheel, then wait for the
+// shot and go again while there are balls left. With none left, tell the
+// master machine to go to defense early. The flywheel timeout and the last
+// shot timeout go on up to the Offense machine as well.
+#define SHOOTING_TRANSITIONS(ES_HSM_TRANSITION)                             \
+  ES_HSM_TRANSITION(WAITING_FOR_FLYWHEEL, ES_TIMEOUT,                       \
+      WAITING_FOR_BALL_WHEEL, IsShootingTimer, NULL,                        \
+      ES_HSM_EXTERNAL | ES_HSM_PASS_ON)                                     \
+  ES_HSM_TRANSITION(WAITING_FOR_BALL_WHEEL, ES_TIMEOUT, WAITING_FOR_SHOT,   \
+      IsBallWheelTimer, CountBallShot, ES_HSM_EXTERNAL)                     \
+  ES_HSM_TRANSITION(WAITING_FOR_SHOT, ES_TIMEOUT, WAITING_FOR_BALL_WHEEL,   \
+      IsShootingTimerWithBalls, NULL, ES_HSM_EXTERNAL)                      \
+  ES_HSM_TRANSITION(WAITING_FOR_SHOT, ES_TIMEOUT, WAITING_FOR_SHOT,         \
+      IsShootingTimer, GoToDefenseEarly, ES_HSM_INTERNAL | ES_HSM_PASS_ON)
+
+ES_HSM_DEFINE(ShootingHsm, SHOOTING_STATES, SHOOTING_TRANSITIONS,
+    ENTRY_STATE);
 
 /*------------------------------ Module Code ------------------------------*/
 /****************************************************************************
  Function
-    RunShooting_SM
+    RunShootingSM
 
  Parameters
    ES_Event_t: the event to process
 
  Returns
-   ES_Event_t: an event to return
+   ES_Event_t: ES_NO_EVENT if the event was consumed, otherwise the event,
+   for the upper level state machine
 
  Description
-   add your description here
+   hands the event to the table driven machine
  Notes
-   uses nested switch/case to implement the machine.
+   ES_ENTRY, ES_ENTRY_HISTORY & ES_EXIT start and stop the machine, so the
+   Offense machine drives it the same as any other lower level machine
  Author
    J. Edward Carryer, 2/11/05, 10:45AM
 ****************************************************************************/
 ES_Event_t RunShootingSM(ES_Event_t CurrentEvent)
 {
-  /* are we making a state transition? */
-  bool            MakeTransition = false;
-  ShootingState_t NextState = CurrentState;
-
-  // default to normal entry to new state
-  ES_Event_t EntryEventKind = { ES_ENTRY, 0 };
-
-  // assume we are not consuming event
-  ES_Event_t ReturnEvent = CurrentEvent;
-
-  switch (CurrentState)
-  {
-    // In this state, we wait for the flywheel to get up and running
-    case WAITING_FOR_FLYWHEEL:  // If current state is state one
-    {                           // Execute During function for state one. ES_ENTRY & ES_EXIT are
-                                // processed here allow the lower-level state machines to re-map
-                                // or consume the event
-      ReturnEvent = CurrentEvent = DuringWaitingForFlywheel(CurrentEvent);
-      //process any events
-      if (CurrentEvent.EventType != ES_NO_EVENT)      //If an event is active
-      {
-        switch (CurrentEvent.EventType)
-        {
-          case ES_TIMEOUT:       //If event is event one
-          { if (CurrentEvent.EventParam == SHOOTING_TIMER)
-            {
-              // Execute action function for state one : event one
-              // Decide what the next state will be
-              NextState = WAITING_FOR_BALL_WHEEL;
-
-              // Mark that we are taking a transition
-              MakeTransition = true;
-
-              // not transitioning to a state with
-              // history change kind of entry
-              //EntryEventKind.EventType = ES_ENTRY_HISTORY;
-
-              // don't consume or re-map this event for the upper
-              // level state machine
-              //ReturnEvent.EventType = ES_NO_EVENT;
-            }
-          }
-          break;
-        }
-      }
-    }
-    break;
-
-    // In this state, we wait for the ball wheel to rotate the correct
-    // amount
-    case WAITING_FOR_BALL_WHEEL:  // If current state is state one
-    {                             // Execute During function for state one. ES_ENTRY & ES_EXIT are
-                                  // processed here allow the lower-level state machines to re-map
-                                  // or consume the event
-      ReturnEvent = CurrentEvent =
-              DuringWaitingForBallWheel(CurrentEvent);
-      //process any events
-      if (CurrentEvent.EventType != ES_NO_EVENT)      //If an event is active
-      {
-        switch (CurrentEvent.EventType)
-        {
-          case ES_TIMEOUT:       //If event is event one
-          { if (CurrentEvent.EventParam == BALL_WHEEL_TIMER)
-            {
-              // Execute action function for state one : event one
-              // Decide what the next state will be
-              NextState = WAITING_FOR_SHOT;
-
-              //mark that we are taking a transition
-              MakeTransition = true;
-
-              // not transitioning to a state with
-              // history change kind of entry
-              //EntryEventKind.EventType = ES_ENTRY_HISTORY;
-
-              // consume this event
-              ReturnEvent.EventType = ES_NO_EVENT;
-
-              //Assume that ball successfully exited
-              SetNumBalls(GetNumBalls() - 1);
-            }
-          }
-          break;
-        }
-      }
-    }
-    break;
-
-    // In this state, we wait to receive word on whether we've scored
-    case WAITING_FOR_SHOT:  // If current state is state one
-    {                       // Execute During function for state one. ES_ENTRY & ES_EXIT are
-                            // processed here allow the lower-level state machines to re-map
-                            // or consume the event
-      ReturnEvent = CurrentEvent = DuringWaitingForShot(CurrentEvent);
-      //process any events
-      if (CurrentEvent.EventType != ES_NO_EVENT)      //If an event is active
-      {
-        switch (CurrentEvent.EventType)
-        {
-          case ES_TIMEOUT:       //If event is event one
-
-          { if (CurrentEvent.EventParam == SHOOTING_TIMER)
-            {
-              if (GetNumBalls() > 0)
-              {
-                // Execute action function for state one : event one
-                // Decide what the next state will be
-                NextState = WAITING_FOR_BALL_WHEEL;
-
-                // mark that we are taking a transition
-                MakeTransition = true;
-
-                // for internal transitions,
-                // skip changing MakeTransition
-                //MakeTransition = true;
-
-                // not transitioning to a state with
-                // history change kind of entry
-                //EntryEventKind.EventType = ES_ENTRY_HISTORY;
-
-                // consume this event
-                ReturnEvent.EventType = ES_NO_EVENT;
-              }
-              else
-              {
-                // if no balls remain, go to defense early
-                ES_Event_t DefenseEvent;
-                DefenseEvent.EventType = EV_EARLY_DEFENSE;
-                PostMasterSM(DefenseEvent);
-              }
-            }
-          }
-          break;
-        }
-      }
-    }
-    break;
-  }
-  //   If we are making a state transition
-  if (MakeTransition == true)
-  {
-    // Execute exit function for current state
-    CurrentEvent.EventType = ES_EXIT;
-    RunShootingSM(CurrentEvent);
-
-    CurrentState = NextState;    //Modify state variable
-
-    // Execute entry function for new state
-    // this defaults to ES_ENTRY
-    RunShootingSM(EntryEventKind);
-  }
-  return ReturnEvent;
+  return ES_Hsm_Dispatch(&ShootingHsm, CurrentEvent);
 }
 
 /****************************************************************************
  Function
-     StartShooting_SM
+     StartShootingSM
 
  Parameters
-     None
+     ES_Event_t: ES_ENTRY, or ES_ENTRY_HISTORY to go back to the last state
 
  Returns
      None
@@ -235,21 +117,12 @@ ES_Event_t RunShootingSM(ES_Event_t CurrentEvent)
 ****************************************************************************/
 void StartShootingSM(ES_Event_t CurrentEvent)
 {
-  // to implement entry to a history state or directly to a substate
-  // we can modify the initialization of the CurrentState variable
-  // otherwise just start in the entry state every time the state machine
-  // is started
-  if (ES_ENTRY_HISTORY != CurrentEvent.EventType)
-  {
-    CurrentState = ENTRY_STATE;
-  }
-  // call the entry function for the ENTRY_STATE
-  RunShootingSM(CurrentEvent);
+  ES_Hsm_Start(&ShootingHsm, CurrentEvent);
 }
 
 /****************************************************************************
  Function
-     QueryShooting_SM
+     QueryShootingSM
 
  Parameters
      None
@@ -264,101 +137,59 @@ void StartShootingSM(ES_Event_t CurrentEvent)
  Author
      J. Edward Carryer, 2/11/05, 10:38AM
 ****************************************************************************/
-ShootingState_t QueryShooting_SM(void)
+ShootingState_t QueryShootingSM(void)
 {
-  return CurrentState;
+  return (ShootingState_t)ES_Hsm_Query(&ShootingHsm);
 }
 
 /***************************************************************************
  private functions
  ***************************************************************************/
 
-static ES_Event_t DuringWaitingForFlywheel(ES_Event_t Event)
+static void EnterWaitingForBallWheel(ES_Event_t EntryEvent)
+{
+  ES_Timer_InitTimer(BALL_WHEEL_TIMER, BALL_WHEEL_DURATION);
+
+  // start servo
+  HWREG(PWM0_BASE + PWM_O_2_CMPB) = SERVO_CMP_RIGHT;
+}
+
+static void ExitWaitingForBallWheel(void)
+{
+  //Stop servo
+  HWREG(PWM0_BASE + PWM_O_2_CMPB) = SERVO_CMP_CENTER;
+}
+
+static void EnterWaitingForShot(ES_Event_t EntryEvent)
+{
+  ES_Timer_InitTimer(SHOOTING_TIMER, SHOT_DURATION);
+}
+
+static bool IsShootingTimer(ES_Event_t Event)
+{
+  return Event.EventParam == SHOOTING_TIMER;
+}
+
+static bool IsBallWheelTimer(ES_Event_t Event)
+{
+  return Event.EventParam == BALL_WHEEL_TIMER;
+}
+
+static bool IsShootingTimerWithBalls(ES_Event_t Event)
 {
-  ES_Event_t ReturnEvent = Event;   // assume no re-mapping or consumption
-
-  // process ES_ENTRY, ES_ENTRY_HISTORY & ES_EXIT events
-  if ((Event.EventType == ES_ENTRY) ||
-      (Event.EventType == ES_ENTRY_HISTORY))
-  {
-    // implement any entry actions required for this state machine
-
-    // after that start any lower-level machines that run in this state
-  }
-  else if (Event.EventType == ES_EXIT)
-  {
-    // on exit, give the lower levels a chance to clean up first
-
-    // now do any local exit functionality
-  }
-  else
-  // do the 'during' function for this state
-  {
-    // run any lower-level state machine
-  }
-  return ReturnEvent;
+  return (Event.EventParam == SHOOTING_TIMER) && (GetNumBalls() > 0);
 }
 
-static ES_Event_t DuringWaitingForBallWheel(ES_Event_t Event)
+static void CountBallShot(ES_Event_t Event)
 {
-  ES_Event_t ReturnEvent = Event;   // assume no re-mapping or consumption
-
-  // process ES_ENTRY, ES_ENTRY_HISTORY & ES_EXIT events
-  if ((Event.EventType == ES_ENTRY) ||
-      (Event.EventType == ES_ENTRY_HISTORY))
-  {
-    // implement any entry actions required for this state machine
-    ES_Timer_InitTimer(BALL_WHEEL_TIMER, BALL_WHEEL_DURATION);
-
-    // start servo
-    HWREG(PWM0_BASE + PWM_O_2_CMPB) = SERVO_CMP_RIGHT;
-
-    // after that start any lower-level machines that run in this state
-  }
-  else if (Event.EventType == ES_EXIT)
-  {
-    // on exit, give the lower levels a chance to clean up first
-
-    // now do any local exit functionality
-
-    //Stop servo
-    HWREG(PWM0_BASE + PWM_O_2_CMPB) = SERVO_CMP_CENTER;
-  }
-  else
-  // do the 'during' function for this state
-  {
-    // run any lower-level state machine
-
-    // do any activity that is repeated as long as we are in this state
-  }
-  return ReturnEvent;
+  //Assume that ball successfully exited
+  SetNumBalls(GetNumBalls() - 1);
 }
 
-static ES_Event_t DuringWaitingForShot(ES_Event_t Event)
+static void GoToDefenseEarly(ES_Event_t Event)
 {
-  ES_Event_t ReturnEvent = Event;   // assume no re-mapping or consumption
-
-  // process ES_ENTRY, ES_ENTRY_HISTORY & ES_EXIT events
-  if ((Event.EventType == ES_ENTRY) ||
-      (Event.EventType == ES_ENTRY_HISTORY))
-  {
-    // implement any entry actions required for this state machine
-    ES_Timer_InitTimer(SHOOTING_TIMER, SHOT_DURATION);
-
-    // after that start any lower-level machines that run in this state
-  }
-  else if (Event.EventType == ES_EXIT)
-  {
-    // on exit, give the lower levels a chance to clean up first
-
-    // now do any local exit functionality
-  }
-  else
-  // do the 'during' function for this state
-  {
-    // run any lower-level state machine
-
-    // do any activity that is repeated as long as we are in this state
-  }
-  return ReturnEvent;
+  // if no balls remain, go to defense early
+  ES_Event_t DefenseEvent;
+  DefenseEvent.EventType = EV_EARLY_DEFENSE;
+  PostMasterSM(DefenseEvent);
 }
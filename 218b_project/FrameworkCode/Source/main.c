@@ -44,6 +44,7 @@
 
 //Initializing general GPIO and analog pins
 #define NumAnalog 4 //2 for inductors and 2 for Sharp sensors
+#define ADC_SAMPLE_PERIOD_US 500 //twice as fast as Check4Wire looks
 void InitGPIO(void);
 
 //Initializing interrupts
@@ -204,6 +205,8 @@ void InitGPIO(void)
   //Clock enable for Port E included within function
   //Init analog inputs for magnetic line following and Sharp sensor
   ADC_MultiInit(NumAnalog);
+  //and keep converting in the background so nobody waits on the A/D
+  ADC_MultiStartContinuous(ADC_SAMPLE_PERIOD_US);
 }
 
 //Init input capture interrupt using wide timers 0A, 0B, 3A, 3B
@@ -0,0 +1,753 @@
+#!/usr/bin/env python3
+"""
+ Module
+     ES_Analyze.py
+ Description
+     host side stack depth & blocking call analysis for an Events and
+     Services Framework project. Builds the call graph of the sources, starts
+     it from main, every service run & init function, every event checker
+     and every interrupt handler in the startup file's vector table, and
+     reports:
+       - the deepest stack below each of them, and the worst case for the
+         whole program against the Stack size in the startup file
+       - recursion, with the stack counted for --recursion extra levels
+       - blocking calls below each root: printf & friends, delays, and
+         busy-wait loops (a while with an empty body)
+       - with --profile, the worst run function times that ES_Profile_Dump
+         measured for each service & event type, on the host or the Tiva
+ Notes
+     The sources are read, not compiled, so macros are not expanded in the
+     code. The #if, #ifdef & co are evaluated for the target though, with
+     the defines of the Keil project, those of the headers, ES_Configure.h
+     first, those of the file itself and any --define, so the host tests and
+     the ES_PORT_POSIX code drop out. A condition that can not be worked out
+     keeps all of its branches. With a Keil project only the .c files it
+     builds are read. Calls through function
+     pointers are resolved to the functions whose address is taken in the
+     file of the caller, and to the functions named in ES_Configure.h for
+     the framework's own files. That covers the service tables, the event
+     checkers and ES_Hsm machines, which is what this code base has.
+
+     Frame sizes come from the compiler if it is given the chance:
+       --su DIR     .su files from gcc -fstack-usage (arm-none-eabi-gcc)
+       --keil FILE  the .htm call graph from the Keil linker (--callgraph,
+                    "Callgraph" on the Listing tab of the target options)
+     Any function without one gets --frame bytes, and any depth that
+     includes such a guess is marked with a ~.
+
+     usage, from the FrameworkCode directory:
+       python3 Tools/ES_Analyze.py
+       python3 Tools/ES_Analyze.py -D ES_BUS_SIZE=16 -D ES_PROFILE
+       python3 Tools/ES_Analyze.py --keil Objects/UVFrameworkTemplate.htm \\
+         --profile profile.txt --budget-us 500
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 20:30         started coding
+ 10/17/26 21:05         evaluate the #if's for the target build
+"""
+import argparse
+import os
+import re
+import sys
+
+# calls that block, or take long enough over a UART that they may as well
+BLOCKING_CALLS = {
+    'printf', 'puts', 'putchar', 'getchar', 'scanf', 'fflush',
+    'UARTprintf', 'UARTgets', 'UARTgetc', 'UARTCharGet', 'UARTCharPut',
+    'SysCtlDelay', 'fputc', 'fgetc',
+}
+
+NOT_CALLS = {
+    'if', 'while', 'for', 'switch', 'return', 'sizeof', 'defined',
+    'else', 'case', 'do', '__attribute__', 'void', 'int', 'char', 'bool',
+    'unsigned', 'signed', 'long', 'short', 'float', 'double', 'const',
+    'volatile', 'static', 'struct', 'union', 'enum',
+}
+
+EXCEPTION_FRAME = 32    # what the Cortex-M pushes on interrupt entry
+
+
+class Function:
+    def __init__(self, name, file, line):
+        self.name = name
+        self.file = file
+        self.line = line
+        self.calls = set()          # names called directly
+        self.indirect = False       # calls through a pointer
+        self.busy_waits = []        # line numbers of empty-bodied whiles
+        self.frame = None           # bytes, None if not known
+        self.callees = set()        # resolved, filled in by Resolve
+
+
+def StripSource(text, defines):
+    """blanks out comments, strings, character constants and the lines that
+    the #if's leave out, keeping the line breaks so line numbers still
+    match. The #define's and #undef's that are kept update defines"""
+    out = []
+    i = 0
+    n = len(text)
+    while i < n:
+        c = text[i]
+        if text.startswith('//', i):
+            j = text.find('\n', i)
+            j = n if j < 0 else j
+            i = j
+        elif text.startswith('/*', i):
+            j = text.find('*/', i + 2)
+            j = n if j < 0 else j + 2
+            # keep the line continuations, a comment can be inside a macro
+            out.append(re.sub(r'[^\n\\]|\\(?!\n)', ' ', text[i:j]))
+            i = j
+        elif c in '"\'':
+            j = i + 1
+            while j < n and text[j] != c and text[j] != '\n':
+                j += 2 if text[j] == '\\' else 1
+            out.append(c + ' ' * (min(j, n - 1) - i - 1) + c)
+            i = j + 1
+        else:
+            out.append(c)
+            i += 1
+    lines = ''.join(out).split('\n')
+    Conditionals(lines, defines)
+    return '\n'.join(lines)
+
+
+def Evaluate(expr, defines):
+    """the value of an #if expression, None if it can not be worked out"""
+    expr = re.sub(r'\bdefined\s*(?:\(\s*(\w+)\s*\)|(\w+))',
+                  lambda m: '1' if (m.group(1) or m.group(2)) in defines
+                  else '0', expr)
+    # expand the macros a few levels deep, anything left over is 0 as in C
+    for _ in range(8):
+        expanded = re.sub(r'\b[A-Za-z_]\w*\b', lambda m: '(%s)' % (
+            defines[m.group(0)] or '0') if m.group(0) in defines else
+            m.group(0), expr)
+        if expanded == expr:
+            break
+        expr = expanded
+    expr = re.sub(r'\b[A-Za-z_]\w*\b', '0', expr)
+    expr = re.sub(r'\b(0[xX][0-9a-fA-F]+|\d+)[uUlL]*\b', r'\1', expr)
+    expr = expr.replace('&&', ' and ').replace('||', ' or ')
+    expr = re.sub(r'!(?!=)', ' not ', expr).replace('/', '//')
+    try:
+        return bool(eval(expr, {'__builtins__': {}}))
+    except Exception:
+        return None
+
+
+def Conditionals(lines, defines):
+    """blanks the lines that the #if's of a file leave out"""
+    stack = []          # [parent active, branch taken, unknown, active]
+    active = True
+    k = 0
+    while k < len(lines):
+        first = k
+        line = lines[k]
+        while line.endswith('\\') and k + 1 < len(lines):
+            k += 1
+            line = line[:-1] + ' ' + lines[k]
+        m = re.match(r'\s*#\s*(\w+)\s*(.*)', line)
+        word, rest = (m.group(1), m.group(2).strip()) if m else ('', '')
+        keep = active
+        if word in ('if', 'ifdef', 'ifndef'):
+            if word == 'if':
+                value = Evaluate(rest, defines)
+            else:
+                name = rest.split()[0] if rest else ''
+                value = (name in defines) == (word == 'ifdef')
+                # an include guard, the header may be read more than once
+                if word == 'ifndef' and any(re.match(
+                        r'\s*#\s*define\s+%s\b' % re.escape(name), later)
+                        for later in lines[k + 1:k + 2]):
+                    value = True
+            stack.append([active, bool(value), value is None, False])
+            active = active and value is not False
+            stack[-1][3] = active
+            keep = stack[-1][0]
+        elif word in ('elif', 'else') and stack:
+            top = stack[-1]
+            if top[2]:
+                active = top[0]
+            elif top[1]:
+                active = False
+            else:
+                value = True if word == 'else' else Evaluate(rest, defines)
+                top[1] = bool(value)
+                top[2] = value is None
+                active = top[0] and value is not False
+            keep = top[0]
+        elif word == 'endif' and stack:
+            active = stack.pop()[0]
+            keep = active
+        elif active and word == 'define':
+            m = re.match(r'(\w+)(\([^)]*\))?\s*(.*)', rest)
+            if m:
+                defines[m.group(1)] = '' if m.group(2) else m.group(3)
+        elif active and word == 'undef':
+            defines.pop(rest.split()[0] if rest else '', None)
+        if not keep:
+            for j in range(first, k + 1):
+                lines[j] = ''
+        k += 1
+
+
+def SplitDirectives(text):
+    """returns the text with the preprocessor lines blanked, and the bodies
+    of the function-like macros"""
+    lines = text.split('\n')
+    macros = {}
+    k = 0
+    while k < len(lines):
+        if lines[k].lstrip().startswith('#'):
+            start = k
+            body = lines[k]
+            while body.endswith('\\') and k + 1 < len(lines):
+                k += 1
+                body = body[:-1] + ' ' + lines[k]
+            m = re.match(r'\s*#\s*define\s+(\w+)\((.*?)\)(.*)', body)
+            if m:
+                macros[m.group(1)] = m.group(3)
+            for j in range(start, k + 1):
+                lines[j] = ''
+        k += 1
+    return '\n'.join(lines), macros
+
+
+def MatchBack(text, close, opener, closer):
+    """index of the bracket that opens the one at close"""
+    depth = 0
+    for i in range(close, -1, -1):
+        if text[i] == closer:
+            depth += 1
+        elif text[i] == opener:
+            depth -= 1
+            if depth == 0:
+                return i
+    return -1
+
+
+def MatchForward(text, open_, opener, closer):
+    depth = 0
+    for i in range(open_, len(text)):
+        if text[i] == opener:
+            depth += 1
+        elif text[i] == closer:
+            depth -= 1
+            if depth == 0:
+                return i
+    return -1
+
+
+def FindBusyWaits(body, base_line):
+    """lines of while loops that do nothing but test their condition"""
+    found = []
+    for m in re.finditer(r'\bwhile\s*\(', body):
+        close = MatchForward(body, m.end() - 1, '(', ')')
+        if close < 0:
+            continue
+        rest = body[close + 1:]
+        if not re.match(r'\s*(;|\{\s*;?\s*\})', rest):
+            continue
+        # the end of a do { } while (x); is not a busy wait
+        before = body[:m.start()].rstrip()
+        if before.endswith('}'):
+            open_ = MatchBack(before, len(before) - 1, '{', '}')
+            if re.search(r'\bdo\s*$', before[:open_]):
+                continue
+        found.append(base_line + body.count('\n', 0, m.start()))
+    return found
+
+
+def ParseFile(path, functions, address_taken, used, defines):
+    with open(path, errors='replace') as f:
+        raw = f.read()
+    stripped = StripSource(raw, dict(defines))
+    text, macros = SplitDirectives(stripped)
+    name = os.path.basename(path)
+    defined_here = []
+
+    depth = 0
+    i = 0
+    while i < len(text):
+        c = text[i]
+        if c == '{' and depth == 0:
+            head = text[:i].rstrip()
+            end = MatchForward(text, i, '{', '}')
+            end = len(text) - 1 if end < 0 else end
+            if head.endswith(')'):
+                open_ = MatchBack(head, len(head) - 1, '(', ')')
+                m = re.search(r'(\w+)\s*$', head[:open_])
+                if m and m.group(1) not in NOT_CALLS and \
+                        not re.search(r'=\s*$', head[:open_]):
+                    fn = Function(m.group(1), name,
+                                  text.count('\n', 0, m.start()) + 1)
+                    body = text[i:end + 1]
+                    AddCalls(fn, body, macros)
+                    fn.busy_waits = FindBusyWaits(body, text.count(
+                        '\n', 0, i) + 1)
+                    functions.setdefault(fn.name, []).append(fn)
+                    defined_here.append(fn)
+            i = end + 1
+            continue
+        i += 1
+
+    # a function named anywhere but in a call has its address taken, the
+    # #define bodies count since that is where the X-macro lists live
+    words = set(re.findall(r'\b(\w+)\b(?!\s*\()', text))
+    for body in macros.values():
+        words |= set(re.findall(r'\b(\w+)\b(?!\s*\()', body))
+    raw_defines = ' '.join(re.findall(r'#\s*define[^\n]*(?:\\\n[^\n]*)*',
+                                      stripped))
+    words |= set(re.findall(r'\b(\w+)\b', raw_defines))
+    address_taken[name] = words
+    used[name] = set(re.findall(r'\b(\w+)\b', stripped))
+    return defined_here
+
+
+def AddCalls(fn, body, macros, seen=None):
+    seen = set() if seen is None else seen
+    for m in re.finditer(r'(->|\.)?\s*\b(\w+)\s*\(', body):
+        word = m.group(2)
+        if m.group(1):
+            fn.indirect = True
+        elif word in macros and word not in seen:
+            seen.add(word)
+            AddCalls(fn, macros[word], macros, seen)
+        elif word not in NOT_CALLS and not word.isupper():
+            fn.calls.add(word)
+    if re.search(r'\(\s*\*[^()]*\)\s*\(|\]\s*\(', body):
+        # (*pFunc)(x) or Table[i](x)
+        fn.indirect = True
+
+
+def ReadFrames(args, functions):
+    frames = {}
+    if args.su:
+        for root, _, files in os.walk(args.su):
+            for f in files:
+                if not f.endswith('.su'):
+                    continue
+                with open(os.path.join(root, f)) as su:
+                    for line in su:
+                        parts = line.rstrip('\n').split('\t')
+                        if len(parts) >= 2:
+                            name = parts[0].split(':')[-1]
+                            frames[name] = max(frames.get(name, 0),
+                                               int(parts[1]))
+    if args.keil:
+        with open(args.keil, errors='replace') as htm:
+            for m in re.finditer(r'>(\w+)</STRONG>\s*\([^,]*,\s*\d+ bytes,'
+                                 r'\s*Stack size (\d+) bytes', htm.read()):
+                frames[m.group(1)] = max(frames.get(m.group(1), 0),
+                                         int(m.group(2)))
+    for fns in functions.values():
+        for fn in fns:
+            fn.frame = frames.get(fn.name)
+    return frames
+
+
+def Resolve(functions, address_taken, used, config_macros):
+    # the functions named in the ES_Configure.h lists that a file uses, like
+    # SERVICE_LIST in ES_Framework.c, have their address taken there too
+    for file in address_taken:
+        for macro in used.get(file, set()) & set(config_macros):
+            address_taken[file] |= config_macros[macro]
+        address_taken[file] = {w for w in address_taken[file]
+                               if w in functions}
+    for fns in functions.values():
+        for fn in fns:
+            fn.callees = {c for c in fn.calls if c in functions or
+                          c in BLOCKING_CALLS}
+            if fn.indirect:
+                fn.callees |= {t for t in address_taken.get(fn.file, ())
+                               if t != fn.name}
+    # a function that calls back through pointers without taking any
+    # addresses itself, like ES_Hsm_Dispatch, is given them by its callers,
+    # so it reaches the functions whose address the caller's file takes
+    callers = {}
+    for fns in functions.values():
+        for fn in fns:
+            for c in fn.calls:
+                if c in functions and any(g.indirect and
+                                          not address_taken.get(g.file)
+                                          for g in functions[c]):
+                    callers.setdefault(c, set()).add(fn.file)
+    return callers
+
+
+class Analyzer:
+    def __init__(self, functions, callers, address_taken, args):
+        self.functions = functions
+        self.callers = callers
+        self.address_taken = address_taken
+        self.args = args
+        self.recursion = set()
+        self.cache = {}
+
+    def Frame(self, name):
+        fns = self.functions.get(name)
+        if fns and fns[0].frame is not None:
+            return fns[0].frame, True
+        return self.args.frame, False
+
+    def Callees(self, name, via_file):
+        key = (name, via_file)
+        if key not in self.cache:
+            out = set()
+            for fn in self.functions.get(name, []):
+                out |= fn.callees
+                if fn.indirect and via_file and name in self.callers:
+                    out |= {t for t in self.address_taken.get(via_file, ())
+                            if t != name}
+            self.cache[key] = sorted(out)
+        return self.cache[key]
+
+    def Node(self, name, via_file):
+        """a node of the graph, a function that calls back through pointers
+        is a different node for each file that calls it"""
+        return (name, via_file if name in self.callers else None)
+
+    def FileOf(self, name):
+        fns = self.functions.get(name)
+        return fns[0].file if fns else None
+
+    def Edges(self, node):
+        """the callees of a node. Inside the file of a function that calls
+        back, like ES_Hsm.c, the file that gave it the call backs is kept"""
+        name, via = node
+        own = self.FileOf(name)
+        out = []
+        for c in self.Callees(name, via):
+            keep = via is not None and self.FileOf(c) == own
+            out.append(self.Node(c, via if keep else own))
+        return out
+
+    def Components(self, root):
+        """Tarjan's strongly connected components of everything below root,
+        done without recursion since the graph can be deep"""
+        index = {root: 0}
+        low = {root: 0}
+        on_stack = {root}
+        stack = [root]
+        comp = {}
+        work = [(root, iter(self.Edges(root)))]
+        while work:
+            node, edges = work[-1]
+            for nxt in edges:
+                if nxt not in index:
+                    index[nxt] = low[nxt] = len(index)
+                    stack.append(nxt)
+                    on_stack.add(nxt)
+                    work.append((nxt, iter(self.Edges(nxt))))
+                    break
+                if nxt in on_stack:
+                    low[node] = min(low[node], index[nxt])
+            else:
+                work.pop()
+                if work:
+                    parent = work[-1][0]
+                    low[parent] = min(low[parent], low[node])
+                if low[node] == index[node]:
+                    members = []
+                    while True:
+                        member = stack.pop()
+                        on_stack.discard(member)
+                        members.append(member)
+                        if member == node:
+                            break
+                    for member in members:
+                        comp[member] = tuple(members)
+        return comp
+
+    def Depth(self, name):
+        """(bytes, all frames known, deepest path) below name. A group of
+        mutually recursive functions counts every frame in it --recursion
+        extra times, which over-estimates a cycle that does not go through
+        all of them"""
+        root = self.Node(name, None)
+        comp = self.Components(root)
+        memo = {}
+
+        def Visit(members):
+            if members in memo:
+                return memo[members]
+            group = set(members)
+            names = sorted({m[0] for m in members})
+            frames = 0
+            known = True
+            for each in names:
+                frame, is_known = self.Frame(each)
+                frames += frame
+                known = known and is_known
+            if len(members) > 1 or members[0] in self.Edges(members[0]):
+                self.recursion.add(tuple(names))
+                frames *= self.args.recursion + 1
+            best = (0, True, ())
+            for m in members:
+                for nxt in self.Edges(m):
+                    if nxt not in group:
+                        d = Visit(comp[nxt])
+                        if d[0] > best[0]:
+                            best = d
+            memo[members] = (frames + best[0], known and best[1],
+                             (' + '.join(names),) + best[2])
+            return memo[members]
+
+        return Visit(comp[root])
+
+    def Blocking(self, name):
+        """{what: path} for each blocking call below name"""
+        found = {}
+        root = self.Node(name, None)
+        stack = [(root, (name,))]
+        visited = set()
+        while stack:
+            node, path = stack.pop()
+            if node in visited:
+                continue
+            visited.add(node)
+            if node[0] in BLOCKING_CALLS:
+                found.setdefault(node[0], path)
+                continue
+            for fn in self.functions.get(node[0], []):
+                for line in fn.busy_waits:
+                    found.setdefault('busy-wait in %s (%s:%d)' %
+                                     (node[0], fn.file, line), path)
+            for nxt in reversed(self.Edges(node)):
+                stack.append((nxt, path + (nxt[0],)))
+        return found
+
+
+def ReadConfig(path, defines):
+    with open(path, errors='replace') as f:
+        text = re.sub(r'\\\n', ' ', StripSource(f.read(), dict(defines)))
+    roots = []
+    m = re.search(r'#\s*define\s+SERVICE_LIST\(\w+\)(.*)', text)
+    if m:
+        for init, run in re.findall(r'\w+\(\s*(\w+)\s*,\s*(\w+)\s*,',
+                                    m.group(1)):
+            roots += [(run, 'service'), (init, 'init')]
+    else:
+        m = re.search(r'#\s*define\s+NUM_SERVICES\s+(\d+)', text)
+        count = int(m.group(1)) if m else 16
+        for n in range(count):
+            for kind, key in (('service', 'RUN'), ('init', 'INIT')):
+                m = re.search(r'#\s*define\s+SERV_%d_%s\s+(\w+)' % (n, key),
+                              text)
+                if m:
+                    roots.append((m.group(1), kind))
+    m = re.search(r'#\s*define\s+EVENT_CHECK_SCHEDULE\(\w+\)(.*)', text)
+    if m:
+        roots += [(c, 'checker') for c in
+                  re.findall(r'\w+\(\s*(\w+)\s*,', m.group(1))]
+    m = re.search(r'^\s*#\s*define\s+EVENT_CHECK_LIST\s+(.*)$', text, re.M)
+    if m:
+        roots += [(c, 'checker') for c in re.findall(r'\w+', m.group(1))]
+    macros = {m.group(1): set(re.findall(r'\b(\w+)\b', m.group(2)))
+              for m in re.finditer(r'^\s*#\s*define\s+(\w+)(.*)$', text,
+                                   re.M)}
+
+    events = []
+    m = re.search(r'typedef\s+enum\s*\{(.*?)\}\s*ES_EventType_t', text, re.S)
+    if m:
+        events = [e.split('=')[0].strip() for e in m.group(1).split(',')
+                  if e.strip()]
+    return roots, macros, events
+
+
+def ReadProject(path):
+    """the .c files that a Keil project builds, and the defines of its C
+    compiler options"""
+    with open(path, errors='replace') as f:
+        text = f.read()
+    files = set(re.split(r'[\\/]', f)[-1] for f in
+                re.findall(r'<FilePath>([^<]*\.c)</FilePath>', text, re.I))
+    defines = {}
+    m = re.search(r'<Cads>.*?<Define>([^<]*)</Define>', text, re.S)
+    if m:
+        for word in m.group(1).replace(',', ' ').split():
+            name, _, value = word.partition('=')
+            defines[name] = value
+    return files, defines
+
+
+def ReadHeaderDefines(folder, defines):
+    """adds what the headers define, ES_Configure.h first since the others
+    may test it"""
+    names = sorted(f for f in os.listdir(folder) if f.endswith('.h'))
+    names.sort(key=lambda f: f != 'ES_Configure.h')
+    for f in names:
+        with open(os.path.join(folder, f), errors='replace') as h:
+            StripSource(h.read(), defines)
+
+
+def ReadStartup(path):
+    isrs = []
+    stack = None
+    with open(path, errors='replace') as f:
+        for line in f:
+            line = line.split(';')[0]
+            m = re.match(r'\s*DCD\s+(\w+)\s*$', line)
+            if m and m.group(1) not in ('0', 'Reset_Handler',
+                                        'IntDefaultHandler'):
+                isrs.append(m.group(1))
+            m = re.match(r'\s*Stack\s+EQU\s+(\w+)', line)
+            if m:
+                stack = int(m.group(1), 0)
+    return isrs, stack
+
+
+def ReadProfile(path, events):
+    """the table that ES_Profile_Dump prints, as (service, event, count,
+    average uS, max uS)"""
+    rows = []
+    with open(path, errors='replace') as f:
+        for line in f:
+            m = re.match(r'\s*(\w+)\s+(\d+)\s+(\d+)\s+(\d+)\s+(\d+)\s+\d+'
+                         r'\s+\d+\s*$', line)
+            if m:
+                event = int(m.group(2))
+                rows.append((m.group(1), events[event] if event < len(events)
+                             else str(event), int(m.group(3)),
+                             int(m.group(4)), int(m.group(5))))
+    return rows
+
+
+def Show(depth):
+    return ('%d' if depth[1] else '~%d') % depth[0]
+
+
+def main():
+    parser = argparse.ArgumentParser(description='stack depth, recursion '
+                                     'and blocking call report for an ES '
+                                     'framework project')
+    parser.add_argument('--dir', default='.', help='the FrameworkCode '
+                        'directory, with Source, Headers & StartUp')
+    parser.add_argument('--su', help='directory of gcc -fstack-usage files')
+    parser.add_argument('--keil', help='Keil linker call graph (.htm)')
+    parser.add_argument('--frame', type=int, default=32, help='bytes to '
+                        'assume for a function with no known frame')
+    parser.add_argument('--recursion', type=int, default=1, help='extra '
+                        'levels to allow a recursive function, 1 covers the '
+                        'ES_EXIT/ES_ENTRY calls of HSMTemplate.c')
+    parser.add_argument('--nesting', type=int, help='interrupts that can '
+                        'be active at once, the deepest ones are counted. '
+                        'Defaults to all of them')
+    parser.add_argument('--profile', help='ES_Profile_Dump output')
+    parser.add_argument('--budget-us', type=int, help='flag profiled run '
+                        'functions slower than this')
+    parser.add_argument('--path', action='store_true', help='print the '
+                        'deepest call path of each root')
+    parser.add_argument('--define', '-D', action='append', default=[],
+                        metavar='NAME[=VALUE]', help='define a macro, as '
+                        'for the compiler, to look at another configuration')
+    args = parser.parse_args()
+
+    # what the target build defines, and which files it builds
+    defines = {}
+    built = None
+    for f in sorted(os.listdir(args.dir)):
+        if f.endswith('.uvprojx'):
+            built, defines = ReadProject(os.path.join(args.dir, f))
+            break
+    for word in args.define:
+        name, _, value = word.partition('=')
+        defines[name] = value or '1'
+    headers = os.path.join(args.dir, 'Headers')
+    if os.path.isdir(headers):
+        ReadHeaderDefines(headers, defines)
+
+    functions = {}
+    address_taken = {}
+    used = {}
+    for sub in ('Source', 'Headers'):
+        folder = os.path.join(args.dir, sub)
+        if not os.path.isdir(folder):
+            continue
+        for f in sorted(os.listdir(folder)):
+            if (f.endswith('.c') and (built is None or f in built)) or \
+                    (f.endswith('.h') and sub == 'Headers'):
+                ParseFile(os.path.join(folder, f), functions, address_taken,
+                          used, defines)
+
+    roots, config_macros, events = ReadConfig(
+        os.path.join(args.dir, 'Headers', 'ES_Configure.h'), defines)
+    roots.insert(0, ('main', 'main'))
+    stack_size = None
+    startup = os.path.join(args.dir, 'StartUp')
+    if os.path.isdir(startup):
+        for f in sorted(os.listdir(startup)):
+            if f.lower().endswith('.s'):
+                isrs, size = ReadStartup(os.path.join(startup, f))
+                roots += [(i, 'isr') for i in isrs if i in functions]
+                stack_size = size or stack_size
+
+    ReadFrames(args, functions)
+    callers = Resolve(functions, address_taken, used, config_macros)
+    analyzer = Analyzer(functions, callers, address_taken, args)
+
+    print('Stack, in bytes, ~ if a frame of %d was assumed somewhere'
+          % args.frame)
+    print(('%-28s %-8s %7s %6s  %s' % ('Root', 'Kind', 'Depth', 'Calls',
+           'Deepest path' if args.path else '')).rstrip())
+    depths = {}
+    for name, kind in roots:
+        if name not in functions:
+            print('%-28s %-8s %7s' % (name, kind, 'missing'))
+            continue
+        depths[name] = d = analyzer.Depth(name)
+        print(('%-28s %-8s %7s %6d  %s' % (name, kind, Show(d), len(d[2]),
+               ' > '.join(d[2]) if args.path else '')).rstrip())
+
+    # the worst case is the main stack plus the deepest interrupts nested
+    # on it, each with its exception frame
+    main_depth = depths.get('main', (0, True, ()))
+    isr_depths = sorted((depths[n] for n, k in roots
+                         if k == 'isr' and n in depths), reverse=True)
+    if args.nesting is not None:
+        isr_depths = isr_depths[:args.nesting]
+    total = main_depth[0] + sum(d[0] + EXCEPTION_FRAME for d in isr_depths)
+    known = main_depth[1] and all(d[1] for d in isr_depths)
+    print('\nworst case, main + %d nested interrupts: %s bytes'
+          % (len(isr_depths), Show((total, known))), end='')
+    if stack_size:
+        print(' of %d (Stack EQU in the startup file)%s' % (stack_size,
+              ', OVERFLOW' if total > stack_size else ''))
+    else:
+        print()
+
+    if analyzer.recursion:
+        print('\nRecursion, counted for %d extra level(s):' % args.recursion)
+        for group in sorted(analyzer.recursion):
+            print('  ' + ', '.join(group))
+
+    print('\nBlocking calls:')
+    any_blocking = False
+    for name, kind in roots:
+        # start up is allowed to wait on the hardware
+        if name not in functions or kind in ('main', 'init'):
+            continue
+        for what, path in sorted(analyzer.Blocking(name).items()):
+            any_blocking = True
+            print('  %-26s %s' % (name, what))
+            if args.path:
+                print('    ' + ' > '.join(path))
+    if not any_blocking:
+        print('  none')
+
+    if args.profile:
+        print('\nRun function times from %s, uS' % args.profile)
+        print('%-24s %-26s %8s %7s %7s' % ('Service', 'Event', 'Count',
+                                           'Avg', 'Max'))
+        for service, event, count, avg, worst in sorted(
+                ReadProfile(args.profile, events), key=lambda r: -r[4]):
+            flag = '  OVER BUDGET' if args.budget_us is not None and \
+                worst > args.budget_us else ''
+            print('%-24s %-26s %8d %7d %7d%s' % (service, event, count, avg,
+                                                 worst, flag))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
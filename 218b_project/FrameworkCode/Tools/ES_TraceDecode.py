@@ -0,0 +1,211 @@
+#!/usr/bin/env python3
+"""
+ Module
+     ES_TraceDecode.py
+ Description
+     turns the output of ES_Trace_Dump back into a readable timeline of
+     posts and dispatches, with the services, event types and interrupts
+     named, followed by a summary:
+       - records lost to the ring wrapping
+       - posts refused by a full queue or bus, and posts merged by a
+         coalescing rule
+       - for each service, the dispatches and the longest time an event
+         waited between its post and its dispatch
+ Notes
+     The names come from ES_Configure.h (SERVICE_LIST or SERV_n_RUN, and the
+     ES_EventType_t enum) and from the vector table in the startup file, so
+     run it against the sources of the build that made the capture. The
+     capture can have other terminal output around it, the last complete
+     dump in the file is used.
+
+     Waits are matched up by keeping a model of each queue, which only
+     works if every post is in the capture and none of them went through
+     the bus, so there are none for a capture whose ring had wrapped or that
+     has publishes in it.
+
+     usage, from the FrameworkCode directory:
+       python3 Tools/ES_TraceDecode.py capture.txt
+       python3 Tools/ES_TraceDecode.py --summary capture.txt
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 22:30         started coding
+"""
+import argparse
+import os
+import re
+import sys
+
+sys.dont_write_bytecode = True
+from ES_Analyze import ReadConfig  # noqa: E402
+
+# must agree with ES_Trace.h
+KINDS = {0: 'post', 1: 'lifo', 2: 'merged', 3: 'publish', 4: 'run'}
+REFUSED = 0x80
+DISPATCH = 4
+NO_SERVICE = 0xFF
+BUS = 0xFE
+TRACE_FORMAT = 1
+
+# the host port has no exception numbers, every interrupt is reported as 1,
+# which is the reset vector on the Tiva and so never seen there
+HOST_INTERRUPT = 1
+
+
+class Record(object):
+    def __init__(self, line):
+        self.time = int(line[0:8], 16)
+        self.param = int(line[8:12], 16)
+        self.type = int(line[12:14], 16)
+        self.kind = int(line[14:16], 16)
+        self.source = int(line[16:18], 16)
+        self.interrupt = int(line[18:20], 16)
+        self.target = int(line[20:22], 16)
+
+
+def ReadCapture(path):
+    """the header numbers and the records of the last complete dump"""
+    dump = None
+    header = None
+    records = []
+    with open(path, errors='replace') as f:
+        for line in f:
+            line = line.strip()
+            m = re.match(r'ES_TRACE (\d+) (\d+) (\d+) (\d+)$', line)
+            if m:
+                header = [int(g) for g in m.groups()]
+                records = []
+            elif line == 'ES_TRACE_END' and header is not None:
+                dump = (header, records)
+                header = None
+            elif header is not None and re.match(r'[0-9a-fA-F]{22}$', line):
+                records.append(Record(line))
+    return dump
+
+
+def ReadVectors(folder):
+    """exception number to handler name, the comment is used for the ones
+    that are left on IntDefaultHandler"""
+    names = {}
+    if not os.path.isdir(folder):
+        return names
+    for f in sorted(os.listdir(folder)):
+        if not f.lower().endswith(('.s', '.asm')):
+            continue
+        number = 0
+        with open(os.path.join(folder, f), errors='replace') as src:
+            for line in src:
+                m = re.match(r'\s*DCD\s+([^;]+?)\s*(?:;\s*(.*))?$', line)
+                if not m:
+                    continue
+                handler = m.group(1)
+                if handler == 'IntDefaultHandler' and m.group(2):
+                    handler = m.group(2).strip()
+                names[number] = handler
+                number += 1
+    names[HOST_INTERRUPT] = 'interrupt'
+    return names
+
+
+def main():
+    parser = argparse.ArgumentParser(description='decode an ES_Trace_Dump '
+                                     'capture into a timeline')
+    parser.add_argument('capture', help='terminal output holding the dump')
+    parser.add_argument('--dir', default='.', help='the FrameworkCode '
+                        'directory, with Headers & StartUp')
+    parser.add_argument('--summary', action='store_true', help='leave out '
+                        'the timeline')
+    args = parser.parse_args()
+
+    dump = ReadCapture(args.capture)
+    if dump is None:
+        print('no complete ES_TRACE dump in %s' % args.capture)
+        return 1
+    (fmt, written, num_services, cycles_per_us), records = dump
+    if fmt != TRACE_FORMAT:
+        print('trace format %d, this decoder reads %d' % (fmt, TRACE_FORMAT))
+        return 1
+
+    roots, _, events = ReadConfig(os.path.join(args.dir, 'Headers',
+                                               'ES_Configure.h'))
+    services = [name for name, kind in roots if kind == 'service']
+    if len(services) != num_services:
+        print('warning: the capture has %d services, ES_Configure.h has %d'
+              % (num_services, len(services)))
+    vectors = ReadVectors(os.path.join(args.dir, 'StartUp'))
+
+    def Service(n):
+        if n == BUS:
+            return 'bus'
+        if n == NO_SERVICE:
+            return '-'
+        return services[n] if n < len(services) else 'service %d' % n
+
+    def Event(r):
+        name = events[r.type] if r.type < len(events) else str(r.type)
+        return '%s(%d)' % (name, r.param)
+
+    def Who(r):
+        if r.interrupt != 0:
+            return vectors.get(r.interrupt, 'exception %d' % r.interrupt)
+        if r.source == NO_SERVICE:
+            return 'main' if r.kind != DISPATCH else ''
+        return Service(r.source)
+
+    # time stamps are cycle counts that wrap, add up the differences
+    lost = written - len(records)
+    model_queues = lost == 0 and not any(r.kind & ~REFUSED == 3
+                                         for r in records)
+    now = 0
+    last = records[0].time if records else 0
+    queues = {}
+    waits = {}
+    runs = {}
+    refused = []
+    merged = 0
+    if not args.summary:
+        print('%12s %9s  %-22s %-8s %-22s %s' % ('uS', '+uS', 'by', 'what',
+                                                 'to', 'event'))
+    for r in records:
+        delta = (r.time - last) & 0xFFFFFFFF
+        last = r.time
+        now += delta
+        kind = r.kind & ~REFUSED
+        what = KINDS.get(kind, 'kind %d' % kind)
+        if r.kind & REFUSED:
+            what += '!'
+            refused.append(r)
+        elif kind == 2:
+            merged += 1
+        elif kind == 0:
+            queues.setdefault(r.target, []).append(now)
+        elif kind == 1:
+            queues.setdefault(r.target, []).insert(0, now)
+        elif kind == DISPATCH:
+            runs[r.target] = runs.get(r.target, 0) + 1
+            queue = queues.get(r.target)
+            if model_queues and queue:
+                wait = now - queue.pop(0)
+                waits[r.target] = max(waits.get(r.target, 0), wait)
+        if not args.summary:
+            print('%12.3f %9.3f  %-22s %-8s %-22s %s' % (
+                now / cycles_per_us, delta / cycles_per_us, Who(r), what,
+                Service(r.target), Event(r)))
+
+    print('\n%d records, %.3f mS' % (len(records), now / cycles_per_us /
+                                     1000.0))
+    if lost > 0:
+        print('%d older records were overwritten' % lost)
+    print('%d posts merged, %d refused' % (merged, len(refused)))
+    for r in refused:
+        print('  refused: %s %s to %s' % (Who(r), Event(r),
+                                          Service(r.target)))
+    print('\n%-26s %8s %12s' % ('Service', 'Runs', 'MaxWait uS'))
+    for n in sorted(runs):
+        print('%-26s %8d %12s' % (Service(n), runs[n], (
+            '%.3f' % (waits[n] / cycles_per_us)) if n in waits else '-'))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
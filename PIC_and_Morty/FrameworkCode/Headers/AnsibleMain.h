@@ -16,6 +16,24 @@
 //State definition for use with the query function 
 typedef enum{InitAnsible, WaitingForPair, WaitingForPairResp, CommunicatingSHIP} AnsibleMainState_t; 
 
+// CTRL scheduling counts, see PrintCtrlStats, 32 bits so that they last a
+// long run
+typedef struct
+{
+  uint32_t Moves;             // sensor updates with a control past the deadband
+  uint32_t Deferred;          // moves held back for CTRL_MIN_GAP
+  uint32_t MoveSends;         // CTRLs sent for a move
+  uint32_t Resends;           // CTRLs sent again for no STATUS back
+  uint32_t KeepAlives;        // CTRLs sent with nothing moved
+  uint32_t Suppressed;        // sensor updates with nothing to send
+  uint32_t PairedMs;          // time paired, up to the last CTRL
+  uint32_t MoveLatencyTotal;  // mS, move seen to CTRL sent
+  uint32_t MoveLatencyMax;
+  uint32_t RoundTrips;        // CTRLs timed to their STATUS
+  uint32_t RoundTripTotal;    // mS
+  uint32_t RoundTripMax;
+} AnsibleCtrlStats_t;
+
 // Public Function Prototypes
 uint8_t getCurrentBoat( void ); 
 
@@ -24,6 +42,9 @@ bool InitAnsibleMain(uint8_t Priority);
 bool PostAnsibleMain(ES_Event_t ThisEvent);
 ES_Event_t RunAnsibleMainSM(ES_Event_t ThisEvent);
 bool getpairStatus( void );
+AnsibleMainState_t QueryAnsible(void);
+AnsibleCtrlStats_t const *QueryCtrlStats(void);
+void PrintCtrlStats(void);
 
 
 
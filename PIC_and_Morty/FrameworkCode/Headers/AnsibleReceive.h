@@ -12,15 +12,20 @@
 #include <stdbool.h>
 
 #include "ES_Events.h"
+#include "ES_Fsm.h"
 
 // Public Function Prototypes
 
 //State definition for use with the query function 
-typedef enum{WaitingForStart, WaitingForMSBLen, WaitingForLSBLen,ReceivingData,ReceivingCheckSum} AnsibleRXState_t; 
+#define ANSIBLE_RX_STATES(ES_FSM_STATE) \
+  ES_FSM_STATE(WaitingForFrame)
+
+typedef enum{ ANSIBLE_RX_STATES(ES_FSM_STATE_NAME) } AnsibleRXState_t; 
 
 bool InitAnsibleRX(uint8_t Priority);
 bool PostAnsibleRX(ES_Event_t ThisEvent);
 ES_Event_t RunAnsibleRXSM(ES_Event_t ThisEvent);
+void AnsibleRXByte(uint8_t Byte);
 uint8_t getFuelStatus ( void ); 
 
 #endif 
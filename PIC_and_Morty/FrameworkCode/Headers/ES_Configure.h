@@ -268,7 +268,9 @@ typedef enum
   ES_TX_COMPLETE,
   ES_BEGIN_TX,
   BYTE_RECEIVED, 
+  FRAME_RECEIVED,           /* EventParam is the pool handle of the frame */
   STATUS_RX, 
+  ES_CONTROLS_UPDATED,      /* SensorUpdate has taken new readings */
   ES_BUTTON_DOWN,
   ES_BUTTON_UP,
   
@@ -278,6 +280,10 @@ typedef enum
   ES_LCD_PUTCHAR
 }ES_EventType_t;
 
+// the number of event types, keep this one more than the last entry above.
+// Used to size the per event type tables
+#define NUM_EVENT_TYPES (ES_LCD_PUTCHAR + 1)
+
 /****************************************************************************/
 // These are the definitions for the Distribution lists. Each definition
 // should be a comma separated list of post functions to indicate which
@@ -308,6 +314,15 @@ typedef enum
 #define DIST_LIST7 PostTemplateFSM
 #endif
 
+/****************************************************************************/
+// Pools of fixed size blocks for event payloads too big for the EventParam
+// (see ES_Pool.h). Each ES_POOL(BlockSize, NumBlocks) entry is a size class,
+// smallest first, and BlockSize must be a plain number. POOL_EVENT_LIST is
+// a comma separated list of the event types whose EventParam is a pool
+// handle. Leave ES_POOL_LIST commented out to leave the pools out.
+#define ES_POOL_LIST(ES_POOL) ES_POOL(16, 8) ES_POOL(112, 4)
+#define POOL_EVENT_LIST FRAME_RECEIVED
+
 /****************************************************************************/
 // This is the list of event checking functions
 #define EVENT_CHECK_LIST Check4Keystroke, CheckButtonEvents
@@ -326,7 +341,7 @@ typedef enum
 #define TIMER4_RESP_FUNC PostSensorUpdate
 #define TIMER5_RESP_FUNC PostScreenService
 #define TIMER6_RESP_FUNC PostAnsibleTX
-#define TIMER7_RESP_FUNC PostAnsibleRX
+#define TIMER7_RESP_FUNC TIMER_UNUSED
 #define TIMER8_RESP_FUNC PostButton
 #define TIMER9_RESP_FUNC TIMER_UNUSED
 #define TIMER10_RESP_FUNC TIMER_UNUSED
@@ -350,7 +365,6 @@ typedef enum
 #define DEBOUNCE_TIMER          4
 #define SCREEN_UPDATE_TIMER     5
 #define TX_ATTEMPT_TIMER        6
-#define RX_ATTEMPT_TIMER        7
 #define BUTTON_DEBOUNCE_TIMER   8
 #define SERVICE0_TIMER          15
 /**************************************************************************/
@@ -358,4 +372,11 @@ typedef enum
 // PF1 & PF2
 //#define _INCLUDE_BASIC_FRAMEWORK_DEBUG_
 
+/**************************************************************************/
+// comment this line out to take every tick interrupt while the framework is
+// idle rather than sleep between timer expiries. The event checkers only get
+// called when something wakes the processor, here at least every 7 ms for
+// IMU_TIMER, which is plenty for CheckButtonEvents and the keystrokes.
+#define ES_TICKLESS_IDLE
+
 #endif /* ES_CONFIGURE_H */
@@ -0,0 +1,61 @@
+/****************************************************************************
+ Module
+     ES_Mailbox.h
+ Description
+     header file for the latest-value mailboxes that carry samples from an
+     interrupt response to the services without turning interrupts off
+ Notes
+     A mailbox holds one value of any type. Exactly one writer, usually an
+     interrupt response, replaces the whole value with ES_Mailbox_Write.
+     Any number of readers take a copy with ES_Mailbox_Read, and always get
+     a value that one write put there, never half of one write and half of
+     the next. Readers never block the writer, a reader that was interrupted
+     by a write simply copies again.
+
+       typedef struct { uint16_t X, Y, Z; } Accel_t;
+       ES_MAILBOX(AccelBox, Accel_t);
+       ...
+       in the interrupt response:
+         ES_Mailbox_Write(&AccelBox, &NewSample);
+       in a service:
+         Accel_t Sample;
+         if (ES_Mailbox_Read(&AccelBox, &Sample) != 0) ...
+
+     A reader must not run at a higher interrupt priority than the writer of
+     the same mailbox, it would spin forever on the write it interrupted.
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 23:30         started coding
+*****************************************************************************/
+#ifndef ES_Mailbox_H
+#define ES_Mailbox_H
+
+#include "ES_Types.h"
+
+typedef struct
+{
+  volatile uint32_t Sequence;   // odd while a write is under way
+  uint16_t          Size;       // bytes in the value
+  void              *pValue;
+}ES_Mailbox_t;
+
+/****************************************************************************
+ Macro
+   ES_MAILBOX
+ Parameters
+   Name : what to call the mailbox
+   Type : the type of the value that it carries
+ Description
+   declares a mailbox and the memory for its value, ready to use. The value
+   reads as all zeros until the first write.
+ ***************************************************************************/
+#define ES_MAILBOX(Name, Type)                                      \
+  static Type Name##Value;                                          \
+  static ES_Mailbox_t Name = { 0, sizeof(Type), &Name##Value }
+
+void ES_Mailbox_Write(ES_Mailbox_t *pBox, void const *pNewValue);
+uint32_t ES_Mailbox_Read(ES_Mailbox_t *pBox, void *pCopy);
+uint32_t ES_Mailbox_GetCount(ES_Mailbox_t const *pBox);
+
+#endif /* ES_Mailbox_H */
@@ -0,0 +1,80 @@
+/****************************************************************************
+ Module
+     ES_Pool.h
+ Description
+     header file for the optional pools of fixed size blocks that events can
+     use to carry payloads too big for the EventParam
+ Notes
+     Everything here compiles away unless ES_POOL_LIST is defined in
+     ES_Configure.h
+
+     A payload event has a type listed in POOL_EVENT_LIST and a handle from
+     ES_Pool_Alloc in its EventParam. The framework takes a reference to the
+     block for every queue the event is put in, and gives it back when the
+     run function that got the event returns, so the block lives until the
+     last service on a distribution list is done with it. The poster owns
+     the reference that ES_Pool_Alloc returns and must release it once it
+     has posted:
+
+       Handle = ES_Pool_Alloc(Length);
+       if (Handle != ES_POOL_NO_HANDLE)
+       {
+         memcpy(ES_Pool_GetPtr(Handle), pFrame, Length);
+         ThisEvent.EventType = ES_FRAME_RECEIVED;
+         ThisEvent.EventParam = Handle;
+         ES_PostList00(ThisEvent);
+         ES_Pool_Release(Handle);
+       }
+
+     A service that wants to keep the block after its run function returns
+     must call ES_Pool_Retain, and ES_Pool_Release when it is done.
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 17:30         started coding
+*****************************************************************************/
+#ifndef ES_Pool_H
+#define ES_Pool_H
+
+#include "ES_Configure.h"
+#include "ES_Types.h"
+#include "ES_Events.h"
+
+// handles travel in the 16 bit EventParam, 0 is never a valid handle
+typedef uint16_t ES_PoolHandle_t;
+#define ES_POOL_NO_HANDLE ((ES_PoolHandle_t)0)
+
+#ifdef ES_POOL_LIST
+
+// what is kept for each size class
+typedef struct
+{
+  uint16_t BlockSize;   // bytes in each block
+  uint8_t  NumBlocks;
+  uint8_t  InUse;       // blocks allocated now
+  uint8_t  MaxInUse;    // most blocks allocated at once
+  uint16_t Failures;    // allocations that found no free block
+}ES_PoolStats_t;
+
+void ES_Pool_Init(void);
+ES_PoolHandle_t ES_Pool_Alloc(uint16_t Length);
+bool ES_Pool_Retain(ES_PoolHandle_t Handle);
+bool ES_Pool_Release(ES_PoolHandle_t Handle);
+void *ES_Pool_GetPtr(ES_PoolHandle_t Handle);
+uint16_t ES_Pool_GetLength(ES_PoolHandle_t Handle);
+bool ES_Pool_SetLength(ES_PoolHandle_t Handle, uint16_t Length);
+bool ES_Pool_IsPayloadEvent(ES_EventType_t WhichEvent);
+void ES_Pool_HoldEvent(ES_Event_t ThisEvent);
+void ES_Pool_DropEvent(ES_Event_t ThisEvent);
+bool ES_Pool_GetStats(uint8_t WhichClass, ES_PoolStats_t *pStats);
+void ES_Pool_PrintStats(void);
+
+#else
+
+// without the pools no event carries a block, so there is nothing to hold
+#define ES_Pool_HoldEvent(ThisEvent) ((void)0)
+#define ES_Pool_DropEvent(ThisEvent) ((void)0)
+
+#endif /* ES_POOL_LIST */
+
+#endif /* ES_Pool_H */
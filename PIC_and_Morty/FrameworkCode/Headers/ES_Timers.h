@@ -42,6 +42,9 @@ typedef enum
   ES_Timer_NOT_ACTIVE = 0
 }ES_TimerReturn_t;
 
+// returned by ES_Timer_GetTicksToNextExpiry when no timers are running
+#define ES_Timer_NO_EXPIRY 0xFFFFFFFFUL
+
 void ES_Timer_Init(TimerRate_t Rate);
 void ES_Timer_Tick_Resp(void);
 ES_TimerReturn_t ES_Timer_InitTimer(uint8_t Num, uint16_t NewTime);
@@ -49,6 +52,8 @@ ES_TimerReturn_t ES_Timer_SetTimer(uint8_t Num, uint16_t NewTime);
 ES_TimerReturn_t ES_Timer_StartTimer(uint8_t Num);
 ES_TimerReturn_t ES_Timer_StopTimer(uint8_t Num);
 uint16_t ES_Timer_GetTime(void);
+uint32_t ES_Timer_GetTicksToNextExpiry(void);
+void ES_Timer_AdvanceTicks(uint32_t Ticks);
 
 #endif   /* ES_Timers_H */
 /*------------------------------ End of file ------------------------------*/
@@ -9,6 +9,7 @@
 #include "ES_Types.h"     /* gets bool type for returns */
 #include "ES_Events.h" // Erez Added 
 #include "ES_Framework.h"
+#include "ES_Mailbox.h"
 
 // Configuration Headers 
 #include "ES_Framework.h"
@@ -31,9 +32,21 @@
 
 #include "MPU9250_RegisterMap.h"
 
+// one complete read of the IMU, raw register values
+typedef struct
+{
+    uint16_t accel_x;
+    uint16_t accel_y;
+    uint16_t accel_z;
+    uint16_t gyro_x;
+    uint16_t gyro_y;
+    uint16_t gyro_z;
+} IMU_Sample_t;
+
 bool InitIMU(uint8_t Priority);
 bool PostIMU(ES_Event_t ThisEvent);
 ES_Event_t RunIMU(ES_Event_t ThisEvent);
+uint32_t get_imu_sample( IMU_Sample_t *pSample );
 uint16_t get_accel_x( void );
 uint16_t get_accel_y( void );
 uint16_t get_accel_z( void );
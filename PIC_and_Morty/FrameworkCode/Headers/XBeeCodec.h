@@ -0,0 +1,74 @@
+/****************************************************************************
+
+  Header file for the XBee packet codec, shared by the ANSIBLE and the SHIP.
+  The same file is in both projects, keep them the same.
+
+  Every packet of the class protocol is one line of XBEE_MESSAGES: its
+  name, the header byte that starts its RF data and how many payload bytes
+  follow the header. XBEE_API_FRAMES does the same for the XBee API frames
+  the packets travel in. XBeeCodec_Encode and XBeeCodec_Decode work the
+  lengths out from these tables, nothing else should know a frame offset.
+
+ ****************************************************************************/
+#ifndef XBeeCodec_H
+#define XBeeCodec_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Name, header byte, payload bytes after the header
+#define XBEE_MESSAGES(XBEE_MESSAGE) \
+  XBEE_MESSAGE(REQ_2_PAIR, 0x01, 1) \
+  XBEE_MESSAGE(PAIR_ACK,   0x02, 0) \
+  XBEE_MESSAGE(CTRL,       0x03, 5) \
+  XBEE_MESSAGE(STATUS,     0x04, 2)
+
+// payload byte positions, after the header
+#define XBEE_REQ_2_PAIR_COLOUR  0   // 0 blue, 1 red
+#define XBEE_CTRL_FB            0
+#define XBEE_CTRL_LR            1
+#define XBEE_CTRL_TURRET_YAW    2
+#define XBEE_CTRL_TURRET_PITCH  3
+#define XBEE_CTRL_CONTROL       4
+#define XBEE_STATUS_FUEL        0
+#define XBEE_STATUS_CONTROL     1
+
+// Name, API identifier. Both carry an RF data packet behind the same 5 byte
+// layout: API identifier, then frame ID, destination MSB, destination LSB
+// and options for a transmit request, or source MSB, source LSB, RSSI and
+// options for a received packet
+#define XBEE_API_FRAMES(XBEE_API_FRAME) \
+  XBEE_API_FRAME(TX_REQUEST, 0x01) \
+  XBEE_API_FRAME(RX_PACKET,  0x81)
+
+#define XBEE_MESSAGE_ID(Name, Header, NumBytes) XBEE_##Name = (Header),
+typedef enum { XBEE_MESSAGES(XBEE_MESSAGE_ID) } XBeeMessage_t;
+
+#define XBEE_API_ID(Name, Identifier) XBEE_##Name = (Identifier),
+typedef enum { XBEE_API_FRAMES(XBEE_API_ID) } XBeeApi_t;
+
+// the largest payload in XBEE_MESSAGES
+#define XBEE_MAX_PAYLOAD    5
+// start delimiter, 2 length bytes, 5 byte API header, message header,
+// payload and check sum
+#define XBEE_MAX_FRAME      (3 + 5 + 1 + XBEE_MAX_PAYLOAD + 1)
+
+// one packet, as the fields of its API frame
+typedef struct
+{
+  XBeeApi_t     Api;
+  uint8_t       FrameId;    // transmit request only, 0 for no TX status
+  uint16_t      Address;    // destination or source
+  uint8_t       Rssi;       // received packet only
+  uint8_t       Options;
+  XBeeMessage_t Message;
+  uint8_t       Payload[XBEE_MAX_PAYLOAD];
+} XBeePacket_t;
+
+uint8_t XBeeCodec_Encode(XBeePacket_t const *pPacket, uint8_t *pFrame,
+    uint8_t Size);
+bool XBeeCodec_Decode(uint8_t const *pFrameData, uint16_t Length,
+    XBeePacket_t *pPacket);
+uint8_t XBeeCodec_PayloadLength(XBeeMessage_t Message);
+
+#endif /* XBeeCodec_H */
@@ -6,16 +6,26 @@
    1.0.1
 
  Description
-   This file implements a set of functions to initialize and read up to 4 
+   This file implements a set of functions to initialize and read up to 4
    A/D channels on the Tiva
 
  Notes
+  ADC_MultiRead converts on demand and waits for the result. After
+  ADC_MultiStartContinuous, Timer 4A triggers the conversions in hardware,
+  the sequence 2 interrupt copies each set of results into a double
+  buffer, and readers take the latest set with ADC_MultiLatest without
+  waiting. In that mode ADC_MultiRead returns the latest set as well.
+
+  Compiled with ES_PORT_POSIX, the registers are replaced by plain
+  variables and a fake converter so that the module can be tested on the
+  host, see ADC_MultiFakeSetInput and ADC_MultiFakeTimerTimeout.
+
   I started with ADCSWTrigger.c from Valvano's book for the basic operation
   sequence. That exmaple did only 2 fixed channels, so I re-wrote it to
   take a parameter to specify how many channels and generalize the init
   constants into a set of data structures rather than hard coded constants.
   All of the magic numbers are left over from the original example. Mea Culpa!
-  
+
  History
  When           Who     What/Why
  -------------- ---     --------
@@ -25,30 +35,111 @@
 
 /*----------------------------- Include Files -----------------------------*/
 #include <stdint.h>
+#ifndef ES_PORT_POSIX
 #include "inc/hw_gpio.h"
 #include "inc/hw_types.h"
 #include "inc/hw_memmap.h"
 #include "inc/hw_sysctl.h"
 #include "inc/tm4c123gh6pm.h"
+#endif
 
 #include "ADMulti.h"
 
 /*----------------------------- Module Defines ----------------------------*/
-// None
+#define TICKS_PER_US 40     // Timer 4 runs from the 40MHz system clock
+
+// ADC0 sequence 2 is interrupt 16
+#define ADC0SS2_NVIC_BIT (1UL << 16)
+
+#ifdef ES_PORT_POSIX
+// register level stand-ins for the host. The peripherals are always
+// ready, the registers are fields of Fake, and the reads that have side
+// effects on the real part go through the fake converter at the end of
+// this file
+typedef struct
+{
+  uint32_t RCGCADC, RCGCGPIO, RCGCTIMER;
+  uint32_t PORTE_DIR, PORTE_AFSEL, PORTE_DEN, PORTE_AMSEL;
+  uint32_t PC, SSPRI, ACTSS, EMUX, SSMUX2, SSCTL2, IM, PSSI, RIS, ISC;
+  uint32_t T4_CTL, T4_CFG, T4_TAMR, T4_TAILR;
+  uint32_t NVIC_EN0, NVIC_DIS0;
+}FakeRegs_t;
+
+static volatile FakeRegs_t Fake;
+
+static uint32_t FakeReadRIS(void);
+static uint32_t FakePopFIFO(void);
+
+#define SYSCTL_RCGCADC_R    Fake.RCGCADC
+#define SYSCTL_PRADC_R      0xFFFFFFFFUL
+#define SYSCTL_RCGCGPIO_R   Fake.RCGCGPIO
+#define SYSCTL_PRGPIO_R     0xFFFFFFFFUL
+#define SYSCTL_RCGCTIMER_R  Fake.RCGCTIMER
+#define SYSCTL_PRTIMER_R    0xFFFFFFFFUL
+#define GPIO_PORTE_DIR_R    Fake.PORTE_DIR
+#define GPIO_PORTE_AFSEL_R  Fake.PORTE_AFSEL
+#define GPIO_PORTE_DEN_R    Fake.PORTE_DEN
+#define GPIO_PORTE_AMSEL_R  Fake.PORTE_AMSEL
+#define ADC0_PC_R           Fake.PC
+#define ADC0_SSPRI_R        Fake.SSPRI
+#define ADC0_ACTSS_R        Fake.ACTSS
+#define ADC0_EMUX_R         Fake.EMUX
+#define ADC0_SSMUX2_R       Fake.SSMUX2
+#define ADC0_SSCTL2_R       Fake.SSCTL2
+#define ADC0_IM_R           Fake.IM
+#define ADC0_PSSI_R         Fake.PSSI
+#define ADC0_RIS_R          FakeReadRIS()
+#define ADC0_ISC_R          Fake.ISC
+#define ADC0_SSFIFO2_R      FakePopFIFO()
+#define TIMER4_CTL_R        Fake.T4_CTL
+#define TIMER4_CFG_R        Fake.T4_CFG
+#define TIMER4_TAMR_R       Fake.T4_TAMR
+#define TIMER4_TAILR_R      Fake.T4_TAILR
+#define NVIC_EN0_R          Fake.NVIC_EN0
+#define NVIC_DIS0_R         Fake.NVIC_DIS0
+
+// and the bit definitions from tm4c123gh6pm.h that are used here
+#define ADC_SSCTL2_END0         0x00000002
+#define ADC_SSCTL2_IE0          0x00000004
+#define ADC_SSCTL2_END1         0x00000020
+#define ADC_SSCTL2_IE1          0x00000040
+#define ADC_SSCTL2_END2         0x00000200
+#define ADC_SSCTL2_IE2          0x00000400
+#define ADC_SSCTL2_END3         0x00002000
+#define ADC_SSCTL2_IE3          0x00004000
+#define ADC_EMUX_EM2_M          0x00000F00
+#define ADC_EMUX_EM2_TIMER      0x00000500
+#define SYSCTL_RCGCGPIO_R4      0x00000010
+#define SYSCTL_PRGPIO_R4        0x00000010
+#define SYSCTL_RCGCTIMER_R4     0x00000010
+#define SYSCTL_PRTIMER_R4       0x00000010
+#define TIMER_CTL_TAEN          0x00000001
+#define TIMER_CTL_TAOTE         0x00000020
+#define TIMER_CFG_32_BIT_TIMER  0x00000000
+#define TIMER_TAMR_TAMR_PERIOD  0x00000002
+#endif
 
 /*---------------------------- Module Functions ---------------------------*/
 // None
 
 /*---------------------------- Module Variables ---------------------------*/
 
-static const uint32_t HowMany2Mask[4] = {0x01,0x03,0x07,0x0F};
+static const uint32_t HowMany2Mask[4] = { 0x01, 0x03, 0x07, 0x0F };
 // this mapping puts PE0 as resuult 0, PE1 as result 1...
-static const uint32_t HowMany2Mux[4] = {0x03,0x023,0x123,0x0123};
-static const uint32_t HowMany2CTL[4] = {ADC_SSCTL2_END0|ADC_SSCTL2_IE0,
-                                        ADC_SSCTL2_END1|ADC_SSCTL2_IE1,
-                                        ADC_SSCTL2_END2|ADC_SSCTL2_IE2,
-                                        ADC_SSCTL2_END3|ADC_SSCTL2_IE3};
-static uint8_t NumChannelsConverting;
+static const uint32_t HowMany2Mux[4] = { 0x03, 0x023, 0x123, 0x0123 };
+static const uint32_t HowMany2CTL[4] = { ADC_SSCTL2_END0 | ADC_SSCTL2_IE0,
+                                         ADC_SSCTL2_END1 | ADC_SSCTL2_IE1,
+                                         ADC_SSCTL2_END2 | ADC_SSCTL2_IE2,
+                                         ADC_SSCTL2_END3 | ADC_SSCTL2_IE3 };
+static uint8_t        NumChannelsConverting;
+
+// the last two sets of results from continuous sampling. The set numbered
+// SampleCount is in Snapshots[SampleCount & 1], the ISR fills the other
+// one and then bumps SampleCount, so a reader has a whole sample period
+// to copy the latest set before it is overwritten
+static volatile uint32_t  Snapshots[2][4];
+static volatile uint32_t  SampleCount;
+static volatile bool      Continuous;
 
 /*------------------------------ Module Code ------------------------------*/
 /****************************************************************************
@@ -64,42 +155,49 @@ static uint8_t NumChannelsConverting;
  Description
     enables the A/D #0 and Port E and configures the converter and the
     port to allow A/D conversions on the requested number of channels
-     
+
  Notes
     Based on example code from Jonathan Valvano
-    
+
  Author
     J. Edward Carryer, 08/22/17, 17:49
 ****************************************************************************/
-void ADC_MultiInit(uint8_t HowMany){ 
-  uint8_t index = HowMany-1; // index into the HowMany2Mask array
-  
+void ADC_MultiInit(uint8_t HowMany)
+{
+  uint8_t index = HowMany - 1; // index into the HowMany2Mask array
+
   // first sanity check on the HowMany parameter
-  if ( (0 == HowMany) || (4 < HowMany))
+  if ((0 == HowMany) || (4 < HowMany))
+  {
     return;
-  
+  }
+
   NumChannelsConverting = HowMany;
-  
+
   SYSCTL_RCGCADC_R |= 0x00000001;                // 1) activate clock for ADC0
-  while((SYSCTL_PRADC_R & 0x0001) != 0x0001)
+  while ((SYSCTL_PRADC_R & 0x0001) != 0x0001)
+  {
     ;                                            // 2) allow time for ADC clock to stabilize
+  }
   SYSCTL_RCGCGPIO_R |= SYSCTL_RCGCGPIO_R4;       // 3) activate clock for Port E
-  while ((HWREG(SYSCTL_PRGPIO) & SYSCTL_PRGPIO_R4) != SYSCTL_PRGPIO_R4)
+  while ((SYSCTL_PRGPIO_R & SYSCTL_PRGPIO_R4) != SYSCTL_PRGPIO_R4)
+  {
     ;                                            // 4) allow time for port E clock to stabilize
-  GPIO_PORTE_DIR_R &= ~HowMany2Mask[index];      // 5) make PE0, PE1, PE2, PE3 inputs
-  GPIO_PORTE_AFSEL_R |= HowMany2Mask[index];     // 6) enable alternate function on PE0 - PE3
-  GPIO_PORTE_DEN_R &= ~HowMany2Mask[index];      // 7) disable digital I/O on PE0 - PE3
-  GPIO_PORTE_AMSEL_R |= HowMany2Mask[index];     // 8) enable analog functionality on PE0 - PE3
-  
-  ADC0_PC_R &= ~0xF;                             // 9) clear max sample rate field 
-  ADC0_PC_R |= 0x3;                              // 10) configure for 250K samples/sec
-  ADC0_SSPRI_R = 0x3210;                         // 11) Set sequencer 3 as lowest priority
-  ADC0_ACTSS_R &= ~0x0004;                       // 12) disable sample sequencer 2
-  ADC0_EMUX_R &= ~0x0F00;                        // 13) Set seq2 as software trigger
-  ADC0_SSMUX2_R = HowMany2Mux[index];            // 14) set channels for SS2
-  ADC0_SSCTL2_R = HowMany2CTL[index];            // 15) set which sample is last
-  ADC0_IM_R &= ~0x0004;                          // 16) disable SS2 interrupts
-  ADC0_ACTSS_R |= 0x0004;                        // 17) enable sample sequencer 2
+  }
+  GPIO_PORTE_DIR_R &= ~HowMany2Mask[index];       // 5) make PE0, PE1, PE2, PE3 inputs
+  GPIO_PORTE_AFSEL_R |= HowMany2Mask[index];      // 6) enable alternate function on PE0 - PE3
+  GPIO_PORTE_DEN_R &= ~HowMany2Mask[index];       // 7) disable digital I/O on PE0 - PE3
+  GPIO_PORTE_AMSEL_R |= HowMany2Mask[index];      // 8) enable analog functionality on PE0 - PE3
+
+  ADC0_PC_R &= ~0xF;                              // 9) clear max sample rate field
+  ADC0_PC_R |= 0x3;                               // 10) configure for 250K samples/sec
+  ADC0_SSPRI_R = 0x3210;                          // 11) Set sequencer 3 as lowest priority
+  ADC0_ACTSS_R &= ~0x0004;                        // 12) disable sample sequencer 2
+  ADC0_EMUX_R &= ~0x0F00;                         // 13) Set seq2 as software trigger
+  ADC0_SSMUX2_R = HowMany2Mux[index];             // 14) set channels for SS2
+  ADC0_SSCTL2_R = HowMany2CTL[index];             // 15) set which sample is last
+  ADC0_IM_R &= ~0x0004;                           // 16) disable SS2 interrupts
+  ADC0_ACTSS_R |= 0x0004;                         // 17) enable sample sequencer 2
 }
 
 /****************************************************************************
@@ -123,18 +221,369 @@ void ADC_MultiInit(uint8_t HowMany){
 
  Notes
     Based on example code from Jonathan Valvano
-    
+    After ADC_MultiStartContinuous it does not wait, it returns the latest
+    set of results, as ADC_MultiLatest does
+
  Author
      J. Edward Carryer, 08/22/17, 17:55
 ****************************************************************************///------------ADC_MultiRead------------
-void ADC_MultiRead(uint32_t data[4]){ 
+void ADC_MultiRead(uint32_t data[4])
+{
   uint8_t i;
-  
+
+  if (Continuous)
+  {
+    // the timer owns the sequencer now, so hand back the latest set
+    ADC_MultiLatest(data);
+    return;
+  }
   ADC0_PSSI_R = 0x0004;               // 1) initiate conversion with SS2
-  while((ADC0_RIS_R & 0x04) == 0)
+  while ((ADC0_RIS_R & 0x04) == 0)
+  {
     ;                                 // 2) wait for conversion(s) to complete
-  for (i=0; i< NumChannelsConverting; i++){
+  }
+  for (i = 0; i < NumChannelsConverting; i++)
+  {
     data[i] = ADC0_SSFIFO2_R & 0xFFF; // 3) read result(s), one at a time
   }
   ADC0_ISC_R = 0x0004;                // 4) acknowledge completion, clear int
 }
+
+/****************************************************************************
+ Function
+    ADC_MultiStartContinuous
+
+ Parameters
+    uint32_t : time between conversions in uS, 10 or more
+
+ Returns
+    nothing
+
+ Description
+    sets up Timer 4A to trigger sequence 2 every SamplePeriodUS and turns
+    on the sequence 2 interrupt, which stores each set of results for
+    ADC_MultiLatest
+
+ Notes
+    call after ADC_MultiInit. ADC0SS2 must point at ADC_MultiISR in the
+    vector table
+
+ Author
+    10/17/26
+****************************************************************************/
+void ADC_MultiStartContinuous(uint32_t SamplePeriodUS)
+{
+  if (SamplePeriodUS < 10)
+  {
+    SamplePeriodUS = 10;    // leave time to get out of the ISR
+  }
+  SYSCTL_RCGCTIMER_R |= SYSCTL_RCGCTIMER_R4;      // 1) activate clock for Timer 4
+  while ((SYSCTL_PRTIMER_R & SYSCTL_PRTIMER_R4) != SYSCTL_PRTIMER_R4)
+  {
+    ;                                             // 2) wait for the clock
+  }
+  TIMER4_CTL_R &= ~TIMER_CTL_TAEN;                // 3) stop timer A while we set it up
+  TIMER4_CFG_R = TIMER_CFG_32_BIT_TIMER;          // 4) one 32 bit timer
+  TIMER4_TAMR_R = TIMER_TAMR_TAMR_PERIOD;         // 5) periodic, counting down
+  TIMER4_TAILR_R = SamplePeriodUS * TICKS_PER_US - 1;
+
+  ADC0_ACTSS_R &= ~0x0004;                        // 6) disable sample sequencer 2
+  ADC0_EMUX_R = (ADC0_EMUX_R & ~ADC_EMUX_EM2_M) | ADC_EMUX_EM2_TIMER;
+  ADC0_ISC_R = 0x0004;                            // 7) clear any old completion
+  ADC0_IM_R |= 0x0004;                            // 8) enable SS2 interrupts
+  Continuous = true;
+  NVIC_EN0_R = ADC0SS2_NVIC_BIT;                  // 9) and in the NVIC
+  ADC0_ACTSS_R |= 0x0004;                         // 10) enable sample sequencer 2
+  TIMER4_CTL_R |= TIMER_CTL_TAOTE | TIMER_CTL_TAEN; // 11) trigger the ADC & go
+}
+
+/****************************************************************************
+ Function
+    ADC_MultiLatest
+
+ Parameters
+    uint32_t data[4] pointer to the first element of an array to hold results
+
+ Returns
+    uint32_t : the number of the set of results copied, counting from 1.
+    0 if there have been no conversions yet, data is left alone then
+
+ Description
+    copies the latest complete set of results from continuous sampling,
+    without waiting. Lowest numbered converted channel is in data[0].
+    Compare the returned number with the last one to tell whether there
+    is a new set
+
+ Notes
+    if the ISR laps the copy (only possible if this is interrupted for a
+    whole sample period) the copy is done again, so the channels in data
+    always come from the same conversion
+
+ Author
+    10/17/26
+****************************************************************************/
+uint32_t ADC_MultiLatest(uint32_t data[4])
+{
+  uint32_t  Count;
+  uint8_t   i;
+
+  do
+  {
+    Count = SampleCount;
+    if (Count == 0)
+    {
+      return 0;
+    }
+    for (i = 0; i < NumChannelsConverting; i++)
+    {
+      data[i] = Snapshots[Count & 1][i];
+    }
+  } while ((SampleCount - Count) >= 2);
+  return Count;
+}
+
+/****************************************************************************
+ Function
+    ADC_MultiISR
+
+ Parameters
+    none
+
+ Returns
+    nothing
+
+ Description
+    ADC0 sequence 2 interrupt response, stores the results of the conversion
+    that the timer just triggered in the free buffer and then makes it the
+    latest
+
+ Notes
+
+ Author
+    10/17/26
+****************************************************************************/
+void ADC_MultiISR(void)
+{
+  uint32_t  Next = (SampleCount + 1) & 1;
+  uint8_t   i;
+
+  ADC0_ISC_R = 0x0004;                // acknowledge completion, clear int
+  for (i = 0; i < NumChannelsConverting; i++)
+  {
+    Snapshots[Next][i] = ADC0_SSFIFO2_R & 0xFFF;
+  }
+  SampleCount++;                      // publish it
+}
+
+#ifdef ES_PORT_POSIX
+/*
+  The fake converter. Conversions are started by a write to PSSI (noticed
+  when RIS is read) or by ADC_MultiFakeTimerTimeout when the registers are
+  set up for timer triggering. A conversion reads the inputs named in
+  SSMUX2 up to the END bit in SSCTL2 into the FIFO, sets RIS and, if the
+  interrupt is enabled in IM & the NVIC, calls ADC_MultiISR from the
+  caller's context. ISC is applied (write 1 to clear) before RIS is read
+  or set.
+*/
+static uint32_t FakeInputs[12];
+static uint32_t FakeFIFO[8];
+static uint8_t  FakeFIFOFirst;
+static uint8_t  FakeFIFOCount;
+
+static void FakeConvert(void)
+{
+  uint8_t i;
+  uint8_t Channel;
+
+  for (i = 0; i < 4; i++)
+  {
+    Channel = (Fake.SSMUX2 >> (4 * i)) & 0x0F;
+    if (FakeFIFOCount < 4)   // the SS2 FIFO is 4 deep
+    {
+      FakeFIFO[(FakeFIFOFirst + FakeFIFOCount) & 7] =
+          (Channel < 12) ? FakeInputs[Channel] : 0;
+      FakeFIFOCount++;
+    }
+    if (Fake.SSCTL2 & (ADC_SSCTL2_END0 << (4 * i)))
+    {
+      break;
+    }
+  }
+  Fake.RIS = (Fake.RIS & ~Fake.ISC) | 0x0004;
+  Fake.ISC = 0;
+  if ((Fake.IM & 0x0004) && (Fake.NVIC_EN0 & ADC0SS2_NVIC_BIT))
+  {
+    ADC_MultiISR();
+  }
+}
+
+static uint32_t FakeReadRIS(void)
+{
+  Fake.RIS &= ~Fake.ISC;
+  Fake.ISC = 0;
+  if ((Fake.PSSI & 0x0004) && (Fake.ACTSS & 0x0004))
+  {
+    Fake.PSSI = 0;
+    FakeConvert();
+  }
+  return Fake.RIS;
+}
+
+static uint32_t FakePopFIFO(void)
+{
+  uint32_t Value = 0;
+
+  if (FakeFIFOCount > 0)
+  {
+    Value = FakeFIFO[FakeFIFOFirst];
+    FakeFIFOFirst = (FakeFIFOFirst + 1) & 7;
+    FakeFIFOCount--;
+  }
+  return Value;
+}
+
+/****************************************************************************
+ Function
+    ADC_MultiFakeSetInput
+
+ Parameters
+    uint8_t : the analog input, AIN0-11 (PE0 is AIN3, PE3 is AIN0)
+    uint32_t : the count that the fake converter will read for it
+
+ Returns
+    nothing
+
+ Description
+    host only, sets what the next conversions will read
+
+ Notes
+
+ Author
+    10/17/26
+****************************************************************************/
+void ADC_MultiFakeSetInput(uint8_t Channel, uint32_t Counts)
+{
+  if (Channel < 12)
+  {
+    FakeInputs[Channel] = Counts & 0xFFF;
+  }
+}
+
+/****************************************************************************
+ Function
+    ADC_MultiFakeTimerTimeout
+
+ Parameters
+    none
+
+ Returns
+    nothing
+
+ Description
+    host only, plays the part of Timer 4A timing out: if it is running with
+    its ADC trigger on and sequence 2 is enabled for timer triggering, a
+    conversion is done, which calls ADC_MultiISR if its interrupt is on
+
+ Notes
+    call it from whatever is standing in for interrupt context
+
+ Author
+    10/17/26
+****************************************************************************/
+void ADC_MultiFakeTimerTimeout(void)
+{
+  if (((Fake.T4_CTL & (TIMER_CTL_TAEN | TIMER_CTL_TAOTE)) ==
+      (TIMER_CTL_TAEN | TIMER_CTL_TAOTE)) &&
+      ((Fake.EMUX & ADC_EMUX_EM2_M) == ADC_EMUX_EM2_TIMER) &&
+      (Fake.ACTSS & 0x0004))
+  {
+    FakeConvert();
+  }
+}
+#endif
+
+#if defined(TEST) && defined(ES_PORT_POSIX)
+/*
+  Host test against the fake registers. Checks one software triggered
+  read, then starts continuous sampling with a second thread playing the
+  timer & ISR, writing the sample number to every input before each
+  conversion, while main reads with ADC_MultiLatest and checks that every
+  set it gets comes from a single conversion and that the numbers never
+  go backwards. Build with:
+  gcc -O2 -DTEST -DES_PORT_POSIX -IHeaders Source/ADMulti.c -lpthread
+*/
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define NUM_TEST_SAMPLES 2000000UL
+
+static void *TimerThread(void *pArg)
+{
+  uint32_t Sample;
+  uint8_t  Channel;
+  (void)pArg;
+
+  for (Sample = 1; Sample <= NUM_TEST_SAMPLES; Sample++)
+  {
+    for (Channel = 0; Channel < 4; Channel++)
+    {
+      ADC_MultiFakeSetInput(Channel, Sample);
+    }
+    ADC_MultiFakeTimerTimeout();
+    if ((Sample & 0xFF) == 0)
+    {
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+int main(void)
+{
+  pthread_t Timer;
+  uint32_t  Data[4];
+  uint32_t  Count;
+  uint32_t  LastCount = 0;
+  uint32_t  Reads = 0;
+  uint32_t  Errors = 0;
+  uint8_t   i;
+
+  ADC_MultiInit(4);
+  for (i = 0; i < 4; i++)
+  {
+    ADC_MultiFakeSetInput(i, 100 + i);
+  }
+  ADC_MultiRead(Data);
+  // PE0 (AIN3) is data[0]
+  if ((Data[0] != 103) || (Data[1] != 102) || (Data[2] != 101) ||
+      (Data[3] != 100))
+  {
+    printf("software trigger read %u %u %u %u\n", Data[0], Data[1],
+        Data[2], Data[3]);
+    Errors++;
+  }
+
+  ADC_MultiStartContinuous(100);
+  pthread_create(&Timer, NULL, TimerThread, NULL);
+  while (LastCount < NUM_TEST_SAMPLES)
+  {
+    Count = ADC_MultiLatest(Data);
+    if (Count == 0)
+    {
+      continue;
+    }
+    Reads++;
+    if ((Count < LastCount) || (Data[0] != (Count & 0xFFF)) ||
+        (Data[1] != Data[0]) || (Data[2] != Data[0]) || (Data[3] != Data[0]))
+    {
+      Errors++;
+    }
+    LastCount = Count;
+  }
+  pthread_join(Timer, NULL);
+  printf("%lu samples, %u reads, %u errors\n", NUM_TEST_SAMPLES, Reads,
+      Errors);
+  return Errors != 0;
+}
+#endif
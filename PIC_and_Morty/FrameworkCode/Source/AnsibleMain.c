@@ -52,6 +52,7 @@ first pass   Sai Koppaka 5/13/18
 
 #include "AnsibleMain.h"
 #include "AnsibleTransmit.h"
+#include "XBeeCodec.h"
 
 /*----------------------------- Module Defines ----------------------------*/
 #define BitsPerNibble 4
@@ -60,16 +61,56 @@ first pass   Sai Koppaka 5/13/18
 #define ATTEMPT_TIME              200     //200ms
 #define PAIRING_TIME            3000      //1 sec time 
 
-//Defines for Class Packets 
-#define REQ_2_PAIR              0x01
-#define CTRL                    0x03 
-#define PAIR_ACK                0x02
-#define STATUS                  0x04
+// CTRL scheduling while paired. A move past the deadband goes out on the
+// sensor update that sees it, but no sooner than CTRL_MIN_GAP after the last
+// CTRL: a CTRL is 15 bytes and the TX status and STATUS back another 19, so
+// at 9600 baud more would only queue up. With nothing moving a keep-alive
+// CTRL goes every KEEPALIVE_TIME, so that a SHIP, whose PAIR_TIMEOUT_TIME
+// is also 3 sec, and this end both see two lost before giving up. A CTRL
+// with no STATUS back after ATTEMPT_TIME is sent again, so a poor link gets
+// the old 5 Hz
+#define CTRL_MIN_GAP              50      //ms
+#define KEEPALIVE_TIME          1000      //ms
+#define STICK_DEADBAND             2      //counts, out of 255
+
+#if (3 * KEEPALIVE_TIME) > PAIRING_TIME
+#error "KEEPALIVE_TIME must allow 3 tries inside PAIRING_TIME"
+#endif
+#if (ATTEMPT_TIME >= KEEPALIVE_TIME) || (CTRL_MIN_GAP >= ATTEMPT_TIME)
+#error "need CTRL_MIN_GAP < ATTEMPT_TIME < KEEPALIVE_TIME"
+#endif
+
+// for the airtime estimate: an API frame is the RF data plus 9 bytes, 10
+// bits a byte at 9600 baud on the UART. Over the air it is 32uS a byte, with
+// 17 bytes of PHY & MAC overhead and an 11 byte ACK
+#define API_FRAME_OVERHEAD         9
+#define UART_US_PER_BYTE        1042
+#define AIR_US_PER_BYTE           32
+#define AIR_OVERHEAD_BYTES        17
+#define AIR_ACK_BYTES             11
+
+
+/*---------------------------- Module Types -------------------------------*/
+// the controls as they went out in the last CTRL
+typedef struct
+{
+  uint8_t Throttle;
+  uint8_t Steering;
+  uint8_t Yaw;
+  uint8_t Pitch;
+  uint8_t Control;
+} Controls_t;
 
 /*---------------------------- Module Functions ---------------------------*/
 /* prototypes for private functions for this machine.They should be functions
    relevant to the behavior of this state machine
 */
+static void ReadControls(Controls_t *pControls);
+static bool PastDeadband(uint8_t Now, uint8_t Sent);
+static bool ControlsMoved(void);
+static void ControlsUpdated(void);
+static void SendControls(void);
+static void StatusReceived(void);
 
 /*---------------------------- Module Variables ---------------------------*/
 // everybody needs a state variable, you may need others as well.
@@ -84,6 +125,15 @@ static uint8_t currentBoat = 6;
 // with the introduction of Gen2, we need a module level Priority var as well
 static uint8_t MyPriority;
 
+// CTRL scheduling
+static Controls_t LastSent;
+static uint16_t LastSendTime;
+static bool MovePending;        // a move is waiting for CTRL_MIN_GAP
+static uint16_t MoveTime;       // when the oldest unsent move was seen
+static bool StatusOwed;         // a CTRL has gone with no STATUS back yet
+static bool TimingRoundTrip;    // and it was the only one, so it is timed
+static AnsibleCtrlStats_t Stats;
+
 //public getter function
 uint8_t DestAddressMSB(void); 
 uint8_t DestAddressLSB(void); 
@@ -200,7 +250,7 @@ ES_Event_t RunAnsibleMainSM(ES_Event_t ThisEvent)
             //set ship address (**getter function that determines ship destination address and sends dest address to ansibletx)  
             //send packet to SHIP (0x01)
              ThisEvent.EventType = ES_BEGIN_TX;
-             ThisEvent.EventParam = REQ_2_PAIR; //CTRL;//REQ_2_PAIR; //// REQ_2_PAIR;
+             ThisEvent.EventParam = XBEE_REQ_2_PAIR;
              PostAnsibleTX(ThisEvent); 
               
              // currentBoat = getBoatNumber(); 
@@ -234,7 +284,7 @@ ES_Event_t RunAnsibleMainSM(ES_Event_t ThisEvent)
               NextState = WaitingForPairResp; 
             //send packet to SHIP (0x01)
              ThisEvent.EventType = ES_BEGIN_TX;
-             ThisEvent.EventParam = REQ_2_PAIR;
+             ThisEvent.EventParam = XBEE_REQ_2_PAIR;
              PostAnsibleTX(ThisEvent); 
           //   printf("\n \r es_begin_tX");
           }
@@ -254,12 +304,11 @@ ES_Event_t RunAnsibleMainSM(ES_Event_t ThisEvent)
           pair_var = true; 
           //Start Pairing Timer (1sec)
           ES_Timer_InitTimer (PAIR_TIMEOUT_TIMER,PAIRING_TIME); //reset timer
-          //Start Attempt Timer (200ms)
-          ES_Timer_InitTimer (PAIR_ATTEMPT_TIMER,ATTEMPT_TIME); //reset timer 
-          
-              ThisEvent.EventType = ES_BEGIN_TX;
-             ThisEvent.EventParam = CTRL; //add cntrl data
-             PostAnsibleTX(ThisEvent); 
+          //send the first CTRL, SendControls keeps PAIR_ATTEMPT_TIMER
+          MovePending = false;
+          StatusOwed = false;
+          LastSendTime = ES_Timer_GetTime();
+          SendControls(); 
           
           NextState = CommunicatingSHIP;  //Decide what the next state will be
         }
@@ -276,7 +325,7 @@ ES_Event_t RunAnsibleMainSM(ES_Event_t ThisEvent)
         {  
            //send packet to SHIP (0x01)
              ThisEvent.EventType = ES_BEGIN_TX;
-             ThisEvent.EventParam = REQ_2_PAIR;
+             ThisEvent.EventParam = XBEE_REQ_2_PAIR;
              PostAnsibleTX(ThisEvent);  
           //start 200ms timer
            ES_Timer_InitTimer (PAIR_ATTEMPT_TIMER,ATTEMPT_TIME); //reset 200 timer 
@@ -292,15 +341,9 @@ ES_Event_t RunAnsibleMainSM(ES_Event_t ThisEvent)
         {  
           if (ThisEvent.EventParam == PAIR_ATTEMPT_TIMER)
           {
-          // printf("\r\n ATTEMPT timeout"); 
-             //send CNTRL packet to SHIP 
-             ThisEvent.EventType = ES_BEGIN_TX;
-             ThisEvent.EventParam = CTRL; //add cntrl data
-             PostAnsibleTX(ThisEvent); 
-         //    printf("\n \r timed out pair attempt"); 
-           
-            //reset PAIR_ATTEMPT_TIMER
-            ES_Timer_InitTimer (PAIR_ATTEMPT_TIMER,ATTEMPT_TIME); //reset 200 timer
+            //a move held back for CTRL_MIN_GAP, no STATUS back or a
+            //keep-alive
+            SendControls(); 
             NextState = CommunicatingSHIP;  //Decide what the next state will be
           } 
           else if (ThisEvent.EventParam == PAIR_TIMEOUT_TIMER)
@@ -323,9 +366,16 @@ ES_Event_t RunAnsibleMainSM(ES_Event_t ThisEvent)
         {  
             //reset PAIR_TIMEOUT_TIMER
             ES_Timer_InitTimer (PAIR_TIMEOUT_TIMER,PAIRING_TIME); //reset timer 
+            StatusReceived();
             NextState = CommunicatingSHIP;  //Decide what the next state will be
         }
         break;
+        
+        case ES_CONTROLS_UPDATED:  //new sensor readings
+        {
+            ControlsUpdated();
+        }
+        break;
         default: 
             printf("\n \r problem"); 
       }
@@ -365,9 +415,232 @@ uint8_t getCurrentBoat( void )
 {
     return currentBoat; 
 }
+
+/****************************************************************************
+ Function
+     QueryCtrlStats
+
+ Parameters
+     None
+
+ Returns
+     AnsibleCtrlStats_t const *, the CTRL scheduling counts
+
+ Description
+     for working out how much of the link the CTRLs use, and how long a
+     move of the controls takes to get to the SHIP
+ Notes
+     the counts are only changed by RunAnsibleMainSM, so read them from
+     the main loop
+****************************************************************************/
+AnsibleCtrlStats_t const *QueryCtrlStats(void)
+{
+  return &Stats;
+}
+
+/****************************************************************************
+ Function
+     PrintCtrlStats
+
+ Parameters
+     None
+
+ Returns
+     None
+
+ Description
+     prints the CTRL counts, the UART and air time they took and the
+     latencies on the console. A move gets to the SHIP within its move to
+     CTRL time plus the CTRL to STATUS time, the SHIP acts on a CTRL before
+     it sends the STATUS
+ Notes
+     uses printf, so only call it from the main loop
+****************************************************************************/
+void PrintCtrlStats(void)
+{
+  uint32_t NumSent = Stats.MoveSends + Stats.Resends + Stats.KeepAlives;
+  uint32_t RFBytes = 1 + XBeeCodec_PayloadLength(XBEE_CTRL);
+  uint32_t UARTms = (NumSent * (RFBytes + API_FRAME_OVERHEAD) *
+      UART_US_PER_BYTE) / 1000;
+  uint32_t Airms = (NumSent * (RFBytes + AIR_OVERHEAD_BYTES + AIR_ACK_BYTES) *
+      AIR_US_PER_BYTE) / 1000;
+
+  printf("CTRL Moves Defer  Sent Resent Keep-alive Suppressed  Paired mS"
+      "   UART mS    Air mS\r\n");
+  printf("%10lu %5lu %5lu %6lu %10lu %10lu %10lu %9lu %9lu\r\n",
+      (unsigned long)Stats.Moves, (unsigned long)Stats.Deferred,
+      (unsigned long)Stats.MoveSends, (unsigned long)Stats.Resends,
+      (unsigned long)Stats.KeepAlives, (unsigned long)Stats.Suppressed,
+      (unsigned long)Stats.PairedMs, (unsigned long)UARTms,
+      (unsigned long)Airms);
+  printf("mS   Move to CTRL mean/max   CTRL to STATUS mean/max   timed\r\n");
+  printf("%14lu %5lu %19lu %5lu %7lu\r\n",
+      (unsigned long)((Stats.MoveSends != 0) ?
+      Stats.MoveLatencyTotal / Stats.MoveSends : 0),
+      (unsigned long)Stats.MoveLatencyMax,
+      (unsigned long)((Stats.RoundTrips != 0) ?
+      Stats.RoundTripTotal / Stats.RoundTrips : 0),
+      (unsigned long)Stats.RoundTripMax, (unsigned long)Stats.RoundTrips);
+}
+
 /***************************************************************************
  private functions
  ***************************************************************************/
+/****************************************************************************
+ Function
+     ReadControls
+
+ Description
+     the controls as AnsibleTransmit puts them in a CTRL
+****************************************************************************/
+static void ReadControls(Controls_t *pControls)
+{
+  pControls->Throttle = getThrottle();
+  pControls->Steering = getSteering();
+  pControls->Yaw = getYaw();
+  pControls->Pitch = getPitch();
+  pControls->Control = getControl();
+}
+
+static bool PastDeadband(uint8_t Now, uint8_t Sent)
+{
+  return (Now > Sent) ? ((Now - Sent) > STICK_DEADBAND) :
+                        ((Sent - Now) > STICK_DEADBAND);
+}
+
+/****************************************************************************
+ Function
+     ControlsMoved
+
+ Description
+     true if a stick has moved past the deadband, or a button has changed,
+     since the last CTRL
+****************************************************************************/
+static bool ControlsMoved(void)
+{
+  Controls_t Now;
+
+  ReadControls(&Now);
+  return PastDeadband(Now.Throttle, LastSent.Throttle) ||
+         PastDeadband(Now.Steering, LastSent.Steering) ||
+         PastDeadband(Now.Yaw, LastSent.Yaw) ||
+         PastDeadband(Now.Pitch, LastSent.Pitch) ||
+         (Now.Control != LastSent.Control);
+}
+
+/****************************************************************************
+ Function
+     ControlsUpdated
+
+ Description
+     on each sensor update while paired: sends a CTRL now for a move, or as
+     soon as CTRL_MIN_GAP is up, and drops the update if nothing has moved
+****************************************************************************/
+static void ControlsUpdated(void)
+{
+  uint16_t SinceLast;
+
+  if (MovePending)
+  {
+    return;     // the CTRL that is waiting will take the latest readings
+  }
+  if (ControlsMoved() == false)
+  {
+    Stats.Suppressed++;
+    return;
+  }
+  Stats.Moves++;
+  MovePending = true;
+  MoveTime = ES_Timer_GetTime();
+  SinceLast = MoveTime - LastSendTime;
+  if (SinceLast >= CTRL_MIN_GAP)
+  {
+    SendControls();
+  }
+  else
+  {
+    Stats.Deferred++;
+    ES_Timer_InitTimer(PAIR_ATTEMPT_TIMER, CTRL_MIN_GAP - SinceLast);
+  }
+}
+
+/****************************************************************************
+ Function
+     SendControls
+
+ Description
+     has AnsibleTransmit send a CTRL and gives the SHIP ATTEMPT_TIME to
+     answer it
+****************************************************************************/
+static void SendControls(void)
+{
+  ES_Event_t TXEvent;
+  uint16_t Now = ES_Timer_GetTime();
+  uint16_t SinceLast = Now - LastSendTime;   // across a timer wrap too
+  uint16_t Latency;
+
+  ReadControls(&LastSent);
+  Stats.PairedMs += SinceLast;
+  LastSendTime = Now;
+  if (MovePending)
+  {
+    Latency = Now - MoveTime;
+    Stats.MoveSends++;
+    Stats.MoveLatencyTotal += Latency;
+    if (Latency > Stats.MoveLatencyMax)
+    {
+      Stats.MoveLatencyMax = Latency;
+    }
+    MovePending = false;
+  }
+  else if (StatusOwed == true)
+  {
+    Stats.Resends++;
+  }
+  else
+  {
+    Stats.KeepAlives++;
+  }
+  // the STATUS has nothing to match it to its CTRL, so only time a CTRL
+  // when there are no others waiting for one
+  TimingRoundTrip = (StatusOwed == false);
+  StatusOwed = true;
+
+  TXEvent.EventType = ES_BEGIN_TX;
+  TXEvent.EventParam = XBEE_CTRL;
+  PostAnsibleTX(TXEvent);
+  ES_Timer_InitTimer(PAIR_ATTEMPT_TIMER, ATTEMPT_TIME);
+}
+
+/****************************************************************************
+ Function
+     StatusReceived
+
+ Description
+     times the round trip of the CTRL the STATUS answers, if it can, and
+     puts the next CTRL off to the keep-alive, unless a move is waiting
+****************************************************************************/
+static void StatusReceived(void)
+{
+  uint16_t RoundTrip = ES_Timer_GetTime() - LastSendTime;
+
+  if ((MovePending == false) && (RoundTrip < KEEPALIVE_TIME))
+  {
+    ES_Timer_InitTimer(PAIR_ATTEMPT_TIMER, KEEPALIVE_TIME - RoundTrip);
+  }
+
+  if (TimingRoundTrip == true)
+  {
+    Stats.RoundTrips++;
+    Stats.RoundTripTotal += RoundTrip;
+    if (RoundTrip > Stats.RoundTripMax)
+    {
+      Stats.RoundTripMax = RoundTrip;
+    }
+  }
+  StatusOwed = false;
+  TimingRoundTrip = false;
+}
 
 
 
@@ -45,60 +45,41 @@
 #include "AnsibleTransmit.h"
 #include "AnsibleReceive.h"
 #include "AnsibleMain.h"
+#include "XBeeFrame.h"
+#include "XBeeCodec.h"
 
 /*----------------------------- Module Defines ----------------------------*/
-#define RX_TIME 2000 //sending bits at 500ms time interval 
+#define RX_TIME 2000 //longest gap between the bytes of a frame, in ms
 #define BitsPerNibble 4
 #define UART5_RX_PIN GPIO_PIN_4 //Port E4
 #define UART5_TX_PIN GPIO_PIN_5 //Port E5
-#define FUEL_IDX            6       // byte position in packet 
-
-//Defines for XBee
-#define Start_Delimiter 0x7E
-#define API_Identifier 0x81
-#define Options 0x00 //ack enabled 
-
-//Defines for Class Packets 
-#define BLUE 0x00
-#define RED 0x01
-#define REQ_2_PAIR 0x01
-#define CTRL 0x03 
-#define PAIR_ACK 0x02
-#define STATUS 0x04
-
-//TX Bytes
-#define TX_Status_IDX 0 
-#define TX_Success  1
-#define TX_Bad      2
-
-//Bit Positions
-#define API_Identifier_Index 0
-#define API_PACKET_HEADER 5 //first bit of RF data is packet type
 
 /*---------------------------- Module Functions ---------------------------*/
 /* prototypes for private functions for this machine.They should be functions
    relevant to the behavior of this state machine
 */
+static void HandleFrame(ES_Event_t ThisEvent);
 
 
 /*---------------------------- Module Variables ---------------------------*/
-// everybody needs a state variable, you may need others as well.
-// type of state variable should match htat of enum in header file
-static AnsibleRXState_t CurrentState;
+// the machine, one line per transition, tried in order. The frames are
+// taken apart in the UART interrupt, so all that is left here is one event
+// per good frame
+#define ANSIBLE_RX_TRANSITIONS(ES_FSM_TRANSITION) \
+  ES_FSM_TRANSITION(WaitingForFrame, FRAME_RECEIVED, ES_FSM_ANY_PARAM, NULL, \
+    HandleFrame, ES_FSM_SAME_STATE) \
+  ES_FSM_TRANSITION(WaitingForFrame, ES_INIT, ES_FSM_ANY_PARAM, NULL, \
+    NULL, ES_FSM_SAME_STATE)
+
+ES_FSM_DEFINE(AnsibleRXFsm, ANSIBLE_RX_STATES, ANSIBLE_RX_TRANSITIONS,
+    WaitingForFrame, NULL);
 //static PacketType_t  PacketType; 
 
-//Variables for XBee API RX 
-static uint16_t index = 0; 
+// the XBee API frame parser for UART5, set up here so that it is ready for
+// bytes before InitAnsibleRX runs
+static XBeeFrameParser_t Parser = XBEE_FRAME_PARSER(PostAnsibleRX, RX_TIME);
 
-static uint16_t Data_Length;  //number of bytes (**arbitrarily set") 
-static uint8_t Computed_CheckSum; //initialize check sum to 0xFF
 static uint8_t fuelStatus = 0; 
-static uint8_t Sum; 
-
-//static bool receiving; 
-
-//Arrays
-uint8_t RXData_Packet[100]; //***setting initial large value of array*** needs change
 
 // with the introduction of Gen2, we need a module level Priority var as well
 static uint8_t MyPriority;
@@ -128,7 +109,10 @@ bool InitAnsibleRX(uint8_t Priority)
 
   MyPriority = Priority;
   // put us into the Initial state
-    CurrentState = WaitingForStart;  
+  if (ES_Fsm_Init(&AnsibleRXFsm) != true)
+  {
+    return false;
+  }
   
   // post the initial transition event
     ThisEvent.EventType = ES_INIT;
@@ -167,7 +151,7 @@ bool PostAnsibleRX(ES_Event_t ThisEvent)
 
 /****************************************************************************
  Function
-    RunTemplateFSM
+    RunAnsibleRXSM
 
  Parameters
    ES_Event : the event to process
@@ -176,172 +160,16 @@ bool PostAnsibleRX(ES_Event_t ThisEvent)
    ES_Event, ES_NO_EVENT if no error ES_ERROR otherwise
 
  Description
-   add your description here
+   handles the good XBee API frames from the UART interrupt
  Notes
-   uses nested switch/case to implement the machine.
+   the machine is the ANSIBLE_RX_TRANSITIONS table, events that no line
+   takes are ignored
  Author
     s k first pass
 ****************************************************************************/
 ES_Event_t RunAnsibleRXSM(ES_Event_t ThisEvent)
 {
-  ES_Event_t ReturnEvent;
-  ReturnEvent.EventType = ES_NO_EVENT; // assume no errors
-  
-
-    switch (CurrentState)
-    {
-        case WaitingForStart:        // If current state is initial Psedudo State
-        {
-            //Set the initial state      
-         
-            if((ThisEvent.EventType == BYTE_RECEIVED) && (ThisEvent.EventParam == Start_Delimiter))
-            {
-                // printf("\r \n Start_Delimiter %X", ThisEvent.EventParam);
-                //Enable Timer 
-                ES_Timer_InitTimer (RX_ATTEMPT_TIMER,RX_TIME); 
-    
-                //Initialize DataLength to 0
-                Data_Length = 0; 
-                CurrentState = WaitingForMSBLen;
-            }
-        }
-        break;
-
-        case WaitingForMSBLen:        // If current state is state one
-        {
-            if((ThisEvent.EventType == ES_TIMEOUT) && (ThisEvent.EventParam == RX_ATTEMPT_TIMER)) //ES_BEGIN_TX:  //If event is event one
-            {  
-                //Go back to Waiting For Start
-                CurrentState = WaitingForStart;
-            }
-            else if (ThisEvent.EventType == BYTE_RECEIVED)  //0x7E received in time 
-            {     
-                // printf("\r \n Arbitrary_MSB %X", ThisEvent.EventParam);
-                //Reset timer 
-                ES_Timer_InitTimer (RX_ATTEMPT_TIMER,RX_TIME); 
-          
-                //Record length of MSB (second byte) 
-                Data_Length |= (ThisEvent.EventParam <<8); //byte is length of msb
-                //  printf("\n \r DataLengthMSB = %x", ThisEvent.EventParam<<8);  
-          
-               //set next state to WaitingforLSB  
-                CurrentState = WaitingForLSBLen;            
-            } 
-        }        
-        break;
-
-        case WaitingForLSBLen:        // If current state is state one
-        {
-            if((ThisEvent.EventType == ES_TIMEOUT) && (ThisEvent.EventParam == RX_ATTEMPT_TIMER)) //ES_BEGIN_TX:  //If event is event one
-            {  
-                //Go back to Waiting For Start
-                CurrentState = WaitingForStart;
-            }
-            else if (ThisEvent.EventType == BYTE_RECEIVED)
-            {            
-                // printf("\r \n Arbitary_LSB %X", ThisEvent.EventParam);
-                //Reset timer 
-                ES_Timer_InitTimer (RX_ATTEMPT_TIMER,RX_TIME); 
-          
-                //Record length of LSB 
-                Data_Length |= (ThisEvent.EventParam); //byte is the LSB of length  
-
-                //Set initial variables 
-                Sum = 0; 
-                index = 0;  
-          
-                //set next state to ReceivingData  
-                CurrentState = ReceivingData; 
-            } 
-        }        
-        break;
-     
-     
-        case ReceivingData:        // If current state is state one
-        {
-            if((ThisEvent.EventType == ES_TIMEOUT) && (ThisEvent.EventParam == RX_ATTEMPT_TIMER)) //ES_BEGIN_TX:  //If event is event one
-            {  
-                //Go back to Waiting For Start
-                CurrentState = WaitingForStart;
-            }
-            else if (ThisEvent.EventType == BYTE_RECEIVED)
-            {    
-                //Reset timer 
-                ES_Timer_InitTimer (RX_ATTEMPT_TIMER, RX_TIME); 
-         
-                //API Identifier (0x81), Source Address (0x20 and 0x8_), RSSI, and Options, data   
-                RXData_Packet[index] = ThisEvent.EventParam; //frame data packet
-                
-                //Compute resultant (oxff - sum) 
-                Sum +=ThisEvent.EventParam; 
-          
-                if (index == (Data_Length - 1)) //DataLength)
-                {
-                    //set next state to WaitingforLSB  
-                    CurrentState = ReceivingCheckSum; 
-                }
-                index++; //increment the index by the size of the data packet
-            } 
-        }        
-        break;
-     
-        case ReceivingCheckSum:        // If current state is state one
-        {
-            CurrentState = WaitingForStart; //Go back to waiting  
-
-            if (ThisEvent.EventType == BYTE_RECEIVED)
-            {
-               Computed_CheckSum = 0xFF - Sum; 
-          
-
-                if (ThisEvent.EventParam  == Computed_CheckSum) // process data only for good check sum
-                {
-                    //Loook at the aPI_ID to see that it was indeed for transmit
-                    if (RXData_Packet[API_Identifier_Index] == API_Identifier)
-                    {
-                        //if there was a ACK  
-                        if(RXData_Packet[API_PACKET_HEADER] == PAIR_ACK)
-                        {
-                            ThisEvent.EventType = ES_CONNECTIONEST; 
-                            PostAnsibleMain(ThisEvent); //post the Connection is established
-                            //ProcessData(); 
-                        }
-                        else if(RXData_Packet[API_PACKET_HEADER] == STATUS)
-                        {
-                            //call different functions to deal with this    
-                            fuelStatus = RXData_Packet[FUEL_IDX]; 
-                            ES_Event_t PostByte;
-                            PostByte.EventType = STATUS_RX; // assume no errors
-                            PostAnsibleMain(PostByte);
-  
-                        }
-                        else
-                        {
-                            //Send a fail message
-                            //ThisEvent.EventType == ES_TX_FAIL; //the transmit from SHIP-> ANSIBLE failed
-                            //PostAnsibleMaster(ThisEvent); 
-                            CurrentState = WaitingForStart; //Go back to waiting 
-                        }
-                    }
-                }
-                else        // check sum did not match
-                {
-                    //Send a fail message
-                    //ThisEvent.EventType == ES_TX_FAIL; //the transmit from SHIP-> ANSIBLE failed
-                    //PostAnsibleMaster(ThisEvent); 
-                    //CurrentState = WaitingForStart; //Go back to waiting   
-                }
-            }
-            else        // if this event is NOT of type Byte Received 
-            {
-            }   
-        } // end case byte received 
-        break;    
-        
-        default:
-             printf("\r\nBug in state machine of ansible recevice"); 
-  } // end switch on Current State
-  return ReturnEvent;
+  return ES_Fsm_Dispatch(&AnsibleRXFsm, ThisEvent);
 }
 
 /****************************************************************************
@@ -363,7 +191,7 @@ ES_Event_t RunAnsibleRXSM(ES_Event_t ThisEvent)
 ****************************************************************************/
 AnsibleRXState_t QueryAnsibleRX(void)
 {
-  return CurrentState;
+  return (AnsibleRXState_t)ES_Fsm_Query(&AnsibleRXFsm);
 }
 
 /***************************************************************************
@@ -380,8 +208,69 @@ uint8_t getFuelStatus ( void )
   
  return fuelOut; 
 }
+
+/****************************************************************************
+ Function
+    AnsibleRXByte
+
+ Parameters
+   uint8_t : a byte from the XBee
+
+ Returns
+   nothing
+
+ Description
+   hands a received byte to the frame parser, which posts FRAME_RECEIVED
+   to this service when it completes a good frame
+ Notes
+   called from AnsibleTXRXISR for each byte in the receive FIFO
+ Author
+   10/18/26
+****************************************************************************/
+void AnsibleRXByte(uint8_t Byte)
+{
+  XBeeFrame_ParseByte(&Parser, Byte);
+}
 ///PUBLIC FUNCTIONS//
  /***************************************************************************
  private functions
  ***************************************************************************/
-  
+
+/****************************************************************************
+ Function
+    HandleFrame
+
+ Parameters
+   ES_Event_t : the FRAME_RECEIVED event, its EventParam is the pool handle
+   of the frame data
+
+ Description
+   if the frame is a packet from a SHIP, tells AnsibleMain about a pair
+   acknowledge or a status packet
+ Notes
+   the framework frees the block after this returns
+****************************************************************************/
+static void HandleFrame(ES_Event_t ThisEvent)
+{
+  XBeePacket_t  RXPacket;
+  ES_Event_t    PostEvent;
+
+  if ((XBeeCodec_Decode(ES_Pool_GetPtr(ThisEvent.EventParam),
+      ES_Pool_GetLength(ThisEvent.EventParam), &RXPacket) != true) ||
+      (RXPacket.Api != XBEE_RX_PACKET))
+  {
+    return;     // process received data only
+  }
+  PostEvent.EventParam = 0;
+  if (RXPacket.Message == XBEE_PAIR_ACK)
+  {
+    PostEvent.EventType = ES_CONNECTIONEST;
+    PostAnsibleMain(PostEvent); //post the Connection is established
+  }
+  else if (RXPacket.Message == XBEE_STATUS)
+  {
+    fuelStatus = RXPacket.Payload[XBEE_STATUS_FUEL];
+    PostEvent.EventType = STATUS_RX;
+    PostAnsibleMain(PostEvent);
+  }
+}
@@ -47,6 +47,7 @@
 #include "AnsibleMain.h"
 #include "AnsibleReceive.h"
 #include "SensorUpdate.h"
+#include "XBeeCodec.h"
 
 /*----------------------------- Module Defines ----------------------------*/
 #define TX_TIME 500 //sending bits at 500ms time interval 
@@ -56,16 +57,8 @@
 #define TEAM_PIN      BIT6HI    // Port C 
 
 //Defines for XBee
-#define Start_Delimiter 0x7E
-#define API_Identifier 0x01
-#define Options 0x00 //ack enabled 
-#define Preamble_Length_TX 8 //API_ID(1 byte), Frame_ID(1byte), dest_address (2 bytes), options(1byte) 
-
-//Defines for Class Packets 
-#define REQ_2_PAIR 0x01
-#define CTRL 0x03 
-#define PAIR_ACK 0x02
-#define STATUS 0x04
+#define Frame_ID 0x01 //(**arbitrary for the moment)
+#define TX_Options 0x00 //ack enabled 
 
 
 /*---------------------------- Module Functions ---------------------------*/
@@ -73,8 +66,8 @@
    relevant to the behavior of this state machine
 */
 static void BuildTXPacket(uint8_t PacketType); 
-static uint8_t CheckSum(void); 
 static void UARTHardwareInit(void);
+static void FillTXFIFO(void);
 
 /*---------------------------- Module Variables ---------------------------*/
 // everybody needs a state variable, you may need others as well.
@@ -82,16 +75,10 @@ static void UARTHardwareInit(void);
 static AnsibleTXState_t CurrentState;
 //static PacketType_t  PacketType; 
 //static bool Ready2TX = false; 
-static uint8_t BytesRemaining = 0; 
-static uint16_t index = 0; 
 static uint8_t TXPacket_Length; 
-//static uint8_t Preamble_Length = 5;  //API_ID(1 byte), Frame_ID(1byte), dest_address (2 bytes), options(1byte) 
 static uint8_t Packet; 
 
-static uint8_t Data_Length = 2;  //number of bytes (**arbitrarily set") 
-static uint8_t CHK_SUM = 1; //initialize check sum to 0xFF
-static uint8_t DestAddressLSB_val;
-static uint8_t DestAddressMSB_val; 
+static uint16_t DestAddress_val;
 //static bool receiving = false; 
 static uint8_t IDX; 
 static uint8_t TeamColor; 
@@ -99,7 +86,7 @@ static uint8_t TeamColor;
 
 //Arrays
 static uint16_t DestAddress[11];
-static uint8_t Message_Packet[100]; //***setting initial large value of array*** needs change
+static uint8_t Message_Packet[XBEE_MAX_FRAME];
 uint8_t RXMessage_Packet[100]; //not static because I want to access from AnsibleRX 
 
 // with the introduction of Gen2, we need a module level Priority var as well
@@ -263,49 +250,27 @@ ES_Event_t RunAnsibleTXSM(ES_Event_t ThisEvent)
       //   DestAddressMSB_val = 0x20; // = DestAddressMSB(); //= 0x20; 
       // DestAddressLSB_val = 0x86;//DestAddressLSB(); // = 0x86; 
           uint8_t boat_number = getCurrentBoat(); 
-          DestAddressMSB_val = DestAddress[boat_number - 1] >> 8;
-          DestAddressLSB_val = DestAddress[boat_number - 1] & 0x00FF; 
+          DestAddress_val = DestAddress[boat_number - 1];
         
             //Initialize IDX;
              IDX=0; 
           
-            //Set local variable TXPacket_Length
-             TXPacket_Length =  Preamble_Length_TX + Data_Length + CHK_SUM;  
- 
-           //Initialize BytesRemaining = Length of XBee Packet (Preamble (Start + Length + API_ID) + DATA + CHKSUM) 
-              BytesRemaining = TXPacket_Length;  
-                   
-            //set index = 0 
-              index = 0; 
-              
-            //Build the packet to send
+            //Build the packet to send, this sets TXPacket_Length
               Packet= ThisEvent.EventParam;
               BuildTXPacket(Packet);  
              // printf("\n \r PacketTX = %X", ThisEvent.EventParam);
             //Transmiting this packet 
            
-          if((HWREG(UART5_BASE+UART_O_FR)) & ((UART_FR_TXFE)))//If TXFE is set (empty)
+          if((TXPacket_Length != 0) &&
+             !(HWREG(UART5_BASE+UART_O_FR) & UART_FR_TXFF))//If it built and there is room in the TX FIFO
           {
          //   printf("\r\nwriting to DR");
-            //Write the new data to the UARTDR (first byte)
-             HWREG(UART5_BASE+UART_O_DR) = Message_Packet[(IDX)];  
-              //decremet Bytes Remaining 
-                BytesRemaining--;
-              //Increment index 
-                index++; 
-                IDX++; 
+            //Write as much of the packet as the FIFO takes, the TX interrupt
+            //tops it up as it drains
+              FillTXFIFO(); 
             
-//             if((HWREG(UART2_BASE+UART_O_FR)) & ((UART_FR_TXFE))) //if the TXFE is set (still empty)
-//             {
-//               //Write the second byte to the UART DR 
-//             //  printf("\n \r  Message_Packet= %d",  Message_Packet[BytesRemaining]); 
-//             //  printf("\n \r  Bytes_Remaining= %d",  BytesRemaining); 
-//               HWREG(UART2_BASE+UART_O_DR) |= Message_Packet[BytesRemaining-1];  
-//               BytesRemaining--; 
-//               index++; 
-//             }
 //            //Enable TXIM (Note: also enabled in UARTInit)
-               HWREG(UART5_BASE + UART_O_IM) &= ~(UART_IM_RXIM);
+               HWREG(UART5_BASE + UART_O_IM) &= ~(UART_IM_RXIM | UART_IM_RTIM);
                HWREG(UART5_BASE + UART_O_IM) |= (UART_IM_TXIM); 
 
             //Enable Interrupts globally  (also enabled in UARTinit) 
@@ -378,35 +343,23 @@ void AnsibleTXRXISR (void)
 {
   //Read the Masked Interrupt Status (UARTMIS)
   
-  //If TXMIS Is Set 
+  //If TXMIS Is Set, the TX FIFO has drained to 2 bytes
   if ((HWREG(UART5_BASE + UART_O_MIS)) & (UART_MIS_TXMIS)) //if bit is set, then an interrupt has occured
   {
-  //  printf("\r\nISRbitch");
      //clear the source of the interrupt
       HWREG(UART5_BASE+UART_O_ICR) |= UART_ICR_TXIC;
-    //Write the new data to register (UARTDR)
-      HWREG(UART5_BASE+UART_O_DR) = Message_Packet[IDX]; 
-     // printf("\n \r tx = %x", Message_Packet[(IDX)]); 
-      IDX++; 
-      
-  //    printf("\n \r MessagePacket = %i",Message_Packet[BytesRemaining-1]);
     if (IDX == (TXPacket_Length))
     {
-      //clear the source of the interrupt
-        HWREG(UART5_BASE+UART_O_ICR) |= UART_ICR_TXIC;
+      //the whole packet went into the FIFO last time
         HWREG(UART5_BASE + UART_O_IM) &= ~(UART_IM_TXIM); //disable interrupt on TX by clearing TXIM 
-        HWREG(UART5_BASE + UART_O_IM) |= (UART_IM_RXIM); //enable rx
+        HWREG(UART5_BASE + UART_O_IM) |= (UART_IM_RXIM | UART_IM_RTIM); //enable rx
       //Post the ES_TX_COMPLETE (note: TX complete does not mean that that the Packet has been sent) 
       ES_Event_t ReturnEvent; 
       ReturnEvent.EventType = ES_TX_COMPLETE; 
       PostAnsibleTX (ReturnEvent); 
     } else {
-    //decrement BytesRemaining 
-      BytesRemaining--; 
-    //increment index
-      index++;
-    //Set TXIC in UARTICR (clear int)
-    // HWREG(UART2_BASE + UART_O_ICR) |= UART_ICR_TXIC;  //clear TX interrupt
+    //top the FIFO up with the rest of the packet
+      FillTXFIFO(); 
     }
   }
   else
@@ -417,18 +370,19 @@ void AnsibleTXRXISR (void)
   }
   
   
-  //If RXMIS Is Set 
-  if ((HWREG(UART5_BASE + UART_O_MIS)) & (UART_MIS_RXMIS)) //if bit is set, then an interrupt has occured
+  //If RXMIS Is Set (RX FIFO half full) or RTMIS (bytes left in it after a
+  //quiet spell, the end of a frame)
+  if ((HWREG(UART5_BASE + UART_O_MIS)) & (UART_MIS_RXMIS | UART_MIS_RTMIS)) //if bit is set, then an interrupt has occured
   {
        //clear the source of the interrupt
-        HWREG(UART5_BASE+UART_O_ICR) |= UART_ICR_RXIC;
+        HWREG(UART5_BASE+UART_O_ICR) |= (UART_ICR_RXIC | UART_ICR_RTIC);
 //        receiving = true; 
-      //Read the new data  register (UARTDR)
-          ES_Event_t ThisEvent; 
-          ThisEvent.EventType = BYTE_RECEIVED;  
-          ThisEvent.EventParam = HWREG(UART5_BASE+UART_O_DR); 
-          PostAnsibleRX(ThisEvent);
-       //  printf("\n \r RX = %X", ThisEvent.EventParam); 
+      //Read the new data  register (UARTDR) until it is empty, the frame
+      //parser posts FRAME_RECEIVED to AnsibleRX once a frame is complete
+        while (!(HWREG(UART5_BASE + UART_O_FR) & UART_FR_RXFE))
+        {
+          AnsibleRXByte(HWREG(UART5_BASE+UART_O_DR));
+        }
    
   }
   else
@@ -476,7 +430,12 @@ static void UARTHardwareInit(void){
     HWREG(UART5_BASE+UART_O_FBRD) = 0x1B;  
 
   //Write the desired serial parameters to the UARTLCRH registers to set word length to 8
-     HWREG(UART5_BASE + UART_O_LCRH) |= UART_LCRH_WLEN_8;
+  //and turn on the 16 byte FIFOs
+     HWREG(UART5_BASE + UART_O_LCRH) |= (UART_LCRH_WLEN_8 | UART_LCRH_FEN);
+
+  //TX interrupt when the TX FIFO drains to 2 bytes, RX interrupt when the RX
+  //FIFO is half full, the receive time out picks up anything less
+     HWREG(UART5_BASE + UART_O_IFLS) = (UART_IFLS_TX1_8 | UART_IFLS_RX4_8);
 
   //Configure the UART operation using the UARTCTL register 
   //UART Data Registers should be cleared by default (RXE and TXE are already enabled) 
@@ -484,7 +443,7 @@ static void UARTHardwareInit(void){
     HWREG(UART5_BASE + UART_O_CTL) |= ( UART_CTL_RXE |UART_CTL_TXE | UART_CTL_UARTEN);
 
   //Enable UART RX Interrupt (p.924)
-   HWREG(UART5_BASE + UART_O_IM) |= (UART_IM_RXIM | UART_IM_TXIM);
+   HWREG(UART5_BASE + UART_O_IM) |= (UART_IM_RXIM | UART_IM_RTIM | UART_IM_TXIM);
   
   //Enable UART TX Interrupt
    //HWREG(UART2_BASE + UART_O_IM) |= (UART_IM_TXIM); 
@@ -502,166 +461,68 @@ static void UARTHardwareInit(void){
  /***************************************************************************
  private functions
  ***************************************************************************/
-  
-  static void BuildPreamble (void)
+
+/****************************************************************************
+ Function
+    FillTXFIFO
+
+ Description
+   writes the rest of Message_Packet to UART5 until it is all in or the TX
+   FIFO is full, so there is one TX interrupt per 14 bytes, not one per byte
+****************************************************************************/
+static void FillTXFIFO(void)
+{
+  while ((IDX < TXPacket_Length) &&
+      !(HWREG(UART5_BASE + UART_O_FR) & UART_FR_TXFF))
   {
-      Message_Packet[0] = Start_Delimiter;  //0x7E
-     
-      Message_Packet[1] = 0x00; //Data_Length = Preamble_Length + SizeofArray MSB
-     // printf("\n \r %x \n \r", Message_Packet[1]); 
-     
-    // Message_Packet[2] = 0x07; //Data_Length = Preamble_Length + SizeofArray LSB 
-    //  printf("\n \r %x \n \r", Message_Packet[2]); 
-     
-     Message_Packet[3] = API_Identifier;  //API_ID
-     // printf("\n \r %x \n \r", Message_Packet[3]);
-    
-      Message_Packet[4] = 0x01;  //Frame_ID (**arbitrary for the moment)
-   //   printf("\n \r %x \n \r", Message_Packet[4]); 
-    
-      Message_Packet[5] = DestAddressMSB_val;   //Destination Address MSB
-    // printf("\n \r %x \n \r", Message_Packet[5]); 
-    
-      Message_Packet[6] = DestAddressLSB_val;   //Destination Address LSB
-    //  printf("\n \r %x \n \r", Message_Packet[6]); 
-    
-      Message_Packet[7] = Options;  //Options Byte 
-    // printf("\n \r %x \n \r", Message_Packet[7]); 
-    
+    HWREG(UART5_BASE + UART_O_DR) = Message_Packet[IDX];
+    IDX++;
   }
+}
   
-  
+/****************************************************************************
+ Function
+    BuildTXPacket
+
+ Parameters
+   uint8_t : the packet to send, REQ_2_PAIR or CTRL
+
+ Description
+   fills in the packet for the current boat and has the codec build the
+   frame in Message_Packet. Sets TXPacket_Length, to 0 if there is nothing
+   to send
+****************************************************************************/
 static void BuildTXPacket(uint8_t Packet)
 {
+  XBeePacket_t TXPacket;
+
+  TXPacket.Api = XBEE_TX_REQUEST;
+  TXPacket.FrameId = Frame_ID;
+  TXPacket.Address = DestAddress_val;
+  TXPacket.Options = TX_Options;
+  TXPacket.Message = (XBeeMessage_t)Packet;
   switch(Packet)
   { 
-          
-    case REQ_2_PAIR: 
-    {
-      //build the preamble 
-       BuildPreamble(); 
-      //set index to length of preamble
-      index = Preamble_Length_TX; 
-      //Add RF Data packet header corresponding to REQ_2_PAIR
-      Message_Packet[index] = REQ_2_PAIR; 
-      //increment index
-      index++; 
-      //decrement BytesRemaining 
-       BytesRemaining--;
+    case XBEE_REQ_2_PAIR: 
       //Red or Blue state 
-       Message_Packet[index] = TeamColor; 
-      //increment index
-       index++; 
-      //decrement BytesRemaining 
-       BytesRemaining--;
-      //ModifyDataLength()
-        Message_Packet[2] = 0x07; //Data_Length = Preamble_Length + SizeofArray LSB 
-        TXPacket_Length = 11; 
-      //calculate CheckSum (); 
-      //store CheckSum as the next byte of Message_Packet
-      Message_Packet[index] = CheckSum(); 
-
-    }
-    break;
+      TXPacket.Payload[XBEE_REQ_2_PAIR_COLOUR] = TeamColor; 
+      break;
     
-    case CTRL: 
-    {
-      //index = 0; 
-      //Build Preamble 
-      BuildPreamble();
-      //set index to length of preamble
-       index = Preamble_Length_TX; 
-      //Add RF Data packet corresponding to REQ_2_PAIR
-      Message_Packet[8] = CTRL; 
-      //increment index
-        index++; 
-      //decrement BytesRemaining 
-       BytesRemaining--;
-      
-      //Forward/Back
-       Message_Packet[index] =  getThrottle(); 
-      //increment index
-        index++; 
-      //decrement BytesRemaining 
-       BytesRemaining--;
-      
-      //Left/Right
-
-       Message_Packet[index] = getSteering(); 
-      //increment index
-        index++; 
-      //decrement BytesRemaining 
-       BytesRemaining--;
-      
-     
-       //Turret Yaw
-
-       Message_Packet[index] = getYaw(); 
-       //increment index
-        index++; 
-      //decrement BytesRemaining 
-       BytesRemaining--;
-       
-       //Turret Yaw
-
-       Message_Packet[index] = getPitch(); 
-         //increment index
-       index++; 
-      //decrement BytesRemaining 
-       BytesRemaining--;
-       
-       Message_Packet[index] = getControl(); 
-         //increment index
-       index++; 
-      //decrement BytesRemaining 
-       BytesRemaining--;
-      
-       //ModifyDataLength()
-        Message_Packet[2] = 0x0B; //Data_Length = Preamble_Length + SizeofArray LSB 
-        TXPacket_Length = 0x0F; 
-      
-      //calculate CheckSum (); 
-      //store CheckSum as the next byte of Message_Packet
-      Message_Packet[index] = CheckSum(); 
-
-      
-    }
-    break; 
-
-    case STATUS: 
-    {
-      //BuildPreamble
-      BuildPreamble(); 
-      //set index to length of preamble
-      index = Preamble_Length_TX; 
-      //Add RF Data packet corresponding to REQ_2_PAIR
-      Message_Packet[index] = STATUS; 
-      //increment index
-      index++; 
-      //calculate CheckSum (); 
-      //store CheckSum as the next byte of Message_Packet
-      Message_Packet[index] = CheckSum(); 
-    }
-    break; 
-  
+    case XBEE_CTRL: 
+      TXPacket.Payload[XBEE_CTRL_FB] = getThrottle(); 
+      TXPacket.Payload[XBEE_CTRL_LR] = getSteering(); 
+      TXPacket.Payload[XBEE_CTRL_TURRET_YAW] = getYaw(); 
+      TXPacket.Payload[XBEE_CTRL_TURRET_PITCH] = getPitch(); 
+      TXPacket.Payload[XBEE_CTRL_CONTROL] = getControl(); 
+      break; 
+
+    default: 
+      //the SHIP sends the others
+      TXPacket_Length = 0; 
+      return;
   }
-  return;
-}
-static uint8_t CheckSum(void)
-{
-  uint8_t summation = 0; 
-  uint8_t FrameDataStart = 3; //check sum is the 0xFF - (Sum of FrameData)
-  uint8_t computed_chksum = 0; 
-  uint8_t i; 
-  
-  for(i= FrameDataStart; i<(TXPacket_Length-1); i++)
-  {
-    summation += Message_Packet[i];
-  }
-  
-  computed_chksum =(0xFF-summation); 
-  
-  return computed_chksum; 
+  TXPacket_Length = XBeeCodec_Encode(&TXPacket, Message_Packet,
+      sizeof(Message_Packet));
 }
 
 
@@ -23,6 +23,7 @@
 #include "ES_General.h"
 #include "ES_Events.h"
 #include "ES_DeferRecall.h"
+#include "ES_Pool.h"
 
 /*--------------------------- External Variables --------------------------*/
 
@@ -64,12 +65,44 @@ bool ES_RecallEvents(uint8_t WhichService, ES_Event_t *pBlock)
     if (RecalledEvent.EventType != ES_NO_EVENT)
     {
       ES_PostToServiceLIFO(WhichService, RecalledEvent);
+      // the service queue holds any block now, let go of the deferral's
+      ES_Pool_DropEvent(RecalledEvent);
       WereEventsPulled = true;
     }
   } while (RecalledEvent.EventType != ES_NO_EVENT);
   return WereEventsPulled;
 }
 
+#ifdef ES_POOL_LIST
+/****************************************************************************
+ Function
+     ES_DeferEvent
+ Parameters
+      ES_Event_t * pBlock, pointer to the block of memory that implements the
+        Defer/Recall queue
+      ES_Event_t Event2Add, event to be added to the queue
+ Returns
+     bool true if the add was successful, false if not
+ Description
+     adds Event2Add to the deferral queue, taking a reference to the block
+     it carries so that the block outlives the run function that deferred it
+ Notes
+     with no pools configured this is a macro for ES_EnQueueLIFO
+ Author
+     10/17/26
+****************************************************************************/
+bool ES_DeferEvent(ES_Event_t *pBlock, ES_Event_t Event2Add)
+{
+  if (ES_EnQueueLIFO(pBlock, Event2Add) == true)
+  {
+    ES_Pool_HoldEvent(Event2Add);
+    return true;
+  }
+  return false;
+}
+
+#endif /* ES_POOL_LIST */
+
 /*------------------------------- Footnotes -------------------------------*/
 
 /*------------------------------ End of file ------------------------------*/
@@ -34,6 +34,7 @@
 #include "ES_Timers.h"
 #include "ES_General.h"
 #include "ES_CheckEvents.h"
+#include "ES_Pool.h"
 // Include the header files for the Service modules.
 // This gets you the prototypes for the public service functions.
 
@@ -259,6 +260,9 @@ ES_Return_t ES_Initialize(TimerRate_t NewRate)
 {
   uint8_t i;
   ES_Timer_Init(NewRate);  // start up the timer subsystem
+#ifdef ES_POOL_LIST
+  ES_Pool_Init();          // services may allocate blocks in their inits
+#endif
   // loop through the list testing for NULL pointers and
   for (i = 0; i < ARRAY_SIZE(ServDescList); i++)
   {
@@ -324,6 +328,8 @@ ES_Return_t ES_Run(void)
       {
         return FailedRun;
       }
+      // the service is done with any block the event carried
+      ES_Pool_DropEvent(ThisEvent);
 #ifdef _INCLUDE_BASIC_FRAMEWORK_DEBUG_
       _HW_DebugClearLine1();
 #endif
@@ -332,7 +338,9 @@ ES_Return_t ES_Run(void)
 #ifdef _INCLUDE_BASIC_FRAMEWORK_DEBUG_
     _HW_DebugSetLine2();
 #endif
-    // all the queues are empty, so look for new user detected events
+    // all the queues are empty, give the port a chance to deal with idle
+    _HW_Idle();
+    // then look for new user detected events
     ES_CheckUserEvents();
 #ifdef _INCLUDE_BASIC_FRAMEWORK_DEBUG_
     _HW_DebugClearLine2();
@@ -367,6 +375,7 @@ bool ES_PostAll(ES_Event_t ThisEvent)
     else
     {
       Ready |= BitNum2SetMask[i]; // show queue as non-empty
+      ES_Pool_HoldEvent(ThisEvent);
     }
   }
   if (i == ARRAY_SIZE(EventQueues))    // if no failures
@@ -401,6 +410,7 @@ bool ES_PostToService(uint8_t WhichService, ES_Event_t TheEvent)
         true))
   {
     Ready |= BitNum2SetMask[WhichService]; // show queue as non-empty
+    ES_Pool_HoldEvent(TheEvent);
     return true;
   }
   else
@@ -431,6 +441,7 @@ bool ES_PostToServiceLIFO(uint8_t WhichService, ES_Event_t TheEvent)
         true))
   {
     Ready |= BitNum2SetMask[WhichService]; // show queue as non-empty
+    ES_Pool_HoldEvent(TheEvent);
     return true;
   }
   else
@@ -439,6 +450,26 @@ bool ES_PostToServiceLIFO(uint8_t WhichService, ES_Event_t TheEvent)
   }
 }
 
+/****************************************************************************
+ Function
+   ES_IsIdle
+ Parameters
+   None
+ Returns
+   boolean : true if none of the services have an event waiting
+ Description
+   lets the port check, with interrupts disabled, that nothing was posted
+   between ES_Run finding the queues empty and the port going to sleep
+ Notes
+
+ Author
+   10/18/26
+****************************************************************************/
+bool ES_IsIdle(void)
+{
+  return Ready == 0;
+}
+
 //*********************************
 // private functions
 //*********************************
@@ -0,0 +1,847 @@
+/****************************************************************************
+ Module
+     ES_Pool.c
+ Description
+     optional pools of fixed size blocks for event payloads. Each size class
+     in ES_POOL_LIST gets its own array of blocks and a free list, so both
+     allocating and freeing take the same short time no matter how many
+     blocks are in use, and the memory can never fragment.
+ Notes
+     Only compiled when ES_POOL_LIST is defined in ES_Configure.h
+
+     Every block has a reference count. ES_Pool_Alloc hands out a block with
+     a count of 1, ES_Pool_Retain adds one, ES_Pool_Release takes one away
+     and puts the block back on its free list when the count reaches 0.
+     All of these may be called from interrupt responses, they do their work
+     with interrupts off for a few instructions.
+
+     Handles are (class + 1) in the upper byte and the block number in the
+     lower byte, so there can be up to 254 blocks in a class.
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 17:30         started coding
+*****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Configure.h"
+#include "ES_Pool.h"
+
+#ifdef ES_POOL_LIST
+
+#include "ES_General.h"
+#include "ES_Port.h"
+#include <stdio.h>
+
+#ifndef POOL_EVENT_LIST
+#error "POOL_EVENT_LIST must list the event types that carry pool handles"
+#endif
+
+/*----------------------------- Module Defines ----------------------------*/
+// marks the end of a free list, also the limit on blocks per class
+#define END_OF_LIST 0xFF
+
+// blocks are kept in uint32_t arrays so that every block is word aligned
+#define WORDS_PER_BLOCK(Size) (((Size) + 3) / 4)
+
+typedef struct
+{
+  uint32_t  *pBlocks;   // NumBlocks blocks of WORDS_PER_BLOCK(BlockSize)
+  uint8_t   *pRefs;     // reference count of each block, 0 when free
+  uint8_t   *pNext;     // free list links
+  uint16_t  *pLengths;  // bytes in use in each block
+  uint16_t  BlockSize;
+  uint8_t   NumBlocks;
+}PoolDesc_t;
+
+typedef struct
+{
+  uint8_t   FreeHead;
+  uint8_t   InUse;
+  uint8_t   MaxInUse;
+  uint16_t  Failures;
+}PoolState_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+static bool Decode(ES_PoolHandle_t Handle, uint8_t *pClass, uint8_t *pBlock);
+
+/*---------------------------- Module Variables ---------------------------*/
+// the memory for each size class. The CountCheck array only exists to
+// stop the compile if a class has no blocks or too many
+#define POOL_MEMORY(Size, Count) \
+  static uint32_t Blocks_##Size[(Count) * WORDS_PER_BLOCK(Size)]; \
+  static uint8_t  Refs_##Size[(Count)]; \
+  static uint8_t  Next_##Size[(Count)]; \
+  static uint16_t Lengths_##Size[(Count)]; \
+  extern char CountCheck_##Size[(((Count) > 0) && \
+      ((Count) < END_OF_LIST)) ? 1 : -1];
+
+ES_POOL_LIST(POOL_MEMORY)
+
+#define POOL_DESC(Size, Count) \
+  { Blocks_##Size, Refs_##Size, Next_##Size, Lengths_##Size, (Size), \
+    (Count) },
+
+static PoolDesc_t const Pools[] = {
+  ES_POOL_LIST(POOL_DESC)
+};
+
+#define NUM_CLASSES ARRAY_SIZE(Pools)
+
+static PoolState_t State[NUM_CLASSES];
+
+static ES_EventType_t const PayloadEvents[] = {
+  POOL_EVENT_LIST
+};
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+   ES_Pool_Init
+ Parameters
+   None
+ Returns
+   None
+ Description
+   puts every block on its free list and clears the statistics
+ Notes
+   called by ES_Initialize before any of the services are initialized, any
+   handles from before then are no longer valid
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Pool_Init(void)
+{
+  uint8_t Class;
+  uint8_t Block;
+
+  for (Class = 0; Class < NUM_CLASSES; Class++)
+  {
+    for (Block = 0; Block < Pools[Class].NumBlocks; Block++)
+    {
+      Pools[Class].pRefs[Block] = 0;
+      Pools[Class].pNext[Block] = Block + 1;
+    }
+    Pools[Class].pNext[Pools[Class].NumBlocks - 1] = END_OF_LIST;
+    State[Class].FreeHead = 0;
+    State[Class].InUse = 0;
+    State[Class].MaxInUse = 0;
+    State[Class].Failures = 0;
+  }
+}
+
+/****************************************************************************
+ Function
+   ES_Pool_Alloc
+ Parameters
+   uint16_t Length : number of bytes needed
+ Returns
+   ES_PoolHandle_t : handle of a block of at least Length bytes, with one
+   reference held by the caller. ES_POOL_NO_HANDLE if there was none free
+ Description
+   takes a block from the smallest class that fits Length and has a block
+   free, so a busy small class spills over into the bigger ones
+ Notes
+   a failure is counted against the smallest class that would have fit
+ Author
+   10/17/26
+****************************************************************************/
+ES_PoolHandle_t ES_Pool_Alloc(uint16_t Length)
+{
+  uint8_t         Class;
+  uint8_t         Block;
+  uint8_t         FirstFit = NUM_CLASSES;
+  uint32_t        SavedPRIMASK;
+  ES_PoolHandle_t Handle = ES_POOL_NO_HANDLE;
+
+  SavedPRIMASK = CPUgetPRIMASK_cpsid();
+  for (Class = 0; Class < NUM_CLASSES; Class++)
+  {
+    if (Length <= Pools[Class].BlockSize)
+    {
+      if (FirstFit == NUM_CLASSES)
+      {
+        FirstFit = Class;
+      }
+      Block = State[Class].FreeHead;
+      if (Block != END_OF_LIST)
+      {
+        State[Class].FreeHead = Pools[Class].pNext[Block];
+        Pools[Class].pRefs[Block] = 1;
+        Pools[Class].pLengths[Block] = Length;
+        State[Class].InUse++;
+        if (State[Class].InUse > State[Class].MaxInUse)
+        {
+          State[Class].MaxInUse = State[Class].InUse;
+        }
+        Handle = (ES_PoolHandle_t)(((Class + 1) << 8) | Block);
+        break;
+      }
+    }
+  }
+  if ((Handle == ES_POOL_NO_HANDLE) && (FirstFit != NUM_CLASSES) &&
+      (State[FirstFit].Failures != 0xFFFF))
+  {
+    State[FirstFit].Failures++;
+  }
+  CPUsetPRIMASK(SavedPRIMASK);
+  return Handle;
+}
+
+/****************************************************************************
+ Function
+   ES_Pool_Retain
+ Parameters
+   ES_PoolHandle_t Handle : the block to keep
+ Returns
+   bool : false if Handle is not an allocated block or already has the
+   most references a block can have
+ Description
+   adds a reference to the block so that it is not freed until there is a
+   matching ES_Pool_Release
+ Notes
+
+ Author
+   10/17/26
+****************************************************************************/
+bool ES_Pool_Retain(ES_PoolHandle_t Handle)
+{
+  uint8_t   Class;
+  uint8_t   Block;
+  uint32_t  SavedPRIMASK;
+  bool      ReturnVal = false;
+
+  if (Decode(Handle, &Class, &Block) == true)
+  {
+    SavedPRIMASK = CPUgetPRIMASK_cpsid();
+    if ((Pools[Class].pRefs[Block] != 0) &&
+        (Pools[Class].pRefs[Block] != 0xFF))
+    {
+      Pools[Class].pRefs[Block]++;
+      ReturnVal = true;
+    }
+    CPUsetPRIMASK(SavedPRIMASK);
+  }
+  return ReturnVal;
+}
+
+/****************************************************************************
+ Function
+   ES_Pool_Release
+ Parameters
+   ES_PoolHandle_t Handle : the block to let go of
+ Returns
+   bool : false if Handle is not an allocated block
+ Description
+   takes away a reference, the block goes back on its free list when the
+   last one is gone
+ Notes
+   the handle must not be used after the caller's last release
+ Author
+   10/17/26
+****************************************************************************/
+bool ES_Pool_Release(ES_PoolHandle_t Handle)
+{
+  uint8_t   Class;
+  uint8_t   Block;
+  uint32_t  SavedPRIMASK;
+  bool      ReturnVal = false;
+
+  if (Decode(Handle, &Class, &Block) == true)
+  {
+    SavedPRIMASK = CPUgetPRIMASK_cpsid();
+    if (Pools[Class].pRefs[Block] != 0)
+    {
+      Pools[Class].pRefs[Block]--;
+      if (Pools[Class].pRefs[Block] == 0)
+      {
+        Pools[Class].pNext[Block] = State[Class].FreeHead;
+        State[Class].FreeHead = Block;
+        State[Class].InUse--;
+      }
+      ReturnVal = true;
+    }
+    CPUsetPRIMASK(SavedPRIMASK);
+  }
+  return ReturnVal;
+}
+
+/****************************************************************************
+ Function
+   ES_Pool_GetPtr
+ Parameters
+   ES_PoolHandle_t Handle : an allocated block
+ Returns
+   void * : the start of the block, word aligned. NULL if Handle is not an
+   allocated block
+ Description
+   gives access to the bytes in a block
+ Notes
+   the pointer is only good while the caller holds a reference
+ Author
+   10/17/26
+****************************************************************************/
+void *ES_Pool_GetPtr(ES_PoolHandle_t Handle)
+{
+  uint8_t Class;
+  uint8_t Block;
+
+  if ((Decode(Handle, &Class, &Block) == true) &&
+      (Pools[Class].pRefs[Block] != 0))
+  {
+    return &Pools[Class].pBlocks[Block *
+           WORDS_PER_BLOCK(Pools[Class].BlockSize)];
+  }
+  return NULL;
+}
+
+/****************************************************************************
+ Function
+   ES_Pool_GetLength
+ Parameters
+   ES_PoolHandle_t Handle : an allocated block
+ Returns
+   uint16_t : the length given to ES_Pool_Alloc or ES_Pool_SetLength, 0 if
+   Handle is not an allocated block
+ Description
+   lets the receiver of a payload know how much of the block is in use
+ Notes
+
+ Author
+   10/17/26
+****************************************************************************/
+uint16_t ES_Pool_GetLength(ES_PoolHandle_t Handle)
+{
+  uint8_t Class;
+  uint8_t Block;
+
+  if ((Decode(Handle, &Class, &Block) == true) &&
+      (Pools[Class].pRefs[Block] != 0))
+  {
+    return Pools[Class].pLengths[Block];
+  }
+  return 0;
+}
+
+/****************************************************************************
+ Function
+   ES_Pool_SetLength
+ Parameters
+   ES_PoolHandle_t Handle : an allocated block
+   uint16_t Length : the number of bytes now in use
+ Returns
+   bool : false if Handle is not an allocated block or Length does not fit
+ Description
+   for producers that allocate for the longest payload and only find out
+   how long it really is as they fill it in
+ Notes
+   set the length before posting, receivers do not expect it to change
+ Author
+   10/17/26
+****************************************************************************/
+bool ES_Pool_SetLength(ES_PoolHandle_t Handle, uint16_t Length)
+{
+  uint8_t Class;
+  uint8_t Block;
+
+  if ((Decode(Handle, &Class, &Block) == true) &&
+      (Pools[Class].pRefs[Block] != 0) &&
+      (Length <= Pools[Class].BlockSize))
+  {
+    Pools[Class].pLengths[Block] = Length;
+    return true;
+  }
+  return false;
+}
+
+/****************************************************************************
+ Function
+   ES_Pool_IsPayloadEvent
+ Parameters
+   ES_EventType_t WhichEvent : the event type to test
+ Returns
+   bool : true if WhichEvent is in POOL_EVENT_LIST
+ Description
+   tells the framework whether the EventParam of an event is a pool handle
+ Notes
+
+ Author
+   10/17/26
+****************************************************************************/
+bool ES_Pool_IsPayloadEvent(ES_EventType_t WhichEvent)
+{
+  uint8_t i;
+
+  for (i = 0; i < ARRAY_SIZE(PayloadEvents); i++)
+  {
+    if (PayloadEvents[i] == WhichEvent)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/****************************************************************************
+ Function
+   ES_Pool_HoldEvent
+ Parameters
+   ES_Event_t ThisEvent : an event that has just been put in a queue
+ Returns
+   None
+ Description
+   takes a reference for the queued copy if the event carries a block
+ Notes
+   called by the posting functions after each successful enqueue, so a
+   post to a distribution list holds the block once for each service
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Pool_HoldEvent(ES_Event_t ThisEvent)
+{
+  if ((ThisEvent.EventParam != ES_POOL_NO_HANDLE) &&
+      (ES_Pool_IsPayloadEvent(ThisEvent.EventType) == true))
+  {
+    ES_Pool_Retain(ThisEvent.EventParam);
+  }
+}
+
+/****************************************************************************
+ Function
+   ES_Pool_DropEvent
+ Parameters
+   ES_Event_t ThisEvent : an event that has been taken out of a queue
+ Returns
+   None
+ Description
+   gives back the reference taken by ES_Pool_HoldEvent
+ Notes
+   called by ES_Run once the run function that got the event returns
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Pool_DropEvent(ES_Event_t ThisEvent)
+{
+  if ((ThisEvent.EventParam != ES_POOL_NO_HANDLE) &&
+      (ES_Pool_IsPayloadEvent(ThisEvent.EventType) == true))
+  {
+    ES_Pool_Release(ThisEvent.EventParam);
+  }
+}
+
+/****************************************************************************
+ Function
+   ES_Pool_GetStats
+ Parameters
+   uint8_t WhichClass : the size class, in the order of ES_POOL_LIST
+   ES_PoolStats_t *pStats : where to put them
+ Returns
+   bool : false if there is no such class
+ Description
+   copies out the use of one size class, for sizing the pools
+ Notes
+
+ Author
+   10/17/26
+****************************************************************************/
+bool ES_Pool_GetStats(uint8_t WhichClass, ES_PoolStats_t *pStats)
+{
+  uint32_t SavedPRIMASK;
+
+  if (WhichClass >= NUM_CLASSES)
+  {
+    return false;
+  }
+  SavedPRIMASK = CPUgetPRIMASK_cpsid();
+  pStats->BlockSize = Pools[WhichClass].BlockSize;
+  pStats->NumBlocks = Pools[WhichClass].NumBlocks;
+  pStats->InUse = State[WhichClass].InUse;
+  pStats->MaxInUse = State[WhichClass].MaxInUse;
+  pStats->Failures = State[WhichClass].Failures;
+  CPUsetPRIMASK(SavedPRIMASK);
+  return true;
+}
+
+/****************************************************************************
+ Function
+   ES_Pool_PrintStats
+ Parameters
+   None
+ Returns
+   None
+ Description
+   prints a line for each size class on the console
+ Notes
+   uses printf, so only call it from the main loop
+ Author
+   10/17/26
+****************************************************************************/
+void ES_Pool_PrintStats(void)
+{
+  uint8_t         Class;
+  ES_PoolStats_t  Stats;
+
+  printf("Pool  Size Blocks InUse   Max Fails\r\n");
+  for (Class = 0; Class < NUM_CLASSES; Class++)
+  {
+    ES_Pool_GetStats(Class, &Stats);
+    printf("%4u %5u %6u %5u %5u %5u\r\n", Class, Stats.BlockSize,
+        Stats.NumBlocks, Stats.InUse, Stats.MaxInUse, Stats.Failures);
+  }
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+/****************************************************************************
+ Function
+   Decode
+ Parameters
+   ES_PoolHandle_t Handle : the handle to take apart
+   uint8_t *pClass, uint8_t *pBlock : where to put the pieces
+ Returns
+   bool : false if Handle could not have come from ES_Pool_Alloc
+ Description
+   splits a handle into its size class & block number
+ Notes
+   does not check that the block is allocated
+****************************************************************************/
+static bool Decode(ES_PoolHandle_t Handle, uint8_t *pClass, uint8_t *pBlock)
+{
+  uint8_t Class = (uint8_t)((Handle >> 8) - 1);  // NO_HANDLE becomes 0xFF
+  uint8_t Block = (uint8_t)Handle;
+
+  if ((Class >= NUM_CLASSES) || (Block >= Pools[Class].NumBlocks))
+  {
+    return false;
+  }
+  *pClass = Class;
+  *pBlock = Block;
+  return true;
+}
+
+#if defined(TEST) && defined(ES_PORT_POSIX)
+/*
+  Host test of the allocator on its own, for whatever ES_POOL_LIST is in
+  ES_Configure.h. Build with:
+  gcc -O2 -DTEST -DES_PORT_POSIX -IHeaders Source/ES_Pool.c
+
+  First every block is allocated, smallest request first, to check the
+  spill order into the bigger classes and that no two blocks overlap. Then
+  the reference counts are run through a fan-out the way the posting
+  functions and ES_Run use them. Last, random allocs, retains and releases
+  are checked against a model of the free blocks in each class, including
+  the failure counts, and the contents of every block are checked when its
+  last reference goes. Every block must be free at the end.
+*/
+#include <string.h>
+
+#define NUM_TEST_OPS 200000UL
+
+// the total number of blocks in all of the classes
+#define POOL_COUNT(Size, Count) + (Count)
+#define TOTAL_BLOCKS (0 ES_POOL_LIST(POOL_COUNT))
+
+typedef struct
+{
+  ES_PoolHandle_t Handle;
+  uint16_t        Length;
+  uint8_t         Refs;
+  uint8_t         Tag;
+}LiveBlock_t;
+
+uint32_t _PRIMASK_temp;
+
+static LiveBlock_t  Live[TOTAL_BLOCKS];
+static uint8_t      NumLive;
+static uint32_t     Errors;
+static uint32_t     RandomState = 12345;
+
+uint32_t CPUgetPRIMASK_cpsid(void)
+{
+  return 0;
+}
+
+void CPUsetPRIMASK(uint32_t newPRIMASK)
+{
+  (void)newPRIMASK;
+}
+
+static void Check(bool Condition, char const *pWhat)
+{
+  if (Condition != true)
+  {
+    printf("FAILED: %s\n", pWhat);
+    Errors++;
+  }
+}
+
+static uint32_t Random(uint32_t Range)
+{
+  RandomState = RandomState * 1103515245u + 12345u;
+  return (RandomState >> 8) % Range;
+}
+
+static bool BlockHolds(ES_PoolHandle_t Handle, uint8_t Tag, uint16_t Length)
+{
+  uint8_t   *pBytes = ES_Pool_GetPtr(Handle);
+  uint16_t  i;
+
+  if (pBytes == NULL)
+  {
+    return false;
+  }
+  for (i = 0; i < Length; i++)
+  {
+    if (pBytes[i] != Tag)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void CheckAllFree(char const *pWhat)
+{
+  uint8_t         Class;
+  ES_PoolStats_t  Stats;
+
+  for (Class = 0; Class < NUM_CLASSES; Class++)
+  {
+    ES_Pool_GetStats(Class, &Stats);
+    Check(Stats.InUse == 0, pWhat);
+  }
+}
+
+static void FillEveryBlock(void)
+{
+  ES_PoolHandle_t Handles[TOTAL_BLOCKS];
+  uint16_t        Largest = Pools[NUM_CLASSES - 1].BlockSize;
+  uint8_t         Class = 0;
+  uint8_t         InClass = 0;
+  uint8_t         i;
+
+  ES_Pool_Init();
+  for (i = 0; i < TOTAL_BLOCKS; i++)
+  {
+    Handles[i] = ES_Pool_Alloc(1);
+    Check(Handles[i] != ES_POOL_NO_HANDLE, "alloc while blocks are free");
+    if (InClass == Pools[Class].NumBlocks)
+    {
+      Class++;
+      InClass = 0;
+    }
+    Check((Handles[i] >> 8) == Class + 1, "spill into the next class up");
+    InClass++;
+    // the whole block is ours, whatever length was asked for
+    memset(ES_Pool_GetPtr(Handles[i]), i, Pools[Class].BlockSize);
+  }
+  Check(ES_Pool_Alloc(1) == ES_POOL_NO_HANDLE, "alloc with no blocks free");
+  Check(ES_Pool_Alloc(Largest + 1) == ES_POOL_NO_HANDLE,
+      "alloc bigger than any class");
+  for (i = 0; i < TOTAL_BLOCKS; i++)
+  {
+    Check(BlockHolds(Handles[i], i,
+        Pools[(Handles[i] >> 8) - 1].BlockSize), "blocks overlap");
+  }
+  Check(ES_Pool_SetLength(Handles[0], Pools[0].BlockSize + 1) == false,
+      "length past the block");
+  Check(ES_Pool_SetLength(Handles[0], Pools[0].BlockSize) == true,
+      "length of the whole block");
+  Check(ES_Pool_GetLength(Handles[0]) == Pools[0].BlockSize, "length kept");
+
+  // the freed block is the one handed out next
+  Check(ES_Pool_Release(Handles[0]) == true, "release");
+  Check(ES_Pool_GetPtr(Handles[0]) == NULL, "block freed by the last ref");
+  Check(ES_Pool_Release(Handles[0]) == false, "release of a free block");
+  Check(ES_Pool_Alloc(1) == Handles[0], "reuse of the freed block");
+  for (i = 0; i < TOTAL_BLOCKS; i++)
+  {
+    ES_Pool_Release(Handles[i]);
+  }
+  CheckAllFree("blocks left after the fill");
+}
+
+static void FanOut(void)
+{
+  ES_Event_t      ThisEvent;
+  ES_Event_t      Plain;
+  ES_PoolHandle_t Handle;
+  uint8_t         i;
+
+  ES_Pool_Init();
+  Check(ES_Pool_Retain(ES_POOL_NO_HANDLE) == false, "retain of no handle");
+  Handle = ES_Pool_Alloc(Pools[0].BlockSize);
+  ThisEvent.EventType = PayloadEvents[0];
+  ThisEvent.EventParam = Handle;
+  // posted to three queues, then the poster lets go of its reference
+  for (i = 0; i < 3; i++)
+  {
+    ES_Pool_HoldEvent(ThisEvent);
+  }
+  ES_Pool_Release(Handle);
+  // an event of another type with the same number in its param is no
+  // business of the pools
+  Plain.EventType = ES_NO_EVENT;
+  Plain.EventParam = Handle;
+  ES_Pool_DropEvent(Plain);
+  for (i = 0; i < 3; i++)
+  {
+    Check(ES_Pool_GetPtr(Handle) != NULL, "block kept until the last run");
+    ES_Pool_DropEvent(ThisEvent);
+  }
+  Check(ES_Pool_GetPtr(Handle) == NULL, "block freed after the last run");
+  CheckAllFree("blocks left after the fan-out");
+}
+
+static void LetGo(uint8_t Which)
+{
+  if (Live[Which].Refs == 1)
+  {
+    Check(BlockHolds(Live[Which].Handle, Live[Which].Tag, Live[Which].Length),
+        "contents kept while allocated");
+  }
+  Check(ES_Pool_Release(Live[Which].Handle) == true, "release of a live block");
+  if (--Live[Which].Refs == 0)
+  {
+    Live[Which] = Live[--NumLive];
+  }
+}
+
+static void RandomOps(void)
+{
+  uint8_t         FreeBlocks[NUM_CLASSES];
+  uint16_t        Failures[NUM_CLASSES];
+  uint16_t        Largest = Pools[NUM_CLASSES - 1].BlockSize;
+  uint16_t        Length;
+  uint8_t         FirstFit;
+  uint8_t         Expected;
+  uint8_t         Class;
+  uint8_t         Which;
+  uint32_t        Op;
+  ES_PoolHandle_t Handle;
+  ES_PoolStats_t  Stats;
+
+  ES_Pool_Init();
+  for (Class = 0; Class < NUM_CLASSES; Class++)
+  {
+    FreeBlocks[Class] = Pools[Class].NumBlocks;
+    Failures[Class] = 0;
+  }
+  for (Op = 0; Op < NUM_TEST_OPS; Op++)
+  {
+    Which = (NumLive != 0) ? (uint8_t)Random(NumLive) : 0;
+    switch (Random(6))
+    {
+      case 0:   // retain, up to a few references
+      {
+        if ((NumLive != 0) && (Live[Which].Refs < 4))
+        {
+          Check(ES_Pool_Retain(Live[Which].Handle) == true, "retain");
+          Live[Which].Refs++;
+        }
+      }
+      break;
+
+      case 1:
+      case 2:
+      case 3:   // release
+      {
+        if (NumLive != 0)
+        {
+          Class = (uint8_t)((Live[Which].Handle >> 8) - 1);
+          if (Live[Which].Refs == 1)
+          {
+            FreeBlocks[Class]++;
+          }
+          LetGo(Which);
+        }
+      }
+      break;
+
+      default:  // alloc, now and then too big for any class
+      {
+        // a length that fits a class picked at random, so that the small
+        // classes fill up too
+        Class = (uint8_t)Random(NUM_CLASSES + 1);
+        if (Class == NUM_CLASSES)
+        {
+          Length = (uint16_t)(Largest + 1 + Random(8));
+        }
+        else
+        {
+          Length = (uint16_t)Random(Pools[Class].BlockSize + 1u);
+        }
+        FirstFit = NUM_CLASSES;
+        Expected = NUM_CLASSES;
+        for (Class = 0; Class < NUM_CLASSES; Class++)
+        {
+          if (Length <= Pools[Class].BlockSize)
+          {
+            if (FirstFit == NUM_CLASSES)
+            {
+              FirstFit = Class;
+            }
+            if ((Expected == NUM_CLASSES) && (FreeBlocks[Class] != 0))
+            {
+              Expected = Class;
+            }
+          }
+        }
+        Handle = ES_Pool_Alloc(Length);
+        if (Expected == NUM_CLASSES)
+        {
+          Check(Handle == ES_POOL_NO_HANDLE, "alloc with none free");
+          if ((FirstFit != NUM_CLASSES) && (Failures[FirstFit] != 0xFFFF))
+          {
+            Failures[FirstFit]++;
+          }
+        }
+        else if (Handle == ES_POOL_NO_HANDLE)
+        {
+          Check(false, "alloc with blocks free");
+        }
+        else
+        {
+          Check((Handle >> 8) == Expected + 1, "alloc from the class that fits");
+          Check(ES_Pool_GetLength(Handle) == Length, "length of a new block");
+          FreeBlocks[Expected]--;
+          Live[NumLive].Handle = Handle;
+          Live[NumLive].Length = Length;
+          Live[NumLive].Refs = 1;
+          Live[NumLive].Tag = (uint8_t)Op;
+          memset(ES_Pool_GetPtr(Handle), (uint8_t)Op, Length);
+          NumLive++;
+        }
+      }
+      break;
+    }
+  }
+  while (NumLive != 0)
+  {
+    LetGo(0);
+  }
+  for (Class = 0; Class < NUM_CLASSES; Class++)
+  {
+    ES_Pool_GetStats(Class, &Stats);
+    Check(Stats.InUse == 0, "blocks left after the random ops");
+    Check(Stats.MaxInUse == Stats.NumBlocks, "every block used");
+    Check(Stats.Failures == Failures[Class], "failure count");
+  }
+}
+
+int main(void)
+{
+  FillEveryBlock();
+  FanOut();
+  RandomOps();
+  ES_Pool_PrintStats();
+  printf("%lu errors\n", (unsigned long)Errors);
+  return (Errors == 0) ? 0 : 1;
+}
+
+#endif /* TEST */
+
+#endif /* ES_POOL_LIST */
+
+/*------------------------------- Footnotes -------------------------------*/
+/*------------------------------ End of file ------------------------------*/
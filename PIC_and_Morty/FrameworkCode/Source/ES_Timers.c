@@ -67,6 +67,9 @@ typedef uint16_t Tflag_t;
 typedef uint16_t Timer_t; // sets size of timers to 16 bits
 
 /*---------------------------- Module Functions ---------------------------*/
+#if defined(TEST) && defined(ES_PORT_POSIX)
+static bool TestPost(ES_Event_t ThisEvent);
+#endif
 
 /*---------------------------- Module Variables ---------------------------*/
 static Timer_t TMR_TimerArray[sizeof(Tflag_t) * BITS_PER_BYTE] =
@@ -93,6 +96,10 @@ static Tflag_t TMR_ActiveFlags;
 
 static pPostFunc const Timer2PostFunc[sizeof(Tflag_t) * BITS_PER_BYTE] =
 {
+#if defined(TEST) && defined(ES_PORT_POSIX)
+  // the host test at the bottom takes every timeout itself
+  [0 ... (sizeof(Tflag_t) * BITS_PER_BYTE) - 1] = TestPost
+#else
   TIMER0_RESP_FUNC,
   TIMER1_RESP_FUNC,
   TIMER2_RESP_FUNC,
@@ -109,6 +116,7 @@ static pPostFunc const Timer2PostFunc[sizeof(Tflag_t) * BITS_PER_BYTE] =
   TIMER13_RESP_FUNC,
   TIMER14_RESP_FUNC,
   TIMER15_RESP_FUNC
+#endif
 };
 
 /*------------------------------ Module Code ------------------------------*/
@@ -319,6 +327,255 @@ void ES_Timer_Tick_Resp(void)
   }
 }
 
+/****************************************************************************
+ Function
+     ES_Timer_GetTicksToNextExpiry
+ Parameters
+     None.
+ Returns
+     the number of ticks until the next timer expires, ES_Timer_NO_EXPIRY if
+     no timers are running
+ Description
+     used by the port for tickless idle. Until the tick that this returns,
+     nothing will time out, so the port may sleep and then catch up with
+     ES_Timer_AdvanceTicks.
+ Notes
+     Call with interrupts disabled, so that an ISR can not start a timer
+     between this answer and the sleep that depends on it.
+ Author
+     10/18/26
+****************************************************************************/
+uint32_t ES_Timer_GetTicksToNextExpiry(void)
+{
+  Tflag_t   NeedsLook = TMR_ActiveFlags;
+  uint8_t   ThisTimer;
+  uint32_t  Soonest = ES_Timer_NO_EXPIRY;
+
+  while (NeedsLook != 0)
+  {
+    ThisTimer = ES_GetMSBitSet(NeedsLook);
+    if (TMR_TimerArray[ThisTimer] < Soonest)
+    {
+      Soonest = TMR_TimerArray[ThisTimer];
+    }
+    NeedsLook &= BitNum2ClrMask[ThisTimer];
+  }
+  return Soonest;
+}
+
+/****************************************************************************
+ Function
+     ES_Timer_AdvanceTicks
+ Parameters
+     uint32_t Ticks, the number of ticks that went by without a response
+ Returns
+     None.
+ Description
+     catches the timers up after the port has slept through some ticks.
+     The ticks up to the next expiry are taken off every active timer in
+     one go, the tick response is run for the tick that expires one, so
+     the timeouts are still posted on the right tick.
+ Notes
+     Called from the port, in the same (thread) context as
+     ES_Timer_Tick_Resp
+ Author
+     10/18/26
+****************************************************************************/
+void ES_Timer_AdvanceTicks(uint32_t Ticks)
+{
+  uint32_t  Skip;
+  Tflag_t   NeedsProcessing;
+  uint8_t   ThisTimer;
+
+  while (Ticks > 0)
+  {
+    Skip = ES_Timer_GetTicksToNextExpiry();
+    if (Skip > Ticks)
+    {
+      Skip = Ticks;
+    }
+    // nothing times out on the ticks that we jump over
+    NeedsProcessing = TMR_ActiveFlags;
+    while (NeedsProcessing != 0)
+    {
+      ThisTimer = ES_GetMSBitSet(NeedsProcessing);
+      TMR_TimerArray[ThisTimer] -= (Timer_t)(Skip - 1);
+      NeedsProcessing &= BitNum2ClrMask[ThisTimer];
+    }
+    ES_Timer_Tick_Resp();
+    Ticks -= Skip;
+  }
+}
+
+#if defined(TEST) && defined(ES_PORT_POSIX)
+/*
+  Host test of tickless idle, reporting how often the processor would be
+  woken while the application waits. Built with the host port on its
+  virtual clock, which in tickless mode jumps to the next timer expiry when
+  ES_Run is idle, no further than the Tiva's 24 bit SysTick could sleep,
+  just as ES_Port.c sleeps through the ticks. Each idle case is the set of
+  timers an application keeps running while it waits, each restarted as
+  soon as it times out, run for NUM_TEST_SECONDS of simulated time. The
+  tick interrupts that were actually delivered (_HW_GetWakeupCount) are
+  reported per simulated second. Every timeout must arrive on the tick
+  that it is due, with ES_Timer_GetTime in step, and the only wakeups must
+  be for a timeout or at the end of the longest sleep. The last case
+  restarts its timers for random times, so that timeouts land together
+  and a tick apart. ES_Run and ES_IsIdle are stand-ins that restart the
+  timers, so that this test links on its own. Build with:
+  gcc -O2 -DES_PORT_POSIX -IHeaders -c Source/ES_PortPOSIX.c
+      Source/ES_LookupTables.c
+  gcc -O2 -DTEST -DES_PORT_POSIX -IHeaders -I$TIVAWARE Source/ES_Timers.c
+      ES_PortPOSIX.o ES_LookupTables.o -lpthread
+*/
+#include <stdio.h>
+
+#define NUM_TEST_SECONDS 3600u
+#define TEST_RATE ES_Timer_RATE_1mS
+#define TICKS_PER_SECOND 1000u
+#define NUM_TEST_TICKS (NUM_TEST_SECONDS * TICKS_PER_SECOND)
+// the longest sleep, as many ticks as fit in the 24 bit SysTick
+#define MAX_SLEEP_TICKS (0x1000000UL / TEST_RATE)
+#define MAX_CASE_TIMERS 4
+// in place of a time, restart the timer for a new random time each time
+#define RANDOM_TIME 0xFFFFu
+#define MAX_RANDOM_TIME 2000u
+
+typedef struct
+{
+  char const  *Name;
+  uint16_t    Times[MAX_CASE_TIMERS];   // ticks, 0 for no timer
+}IdleCase_t;
+
+static IdleCase_t const IdleCases[] =
+{
+  { "SHIP waiting to pair, no timers", { 0 } },
+  { "SHIP trying to pair, 150 ms & 3 s", { 150, 3000 } },
+  { "ANSIBLE, 7 ms, 20 ms & 100 ms", { 7, 20, 100 } },
+  { "random times up to 2 s",
+    { RANDOM_TIME, RANDOM_TIME, RANDOM_TIME, RANDOM_TIME } }
+};
+
+static uint16_t TimerTimes[MAX_CASE_TIMERS];
+static uint32_t DueTick[MAX_CASE_TIMERS];   // the elapsed tick it is due on
+static Tflag_t  TimedOut;           // for the stand-in ES_Run to restart
+static uint32_t LastTimeoutTick;
+static uint32_t NumTimeoutTicks;    // ticks with at least one timeout
+static uint32_t Errors;
+static uint32_t Seed = 12345u;
+
+static uint32_t Random(void)
+{
+  Seed = Seed * 1103515245u + 12345u;
+  return Seed >> 8;
+}
+
+static void Check(bool Good, char const *What)
+{
+  if (!Good)
+  {
+    Errors++;
+    printf("FAILED: %s\n", What);
+  }
+}
+
+static void StartTestTimer(uint8_t Num)
+{
+  uint16_t Time = TimerTimes[Num];
+
+  if (Time == RANDOM_TIME)
+  {
+    Time = 1 + Random() % MAX_RANDOM_TIME;
+  }
+  ES_Timer_InitTimer(Num, Time);
+  DueTick[Num] = _HW_GetElapsedTicks() + Time;
+}
+
+static bool TestPost(ES_Event_t ThisEvent)
+{
+  uint32_t Now = _HW_GetElapsedTicks();
+
+  Check((ThisEvent.EventType == ES_TIMEOUT) &&
+      (ThisEvent.EventParam < MAX_CASE_TIMERS), "timeout from a test timer");
+  Check(Now == DueTick[ThisEvent.EventParam & (MAX_CASE_TIMERS - 1)],
+      "timeout on the tick it is due");
+  Check(ES_Timer_GetTime() == (uint16_t)Now, "ES_Timer_GetTime in step");
+  if (Now != LastTimeoutTick)
+  {
+    NumTimeoutTicks++;
+    LastTimeoutTick = Now;
+  }
+  TimedOut |= BitNum2SetMask[ThisEvent.EventParam];
+  return true;
+}
+
+// stand-ins for the framework, the timed out timers are the queued events
+ES_Return_t ES_Run(void)
+{
+  uint8_t Num;
+
+  while (1)
+  {
+    while ((_HW_Process_Pending_Ints()) && (TimedOut != 0))
+    {
+      Num = ES_GetMSBitSet(TimedOut);
+      TimedOut &= BitNum2ClrMask[Num];
+      StartTestTimer(Num);
+    }
+    _HW_Idle();
+  }
+}
+
+bool ES_IsIdle(void)
+{
+  return TimedOut == 0;
+}
+
+int main(void)
+{
+  uint8_t   i;
+  uint8_t   j;
+  uint32_t  FirstWakeup;
+  uint32_t  NumWakeups;
+
+  _HW_SelectClock(HW_CLOCK_VIRTUAL);
+  ES_Timer_Init(TEST_RATE);
+  for (i = 0; i < ARRAY_SIZE(IdleCases); i++)
+  {
+    NumTimeoutTicks = 0;
+    for (j = 0; j < MAX_CASE_TIMERS; j++)
+    {
+      TimerTimes[j] = IdleCases[i].Times[j];
+      if (TimerTimes[j] != 0)
+      {
+        StartTestTimer(j);
+      }
+    }
+    FirstWakeup = _HW_GetWakeupCount();
+    Check(_HW_RunFor(NUM_TEST_TICKS), "run for the whole time");
+    NumWakeups = _HW_GetWakeupCount() - FirstWakeup;
+    Check(NumWakeups >= NumTimeoutTicks, "woken for every timeout");
+#ifdef ES_TICKLESS_IDLE
+    Check(NumWakeups <= NumTimeoutTicks + NUM_TEST_TICKS / MAX_SLEEP_TICKS + 1,
+        "woken only for a timeout or at the end of the longest sleep");
+#else
+    Check(NumWakeups == NUM_TEST_TICKS, "woken on every tick");
+#endif
+    printf("%-36s %lu ticks/s, %lu.%02lu wakeups/s\n", IdleCases[i].Name,
+        (unsigned long)TICKS_PER_SECOND,
+        (unsigned long)(NumWakeups / NUM_TEST_SECONDS),
+        (unsigned long)((NumWakeups * 100u / NUM_TEST_SECONDS) % 100u));
+    for (j = 0; j < MAX_CASE_TIMERS; j++)
+    {
+      ES_Timer_StopTimer(j);
+    }
+    TimedOut = 0;
+  }
+  printf("%lu errors\n", (unsigned long)Errors);
+  return Errors != 0;
+}
+#endif
+
 /*------------------------------- Footnotes -------------------------------*/
 /*------------------------------ End of file ------------------------------*/
 
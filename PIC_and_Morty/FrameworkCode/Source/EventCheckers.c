@@ -127,6 +127,10 @@ bool Check4Keystroke(void)
         PostAnsibleMain(ThisEvent);
       //  ES_PostList00(ThisEvent);
     }
+    else if (ThisEvent.EventParam == 'l')   // link use & latencies
+    {
+        PrintCtrlStats();
+    }
     /* else if (ThisEvent.EventParam == 'c')
     {
       ThisEvent.EventType = ES_CONNECTIONEST; 
@@ -26,13 +26,11 @@
 #define AK8963_CNTL1                0x0A
 #define AK8963_CNTL2                0x0B
 
-// Stative Variables to store IMU Readings 
-static uint16_t accel_x;
-static uint16_t accel_y;
-static uint16_t accel_z;
-static uint16_t gyro_x;
-static uint16_t gyro_y;
-static uint16_t gyro_z;
+// The sample being read in, a byte at a time, by SPI_IntResponse. Once all
+// twelve bytes are in it is written to SampleBox as a whole, so the getters
+// never see one axis half updated or the axes from different reads
+static IMU_Sample_t NewSample;
+ES_MAILBOX(SampleBox, IMU_Sample_t);
 
 // For storing current read state 
 typedef enum {  ACC_X_HIGH,
@@ -255,7 +253,8 @@ ES_Event_t RunIMU(ES_Event_t ThisEvent)
      
  Description
     Function that runs when EOT timeout is detected. Assigns the new byte to 
-    module level variable "byteIn"
+    module level variable "byteIn" and puts it in its place in NewSample,
+    the last byte of a set writes the sample to SampleBox
 ****************************************************************************/
 void SPI_IntResponse ( void )
 {
@@ -267,40 +266,42 @@ void SPI_IntResponse ( void )
     switch (CurrentState)
     {
         case ACC_X_HIGH:
-            accel_x = (accel_x & 0x00FF) | (byteIn << 8);
+            NewSample.accel_x = (NewSample.accel_x & 0x00FF) | (byteIn << 8);
             break;
         case ACC_X_LOW:
-            accel_x = (accel_x & 0xFF00) | (byteIn & 0x00FF);
+            NewSample.accel_x = (NewSample.accel_x & 0xFF00) | (byteIn & 0x00FF);
             break;
         case ACC_Y_HIGH:
-            accel_y = (accel_x & 0x00FF) | (byteIn << 8);
+            NewSample.accel_y = (NewSample.accel_y & 0x00FF) | (byteIn << 8);
             break;
         case ACC_Y_LOW:
-            accel_y = (accel_y & 0xFF00) | (byteIn & 0x00FF);
+            NewSample.accel_y = (NewSample.accel_y & 0xFF00) | (byteIn & 0x00FF);
             break;
         case ACC_Z_HIGH:
-            accel_z = (accel_x & 0x00FF) | (byteIn << 8);
+            NewSample.accel_z = (NewSample.accel_z & 0x00FF) | (byteIn << 8);
             break;
         case ACC_Z_LOW:
-            accel_z = (accel_z & 0xFF00) | (byteIn & 0x00FF);
+            NewSample.accel_z = (NewSample.accel_z & 0xFF00) | (byteIn & 0x00FF);
             break;
         case GYR_X_HIGH:
-            gyro_x = (gyro_x & 0x00FF) | (byteIn << 8);
+            NewSample.gyro_x = (NewSample.gyro_x & 0x00FF) | (byteIn << 8);
             break;
         case GYR_X_LOW:
-            gyro_x = (gyro_x & 0xFF00) | (byteIn & 0x00FF);
+            NewSample.gyro_x = (NewSample.gyro_x & 0xFF00) | (byteIn & 0x00FF);
             break;
         case GYR_Y_HIGH:
-            gyro_y = (gyro_y & 0x00FF) | (byteIn << 8);
+            NewSample.gyro_y = (NewSample.gyro_y & 0x00FF) | (byteIn << 8);
             break;
         case GYR_Y_LOW:
-            gyro_y = (gyro_y & 0xFF00) | (byteIn & 0x00FF);
+            NewSample.gyro_y = (NewSample.gyro_y & 0xFF00) | (byteIn & 0x00FF);
             break;
         case GYR_Z_HIGH:
-            gyro_z = (gyro_z & 0x00FF) | (byteIn << 8);
+            NewSample.gyro_z = (NewSample.gyro_z & 0x00FF) | (byteIn << 8);
             break;
         case GYR_Z_LOW:
-            gyro_z = (gyro_z & 0xFF00) | (byteIn & 0x00FF);
+            NewSample.gyro_z = (NewSample.gyro_z & 0xFF00) | (byteIn & 0x00FF);
+            // last byte of the set, hand the whole sample over
+            ES_Mailbox_Write(&SampleBox, &NewSample);
             break;
     }
 }
@@ -443,34 +444,66 @@ static void IMU_SPI_Init( void )
 
 }
 
+/****************************************************************************
+ Function
+     get_imu_sample
+
+ Parameters
+     IMU_Sample_t * : where to put the latest complete sample
+
+ Returns
+     uint32_t, the number of samples read so far, 0 before the first one
+     is complete (the sample is all zeros then)
+
+ Description
+    Gives all six axes from the same read of the IMU, the single axis
+    getters below each take their own copy
+****************************************************************************/
+uint32_t get_imu_sample( IMU_Sample_t *pSample )
+{
+    return ES_Mailbox_Read(&SampleBox, pSample);
+}
+
 uint16_t get_accel_x( void )
 {
-    return accel_x; 
+    IMU_Sample_t Sample;
+    ES_Mailbox_Read(&SampleBox, &Sample);
+    return Sample.accel_x; 
 }
 
 uint16_t get_accel_y( void )
 {
-    return accel_y;   
+    IMU_Sample_t Sample;
+    ES_Mailbox_Read(&SampleBox, &Sample);
+    return Sample.accel_y;   
 }
 
 uint16_t get_accel_z( void )
 {
-    return accel_z;    
+    IMU_Sample_t Sample;
+    ES_Mailbox_Read(&SampleBox, &Sample);
+    return Sample.accel_z;    
 }
 
 uint16_t get_gyro_x( void )
 {
-    return gyro_x;
+    IMU_Sample_t Sample;
+    ES_Mailbox_Read(&SampleBox, &Sample);
+    return Sample.gyro_x;
 }
 
 
 uint16_t get_gyro_y( void )
 {
-    return gyro_y; 
+    IMU_Sample_t Sample;
+    ES_Mailbox_Read(&SampleBox, &Sample);
+    return Sample.gyro_y; 
 }
 
 
 uint16_t get_gyro_z( void )
 {
-    return gyro_z;
+    IMU_Sample_t Sample;
+    ES_Mailbox_Read(&SampleBox, &Sample);
+    return Sample.gyro_z;
 }
@@ -12,6 +12,8 @@
 
 #include "SensorUpdate.h"
 #include "IMU_SPI.h"
+#include "AnsibleMain.h"
+#include "ES_Fsm.h"
 
 #define MAX_AD              4095                // for AD readings 
 #define DEBOUNCE_TIME        100                // ms 
@@ -41,12 +43,16 @@
 
 // Port E
 #define SF_PIN            BIT3HI                // special function
+
+#define ADC_SAMPLE_PERIOD_US 1000               // A/D runs at 1kHz on its own
     
 static const float IMU_scaler = 17000.0;    
     
     
 static uint8_t MyPriority;
-static uint8_t updateInterval = 100;      // milliseconds (10 Hz refresh rate)
+// milliseconds (50 Hz refresh rate), AnsibleMain decides from each update
+// whether there is anything worth sending
+static uint8_t updateInterval = 20;
 
 static uint8_t boatNumber = 6;            // start at 6 (our team)
 static const uint8_t maxBoatNumber = 11; 
@@ -59,6 +65,23 @@ static uint8_t control = 0x00;
 
 // ------------- Private Functions ------------
 static void InitIOC( void );
+static void UpdateReadings( ES_Event_t ThisEvent );
+static void RearmEncoder( ES_Event_t ThisEvent );
+static ES_Event_t UnexpectedEvent( ES_Event_t ThisEvent );
+
+// a single state, the timers pick what to do, anything else is an error
+#define SENSOR_UPDATE_STATES(ES_FSM_STATE) \
+  ES_FSM_STATE(Updating)
+
+#define SENSOR_UPDATE_TRANSITIONS(ES_FSM_TRANSITION) \
+  ES_FSM_TRANSITION(Updating, ES_TIMEOUT, SENSOR_UPDATE_TIMER, NULL, \
+    UpdateReadings, ES_FSM_SAME_STATE) \
+  ES_FSM_TRANSITION(Updating, ES_TIMEOUT, DEBOUNCE_TIMER, NULL, \
+    RearmEncoder, ES_FSM_SAME_STATE)
+
+typedef enum { SENSOR_UPDATE_STATES(ES_FSM_STATE_NAME) } SensorUpdateState_t;
+ES_FSM_DEFINE(SensorUpdateFsm, SENSOR_UPDATE_STATES,
+    SENSOR_UPDATE_TRANSITIONS, Updating, UnexpectedEvent);
 
 /****************************************************************************
  Function
@@ -109,11 +132,14 @@ bool InitSensorUpdate( uint8_t Priority )
     // PE1 - turret (pitch)
     // PE2 - turret (yaw) 
     ADC_MultiInit(3);    
+    // sample in the background, each update takes the latest set
+    ADC_MultiStartContinuous(ADC_SAMPLE_PERIOD_US);
     HWREG(GPIO_PORTE_BASE+GPIO_O_DEN) |= SF_PIN; // Digital Enable
     HWREG(GPIO_PORTE_BASE+GPIO_O_DIR) &= ~SF_PIN; // Set input (clear bit)
     
 
-	if (ES_Timer_InitTimer(SENSOR_UPDATE_TIMER, updateInterval) == ES_Timer_OK)  
+	if ((ES_Fsm_Init(&SensorUpdateFsm) == true) &&
+        (ES_Timer_InitTimer(SENSOR_UPDATE_TIMER, updateInterval) == ES_Timer_OK))  
     {
         returnValue = true;
     } 
@@ -156,96 +182,7 @@ bool PostSensorUpdate( ES_Event_t ThisEvent)
 ****************************************************************************/
 ES_Event_t RunSensorUpdate( ES_Event_t ThisEvent )
 {
-	//Create ES_Event ReturnEvent
-    ES_Event_t ReturnEvent;
-    ReturnEvent.EventType = ES_NO_EVENT;
-
-	if (ThisEvent.EventType == ES_TIMEOUT && ThisEvent.EventParam == SENSOR_UPDATE_TIMER)
-    {
-		// Update all the sensor readings 
-		ES_Timer_InitTimer(SENSOR_UPDATE_TIMER, updateInterval);
-
-        //read AD value 
-        uint32_t analogIn[3]; // to store AD value      
-        ADC_MultiRead(analogIn);
-      
-       // printf("\r\n raw throttle: %i", raw_throttle);  
-        throttle = ((146*analogIn[0])/MAX_AD); 
-      
-        //  printf("\r\nthrottle: %i", (int) throttle);  
-      
-        if (throttle > 128)
-        {
-          throttle = 128; 
-        }
-        
-        if (throttle < THROTTLE_DEAD_BAND)
-        {
-            throttle = 0;
-        }
-        
-
-        if ( HWREG(GPIO_PORTC_BASE+(GPIO_O_DATA + ALL_BITS)) & MOTOR_DIR_PIN )
-        {
-            throttle = 127 + throttle;
-        }
-        else
-        {
-            throttle = 128 - throttle;
-        }
-         
-        
-        // set throttle deadband 
-        if ((throttle < THROTTLE_DEAD_HIGH) && (throttle > THROTTLE_DEAD_LOW))
-        {
-            throttle = 127; 
-        }
-        
-        // cap throttle values 
-        if (throttle > 250)
-        {
-            throttle = 255;
-        }
-           
-        yaw = 255*((MAX_AD - analogIn[1])/(MAX_AD + 0.0));   
-        pitch = 255*((MAX_AD - analogIn[2])/(MAX_AD + 0.0));   
-
-        // fill up control byte        
-        control = 0x00; 
-        if (!(HWREG(GPIO_PORTC_BASE+(GPIO_O_DATA + ALL_BITS)) & SHOOT_PIN))
-        {
-            control |= BIT0HI; 
-        }
-        
-        // BIT1 Self refuel -- if momentary, may want to be posting event 
-        if (HWREG(GPIO_PORTD_BASE+(GPIO_O_DATA + ALL_BITS)) & REFUEL_PIN)
-        {
-            control |= BIT1HI; 
-        }
-    
-        // Bit 2 special function 
-        if (HWREG(GPIO_PORTE_BASE+(GPIO_O_DATA + ALL_BITS)) & SF_PIN)
-        {
-            control |= BIT2HI; 
-        }
-        
-        
-        #ifdef SENSOR_DEBUG
-           printf("\r\n Boat Number: %i, Throttle: %i, Yaw: %i, Pitch: %i, Control: %x, Steering: %u", boatNumber, getThrottle(), yaw, pitch, control, getSteering());
-        #endif 
-
-
-	}
-    else if (ThisEvent.EventType == ES_TIMEOUT && ThisEvent.EventParam == DEBOUNCE_TIMER)
-    {
-        HWREG(GPIO_PORTA_BASE+GPIO_O_ICR) |= ENCODER_A;         // W1C 
-        HWREG(GPIO_PORTA_BASE+GPIO_O_IM) |= ENCODER_A;          // unmask
-    }
-    else
-    {
-		ReturnEvent.EventType = ES_ERROR;
-    }
-	return ReturnEvent;
+    return ES_Fsm_Dispatch(&SensorUpdateFsm, ThisEvent);
 }
 
 /****************************************************************************
@@ -335,24 +272,27 @@ void Encoder_IOC_Response( void )
         // clear the source of the interupt, p. 670 
         HWREG(GPIO_PORTA_BASE+GPIO_O_ICR) |= ENCODER_A; // W1C 
         //printf("p");
-        // read encoder channel B 
+        // read encoder channel B, working on a copy so that getBoatNumber
+        // never sees the number before it has been wrapped
+        uint8_t newBoatNumber = boatNumber;
         if (HWREG(GPIO_PORTA_BASE+(GPIO_O_DATA + ALL_BITS)) & ENCODER_B)
         {
-            boatNumber++;
+            newBoatNumber++;
         }
         else
         {
-            boatNumber--;
+            newBoatNumber--;
         }
 
-        if (boatNumber > maxBoatNumber)
+        if (newBoatNumber > maxBoatNumber)
         {
-            boatNumber = 1;
+            newBoatNumber = 1;
         }    
-        else if (boatNumber == 0)
+        else if (newBoatNumber == 0)
         {
-            boatNumber = maxBoatNumber; 
+            newBoatNumber = maxBoatNumber; 
         }
+        boatNumber = newBoatNumber;     // a single byte store, can't tear
         
     }
 }
@@ -425,3 +365,143 @@ static void InitIOC( void )
     // globally enable interupts 
     __enable_irq();     
 }
+
+/****************************************************************************
+ Function
+     UpdateReadings
+
+ Parameters
+     ES_Event_t : the SENSOR_UPDATE_TIMER timeout
+
+ Returns
+     none
+
+ Description
+     Takes a new set of readings from the A/D, the IMU and the switches,
+     starts the timer for the next update and tells AnsibleMain
+
+****************************************************************************/
+static void UpdateReadings( ES_Event_t ThisEvent )
+{
+    (void)ThisEvent;
+    // Update all the sensor readings 
+    ES_Timer_InitTimer(SENSOR_UPDATE_TIMER, updateInterval);
+
+    //read AD value, there is no set to read until the first conversion
+    //is done, so keep the neutral throttle, yaw & pitch until then
+    uint32_t analogIn[3]; // to store AD value      
+    if (ADC_MultiLatest(analogIn) != 0)
+    {
+      
+           // printf("\r\n raw throttle: %i", raw_throttle);  
+        throttle = ((146*analogIn[0])/MAX_AD); 
+      
+        //  printf("\r\nthrottle: %i", (int) throttle);  
+      
+        if (throttle > 128)
+        {
+          throttle = 128; 
+        }
+    
+        if (throttle < THROTTLE_DEAD_BAND)
+        {
+            throttle = 0;
+        }
+    
+
+        if ( HWREG(GPIO_PORTC_BASE+(GPIO_O_DATA + ALL_BITS)) & MOTOR_DIR_PIN )
+        {
+            throttle = 127 + throttle;
+        }
+        else
+        {
+            throttle = 128 - throttle;
+        }
+     
+    
+        // set throttle deadband 
+        if ((throttle < THROTTLE_DEAD_HIGH) && (throttle > THROTTLE_DEAD_LOW))
+        {
+            throttle = 127; 
+        }
+    
+        // cap throttle values 
+        if (throttle > 250)
+        {
+            throttle = 255;
+        }
+       
+        yaw = 255*((MAX_AD - analogIn[1])/(MAX_AD + 0.0));   
+        pitch = 255*((MAX_AD - analogIn[2])/(MAX_AD + 0.0));   
+    }
+
+    // fill up control byte        
+    control = 0x00; 
+    if (!(HWREG(GPIO_PORTC_BASE+(GPIO_O_DATA + ALL_BITS)) & SHOOT_PIN))
+    {
+        control |= BIT0HI; 
+    }
+    
+    // BIT1 Self refuel -- if momentary, may want to be posting event 
+    if (HWREG(GPIO_PORTD_BASE+(GPIO_O_DATA + ALL_BITS)) & REFUEL_PIN)
+    {
+        control |= BIT1HI; 
+    }
+    
+    // Bit 2 special function 
+    if (HWREG(GPIO_PORTE_BASE+(GPIO_O_DATA + ALL_BITS)) & SF_PIN)
+    {
+        control |= BIT2HI; 
+    }
+    
+    
+    ES_Event_t UpdatedEvent;
+    UpdatedEvent.EventType = ES_CONTROLS_UPDATED;
+    UpdatedEvent.EventParam = 0;
+    PostAnsibleMain(UpdatedEvent);
+
+    #ifdef SENSOR_DEBUG
+       printf("\r\n Boat Number: %i, Throttle: %i, Yaw: %i, Pitch: %i, Control: %x, Steering: %u", boatNumber, getThrottle(), yaw, pitch, control, getSteering());
+    #endif
+}
+
+/****************************************************************************
+ Function
+     RearmEncoder
+
+ Parameters
+     ES_Event_t : the DEBOUNCE_TIMER timeout
+
+ Returns
+     none
+
+ Description
+     Lets the boat select dial interrupt in again once it has settled
+
+****************************************************************************/
+static void RearmEncoder( ES_Event_t ThisEvent )
+{
+    (void)ThisEvent;
+    HWREG(GPIO_PORTA_BASE+GPIO_O_ICR) |= ENCODER_A;         // W1C 
+    HWREG(GPIO_PORTA_BASE+GPIO_O_IM) |= ENCODER_A;          // unmask
+}
+
+/****************************************************************************
+ Function
+     UnexpectedEvent
+
+ Parameters
+     ES_Event_t : an event that no transition took
+
+ Returns
+     ES_Event_t, ES_ERROR
+
+ Description
+     Default handler for SensorUpdateFsm
+
+****************************************************************************/
+static ES_Event_t UnexpectedEvent( ES_Event_t ThisEvent )
+{
+    ThisEvent.EventType = ES_ERROR;
+    return ThisEvent;
+}
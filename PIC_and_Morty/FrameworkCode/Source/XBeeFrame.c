@@ -0,0 +1,490 @@
+/****************************************************************************
+ Module
+   XBeeFrame.c
+
+ Revision
+   1.0.1
+
+ Description
+   Takes XBee API frames (0x7E, length MSB, length LSB, frame data, check
+   sum) apart a byte at a time from inside the UART receive interrupt, and
+   posts one FRAME_RECEIVED event for each frame whose check sum is good.
+
+ Notes
+   The frame data goes straight into a block from the event pools, the
+   event's EventParam is its handle, so the service gets the frame data with
+   ES_Pool_GetPtr and ES_Pool_GetLength and the framework frees the block
+   when the service's run function is done with it.
+
+   There are no timers. The time of each byte is kept, and a frame that
+   goes quiet for more than MaxGap ticks part way through is dropped, so
+   the byte after the gap can start a new one.
+
+   The same file is in the ANSIBLE and the SHIP projects, keep them the same.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/18/26 00:30         started coding, replaces the per byte state machines
+                        in AnsibleReceive.c and SHIP_RX.c
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "XBeeFrame.h"
+#include "ES_Port.h"
+#include <string.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+// 100 bytes of RF data, plus the API identifier, source address, RSSI and
+// options of a 16 bit address receive frame
+#define XBEE_MAX_FRAME_DATA 105
+
+// where a parser is in the frame
+#define HUNTING   0   // for the start delimiter
+#define LEN_MSB   1
+#define LEN_LSB   2
+#define DATA      3
+#define CHECKSUM  4
+#define SKIPPING  5   // a frame that there was no room for
+
+/*---------------------------- Module Functions ---------------------------*/
+static void Abandon(XBeeFrameParser_t *pParser);
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     XBeeFrame_Init
+
+ Parameters
+     XBeeFrameParser_t * : the parser to set up
+     XBeeFramePost_t * : the post function for the FRAME_RECEIVED events
+     uint16_t : ES_Timer ticks allowed between the bytes of a frame
+
+ Returns
+     nothing
+
+ Description
+     gets a parser ready to look for a start delimiter, with its counts
+     cleared
+
+ Notes
+     call with the UART receive interrupt off
+
+ Author
+     10/18/26
+****************************************************************************/
+void XBeeFrame_Init(XBeeFrameParser_t *pParser, XBeeFramePost_t *pPost,
+    uint16_t MaxGap)
+{
+  if ((pParser->State != HUNTING) && (pParser->Handle != ES_POOL_NO_HANDLE))
+  {
+    ES_Pool_Release(pParser->Handle);
+  }
+  memset(pParser, 0, sizeof(*pParser));
+  pParser->pPost = pPost;
+  pParser->MaxGap = MaxGap;
+  pParser->State = HUNTING;
+  pParser->Handle = ES_POOL_NO_HANDLE;
+}
+
+/****************************************************************************
+ Function
+     XBeeFrame_ParseByte
+
+ Parameters
+     XBeeFrameParser_t * : the parser for the UART that the byte came from
+     uint8_t : the byte
+
+ Returns
+     nothing
+
+ Description
+     moves the parser along by one byte, and posts FRAME_RECEIVED when the
+     byte is the good check sum of a frame
+
+ Notes
+     called from the UART receive interrupt, once for each byte in the FIFO.
+     Frames with a bad length or check sum are counted and dropped
+
+ Author
+     10/18/26
+****************************************************************************/
+void XBeeFrame_ParseByte(XBeeFrameParser_t *pParser, uint8_t Byte)
+{
+  ES_Event_t  ThisEvent;
+  uint16_t    Now = ES_Timer_GetTime();
+
+  if ((pParser->State != HUNTING) &&
+      ((uint16_t)(Now - pParser->LastTime) > pParser->MaxGap))
+  {
+    Abandon(pParser);
+    pParser->Stats.Timeouts++;
+  }
+  pParser->LastTime = Now;
+
+  switch (pParser->State)
+  {
+    case HUNTING:
+      if (Byte == XBEE_START_DELIMITER)
+      {
+        pParser->State = LEN_MSB;
+      }
+      else
+      {
+        pParser->Stats.Discarded++;
+      }
+      break;
+
+    case LEN_MSB:
+      pParser->Length = (uint16_t)Byte << 8;
+      pParser->State = LEN_LSB;
+      break;
+
+    case LEN_LSB:
+      pParser->Length |= Byte;
+      pParser->Count = 0;
+      if ((pParser->Length == 0) || (pParser->Length > XBEE_MAX_FRAME_DATA))
+      {
+        // can't trust the length to skip by, look for the next start
+        pParser->Stats.BadLengths++;
+        pParser->State = HUNTING;
+        break;
+      }
+      pParser->Handle = ES_Pool_Alloc(pParser->Length);
+      if (pParser->Handle == ES_POOL_NO_HANDLE)
+      {
+        pParser->Stats.NoBuffers++;
+        pParser->State = SKIPPING;
+        break;
+      }
+      pParser->pData = ES_Pool_GetPtr(pParser->Handle);
+      pParser->Sum = 0;
+      pParser->State = DATA;
+      break;
+
+    case DATA:
+      pParser->pData[pParser->Count++] = Byte;
+      pParser->Sum += Byte;
+      if (pParser->Count == pParser->Length)
+      {
+        pParser->State = CHECKSUM;
+      }
+      break;
+
+    case CHECKSUM:
+      // the frame data and the check sum add up to 0xFF
+      if ((uint8_t)(pParser->Sum + Byte) != 0xFF)
+      {
+        pParser->Stats.BadChecksums++;
+      }
+      else
+      {
+        ThisEvent.EventType = FRAME_RECEIVED;
+        ThisEvent.EventParam = pParser->Handle;
+        if (pParser->pPost(ThisEvent) == true)
+        {
+          pParser->Stats.Frames++;
+        }
+        else
+        {
+          pParser->Stats.NoBuffers++;
+        }
+      }
+      // the queue holds its own reference now, if the post went
+      Abandon(pParser);
+      break;
+
+    case SKIPPING:
+      // the frame data, then the check sum
+      if (++pParser->Count > pParser->Length)
+      {
+        pParser->State = HUNTING;
+      }
+      break;
+  }
+}
+
+/****************************************************************************
+ Function
+     XBeeFrame_GetStats
+
+ Parameters
+     XBeeFrameParser_t const * : the parser to look at
+
+ Returns
+     XBeeFrameStats_t const * : its counts
+
+ Description
+     for debugging, the counts of frames taken and thrown away
+
+ Author
+     10/18/26
+****************************************************************************/
+XBeeFrameStats_t const *XBeeFrame_GetStats(XBeeFrameParser_t const *pParser)
+{
+  return &pParser->Stats;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+/****************************************************************************
+ Function
+     Abandon
+
+ Description
+     lets go of the parser's block, if it has one, and goes back to looking
+     for a start delimiter
+****************************************************************************/
+static void Abandon(XBeeFrameParser_t *pParser)
+{
+  if (pParser->Handle != ES_POOL_NO_HANDLE)
+  {
+    ES_Pool_Release(pParser->Handle);
+    pParser->Handle = ES_POOL_NO_HANDLE;
+  }
+  pParser->State = HUNTING;
+}
+
+#if defined(TEST) && defined(ES_PORT_POSIX)
+/*
+  Host fuzz test of the parser on its own. The pools come from ES_Pool.c,
+  built without TEST so that its own test is left out:
+  gcc -DES_PORT_POSIX -IHeaders -c Source/ES_Pool.c
+  gcc -DTEST -DES_PORT_POSIX -IHeaders Source/XBeeFrame.c ES_Pool.o
+
+  Streams of good frames are mixed with frames that have a byte changed,
+  noise, frames cut off by a gap and refused posts. Every good frame that
+  is not cut off or refused must come out once, in order and unchanged,
+  nothing else may come out, and every block must be back in its pool at
+  the end. Then plain random bytes are thrown at it, where only the check
+  sums of what comes out and the blocks can be checked.
+*/
+#include <stdio.h>
+
+#define NUM_TEST_ITEMS  200000UL
+#define TEST_MAX_GAP    5
+#define MAX_EXPECTED    8
+
+typedef struct
+{
+  uint8_t   Data[XBEE_MAX_FRAME_DATA];
+  uint16_t  Length;
+} TestFrame_t;
+
+uint32_t _PRIMASK_temp;
+static uint16_t FakeTime;
+
+static XBeeFrameParser_t Parser;
+static TestFrame_t  Expected[MAX_EXPECTED];
+static uint8_t      NumExpected;
+static bool         RefusePost;
+static bool         CheckContent = true;
+static uint32_t     Posted;
+static uint32_t     Errors;
+static uint32_t     RandomState = 12345;
+
+uint32_t CPUgetPRIMASK_cpsid(void)
+{
+  return 0;
+}
+
+void CPUsetPRIMASK(uint32_t newPRIMASK)
+{
+  (void)newPRIMASK;
+}
+
+uint16_t ES_Timer_GetTime(void)
+{
+  return FakeTime;
+}
+
+static uint32_t Random(void)
+{
+  RandomState ^= RandomState << 13;
+  RandomState ^= RandomState >> 17;
+  RandomState ^= RandomState << 5;
+  return RandomState;
+}
+
+static void Check(bool Condition, char const *pWhat)
+{
+  if (Condition != true)
+  {
+    if (Errors < 10)
+    {
+      printf("FAILED: %s\n", pWhat);
+    }
+    Errors++;
+  }
+}
+
+static bool TestPost(ES_Event_t ThisEvent)
+{
+  uint8_t   *pData = ES_Pool_GetPtr(ThisEvent.EventParam);
+  uint16_t  Length = ES_Pool_GetLength(ThisEvent.EventParam);
+
+  Check(ThisEvent.EventType == FRAME_RECEIVED, "event type");
+  Check(pData != NULL, "posted handle has a block");
+  if ((pData == NULL) || RefusePost)
+  {
+    return false;
+  }
+  Posted++;
+  if (CheckContent)
+  {
+    Check(NumExpected > 0, "frame that was not sent");
+    if (NumExpected > 0)
+    {
+      Check((Length == Expected[0].Length) &&
+          (memcmp(pData, Expected[0].Data, Length) == 0), "frame content");
+      NumExpected--;
+      memmove(&Expected[0], &Expected[1], NumExpected * sizeof(Expected[0]));
+    }
+  }
+  Check((Length > 0) && (Length <= XBEE_MAX_FRAME_DATA), "frame length");
+  return true;
+}
+
+static void Feed(uint8_t const *pBytes, uint16_t NumBytes)
+{
+  while (NumBytes-- > 0)
+  {
+    XBeeFrame_ParseByte(&Parser, *pBytes++);
+  }
+}
+
+// a good frame of random length & data, 0x7E is allowed in the data
+static uint16_t MakeFrame(uint8_t *pOut, TestFrame_t *pFrame)
+{
+  uint8_t   Sum = 0;
+  uint16_t  i;
+
+  pFrame->Length = 1 + Random() % XBEE_MAX_FRAME_DATA;
+  pOut[0] = XBEE_START_DELIMITER;
+  pOut[1] = pFrame->Length >> 8;
+  pOut[2] = pFrame->Length & 0xFF;
+  for (i = 0; i < pFrame->Length; i++)
+  {
+    pFrame->Data[i] = Random();
+    pOut[3 + i] = pFrame->Data[i];
+    Sum += pFrame->Data[i];
+  }
+  pOut[3 + i] = 0xFF - Sum;
+  return pFrame->Length + 4;
+}
+
+static void CheckPoolsEmpty(char const *pWhat)
+{
+  ES_PoolStats_t  Stats;
+  uint8_t         Class;
+
+  for (Class = 0; ES_Pool_GetStats(Class, &Stats); Class++)
+  {
+    Check(Stats.InUse == 0, pWhat);
+  }
+}
+
+int main(void)
+{
+  uint8_t         Bytes[XBEE_MAX_FRAME_DATA + 4];
+  TestFrame_t     Frame;
+  ES_PoolHandle_t Held[16];
+  uint8_t         NumHeld = 0;
+  uint16_t        Length;
+  uint32_t        Sent = 0;
+  uint32_t        Item;
+  uint16_t        Cut;
+  uint8_t         i;
+
+  ES_Pool_Init();
+  XBeeFrame_Init(&Parser, TestPost, TEST_MAX_GAP);
+
+  for (Item = 0; Item < NUM_TEST_ITEMS; Item++)
+  {
+    Length = MakeFrame(Bytes, &Frame);
+    switch (Random() % 6)
+    {
+      case 0:   // a byte of the data or check sum changed
+        Bytes[3 + Random() % (Length - 3)] ^= 1 + Random() % 255;
+        Feed(Bytes, Length);
+        break;
+
+      case 1:   // noise, with no start delimiters in it
+        for (i = 0; i < 20; i++)
+        {
+          Bytes[i] = Random() % 0x7E;
+        }
+        Feed(Bytes, 1 + Random() % 20);
+        break;
+
+      case 2:   // cut off part way through, then quiet for too long
+        Cut = 1 + Random() % (Length - 1);
+        Feed(Bytes, Cut);
+        FakeTime += TEST_MAX_GAP + 1;
+        break;
+
+      case 3:   // the post is refused
+        RefusePost = true;
+        Feed(Bytes, Length);
+        RefusePost = false;
+        break;
+
+      default:  // good, with a short gap before it
+        FakeTime += Random() % (TEST_MAX_GAP + 1);
+        Expected[NumExpected++] = Frame;
+        Sent++;
+        Feed(Bytes, Length);
+        Check(NumExpected == 0, "good frame lost");
+        NumExpected = 0;
+        break;
+    }
+  }
+  Check(Posted == Sent, "count of good frames");
+  CheckPoolsEmpty("block left in use");
+
+  // with every block in use a frame is skipped, and the next one is fine
+  while ((NumHeld < 16) &&
+      ((Held[NumHeld] = ES_Pool_Alloc(1)) != ES_POOL_NO_HANDLE))
+  {
+    NumHeld++;
+  }
+  Length = MakeFrame(Bytes, &Frame);
+  Feed(Bytes, Length);
+  Check(XBeeFrame_GetStats(&Parser)->NoBuffers > 0, "frame with no block");
+  for (i = 0; i < NumHeld; i++)
+  {
+    ES_Pool_Release(Held[i]);
+  }
+  Length = MakeFrame(Bytes, &Frame);
+  Expected[NumExpected++] = Frame;
+  Feed(Bytes, Length);
+  Check(NumExpected == 0, "frame after running out of blocks");
+
+  // plain random bytes
+  CheckContent = false;
+  for (Item = 0; Item < 20 * NUM_TEST_ITEMS; Item++)
+  {
+    XBeeFrame_ParseByte(&Parser, Random());
+    if ((Item & 0x3FF) == 0)
+    {
+      FakeTime += Random() % (2 * TEST_MAX_GAP);
+    }
+  }
+  FakeTime += TEST_MAX_GAP + 1;
+  XBeeFrame_ParseByte(&Parser, 0);
+  CheckPoolsEmpty("block left in use after noise");
+  Check(Parser.Stats.Frames == Posted, "count of frames posted");
+
+  printf("%lu good frames sent, %lu taken, stats: %lu frames, %lu bad sums, "
+      "%lu bad lengths, %lu no buffer, %lu timeouts, %lu discarded\n",
+      (unsigned long)Sent, (unsigned long)Posted,
+      (unsigned long)Parser.Stats.Frames,
+      (unsigned long)Parser.Stats.BadChecksums,
+      (unsigned long)Parser.Stats.BadLengths,
+      (unsigned long)Parser.Stats.NoBuffers,
+      (unsigned long)Parser.Stats.Timeouts,
+      (unsigned long)Parser.Stats.Discarded);
+  printf("%lu errors\n", (unsigned long)Errors);
+  return (Errors == 0) ? 0 : 1;
+}
+#endif /* TEST */
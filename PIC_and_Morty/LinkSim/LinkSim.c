@@ -0,0 +1,1155 @@
+/****************************************************************************
+ Module
+   LinkSim.c
+
+ Revision
+   1.0.1
+
+ Description
+   A host simulation of the XBee link between ANSIBLEs and SHIPs, for
+   measuring pairing time, control round trip time and failover, and as a
+   regression check on the link code. The ANSIBLE and SHIP firmware runs as
+   it is, one copy per board, in one process; the XBee radios and the air
+   between them are modelled here.
+
+ Notes
+   Each board is a shared library: the firmware, the framework,
+   ES_PortPOSIX.c, SimBoard.c and SimAnsible.c or SimShip.c, built against
+   the host inc/hw_types.h in this directory (see SimBoard.h). From
+   PIC_and_Morty, with TIVAWARE the TivaWare install for the other inc/
+   headers and driverlib/:
+
+   F=FrameworkCode/Source; S=Ship/Source
+   ES="ES_Framework.c ES_Timers.c ES_Queue.c ES_LookupTables.c
+       ES_PostList.c ES_CheckEvents.c ES_DeferRecall.c ES_Pool.c ES_Fsm.c
+       ES_PortPOSIX.c XBeeFrame.c XBeeCodec.c"
+   SO="-std=gnu99 -O2 -fPIC -shared -Wl,-Bsymbolic -DES_PORT_POSIX -ILinkSim"
+   gcc $SO -IFrameworkCode/Headers -I$TIVAWARE -o ansible.so
+       LinkSim/SimBoard.c LinkSim/SimAnsible.c $F/AnsibleMain.c
+       $F/AnsibleReceive.c $F/AnsibleTransmit.c $(for f in $ES; do
+       echo $F/$f; done) -lpthread
+   gcc $SO -IShip/Headers -I$TIVAWARE -o ship.so
+       LinkSim/SimBoard.c LinkSim/SimShip.c $S/SHIP_MASTER.c $S/SHIP_RX.c
+       $S/SHIP_TX.c $S/Init_UART.c $S/MotorModule.c $S/PWMLibrary.c
+       $(for f in $ES; do echo $S/$f; done) -lpthread
+   gcc -std=gnu99 -O2 -IFrameworkCode/Headers -o linksim LinkSim/LinkSim.c
+       $F/XBeeCodec.c -ldl -lm
+
+   ./linksim ansible.so ship.so [options], -h lists them. A library loaded
+   twice with dlopen is the same library, so each board gets its own copy
+   of the image in a memfd and is loaded from that.
+
+   Time moves in 1mS steps, every board one ES_Timer tick at a time. The
+   radio times below are in uS, but a packet is handed to a board on the
+   tick it arrives in, and times measured at the boards are to the tick.
+
+   Radio
+   Each XBee is in API mode, as the boards expect. A transmit request to
+   an address goes over the air as an 802.15.4 frame: CSMA back off, 250
+   kbit/S, one channel shared by every board, then the ACK. A lost frame
+   or ACK is retried up to the retry count, the receiving XBee filters
+   out the repeats. Each try is lost with the drop probability, or for a
+   bit error at the bit error rate, or if it starts in the outage. The
+   receiver gets a received packet frame after the latency plus up to the
+   jitter, and the sender a TX status if the frame ID was not 0.
+
+   Operator
+   Each ANSIBLE has its boat dial set to a boat, ANSIBLE i to boat
+   (i % boats) + 1, and presses the pair button at the start, and again
+   whenever it has been unpaired for the re-press delay. All the boards
+   are on the red team, and the SHIPs have fuel unless -u. With -m the
+   throttle moves to a new place about every move period, a random time
+   between half and one and a half times it.
+
+   Measures
+   pair_ms      first press to paired, per ANSIBLE
+   rtt_ms       first byte of a CTRL out of an ANSIBLE to the last byte of
+                the next STATUS from its SHIP into it
+   recover_ms   link dropped to paired again
+   failover_ms  boat switch to paired with the new boat, for -w: the SHIP
+                ANSIBLE 0 is on goes off the air and its dial is turned to
+                the new boat, which it only reads when it is unpaired
+   outage_*     outage start to the first link drop, outage end to paired
+   actuate_ms   throttle moved to the last byte of a CTRL carrying it into
+                the SHIP, for -m
+   available    the time ANSIBLEs were paired, from their first pairing
+   air_busy     the time the channel carried frames or ACKs
+   ctrl_per_s   CTRL packets sent, per ANSIBLE per second
+   The exit status is 1 if an ANSIBLE never paired, a board stopped, a
+   UART overran or a -P or -R limit was passed, 2 for bad arguments.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/18/26 05:40         started coding
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "XBeeCodec.h"
+#include "SimBoard.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+#define MAX_ANSIBLES      8
+#define MAX_BOATS         11
+#define MAX_NODES         (MAX_ANSIBLES + MAX_BOATS)
+#define MAX_DELIVERIES    512
+
+#define US_PER_TICK       1000
+
+// addresses: SHIP n is 0x2180 + n, as in DestAddress in AnsibleTransmit.c
+#define SHIP_ADDRESS(Boat)      (0x2180 + (Boat))
+#define ANSIBLE_ADDRESS(Index)  (0x2101 + (Index))
+
+// the API frames the radio deals in, the rest are in XBeeCodec.h
+#define START_DELIMITER   0x7E
+#define API_TX_STATUS     0x89
+#define TX_SUCCESS        0x00
+#define TX_NO_ACK         0x01
+#define API_HEADER_SIZE   5       // API identifier to options
+#define MAX_API_FRAME     128
+#define RSSI              0x28    // -40dBm
+
+// the UART between each board and its XBee, 9600 baud, 10 bits a byte
+#define UART_BYTE_US      1042
+
+// 802.15.4 at 2.4GHz: 32uS a byte, 6 bytes of PHY header, 9 of MAC header
+// with 16 bit addresses and 2 of FCS, the ACK is 11 bytes all told
+#define AIR_BYTE_US       32
+#define AIR_OVERHEAD      17
+#define AIR_ACK_BYTES     11
+#define TURNAROUND_US     192
+#define BACKOFF_US        320
+#define MIN_BE            3
+#define ACK_WAIT_US       864
+
+// what the firmware runs in before the first pair button press, and the
+// spread of the first presses after it
+#define SETTLE_TICKS      100
+#define PRESS_SPREAD      200
+
+// the least a throttle move for -m goes, to be past any deadband
+#define MIN_MOVE          16
+#define STICK_RANGE       256
+
+/*---------------------------- Module Types -------------------------------*/
+typedef struct
+{
+  uint32_t  *pValues;
+  uint32_t  Count;
+  uint32_t  Size;
+} Samples_t;
+
+typedef struct
+{
+  // what the trial is
+  uint32_t  RunTicks;
+  uint32_t  Trials;
+  uint32_t  Seed;
+  uint8_t   NumBoats;
+  uint8_t   NumAnsibles;
+  uint32_t  LatencyUs;
+  uint32_t  JitterUs;
+  double    BitErrorRate;
+  double    DropRate;
+  uint8_t   Retries;
+  uint32_t  OutageStart;      // ticks, OutageLength 0 for none
+  uint32_t  OutageLength;
+  uint32_t  SwitchTick;       // ticks, SwitchBoat 0 for none
+  uint8_t   SwitchBoat;
+  uint32_t  RepressTicks;
+  uint32_t  MoveTicks;        // 0 for sticks that stay put
+  bool      Unfueled;
+  // the limits, 0 for none
+  uint32_t  MaxPairP95;
+  uint32_t  MaxRTTP95;
+  bool      Verbose;
+} Options_t;
+
+// one API frame coming together from a board's TX line
+typedef struct
+{
+  uint8_t   Data[MAX_API_FRAME];
+  uint16_t  Length;
+  uint16_t  Count;
+  uint8_t   State;
+  uint64_t  StartUs;
+} Splitter_t;
+
+typedef struct
+{
+  SimBoard_t const  *pBoard;
+  void              *pHandle;
+  int               FD;
+  bool              IsShip;
+  bool              OffAir;
+  uint16_t          Address;
+  Splitter_t        Splitter;
+  uint64_t          RadioFreeUs;    // when the XBee is done with the last send
+  uint64_t          RXLineFreeUs;   // when the UART into the board goes idle
+  // ANSIBLEs only
+  uint8_t           Boat;
+  SimLinkState_t    LastState;
+  uint32_t          PressAt;        // the next press, if still unpaired
+  uint32_t          PressTick;      // the first press, 0 for none yet
+  uint32_t          DropTick;       // 0 for not dropped
+  uint32_t          FirstPaired;    // 0 for not yet
+  bool              CtrlPending;
+  uint64_t          CtrlStartUs;
+  bool              SwitchPending;
+  uint32_t          MoveAt;
+  uint8_t           Throttle;
+  bool              MovePending;
+  uint64_t          MoveUs;
+  bool              OutageDropSeen;
+  bool              OutageRecoverPending;
+} Node_t;
+
+typedef struct
+{
+  uint64_t  DueUs;
+  uint8_t   To;
+  uint8_t   Length;
+  uint8_t   Bytes[MAX_API_FRAME];
+} Delivery_t;
+
+typedef enum
+{
+  RUN_OK,
+  RUN_NEVER_PAIRED,
+  RUN_STOPPED,
+  RUN_OVERRUN,
+  RUN_LOAD_FAILED
+} RunResult_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+static bool ParseOptions(int argc, char *argv[], Options_t *pOpt);
+static void Usage(char const *pName);
+static bool LoadImage(char const *pPath, uint8_t **ppImage, size_t *pSize);
+static bool LoadBoard(Node_t *pNode, uint8_t const *pImage, size_t Size);
+static void UnloadBoard(Node_t *pNode);
+static RunResult_t RunTrial(Options_t const *pOpt, uint32_t Trial);
+static void StepTick(Options_t const *pOpt, uint32_t Tick);
+static void WatchAnsible(Options_t const *pOpt, Node_t *pNode, uint32_t Tick);
+static void Split(Options_t const *pOpt, Node_t *pNode, uint8_t Byte,
+    uint32_t Tick);
+static void Transmit(Options_t const *pOpt, Node_t *pFrom,
+    uint8_t const *pData, uint16_t Length, uint64_t NowUs);
+static bool TryLost(Options_t const *pOpt, uint64_t StartUs, uint16_t Bytes);
+static void Deliver(Delivery_t const *pDelivery);
+static void Schedule(uint8_t To, uint64_t DueUs, uint8_t const *pData,
+    uint16_t Length);
+static Node_t *FindNode(uint16_t Address);
+static uint64_t Random(void);
+static double Uniform(void);
+static void AddSample(Samples_t *pSamples, uint32_t Value);
+static uint32_t Percentile(Samples_t const *pSamples, uint32_t Percent);
+static void Report(char const *pName, Samples_t *pSamples);
+
+/*---------------------------- Module Variables ---------------------------*/
+static uint8_t    *pAnsibleImage;
+static size_t     AnsibleImageSize;
+static uint8_t    *pShipImage;
+static size_t     ShipImageSize;
+
+static Node_t     Nodes[MAX_NODES];
+static uint8_t    NumNodes;
+static Delivery_t Deliveries[MAX_DELIVERIES];
+static uint16_t   NumDeliveries;
+static uint64_t   ChannelFreeUs;
+static uint64_t   RandomState;
+static FILE       *pReport;
+
+// over all the trials
+static Samples_t  PairTimes;
+static Samples_t  RTTs;
+static Samples_t  RecoverTimes;
+static Samples_t  FailoverTimes;
+static Samples_t  OutageDetectTimes;
+static Samples_t  OutageRecoverTimes;
+static Samples_t  ActuateTimes;
+static uint32_t   Sent[256];
+static uint32_t   Delivered[256];
+static uint32_t   Tries;
+static uint32_t   LostTries;
+static uint32_t   NoAcks;
+static uint32_t   LinkDrops;
+static uint64_t   PairedTicks;
+static uint64_t   PairableTicks;
+static uint32_t   Overruns;
+static uint32_t   LateDeliveries;
+static uint64_t   AirUs;
+
+/*------------------------------ Module Code ------------------------------*/
+int main(int argc, char *argv[])
+{
+  Options_t   Opt;
+  RunResult_t Result = RUN_OK;
+  RunResult_t TrialResult;
+  bool        GatesOK = true;
+  uint32_t    Trial;
+  int         ReportFD;
+
+  if (!ParseOptions(argc, argv, &Opt))
+  {
+    Usage(argv[0]);
+    return 2;
+  }
+  if (!LoadImage(argv[optind], &pAnsibleImage, &AnsibleImageSize) ||
+      !LoadImage(argv[optind + 1], &pShipImage, &ShipImageSize))
+  {
+    return 2;
+  }
+  // the firmware printfs go to stdout, keep them out of the report
+  ReportFD = dup(STDOUT_FILENO);
+  pReport = fdopen(ReportFD, "w");
+  if (!Opt.Verbose)
+  {
+    (void)freopen("/dev/null", "w", stdout);
+  }
+
+  for (Trial = 0; Trial < Opt.Trials; Trial++)
+  {
+    TrialResult = RunTrial(&Opt, Trial);
+    if (TrialResult != RUN_OK)
+    {
+      fprintf(pReport, "trial=%u failed=%s\n", (unsigned)Trial,
+          (TrialResult == RUN_NEVER_PAIRED) ? "never_paired" :
+          (TrialResult == RUN_STOPPED) ? "board_stopped" :
+          (TrialResult == RUN_OVERRUN) ? "uart_overrun" : "load");
+      Result = TrialResult;
+      if (TrialResult == RUN_LOAD_FAILED)
+      {
+        return 2;
+      }
+    }
+  }
+
+  fprintf(pReport, "trials=%u boats=%u ansibles=%u seconds=%.1f latency_us=%u "
+      "jitter_us=%u ber=%g drop=%g retries=%u\n", (unsigned)Opt.Trials,
+      Opt.NumBoats, Opt.NumAnsibles, Opt.RunTicks / 1000.0,
+      (unsigned)Opt.LatencyUs, (unsigned)Opt.JitterUs, Opt.BitErrorRate,
+      Opt.DropRate, Opt.Retries);
+  Report("pair_ms", &PairTimes);
+  Report("rtt_ms", &RTTs);
+  Report("recover_ms", &RecoverTimes);
+  if (Opt.MoveTicks != 0)
+  {
+    Report("actuate_ms", &ActuateTimes);
+  }
+  if (Opt.SwitchBoat != 0)
+  {
+    Report("failover_ms", &FailoverTimes);
+  }
+  if (Opt.OutageLength != 0)
+  {
+    Report("outage_detect_ms", &OutageDetectTimes);
+    Report("outage_recover_ms", &OutageRecoverTimes);
+  }
+#define REPORT_DELIVERY(Name, Header, NumBytes) \
+  fprintf(pReport, "delivered_" #Name "=%u/%u\n", \
+      (unsigned)Delivered[Header], (unsigned)Sent[Header]);
+  XBEE_MESSAGES(REPORT_DELIVERY)
+#undef REPORT_DELIVERY
+  fprintf(pReport, "air_tries=%u air_lost=%u no_acks=%u late=%u\n",
+      (unsigned)Tries, (unsigned)LostTries, (unsigned)NoAcks,
+      (unsigned)LateDeliveries);
+  fprintf(pReport, "air_busy=%.4f ctrl_per_s=%.2f\n",
+      (double)AirUs / ((double)Opt.Trials * Opt.RunTicks * US_PER_TICK),
+      Sent[XBEE_CTRL] * 1000.0 /
+      ((double)Opt.Trials * Opt.NumAnsibles * Opt.RunTicks));
+  fprintf(pReport, "link_drops=%u available=%.4f overruns=%u\n",
+      (unsigned)LinkDrops,
+      (PairableTicks != 0) ? (double)PairedTicks / PairableTicks : 0.0,
+      (unsigned)Overruns);
+
+  if ((Opt.MaxPairP95 != 0) &&
+      ((PairTimes.Count == 0) ||
+      (Percentile(&PairTimes, 95) > Opt.MaxPairP95)))
+  {
+    fprintf(pReport, "gate=pair_p95 limit=%u\n", (unsigned)Opt.MaxPairP95);
+    GatesOK = false;
+  }
+  if ((Opt.MaxRTTP95 != 0) &&
+      ((RTTs.Count == 0) || (Percentile(&RTTs, 95) > Opt.MaxRTTP95)))
+  {
+    fprintf(pReport, "gate=rtt_p95 limit=%u\n", (unsigned)Opt.MaxRTTP95);
+    GatesOK = false;
+  }
+  fprintf(pReport, "result=%s\n",
+      ((Result == RUN_OK) && GatesOK) ? "PASS" : "FAIL");
+  fclose(pReport);
+  return ((Result == RUN_OK) && GatesOK) ? 0 : 1;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+/****************************************************************************
+ Function
+    ParseOptions
+
+ Description
+    fills in the options from the command line, false if they do not make
+    sense. The two library paths are left at optind
+****************************************************************************/
+static bool ParseOptions(int argc, char *argv[], Options_t *pOpt)
+{
+  int       Option;
+  double    Seconds;
+  double    Length;
+
+  memset(pOpt, 0, sizeof(*pOpt));
+  pOpt->RunTicks = 30000;
+  pOpt->Trials = 1;
+  pOpt->Seed = 1;
+  pOpt->NumBoats = 1;
+  pOpt->NumAnsibles = 1;
+  pOpt->LatencyUs = 2000;
+  pOpt->JitterUs = 1000;
+  pOpt->Retries = 3;
+  pOpt->RepressTicks = 500;
+
+  while ((Option = getopt(argc, argv, "b:a:t:n:s:l:j:e:d:r:o:w:k:m:uP:R:vh"))
+      != -1)
+  {
+    switch (Option)
+    {
+      case 'b': pOpt->NumBoats = atoi(optarg); break;
+      case 'a': pOpt->NumAnsibles = atoi(optarg); break;
+      case 't': pOpt->RunTicks = atof(optarg) * 1000; break;
+      case 'n': pOpt->Trials = atoi(optarg); break;
+      case 's': pOpt->Seed = strtoul(optarg, NULL, 0); break;
+      case 'l': pOpt->LatencyUs = atof(optarg) * 1000; break;
+      case 'j': pOpt->JitterUs = atof(optarg) * 1000; break;
+      case 'e': pOpt->BitErrorRate = atof(optarg); break;
+      case 'd': pOpt->DropRate = atof(optarg); break;
+      case 'r': pOpt->Retries = atoi(optarg); break;
+      case 'k': pOpt->RepressTicks = atof(optarg) * 1000; break;
+      case 'm': pOpt->MoveTicks = atoi(optarg); break;
+      case 'u': pOpt->Unfueled = true; break;
+      case 'P': pOpt->MaxPairP95 = atoi(optarg); break;
+      case 'R': pOpt->MaxRTTP95 = atoi(optarg); break;
+      case 'v': pOpt->Verbose = true; break;
+
+      case 'o':
+        if (sscanf(optarg, "%lf,%lf", &Seconds, &Length) != 2)
+        {
+          return false;
+        }
+        pOpt->OutageStart = Seconds * 1000;
+        pOpt->OutageLength = Length * 1000;
+        break;
+
+      case 'w':
+        if (sscanf(optarg, "%lf,%hhu", &Seconds, &pOpt->SwitchBoat) != 2)
+        {
+          return false;
+        }
+        pOpt->SwitchTick = Seconds * 1000;
+        break;
+
+      default:
+        return false;
+    }
+  }
+  return ((argc - optind) == 2) &&
+         (pOpt->NumBoats >= 1) && (pOpt->NumBoats <= MAX_BOATS) &&
+         (pOpt->NumAnsibles >= 1) && (pOpt->NumAnsibles <= MAX_ANSIBLES) &&
+         (pOpt->SwitchBoat <= pOpt->NumBoats) && (pOpt->SwitchBoat != 1) &&
+         (pOpt->SwitchTick < pOpt->RunTicks) &&
+         (pOpt->RunTicks > SETTLE_TICKS + PRESS_SPREAD) &&
+         (pOpt->Trials >= 1) && (pOpt->RepressTicks >= 1) &&
+         (pOpt->DropRate >= 0) && (pOpt->DropRate <= 1) &&
+         (pOpt->BitErrorRate >= 0) && (pOpt->BitErrorRate <= 1);
+}
+
+static void Usage(char const *pName)
+{
+  fprintf(stderr,
+      "usage: %s ansible.so ship.so [options]\n"
+      "  -b boats        SHIPs, boats 1 on (1)\n"
+      "  -a ansibles     ANSIBLEs, ANSIBLE i on boat (i %% boats) + 1 (1)\n"
+      "  -t seconds      length of each trial (30)\n"
+      "  -n trials       trials, each with fresh boards (1)\n"
+      "  -s seed         random seed, trial n uses seed + n (1)\n"
+      "  -l mS           radio latency (2)\n"
+      "  -j mS           radio jitter, added to the latency (1)\n"
+      "  -e ber          bit error rate on the air (0)\n"
+      "  -d probability  chance of losing any one try on the air (0)\n"
+      "  -r retries      XBee MAC retries (3)\n"
+      "  -o start,len    outage, in seconds, nothing gets through\n"
+      "  -w time,boat    at time seconds ANSIBLE 0's SHIP goes off the air\n"
+      "                  and it turns its dial to boat\n"
+      "  -k seconds      operator re-press delay when unpaired (0.5)\n"
+      "  -m mS           move the throttle about this often (never)\n"
+      "  -u              the SHIPs have no fuel\n"
+      "  -P mS           fail if the pairing time p95 is over this\n"
+      "  -R mS           fail if the round trip time p95 is over this\n"
+      "  -v              let the firmware printfs through\n", pName);
+}
+
+/****************************************************************************
+ Function
+    LoadImage
+
+ Description
+    reads a board library into memory, for LoadBoard to copy from
+****************************************************************************/
+static bool LoadImage(char const *pPath, uint8_t **ppImage, size_t *pSize)
+{
+  FILE  *pFile = fopen(pPath, "rb");
+  long  Size;
+
+  if ((pFile == NULL) || (fseek(pFile, 0, SEEK_END) != 0) ||
+      ((Size = ftell(pFile)) <= 0))
+  {
+    perror(pPath);
+    return false;
+  }
+  rewind(pFile);
+  *ppImage = malloc(Size);
+  if ((*ppImage == NULL) || (fread(*ppImage, 1, Size, pFile) != (size_t)Size))
+  {
+    perror(pPath);
+    return false;
+  }
+  fclose(pFile);
+  *pSize = Size;
+  return true;
+}
+
+/****************************************************************************
+ Function
+    LoadBoard
+
+ Description
+    loads a fresh copy of a board library, through a memfd so dlopen does
+    not hand back one already loaded
+****************************************************************************/
+static bool LoadBoard(Node_t *pNode, uint8_t const *pImage, size_t Size)
+{
+  char              Path[32];
+  SimBoard_t const  *(*pGet)(void);
+
+  pNode->FD = memfd_create("board", 0);
+  if ((pNode->FD < 0) || (write(pNode->FD, pImage, Size) != (ssize_t)Size))
+  {
+    perror("memfd");
+    return false;
+  }
+  snprintf(Path, sizeof(Path), "/proc/self/fd/%d", pNode->FD);
+  pNode->pHandle = dlopen(Path, RTLD_NOW | RTLD_LOCAL);
+  if (pNode->pHandle == NULL)
+  {
+    fprintf(stderr, "%s\n", dlerror());
+    return false;
+  }
+  *(void **)&pGet = dlsym(pNode->pHandle, "SimBoard_Get");
+  if (pGet == NULL)
+  {
+    fprintf(stderr, "%s\n", dlerror());
+    return false;
+  }
+  pNode->pBoard = pGet();
+  return true;
+}
+
+static void UnloadBoard(Node_t *pNode)
+{
+  if (pNode->pHandle != NULL)
+  {
+    dlclose(pNode->pHandle);
+  }
+  if (pNode->FD >= 0)
+  {
+    close(pNode->FD);
+  }
+  pNode->pHandle = NULL;
+  pNode->FD = -1;
+}
+
+/****************************************************************************
+ Function
+    RunTrial
+
+ Description
+    loads and starts the boards, runs them for the trial and adds what
+    was measured to the totals
+****************************************************************************/
+static RunResult_t RunTrial(Options_t const *pOpt, uint32_t Trial)
+{
+  RunResult_t Result = RUN_OK;
+  Node_t      *pNode;
+  uint32_t    Tick;
+  uint8_t     i;
+
+  memset(Nodes, 0, sizeof(Nodes));
+  NumNodes = 0;
+  NumDeliveries = 0;
+  ChannelFreeUs = 0;
+  RandomState = ((uint64_t)(pOpt->Seed + Trial) << 1) | 1;
+
+  for (i = 0; i < pOpt->NumBoats + pOpt->NumAnsibles; i++)
+  {
+    pNode = &Nodes[NumNodes++];
+    pNode->FD = -1;
+    pNode->IsShip = (i < pOpt->NumBoats);
+    if (!(pNode->IsShip ? LoadBoard(pNode, pShipImage, ShipImageSize) :
+        LoadBoard(pNode, pAnsibleImage, AnsibleImageSize)))
+    {
+      return RUN_LOAD_FAILED;
+    }
+    pNode->pBoard->SetInput(SIM_RED_TEAM, 1);
+    if (pNode->IsShip)
+    {
+      pNode->Address = SHIP_ADDRESS(i + 1);
+      pNode->pBoard->SetInput(SIM_FUEL, pOpt->Unfueled ? 0 : 0x0F);
+    }
+    else
+    {
+      pNode->Address = ANSIBLE_ADDRESS(i - pOpt->NumBoats);
+      pNode->Boat = ((i - pOpt->NumBoats) % pOpt->NumBoats) + 1;
+      pNode->pBoard->SetInput(SIM_BOAT, pNode->Boat);
+      pNode->PressAt = SETTLE_TICKS + (Random() % PRESS_SPREAD);
+      pNode->Throttle = STICK_RANGE / 2 - 1;
+      pNode->MoveAt = pNode->PressAt;
+    }
+    if (!pNode->pBoard->Start())
+    {
+      Result = RUN_STOPPED;
+    }
+  }
+
+  for (Tick = 1; (Tick <= pOpt->RunTicks) && (Result == RUN_OK); Tick++)
+  {
+    StepTick(pOpt, Tick);
+    for (i = 0; i < NumNodes; i++)
+    {
+      if (!Nodes[i].pBoard->Step())
+      {
+        Result = RUN_STOPPED;
+      }
+    }
+    for (i = 0; i < NumNodes; i++)
+    {
+      uint8_t   TXBytes[64];
+      uint16_t  NumBytes = Nodes[i].pBoard->TakeTX(TXBytes, sizeof(TXBytes));
+      uint16_t  j;
+
+      for (j = 0; j < NumBytes; j++)
+      {
+        Split(pOpt, &Nodes[i], TXBytes[j], Tick);
+      }
+      if (!Nodes[i].IsShip)
+      {
+        WatchAnsible(pOpt, &Nodes[i], Tick);
+      }
+    }
+  }
+
+  for (i = 0; i < NumNodes; i++)
+  {
+    pNode = &Nodes[i];
+    if (pNode->pBoard->GetOverruns() != 0)
+    {
+      Overruns += pNode->pBoard->GetOverruns();
+      Result = (Result == RUN_OK) ? RUN_OVERRUN : Result;
+    }
+    if (!pNode->IsShip && (pNode->FirstPaired == 0) && (Result == RUN_OK))
+    {
+      Result = RUN_NEVER_PAIRED;
+    }
+    UnloadBoard(pNode);
+  }
+  return Result;
+}
+
+/****************************************************************************
+ Function
+    StepTick
+
+ Description
+    what happens to the boards at the start of a tick: packets the radio
+    has for them, the boat switch and the pair button
+****************************************************************************/
+static void StepTick(Options_t const *pOpt, uint32_t Tick)
+{
+  uint64_t  EndUs = (uint64_t)Tick * US_PER_TICK;
+  uint16_t  First;
+  uint16_t  i;
+  Node_t    *pNode;
+
+  // in the order they arrive
+  for (;;)
+  {
+    First = NumDeliveries;
+    for (i = 0; i < NumDeliveries; i++)
+    {
+      if ((Deliveries[i].DueUs < EndUs) && ((First == NumDeliveries) ||
+          (Deliveries[i].DueUs < Deliveries[First].DueUs)))
+      {
+        First = i;
+      }
+    }
+    if (First == NumDeliveries)
+    {
+      break;
+    }
+    Deliver(&Deliveries[First]);
+    Deliveries[First] = Deliveries[--NumDeliveries];
+  }
+
+  for (i = 0; i < NumNodes; i++)
+  {
+    pNode = &Nodes[i];
+    if (pNode->IsShip)
+    {
+      continue;
+    }
+    if ((pOpt->SwitchBoat != 0) && (Tick == pOpt->SwitchTick) &&
+        (pNode == &Nodes[pOpt->NumBoats]))
+    {
+      Nodes[pNode->Boat - 1].OffAir = true;
+      pNode->Boat = pOpt->SwitchBoat;
+      pNode->pBoard->SetInput(SIM_BOAT, pNode->Boat);
+      pNode->SwitchPending = true;
+    }
+    if ((pOpt->MoveTicks != 0) && (Tick >= pNode->MoveAt))
+    {
+      pNode->Throttle = (pNode->Throttle + MIN_MOVE +
+          Random() % (STICK_RANGE - 2 * MIN_MOVE)) % STICK_RANGE;
+      pNode->pBoard->SetInput(SIM_THROTTLE, pNode->Throttle);
+      pNode->MoveAt = Tick + pOpt->MoveTicks / 2 + Random() % pOpt->MoveTicks;
+      // only moves made while paired count, to the time the board sees them
+      pNode->MovePending = (pNode->LastState == SIM_PAIRED);
+      pNode->MoveUs = (uint64_t)(Tick - 1) * US_PER_TICK;
+    }
+    if ((pNode->LastState == SIM_UNPAIRED) && (Tick >= pNode->PressAt))
+    {
+      pNode->pBoard->SetInput(SIM_PRESS_PAIR, 0);
+      pNode->PressAt = Tick + pOpt->RepressTicks;
+      if ((pNode->PressTick == 0) && (pNode->FirstPaired == 0))
+      {
+        pNode->PressTick = Tick;
+      }
+    }
+  }
+}
+
+/****************************************************************************
+ Function
+    WatchAnsible
+
+ Description
+    keeps the times that follow from an ANSIBLE's link state
+****************************************************************************/
+static void WatchAnsible(Options_t const *pOpt, Node_t *pNode, uint32_t Tick)
+{
+  SimLinkState_t  State = pNode->pBoard->GetLinkState();
+  uint32_t        OutageEnd = pOpt->OutageStart + pOpt->OutageLength;
+
+  if (pNode->FirstPaired != 0)
+  {
+    PairableTicks++;
+    PairedTicks += (State == SIM_PAIRED);
+  }
+
+  if ((State == SIM_PAIRED) && (pNode->LastState != SIM_PAIRED))
+  {
+    if (pNode->FirstPaired == 0)
+    {
+      pNode->FirstPaired = Tick;
+      AddSample(&PairTimes, Tick - pNode->PressTick);
+    }
+    else if (pNode->DropTick != 0)
+    {
+      AddSample(&RecoverTimes, Tick - pNode->DropTick);
+    }
+    pNode->DropTick = 0;
+    if (pNode->OutageRecoverPending && (Tick >= OutageEnd))
+    {
+      AddSample(&OutageRecoverTimes, Tick - OutageEnd);
+      pNode->OutageRecoverPending = false;
+    }
+  }
+  else if ((State != SIM_PAIRED) && (pNode->LastState == SIM_PAIRED))
+  {
+    LinkDrops++;
+    pNode->DropTick = Tick;
+    pNode->CtrlPending = false;
+    pNode->MovePending = false;
+    if ((pOpt->OutageLength != 0) && !pNode->OutageDropSeen &&
+        (Tick >= pOpt->OutageStart))
+    {
+      AddSample(&OutageDetectTimes, Tick - pOpt->OutageStart);
+      pNode->OutageDropSeen = true;
+      pNode->OutageRecoverPending = true;
+    }
+  }
+
+  if (pNode->SwitchPending && (State == SIM_PAIRED) &&
+      (pNode->pBoard->GetPeer() == SHIP_ADDRESS(pNode->Boat)))
+  {
+    AddSample(&FailoverTimes, Tick - pOpt->SwitchTick);
+    pNode->SwitchPending = false;
+  }
+  if ((State == SIM_UNPAIRED) && (pNode->LastState != SIM_UNPAIRED))
+  {
+    pNode->PressAt = Tick + pOpt->RepressTicks;
+  }
+  pNode->LastState = State;
+}
+
+/****************************************************************************
+ Function
+    Split
+
+ Description
+    puts together the API frames a board sends its XBee and hands each good
+    one to the radio. Times are to the tick: a byte taken after the step to
+    Tick finished by the end of it
+****************************************************************************/
+static void Split(Options_t const *pOpt, Node_t *pNode, uint8_t Byte,
+    uint32_t Tick)
+{
+  Splitter_t  *pSplit = &pNode->Splitter;
+  uint64_t    NowUs = (uint64_t)Tick * US_PER_TICK;
+  uint8_t     Sum = 0;
+  uint16_t    i;
+
+  switch (pSplit->State)
+  {
+    case 0:
+      if (Byte == START_DELIMITER)
+      {
+        pSplit->StartUs = NowUs - UART_BYTE_US;
+        pSplit->State = 1;
+      }
+      break;
+
+    case 1:
+      pSplit->Length = (uint16_t)Byte << 8;
+      pSplit->State = 2;
+      break;
+
+    case 2:
+      pSplit->Length |= Byte;
+      pSplit->Count = 0;
+      pSplit->State = ((pSplit->Length == 0) ||
+          (pSplit->Length > MAX_API_FRAME)) ? 0 : 3;
+      break;
+
+    default:
+      if (pSplit->Count < pSplit->Length)
+      {
+        pSplit->Data[pSplit->Count++] = Byte;
+        break;
+      }
+      for (i = 0; i < pSplit->Length; i++)
+      {
+        Sum += pSplit->Data[i];
+      }
+      if ((uint8_t)(Sum + Byte) == 0xFF)
+      {
+        Transmit(pOpt, pNode, pSplit->Data, pSplit->Length, NowUs);
+      }
+      pSplit->State = 0;
+      break;
+  }
+}
+
+/****************************************************************************
+ Function
+    Transmit
+
+ Description
+    an XBee sending a transmit request over the air, see the module notes
+****************************************************************************/
+static void Transmit(Options_t const *pOpt, Node_t *pFrom,
+    uint8_t const *pData, uint16_t Length, uint64_t NowUs)
+{
+  uint8_t   Frame[MAX_API_FRAME];
+  Node_t    *pTo;
+  uint16_t  Address;
+  uint16_t  RFLength;
+  uint64_t  AtUs;
+  uint64_t  EndUs;
+  uint8_t   Try;
+  uint8_t   Sum = 0;
+  uint16_t  i;
+  bool      Acked = false;
+  bool      Arrived = false;
+
+  if (pFrom->OffAir || (pData[0] != XBEE_TX_REQUEST) ||
+      (Length <= API_HEADER_SIZE) ||
+      (Length + 4 > MAX_API_FRAME))
+  {
+    return;
+  }
+  Address = ((uint16_t)pData[2] << 8) | pData[3];
+  RFLength = Length - API_HEADER_SIZE;
+  pTo = FindNode(Address);
+  Sent[pData[API_HEADER_SIZE]]++;
+  if (!pFrom->IsShip && (pData[API_HEADER_SIZE] == XBEE_CTRL))
+  {
+    pFrom->CtrlPending = true;
+    pFrom->CtrlStartUs = pFrom->Splitter.StartUs;
+  }
+
+  // the received packet frame it turns into
+  Frame[0] = START_DELIMITER;
+  Frame[1] = 0;
+  Frame[2] = Length;
+  Frame[3] = XBEE_RX_PACKET;
+  Frame[4] = pFrom->Address >> 8;
+  Frame[5] = pFrom->Address & 0xFF;
+  Frame[6] = RSSI;
+  Frame[7] = pData[4];
+  memcpy(&Frame[8], &pData[API_HEADER_SIZE], RFLength);
+  for (i = 3; i < Length + 3; i++)
+  {
+    Sum += Frame[i];
+  }
+  Frame[Length + 3] = 0xFF - Sum;
+
+  AtUs = (NowUs > pFrom->RadioFreeUs) ? NowUs : pFrom->RadioFreeUs;
+  for (Try = 0; (Try <= pOpt->Retries) && !Acked; Try++)
+  {
+    if (AtUs < ChannelFreeUs)
+    {
+      AtUs = ChannelFreeUs;
+    }
+    AtUs += (Random() % (1U << MIN_BE)) * BACKOFF_US + TURNAROUND_US;
+    EndUs = AtUs + (AIR_OVERHEAD + RFLength) * AIR_BYTE_US;
+    ChannelFreeUs = EndUs;
+    AirUs += EndUs - AtUs;
+    Tries++;
+    if ((pTo == NULL) || TryLost(pOpt, AtUs, AIR_OVERHEAD + RFLength))
+    {
+      LostTries += (pTo != NULL);
+      AtUs = EndUs + ACK_WAIT_US;
+      continue;
+    }
+    if (!Arrived)
+    {
+      Arrived = true;
+      Schedule(pTo - Nodes, EndUs + pOpt->LatencyUs +
+          ((pOpt->JitterUs != 0) ? Random() % pOpt->JitterUs : 0),
+          Frame, Length + 4);
+    }
+    if (!TryLost(pOpt, EndUs, AIR_ACK_BYTES))
+    {
+      Acked = true;
+      AtUs = EndUs + TURNAROUND_US + AIR_ACK_BYTES * AIR_BYTE_US;
+      ChannelFreeUs = AtUs;
+      AirUs += AIR_ACK_BYTES * AIR_BYTE_US;
+    }
+    else
+    {
+      LostTries++;
+      AtUs = EndUs + ACK_WAIT_US;
+    }
+  }
+  pFrom->RadioFreeUs = AtUs;
+  NoAcks += !Acked;
+
+  if (pData[1] != 0)
+  {
+    Frame[2] = 3;
+    Frame[3] = API_TX_STATUS;
+    Frame[4] = pData[1];
+    Frame[5] = Acked ? TX_SUCCESS : TX_NO_ACK;
+    Frame[6] = 0xFF - (uint8_t)(Frame[3] + Frame[4] + Frame[5]);
+    Schedule(pFrom - Nodes, AtUs, Frame, 7);
+  }
+}
+
+/****************************************************************************
+ Function
+    TryLost
+
+ Description
+    whether one frame of Bytes bytes on the air, starting at StartUs, is
+    lost
+****************************************************************************/
+static bool TryLost(Options_t const *pOpt, uint64_t StartUs, uint16_t Bytes)
+{
+  uint64_t  OutageStartUs = (uint64_t)pOpt->OutageStart * US_PER_TICK;
+  uint64_t  OutageEndUs = OutageStartUs +
+      (uint64_t)pOpt->OutageLength * US_PER_TICK;
+
+  if ((pOpt->OutageLength != 0) && (StartUs >= OutageStartUs) &&
+      (StartUs < OutageEndUs))
+  {
+    return true;
+  }
+  if ((pOpt->DropRate > 0) && (Uniform() < pOpt->DropRate))
+  {
+    return true;
+  }
+  return (pOpt->BitErrorRate > 0) &&
+         (Uniform() < 1.0 - pow(1.0 - pOpt->BitErrorRate, 8.0 * Bytes));
+}
+
+/****************************************************************************
+ Function
+    Deliver
+
+ Description
+    puts a frame from the XBee on a board's RX line, and keeps the round
+    trip time if it is the STATUS an ANSIBLE was waiting for, or the
+    actuation time if it is a CTRL with the throttle an ANSIBLE moved to
+****************************************************************************/
+static void Deliver(Delivery_t const *pDelivery)
+{
+  Node_t    *pTo = &Nodes[pDelivery->To];
+  Node_t    *pFrom;
+  uint64_t  StartUs = (pDelivery->DueUs > pTo->RXLineFreeUs) ?
+      pDelivery->DueUs : pTo->RXLineFreeUs;
+  uint8_t   Message = pDelivery->Bytes[3 + API_HEADER_SIZE];
+  uint16_t  Source = ((uint16_t)pDelivery->Bytes[4] << 8) |
+      pDelivery->Bytes[5];
+
+  // the bytes cannot start before the tick they are given in
+  if (StartUs < (pDelivery->DueUs / US_PER_TICK) * US_PER_TICK)
+  {
+    StartUs = (pDelivery->DueUs / US_PER_TICK) * US_PER_TICK;
+  }
+  if (StartUs > pDelivery->DueUs + 10 * UART_BYTE_US)
+  {
+    LateDeliveries++;
+  }
+  pTo->RXLineFreeUs = StartUs + (uint64_t)pDelivery->Length * UART_BYTE_US;
+  pTo->pBoard->GiveRX(pDelivery->Bytes, pDelivery->Length);
+
+  if (pDelivery->Bytes[3] != XBEE_RX_PACKET)
+  {
+    return;
+  }
+  Delivered[Message]++;
+  if (!pTo->IsShip && (Message == XBEE_STATUS) && pTo->CtrlPending &&
+      (Source == pTo->pBoard->GetPeer()))
+  {
+    AddSample(&RTTs, (pTo->RXLineFreeUs - pTo->CtrlStartUs + 500) / 1000);
+    pTo->CtrlPending = false;
+  }
+  pFrom = FindNode(Source);
+  if (pTo->IsShip && (Message == XBEE_CTRL) && (pFrom != NULL) &&
+      pFrom->MovePending && (pDelivery->Bytes[3 + API_HEADER_SIZE + 1 +
+      XBEE_CTRL_FB] == pFrom->Throttle))
+  {
+    AddSample(&ActuateTimes, (pTo->RXLineFreeUs - pFrom->MoveUs + 500) /
+        1000);
+    pFrom->MovePending = false;
+  }
+}
+
+static void Schedule(uint8_t To, uint64_t DueUs, uint8_t const *pData,
+    uint16_t Length)
+{
+  Delivery_t *pDelivery;
+
+  if (NumDeliveries == MAX_DELIVERIES)
+  {
+    fprintf(stderr, "LinkSim: too many packets in the air\n");
+    exit(1);
+  }
+  pDelivery = &Deliveries[NumDeliveries++];
+  pDelivery->To = To;
+  pDelivery->DueUs = DueUs;
+  pDelivery->Length = Length;
+  memcpy(pDelivery->Bytes, pData, Length);
+}
+
+static Node_t *FindNode(uint16_t Address)
+{
+  uint8_t i;
+
+  for (i = 0; i < NumNodes; i++)
+  {
+    if ((Nodes[i].Address == Address) && !Nodes[i].OffAir)
+    {
+      return &Nodes[i];
+    }
+  }
+  return NULL;
+}
+
+// xorshift64*, the same runs for the same seed on any host
+static uint64_t Random(void)
+{
+  RandomState ^= RandomState >> 12;
+  RandomState ^= RandomState << 25;
+  RandomState ^= RandomState >> 27;
+  return RandomState * 0x2545F4914F6CDD1DULL;
+}
+
+static double Uniform(void)
+{
+  return (Random() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void AddSample(Samples_t *pSamples, uint32_t Value)
+{
+  if (pSamples->Count == pSamples->Size)
+  {
+    pSamples->Size = (pSamples->Size != 0) ? pSamples->Size * 2 : 64;
+    pSamples->pValues = realloc(pSamples->pValues,
+        pSamples->Size * sizeof(uint32_t));
+    if (pSamples->pValues == NULL)
+    {
+      perror("LinkSim");
+      exit(1);
+    }
+  }
+  pSamples->pValues[pSamples->Count++] = Value;
+}
+
+static int CompareSamples(void const *pA, void const *pB)
+{
+  uint32_t A = *(uint32_t const *)pA;
+  uint32_t B = *(uint32_t const *)pB;
+
+  return (A > B) - (A < B);
+}
+
+// nearest rank, the samples must have been sorted by Report
+static uint32_t Percentile(Samples_t const *pSamples, uint32_t Percent)
+{
+  uint32_t Rank = (pSamples->Count * Percent + 99) / 100;
+
+  return pSamples->pValues[(Rank != 0) ? Rank - 1 : 0];
+}
+
+static void Report(char const *pName, Samples_t *pSamples)
+{
+  uint64_t  Total = 0;
+  uint32_t  i;
+
+  if (pSamples->Count == 0)
+  {
+    fprintf(pReport, "%s n=0\n", pName);
+    return;
+  }
+  qsort(pSamples->pValues, pSamples->Count, sizeof(uint32_t), CompareSamples);
+  for (i = 0; i < pSamples->Count; i++)
+  {
+    Total += pSamples->pValues[i];
+  }
+  fprintf(pReport, "%s n=%u min=%u mean=%.1f p50=%u p95=%u p99=%u max=%u\n",
+      pName, (unsigned)pSamples->Count, (unsigned)pSamples->pValues[0],
+      (double)Total / pSamples->Count, (unsigned)Percentile(pSamples, 50),
+      (unsigned)Percentile(pSamples, 95), (unsigned)Percentile(pSamples, 99),
+      (unsigned)pSamples->pValues[pSamples->Count - 1]);
+}
@@ -0,0 +1,219 @@
+/****************************************************************************
+ Module
+   SimAnsible.c
+
+ Revision
+   1.0.1
+
+ Description
+   The ANSIBLE as a simulated board for LinkSim: the board description
+   for SimBoard.c, and stand-ins for the services and sensors that have
+   nothing to do with the XBee link.
+
+ Notes
+   Built with SimBoard.c, ES_PortPOSIX.c, the framework and AnsibleMain.c,
+   AnsibleReceive.c, AnsibleTransmit.c, XBeeFrame.c & XBeeCodec.c from
+   FrameworkCode, against FrameworkCode/Headers/ES_Configure.h as it is.
+   The IMU, sensor, screen and button services are in ES_Configure.h, so
+   they are here as services that do nothing, and the sticks and the boat
+   dial are whatever LinkSim last set them to. SensorUpdate only keeps its
+   timer, to tell AnsibleMain about new readings as often as the real one.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/18/26 04:50         started coding
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+
+#include "inc/hw_memmap.h"
+
+#include "AnsibleMain.h"
+#include "AnsibleTransmit.h"
+#include "IMU_SPI.h"
+#include "SensorUpdate.h"
+#include "ScreenService.h"
+#include "ButtonService.h"
+#include "EventCheckers.h"
+
+#include "SimBoard.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// PC6, high for the blue team, see InitAnsibleTX
+#define TEAM_PIN        BIT6HI
+// the middle of the sticks
+#define STICK_CENTRE    127
+// updateInterval in SensorUpdate.c
+#define SENSOR_UPDATE_TIME 20
+// the SHIP XBee addresses in DestAddress in AnsibleTransmit.c are 0x2181 on
+// for boats 1 on
+#define BOAT_ADDRESS(Boat) (0x2180 + (Boat))
+
+// a service of the Tiva build that has no part in the simulation
+#define IDLE_SERVICE(Name) \
+  static uint8_t Name##Priority; \
+  bool Init##Name(uint8_t Priority) \
+  { \
+    Name##Priority = Priority; \
+    return true; \
+  } \
+  bool Post##Name(ES_Event_t ThisEvent) \
+  { \
+    return ES_PostToService(Name##Priority, ThisEvent); \
+  } \
+  ES_Event_t Run##Name(ES_Event_t ThisEvent) \
+  { \
+    ThisEvent.EventType = ES_NO_EVENT; \
+    return ThisEvent; \
+  }
+
+/*---------------------------- Module Functions ---------------------------*/
+void AnsibleTXRXISR(void);
+
+static void SetInput(SimInput_t Which, uint8_t Value);
+static SimLinkState_t GetLinkState(void);
+static uint16_t GetPeer(void);
+
+/*---------------------------- Module Variables ---------------------------*/
+static uint8_t BoatNumber = 1;
+static uint8_t Throttle = STICK_CENTRE;
+static uint8_t Steering = STICK_CENTRE;
+
+SimBoardPort_t const SimBoardPort =
+{
+  "ANSIBLE", UART5_BASE, AnsibleTXRXISR, SetInput, GetLinkState, GetPeer
+};
+
+/*------------------------------ Module Code ------------------------------*/
+IDLE_SERVICE(IMU)
+IDLE_SERVICE(ScreenService)
+IDLE_SERVICE(Button)
+
+static uint8_t SensorUpdatePriority;
+
+bool InitSensorUpdate(uint8_t Priority)
+{
+  SensorUpdatePriority = Priority;
+  return ES_Timer_InitTimer(SENSOR_UPDATE_TIMER, SENSOR_UPDATE_TIME) ==
+         ES_Timer_OK;
+}
+
+bool PostSensorUpdate(ES_Event_t ThisEvent)
+{
+  return ES_PostToService(SensorUpdatePriority, ThisEvent);
+}
+
+ES_Event_t RunSensorUpdate(ES_Event_t ThisEvent)
+{
+  ES_Event_t UpdatedEvent;
+
+  if ((ThisEvent.EventType == ES_TIMEOUT) &&
+      (ThisEvent.EventParam == SENSOR_UPDATE_TIMER))
+  {
+    ES_Timer_InitTimer(SENSOR_UPDATE_TIMER, SENSOR_UPDATE_TIME);
+    UpdatedEvent.EventType = ES_CONTROLS_UPDATED;
+    UpdatedEvent.EventParam = 0;
+    PostAnsibleMain(UpdatedEvent);
+  }
+  ThisEvent.EventType = ES_NO_EVENT;
+  return ThisEvent;
+}
+
+bool CheckButtonEvents(void)
+{
+  return false;
+}
+
+bool Check4Keystroke(void)
+{
+  return false;
+}
+
+uint8_t getBoatNumber(void)
+{
+  return BoatNumber;
+}
+
+uint8_t getThrottle(void)
+{
+  return Throttle;
+}
+
+uint8_t getSteering(void)
+{
+  return Steering;
+}
+
+uint8_t getYaw(void)
+{
+  return STICK_CENTRE;
+}
+
+uint8_t getPitch(void)
+{
+  return STICK_CENTRE;
+}
+
+uint8_t getControl(void)
+{
+  return 0;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+static void SetInput(SimInput_t Which, uint8_t Value)
+{
+  ES_Event_t ThisEvent;
+
+  switch (Which)
+  {
+    case SIM_RED_TEAM:
+      SimBoard_SetPins(GPIO_PORTC_BASE, TEAM_PIN, Value == 0);
+      break;
+
+    case SIM_PRESS_PAIR:
+      // what ButtonService posts
+      ThisEvent.EventType = ES_PAIRBUTTONPRESSED;
+      ThisEvent.EventParam = 0;
+      PostAnsibleMain(ThisEvent);
+      break;
+
+    case SIM_BOAT:
+      BoatNumber = Value;
+      break;
+
+    case SIM_THROTTLE:
+      Throttle = Value;
+      break;
+
+    case SIM_STEERING:
+      Steering = Value;
+      break;
+
+    default:
+      break;
+  }
+}
+
+static SimLinkState_t GetLinkState(void)
+{
+  switch (QueryAnsible())
+  {
+    case WaitingForPairResp:
+      return SIM_PAIRING;
+
+    case CommunicatingSHIP:
+      return SIM_PAIRED;
+
+    default:
+      return SIM_UNPAIRED;
+  }
+}
+
+static uint16_t GetPeer(void)
+{
+  return BOAT_ADDRESS(getCurrentBoat());
+}
@@ -0,0 +1,650 @@
+/****************************************************************************
+ Module
+   SimBoard.c
+
+ Revision
+   1.0.1
+
+ Description
+   The parts of a simulated board that the ANSIBLE and the SHIP share: the
+   registers behind HWREG, a model of the UART wired to the XBee, and the
+   SimBoard_t table that LinkSim.c drives the board through.
+
+ Notes
+   Built into each board's shared library, with the board's firmware,
+   ES_PortPOSIX.c and SimAnsible.c or SimShip.c. Each library is loaded
+   once per board, so everything here is simply module level.
+
+   Registers
+   Any address the firmware uses gets a cell, zero to start with. The
+   peripheral ready (PRxxx) registers always read all ones, so the
+   waits in the inits fall straight through. The XBee UART is modelled:
+   FR, RIS and MIS are worked out when they are read, DR and ICR have side
+   effects. HWREG hands out a pointer, so the model cannot see a store
+   when it happens. Instead DR and ICR accesses are settled at the next
+   HWREG, tick or Step: a DR cell that still holds the marker put there
+   when it was handed out was read, one that does not was written.
+
+   UART
+   TX and RX FIFOs of 16, the FIFO level interrupts as set in IFLS, the
+   receive time out after 32 bit times with no new byte, and overruns.
+   Bytes move at the baud rate set in IBRD and FBRD, 10 bit times each,
+   on every tick. The interrupt response is called at the end of a tick
+   while (RIS & IM) is not zero, so interrupts are taken between run
+   functions and up to a tick late, never in the middle of one.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/18/26 04:10         started coding
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+#include "ES_Port.h"
+
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "inc/hw_gpio.h"
+#include "inc/hw_sysctl.h"
+#include "inc/hw_uart.h"
+
+#include "SimBoard.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// cells for the registers that are not modelled, a power of 2
+#define NUM_REGISTERS   256
+// the peripheral ready registers
+#define PR_FIRST        SYSCTL_PRWD
+#define PR_LAST         SYSCTL_PREMAC
+
+#define FIFO_SIZE       16
+// what the XBee has waiting to go down the UART to the board, and what the
+// board has sent since the last TakeTX
+#define RX_LINE_SIZE    1024
+#define TX_LINE_SIZE    256
+
+#define SYSCLK_HZ       40000000UL
+#define BIT_TIMES_PER_BYTE   10            // start, 8 data & stop
+#define NS_PER_TICK     1000000UL     // ES_Timer_RATE_1mS
+// the receive time out is 32 bit times, 3.3mS at 9600 baud
+#define RT_BIT_TIMES    32
+
+// put in a DR cell when it is handed out, no 8 bit write can leave it there
+#define DR_UNTOUCHED    0x80000000UL
+
+// the most times the interrupt response is run back to back in one tick
+#define MAX_ISR_RUNS    4
+
+/*---------------------------- Module Types -------------------------------*/
+typedef struct
+{
+  uint32_t          Address;
+  volatile uint32_t Value;
+  bool              Used;
+} Register_t;
+
+typedef enum
+{
+  NOTHING_PENDING,
+  DR_PENDING,
+  ICR_PENDING
+} Pending_t;
+
+/*---------------------------- Module Functions ---------------------------*/
+static volatile uint32_t *Cell(uint32_t Address);
+static void Settle(void);
+static void UARTTick(uint32_t Now);
+static uint32_t ByteTimeNS(void);
+static void MoveTX(uint32_t ByteNS);
+static void MoveRX(uint32_t ByteNS);
+static uint8_t Depth(void);
+static uint8_t TXTrigger(void);
+static uint8_t RXTrigger(void);
+static uint32_t UARTFlags(void);
+static uint32_t IM(void);
+
+static bool Start(void);
+static bool Step(void);
+static uint16_t TakeTX(uint8_t *pBytes, uint16_t Size);
+static void GiveRX(uint8_t const *pBytes, uint16_t Count);
+static uint16_t GetOverruns(void);
+
+/*---------------------------- Module Variables ---------------------------*/
+static Register_t Registers[NUM_REGISTERS];
+static uint16_t   NumRegisters;
+
+// the cells handed out for the modelled UART registers
+static volatile uint32_t  DRCell;
+static volatile uint32_t  ICRCell;
+static volatile uint32_t  FRCell;
+static volatile uint32_t  RISCell;
+static volatile uint32_t  MISCell;
+static Pending_t          Pending = NOTHING_PENDING;
+
+static uint32_t   RIS;
+
+static uint8_t    TXFIFO[FIFO_SIZE];
+static uint8_t    TXHead;
+static uint8_t    TXCount;
+static uint32_t   TXCredit;     // nS of line time towards the next byte
+static uint8_t    TXLine[TX_LINE_SIZE];
+static uint16_t   TXLineCount;
+
+static uint8_t    RXFIFO[FIFO_SIZE];
+static uint8_t    RXHead;
+static uint8_t    RXCount;
+static uint32_t   RXCredit;
+static uint8_t    RXLine[RX_LINE_SIZE];
+static uint16_t   RXLineHead;
+static uint16_t   RXLineCount;
+static uint32_t   RXIdleNS;     // since the last byte arrived
+static bool       RTArmed;      // a byte came in since the last time out
+
+static uint16_t   Overruns;
+
+static SimBoard_t Board;
+
+// TX interrupt levels for IFLS TX1_8 to TX7_8, RX levels for RX1_8 to RX7_8
+static const uint8_t FIFOLevels[] = { 2, 4, 8, 12, 14 };
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     SimBoard_Get
+
+ Parameters
+     none
+
+ Returns
+     SimBoard_t const *, the table LinkSim drives this board through
+
+ Description
+     LinkSim looks this up by name in each copy of the library it loads
+
+ Author
+     10/18/26
+****************************************************************************/
+SimBoard_t const *SimBoard_Get(void)
+{
+  Board.pName = SimBoardPort.pName;
+  Board.Start = Start;
+  Board.Step = Step;
+  Board.SetInput = SimBoardPort.SetInput;
+  Board.TakeTX = TakeTX;
+  Board.GiveRX = GiveRX;
+  Board.GetLinkState = SimBoardPort.GetLinkState;
+  Board.GetPeer = SimBoardPort.GetPeer;
+  Board.GetOverruns = GetOverruns;
+  return &Board;
+}
+
+/****************************************************************************
+ Function
+     SimBoard_Register
+
+ Parameters
+     uint32_t : a Tiva register address
+
+ Returns
+     volatile uint32_t *, the cell that stands in for it
+
+ Description
+     what HWREG comes to in the host inc/hw_types.h
+
+ Notes
+     settles the last DR or ICR access first, see the module notes
+
+ Author
+     10/18/26
+****************************************************************************/
+volatile uint32_t *SimBoard_Register(uint32_t Address)
+{
+  uint32_t UARTBase = SimBoardPort.UARTBase;
+
+  Settle();
+  if ((Address >= PR_FIRST) && (Address <= PR_LAST))
+  {
+    *Cell(Address) = 0xFFFFFFFF;
+  }
+  else if (Address == (UARTBase + UART_O_DR))
+  {
+    DRCell = DR_UNTOUCHED | ((RXCount != 0) ? RXFIFO[RXHead] : 0);
+    Pending = DR_PENDING;
+    return &DRCell;
+  }
+  else if (Address == (UARTBase + UART_O_ICR))
+  {
+    ICRCell = 0;
+    Pending = ICR_PENDING;
+    return &ICRCell;
+  }
+  else if (Address == (UARTBase + UART_O_FR))
+  {
+    FRCell = UARTFlags();
+    return &FRCell;
+  }
+  else if (Address == (UARTBase + UART_O_RIS))
+  {
+    RISCell = RIS;
+    return &RISCell;
+  }
+  else if (Address == (UARTBase + UART_O_MIS))
+  {
+    MISCell = RIS & IM();
+    return &MISCell;
+  }
+  return Cell(Address);
+}
+
+/****************************************************************************
+ Function
+     SimBoard_SetPins
+
+ Parameters
+     uint32_t : the GPIO port base address
+     uint8_t : the pins to set
+     bool : true to drive them high
+
+ Returns
+     none
+
+ Description
+     sets input pins as the firmware sees them through the all bits DATA
+     address, GPIO_O_DATA + ALL_BITS
+
+ Author
+     10/18/26
+****************************************************************************/
+void SimBoard_SetPins(uint32_t PortBase, uint8_t Pins, bool High)
+{
+  volatile uint32_t *pData = Cell(PortBase + GPIO_O_DATA + ALL_BITS);
+
+  if (High)
+  {
+    *pData |= Pins;
+  }
+  else
+  {
+    *pData &= ~(uint32_t)Pins;
+  }
+}
+
+/****************************************************************************
+ Function
+     __enable_irq
+
+ Description
+     interrupts are always on in the simulation
+****************************************************************************/
+void __enable_irq(void)
+{
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+
+/****************************************************************************
+ Function
+    Start
+
+ Description
+    runs the service inits, with the virtual clock and the UART model on
+    the tick
+****************************************************************************/
+static bool Start(void)
+{
+  _HW_SelectClock(HW_CLOCK_VIRTUAL);
+  _HW_SetTickHook(UARTTick);
+  if (ES_Initialize(ES_Timer_RATE_1mS) != Success)
+  {
+    return false;
+  }
+  Settle();
+  return true;
+}
+
+/****************************************************************************
+ Function
+    Step
+
+ Description
+    runs the framework for one tick, the UART moves on in UARTTick
+****************************************************************************/
+static bool Step(void)
+{
+  bool StillRunning = _HW_RunFor(1);
+
+  Settle();
+  return StillRunning;
+}
+
+/****************************************************************************
+ Function
+    TakeTX
+
+ Description
+    hands over the bytes that have gone out on the TX line since last time
+****************************************************************************/
+static uint16_t TakeTX(uint8_t *pBytes, uint16_t Size)
+{
+  uint16_t NumBytes = (TXLineCount < Size) ? TXLineCount : Size;
+  uint16_t i;
+
+  for (i = 0; i < NumBytes; i++)
+  {
+    pBytes[i] = TXLine[i];
+  }
+  TXLineCount = 0;
+  return NumBytes;
+}
+
+/****************************************************************************
+ Function
+    GiveRX
+
+ Description
+    queues bytes for the RX line, any that do not fit count as overruns
+****************************************************************************/
+static void GiveRX(uint8_t const *pBytes, uint16_t Count)
+{
+  uint16_t i;
+
+  for (i = 0; i < Count; i++)
+  {
+    if (RXLineCount == RX_LINE_SIZE)
+    {
+      Overruns++;
+    }
+    else
+    {
+      RXLine[(RXLineHead + RXLineCount) % RX_LINE_SIZE] = pBytes[i];
+      RXLineCount++;
+    }
+  }
+}
+
+static uint16_t GetOverruns(void)
+{
+  return Overruns;
+}
+
+/****************************************************************************
+ Function
+    Cell
+
+ Description
+    finds or makes the cell for a register that is not modelled
+****************************************************************************/
+static volatile uint32_t *Cell(uint32_t Address)
+{
+  uint16_t i = ((Address >> 2) ^ (Address >> 12)) & (NUM_REGISTERS - 1);
+
+  while (Registers[i].Used && (Registers[i].Address != Address))
+  {
+    i = (i + 1) & (NUM_REGISTERS - 1);
+  }
+  if (!Registers[i].Used)
+  {
+    if (NumRegisters == (NUM_REGISTERS - 1))
+    {
+      fprintf(stderr, "SimBoard: out of register cells, raise "
+          "NUM_REGISTERS\n");
+      abort();
+    }
+    NumRegisters++;
+    Registers[i].Used = true;
+    Registers[i].Address = Address;
+    Registers[i].Value = 0;
+  }
+  return &Registers[i].Value;
+}
+
+/****************************************************************************
+ Function
+    Settle
+
+ Description
+    carries out the read or write of DR, or the write of ICR, that the last
+    pointer handed out was used for
+****************************************************************************/
+static void Settle(void)
+{
+  if (Pending == DR_PENDING)
+  {
+    if ((DRCell & DR_UNTOUCHED) != 0)
+    {
+      // read, the byte at the head of the RX FIFO is gone
+      if (RXCount != 0)
+      {
+        RXHead = (RXHead + 1) % FIFO_SIZE;
+        RXCount--;
+      }
+    }
+    else if (TXCount < Depth())
+    {
+      TXFIFO[(TXHead + TXCount) % FIFO_SIZE] = (uint8_t)DRCell;
+      TXCount++;
+    }
+    // a write to a full TX FIFO is lost, as on the Tiva
+  }
+  else if (Pending == ICR_PENDING)
+  {
+    RIS &= ~ICRCell;
+  }
+  Pending = NOTHING_PENDING;
+}
+
+/****************************************************************************
+ Function
+    UARTTick
+
+ Description
+    the tick hook: one tick of line time for each direction, then the
+    interrupt response for as long as there is an unmasked interrupt
+****************************************************************************/
+static void UARTTick(uint32_t Now)
+{
+  uint32_t ByteNS = ByteTimeNS();
+  uint8_t  i;
+
+  (void)Now;
+  Settle();
+  MoveTX(ByteNS);
+  MoveRX(ByteNS);
+  for (i = 0; (i < MAX_ISR_RUNS) && ((RIS & IM()) != 0); i++)
+  {
+    SimBoardPort.pISR();
+    Settle();
+  }
+}
+
+/****************************************************************************
+ Function
+    ByteTimeNS
+
+ Description
+    the time for one byte at the baud rate in IBRD & FBRD, which divide the
+    system clock by 16 * (IBRD + FBRD / 64)
+****************************************************************************/
+static uint32_t ByteTimeNS(void)
+{
+  uint32_t UARTBase = SimBoardPort.UARTBase;
+  uint32_t Divisor = (*Cell(UARTBase + UART_O_IBRD) * 64) +
+      *Cell(UARTBase + UART_O_FBRD);
+
+  if (Divisor == 0)
+  {
+    Divisor = (260 * 64) + 27;     // 9600 baud until the init sets it
+  }
+  // SYSCLK / (Divisor / 4) baud
+  return (uint32_t)((BIT_TIMES_PER_BYTE * 1000000000ULL * Divisor) /
+         (SYSCLK_HZ * 4));
+}
+
+/****************************************************************************
+ Function
+    MoveTX
+
+ Description
+    shifts out the bytes that the TX FIFO gets through in a tick, TXRIS
+    goes up as the FIFO drains through the IFLS level
+****************************************************************************/
+static void MoveTX(uint32_t ByteNS)
+{
+  uint8_t Trigger = TXTrigger();
+
+  if (TXCount == 0)
+  {
+    TXCredit = 0;
+    return;
+  }
+  TXCredit += NS_PER_TICK;
+  while ((TXCount != 0) && (TXCredit >= ByteNS))
+  {
+    TXCredit -= ByteNS;
+    if (TXLineCount < TX_LINE_SIZE)
+    {
+      TXLine[TXLineCount++] = TXFIFO[TXHead];
+    }
+    TXHead = (TXHead + 1) % FIFO_SIZE;
+    TXCount--;
+    if (TXCount == Trigger)
+    {
+      RIS |= UART_RIS_TXRIS;
+    }
+  }
+}
+
+/****************************************************************************
+ Function
+    MoveRX
+
+ Description
+    brings in the bytes that arrive on the RX line in a tick. RXRIS goes up
+    as the FIFO fills through the IFLS level, RTRIS when bytes have sat in
+    it for 32 bit times with nothing new
+****************************************************************************/
+static void MoveRX(uint32_t ByteNS)
+{
+  uint8_t Trigger = RXTrigger();
+  uint32_t RTNS = (ByteNS / BIT_TIMES_PER_BYTE) * RT_BIT_TIMES;
+
+  if (RXLineCount == 0)
+  {
+    RXCredit = 0;
+    if (RTArmed && (RXCount != 0))
+    {
+      RXIdleNS += NS_PER_TICK;
+      if (RXIdleNS >= RTNS)
+      {
+        RIS |= UART_RIS_RTRIS;
+        RTArmed = false;
+      }
+    }
+    return;
+  }
+  RXCredit += NS_PER_TICK;
+  while ((RXLineCount != 0) && (RXCredit >= ByteNS))
+  {
+    RXCredit -= ByteNS;
+    if (RXCount == Depth())
+    {
+      Overruns++;
+    }
+    else
+    {
+      RXFIFO[(RXHead + RXCount) % FIFO_SIZE] = RXLine[RXLineHead];
+      RXCount++;
+      if (RXCount == Trigger)
+      {
+        RIS |= UART_RIS_RXRIS;
+      }
+    }
+    RXLineHead = (RXLineHead + 1) % RX_LINE_SIZE;
+    RXLineCount--;
+    RXIdleNS = 0;
+    RTArmed = true;
+  }
+}
+
+/****************************************************************************
+ Function
+    Depth, TXTrigger & RXTrigger
+
+ Description
+    the FIFOs are 16 deep with LCRH FEN set, the levels come from IFLS.
+    Without FEN there is just the one holding register each way
+****************************************************************************/
+static uint8_t Depth(void)
+{
+  return (*Cell(SimBoardPort.UARTBase + UART_O_LCRH) & UART_LCRH_FEN) ?
+         FIFO_SIZE : 1;
+}
+
+static uint8_t TXTrigger(void)
+{
+  uint32_t Select = *Cell(SimBoardPort.UARTBase + UART_O_IFLS) &
+      UART_IFLS_TX_M;
+
+  if ((Depth() == 1) || (Select >= sizeof(FIFOLevels)))
+  {
+    return 0;
+  }
+  return FIFOLevels[Select];
+}
+
+static uint8_t RXTrigger(void)
+{
+  uint32_t Select = (*Cell(SimBoardPort.UARTBase + UART_O_IFLS) &
+      UART_IFLS_RX_M) >> 3;
+
+  if ((Depth() == 1) || (Select >= sizeof(FIFOLevels)))
+  {
+    return 1;
+  }
+  return FIFOLevels[Select];
+}
+
+/****************************************************************************
+ Function
+    UARTFlags & IM
+
+ Description
+    FR as it stands, and the interrupt mask the firmware has set
+****************************************************************************/
+static uint32_t UARTFlags(void)
+{
+  uint32_t Flags = 0;
+
+  if (TXCount == 0)
+  {
+    Flags |= UART_FR_TXFE;
+  }
+  else
+  {
+    Flags |= UART_FR_BUSY;
+  }
+  if (TXCount == Depth())
+  {
+    Flags |= UART_FR_TXFF;
+  }
+  if (RXCount == 0)
+  {
+    Flags |= UART_FR_RXFE;
+  }
+  if (RXCount == Depth())
+  {
+    Flags |= UART_FR_RXFF;
+  }
+  return Flags;
+}
+
+static uint32_t IM(void)
+{
+  return *Cell(SimBoardPort.UARTBase + UART_O_IM);
+}
@@ -0,0 +1,76 @@
+/****************************************************************************
+
+  Header file for the simulated boards of the XBee link simulator.
+
+  A board is the unmodified firmware of the ANSIBLE or the SHIP, built for
+  the host with SimBoard.c and SimAnsible.c or SimShip.c into a shared
+  library. LinkSim.c loads one copy of the library per board, so every
+  board has its own framework, services and registers, and drives it
+  through the table that SimBoard_Get returns.
+
+ ****************************************************************************/
+#ifndef SimBoard_H
+#define SimBoard_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// where a board's main state machine is, in terms both boards share
+typedef enum
+{
+  SIM_UNPAIRED,     // ANSIBLE WaitingForPair, SHIP Waiting2Pair
+  SIM_PAIRING,      // ANSIBLE WaitingForPairResp, SHIP Trying2Pair
+  SIM_PAIRED        // ANSIBLE CommunicatingSHIP, SHIP Communicating
+} SimLinkState_t;
+
+// what can be done to a board from the outside
+typedef enum
+{
+  SIM_RED_TEAM,     // both, the team switch, non-zero for red
+  SIM_PRESS_PAIR,   // ANSIBLE, the pair button, the value is not used
+  SIM_BOAT,         // ANSIBLE, the boat number dial, 1 to 11
+  SIM_THROTTLE,     // ANSIBLE, the sticks, 127 is the middle
+  SIM_STEERING,
+  SIM_FUEL          // SHIP, the fuel level from the PIC, 0 for empty
+} SimInput_t;
+
+typedef struct
+{
+  char const      *pName;
+  // the team switch must be set before this, it is read by the inits
+  bool            (*Start)(void);
+  // one ES_Timer tick of board time, false if ES_Run has given up
+  bool            (*Step)(void);
+  void            (*SetInput)(SimInput_t Which, uint8_t Value);
+  // the bytes that finished on the UART TX line during the last Step
+  uint16_t        (*TakeTX)(uint8_t *pBytes, uint16_t Size);
+  // bytes to arrive on the UART RX line, one after the other at the baud
+  // rate, starting with the next Step
+  void            (*GiveRX)(uint8_t const *pBytes, uint16_t Count);
+  SimLinkState_t  (*GetLinkState)(void);
+  // the XBee address the board is pairing or paired with
+  uint16_t        (*GetPeer)(void);
+  uint16_t        (*GetOverruns)(void);
+} SimBoard_t;
+
+SimBoard_t const *SimBoard_Get(void);
+
+/*----------------------------------------------------------------------------
+  Between SimBoard.c and the board files, SimAnsible.c and SimShip.c
+----------------------------------------------------------------------------*/
+typedef struct
+{
+  char const      *pName;
+  uint32_t        UARTBase;       // the UART wired to the XBee
+  void            (*pISR)(void);  // and its interrupt response
+  void            (*SetInput)(SimInput_t Which, uint8_t Value);
+  SimLinkState_t  (*GetLinkState)(void);
+  uint16_t        (*GetPeer)(void);
+} SimBoardPort_t;
+
+extern SimBoardPort_t const SimBoardPort;
+
+// drives GPIO input pins, as seen through the all bits DATA address
+void SimBoard_SetPins(uint32_t PortBase, uint8_t Pins, bool High);
+
+#endif /* SimBoard_H */
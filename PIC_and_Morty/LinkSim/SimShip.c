@@ -0,0 +1,137 @@
+/****************************************************************************
+ Module
+   SimShip.c
+
+ Revision
+   1.0.1
+
+ Description
+   The SHIP as a simulated board for LinkSim: the board description for
+   SimBoard.c, and a stand-in for the PIC that reports the fuel.
+
+ Notes
+   Built with SimBoard.c, ES_PortPOSIX.c, the framework and SHIP_MASTER.c,
+   SHIP_RX.c, SHIP_TX.c, Init_UART.c, MotorModule.c, PWMLibrary.c,
+   XBeeFrame.c & XBeeCodec.c from Ship, against Ship/Headers/ES_Configure.h
+   as it is. The motors run into the register model. SHIP_PIC_RX and
+   SHIP_PIC_TX are in ES_Configure.h, so they are here as services that do
+   nothing, and the fuel is whatever LinkSim last set it to.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/18/26 05:20         started coding
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Configure.h"
+#include "ES_Framework.h"
+
+#include "inc/hw_memmap.h"
+
+#include "SHIP_MASTER.h"
+#include "SHIP_RX.h"
+#include "SHIP_TX.h"
+#include "SHIP_PIC_RX.h"
+#include "SHIP_PIC_TX.h"
+#include "EventCheckers.h"
+
+#include "SimBoard.h"
+
+/*----------------------------- Module Defines ----------------------------*/
+// PA2, high for the red team, see getHomeTeamColor in SHIP_MASTER.c
+#define TEAM_PIN          BIT2HI
+// the PIC sends the fuel level in the low nibble and its complement in
+// the high nibble, bit 3 set means there is fuel, see SHIP_PIC_RX.c
+#define FUEL_EMPTY_MASK   0x08
+#define FUEL_BYTE(Level)  ((uint8_t)(((~(Level) & 0x0F) << 4) | ((Level) & 0x0F)))
+
+// a service of the Tiva build that has no part in the simulation
+#define IDLE_SERVICE(Name) \
+  static uint8_t Name##Priority; \
+  bool Init##Name(uint8_t Priority) \
+  { \
+    Name##Priority = Priority; \
+    return true; \
+  } \
+  bool Post##Name(ES_Event_t ThisEvent) \
+  { \
+    return ES_PostToService(Name##Priority, ThisEvent); \
+  } \
+  ES_Event_t Run##Name(ES_Event_t ThisEvent) \
+  { \
+    ThisEvent.EventType = ES_NO_EVENT; \
+    return ThisEvent; \
+  }
+
+/*---------------------------- Module Functions ---------------------------*/
+static void SetInput(SimInput_t Which, uint8_t Value);
+static SimLinkState_t GetLinkState(void);
+static uint16_t GetPeer(void);
+
+/*---------------------------- Module Variables ---------------------------*/
+static uint8_t FuelStatus = FUEL_BYTE(0);
+
+SimBoardPort_t const SimBoardPort =
+{
+  "SHIP", UART3_BASE, SHIP_XBEE_ISR, SetInput, GetLinkState, GetPeer
+};
+
+/*------------------------------ Module Code ------------------------------*/
+IDLE_SERVICE(SHIP_PIC_RX)
+IDLE_SERVICE(SHIP_PIC_TX)
+
+bool Check4Keystroke(void)
+{
+  return false;
+}
+
+// true when there is fuel, as in SHIP_PIC_RX.c
+bool QueryFuelEmpty(void)
+{
+  return (FuelStatus & FUEL_EMPTY_MASK) != 0;
+}
+
+uint8_t QueryFuelStatus(void)
+{
+  return FuelStatus;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+static void SetInput(SimInput_t Which, uint8_t Value)
+{
+  switch (Which)
+  {
+    case SIM_RED_TEAM:
+      SimBoard_SetPins(GPIO_PORTA_BASE, TEAM_PIN, Value != 0);
+      break;
+
+    case SIM_FUEL:
+      FuelStatus = FUEL_BYTE(Value);
+      break;
+
+    default:
+      break;
+  }
+}
+
+static SimLinkState_t GetLinkState(void)
+{
+  switch (QueryCommunicationSM())
+  {
+    case Trying2Pair:
+      return SIM_PAIRING;
+
+    case Communicating:
+      return SIM_PAIRED;
+
+    default:
+      return SIM_UNPAIRED;
+  }
+}
+
+static uint16_t GetPeer(void)
+{
+  return QuerySourceAddress();
+}
@@ -0,0 +1,23 @@
+/****************************************************************************
+
+  Host stand-in for the TivaWare inc/hw_types.h, for the XBee link
+  simulator only (see LinkSim.c). LinkSim is first on the include path, so
+  the firmware gets this one and every HWREG goes to the register model in
+  SimBoard.c rather than to the Tiva address map. The rest of the TivaWare
+  headers are the real ones, for the register addresses and bit names.
+
+ ****************************************************************************/
+#ifndef __HW_TYPES_H__
+#define __HW_TYPES_H__
+
+#include <stdint.h>
+
+volatile uint32_t *SimBoard_Register(uint32_t Address);
+// a Keil intrinsic on the Tiva
+void __enable_irq(void);
+
+#define HWREG(x)  (*SimBoard_Register((uint32_t)(x)))
+#define HWREGH(x) (*(volatile uint16_t *)SimBoard_Register((uint32_t)(x)))
+#define HWREGB(x) (*(volatile uint8_t *)SimBoard_Register((uint32_t)(x)))
+
+#endif // __HW_TYPES_H__
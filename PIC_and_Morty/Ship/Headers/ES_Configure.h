@@ -264,6 +264,7 @@ typedef enum
   ES_UNLOCK, 
   /*New events for the SHIP*/
   BYTE_RECEIVED,
+  FRAME_RECEIVED,           /* EventParam is the pool handle of the frame */
   PACKET_RECEIVED,
   BEGIN_TX,
   BYTE_SENT,
@@ -276,6 +277,10 @@ typedef enum
   ES_TX_FAIL
 }ES_EventType_t;
 
+// the number of event types, keep this one more than the last entry above.
+// Used to size the per event type tables
+#define NUM_EVENT_TYPES (ES_TX_FAIL + 1)
+
 /****************************************************************************/
 // These are the definitions for the Distribution lists. Each definition
 // should be a comma separated list of post functions to indicate which
@@ -306,6 +311,15 @@ typedef enum
 #define DIST_LIST7 PostTemplateFSM
 #endif
 
+/****************************************************************************/
+// Pools of fixed size blocks for event payloads too big for the EventParam
+// (see ES_Pool.h). Each ES_POOL(BlockSize, NumBlocks) entry is a size class,
+// smallest first, and BlockSize must be a plain number. POOL_EVENT_LIST is
+// a comma separated list of the event types whose EventParam is a pool
+// handle. Leave ES_POOL_LIST commented out to leave the pools out.
+#define ES_POOL_LIST(ES_POOL) ES_POOL(16, 8) ES_POOL(112, 4)
+#define POOL_EVENT_LIST FRAME_RECEIVED
+
 /****************************************************************************/
 // This is the list of event checking functions
 #define EVENT_CHECK_LIST Check4Keystroke
@@ -354,4 +368,12 @@ typedef enum
 // PF1 & PF2
 //#define _INCLUDE_BASIC_FRAMEWORK_DEBUG_
 
+/**************************************************************************/
+// comment this line out to take every tick interrupt while the framework is
+// idle rather than sleep between timer expiries. The event checkers only get
+// called when something wakes the processor. The XBee and PIC UARTs and the
+// timers all interrupt, the one checker is for keystrokes, which wait in the
+// console UART's FIFO for at most one longest sleep (about 0.4 s).
+#define ES_TICKLESS_IDLE
+
 #endif /* ES_CONFIGURE_H */
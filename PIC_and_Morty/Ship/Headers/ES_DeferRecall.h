@@ -35,8 +35,15 @@
    bool : true if the add was successful, false if not
  Description
    if it will fit, adds Event2Add to the Queue
+ Notes
+   with ES_POOL_LIST defined it is a function in ES_DeferRecall.c that also
+   holds on to the pool block that the event carries
  ***************************************************************************/
+#ifdef ES_POOL_LIST
+bool ES_DeferEvent(ES_Event_t *pBlock, ES_Event_t Event2Add);
+#else
 #define ES_DeferEvent(a, b) ES_EnQueueLIFO(a, b)
+#endif
 
 /****************************************************************************
  Function
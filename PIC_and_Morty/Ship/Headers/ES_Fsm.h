@@ -0,0 +1,137 @@
+/****************************************************************************
+ Module
+     ES_Fsm.h
+ Description
+     header file for the table driven flat state machine helper, an
+     alternative to writing a service's run function as a switch on the
+     state with a chain of tests on the event inside each case
+ Notes
+     A machine is described by two X-macro lists, one line per state and one
+     per transition, which ES_FSM_DEFINE turns into constant tables:
+
+       #define DOOR_STATES(ES_FSM_STATE) \
+         ES_FSM_STATE(Closed) \
+         ES_FSM_STATE(Open)
+
+       #define DOOR_TRANSITIONS(ES_FSM_TRANSITION) \
+         ES_FSM_TRANSITION(Closed, EV_PUSH, ES_FSM_ANY_PARAM, IsUnlocked, \
+           StartMotor, Open) \
+         ES_FSM_TRANSITION(Open, ES_TIMEOUT, DOOR_TIMER, NULL, NULL, Closed)
+
+       typedef enum { DOOR_STATES(ES_FSM_STATE_NAME) } DoorState_t;
+       ES_FSM_DEFINE(DoorFsm, DOOR_STATES, DOOR_TRANSITIONS, Closed, NULL);
+
+     A transition line is (Source, Event type, Param, Guard, Action, Target).
+     Param must match the EventParam, which is how a timeout picks its
+     timer, or be ES_FSM_ANY_PARAM. Guard and Action may be NULL, Target may
+     be ES_FSM_SAME_STATE. The first line for the current state and event
+     whose Param matches and whose guard passes is taken: its action runs
+     and then the state changes. An event that takes no line goes to the
+     default handler named in ES_FSM_DEFINE, which gives the run function's
+     return value, or is ignored if there is none.
+
+     ES_Fsm_Init builds a table of the first line to try for each state and
+     event type, so finding the lines for an event is one look-up however
+     big the machine is. ES_Fsm_PrintDot writes the machine out as a
+     Graphviz graph, from the same tables, so the diagram can not drift from
+     the code.
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 23:50         started coding
+*****************************************************************************/
+#ifndef ES_Fsm_H
+#define ES_Fsm_H
+
+#include "ES_Configure.h"
+#include "ES_Types.h"
+#include "ES_Events.h"
+#include "ES_General.h"
+
+// a Target that leaves the state as it is
+#define ES_FSM_SAME_STATE 0xFF
+// a Param that matches any EventParam
+#define ES_FSM_ANY_PARAM  0xFFFF
+// end of a chain of lines in the dispatch table
+#define ES_FSM_NO_LINE    0xFF
+
+typedef bool (*ES_FsmGuardFunc_t)(ES_Event_t ThisEvent);
+typedef void (*ES_FsmActionFunc_t)(ES_Event_t ThisEvent);
+typedef ES_Event_t (*ES_FsmDefaultFunc_t)(ES_Event_t ThisEvent);
+
+typedef struct
+{
+  uint8_t             Source;
+  ES_EventType_t      Event;
+  uint16_t            Param;
+  ES_FsmGuardFunc_t   Guard;
+  ES_FsmActionFunc_t  Action;
+  uint8_t             Target;
+}ES_FsmTransition_t;
+
+// the names from a transition line, for ES_Fsm_PrintDot
+typedef struct
+{
+  char const *Event;
+  char const *Param;
+  char const *Guard;
+  char const *Action;
+}ES_FsmTransitionNames_t;
+
+typedef struct
+{
+  char const                    *Name;
+  char const * const            *pStateNames;
+  ES_FsmTransition_t const      *pTransitions;
+  ES_FsmTransitionNames_t const *pTransitionNames;
+  ES_FsmDefaultFunc_t           Default;
+  uint8_t                       *pNext;       // per line, next line to try
+  uint8_t                       *pDispatch;   // [state][event type], first
+                                              // line or ES_FSM_NO_LINE
+  uint8_t                       NumStates;
+  uint8_t                       NumTransitions;
+  uint8_t                       Initial;
+  uint8_t                       Current;
+  bool                          IsBuilt;
+}ES_Fsm_t;
+
+// expanders for the state & transition lists
+#define ES_FSM_STATE_NAME(Name) Name,
+
+#define ES_FSM_STATE_STRING(Name) [Name] = #Name,
+
+#define ES_FSM_TRANSITION_ENTRY(Source, Event, Param, Guard, Action, Target) \
+  { (Source), (Event), (Param), (Guard), (Action), (Target) },
+
+#define ES_FSM_TRANSITION_NAMES(Source, Event, Param, Guard, Action, Target) \
+  { #Event, #Param, #Guard, #Action },
+
+// the tables and work space for a machine, and the machine itself
+#define ES_FSM_DEFINE(Machine, STATE_LIST, TRANSITION_LIST, InitialState,   \
+                      DefaultFunc)                                          \
+  static char const * const Machine##_StateNames[] = {                      \
+    STATE_LIST(ES_FSM_STATE_STRING)                                         \
+  };                                                                        \
+  static ES_FsmTransition_t const Machine##_Transitions[] = {               \
+    TRANSITION_LIST(ES_FSM_TRANSITION_ENTRY)                                \
+  };                                                                        \
+  static ES_FsmTransitionNames_t const Machine##_TransitionNames[] = {      \
+    TRANSITION_LIST(ES_FSM_TRANSITION_NAMES)                                \
+  };                                                                        \
+  static uint8_t Machine##_Next[ARRAY_SIZE(Machine##_Transitions)];         \
+  static uint8_t Machine##_Dispatch[ARRAY_SIZE(Machine##_StateNames) *      \
+    NUM_EVENT_TYPES];                                                       \
+  static ES_Fsm_t Machine = {                                               \
+    #Machine, Machine##_StateNames, Machine##_Transitions,                  \
+    Machine##_TransitionNames, (DefaultFunc), Machine##_Next,               \
+    Machine##_Dispatch, ARRAY_SIZE(Machine##_StateNames),                   \
+    ARRAY_SIZE(Machine##_Transitions), (InitialState), (InitialState),      \
+    false                                                                   \
+  }
+
+bool ES_Fsm_Init(ES_Fsm_t *pFsm);
+ES_Event_t ES_Fsm_Dispatch(ES_Fsm_t *pFsm, ES_Event_t ThisEvent);
+uint8_t ES_Fsm_Query(ES_Fsm_t const *pFsm);
+void ES_Fsm_PrintDot(ES_Fsm_t const *pFsm);
+
+#endif /* ES_Fsm_H */
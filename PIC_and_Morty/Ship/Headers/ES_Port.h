@@ -26,8 +26,10 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#ifndef ES_PORT_POSIX
 #include "termio.h"
-#include "bitdefs.h"        /* generic bit defs (BIT0HI, BIT0LO,...) */
+#endif
+#include "BITDEFS.H"        /* generic bit defs (BIT0HI, BIT0LO,...) */
 #include "Bin_Const.h"      /* macros to specify binary constants in C */
 #include "ES_Types.h"
 
@@ -58,6 +60,8 @@
 // The Interrupt Program Status Register (IPSR) contains the exception type number
 // of the current interrupt service routine (ISR)
 // Using TivaWare, CPUcpsid() - IntMasterDisable() calls this. Equivalent to __diable_irq()?
+// The host port (ES_PortPOSIX.c) emulates PRIMASK with a lock shared with the
+// threads that play the part of interrupts, so the same macros work there.
 extern uint32_t _PRIMASK_temp;
 uint32_t CPUgetPRIMASK_cpsid(void);
 void CPUsetPRIMASK(uint32_t newPRIMASK);
@@ -65,6 +69,19 @@ void CPUsetPRIMASK(uint32_t newPRIMASK);
 #define EnterCritical() { _PRIMASK_temp = CPUgetPRIMASK_cpsid(); }
 #define ExitCritical() { CPUsetPRIMASK(_PRIMASK_temp); }
 
+// memory ordering for the lock-free mailboxes (ES_Mailbox.c). A release
+// fence goes between stores that the other side must see in order, an
+// acquire fence between loads that must happen in order. On the single core
+// Tiva a DMB is more than enough, on the host these are real fences between
+// threads.
+#if defined(__ARMCC_VERSION) && (__ARMCC_VERSION < 6000000)
+#define ES_AcquireFence() __dmb(0xF)
+#define ES_ReleaseFence() __dmb(0xF)
+#elif defined(__GNUC__)
+#define ES_AcquireFence() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define ES_ReleaseFence() __atomic_thread_fence(__ATOMIC_RELEASE)
+#endif
+
 /* Rate constants for programming the SysTick Period to generate tick interrupts.
    These assume an 40MHz configuration, they are the values to be used to program
    the SysTick Reload Value (STRELOAD) register. STRELOAD is 24-bits wide and so
@@ -94,12 +111,25 @@ typedef enum
 // and retrieve serial characters, you should write them in ES_Port.c
 #define IsNewKeyReady() (kbhit() != 0)
 #define GetNewKey() getchar()
+#ifdef ES_PORT_POSIX
+int kbhit(void);  // termio.h provides this on the Tiva
+#endif
 
 // prototypes for the hardware specific routines
 void _HW_Timer_Init(TimerRate_t Rate);
 bool _HW_Process_Pending_Ints(void);
 uint16_t _HW_GetTickCount(void);
 void ConsoleInit(void);
+// called by ES_Run each time it finds all of the queues empty, just before it
+// polls the event checkers. On the Tiva there is only something to do in
+// tickless mode (ES_TICKLESS_IDLE in ES_Configure.h), where it sleeps until
+// the next timer expiry, the host port also uses it to move its virtual
+// clock along
+#if defined(ES_PORT_POSIX) || defined(ES_TICKLESS_IDLE)
+void _HW_Idle(void);
+#else
+#define _HW_Idle()
+#endif
 // and the one Framework function that we define here
 uint16_t ES_Timer_GetTime(void);
 
@@ -114,5 +144,28 @@ void _HW_DebugClearLine1(void);
 void _HW_DebugSetLine2(void);
 void _HW_DebugClearLine2(void);
 
+#endif
+
+#ifdef ES_PORT_POSIX
+// host only: choose where the ticks come from. Call before ES_Initialize
+typedef enum
+{
+  HW_CLOCK_WALL,      // a thread ticks at the requested rate in real time
+  HW_CLOCK_VIRTUAL    // time only passes when ES_Run is idle, then it jumps
+}HWClock_t;
+
+void _HW_SelectClock(HWClock_t WhichClock);
+// run ES_Run for NumTicks ticks of framework time then return true, returns
+// false if ES_Run returned on its own (error) before time was up
+bool _HW_RunFor(uint32_t NumTicks);
+// run pISR as if it were an interrupt response: it will not overlap a
+// critical region, the tick or any other simulated interrupt
+void _HW_RaiseInterrupt(void (*pISR)(void));
+// hook called (in interrupt context) after every tick, with the tick count
+void _HW_SetTickHook(void (*pHook)(uint32_t Now));
+// ticks since ES_Initialize, does not wrap at 16 bits like _HW_GetTickCount
+uint32_t _HW_GetElapsedTicks(void);
+// tick interrupts actually delivered, fewer than the ticks when tickless
+uint32_t _HW_GetWakeupCount(void);
 #endif
 #endif
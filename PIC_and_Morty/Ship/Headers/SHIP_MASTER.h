@@ -11,14 +11,15 @@
 // Event Definitions
 #include "ES_Configure.h" /* gets us event definitions */
 #include "ES_Types.h"     /* gets bool type for returns */
+#include "ES_Fsm.h"
 
 // typedefs for the states
-typedef enum
-{
-  Waiting2Pair, 
-  Trying2Pair,
-  Communicating
-}shipState_t;
+#define SHIP_MASTER_STATES(ES_FSM_STATE) \
+  ES_FSM_STATE(Waiting2Pair) \
+  ES_FSM_STATE(Trying2Pair) \
+  ES_FSM_STATE(Communicating)
+
+typedef enum { SHIP_MASTER_STATES(ES_FSM_STATE_NAME) } shipState_t;
 
 
 
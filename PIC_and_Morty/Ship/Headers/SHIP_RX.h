@@ -10,20 +10,21 @@
 // Event Definitions
 #include "ES_Configure.h" /* gets us event definitions */
 #include "ES_Types.h"     /* gets bool type for returns */
+#include "ES_Fsm.h"
 // the common headers for C99 types
 #include <stdint.h>
 #include <stdbool.h>
 
-typedef enum { WaitingForStart, 
-							 WaitingForMSBLen,
-               WaitingForLSBLen,
-               ReceivingData,
-               ReceivingCheckSum} SHIP_RX_State_t ;
+#define SHIP_RX_STATES(ES_FSM_STATE) \
+  ES_FSM_STATE(WaitingForFrame)
+
+typedef enum { SHIP_RX_STATES(ES_FSM_STATE_NAME) } SHIP_RX_State_t ;
 
 // Public Function Prototypes
 bool InitSHIP_RX ( uint8_t Priority );
 bool PostSHIP_RX ( ES_Event_t ThisEvent );
 ES_Event_t RunSHIP_RX( ES_Event_t ThisEvent);
+void SHIP_RX_Byte(uint8_t Byte);
 
 uint16_t QuerySourceAddress(void);
 uint8_t Query_ANSIBLEColour (void);
@@ -0,0 +1,62 @@
+/****************************************************************************
+
+  Header file for the XBee API frame parser, shared by the ANSIBLE and the
+  SHIP. The same file is in both projects, keep them the same.
+
+ ****************************************************************************/
+#ifndef XBeeFrame_H
+#define XBeeFrame_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ES_Configure.h"
+#include "ES_Events.h"
+#include "ES_Pool.h"
+
+#ifndef ES_POOL_LIST
+#error "XBeeFrame needs the event pools, define ES_POOL_LIST in ES_Configure.h"
+#endif
+
+#define XBEE_START_DELIMITER 0x7E
+
+// counts kept by each parser, 32 bits so that they last a long run
+typedef struct
+{
+  uint32_t Frames;        // good frames posted
+  uint32_t BadChecksums;  // complete frames thrown away
+  uint32_t BadLengths;    // length of 0, or bigger than any pool block
+  uint32_t NoBuffers;     // no pool block free, or the post failed
+  uint32_t Timeouts;      // frames given up on part way for a gap
+  uint32_t Discarded;     // bytes thrown away looking for a start
+} XBeeFrameStats_t;
+
+typedef bool XBeeFramePost_t(ES_Event_t ThisEvent);
+
+// one per UART, the fields are private to XBeeFrame.c
+typedef struct
+{
+  XBeeFramePost_t   *pPost;
+  uint16_t          MaxGap;       // ES_Timer ticks allowed between bytes
+  uint16_t          LastTime;
+  uint16_t          Length;
+  uint16_t          Count;
+  uint8_t           State;
+  uint8_t           Sum;
+  ES_PoolHandle_t   Handle;
+  uint8_t           *pData;
+  XBeeFrameStats_t  Stats;
+} XBeeFrameParser_t;
+
+// static initializer, the parser is then ready for bytes without a call to
+// XBeeFrame_Init, which only needs calling to start one over
+#define XBEE_FRAME_PARSER(PostFunc, Gap) \
+  { .pPost = (PostFunc), .MaxGap = (Gap) }
+
+void XBeeFrame_Init(XBeeFrameParser_t *pParser, XBeeFramePost_t *pPost,
+    uint16_t MaxGap);
+void XBeeFrame_ParseByte(XBeeFrameParser_t *pParser, uint8_t Byte);
+XBeeFrameStats_t const *XBeeFrame_GetStats(
+    XBeeFrameParser_t const *pParser);
+
+#endif /* XBeeFrame_H */
@@ -0,0 +1,298 @@
+/****************************************************************************
+ Module
+     ES_Fsm.c
+ Description
+     table driven flat state machines, see ES_Fsm.h for how a machine is
+     described
+ Notes
+     The tables are constant, the only things written at run time are the
+     dispatch table, built once by ES_Fsm_Init, and the current state.
+
+     The lines for one state and event type are chained through pNext in
+     the order they were listed, so dispatch is one look-up in pDispatch
+     and then a walk along that chain, which only has more than one line
+     when Params or guards tell them apart.
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 23:50         started coding
+*****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Fsm.h"
+#include <stdio.h>
+#include <string.h>
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     ES_Fsm_Init
+ Parameters
+     ES_Fsm_t *pFsm, a machine declared with ES_FSM_DEFINE
+ Returns
+     bool, false if the tables are not valid, true otherwise
+ Description
+     checks the tables, builds the dispatch table and puts the machine in
+     its initial state
+ Notes
+     call from the service's init function, it is safe to call again to
+     start the machine over
+ Author
+     10/17/26
+****************************************************************************/
+bool ES_Fsm_Init(ES_Fsm_t *pFsm)
+{
+  ES_FsmTransition_t const  *pTrans;
+  uint8_t                   *pSlot;
+  uint8_t                   i;
+
+  pFsm->IsBuilt = false;
+  if ((pFsm->NumStates >= ES_FSM_SAME_STATE) ||
+      (pFsm->NumTransitions >= ES_FSM_NO_LINE) ||
+      (pFsm->Initial >= pFsm->NumStates))
+  {
+    return false;
+  }
+
+  // chain the lines on each state & event type, working backwards so that
+  // they are tried in the order they were listed
+  memset(pFsm->pDispatch, ES_FSM_NO_LINE,
+      (size_t)pFsm->NumStates * NUM_EVENT_TYPES);
+  for (i = pFsm->NumTransitions; i-- > 0;)
+  {
+    pTrans = &pFsm->pTransitions[i];
+    if ((pTrans->Source >= pFsm->NumStates) ||
+        ((unsigned)pTrans->Event >= NUM_EVENT_TYPES) ||
+        ((pTrans->Target != ES_FSM_SAME_STATE) &&
+        (pTrans->Target >= pFsm->NumStates)))
+    {
+      return false;
+    }
+    pSlot = &pFsm->pDispatch[pTrans->Source * NUM_EVENT_TYPES +
+        pTrans->Event];
+    pFsm->pNext[i] = *pSlot;
+    *pSlot = i;
+  }
+  pFsm->Current = pFsm->Initial;
+  pFsm->IsBuilt = true;
+  return true;
+}
+
+/****************************************************************************
+ Function
+     ES_Fsm_Dispatch
+ Parameters
+     ES_Fsm_t *pFsm, the machine to run
+     ES_Event_t ThisEvent, the event to run it with
+ Returns
+     ES_Event_t, ES_NO_EVENT if a line took the event, otherwise what the
+     default handler returned, ES_ERROR if the machine was never built
+ Description
+     takes the first line for the current state & event type whose Param
+     matches and whose guard passes, runs its action and moves to its target
+ Notes
+     the action sees the machine still in the source state
+ Author
+     10/17/26
+****************************************************************************/
+ES_Event_t ES_Fsm_Dispatch(ES_Fsm_t *pFsm, ES_Event_t ThisEvent)
+{
+  ES_Event_t                ReturnEvent;
+  ES_FsmTransition_t const  *pTrans;
+  uint8_t                   Line = ES_FSM_NO_LINE;
+
+  ReturnEvent.EventType = ES_NO_EVENT;
+  ReturnEvent.EventParam = 0;
+  if (pFsm->IsBuilt != true)
+  {
+    ReturnEvent.EventType = ES_ERROR;
+    return ReturnEvent;
+  }
+  if ((unsigned)ThisEvent.EventType < NUM_EVENT_TYPES)
+  {
+    Line = pFsm->pDispatch[pFsm->Current * NUM_EVENT_TYPES +
+        ThisEvent.EventType];
+  }
+  for (; Line != ES_FSM_NO_LINE; Line = pFsm->pNext[Line])
+  {
+    pTrans = &pFsm->pTransitions[Line];
+    if (((pTrans->Param == ES_FSM_ANY_PARAM) ||
+        (pTrans->Param == ThisEvent.EventParam)) &&
+        ((pTrans->Guard == NULL) || pTrans->Guard(ThisEvent)))
+    {
+      if (pTrans->Action != NULL)
+      {
+        pTrans->Action(ThisEvent);
+      }
+      if (pTrans->Target != ES_FSM_SAME_STATE)
+      {
+        pFsm->Current = pTrans->Target;
+      }
+      return ReturnEvent;
+    }
+  }
+  if (pFsm->Default != NULL)
+  {
+    ReturnEvent = pFsm->Default(ThisEvent);
+  }
+  return ReturnEvent;
+}
+
+/****************************************************************************
+ Function
+     ES_Fsm_Query
+ Parameters
+     ES_Fsm_t const *pFsm, the machine to look at
+ Returns
+     uint8_t, the current state
+ Description
+     None.
+ Notes
+     None.
+ Author
+     10/17/26
+****************************************************************************/
+uint8_t ES_Fsm_Query(ES_Fsm_t const *pFsm)
+{
+  return pFsm->Current;
+}
+
+/****************************************************************************
+ Function
+     ES_Fsm_PrintDot
+ Parameters
+     ES_Fsm_t const *pFsm, the machine to write out
+ Returns
+     nothing
+ Description
+     prints the machine as a Graphviz digraph, one edge per transition line
+     labelled "Event(Param) [Guard] / Action", in the order they are tried
+ Notes
+     capture the terminal output and run it through dot to get a diagram
+ Author
+     10/17/26
+****************************************************************************/
+void ES_Fsm_PrintDot(ES_Fsm_t const *pFsm)
+{
+  ES_FsmTransition_t const      *pTrans;
+  ES_FsmTransitionNames_t const *pNames;
+  uint8_t                       Target;
+  uint8_t                       i;
+
+  printf("digraph %s {\r\n", pFsm->Name);
+  printf("  __start [shape=point];\r\n");
+  printf("  __start -> %s;\r\n", pFsm->pStateNames[pFsm->Initial]);
+  for (i = 0; i < pFsm->NumTransitions; i++)
+  {
+    pTrans = &pFsm->pTransitions[i];
+    pNames = &pFsm->pTransitionNames[i];
+    Target = (pTrans->Target == ES_FSM_SAME_STATE) ? pTrans->Source :
+        pTrans->Target;
+    printf("  %s -> %s [label=\"%s", pFsm->pStateNames[pTrans->Source],
+        pFsm->pStateNames[Target], pNames->Event);
+    if (pTrans->Param != ES_FSM_ANY_PARAM)
+    {
+      printf("(%s)", pNames->Param);
+    }
+    if (pTrans->Guard != NULL)
+    {
+      printf(" [%s]", pNames->Guard);
+    }
+    if (pTrans->Action != NULL)
+    {
+      printf(" / %s", pNames->Action);
+    }
+    printf("\"];\r\n");
+  }
+  printf("}\r\n");
+}
+
+#if defined(TEST) && defined(ES_PORT_POSIX)
+/*
+  Host test of the dispatch rules on a small machine, then the graph of it.
+  Build with:
+  gcc -DTEST -DES_PORT_POSIX -IHeaders Source/ES_Fsm.c
+*/
+#define TEST_TIMER 3
+
+static uint16_t Errors;
+static uint8_t  Opens;
+static bool     IsUnlocked;
+
+static void Check(bool Condition, char const *pWhat)
+{
+  if (Condition != true)
+  {
+    printf("FAILED: %s\n", pWhat);
+    Errors++;
+  }
+}
+
+static bool Unlocked(ES_Event_t ThisEvent)
+{
+  (void)ThisEvent;
+  return IsUnlocked;
+}
+
+static void CountOpen(ES_Event_t ThisEvent)
+{
+  (void)ThisEvent;
+  Opens++;
+}
+
+static ES_Event_t Unexpected(ES_Event_t ThisEvent)
+{
+  (void)ThisEvent;
+  ThisEvent.EventType = ES_ERROR;
+  return ThisEvent;
+}
+
+#define TEST_STATES(ES_FSM_STATE) \
+  ES_FSM_STATE(Closed) \
+  ES_FSM_STATE(Open)
+
+#define TEST_TRANSITIONS(ES_FSM_TRANSITION) \
+  ES_FSM_TRANSITION(Closed, ES_INIT, ES_FSM_ANY_PARAM, NULL, NULL, \
+    ES_FSM_SAME_STATE) \
+  ES_FSM_TRANSITION(Closed, ES_NEW_KEY, 'o', Unlocked, CountOpen, Open) \
+  ES_FSM_TRANSITION(Closed, ES_NEW_KEY, ES_FSM_ANY_PARAM, NULL, NULL, \
+    ES_FSM_SAME_STATE) \
+  ES_FSM_TRANSITION(Open, ES_TIMEOUT, TEST_TIMER, NULL, NULL, Closed)
+
+typedef enum { TEST_STATES(ES_FSM_STATE_NAME) } TestState_t;
+ES_FSM_DEFINE(TestFsm, TEST_STATES, TEST_TRANSITIONS, Closed, Unexpected);
+
+static ES_Event_t Send(ES_EventType_t Type, uint16_t Param)
+{
+  ES_Event_t ThisEvent;
+
+  ThisEvent.EventType = Type;
+  ThisEvent.EventParam = Param;
+  return ES_Fsm_Dispatch(&TestFsm, ThisEvent);
+}
+
+int main(void)
+{
+  Check(Send(ES_INIT, 0).EventType == ES_ERROR, "dispatch before init");
+  Check(ES_Fsm_Init(&TestFsm) == true, "init");
+  Check(Send(ES_INIT, 0).EventType == ES_NO_EVENT, "line to the same state");
+  Check(ES_Fsm_Query(&TestFsm) == Closed, "initial state");
+  Check(Send(ES_NEW_KEY, 'o').EventType == ES_NO_EVENT, "guard fails");
+  Check((ES_Fsm_Query(&TestFsm) == Closed) && (Opens == 0),
+      "falls through to the next line");
+  IsUnlocked = true;
+  Check(Send(ES_NEW_KEY, 'x').EventType == ES_NO_EVENT, "other param");
+  Check(ES_Fsm_Query(&TestFsm) == Closed, "param must match");
+  Send(ES_NEW_KEY, 'o');
+  Check((ES_Fsm_Query(&TestFsm) == Open) && (Opens == 1), "transition");
+  Check(Send(ES_TIMEOUT, TEST_TIMER + 1).EventType == ES_ERROR,
+      "other timer goes to the default");
+  Check(ES_Fsm_Query(&TestFsm) == Open, "default leaves the state");
+  Send(ES_TIMEOUT, TEST_TIMER);
+  Check(ES_Fsm_Query(&TestFsm) == Closed, "timer line");
+  Check(Send(NUM_EVENT_TYPES, 0).EventType == ES_ERROR,
+      "event type off the end of the table");
+  ES_Fsm_PrintDot(&TestFsm);
+  printf("%u errors\n", Errors);
+  return (Errors == 0) ? 0 : 1;
+}
+#endif /* TEST */
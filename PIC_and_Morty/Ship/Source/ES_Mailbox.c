@@ -0,0 +1,227 @@
+/****************************************************************************
+ Module
+     ES_Mailbox.c
+ Description
+     latest-value mailboxes, for handing multi-byte samples from an
+     interrupt response to the services so that they are never read torn
+ Notes
+     Each mailbox is a sequence lock. The writer makes the sequence odd,
+     copies the new value in, then makes it even again. A reader notes the
+     sequence, copies the value out and looks at the sequence again. If it
+     was odd, or has changed, a write overlapped the copy and the reader
+     goes around again. Nothing is ever locked, so the writer never waits
+     and interrupts stay on.
+
+     On the Tiva the writer is an interrupt response, so it always runs to
+     the end before the reader gets to look again, and a reader goes around
+     at most once for each write that lands in the middle of its copy.
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 23:30         started coding
+*****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "ES_Mailbox.h"
+#include "ES_Port.h"
+#include <string.h>
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     ES_Mailbox_Write
+ Parameters
+     ES_Mailbox_t *pBox, the mailbox to write
+     void const *pNewValue, Size bytes to replace the value with
+ Returns
+     nothing
+ Description
+     replaces the value in the mailbox, readers see all of the old value or
+     all of the new one
+ Notes
+     only one writer per mailbox, the writes are not protected from each
+     other
+ Author
+     10/17/26
+****************************************************************************/
+void ES_Mailbox_Write(ES_Mailbox_t *pBox, void const *pNewValue)
+{
+  uint32_t Sequence = pBox->Sequence;
+
+  pBox->Sequence = Sequence + 1;  // odd, a write is under way
+  ES_ReleaseFence();              // which readers must see before the value
+  memcpy(pBox->pValue, pNewValue, pBox->Size);
+  ES_ReleaseFence();              // and the whole value before it is done
+  pBox->Sequence = Sequence + 2;
+}
+
+/****************************************************************************
+ Function
+     ES_Mailbox_Read
+ Parameters
+     ES_Mailbox_t *pBox, the mailbox to read
+     void *pCopy, where to put the Size bytes of the value
+ Returns
+     uint32_t the number of writes so far, 0 if the value has never been
+     written
+ Description
+     copies out the latest value, going around again if a write landed in
+     the middle of the copy
+ Notes
+     the count wraps after 2^31 writes, compare counts by subtracting them
+ Author
+     10/17/26
+****************************************************************************/
+uint32_t ES_Mailbox_Read(ES_Mailbox_t *pBox, void *pCopy)
+{
+  uint32_t Before;
+  uint32_t After;
+
+  do
+  {
+    Before = pBox->Sequence;
+    ES_AcquireFence();
+    memcpy(pCopy, pBox->pValue, pBox->Size);
+    ES_AcquireFence();
+    After = pBox->Sequence;
+  } while ((Before & 1) || (Before != After));
+  return Before >> 1;
+}
+
+/****************************************************************************
+ Function
+     ES_Mailbox_GetCount
+ Parameters
+     ES_Mailbox_t const *pBox, the mailbox to look at
+ Returns
+     uint32_t the number of writes that have finished
+ Description
+     lets a reader find out whether there is anything new without copying
+     the value
+ Notes
+     None.
+ Author
+     10/17/26
+****************************************************************************/
+uint32_t ES_Mailbox_GetCount(ES_Mailbox_t const *pBox)
+{
+  return pBox->Sequence >> 1;
+}
+
+#if defined(TEST) && defined(ES_PORT_POSIX)
+/*
+  Host stress test. One thread plays the interrupt response and writes
+  NUM_TEST_WRITES values into two mailboxes as fast as it can, every word
+  of the big one and every byte of the odd sized one set to the write
+  number. NUM_READERS threads read both all the while and check that each
+  value is from a single write, that it matches the count returned with it
+  and that the counts never go backwards. Build with:
+  gcc -O2 -DTEST -DES_PORT_POSIX -IHeaders Source/ES_Mailbox.c -lpthread
+*/
+#include <stdio.h>
+#include <pthread.h>
+
+#define NUM_TEST_WRITES 5000000UL
+#define NUM_READERS     3
+
+typedef struct
+{
+  uint32_t Words[16];
+}BigValue_t;
+
+typedef struct
+{
+  uint8_t Bytes[3];
+}OddValue_t;
+
+ES_MAILBOX(BigBox, BigValue_t);
+ES_MAILBOX(OddBox, OddValue_t);
+
+static volatile bool WriterDone;
+
+static void *WriterThread(void *pArg)
+{
+  BigValue_t  Big;
+  OddValue_t  Odd;
+  uint32_t    Write;
+  uint8_t     i;
+  (void)pArg;
+
+  for (Write = 1; Write <= NUM_TEST_WRITES; Write++)
+  {
+    for (i = 0; i < 16; i++)
+    {
+      Big.Words[i] = Write;
+    }
+    memset(Odd.Bytes, (uint8_t)Write, sizeof(Odd.Bytes));
+    ES_Mailbox_Write(&BigBox, &Big);
+    ES_Mailbox_Write(&OddBox, &Odd);
+  }
+  WriterDone = true;
+  return NULL;
+}
+
+static void *ReaderThread(void *pArg)
+{
+  uint32_t    *pErrors = pArg;
+  BigValue_t  Big;
+  OddValue_t  Odd;
+  uint32_t    Count;
+  uint32_t    LastBig = 0;
+  uint32_t    LastOdd = 0;
+  uint8_t     i;
+
+  while (WriterDone == false)
+  {
+    Count = ES_Mailbox_Read(&BigBox, &Big);
+    if ((Count < LastBig) || (Big.Words[0] != Count))
+    {
+      (*pErrors)++;
+    }
+    for (i = 1; i < 16; i++)
+    {
+      if (Big.Words[i] != Big.Words[0])
+      {
+        (*pErrors)++;
+      }
+    }
+    LastBig = Count;
+
+    Count = ES_Mailbox_Read(&OddBox, &Odd);
+    if ((Count < LastOdd) || (Odd.Bytes[0] != (uint8_t)Count) ||
+        (Odd.Bytes[1] != Odd.Bytes[0]) || (Odd.Bytes[2] != Odd.Bytes[0]))
+    {
+      (*pErrors)++;
+    }
+    LastOdd = Count;
+  }
+  return NULL;
+}
+
+int main(void)
+{
+  pthread_t Writer;
+  pthread_t Readers[NUM_READERS];
+  uint32_t  Errors[NUM_READERS] = { 0 };
+  uint32_t  TotalErrors = 0;
+  uint8_t   i;
+
+  for (i = 0; i < NUM_READERS; i++)
+  {
+    pthread_create(&Readers[i], NULL, ReaderThread, &Errors[i]);
+  }
+  pthread_create(&Writer, NULL, WriterThread, NULL);
+  pthread_join(Writer, NULL);
+  for (i = 0; i < NUM_READERS; i++)
+  {
+    pthread_join(Readers[i], NULL);
+    TotalErrors += Errors[i];
+  }
+  if (ES_Mailbox_GetCount(&BigBox) != NUM_TEST_WRITES)
+  {
+    TotalErrors++;
+  }
+  printf("%lu writes, %u readers, %u errors\n", NUM_TEST_WRITES, NUM_READERS,
+      TotalErrors);
+  return TotalErrors != 0;
+}
+#endif /* TEST */
@@ -137,15 +137,19 @@ void Init_UART_XBee(void)
   HWREG(UART3_BASE + UART_O_FBRD) = 0x1B;
   
   // Write the desired serial parameters to the UART_LCRH register
-  // We want 8 bits
-  HWREG(UART3_BASE + UART_O_LCRH) |= UART_LCRH_WLEN_8;
+  // We want 8 bits, and the 16 byte FIFOs
+  HWREG(UART3_BASE + UART_O_LCRH) |= (UART_LCRH_WLEN_8 | UART_LCRH_FEN);
+  
+  // TX interrupt when the TX FIFO is down to 2 bytes, RX interrupt when the
+  // RX FIFO is half full, the receive time out picks up the rest
+  HWREG(UART3_BASE + UART_O_IFLS) = (UART_IFLS_TX1_8 | UART_IFLS_RX4_8);
   
   // Set Recieve, Transmit, and End of Transmission bits
   // Enable UART
   HWREG(UART3_BASE + UART_O_CTL) |= ( UART_CTL_RXE |UART_CTL_TXE | UART_CTL_UARTEN);
   
-  // Enable Interrupts for TX and RX
-  HWREG(UART3_BASE + UART_O_IM) |= (UART_IM_RXIM | UART_IM_TXIM);
+  // Enable Interrupts for TX and RX, and the RX time out
+  HWREG(UART3_BASE + UART_O_IM) |= (UART_IM_RXIM | UART_IM_RTIM | UART_IM_TXIM);
   
   // Enable NVIC interrupts
   HWREG(NVIC_EN1) |= BIT27HI;
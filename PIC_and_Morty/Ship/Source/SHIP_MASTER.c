@@ -52,6 +52,17 @@
 */
 static bool getHomeTeamColor(void);
 
+static bool IsHomeTeamFueled(ES_Event_t ThisEvent);
+static bool IsNewAnsibleUnfueled(ES_Event_t ThisEvent);
+static bool IsOutOfFuel(ES_Event_t ThisEvent);
+static bool IsOtherTeamRefueled(ES_Event_t ThisEvent);
+static void StartPairing(ES_Event_t ThisEvent);
+static void ResendPairAck(ES_Event_t ThisEvent);
+static void StartCommunicating(ES_Event_t ThisEvent);
+static void ServeControlPacket(ES_Event_t ThisEvent);
+static void StopBoat(ES_Event_t ThisEvent);
+static void LoseLink(ES_Event_t ThisEvent);
+
 /*FOR TESTING ONLYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYYY*/
 static void sendPairAck(void); 
 static void sendStatusPacket(void); 
@@ -59,9 +70,32 @@ static void executeControlPacketCommands(void);
 
 
 /*---------------------------- Module Variables ---------------------------*/
-// everybody needs a state variable, you may need others as well.
-// type of state variable should match htat of enum in header file
-static shipState_t CurrentState;
+// the machine, one line per transition, tried in order. A pair request
+// from the home team is taken while fueled, from any other ANSIBLE than
+// the last one while not
+#define SHIP_MASTER_TRANSITIONS(ES_FSM_TRANSITION) \
+  ES_FSM_TRANSITION(Waiting2Pair, ES_PAIR_REQUEST, ES_FSM_ANY_PARAM, \
+    IsHomeTeamFueled, StartPairing, Trying2Pair) \
+  ES_FSM_TRANSITION(Waiting2Pair, ES_PAIR_REQUEST, ES_FSM_ANY_PARAM, \
+    IsNewAnsibleUnfueled, StartPairing, Trying2Pair) \
+  ES_FSM_TRANSITION(Trying2Pair, ES_TIMEOUT, PAIR_ATTEMPT_SHIP_TIMER, NULL, \
+    ResendPairAck, ES_FSM_SAME_STATE) \
+  ES_FSM_TRANSITION(Trying2Pair, ES_TIMEOUT, PAIR_TIMEOUT_SHIP_TIMER, NULL, \
+    NULL, Waiting2Pair) \
+  ES_FSM_TRANSITION(Trying2Pair, ES_CONTROL_PACKET, ES_FSM_ANY_PARAM, NULL, \
+    StartCommunicating, Communicating) \
+  ES_FSM_TRANSITION(Communicating, ES_CONTROL_PACKET, ES_FSM_ANY_PARAM, \
+    IsOutOfFuel, StopBoat, Waiting2Pair) \
+  ES_FSM_TRANSITION(Communicating, ES_CONTROL_PACKET, ES_FSM_ANY_PARAM, \
+    IsOtherTeamRefueled, StopBoat, Waiting2Pair) \
+  ES_FSM_TRANSITION(Communicating, ES_CONTROL_PACKET, ES_FSM_ANY_PARAM, \
+    NULL, ServeControlPacket, ES_FSM_SAME_STATE) \
+  ES_FSM_TRANSITION(Communicating, ES_TIMEOUT, PAIR_TIMEOUT_SHIP_TIMER, \
+    NULL, LoseLink, Waiting2Pair)
+
+ES_FSM_DEFINE(SHIP_MASTER_Fsm, SHIP_MASTER_STATES, SHIP_MASTER_TRANSITIONS,
+    Waiting2Pair, NULL);
+
 static uint8_t MyPriority;
 static uint32_t lastAnsAddr = 0; 
 static bool homeTeamColorisRed; 
@@ -101,7 +135,10 @@ bool InitSHIP_MASTER(uint8_t Priority)
 
   MyPriority = Priority;
   // put us into the Initial PseudoState
-  CurrentState = Waiting2Pair;
+  if (ES_Fsm_Init(&SHIP_MASTER_Fsm) != true)
+  {
+    return false;
+  }
   
   #ifdef DEBUG_PRINTF
   printf("\r\nINIT STATE: Waiting2Pair");
@@ -159,166 +196,34 @@ bool PostSHIP_MASTER(ES_Event_t ThisEvent)
  Description
    add your description here
  Notes
-   uses nested switch/case to implement the machine.
+   the machine is the SHIP_MASTER_TRANSITIONS table, events that no line
+   takes are ignored. The fuel switch is sampled here, on every event, so
+   that a change shows up on the next control packet.
  Author
    J. Edward Carryer, 01/15/12, 15:23
 ****************************************************************************/
 ES_Event_t RunSHIP_MASTER(ES_Event_t ThisEvent)
 {
   ES_Event_t ReturnEvent;
-  ReturnEvent.EventType = ES_NO_EVENT; // assume no errors
+  shipState_t LastState = ES_Fsm_Query(&SHIP_MASTER_Fsm);
 
-  switch (CurrentState)
+  if (LastState == Waiting2Pair)
   {
-    case Waiting2Pair:      
-    {
-      setCurrTeamLED(PURPLE); 
-      LastFuel = QueryFuelEmpty();
-      
-      if(ThisEvent.EventType == ES_PAIR_REQUEST){  /*received 0x01 packet*/
-        //guard: if fueled, then only the home team can connect 
-        if(QueryFuelEmpty() && (Query_ANSIBLEColour() == homeTeamColorisRed)){ 
-          //start pairing timer (1sec)
-          ES_Timer_InitTimer(PAIR_TIMEOUT_SHIP_TIMER, PAIR_TIMEOUT_TIME);
-          //start attempt timer (200ms)
-          ES_Timer_InitTimer(PAIR_ATTEMPT_SHIP_TIMER, PAIR_ATTEMPT_TIME);          
-          //send Pair_Ack Packet (0x02) 
-          //sendPairAck(); 
-          CurrentState = Trying2Pair; 
-          
-          #ifdef DEBUG_PRINTF
-          printf("\r\nSTATE TRANSITION: Waiting2Pair - Trying2Pair"); 
-          #endif
-        }
-        else if(!QueryFuelEmpty() && (lastAnsAddr != QuerySourceAddress())){
-          //start pairing timer (1sec)
-          ES_Timer_InitTimer(PAIR_TIMEOUT_SHIP_TIMER, PAIR_TIMEOUT_TIME);
-          //start attempt timer (200ms) 
-          ES_Timer_InitTimer(PAIR_ATTEMPT_SHIP_TIMER, PAIR_ATTEMPT_TIME);
-          //send Pair_Ack Packet (0x02)
-          //sendPairAck(); 
-          CurrentState = Trying2Pair;
-          
-          #ifdef DEBUG_PRINTF
-          printf("\r\nSTATE TRANSITION: Waiting2Pair - Trying2Pair"); 
-          #endif
-        }
-      }
-    }
-    break;
+    setCurrTeamLED(PURPLE); 
+    LastFuel = QueryFuelEmpty();
+  }
+  else if (LastState == Communicating)
+  {
+    CurrentFuel = QueryFuelEmpty();
+    lastAnsAddr = QuerySourceAddress(); 
+  }
 
-    case Trying2Pair:  //make 4 more attempts at sending 0x02 packet in case first one not read 
-    {
-      if(ThisEvent.EventType == ES_TIMEOUT){
-        if(ThisEvent.EventParam == PAIR_ATTEMPT_SHIP_TIMER){
-          //200 ms timer has timeout, just resend 0x02 packet and restart 200ms timer 
-          ES_Timer_InitTimer(PAIR_ATTEMPT_SHIP_TIMER, PAIR_ATTEMPT_TIME);
-          sendPairAck();
-        }
-        else if(ThisEvent.EventParam == PAIR_TIMEOUT_SHIP_TIMER){
-          CurrentState = Waiting2Pair; 
-          
-          #ifdef DEBUG_PRINTF
-          printf("\r\nSTATE TRANSITION: Trying2Pair - Waiting2Pair");
-          #endif
-        }
-        
-      }
-      else if(ThisEvent.EventType == ES_CONTROL_PACKET){  /*Control packet 0x03 received*/
-        sendStatusPacket(); //0x04
-        //restart 1 sec pairing timeout timer
-        ES_Timer_InitTimer(PAIR_TIMEOUT_SHIP_TIMER, PAIR_TIMEOUT_TIME);
-        executeControlPacketCommands(); 
-        
-        CurrentState = Communicating;
-        
-        #ifdef DEBUG_PRINTF
-        printf("\r\nSTATE TRANSITION: Trying2Pair - Communicating");
-        #endif
-        
-        // Turn on LED ANSIBLE Color
-        if(Query_ANSIBLEColour()){
-          setCurrTeamLED(RED); 
-        }
-        else 
-          setCurrTeamLED(BLUE); 
-        
-      }
-    }
-    break;
-    
-    case Communicating:  //regular paired state
-    {
-      CurrentFuel = QueryFuelEmpty();
-      lastAnsAddr = QuerySourceAddress(); 
-      
-      if(ThisEvent.EventType == ES_CONTROL_PACKET){  /*Control packet 0x03 received*/
-        if(!CurrentFuel && (LastFuel != CurrentFuel))
-        {
-          StopFanMotors();
-          CurrentState = Waiting2Pair; 
-          
-          #ifdef DEBUG_PRINTF
-          printf("\r\nOut of Fuel");
-          printf("\r\nSTATE TRANSITION: Communicating - Waiting2Pair");
-          #endif
-        }
-        else if ((CurrentFuel && (LastFuel != CurrentFuel)) && (Query_ANSIBLEColour() != homeTeamColorisRed))
-        {
-          StopFanMotors(); 
-          CurrentState = Waiting2Pair; 
-          
-          #ifdef DEBUG_PRINTF
-          printf("\r\nOpposite team kicked out"); 
-          printf("\r\nIn Waiting2Pair now");
-          #endif
-        }
-        else
-        {
-          sendStatusPacket(); //0x04
-          //restart 1 sec pairing timeout timer
-          ES_Timer_InitTimer(PAIR_TIMEOUT_SHIP_TIMER, PAIR_TIMEOUT_TIME);
-          executeControlPacketCommands(); 
-        }          
-      }
-      else if(ThisEvent.EventType == ES_TIMEOUT && ThisEvent.EventParam == PAIR_TIMEOUT_SHIP_TIMER){
-        //one sec pairing timer has timed out 
-        StopFanMotors(); 
-        CurrentState = Waiting2Pair;
-        //powerFuelLEDs(false);
-        setCurrTeamLED(PURPLE); 
-        
-        #ifdef DEBUG_PRINTF
-        printf("\r\nONE_SEC Timer Timeout");
-        printf("\r\nSTATE TRANSITION: Communicating - Waiting2Pair");
-        #endif
-      } 
-//      else if(!CurrentFuel && (LastFuel != CurrentFuel)){  /*Out of fuel event*/
-//        powerFuelLEDs(false);
-//        StopFanMotors();
-//        lastAnsAddr = Query_ANSIBLEColour(); 
-//        CurrentState = Waiting2Pair; 
-//        
-//        #ifdef DEBUG_PRINTF
-//        printf("\r\nOut of Fuel");
-//        printf("\r\nSTATE TRANSITION: Communicating - Waiting2Pair");
-//        #endif
-//      }
-//      else if((CurrentFuel && (LastFuel != CurrentFuel)) && (Query_ANSIBLEColour() != homeTeamColorisRed)){  /*Refueled Event*/
-//        StopFanMotors(); 
-//        CurrentState = Waiting2Pair; 
-//        
-//        #ifdef DEBUG_PRINTF
-//        printf("\r\nOpposite team kicked out"); 
-//        printf("\r\nIn Waiting2Pair now");
-//        #endif
-//      }
-                  
-      LastFuel = CurrentFuel;      
-    }
-    break;
-        
-  }                                  
+  ReturnEvent = ES_Fsm_Dispatch(&SHIP_MASTER_Fsm, ThisEvent);
+
+  if (LastState == Communicating)
+  {
+    LastFuel = CurrentFuel;      
+  }
   return ReturnEvent;
 }
 
@@ -344,7 +249,7 @@ ES_Event_t RunSHIP_MASTER(ES_Event_t ThisEvent)
 ****************************************************************************/
 shipState_t QueryCommunicationSM(void)
 {
-  return CurrentState;
+  return (shipState_t)ES_Fsm_Query(&SHIP_MASTER_Fsm);
 }
 
 
@@ -368,6 +273,95 @@ bool getHomeTeamColor(void)
   }    
 }
 
+static bool IsHomeTeamFueled(ES_Event_t ThisEvent)
+{
+  //guard: if fueled, then only the home team can connect 
+  return QueryFuelEmpty() && (Query_ANSIBLEColour() == homeTeamColorisRed);
+}
+
+static bool IsNewAnsibleUnfueled(ES_Event_t ThisEvent)
+{
+  return !QueryFuelEmpty() && (lastAnsAddr != QuerySourceAddress());
+}
+
+static bool IsOutOfFuel(ES_Event_t ThisEvent)
+{
+  return !CurrentFuel && (LastFuel != CurrentFuel);
+}
+
+static bool IsOtherTeamRefueled(ES_Event_t ThisEvent)
+{
+  return (CurrentFuel && (LastFuel != CurrentFuel)) &&
+      (Query_ANSIBLEColour() != homeTeamColorisRed);
+}
+
+static void StartPairing(ES_Event_t ThisEvent)
+{
+  //start pairing timer (1sec)
+  ES_Timer_InitTimer(PAIR_TIMEOUT_SHIP_TIMER, PAIR_TIMEOUT_TIME);
+  //start attempt timer (200ms)
+  ES_Timer_InitTimer(PAIR_ATTEMPT_SHIP_TIMER, PAIR_ATTEMPT_TIME);          
+  //send Pair_Ack Packet (0x02) 
+  //sendPairAck(); 
+  
+  #ifdef DEBUG_PRINTF
+  printf("\r\nSTATE TRANSITION: Waiting2Pair - Trying2Pair"); 
+  #endif
+}
+
+static void ResendPairAck(ES_Event_t ThisEvent)
+{
+  //200 ms timer has timeout, just resend 0x02 packet and restart 200ms timer 
+  ES_Timer_InitTimer(PAIR_ATTEMPT_SHIP_TIMER, PAIR_ATTEMPT_TIME);
+  sendPairAck();
+}
+
+static void StartCommunicating(ES_Event_t ThisEvent)
+{
+  ServeControlPacket(ThisEvent);
+  
+  #ifdef DEBUG_PRINTF
+  printf("\r\nSTATE TRANSITION: Trying2Pair - Communicating");
+  #endif
+  
+  // Turn on LED ANSIBLE Color
+  if(Query_ANSIBLEColour()){
+    setCurrTeamLED(RED); 
+  }
+  else 
+    setCurrTeamLED(BLUE); 
+}
+
+static void ServeControlPacket(ES_Event_t ThisEvent)
+{
+  sendStatusPacket(); //0x04
+  //restart 1 sec pairing timeout timer
+  ES_Timer_InitTimer(PAIR_TIMEOUT_SHIP_TIMER, PAIR_TIMEOUT_TIME);
+  executeControlPacketCommands(); 
+}
+
+static void StopBoat(ES_Event_t ThisEvent)
+{
+  StopFanMotors();
+  
+  #ifdef DEBUG_PRINTF
+  printf("\r\nSTATE TRANSITION: Communicating - Waiting2Pair");
+  #endif
+}
+
+static void LoseLink(ES_Event_t ThisEvent)
+{
+  //one sec pairing timer has timed out 
+  StopFanMotors(); 
+  //powerFuelLEDs(false);
+  setCurrTeamLED(PURPLE); 
+  
+  #ifdef DEBUG_PRINTF
+  printf("\r\nONE_SEC Timer Timeout");
+  printf("\r\nSTATE TRANSITION: Communicating - Waiting2Pair");
+  #endif
+}
+
 static void sendPairAck(void)
 {
   ES_Event_t ThisEvent;
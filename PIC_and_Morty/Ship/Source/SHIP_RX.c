@@ -20,6 +20,8 @@ Notes
 #include "ES_Configure.h"
 #include "ES_Framework.h"
 
+#include <string.h>
+
 #include "inc/hw_memmap.h"
 #include "inc/hw_types.h"
 #include "inc/hw_gpio.h"
@@ -42,58 +44,35 @@ Notes
 #include "SHIP_RX.h"
 #include "SHIP_TX.h"
 #include "Init_UART.h"
+#include "XBeeFrame.h"
+#include "XBeeCodec.h"
 
 /*----------------------------- Module Defines ----------------------------*/
-// Timer lengths
+// longest gap between the bytes of a frame
 #define RX_PERIOD   200   // 200 ms (5Hz transmission rate) 
 
-// XBee API Defines
-#define START_DELIMITER           0x7E
-#define API_IDENTIFIER            0x81
-#define TX_STATUS_API_IDENTIFIER  0x89
-#define OPTIONS                   0x00
-
-// Class Protocol Defines
-#define REQ_2_PAIR_HEADER  0x01
-#define BLUE               0x00
-#define RED                0x01
-
-#define PAIR_ACK_HEADER    0x02
-
-#define CTRL_HEADER        0x03
-
-#define STATUS_HEADER      0x04
-
-// Frame Data Indices
-#define API_IDENTIFIER_IDX      0
-#define SOURCE_ADDRESS_MSB_IDX  1
-#define SOURCE_ADDRESS_LSB_IDX  2
-#define RSSI_IDX                3
-#define OPTIONS_IDX             4
-#define DATA_HEADER_IDX         5
-
-// TX Status Packet
-#define TX_STATUS_IDX           5
-
-#define TX_SUCCESS              0
-#define TX_NO_ACK               1
-#define TX_CCA_FAIL             2
-
 /*---------------------------- Module Functions ---------------------------*/
 /* prototypes for private functions for this machine.They should be functions
    relevant to the behavior of this state machine
 */
+static void HandleFrame(ES_Event_t ThisEvent);
 
 
 /*---------------------------- Module Variables ---------------------------*/
-// everybody needs a state variable, you may need others as well.
-// type of state variable should match htat of enum in header file
+// the machine, one line per transition, tried in order. The frames are
+// taken apart in the UART interrupt, one event per good frame comes here
+#define SHIP_RX_TRANSITIONS(ES_FSM_TRANSITION) \
+  ES_FSM_TRANSITION(WaitingForFrame, FRAME_RECEIVED, ES_FSM_ANY_PARAM, NULL, \
+    HandleFrame, ES_FSM_SAME_STATE)
+
+ES_FSM_DEFINE(SHIP_RX_Fsm, SHIP_RX_STATES, SHIP_RX_TRANSITIONS,
+    WaitingForFrame, NULL);
 
-static SHIP_RX_State_t CurrentState;
+// the XBee API frame parser for UART3, ready for bytes as soon as
+// Init_UART_XBee turns the receive interrupt on
+static XBeeFrameParser_t Parser = XBEE_FRAME_PARSER(PostSHIP_RX, RX_PERIOD);
 
-static uint16_t DataLength;
-static uint8_t  RX_FrameData[100];
-static uint8_t  RX_ControlData[10];
+static uint8_t  RX_ControlData[XBEE_MAX_PAYLOAD];
 static uint16_t SourceAddress;
 static uint8_t  ANSIBLEColour;
 
@@ -125,7 +104,10 @@ bool InitSHIP_RX ( uint8_t Priority )
 
   MyPriority = Priority;
   // First state is waiting for 0x7E
-  CurrentState = WaitingForStart;
+  if (ES_Fsm_Init(&SHIP_RX_Fsm) != true)
+  {
+    return false;
+  }
   // post the initial transition event
   ThisEvent.EventType = ES_INIT;
   // any other initializations
@@ -171,184 +153,40 @@ Returns
   ES_Event, ES_NO_EVENT if no error ES_ERROR otherwise
 
 Description
-  add your description here
+  handles the good XBee API frames from the UART interrupt
 
 Notes
-  uses nested switch/case to implement the machine.
+  the machine is the SHIP_RX_TRANSITIONS table, events that no line takes
+  are ignored
 
 ****************************************************************************/
 ES_Event_t RunSHIP_RX( ES_Event_t ThisEvent)
 {
-  ES_Event_t ReturnEvent;
-  ReturnEvent.EventType = ES_NO_EVENT; // assume no errors
-  
-  static uint8_t IDX;
-  static uint8_t CheckSum;
+  return ES_Fsm_Dispatch(&SHIP_RX_Fsm, ThisEvent);
+}
 
-  switch ( CurrentState )
-  {
-    case WaitingForStart :
-      if((ThisEvent.EventType == BYTE_RECEIVED) && (ThisEvent.EventParam == START_DELIMITER))
-      {
-        //printf("\r\n%X",ThisEvent.EventParam);
-        ES_Timer_InitTimer(BYTE_TIMER, RX_PERIOD);
-        DataLength = 0;
-        CurrentState = WaitingForMSBLen;
-      }     
-      break;
-      
-    case WaitingForMSBLen :
-      if ((ThisEvent.EventType == ES_TIMEOUT) && (ThisEvent.EventParam == BYTE_TIMER))
-      {
-        // Didn't receive a byte in time
-        
-        // Go back to WaitingForStart
-        CurrentState = WaitingForStart;
-      }
-      else if (ThisEvent.EventType == BYTE_RECEIVED)
-      { 
-        // Received byte in time
-        //printf("\r\n%X",ThisEvent.EventParam);
-        // Start BYTE_TIMER again
-        ES_Timer_InitTimer(BYTE_TIMER, RX_PERIOD);
-        
-        // Record MSB of data length
-        DataLength |= (ThisEvent.EventParam << 8);
-
-        CurrentState = WaitingForLSBLen;
-      }
-      break;  
-      
-    case WaitingForLSBLen:
-      if ((ThisEvent.EventType == ES_TIMEOUT) && (ThisEvent.EventParam == BYTE_TIMER))
-      {
-        // Didn't receive a byte in time
-        
-        // Go back to WaitingForStart
-        CurrentState = WaitingForStart;
-      }
-      else if (ThisEvent.EventType == BYTE_RECEIVED) 
-      {
-        //printf("\r\n%X",ThisEvent.EventParam);
-        
-        ES_Timer_InitTimer(BYTE_TIMER, RX_PERIOD);
-
-        DataLength |= ThisEvent.EventParam;
-        //printf("\r\n DataLength = %04X", DataLength);
-
-        CheckSum = 0xFF;
-
-        IDX = 0;
-        
-        CurrentState = ReceivingData;
-      }
-      break;     
-
-    case ReceivingData: 
-      if ((ThisEvent.EventType == ES_TIMEOUT) && (ThisEvent.EventParam == BYTE_TIMER))
-      {
-        CurrentState = WaitingForStart;
-      }
-      else if (ThisEvent.EventType == BYTE_RECEIVED)
-      {
-        //printf("\r\n%X",ThisEvent.EventParam);
-        
-        ES_Timer_InitTimer(BYTE_TIMER, RX_PERIOD);
-        
-        // First will be API Identifier (0x81), then Source Address (0x20 and 0x8_)
-        // then RSSI (signal strength), then Options (0x00), then data
-        RX_FrameData[IDX] = ThisEvent.EventParam;
-        //printf("\r\nIDX: %d BYTE: %X", IDX, ThisEvent.EventParam);
-        IDX++;
-        CheckSum -= ThisEvent.EventParam;
-        
-        if (IDX == DataLength)
-        {
-          CurrentState = ReceivingCheckSum;
-        }
-        
-      }
-      break;
-      
-    case ReceivingCheckSum:
-      if ((ThisEvent.EventType == ES_TIMEOUT) && (ThisEvent.EventParam == BYTE_TIMER))
-      {
-        CurrentState = WaitingForStart; //Go back to waiting for a start byte
-      }
-      else if (ThisEvent.EventType == BYTE_RECEIVED)
-      {
-
-        if (ThisEvent.EventParam == CheckSum)
-        {
-          //printf("\r\n%X",ThisEvent.EventParam);
-          //printf("\r\n ");
-          
-          // If message is TX_STATUS (MIGHT BE UNNESSARY)
-//          if (RX_FrameData[API_IDENTIFIER_IDX] == TX_STATUS_API_IDENTIFIER)
-//          {
-//            // If message failed (MIGHT BE UNNESSARY)
-//            if ( (RX_FrameData[TX_STATUS_IDX] == TX_NO_ACK) || (RX_FrameData[TX_STATUS_IDX] == TX_CCA_FAIL))
-//            {
-//              // Send failed message event
-//              ThisEvent.EventType = ES_TX_FAIL;
-//              
-//              // UNCOMMENT
-//              PostSHIP_MASTER(ThisEvent);
-//            }
-//          }
-          
-          // If message is data packet
-          if (RX_FrameData[API_IDENTIFIER_IDX] == API_IDENTIFIER)
-          {
-            if (RX_FrameData[DATA_HEADER_IDX] == CTRL_HEADER)
-            {
-              //printf("\r\nCTRL RXed");
-              
-              static uint8_t i;
-                           
-              // Post to MasterSM that control packet was received
-              
-              // UNCOMMENT
-              ThisEvent.EventType = ES_CONTROL_PACKET;
-              PostSHIP_MASTER(ThisEvent);
-                
-              // Build array containing just the control data 
-              for (i=0;i<5;i++)
-              {
-                RX_ControlData[i] = RX_FrameData[i+6];
-              }
-            }
-
-            // if req_2_pair packet, save ansible colour
-            else if (RX_FrameData[DATA_HEADER_IDX] == REQ_2_PAIR_HEADER)
-            {
-              //printf("\r\nREQ_2_PAIR RXed");
-                
-              // Save source address
-              SourceAddress = 0x00;
-              SourceAddress |= ((uint16_t) RX_FrameData[SOURCE_ADDRESS_MSB_IDX])<<8;
-              SourceAddress |= (uint16_t) RX_FrameData[SOURCE_ADDRESS_LSB_IDX];
-                
-              ANSIBLEColour = RX_FrameData[6];
-              
-              // UNCOMMENT
-              ThisEvent.EventType = ES_PAIR_REQUEST;
-              PostSHIP_MASTER(ThisEvent);
-            }
-                         
-            // Send packet received event, param = message header
-            ThisEvent.EventType = PACKET_RECEIVED;
-          
-            // UNCOMMENT
-            PostSHIP_MASTER(ThisEvent);
-          }
-        }
-        CurrentState = WaitingForStart;
-      }
-      break;
-    }
-  return ReturnEvent;
-}  
+/****************************************************************************
+Function
+  SHIP_RX_Byte
+
+Parameters
+  uint8_t : a byte from the XBee
+
+Returns
+  nothing
+
+Description
+  hands a received byte to the frame parser, which posts FRAME_RECEIVED to
+  this service when it completes a good frame
+
+Notes
+  called from SHIP_XBEE_ISR for each byte waiting in the UART
+
+****************************************************************************/
+void SHIP_RX_Byte(uint8_t Byte)
+{
+  XBeeFrame_ParseByte(&Parser, Byte);
+}
 
 /****************************************************************************
 Function
@@ -390,25 +228,78 @@ uint8_t Query_ANSIBLEColour (void)
 
 uint8_t Query_FB (void)
 {
-  return RX_ControlData[0];
+  return RX_ControlData[XBEE_CTRL_FB];
 }
 
 uint8_t Query_LR (void)
 {
-  return RX_ControlData[1];
+  return RX_ControlData[XBEE_CTRL_LR];
 }
 
 //uint8_t Query_TurretR (void)
 //{
-//  return RX_ControlData[2];
+//  return RX_ControlData[XBEE_CTRL_TURRET_YAW];
 //}
 
 //uint8_t Query_TurretP (void)
 //{
-//  return RX_ControlData[3];
+//  return RX_ControlData[XBEE_CTRL_TURRET_PITCH];
 //}
 
 uint8_t Query_CTRL (void)
 {
-  return RX_ControlData[4];
+  return RX_ControlData[XBEE_CTRL_CONTROL];
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+/****************************************************************************
+Function
+  HandleFrame
+
+Parameters
+  ES_Event_t : the FRAME_RECEIVED event, its EventParam is the pool handle
+  of the frame data
+
+Description
+  if the frame is a packet from an ANSIBLE, keeps the control data or the
+  pairing details and tells SHIP_MASTER about it
+
+Notes
+  the framework frees the block after this returns
+
+****************************************************************************/
+static void HandleFrame(ES_Event_t ThisEvent)
+{
+  XBeePacket_t  RXPacket;
+  ES_Event_t    PostEvent;
+
+  if ((XBeeCodec_Decode(ES_Pool_GetPtr(ThisEvent.EventParam),
+      ES_Pool_GetLength(ThisEvent.EventParam), &RXPacket) != true) ||
+      (RXPacket.Api != XBEE_RX_PACKET))
+  {
+    return;
+  }
+  PostEvent.EventParam = 0;
+  if (RXPacket.Message == XBEE_CTRL)
+  {
+    // Keep just the control data 
+    memcpy(RX_ControlData, RXPacket.Payload, sizeof(RX_ControlData));
+    // Post to MasterSM that control packet was received
+    PostEvent.EventType = ES_CONTROL_PACKET;
+    PostSHIP_MASTER(PostEvent);
+  }
+  // if req_2_pair packet, save ansible colour
+  else if (RXPacket.Message == XBEE_REQ_2_PAIR)
+  {
+    // Save source address
+    SourceAddress = RXPacket.Address;
+    ANSIBLEColour = RXPacket.Payload[XBEE_REQ_2_PAIR_COLOUR];
+    PostEvent.EventType = ES_PAIR_REQUEST;
+    PostSHIP_MASTER(PostEvent);
+  }
+  // Send packet received event
+  PostEvent.EventType = PACKET_RECEIVED;
+  PostSHIP_MASTER(PostEvent);
 }
@@ -42,55 +42,20 @@ Notes
 #include "SHIP_TX.h"
 #include "SHIP_PIC_RX.h"
 #include "Init_UART.h"
+#include "XBeeCodec.h"
 
 /*----------------------------- Module Defines ----------------------------*/
 // XBee API Defines
-#define START_DELIMITER    0x7E
-#define API_IDENTIFIER     0x01
 #define FRAME_ID           0x01
 #define OPTIONS            0x00
 
-// Class Protocol Defines
-#define REQ_2_PAIR_HEADER  0x01
-#define BLUE               0x00
-#define RED                0x01
-
-#define PAIR_ACK_HEADER    0x02
-
-#define CTRL_HEADER        0x03
-
-#define STATUS_HEADER      0x04
-
-// Frame Data Indices
-#define API_IDENTIFIER_IDX      0
-#define SOURCE_ADDRESS_MSB_IDX  1
-#define SOURCE_ADDRESS_LSB_IDX  2
-#define RSSI_IDX                3
-#define OPTIONS_IDX             4
-#define DATA_HEADER_IDX         5
-#define PAIR_ACK_MAX_IDX        9
-#define STATUS_MAX_IDX          11
-
-// TX Status Packet
-#define TX_STATUS_IDX           5
-
-#define TX_SUCCESS              0
-#define TX_NO_ACK               1
-#define TX_CCA_FAIL             2
-
-// Data Length
-#define LENGTH_MSB_PAIR_ACK     0x00
-#define LENGTH_LSB_PAIR_ACK     0x06
-#define LENGTH_MSB_STATUS       0x00
-#define LENGTH_LSB_STATUS       0x08
-
 
 /*---------------------------- Module Functions ---------------------------*/
 /* prototypes for private functions for this machine.They should be functions
    relevant to the behavior of this state machine
 */
 static void BuildPacket(ES_Event_t ThisEvent);
-static uint8_t CheckSum(uint8_t CHECKSUM_INDEX);
+static void FillTXFIFO(void);
 
 /*---------------------------- Module Variables ---------------------------*/
 // everybody needs a state variable, you may need others as well.
@@ -100,7 +65,7 @@ static SHIP_TX_State_t CurrentState;
 
 static uint8_t IDX = 0;
 static uint8_t DataLength;
-static uint8_t Packet[100];
+static uint8_t Packet[XBEE_MAX_FRAME];
 
 static uint16_t SourceAddress;
 
@@ -195,15 +160,15 @@ ES_Event_t RunSHIP_TX( ES_Event_t ThisEvent)
         // Construct Data Packet
         BuildPacket(ThisEvent);
 
-        if (HWREG(UART3_BASE + UART_O_FR) & UART_FR_TXFE) // (Room to TX byte)
+        if ((DataLength != 0) &&
+            !(HWREG(UART3_BASE + UART_O_FR) & UART_FR_TXFF)) // (Room to TX byte)
         {
-          // TX Byte
-          HWREG(UART3_BASE + UART_O_DR) = Packet[IDX];
+          // TX as much as the FIFO takes, the ISR tops it up
+          FillTXFIFO();
           
           // Disable RX and Enable TX Interrupt
-          HWREG(UART3_BASE + UART_O_IM) &= ~UART_IM_RXIM;  
+          HWREG(UART3_BASE + UART_O_IM) &= ~(UART_IM_RXIM | UART_IM_RTIM);
           HWREG(UART3_BASE + UART_O_IM) |= UART_IM_TXIM;        
-          IDX++;
           
           CurrentState = SendingTX;    
         }
@@ -242,37 +207,38 @@ void SHIP_XBEE_ISR(void)
   static ES_Event_t ThisEvent;
   //printf("\r\nISR Bitch");
   
-  // XBee TX
+  // XBee TX, the TX FIFO is down to 2 bytes
   if(HWREG(UART3_BASE + UART_O_MIS) & UART_MIS_TXMIS)
   {
     // Clear interrupt
-		HWREG(UART3_BASE + UART_O_ICR) |= UART_ICR_TXIC;
-		
-		//Write next byte to DR
-		HWREG(UART3_BASE + UART_O_DR) = Packet[IDX];
+    HWREG(UART3_BASE + UART_O_ICR) |= UART_ICR_TXIC;
     
-		//Increment the index
-		IDX++;
-		
     if(IDX == DataLength)
     { 
       // End of packet, Disable TX and Enable RX
-			HWREG(UART3_BASE + UART_O_IM) &= ~UART_IM_TXIM;
-      HWREG(UART3_BASE + UART_O_IM) |= UART_IM_RXIM;
-			
-			ThisEvent.EventType = BYTE_SENT;
-			PostSHIP_TX(ThisEvent);
-    }	
+      HWREG(UART3_BASE + UART_O_IM) &= ~UART_IM_TXIM;
+      HWREG(UART3_BASE + UART_O_IM) |= (UART_IM_RXIM | UART_IM_RTIM);
+      
+      ThisEvent.EventType = BYTE_SENT;
+      PostSHIP_TX(ThisEvent);
+    }
+    else
+    {
+      // Write the next bytes to DR
+      FillTXFIFO();
+    }
   }
   
-  // XBee RX
-  if (HWREG(UART3_BASE + UART_O_MIS) & UART_MIS_RXMIS)
+  // XBee RX, FIFO half full or a receive time out with bytes left in it
+  if (HWREG(UART3_BASE + UART_O_MIS) & (UART_MIS_RXMIS | UART_MIS_RTMIS))
   {
-    HWREG(UART3_BASE + UART_O_ICR) |= UART_ICR_RXIC;
+    HWREG(UART3_BASE + UART_O_ICR) |= (UART_ICR_RXIC | UART_ICR_RTIC);
     
-    ThisEvent.EventType = BYTE_RECEIVED;
-    ThisEvent.EventParam = HWREG(UART3_BASE + UART_O_DR);
-    PostSHIP_RX(ThisEvent);
+    // everything waiting, SHIP_RX gets FRAME_RECEIVED once a frame is done
+    while (!(HWREG(UART3_BASE + UART_O_FR) & UART_FR_RXFE))
+    {
+      SHIP_RX_Byte(HWREG(UART3_BASE + UART_O_DR));
+    }
   }
 }
 
@@ -281,49 +247,62 @@ void SHIP_XBEE_ISR(void)
  private functions
  ***************************************************************************/
 
+/****************************************************************************
+Function
+  FillTXFIFO
+
+Description
+  writes the rest of Packet to UART3 until it is all in or the TX FIFO is
+  full, one TX interrupt per 14 bytes rather than one per byte
+
+****************************************************************************/
+static void FillTXFIFO(void)
+{
+  while ((IDX < DataLength) &&
+      !(HWREG(UART3_BASE + UART_O_FR) & UART_FR_TXFF))
+  {
+    HWREG(UART3_BASE + UART_O_DR) = Packet[IDX];
+    IDX++;
+  }
+}
+
+/****************************************************************************
+Function
+  BuildPacket
+
+Parameters
+  ES_Event_t : the BEGIN_TX event, PAIR_ACK_EVENT or STATUS_EVENT
+
+Description
+  fills in the packet for the paired ANSIBLE and has the codec build the
+  frame in Packet, DataLength is 0 if there is nothing to send
+
+****************************************************************************/
 static void BuildPacket(ES_Event_t ThisEvent)
 {
+  XBeePacket_t TXPacket;
+
   SourceAddress = QuerySourceAddress();
   
-  Packet[0] = START_DELIMITER;  // 0x7E
-  Packet[3] = API_IDENTIFIER;   // 0x01
-  Packet[4] = FRAME_ID;         // 0x01
-  Packet[5] = (uint8_t)(SourceAddress>>8);
-  Packet[6] = (uint8_t)SourceAddress;
-  Packet[7] = OPTIONS;
+  TXPacket.Api = XBEE_TX_REQUEST;
+  TXPacket.FrameId = FRAME_ID;
+  TXPacket.Address = SourceAddress;
+  TXPacket.Options = OPTIONS;
     
   if (ThisEvent.EventParam == PAIR_ACK_EVENT)
   {
-    Packet[1] = LENGTH_MSB_PAIR_ACK; // 0x00
-    Packet[2] = LENGTH_LSB_PAIR_ACK; // 0x06
-    Packet[8] = 0x02;
-    Packet[9] = CheckSum(PAIR_ACK_MAX_IDX);
-    DataLength = PAIR_ACK_MAX_IDX + 1;  // 10
+    TXPacket.Message = XBEE_PAIR_ACK;
   }
-  
-  if (ThisEvent.EventParam == STATUS_EVENT)
+  else if (ThisEvent.EventParam == STATUS_EVENT)
   {
-    Packet[1] = LENGTH_MSB_STATUS;  // 0x00
-    Packet[2] = LENGTH_LSB_STATUS;  // 0x08
-    Packet[8] = 0x04;
-    Packet[9] = QueryFuelStatus();
-    Packet[10] = Query_CTRL();
-    Packet[11] = CheckSum(STATUS_MAX_IDX);
-    DataLength = STATUS_MAX_IDX + 1;  // 12
+    TXPacket.Message = XBEE_STATUS;
+    TXPacket.Payload[XBEE_STATUS_FUEL] = QueryFuelStatus();
+    TXPacket.Payload[XBEE_STATUS_CONTROL] = Query_CTRL();
   }
-}
-
-static uint8_t CheckSum(uint8_t CHECKSUM_INDEX)
-{
-  static uint8_t CheckSum;
-  static uint8_t i;
-  
-  CheckSum = 0xFF;
-  
-  for (i=3;i<CHECKSUM_INDEX;i++)
+  else
   {
-    CheckSum -= Packet[i];
+    DataLength = 0;
+    return;
   }
-  
-  return CheckSum; 
+  DataLength = XBeeCodec_Encode(&TXPacket, Packet, sizeof(Packet));
 }
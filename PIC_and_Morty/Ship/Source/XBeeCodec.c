@@ -0,0 +1,396 @@
+/****************************************************************************
+ Module
+   XBeeCodec.c
+
+ Revision
+   1.0.1
+
+ Description
+   Builds XBee API frames for the class protocol packets, and takes them
+   apart again, from the XBEE_MESSAGES and XBEE_API_FRAMES tables in
+   XBeeCodec.h
+
+ Notes
+   Encode writes the whole frame, start delimiter to check sum, in one pass
+   straight into the caller's transmit buffer, adding up the check sum as
+   it goes. Decode takes the frame data that XBeeFrame.c leaves in a pool
+   block, from the API identifier up to but not including the check sum,
+   which the parser has already checked.
+
+   The same file is in the ANSIBLE and the SHIP projects, keep them the same.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/18/26 02:10         started coding, replaces BuildPreamble, BuildTXPacket
+                        & CheckSum in AnsibleTransmit.c, BuildPacket &
+                        CheckSum in SHIP_TX.c
+****************************************************************************/
+/*----------------------------- Include Files -----------------------------*/
+#include "XBeeCodec.h"
+#include <string.h>
+
+/*----------------------------- Module Defines ----------------------------*/
+#define START_DELIMITER   0x7E
+// API identifier, then 3 address/frame ID/RSSI bytes, then options
+#define API_HEADER_LENGTH 5
+// the message header byte comes right after the API header
+#define MESSAGE_IDX       API_HEADER_LENGTH
+#define PAYLOAD_IDX       (MESSAGE_IDX + 1)
+// what XBeeCodec_PayloadLength gives for a header not in XBEE_MESSAGES
+#define NOT_A_MESSAGE     0xFF
+
+// every payload must fit in XBeePacket_t
+#define PAYLOAD_FITS(Name, Header, NumBytes) \
+  typedef char PayloadFits_##Name[((NumBytes) <= XBEE_MAX_PAYLOAD) ? 1 : -1];
+XBEE_MESSAGES(PAYLOAD_FITS)
+
+/*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     XBeeCodec_Encode
+
+ Parameters
+     XBeePacket_t const * : the packet to send
+     uint8_t * : where to build the frame
+     uint8_t : how many bytes there is room for
+
+ Returns
+     uint8_t : the number of bytes in the frame, 0 if the packet is not one
+     in the tables or the frame does not fit
+
+ Description
+     writes the start delimiter, length, API header, message header,
+     payload and check sum for a packet
+
+ Author
+     10/18/26
+****************************************************************************/
+uint8_t XBeeCodec_Encode(XBeePacket_t const *pPacket, uint8_t *pFrame,
+    uint8_t Size)
+{
+  uint8_t NumBytes = XBeeCodec_PayloadLength(pPacket->Message);
+  uint8_t Length;
+  uint8_t Sum = 0;
+  uint8_t *pOut;
+  uint8_t i;
+
+  if ((NumBytes == NOT_A_MESSAGE) ||
+      ((pPacket->Api != XBEE_TX_REQUEST) && (pPacket->Api != XBEE_RX_PACKET)))
+  {
+    return 0;
+  }
+  Length = PAYLOAD_IDX + NumBytes;
+  if ((Length + 4) > Size)
+  {
+    return 0;
+  }
+
+  pFrame[0] = START_DELIMITER;
+  pFrame[1] = 0;        // no packet is over 255 bytes
+  pFrame[2] = Length;
+  pOut = &pFrame[3];
+#define PUT(Byte) { uint8_t Out_ = (Byte); Sum += Out_; *pOut++ = Out_; }
+  PUT(pPacket->Api);
+  if (pPacket->Api == XBEE_TX_REQUEST)
+  {
+    PUT(pPacket->FrameId);
+    PUT(pPacket->Address >> 8);
+    PUT(pPacket->Address & 0xFF);
+  }
+  else
+  {
+    PUT(pPacket->Address >> 8);
+    PUT(pPacket->Address & 0xFF);
+    PUT(pPacket->Rssi);
+  }
+  PUT(pPacket->Options);
+  PUT(pPacket->Message);
+  for (i = 0; i < NumBytes; i++)
+  {
+    PUT(pPacket->Payload[i]);
+  }
+#undef PUT
+  *pOut = 0xFF - Sum;
+  return Length + 4;
+}
+
+/****************************************************************************
+ Function
+     XBeeCodec_Decode
+
+ Parameters
+     uint8_t const * : the frame data, from the API identifier on
+     uint16_t : how many bytes of it, not counting the check sum
+     XBeePacket_t * : where to put the fields
+
+ Returns
+     bool : true if it is a transmit request or received packet carrying a
+     packet from the tables, with the right length for that packet
+
+ Description
+     the opposite of XBeeCodec_Encode, for a frame that has been through
+     XBeeFrame_ParseByte
+
+ Author
+     10/18/26
+****************************************************************************/
+bool XBeeCodec_Decode(uint8_t const *pFrameData, uint16_t Length,
+    XBeePacket_t *pPacket)
+{
+  uint8_t NumBytes;
+
+  if (Length < PAYLOAD_IDX)
+  {
+    return false;
+  }
+  NumBytes = XBeeCodec_PayloadLength((XBeeMessage_t)pFrameData[MESSAGE_IDX]);
+  if ((NumBytes == NOT_A_MESSAGE) || (Length != (PAYLOAD_IDX + NumBytes)))
+  {
+    return false;
+  }
+
+  pPacket->Api = (XBeeApi_t)pFrameData[0];
+  if (pPacket->Api == XBEE_TX_REQUEST)
+  {
+    pPacket->FrameId = pFrameData[1];
+    pPacket->Address = ((uint16_t)pFrameData[2] << 8) | pFrameData[3];
+    pPacket->Rssi = 0;
+  }
+  else if (pPacket->Api == XBEE_RX_PACKET)
+  {
+    pPacket->FrameId = 0;
+    pPacket->Address = ((uint16_t)pFrameData[1] << 8) | pFrameData[2];
+    pPacket->Rssi = pFrameData[3];
+  }
+  else
+  {
+    return false;
+  }
+  pPacket->Options = pFrameData[4];
+  pPacket->Message = (XBeeMessage_t)pFrameData[MESSAGE_IDX];
+  memcpy(pPacket->Payload, &pFrameData[PAYLOAD_IDX], NumBytes);
+  return true;
+}
+
+/****************************************************************************
+ Function
+     XBeeCodec_PayloadLength
+
+ Parameters
+     XBeeMessage_t : a message header byte
+
+ Returns
+     uint8_t : the number of payload bytes after it, 0xFF if it is not in
+     XBEE_MESSAGES
+
+ Author
+     10/18/26
+****************************************************************************/
+uint8_t XBeeCodec_PayloadLength(XBeeMessage_t Message)
+{
+#define PAYLOAD_LENGTH(Name, Header, NumBytes) \
+  case XBEE_##Name: return (NumBytes);
+
+  switch (Message)
+  {
+    XBEE_MESSAGES(PAYLOAD_LENGTH)
+    default: return NOT_A_MESSAGE;
+  }
+#undef PAYLOAD_LENGTH
+}
+
+#if defined(TEST) && defined(ES_PORT_POSIX)
+/*
+  Host test and benchmark. Build with:
+  gcc -O2 -DTEST -DES_PORT_POSIX -IHeaders Source/XBeeCodec.c
+
+  Checks the frames against the byte layouts the hand written builders
+  used to produce, so both ends still understand older firmware, then round
+  trips random packets of every kind and tries the ways a decode has to
+  fail. Last it times encodes and decodes.
+*/
+#include <stdio.h>
+#include <time.h>
+
+#define NUM_ROUND_TRIPS 100000UL
+#define NUM_TIMED       10000000UL
+
+static uint16_t Errors;
+static uint32_t RandomState = 2463534242UL;
+
+static void Check(bool Condition, char const *pWhat)
+{
+  if (Condition != true)
+  {
+    if (Errors < 10)
+    {
+      printf("FAILED: %s\n", pWhat);
+    }
+    Errors++;
+  }
+}
+
+static uint32_t Random(void)
+{
+  RandomState ^= RandomState << 13;
+  RandomState ^= RandomState >> 17;
+  RandomState ^= RandomState << 5;
+  return RandomState;
+}
+
+static void CheckGolden(XBeePacket_t const *pPacket, uint8_t const *pExpected,
+    uint8_t NumExpected, char const *pWhat)
+{
+  uint8_t Frame[XBEE_MAX_FRAME];
+
+  Check((XBeeCodec_Encode(pPacket, Frame, sizeof(Frame)) == NumExpected) &&
+      (memcmp(Frame, pExpected, NumExpected) == 0), pWhat);
+}
+
+static bool SamePacket(XBeePacket_t const *pA, XBeePacket_t const *pB)
+{
+  uint8_t NumBytes = XBeeCodec_PayloadLength(pA->Message);
+
+  return (pA->Api == pB->Api) && (pA->Address == pB->Address) &&
+         (pA->Options == pB->Options) && (pA->Message == pB->Message) &&
+         ((pA->Api != XBEE_TX_REQUEST) || (pA->FrameId == pB->FrameId)) &&
+         ((pA->Api != XBEE_RX_PACKET) || (pA->Rssi == pB->Rssi)) &&
+         (memcmp(pA->Payload, pB->Payload, NumBytes) == 0);
+}
+
+static void TestGolden(void)
+{
+  // as AnsibleTransmit.c built them, to boat 1, then as SHIP_TX.c did
+  static uint8_t const Req2Pair[] = {
+    0x7E, 0x00, 0x07, 0x01, 0x01, 0x21, 0x81, 0x00, 0x01, 0x01, 0x59 };
+  static uint8_t const Ctrl[] = {
+    0x7E, 0x00, 0x0B, 0x01, 0x01, 0x21, 0x81, 0x00, 0x03, 0x80, 0x7F,
+    0x10, 0x20, 0x05, 0x24 };
+  static uint8_t const PairAck[] = {
+    0x7E, 0x00, 0x06, 0x01, 0x01, 0x20, 0x86, 0x00, 0x02, 0x55 };
+  static uint8_t const Status[] = {
+    0x7E, 0x00, 0x08, 0x01, 0x01, 0x20, 0x86, 0x00, 0x04, 0x0B, 0x05, 0x43 };
+  XBeePacket_t Packet = { XBEE_TX_REQUEST, 0x01, 0x2181, 0, 0x00,
+                          XBEE_REQ_2_PAIR, { 0x01 } };
+
+  CheckGolden(&Packet, Req2Pair, sizeof(Req2Pair), "REQ_2_PAIR layout");
+  Packet.Message = XBEE_CTRL;
+  Packet.Payload[XBEE_CTRL_FB] = 0x80;
+  Packet.Payload[XBEE_CTRL_LR] = 0x7F;
+  Packet.Payload[XBEE_CTRL_TURRET_YAW] = 0x10;
+  Packet.Payload[XBEE_CTRL_TURRET_PITCH] = 0x20;
+  Packet.Payload[XBEE_CTRL_CONTROL] = 0x05;
+  CheckGolden(&Packet, Ctrl, sizeof(Ctrl), "CTRL layout");
+  Packet.Address = 0x2086;
+  Packet.Message = XBEE_PAIR_ACK;
+  CheckGolden(&Packet, PairAck, sizeof(PairAck), "PAIR_ACK layout");
+  Packet.Message = XBEE_STATUS;
+  Packet.Payload[XBEE_STATUS_FUEL] = 0x0B;
+  Packet.Payload[XBEE_STATUS_CONTROL] = 0x05;
+  CheckGolden(&Packet, Status, sizeof(Status), "STATUS layout");
+}
+
+static void TestRoundTrips(void)
+{
+  static XBeeMessage_t const Messages[] = {
+#define MESSAGE_NAME(Name, Header, NumBytes) XBEE_##Name,
+    XBEE_MESSAGES(MESSAGE_NAME)
+#undef MESSAGE_NAME
+  };
+  XBeePacket_t  Sent;
+  XBeePacket_t  Received;
+  uint8_t       Frame[XBEE_MAX_FRAME];
+  uint8_t       Length;
+  uint8_t       Sum;
+  uint32_t      Trip;
+  uint8_t       i;
+
+  for (Trip = 0; Trip < NUM_ROUND_TRIPS; Trip++)
+  {
+    Sent.Api = (Random() & 1) ? XBEE_TX_REQUEST : XBEE_RX_PACKET;
+    Sent.FrameId = Random();
+    Sent.Address = Random();
+    Sent.Rssi = Random();
+    Sent.Options = Random();
+    Sent.Message = Messages[Random() % (sizeof(Messages) /
+        sizeof(Messages[0]))];
+    for (i = 0; i < XBEE_MAX_PAYLOAD; i++)
+    {
+      Sent.Payload[i] = Random();
+    }
+    Length = XBeeCodec_Encode(&Sent, Frame, sizeof(Frame));
+    Check(Length == (XBeeCodec_PayloadLength(Sent.Message) + 10),
+        "frame length");
+    Check((Frame[0] == 0x7E) && (((Frame[1] << 8) | Frame[2]) == Length - 4),
+        "delimiter and length");
+    for (Sum = 0, i = 3; i < Length; i++)
+    {
+      Sum += Frame[i];
+    }
+    Check(Sum == 0xFF, "check sum");
+    Check(XBeeCodec_Decode(&Frame[3], Length - 4, &Received) &&
+        SamePacket(&Sent, &Received), "round trip");
+
+    // too short, too long, and not a packet of ours
+    Check(!XBeeCodec_Decode(&Frame[3], Length - 5, &Received),
+        "decoded a short frame");
+    Check(!XBeeCodec_Decode(&Frame[3], Length - 3, &Received),
+        "decoded a long frame");
+    Frame[3 + MESSAGE_IDX] = 0x05 + (Random() % 250);
+    Check(!XBeeCodec_Decode(&Frame[3], Length - 4, &Received),
+        "decoded an unknown message");
+    Frame[3 + MESSAGE_IDX] = Sent.Message;
+    Frame[3] = 0x89;    // TX status
+    Check(!XBeeCodec_Decode(&Frame[3], Length - 4, &Received),
+        "decoded an unknown API frame");
+    Check(XBeeCodec_Encode(&Sent, Frame, Length - 1) == 0,
+        "encoded past the end of the buffer");
+  }
+}
+
+static void Benchmark(void)
+{
+  XBeePacket_t  Packet = { XBEE_TX_REQUEST, 0x01, 0x2181, 0, 0x00,
+                           XBEE_CTRL, { 1, 2, 3, 4, 5 } };
+  XBeePacket_t  Received;
+  uint8_t       Frame[XBEE_MAX_FRAME];
+  uint32_t      Total = 0;
+  uint32_t      i;
+  clock_t       Start;
+  double        Encode;
+  double        Decode;
+
+  Start = clock();
+  for (i = 0; i < NUM_TIMED; i++)
+  {
+    Packet.Payload[0] = (uint8_t)i;
+    Total += XBeeCodec_Encode(&Packet, Frame, sizeof(Frame));
+    Total += Frame[sizeof(Frame) - 1];
+  }
+  Encode = (double)(clock() - Start) / CLOCKS_PER_SEC;
+
+  XBeeCodec_Encode(&Packet, Frame, sizeof(Frame));
+  Start = clock();
+  for (i = 0; i < NUM_TIMED; i++)
+  {
+    Frame[3 + PAYLOAD_IDX] = (uint8_t)i;
+    Total += XBeeCodec_Decode(&Frame[3], Frame[2], &Received);
+    Total += Received.Payload[0];
+  }
+  Decode = (double)(clock() - Start) / CLOCKS_PER_SEC;
+
+  printf("CTRL encode %.1f ns, decode %.1f ns (%lu)\n",
+      Encode * 1e9 / NUM_TIMED, Decode * 1e9 / NUM_TIMED,
+      (unsigned long)Total);
+}
+
+int main(void)
+{
+  TestGolden();
+  TestRoundTrips();
+  Benchmark();
+  printf("%u errors\n", Errors);
+  return (Errors == 0) ? 0 : 1;
+}
+#endif /* TEST */
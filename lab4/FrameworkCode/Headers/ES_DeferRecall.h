@@ -1,61 +1,80 @@
+/****************************************************************************
+ Module
+     ES_DeferRecall.h
+ Description
+     header file for the event deferral and recall queues
+ Notes
+     A service declares its deferral queue with ES_DEFERRAL_QUEUE, at file
+     scope, and is the only one to use it:
+
+       ES_DEFERRAL_QUEUE( DeferralQueue, 8 );
+       ...
+       ES_DeferEvent( &DeferralQueue, ThisEvent );
+       ...
+       ES_RecallEvents( MyPriority, &DeferralQueue );
+
+     Events come back out in the order that they were deferred, ahead of
+     anything already waiting in the service's queue.
+
+ History
+ When           Who     What/Why
+ -------------- ---     --------
+ 10/17/26 23:00         deferral queues are now their own type, with recall
+                        by event type or by test, recall in deferral order
+                        in a single post, and statistics
+*****************************************************************************/
 #ifndef DEFER_RECALL_H
 #define DEFER_RECALL_H
 
-#include "ES_Queue.h"
+#include "ES_Types.h"
 #include "ES_Events.h"
 
-/****************************************************************************
- Function
-   ES_InitDeferralQueueWith  (wrapper for ES_InitQueue )
-   this is a straight re-naming to aid readability 
- Parameters
-   EF_Event * pBlock : pointer to the block of memory to use for the Queue
-   unsigned char BlockSize: size of the block pointed to by pBlock
- Returns
-   max number of entries in the created queue
- Description
-   Initializes a queue structure at the beginning of the block of memory
- Notes
-   you should pass it a block that is at least sizeof(ES_Queue_t) larger than 
-   the number of entries that you want in the queue. Since the size of an 
-   ES_Event (at 4 bytes; 2 enum, 2 param) is greater than the 
-   sizeof(ES_Queue_t), you only need to declare an array of ES_Event
-   with 1 more element than you need for the actual queue.
-****************************************************************************/
-#define ES_InitDeferralQueueWith( a,b ) ES_InitQueue( a, b )
+typedef struct {
+  uint16_t NumDeferred;   // events taken in
+  uint16_t NumRefused;    // events turned away because the queue was full
+  uint16_t NumRecalled;   // events handed back to the service
+  uint16_t NumHeldBack;   // events that a recall wanted but did not fit in
+                          // the service's queue, so were left deferred
+  uint8_t  PeakDepth;     // most events deferred at once
+  uint16_t MaxAge;        // longest any event was deferred, in timer ticks
+  uint32_t TotalAge;      // of the recalled events, for the average
+} ES_DeferStats_t;
+
+typedef struct {
+  ES_Event * pEvents;     // oldest first
+  uint16_t * pStamps;     // ES_Timer_GetTime when each was deferred
+  uint8_t Size;
+  uint8_t NumEntries;
+  ES_DeferStats_t Stats;
+} ES_DeferralQueue_t;
+
+// tests an event for ES_RecallEventsIf, true to recall it
+typedef bool ES_RecallTest_t( ES_Event ThisEvent );
 
 /****************************************************************************
- Function
-   ES_DeferEvent  (wrapper for ES_EnQueueLIFO)
-   this is a straight re-naming to aid readability
+ Macro
+   ES_DEFERRAL_QUEUE
  Parameters
-   ES_Event * pBlock : pointer to the block of memory in use as the Queue
-   ES_Event Event2Add : event to be added to the Queue
- Returns
-   bool : true if the add was successful, false if not
+   Name : what to call the deferral queue
+   Size : how many events it can hold, no more than 255
  Description
-   if it will fit, adds Event2Add to the Queue
+   declares a deferral queue and the memory for it, ready to use
  ***************************************************************************/
-#define ES_DeferEvent( a,b ) ES_EnQueueLIFO( a, b )
+#define ES_DEFERRAL_QUEUE( Name, Size )                             \
+  static ES_Event Name##Events[Size];                               \
+  static uint16_t Name##Stamps[Size];                               \
+  static ES_DeferralQueue_t Name = { Name##Events, Name##Stamps,    \
+                                     (Size), 0, { 0 } }
 
-/****************************************************************************
- Function
-     ES_RecallEvents
- Parameters
-      uint8_t WhichService, number of the service to post Recalled event to
-      ES_Event * pBlock, pointer to the block of memory that implements the
-        Defer/Recall queue
- Returns
-     bool true if an event was recalled, false if no event was left in queue
- Description
-     pulls an event off the deferral queue if one is available. It there was
-     something in the queue, then it posts it LIFO fashion to the queue 
-     indicated by WhichService
- Notes
-     None.
- Author
-     J. Edward Carryer, 11/20/13 16:49
-****************************************************************************/
-bool ES_RecallEvents( uint8_t WhichService, ES_Event * pBlock );
+void ES_InitDeferralQueue( ES_DeferralQueue_t * pQueue );
+bool ES_DeferEvent( ES_DeferralQueue_t * pQueue, ES_Event ThisEvent );
+bool ES_RecallEvents( uint8_t WhichService, ES_DeferralQueue_t * pQueue );
+bool ES_RecallEventType( uint8_t WhichService, ES_DeferralQueue_t * pQueue,
+                         ES_EventTyp_t WhichType );
+bool ES_RecallEventsIf( uint8_t WhichService, ES_DeferralQueue_t * pQueue,
+                        ES_RecallTest_t * pTest );
+uint8_t ES_GetDeferralDepth( ES_DeferralQueue_t const * pQueue );
+ES_DeferStats_t const * ES_GetDeferralStats(
+                                      ES_DeferralQueue_t const * pQueue );
 
 #endif
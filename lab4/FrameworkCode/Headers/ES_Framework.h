@@ -8,6 +8,7 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/17/26 23:00          added ES_PostBlockToServiceLIFO prototype
  11/02/13 17:06 jec      added ES_PostToServiceLIFO prototype
  08/05/13 15:00 jec      added #include for ES_Port.h to get portability stuff
  10/17/06 07:41 jec      started coding
@@ -43,5 +44,8 @@ ES_Return_t ES_Run( void );
 bool ES_PostAll( ES_Event ThisEvent );
 bool ES_PostToService( uint8_t WhichService, ES_Event ThisEvent);
 bool ES_PostToServiceLIFO( uint8_t WhichService, ES_Event TheEvent);
+uint8_t ES_PostBlockToServiceLIFO( uint8_t WhichService,
+                                   ES_Event const * pEvents,
+                                   uint8_t NumEvents );
 
 #endif   // ES_Framework_H
@@ -25,6 +25,8 @@
 uint8_t ES_InitQueue( ES_Event * pBlock, uint8_t BlockSize );
 bool ES_EnQueueFIFO( ES_Event * pBlock, ES_Event Event2Add );
 bool ES_EnQueueLIFO( ES_Event * pBlock, ES_Event Event2Add );
+uint8_t ES_EnQueueBlockLIFO( ES_Event * pBlock, ES_Event const * pEvents,
+                             uint8_t NumEvents );
 uint8_t ES_DeQueue( ES_Event * pBlock, ES_Event * pReturnEvent );
 //void EF_FlushQueue( unsigned char * pBlock );
 bool ES_IsQueueEmpty( ES_Event * pBlock );
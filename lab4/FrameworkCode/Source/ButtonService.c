@@ -66,8 +66,8 @@ static uint8_t LastButtonState;
 static ButtonState_t CurrentState; 
 
 
-// add a deferral queue for up to 3 pending deferrals +1 to allow for overhead
-static ES_Event DeferralQueue[3+1];
+// add a deferral queue for up to 3 pending deferrals
+ES_DEFERRAL_QUEUE( DeferralQueue, 3 );
 
 /*------------------------------ Module Code ------------------------------*/
 /****************************************************************************
@@ -1,3 +1,4 @@
+//#define TEST
 /****************************************************************************
  Module
      ES_DeferRecall.c
@@ -6,12 +7,18 @@
      This is a module implementing  the management of event deferal and recall
       queues
  Notes
-     
+     A deferral queue belongs to one service and is only used from its run
+     function, so it needs no critical regions of its own. The one place
+     that another context is involved is the service's event queue, which
+     the recalled events are put into with a single call to
+     ES_PostBlockToServiceLIFO.
 
  History
  When           Who     What/Why
  -------------- ---     --------
- 
+ 10/17/26 23:00         deferral queues are now their own type, with recall
+                        by event type or by test, recall in deferral order
+                        in a single post, and statistics
  10/11/14 14:58 jec     converted RecallEvent to RecallEvents to pull all
                         deferred events off the deferral queue
  11/02/13 16:38 jec      Began Coding
@@ -23,6 +30,7 @@
 #include "ES_General.h"
 #include "ES_Events.h"
 #include "ES_DeferRecall.h"
+#include <string.h>
 
 /*--------------------------- External Variables --------------------------*/
 
@@ -31,44 +39,420 @@
 /*------------------------------ Module Types -----------------------------*/
 
 /*---------------------------- Module Functions ---------------------------*/
+static bool Recall( uint8_t WhichService, ES_DeferralQueue_t * pQueue,
+                    ES_RecallTest_t * pTest, ES_EventTyp_t WhichType );
 
 /*---------------------------- Module Variables ---------------------------*/
 
 /*------------------------------ Module Code ------------------------------*/
+/****************************************************************************
+ Function
+     ES_InitDeferralQueue
+ Parameters
+     ES_DeferralQueue_t * pQueue, the deferral queue to empty
+ Returns
+     nothing
+ Description
+     throws away anything deferred and clears the statistics
+ Notes
+     a queue declared with ES_DEFERRAL_QUEUE starts out empty, so this is
+     only needed to start over
+ Author
+     10/17/26
+****************************************************************************/
+void ES_InitDeferralQueue( ES_DeferralQueue_t * pQueue ){
+  pQueue->NumEntries = 0;
+  memset( &pQueue->Stats, 0, sizeof(pQueue->Stats));
+}
+
+/****************************************************************************
+ Function
+     ES_DeferEvent
+ Parameters
+     ES_DeferralQueue_t * pQueue, the deferral queue to add to
+     ES_Event ThisEvent, the event to defer
+ Returns
+     bool true if the event was deferred, false if the queue was full
+ Description
+     adds the event to the end of the deferral queue, with the time that it
+     was deferred
+ Notes
+     None.
+ Author
+     10/17/26
+****************************************************************************/
+bool ES_DeferEvent( ES_DeferralQueue_t * pQueue, ES_Event ThisEvent ){
+  if ( pQueue->NumEntries >= pQueue->Size ){
+    pQueue->Stats.NumRefused++;
+    return false;
+  }
+  pQueue->pEvents[pQueue->NumEntries] = ThisEvent;
+  pQueue->pStamps[pQueue->NumEntries] = ES_Timer_GetTime();
+  pQueue->NumEntries++;
+  if ( pQueue->NumEntries > pQueue->Stats.PeakDepth )
+    pQueue->Stats.PeakDepth = pQueue->NumEntries;
+  pQueue->Stats.NumDeferred++;
+  return true;
+}
+
 /****************************************************************************
  Function
      ES_RecallEvents
  Parameters
       uint8_t WhichService, number of the service to post Recalled event to
-      ES_Event * pBlock, pointer to the block of memory that implements the
-        Defer/Recall queue
+      ES_DeferralQueue_t * pQueue, the deferral queue to recall from
  Returns
      bool true if an event was recalled, false if no event was left in queue
  Description
-     pulls all events off the deferral queue if any are available. If there was
-     something in the queue, then it posts it LIFO fashion to the queue 
-     indicated by WhichService
+     puts all of the deferred events at the front of WhichService's queue,
+     in the order that they were deferred
  Notes
-     None.
+     any that do not fit in the service's queue stay deferred
  Author
      J. Edward Carryer, 11/20/13 16:49
 ****************************************************************************/
-bool ES_RecallEvents( uint8_t WhichService, ES_Event * pBlock ){
-  ES_Event RecalledEvent;
-	bool WereEventsPulled = false;
-  // recall any events from the queue
-  do
-	{	
-		ES_DeQueue( pBlock, &RecalledEvent );
-		if (RecalledEvent.EventType != ES_NO_EVENT){
-			ES_PostToServiceLIFO( WhichService, RecalledEvent);
-			WereEventsPulled = true;
-		}
-  }while(RecalledEvent.EventType != ES_NO_EVENT);
-  return WereEventsPulled;
-  
-}
-  
+bool ES_RecallEvents( uint8_t WhichService, ES_DeferralQueue_t * pQueue ){
+  return Recall( WhichService, pQueue, NULL, ES_NO_EVENT );
+}
+
+/****************************************************************************
+ Function
+     ES_RecallEventType
+ Parameters
+      uint8_t WhichService, number of the service to post Recalled event to
+      ES_DeferralQueue_t * pQueue, the deferral queue to recall from
+      ES_EventTyp_t WhichType, the type of event to recall
+ Returns
+     bool true if an event was recalled
+ Description
+     as ES_RecallEvents, but only for the events of one type, the others
+     stay deferred in their order
+ Notes
+     None.
+ Author
+     10/17/26
+****************************************************************************/
+bool ES_RecallEventType( uint8_t WhichService, ES_DeferralQueue_t * pQueue,
+                         ES_EventTyp_t WhichType ){
+  return Recall( WhichService, pQueue, NULL, WhichType );
+}
+
+/****************************************************************************
+ Function
+     ES_RecallEventsIf
+ Parameters
+      uint8_t WhichService, number of the service to post Recalled event to
+      ES_DeferralQueue_t * pQueue, the deferral queue to recall from
+      ES_RecallTest_t * pTest, returns true for the events to recall
+ Returns
+     bool true if an event was recalled
+ Description
+     as ES_RecallEvents, but only for the events that pass the test, the
+     others stay deferred in their order
+ Notes
+     pTest is called once for each deferred event, from the service's run
+     function
+ Author
+     10/17/26
+****************************************************************************/
+bool ES_RecallEventsIf( uint8_t WhichService, ES_DeferralQueue_t * pQueue,
+                        ES_RecallTest_t * pTest ){
+  return Recall( WhichService, pQueue, pTest, ES_NO_EVENT );
+}
+
+/****************************************************************************
+ Function
+     ES_GetDeferralDepth
+ Parameters
+     ES_DeferralQueue_t const * pQueue, the deferral queue to look at
+ Returns
+     uint8_t the number of events that are deferred right now
+ Description
+     None.
+ Notes
+     None.
+ Author
+     10/17/26
+****************************************************************************/
+uint8_t ES_GetDeferralDepth( ES_DeferralQueue_t const * pQueue ){
+  return pQueue->NumEntries;
+}
+
+/****************************************************************************
+ Function
+     ES_GetDeferralStats
+ Parameters
+     ES_DeferralQueue_t const * pQueue, the deferral queue to look at
+ Returns
+     ES_DeferStats_t const * the statistics that it has kept
+ Description
+     counts of events deferred, refused, recalled and held back, the most
+     that were deferred at once, and how long the recalled events waited
+ Notes
+     the ages are in ES_Timer ticks, the average is TotalAge / NumRecalled
+ Author
+     10/17/26
+****************************************************************************/
+ES_DeferStats_t const * ES_GetDeferralStats(
+                                      ES_DeferralQueue_t const * pQueue ){
+  return &pQueue->Stats;
+}
+
+/***************************************************************************
+ private functions
+ ***************************************************************************/
+/****************************************************************************
+ Function
+     Recall
+ Parameters
+      uint8_t WhichService, number of the service to post Recalled event to
+      ES_DeferralQueue_t * pQueue, the deferral queue to recall from
+      ES_RecallTest_t * pTest, picks the events to recall, or NULL
+      ES_EventTyp_t WhichType, with no test, the type to recall, or
+        ES_NO_EVENT for all of them
+ Returns
+     bool true if an event was recalled
+ Description
+     gathers the wanted events at the front of the deferral queue, keeping
+     the order of both the wanted ones and the rest, then posts them all to
+     the front of the service's queue at once and drops the ones that fit
+ Notes
+     the gathering moves each wanted event past the unwanted ones ahead of
+     it, which is cheap for the handful of events that get deferred
+****************************************************************************/
+static bool Recall( uint8_t WhichService, ES_DeferralQueue_t * pQueue,
+                    ES_RecallTest_t * pTest, ES_EventTyp_t WhichType ){
+  ES_Event ThisEvent;
+  uint16_t ThisStamp;
+  uint16_t Now;
+  uint16_t Age;
+  uint8_t NumWanted = 0;
+  uint8_t NumPosted;
+  uint8_t i;
+  bool IsWanted;
+
+  for ( i = 0; i < pQueue->NumEntries; i++ ){
+    ThisEvent = pQueue->pEvents[i];
+    if ( pTest != NULL )
+      IsWanted = pTest( ThisEvent );
+    else
+      IsWanted = ((WhichType == ES_NO_EVENT) ||
+                  (ThisEvent.EventType == WhichType));
+    if ( IsWanted ){
+      if ( i != NumWanted ){
+        // slide the unwanted ones in between up to make room for it
+        ThisStamp = pQueue->pStamps[i];
+        memmove( &pQueue->pEvents[NumWanted + 1], &pQueue->pEvents[NumWanted],
+                 (i - NumWanted) * sizeof(pQueue->pEvents[0]));
+        memmove( &pQueue->pStamps[NumWanted + 1], &pQueue->pStamps[NumWanted],
+                 (i - NumWanted) * sizeof(pQueue->pStamps[0]));
+        pQueue->pEvents[NumWanted] = ThisEvent;
+        pQueue->pStamps[NumWanted] = ThisStamp;
+      }
+      NumWanted++;
+    }
+  }
+  if ( NumWanted == 0 )
+    return false;
+
+  NumPosted = ES_PostBlockToServiceLIFO( WhichService, pQueue->pEvents,
+                                         NumWanted );
+  Now = ES_Timer_GetTime();
+  for ( i = 0; i < NumPosted; i++ ){
+    Age = Now - pQueue->pStamps[i];
+    pQueue->Stats.TotalAge += Age;
+    if ( Age > pQueue->Stats.MaxAge )
+      pQueue->Stats.MaxAge = Age;
+  }
+  pQueue->Stats.NumRecalled += NumPosted;
+  pQueue->Stats.NumHeldBack += NumWanted - NumPosted;
+  // drop the ones that went, the rest stay in order
+  pQueue->NumEntries -= NumPosted;
+  memmove( &pQueue->pEvents[0], &pQueue->pEvents[NumPosted],
+           pQueue->NumEntries * sizeof(pQueue->pEvents[0]));
+  memmove( &pQueue->pStamps[0], &pQueue->pStamps[NumPosted],
+           pQueue->NumEntries * sizeof(pQueue->pStamps[0]));
+  return (NumPosted > 0);
+}
+
+#ifdef TEST
+/*
+  Test of the deferral queues. The service's queue is a real ES_Queue with
+  room for 4, filled through a stand-in for ES_PostBlockToServiceLIFO, and
+  ES_Timer_GetTime is a stand-in clock that the test sets, so that with
+  the #define TEST at the top uncommented this file links with just
+  ES_Queue.c. Covers recall by type and by test,
+  that the recalled events come out in deferral order ahead of what was
+  waiting while the rest stay deferred in order, a recall into a queue
+  with room for only some of them or none, and the counts, peak depth and
+  ages in the statistics.
+*/
+#include <stdio.h>
+#include "ES_Queue.h"
+#include "ES_Port.h"
+
+#define TEST_SERVICE 3
+
+ES_DEFERRAL_QUEUE( TestDeferrals, 6 );
+static ES_Event ServiceQueue[4 + 1];
+static uint16_t TestTime;
+static uint8_t PostedService;
+static uint32_t Errors;
+
+// stand-ins for the port and the framework
+uint32_t _PRIMASK_temp;
+
+uint32_t CPUgetPRIMASK_cpsid( void ){
+  return 0;
+}
+
+void CPUsetPRIMASK( uint32_t newPRIMASK ){
+  (void)newPRIMASK;
+}
+
+uint16_t ES_Timer_GetTime( void ){
+  return TestTime;
+}
+
+uint8_t ES_PostBlockToServiceLIFO( uint8_t WhichService,
+                                   ES_Event const * pEvents,
+                                   uint8_t NumEvents ){
+  PostedService = WhichService;
+  return ES_EnQueueBlockLIFO( ServiceQueue, pEvents, NumEvents );
+}
+
+static void Check( bool Good, char const * What ){
+  if ( !Good ){
+    Errors++;
+    printf("FAILED: %s\n", What);
+  }
+}
+
+static void Defer( ES_EventTyp_t Type, uint16_t Param, uint16_t When ){
+  ES_Event ThisEvent;
+
+  ThisEvent.EventType = Type;
+  ThisEvent.EventParam = Param;
+  TestTime = When;
+  Check( ES_DeferEvent( &TestDeferrals, ThisEvent ), "defer" );
+}
+
+// the params of the events, in order, must be the digits of Params
+static bool HasParams( ES_Event const * pEvents, uint8_t NumEvents,
+                       char const * Params ){
+  uint8_t i;
+
+  for ( i = 0; i < NumEvents; i++ ){
+    if ( (Params[i] == '\0') || (pEvents[i].EventParam != Params[i] - '0') )
+      return false;
+  }
+  return Params[i] == '\0';
+}
+
+// takes everything out of the service's queue
+static bool ServiceQueueHas( char const * Params ){
+  ES_Event Taken[4];
+  uint8_t NumTaken = 0;
+
+  while ( ES_IsQueueEmpty( ServiceQueue ) == false )
+    ES_DeQueue( ServiceQueue, &Taken[NumTaken++] );
+  return HasParams( Taken, NumTaken, Params );
+}
+
+static bool DeferralsHave( char const * Params ){
+  return HasParams( TestDeferrals.pEvents, ES_GetDeferralDepth(
+                    &TestDeferrals ), Params );
+}
+
+static bool IsParamOver4( ES_Event ThisEvent ){
+  return ThisEvent.EventParam > 4;
+}
+
+void main(void){
+  ES_DeferStats_t const * pStats = ES_GetDeferralStats( &TestDeferrals );
+  ES_Event Waiting = { ES_TIMEOUT, 9 };
+
+  puts("Testing the deferral queues");
+  ES_InitQueue( ServiceQueue, ARRAY_SIZE(ServiceQueue) );
+
+  // a mix of types, the params say which is which
+  Defer( ES_LCD_PUTCHAR, 1, 100 );
+  Defer( DB_BUTTON_DOWN, 2, 101 );
+  Defer( ES_LCD_PUTCHAR, 3, 103 );
+  Defer( DB_BUTTON_UP, 4, 106 );
+  Defer( ES_LCD_PUTCHAR, 5, 110 );
+  Defer( DB_BUTTON_DOWN, 6, 115 );
+  Check( ES_DeferEvent( &TestDeferrals, Waiting ) == false,
+         "refused when full" );
+  Check( (pStats->NumDeferred == 6) && (pStats->NumRefused == 1) &&
+         (pStats->PeakDepth == 6), "counts after deferring" );
+
+  // by type: 1, 3 & 5 go ahead of the event already waiting, in order
+  ES_EnQueueFIFO( ServiceQueue, Waiting );
+  TestTime = 120;
+  Check( ES_RecallEventType( TEST_SERVICE, &TestDeferrals, ES_LCD_PUTCHAR ),
+         "recall by type" );
+  Check( PostedService == TEST_SERVICE, "posted to the right service" );
+  Check( ServiceQueueHas( "1359" ), "recalled by type, in order" );
+  Check( DeferralsHave( "246" ), "left by type, in order" );
+  Check( (pStats->NumRecalled == 3) && (pStats->NumHeldBack == 0),
+         "counts after recall by type" );
+  Check( (pStats->MaxAge == 20) && (pStats->TotalAge == 20 + 17 + 10),
+         "ages after recall by type" );
+  Check( ES_RecallEventType( TEST_SERVICE, &TestDeferrals,
+         ES_LCD_PUTCHAR ) == false, "nothing left of that type" );
+
+  // by test: 6, from the end, leaves 2 & 4 in order
+  TestTime = 125;
+  Check( ES_RecallEventsIf( TEST_SERVICE, &TestDeferrals, IsParamOver4 ),
+         "recall by test" );
+  Check( ServiceQueueHas( "6" ), "recalled by test" );
+  Check( DeferralsHave( "24" ), "left by test, in order" );
+  Check( (pStats->NumRecalled == 4) && (pStats->MaxAge == 20) &&
+         (pStats->TotalAge == 47 + 10), "stats after recall by test" );
+
+  // room for just 1 of the 3, the first goes, the other 2 stay in order
+  Defer( DB_BUTTON_UP, 7, 130 );
+  ES_EnQueueFIFO( ServiceQueue, Waiting );
+  ES_EnQueueFIFO( ServiceQueue, Waiting );
+  ES_EnQueueFIFO( ServiceQueue, Waiting );
+  TestTime = 140;
+  Check( ES_RecallEvents( TEST_SERVICE, &TestDeferrals ), "partial recall" );
+  Check( ServiceQueueHas( "2999" ), "recalled the first that fit" );
+  Check( DeferralsHave( "47" ), "the rest held back, in order" );
+  Check( (pStats->NumRecalled == 5) && (pStats->NumHeldBack == 2),
+         "counts after partial recall" );
+  Check( (pStats->MaxAge == 39) && (pStats->TotalAge == 57 + 39),
+         "ages count only what went" );
+
+  // no room at all, nothing goes and both count as held back again
+  ES_EnQueueFIFO( ServiceQueue, Waiting );
+  ES_EnQueueFIFO( ServiceQueue, Waiting );
+  ES_EnQueueFIFO( ServiceQueue, Waiting );
+  ES_EnQueueFIFO( ServiceQueue, Waiting );
+  TestTime = 200;
+  Check( ES_RecallEvents( TEST_SERVICE, &TestDeferrals ) == false,
+         "no recall into a full queue" );
+  Check( ServiceQueueHas( "9999" ), "full queue untouched" );
+  Check( DeferralsHave( "47" ), "all still deferred, in order" );
+  Check( (pStats->NumRecalled == 5) && (pStats->NumHeldBack == 4) &&
+         (pStats->MaxAge == 39), "counts after no recall" );
+
+  // and the rest, when there is room
+  TestTime = 210;
+  Check( ES_RecallEvents( TEST_SERVICE, &TestDeferrals ), "recall the rest" );
+  Check( ServiceQueueHas( "47" ), "the rest, in order" );
+  Check( (ES_GetDeferralDepth( &TestDeferrals ) == 0) &&
+         (pStats->NumRecalled == 7) && (pStats->MaxAge == 104) &&
+         (pStats->PeakDepth == 6), "all recalled" );
+
+  ES_InitDeferralQueue( &TestDeferrals );
+  Check( (pStats->NumDeferred == 0) && (pStats->PeakDepth == 0) &&
+         (pStats->TotalAge == 0), "init clears the stats" );
+
+  printf("%lu errors\n", (unsigned long)Errors);
+}
+#endif
 /*------------------------------- Footnotes -------------------------------*/
 
 
@@ -8,6 +8,8 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/17/26 23:00         added ES_PostBlockToServiceLIFO for the Defer/Recall
+                        queues
  08/21/17 13:18 jec     added conditional call to initialize the port lines
                         for the hardware debugging of the framework/apps
  12/19/16 20:18 jec      changed includes to accomodate the change to a fixed
@@ -413,6 +415,38 @@ bool ES_PostToServiceLIFO( uint8_t WhichService, ES_Event TheEvent){
     return false;
 }
 
+/****************************************************************************
+ Function
+   ES_PostBlockToServiceLIFO
+ Parameters
+   uint8_t : Which service to post to (index into ServDescList)
+   ES_Event const * : The Events to be posted, in order
+   uint8_t : How many there are
+ Returns
+   uint8_t : the number of them that were posted
+ Description
+   Posts a block of events to the front of one of the services' queues, so
+   that they are the next to be run, in the order given. If they will not
+   all fit, as many as will, from the start of the block, are posted
+ Notes
+   used by the Defer/Recall event capability to put everything it recalls
+   back in one go
+ Author
+   10/17/26
+****************************************************************************/
+uint8_t ES_PostBlockToServiceLIFO( uint8_t WhichService,
+                                   ES_Event const * pEvents,
+                                   uint8_t NumEvents ){
+  uint8_t NumPosted;
+  if (WhichService >= ARRAY_SIZE(EventQueues))
+    return 0;
+  NumPosted = ES_EnQueueBlockLIFO( EventQueues[WhichService].pMem, pEvents,
+                                   NumEvents );
+  if ( NumPosted > 0 )
+    Ready |= BitNum2SetMask[WhichService]; // show queue as non-empty
+  return NumPosted;
+}
+
 //*********************************
 // private functions
 //*********************************
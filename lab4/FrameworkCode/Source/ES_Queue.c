@@ -9,6 +9,7 @@
  History
  When           Who     What/Why
  -------------- ---     --------
+ 10/17/26 23:00          added ES_EnQueueBlockLIFO
  01/15/12 09:34 jec      converted to use the new C99 types from types.h
  08/09/11 18:16 jec      started coding
 *****************************************************************************/
@@ -141,6 +142,51 @@ bool ES_EnQueueLIFO( ES_Event * pBlock, ES_Event Event2Add )
 }
 
 
+/****************************************************************************
+ Function
+   ES_EnQueueBlockLIFO
+ Parameters
+   ES_Event * pBlock : pointer to the block of memory in use as the Queue
+   ES_Event const * pEvents : the events to be added, in order
+   uint8_t NumEvents : how many there are
+ Returns
+   uint8_t : the number that were added
+ Description
+   adds as many of the events as will fit, starting from the first, at the
+   extraction point, so that they are the next ones to be removed by
+   DeQueue operations, in the order that they were given
+ Notes
+   all of the events go in within the one critical region, so nothing can
+   be posted in among them
+
+  Author
+   10/17/26
+****************************************************************************/
+uint8_t ES_EnQueueBlockLIFO( ES_Event * pBlock, ES_Event const * pEvents,
+                             uint8_t NumEvents )
+{
+   pQueue_t pThisQueue;
+   uint8_t NumAdded;
+
+   pThisQueue = (pQueue_t)pBlock;
+   EnterCritical();   // save interrupt state, turn ints off
+   if ( NumEvents > pThisQueue->QueueSize - pThisQueue->NumEntries )
+      NumEvents = pThisQueue->QueueSize - pThisQueue->NumEntries;
+   pThisQueue->NumEntries += NumEvents;
+   // back up the index once for each, putting the last one in first
+   for ( NumAdded = NumEvents; NumAdded > 0; NumAdded-- ){
+      if (pThisQueue->CurrentIndex == 0){
+        pThisQueue->CurrentIndex = pThisQueue->QueueSize -1;
+      }
+      else{
+        pThisQueue->CurrentIndex--;
+      }
+      pBlock[ 1 + pThisQueue->CurrentIndex ] = pEvents[NumAdded - 1];
+   }
+   ExitCritical();  // restore saved interrupt state
+   return(NumEvents);
+}
+
 /****************************************************************************
  Function
    ES_DeQueue
@@ -296,6 +342,17 @@ void main(void){
   // at this point, the events in the queue should be 8,2,4
   // so pull off the 8, leaving 2 entries
   NumLeft = ES_DeQueue( TestQueue, &MyEvent);
+
+  // put 2 back on the front in one go, only 1 will fit
+  {
+    ES_Event Block[2] = { {12, 13}, {14, 15} };
+    if ( ES_EnQueueBlockLIFO( TestQueue, Block, 2 ) != 1 )
+      bReturn = 0;
+  }
+  // at this point, the events in the queue should be 12,2,4
+  NumLeft = ES_DeQueue( TestQueue, &MyEvent);
+  if ( (NumLeft != 2) || (MyEvent.EventParam != 13) )
+    bReturn = 0;
   NumLeft += 3; //to keep the compiler from optimizing away the last save
   
   while(1)
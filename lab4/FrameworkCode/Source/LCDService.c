@@ -58,8 +58,8 @@ static uint8_t MyPriority;
 
 static LCDState_t CurrentState = InitPState;
 
-// add a deferral queue for up to 3 pending deferrals +1 to allow for overhead
-static ES_Event DeferralQueue[3+1];
+// add a deferral queue for up to 3 pending deferrals
+ES_DEFERRAL_QUEUE( DeferralQueue, 3 );
 
 /*------------------------------ Module Code ------------------------------*/
 /****************************************************************************
@@ -88,7 +88,7 @@ bool InitLCDService ( uint8_t Priority )
   /********************************************
    in here you write your initialization code
    *******************************************/
-  ES_InitDeferralQueueWith( DeferralQueue, ARRAY_SIZE(DeferralQueue)); 
+  ES_InitDeferralQueue( &DeferralQueue ); 
 //Put us into the initial pseudo-state to set up for the initial transition
 	CurrentState = InitPState;
 // set up the short timer for inter-command timings
@@ -192,7 +192,7 @@ ES_Event RunLCDService( ES_Event ThisEvent )
 // if this was a short timeout event, 
 		if(ThisEvent.EventType == ES_SHORT_TIMEOUT){
 			// then recall any defered events and move to the Waiting2Write state
-			ES_RecallEvents(MyPriority, DeferralQueue); 
+			ES_RecallEvents(MyPriority, &DeferralQueue); 
 			CurrentState = Waiting2Write; 
       //printf("Deferral done"); 
 		}
@@ -200,8 +200,7 @@ ES_Event RunLCDService( ES_Event ThisEvent )
     // if this was an LCD_Putchar, 
 		if(ThisEvent.EventType == ES_LCD_PUTCHAR){
     // then defer any new characters that arrive while pausing between LCD writes
-			ES_DeferEvent( DeferralQueue, ThisEvent); 
-      //ES_EnQueueFIFO(DeferralQueue, ThisEvent); 
+			ES_DeferEvent( &DeferralQueue, ThisEvent); 
 		}
       break;
 
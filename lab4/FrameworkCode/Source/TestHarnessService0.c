@@ -60,8 +60,8 @@ static void BlinkLED(void);
 /*---------------------------- Module Variables ---------------------------*/
 // with the introduction of Gen2, we need a module level Priority variable
 static uint8_t MyPriority;
-// add a deferral queue for up to 3 pending deferrals +1 to allow for ovehead
-static ES_Event DeferralQueue[3+1];
+// add a deferral queue for up to 3 pending deferrals
+ES_DEFERRAL_QUEUE( DeferralQueue, 3 );
 
 /*------------------------------ Module Code ------------------------------*/
 /****************************************************************************
@@ -91,7 +91,7 @@ bool InitTestHarnessService0 ( uint8_t Priority )
    in here you write your initialization code
    *******************************************/
 	// initialize deferral queue for testing Deferal function
-  ES_InitDeferralQueueWith( DeferralQueue, ARRAY_SIZE(DeferralQueue) );
+  ES_InitDeferralQueue( &DeferralQueue );
 	// initialize LED drive for testing/debug output
 	InitLED();
   // initialize the Short timer system for channel A
@@ -192,7 +192,7 @@ ES_Event RunTestHarnessService0( ES_Event ThisEvent )
       if( 'd' == ThisEvent.EventParam )
       {
           ThisEvent.EventParam = DeferredChar++; //
-          if (ES_DeferEvent( DeferralQueue, ThisEvent ))
+          if (ES_DeferEvent( &DeferralQueue, ThisEvent ))
           {
             puts("ES_NEW_KEY deferred in Service 0\r");
           }
@@ -202,7 +202,7 @@ ES_Event RunTestHarnessService0( ES_Event ThisEvent )
           ThisEvent.EventParam = 'Q'; // This one gets posted normally
           ES_PostToService( MyPriority, ThisEvent);
           // but we slide the deferred events under it so it(they) should come out first
-          if ( true == ES_RecallEvents( MyPriority, DeferralQueue )){
+          if ( true == ES_RecallEvents( MyPriority, &DeferralQueue )){
             puts("ES_NEW_KEY(s) recalled in Service 0\r");
 					DeferredChar = '1';
           }